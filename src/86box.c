@@ -48,6 +48,7 @@
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/config.h>
+#include <86box/log.h>
 #include <86box/mem.h>
 #include "cpu.h"
 #ifdef USE_DYNAREC
@@ -61,6 +62,7 @@
 #include <86box/pic.h>
 #include <86box/timer.h>
 #include <86box/device.h>
+#include <86box/device_prof.h>
 #include <86box/pit.h>
 #include <86box/random.h>
 #include <86box/nvr.h>
@@ -109,6 +111,11 @@
 #include <86box/acpi.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 #include <86box/vfio.h>
+#include <86box/record.h>
+#include <86box/snapshot.h>
+#include <86box/replay.h>
+
+#include <minitrace/minitrace.h>
 
 // Disable c99-designator to avoid the warnings about int ng
 #ifdef __clang__
@@ -131,6 +138,9 @@ int tracing_on = 0;
 /* Commandline options. */
 int dump_on_exit        = 0; /* (O) dump regs on exit */
 int start_in_fullscreen = 0; /* (O) start in fullscreen */
+#ifdef USE_SDL_UI
+int start_headless = 0; /* (O) run without a display */
+#endif
 #ifdef _WIN32
 int force_debug = 0; /* (O) force debug output */
 #endif
@@ -178,6 +188,7 @@ int      force_43                               = 0;              /* (C) video *
 int      video_filter_method                    = 1;              /* (C) video */
 int      video_vsync                            = 0;              /* (C) video */
 int      video_framerate                        = -1;             /* (C) video */
+int      video_screenshot_format                = 0;              /* (C) screenshot file format */
 bool     serial_passthrough_enabled[SERIAL_MAX - 1] = { 0, 0, 0, 0, 0, 0, 0 }; /* (C) activation and kind of
                                                                                   pass-through for serial ports */
 int      bugger_enabled                         = 0;              /* (C) enable ISAbugger */
@@ -191,6 +202,7 @@ int      isartc_type                            = 0;              /* (C) enable
 int      gfxcard[GFXCARD_MAX]                   = { 0, 0 };       /* (C) graphics/video card */
 int      show_second_monitors                   = 1;              /* (C) show non-primary monitors */
 int      sound_is_float                         = 1;              /* (C) sound uses FP values */
+int      sound_low_latency                      = 0;              /* (C) queue less audio ahead */
 int      voodoo_enabled                         = 0;              /* (C) video option */
 int      ibm8514_standalone_enabled             = 0;              /* (C) video option */
 int      xga_standalone_enabled                 = 0;              /* (C) video option */
@@ -199,6 +211,12 @@ uint32_t mem_size                               = 0;              /* (C) memory
                                                                          system board)*/
 uint32_t isa_mem_size                           = 0;              /* (C) memory size (ISA Memory Cards) */
 int      cpu_use_dynarec                        = 0;              /* (C) cpu uses/needs Dyna */
+int      dynarec_cache_size                     = 0;              /* (C) dynarec code cache size in MB,
+                                                                     0 = default */
+int      dynarec_stats                          = 0;              /* (C) show dynarec statistics in
+                                                                     the status bar */
+int      mem_huge_pages                         = 0;              /* (C) back guest RAM and the code
+                                                                     cache with host huge pages */
 int      cpu                                    = 0;              /* (C) cpu type */
 int      fpu_type                               = 0;              /* (C) fpu type */
 int      fpu_softfloat                          = 0;              /* (C) fpu uses softfloat */
@@ -223,6 +241,13 @@ int      sound_muted                            = 0;              /* (C) Is soun
 int      jumpered_internal_ecp_dma              = 0;              /* (C) Jumpered internal EPC DMA */
 int      inhibit_multimedia_keys;                                 /* (G) Inhibit multimedia keys on Windows. */
 int      force_10ms;                                              /* (C) Force 10ms CPU frame intervals. */
+int      cpu_frame_adaptive                     = 0;              /* (C) Size CPU frames to the real
+                                                                     time owed to the emulation. */
+int      hlt_fast_forward                       = 0;              /* (C) Skip halted CPU time up to
+                                                                     the next timer deadline. */
+int      turbo_boot_ms                          = 0;              /* (C) Run unpaced for up to this many
+                                                                     emulated ms after a hard reset. */
+int      turbo_boot                             = 0;              /* Unpaced boot currently in progress. */
 int      vmm_disabled                           = 0;              /* (G) disable built-in manager */
 char     vmm_path_cfg[1024]                     = { '\0' };       /* (G) VMs path (unless -E is used)*/
 
@@ -326,6 +351,8 @@ int   scrnsz_y = SCREEN_RES_Y; /* current screen size, Y */
 int config_changed; /* config has changed */
 int title_update;
 int framecountx        = 0;
+int cpu_frame_ms       = 1; /* length of the last CPU frame, in ms */
+static int turbo_boot_elapsed = 0;
 int hard_reset_pending = 0;
 
 #if 0
@@ -341,14 +368,7 @@ static wchar_t mouse_msg[3][200];
 static volatile ATOMIC_INT do_pause_ack = 0;
 static volatile ATOMIC_INT pause_ack = 0;
 
-#define LOG_SIZE_BUFFER 8192            /* Log size buffer */
-
 #ifndef RELEASE_BUILD
-
-static char buff[LOG_SIZE_BUFFER];
-
-static int seen = 0;
-
 static int suppr_seen = 1;
 
 // Functions only used in this translation unit
@@ -383,25 +403,13 @@ void
 pclog_ex(UNUSED(const char *fmt), UNUSED(va_list ap))
 {
 #ifndef RELEASE_BUILD
-    char temp[LOG_SIZE_BUFFER];
-
     if (strcmp(fmt, "") == 0)
         return;
 
     pclog_ensure_stdlog_open();
 
-    vsprintf(temp, fmt, ap);
-    if (suppr_seen && !strcmp(buff, temp))
-        seen++;
-    else {
-        if (suppr_seen && seen)
-            fprintf(stdlog, "*** %d repeats ***\n", seen);
-        seen = 0;
-        strcpy(buff, temp);
-        fprintf(stdlog, "%s", temp);
-    }
-
-    fflush(stdlog);
+    /* Handed to the log writer thread, which also suppresses the repeats. */
+    log_out_global(suppr_seen, fmt, ap);
 #endif
 }
 
@@ -435,6 +443,9 @@ always_log(const char *fmt, ...)
 
     va_start(ap, fmt);
 
+    /* Keep the order with anything still queued for the log writer. */
+    log_flush();
+
     if (stdlog == NULL) {
         if (log_path[0] != '\0') {
             stdlog = plat_fopen(log_path, "w");
@@ -460,6 +471,9 @@ fatal(const char *fmt, ...)
 
     va_start(ap, fmt);
 
+    /* Keep the order with anything still queued for the log writer. */
+    log_flush();
+
     if (stdlog == NULL) {
         if (log_path[0] != '\0') {
             stdlog = plat_fopen(log_path, "w");
@@ -477,6 +491,7 @@ fatal(const char *fmt, ...)
     nvr_save();
 
     config_save();
+    config_flush();
 
 #ifdef ENABLE_808X_LOG
     dumpregs(1);
@@ -505,6 +520,9 @@ fatal_ex(const char *fmt, va_list ap)
     char  temp[LOG_SIZE_BUFFER];
     char *sp;
 
+    /* Keep the order with anything still queued for the log writer. */
+    log_flush();
+
     if (stdlog == NULL) {
         if (log_path[0] != '\0') {
             stdlog = plat_fopen(log_path, "w");
@@ -521,6 +539,7 @@ fatal_ex(const char *fmt, va_list ap)
     nvr_save();
 
     config_save();
+    config_flush();
 
 #ifdef ENABLE_808X_LOG
     dumpregs(1);
@@ -551,6 +570,9 @@ warning(const char *fmt, ...)
 
     va_start(ap, fmt);
 
+    /* Keep the order with anything still queued for the log writer. */
+    log_flush();
+
     if (stdlog == NULL) {
         if (log_path[0] != '\0') {
             stdlog = plat_fopen(log_path, "w");
@@ -584,6 +606,9 @@ warning_ex(const char *fmt, va_list ap)
     char  temp[LOG_SIZE_BUFFER];
     char *sp;
 
+    /* Keep the order with anything still queued for the log writer. */
+    log_flush();
+
     if (stdlog == NULL) {
         if (log_path[0] != '\0') {
             stdlog = plat_fopen(log_path, "w");
@@ -665,6 +690,7 @@ pc_show_usage(char *s)
             "Valid options are:\n\n"
             "-? or --help\t\t\t- show this information\n"
             "-A or --assetpath path\t\t- set 'path' to be asset path\n"
+            "-B or --voodoocap path\t\t- record the Voodoo FIFO stream to 'path'\n"
 #ifdef SHOW_EXTRA_PARAMS
             "-C or --config path\t\t- set 'path' to be config file\n"
 #endif
@@ -677,6 +703,10 @@ pc_show_usage(char *s)
             "-F or --fullscreen\t\t- start in fullscreen mode\n"
             "-G or --lang langid\t\t- start with specified language\n"
             "\t\t\t\t   (e.g. en-US, or system)\n"
+#ifdef USE_SDL_UI
+            "--headless\t\t\t- run without a window, only rendering frames\n"
+            "\t\t\t\t   for screenshots\n"
+#endif
 #ifdef SHOW_EXTRA_PARAMS
 #ifdef _WIN32
             "-H or --hwnd id,hwnd\t\t- sends back the main dialog's hwnd\n"
@@ -686,12 +716,34 @@ pc_show_usage(char *s)
 #ifdef USE_INSTRUMENT
             "-J or --instrument name\t- set 'name' to be the profiling instrument\n"
 #endif
+            "-K or --timerprof\t\t- profile timer callbacks and log the results on exit\n"
             "-L or --logfile path\t\t- set 'path' to be the logfile\n"
             "-M or --missing\t\t- dump missing machines and video cards\n"
             "-N or --noconfirm\t\t- do not ask for confirmation on quit\n"
             "-P or --vmpath path\t\t- set 'path' to be root for vm\n"
+            "-Q or --turboboot ms\t\t- run as fast as possible, without screen updates,\n"
+            "\t\t\t\t   until INT 19h or 'ms' emulated ms after reset\n"
             "-O or --global path\t\t- set 'path' to be global config file\n"
             "-R or --rompath path\t\t- set 'path' to be ROM path\n"
+            "--record path\t\t\t- record the screen and sound to 'path', with\n"
+            "\t\t\t\t   lossless compression (--recordraw for none)\n"
+#ifdef USE_SNAPSHOTS
+            "--resume path\t\t\t- restore the snapshot in 'path' once the machine\n"
+            "\t\t\t\t   has started\n"
+            "--checkpoint secs\t\t- write a checkpoint every 'secs' emulated seconds,\n"
+            "\t\t\t\t   to the checkpoints directory of the VM\n"
+#endif
+            "-U or --memprof path\t\t- count memory mapping accesses and write them\n"
+            "\t\t\t\t   to 'path' as JSON on hard reset and exit\n"
+            "--cpuprof path\t\t\t- sample guest CS:EIP and write a flat profile to\n"
+            "\t\t\t\t   'path' and collapsed stacks to 'path'.folded\n"
+            "--cpusyms path\t\t\t- resolve --cpuprof addresses with the linear\n"
+            "\t\t\t\t   address symbol list (nm format) in 'path'\n"
+            "--devprof\t\t\t- account host time per device, show it in the\n"
+            "\t\t\t\t   status bar and log it on hard reset and exit\n"
+            "--inputrec path\t\t- record keyboard, mouse, network, media and RTC\n"
+            "\t\t\t\t   inputs to 'path' for exact re-execution\n"
+            "--inputplay path\t\t- replay the inputs recorded in 'path', unpaced\n"
 #ifndef USE_SDL_UI
             "-S or --settings\t\t\t- show only the settings dialog\n"
 #endif
@@ -839,6 +891,10 @@ usage:
 #endif
         } else if (!strcasecmp(argv[c], "--fullscreen") || !strcasecmp(argv[c], "-F")) {
             start_in_fullscreen = 1;
+#ifdef USE_SDL_UI
+        } else if (!strcasecmp(argv[c], "--headless")) {
+            start_headless = 1;
+#endif
         } else if (!strcasecmp(argv[c], "--logfile") || !strcasecmp(argv[c], "-L")) {
             if ((c + 1) == argc)
                 goto usage;
@@ -910,6 +966,69 @@ usage:
             test_mode = 1;
         } else if (!strcasecmp(argv[c], "--noconfirm") || !strcasecmp(argv[c], "-N")) {
             confirm_exit_cmdl = 0;
+        } else if (!strcasecmp(argv[c], "--timerprof") || !strcasecmp(argv[c], "-K")) {
+            timer_profile = 1;
+        } else if (!strcasecmp(argv[c], "--devprof")) {
+            device_profile = 1;
+        } else if (!strcasecmp(argv[c], "--memprof") || !strcasecmp(argv[c], "-U")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snprintf(mem_profile_path, sizeof(mem_profile_path), "%s", argv[++c]);
+            mem_profile = 1;
+        } else if (!strcasecmp(argv[c], "--cpuprof")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snprintf(cpu_prof_path, sizeof(cpu_prof_path), "%s", argv[++c]);
+            cpu_prof = 1;
+        } else if (!strcasecmp(argv[c], "--cpusyms")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snprintf(cpu_prof_syms_path, sizeof(cpu_prof_syms_path), "%s", argv[++c]);
+        } else if (!strcasecmp(argv[c], "--voodoocap") || !strcasecmp(argv[c], "-B")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snprintf(voodoo_capture_path, sizeof(voodoo_capture_path), "%s", argv[++c]);
+            voodoo_capture = 1;
+        } else if (!strcasecmp(argv[c], "--record") || !strcasecmp(argv[c], "--recordraw")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            record_raw = !strcasecmp(argv[c], "--recordraw");
+            snprintf(record_path, sizeof(record_path), "%s", argv[++c]);
+            record_enabled = 1;
+#ifdef USE_SNAPSHOTS
+        } else if (!strcasecmp(argv[c], "--checkpoint")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snapshot_checkpoint_secs = atoi(argv[++c]);
+            if (snapshot_checkpoint_secs < 0)
+                snapshot_checkpoint_secs = 0;
+#endif
+        } else if (!strcasecmp(argv[c], "--inputrec") || !strcasecmp(argv[c], "--inputplay")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            replay_set_file(strcasecmp(argv[c], "--inputrec") ? REPLAY_PLAY : REPLAY_RECORD, argv[c + 1]);
+            c++;
+#ifdef USE_SNAPSHOTS
+        } else if (!strcasecmp(argv[c], "--resume")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snapshot_request_load(argv[++c]);
+#endif
+        } else if (!strcasecmp(argv[c], "--turboboot") || !strcasecmp(argv[c], "-Q")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            turbo_boot_ms = atoi(argv[++c]);
+            if (turbo_boot_ms < 0)
+                turbo_boot_ms = 0;
         } else if (!strcasecmp(argv[c], "--missing") || !strcasecmp(argv[c], "-M")) {
             dump_missing = 1;
         } else if (!strcasecmp(argv[c], "--donothing") || !strcasecmp(argv[c], "-Y")) {
@@ -1346,6 +1465,16 @@ pc_init_roms(void)
         }
     }
 
+    /* Starting up only needs the ROMs of the configured machine. If they
+       are there, probing the other machines is left to the settings
+       dialog, which checks each one as it lists them; this saves a file
+       lookup per machine on slow ROM paths. Otherwise, scan them all so
+       pc_init_modules() has something to fall back to. */
+    if ((machine >= 0) && (machine_get_internal_name_ex(machine) != NULL) && machine_available(machine)) {
+        pc_log("ROM set for machine %s found.\n", machine_get_internal_name_ex(machine));
+        return 1;
+    }
+
     pc_log("Scanning for ROM images:\n");
     c = m = 0;
     while (machine_get_internal_name_ex(m) != NULL) {
@@ -1455,6 +1584,10 @@ pc_init_modules(void)
 
     sound_init();
 
+    record_init();
+
+    replay_init();
+
     hdc_init();
 
     video_reset_close();
@@ -1570,11 +1703,20 @@ pc_reset_hard_close(void)
 {
     ui_sb_set_ready(0);
 
+    /* Dump the memory access profile while the mappings are still linked. */
+    mem_profile_dump();
+    cpu_prof_dump();
+
     /* Close all the memory mappings. */
     mem_close();
 
     suppress_overscan = 0;
 
+    /* Dump the timer callback profile while the device names are still valid. */
+    timer_profile_dump();
+    sound_profile_dump();
+    device_profile_dump();
+
     /* Turn off timer processing to avoid potential segmentation faults. */
     timer_close();
 
@@ -1622,6 +1764,9 @@ pc_reset_hard_close(void)
 void
 pc_reset_hard_init(void)
 {
+    /* A checkpoint being written may still be reading the guest RAM. */
+    snapshot_close();
+
     /*
      * First, we reset the modules that are not part of
      * the actual machine, but which support some of the
@@ -1654,6 +1799,9 @@ pc_reset_hard_init(void)
     /* Initialize the actual machine and its basic modules. */
     machine_init();
 
+    /* Start sampling the guest, if asked to. */
+    cpu_prof_init();
+
     /* Reset some basic devices. */
     speaker_init();
     shadowbios = 0;
@@ -1758,6 +1906,9 @@ pc_reset_hard_init(void)
        the IDE controllers present are not some form of PCI. */
     ide_drives_set_shadow();
 
+    /* Everything the devices left to their worker threads has to be in place now. */
+    device_init_wait();
+
     /* Reset the CPU module. */
     resetx86();
     dma_reset();
@@ -1780,9 +1931,26 @@ pc_reset_hard_init(void)
     if (test_mode)
         pc_test_mode_entry_point();
 
+    turbo_boot         = (turbo_boot_ms > 0);
+    turbo_boot_elapsed = 0;
+
+    replay_reset();
+
     ui_hard_reset_completed();
 }
 
+/* Leave the unpaced boot mode, called when the BIOS hands over to the boot
+   loader or when the deadline passes. */
+void
+pc_turbo_boot_end(void)
+{
+    if (!turbo_boot)
+        return;
+
+    turbo_boot = 0;
+    pclog("PC: Turbo boot finished after %i ms\n", turbo_boot_elapsed);
+}
+
 void
 update_mouse_msg(void)
 {
@@ -1841,9 +2009,24 @@ pc_close(UNUSED(thread_t *ptr))
     nvr_save();
 
     config_save();
+    config_flush();
+
+    snapshot_close();
+
+    replay_close();
+
+    log_flush();
 
     plat_mouse_capture(0);
 
+    mem_profile_dump();
+    cpu_prof_dump();
+    device_profile_dump();
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    if (dynarec_stats)
+        codegen_stats_dump();
+#endif
+
     /* Close all the memory mappings. */
     mem_close();
 
@@ -1860,6 +2043,8 @@ pc_close(UNUSED(thread_t *ptr))
         dumpregs(0);
 #endif
 
+    record_close();
+
     video_close();
 
     device_close_all();
@@ -1904,25 +2089,85 @@ ack_pause(void)
     }
 }
 
-void
-pc_run(void)
+/* Frame length statistics, logged once per second. */
+static uint64_t frame_stat_ns;
+static uint32_t frame_stat_ms;
+static uint32_t frame_stat_count;
+
+/* Performance counters for the last second, and the totals they came from. */
+static pc_perf_t perf;
+static pc_perf_t perf_totals;
+static uint32_t  perf_frames;
+
+/*
+ * Pick the length of the next CPU frame.
+ *
+ * With adaptive frames, short frames are used while the emulation keeps up
+ * with real time, so input and audio latency stay low, and longer frames are
+ * used when it falls behind, to cut down on the per-frame overhead. Frames
+ * grow gradually but shrink back at once.
+ */
+static int
+pc_frame_len(int budget_ms)
+{
+    int len;
+
+    /* Frames must end at the same emulated times when recording and replaying. */
+    if (replay_mode != REPLAY_OFF)
+        return 1;
+
+    if (force_10ms || turbo_boot)
+        return 10;
+
+    if (!cpu_frame_adaptive)
+        return 1;
+
+    if (budget_ms > CPU_FRAME_MAX_MS)
+        budget_ms = CPU_FRAME_MAX_MS;
+    else if (budget_ms < 1)
+        budget_ms = 1;
+
+    len = cpu_frame_ms << 1;
+    if (len > budget_ms)
+        len = budget_ms;
+
+    return len;
+}
+
+int
+pc_run(int budget_ms)
 {
-    int     mouse_msg_idx;
-    wchar_t temp[200];
+    int      mouse_msg_idx;
+    int      frame_ms;
+    uint64_t start_ns = 0ULL;
+    wchar_t  temp[200];
 
     /* Trigger a hard reset if one is pending. */
+    if (replay_mode != REPLAY_OFF)
+        hard_reset_pending = replay_hard_reset(hard_reset_pending);
     if (hard_reset_pending) {
         hard_reset_pending = 0;
         pc_reset_hard_close();
         pc_reset_hard_init();
     }
 
+    /* Save or restore a snapshot if one was asked for. */
+    snapshot_process();
+
     /* Update the guest-CPU independent timer for devices with independent clock speed */
     rivatimer_update_all();
 
+    frame_ms     = pc_frame_len(budget_ms);
+    cpu_frame_ms = frame_ms;
+
+    if (cpu_frame_adaptive)
+        start_ns = plat_get_nsecs();
+
     /* Run a block of code. */
     startblit();
-    cpu_exec((int32_t) cpu_s->rspeed / (force_10ms ? 100 : 1000));
+    MTR_BEGIN("cpu", "cpu_exec");
+    cpu_exec((int32_t) ((cpu_s->rspeed / 1000) * frame_ms));
+    MTR_END("cpu", "cpu_exec");
     ack_pause();
 #ifdef USE_GDBSTUB /* avoid a KBC FIFO overflow when CPU emulation is stalled */
     if (gdbstub_step == GDBSTUB_EXEC) {
@@ -1935,11 +2180,28 @@ pc_run(void)
     joystick_process(0); // Gameport 0
     endblit();
 
+    if (cpu_frame_adaptive) {
+        frame_stat_ns += plat_get_nsecs() - start_ns;
+        frame_stat_ms += frame_ms;
+        frame_stat_count++;
+    }
+
+    if (turbo_boot) {
+        turbo_boot_elapsed += frame_ms;
+        if (turbo_boot_elapsed >= turbo_boot_ms)
+            pc_turbo_boot_end();
+    }
+
     /* Done with this frame, update statistics. */
-    framecount++;
-    if (++framecountx >= (force_10ms ? 100 : 1000)) {
+    framecount += force_10ms ? 1 : frame_ms;
+    framecountx += frame_ms;
+    if (framecountx >= 1000) {
         framecountx = 0;
+        perf_frames = frames;
         frames      = 0;
+
+        hdd_image_idle();
+        snapshot_idle();
     }
 
     if (title_update) {
@@ -1959,15 +2221,119 @@ pc_run(void)
 #endif
         title_update = 0;
     }
+
+    return frame_ms;
+}
+
+/* Counters since startup, pc_get_perf() reports their rates. */
+void
+pc_get_perf_totals(pc_perf_t *now)
+{
+    memset(now, 0, sizeof(pc_perf_t));
+
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    codegen_totals_t dynarec;
+
+    codegen_stats_totals(&dynarec);
+    now->dynarec_compiled   = dynarec.recompiles;
+    now->dynarec_evicted    = dynarec.evictions;
+    now->dynarec_uops       = dynarec.uops;
+    now->dynarec_host_bytes = dynarec.host_bytes;
+    now->dynarec_smc        = dynarec.smc_invalidations;
+    now->dynarec_flushed    = dynarec.flushed;
+    now->dynarec_fallbacks  = dynarec.fallbacks;
+#endif
+    now->audio_underruns = sound_underruns;
+    now->timer_callbacks = timer_callback_count;
+    now->instructions    = cpu_instructions;
+    now->disk_ops        = hdd_image_ops;
+    now->net_rx_packets  = network_rx_packets;
+    now->net_tx_packets  = network_tx_packets;
+}
+
+static void
+pc_perf_update(void)
+{
+    pc_perf_t now;
+
+    pc_get_perf_totals(&now);
+
+    perf.speed              = fps / (force_10ms ? 1 : 10);
+    perf.frames             = perf_frames;
+    perf.audio_underruns    = now.audio_underruns - perf_totals.audio_underruns;
+    perf.timer_callbacks    = now.timer_callbacks - perf_totals.timer_callbacks;
+    perf.instructions       = now.instructions - perf_totals.instructions;
+    perf.dynarec_compiled   = now.dynarec_compiled - perf_totals.dynarec_compiled;
+    perf.dynarec_evicted    = now.dynarec_evicted - perf_totals.dynarec_evicted;
+    perf.dynarec_uops       = now.dynarec_uops - perf_totals.dynarec_uops;
+    perf.dynarec_host_bytes = now.dynarec_host_bytes - perf_totals.dynarec_host_bytes;
+    perf.dynarec_smc        = now.dynarec_smc - perf_totals.dynarec_smc;
+    perf.dynarec_flushed    = now.dynarec_flushed - perf_totals.dynarec_flushed;
+    perf.dynarec_fallbacks  = now.dynarec_fallbacks - perf_totals.dynarec_fallbacks;
+    perf.disk_ops           = now.disk_ops - perf_totals.disk_ops;
+    perf.net_rx_packets     = now.net_rx_packets - perf_totals.net_rx_packets;
+    perf.net_tx_packets     = now.net_tx_packets - perf_totals.net_tx_packets;
+
+    perf_totals = now;
+}
+
+void
+pc_get_perf(pc_perf_t *p)
+{
+    *p = perf;
 }
 
 /* Handler for the 1-second timer to refresh the window title. */
 void
 pc_onesec(void)
 {
+    uint32_t frames_dropped = 0;
+    uint32_t frames_blocked = 0;
+
     fps        = framecount;
     framecount = 0;
 
+    pc_perf_update();
+
+    if (frame_stat_count) {
+        pc_log("PC: %u frames, average frame %u.%02u ms, %" PRIu64 "%% of the emulated time spent on the host\n",
+               frame_stat_count, frame_stat_ms / frame_stat_count, ((frame_stat_ms * 100) / frame_stat_count) % 100,
+               frame_stat_ms ? ((frame_stat_ns / 10000ULL) / frame_stat_ms) : 0ULL);
+        frame_stat_ns    = 0ULL;
+        frame_stat_ms    = 0;
+        frame_stat_count = 0;
+    }
+
+    if (smi_count) {
+        pc_log("PC: %u SMIs/s\n", smi_count);
+        smi_count = 0;
+    }
+
+    for (int i = 0; i < MONITORS_NUM; i++) {
+        uint32_t dropped;
+        uint32_t blocked;
+
+        if (monitors[i].mon_blit_data_ptr == NULL)
+            continue;
+
+        video_get_blit_stats_monitor(i, &dropped, &blocked);
+        if (dropped || blocked)
+            pc_log("PC: Monitor %i: %u frames/s dropped, %u frames/s blocked\n", i, dropped, blocked);
+        frames_dropped += dropped;
+        frames_blocked += blocked;
+    }
+    perf.frames_dropped = frames_dropped;
+    perf.frames_blocked = frames_blocked;
+
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    if (dynarec_stats && cpu_use_dynarec) {
+        char dynarec_text[192];
+
+        codegen_stats_text(dynarec_text, sizeof(dynarec_text));
+        ui_sb_bugui(dynarec_text);
+    }
+#endif
+
     title_update = 1;
 }
 
@@ -100,38 +100,46 @@ acpi_gp_timer_get(UNUSED(acpi_t *dev))
     return clock;
 }
 
+/* Time until the next toggle of the timer's most significant bit. */
 static double
-acpi_get_overflow_period(acpi_t *dev)
+acpi_get_overflow_period(acpi_t *dev, int wrapped)
 {
     uint64_t timer = acpi_clock_get();
+    uint64_t msb   = dev->regs.timer32 ? 0x80000000ULL : 0x800000ULL;
     uint64_t overflow_time;
 
-    if (dev->regs.timer32)
-        overflow_time = (timer + 0x80000000LL) & ~0x7fffffffLL;
+    /* From the overflow callback, rounding can leave the toggle just crossed
+       a fraction of a tick ahead, so aim for the one after it. */
+    if (wrapped)
+        overflow_time = (timer + (msb >> 1) + msb) & ~(msb - 1);
     else
-        overflow_time = (timer + 0x800000LL) & ~0x7fffffLL;
+        overflow_time = (timer + msb) & ~(msb - 1);
 
     uint64_t time_to_overflow = overflow_time - timer;
 
     return ((double) time_to_overflow / (double) ACPI_TIMER_FREQ) * 1000000.0;
 }
 
+/* The PM timer itself is computed from the TSC on every read, this only
+   schedules the TMROF_STS events, once per toggle of the MSB. */
 static void
 acpi_timer_update(acpi_t *dev, bool enable)
 {
+    timer_stop(&dev->timer);
+
     if (enable)
-        timer_on_auto(&dev->timer, acpi_get_overflow_period(dev));
-    else
-        timer_stop(&dev->timer);
+        timer_on_auto(&dev->timer, acpi_get_overflow_period(dev, 0));
 }
 
 static void
 acpi_timer_overflow(void *priv)
 {
     acpi_t *dev = (acpi_t *) priv;
+
     dev->regs.pmsts |= TMROF_STS;
     acpi_update_irq(dev);
-    acpi_timer_update(dev, (dev->regs.pmen & TMROF_EN) && !(dev->regs.pmsts & TMROF_STS));
+
+    timer_on_auto(&dev->timer, acpi_get_overflow_period(dev, 1));
 }
 
 static void
@@ -1982,11 +1990,33 @@ acpi_aux_reg_write_common(int size, uint16_t addr, uint8_t val, void *priv)
         acpi_aux_reg_write_smc(size, addr, val, priv);
 }
 
+/* PMTMR reads, taken ahead of the per-byte register decode since ACPI
+   guests spin on this port; every vendor has it at offset 0x08. */
+static uint32_t
+acpi_pm_timer_read(acpi_t *dev)
+{
+#ifdef USE_DYNAREC
+    /* Bring the TSC up to the instruction, recompiled blocks only account
+       their cycles at the end. */
+    if (cpu_use_dynarec)
+        update_tsc();
+#endif
+
+    return acpi_timer_get(dev);
+}
+
 static uint32_t
 acpi_reg_readl(uint16_t addr, void *priv)
 {
+    acpi_t  *dev = (acpi_t *) priv;
     uint32_t ret = 0x00000000;
 
+    if ((addr - dev->io_base) == 0x08) {
+        ret = acpi_pm_timer_read(dev);
+        acpi_log("ACPI: Read L %08X from %04X\n", ret, addr);
+        return ret;
+    }
+
     ret = acpi_reg_read_common(4, addr, priv);
     ret |= (acpi_reg_read_common(4, addr + 1, priv) << 8);
     ret |= (acpi_reg_read_common(4, addr + 2, priv) << 16);
@@ -2000,8 +2030,15 @@ acpi_reg_readl(uint16_t addr, void *priv)
 static uint16_t
 acpi_reg_readw(uint16_t addr, void *priv)
 {
+    acpi_t  *dev = (acpi_t *) priv;
     uint16_t ret = 0x0000;
 
+    if (((addr - dev->io_base) & ~2) == 0x08) {
+        ret = acpi_pm_timer_read(dev) >> (((addr - dev->io_base) & 2) << 3);
+        acpi_log("ACPI: Read W %08X from %04X\n", ret, addr);
+        return ret;
+    }
+
     ret = acpi_reg_read_common(2, addr, priv);
     ret |= (acpi_reg_read_common(2, addr + 1, priv) << 8);
 
@@ -2218,6 +2255,8 @@ void
 acpi_set_timer32(acpi_t *dev, uint8_t timer32)
 {
     dev->regs.timer32 = timer32;
+
+    acpi_timer_update(dev, timer_is_enabled(&dev->timer));
 }
 
 void
@@ -2426,6 +2465,8 @@ acpi_reset(void *priv)
     acpi_update_irq(dev);
     dev->irq_state = 0;
 
+    acpi_timer_update(dev, true);
+
     timer_disable(&dev->gp_timer);
 
     acpi_last_clock = 0ULL;
@@ -2446,11 +2487,7 @@ acpi_speed_changed(void *priv)
 {
     acpi_t *dev        = (acpi_t *) priv;
     cpu_to_acpi        = ACPI_TIMER_FREQ / cpuclock;
-    bool timer_enabled = timer_is_enabled(&dev->timer);
-    timer_stop(&dev->timer);
-
-    if (timer_enabled)
-        timer_on_auto(&dev->timer, acpi_get_overflow_period(dev));
+    acpi_timer_update(dev, timer_is_enabled(&dev->timer));
 
     if ((dev->vendor & 0xffff) == 0x1039) {
         if (timer_is_on(&dev->gp_timer)) {
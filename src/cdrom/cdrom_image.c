@@ -28,18 +28,32 @@
 #include <string.h>
 #include <wchar.h>
 #include <sys/stat.h>
-#ifndef _WIN32
+#ifdef _WIN32
+#    include <windows.h>
+#    include <io.h>
+#    define BIN_HAVE_MMAP
+#else
 #    include <libgen.h>
+#    if defined(__unix__) || defined(__APPLE__)
+#        include <sys/mman.h>
+#        define BIN_HAVE_MMAP
+#    endif
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define BIN_SWAP_SSE2
 #endif
 #include <86box/86box.h>
 #include <86box/log.h>
 #include <86box/path.h>
 #include <86box/plat.h>
+#include <86box/thread.h>
 #include <86box/cdrom.h>
 #include <86box/cdrom_image.h>
 #include <86box/cdrom_image_viso.h>
 
 #include <sndfile.h>
+#include <zlib.h>
 
 #define MAX_LINE_LENGTH     512
 #define MAX_FILENAME_LENGTH 256
@@ -106,17 +120,32 @@ typedef struct
 
 #define dstruct_t mds_disc_struct_t
 
+/*
+   A run of sectors (offset by 150, like the index starts) that all belong to
+   the same track and index, built once the tracks are final so that the per
+   sector lookups are a binary search rather than a scan of every index.
+ */
+typedef struct track_range_t {
+    uint64_t      start;
+    uint64_t      end; /* Exclusive. */
+    int16_t       track;     /* Any track, as returned by image_get_track(). */
+    int16_t       toc_track; /* Tracks 01-99 only, with toc_index. */
+    int16_t       toc_index;
+} track_range_t;
+
 typedef struct cd_image_t {
-    cdrom_t      *dev;
-    void         *log;
-    int           is_dvd;
-    int           has_audio;
-    int           has_dstruct;
-    int32_t       tracks_num;
-    uint32_t      bad_sectors_num;
-    track_t      *tracks;
-    uint32_t     *bad_sectors;
-    dstruct_t     dstruct;
+    cdrom_t       *dev;
+    void          *log;
+    int            is_dvd;
+    int            has_audio;
+    int            has_dstruct;
+    int32_t        tracks_num;
+    uint32_t       bad_sectors_num;
+    int32_t        ranges_num;
+    track_t       *tracks;
+    uint32_t      *bad_sectors;
+    track_range_t *ranges;
+    dstruct_t      dstruct;
 } cd_image_t;
 
 typedef enum
@@ -248,30 +277,99 @@ static char   *cit[4]   = { "SPECIAL", "NONE", "ZERO", "NORMAL" };
 #    define image_log(priv, fmt, ...)
 #endif
 
+/*
+ * A BIN file is either mapped into memory, or read in chunks: a read that
+ * misses both chunks fills one of them, and while the reads keep going
+ * forward, the other one is filled with what comes next on a thread of its
+ * own, so a stream (an install, FMV) rarely waits for the host.
+ */
+typedef struct bin_file_t {
+    /* Reads len bytes at start into buf, returns how many were read. */
+    size_t (*fill)(track_file_t *tf, uint8_t *buf, uint64_t start, size_t len);
+
+    uint8_t *map;
+    uint64_t map_size;
+#ifdef _WIN32
+    HANDLE map_handle;
+#endif
+
+    size_t   chunk_size;
+    uint8_t *chunk[2];
+    uint64_t chunk_start[2];
+    size_t   chunk_len[2];
+    int      last;
+    uint64_t next; /* First byte after the last read. */
+
+    thread_t *thread;
+    mutex_t  *mutex;
+    event_t  *wake_event;
+    event_t  *done_event;
+    int       filling; /* Chunk the thread is filling, -1 if none. */
+    int       run;
+} bin_file_t;
+
+/* Audio files are decoded through the same chunks, so that playing them
+   does not wait for the decoder. */
 typedef struct audio_file_t {
-    SNDFILE *file;
-    SF_INFO  info;
+    bin_file_t bin; /* Must be first. */
+    SNDFILE   *file;
+    SF_INFO    info;
 } audio_file_t;
 
+/*
+ * Compressed ISO (CISO/CSO) track files: the image is split in blocks that
+ * are deflated one by one, with an index of where each block starts, so any
+ * block can be read on its own. Recently used blocks are kept decompressed.
+ */
+#define CSO_CACHE_BLOCKS 64
+
+typedef struct cso_header_t {
+    char     magic[4];
+    uint32_t header_size;
+    uint64_t total_bytes;
+    uint32_t block_size;
+    uint8_t  version;
+    uint8_t  align;
+    uint8_t  reserved[2];
+} cso_header_t;
+
+typedef struct cso_cache_entry_t {
+    uint32_t block;
+    uint32_t last_use;
+    uint8_t *data;
+} cso_cache_entry_t;
+
+typedef struct cso_file_t {
+    cso_header_t header;
+    uint32_t     num_blocks;
+    uint32_t    *index;
+    uint8_t     *comp;
+    size_t       comp_size;
+    z_stream     zs;
+    uint32_t     use_count;
+
+    cso_cache_entry_t cache[CSO_CACHE_BLOCKS];
+} cso_file_t;
+
+int cdrom_image_mmap       = 0;   /* (C) map BIN images into memory */
+int cdrom_image_read_ahead = 256; /* (C) BIN read chunk in kB, 0 = unbuffered */
+
+static int  bin_read_chunked(track_file_t *tf, uint8_t *buffer, uint64_t seek, size_t count);
+static void bin_close_buffers(bin_file_t *bin);
+
 /* Audio file functions */
-static int
-audio_read(void *priv, uint8_t *buffer, const uint64_t seek, const size_t count)
+static size_t
+audio_fill(track_file_t *tf, uint8_t *buf, const uint64_t start, const size_t len)
 {
-    const track_file_t *tf            = (track_file_t *) priv;
-    const audio_file_t *audio         = (audio_file_t *) tf->priv;
-    const uint64_t      samples_seek  = seek / 4;
-    const uint64_t      samples_count = count / 4;
-
-    if ((seek & 3) || (count & 3)) {
-        image_log(tf->log, "CD Audio file: Reading on non-4-aligned boundaries.\n");
-    }
-
-    const sf_count_t res = sf_seek(audio->file, samples_seek, SEEK_SET);
+    const audio_file_t *audio = (audio_file_t *) tf->priv;
+    sf_count_t          res;
 
-    if (res == -1)
+    if (sf_seek(audio->file, start / 4, SEEK_SET) == -1)
         return 0;
 
-    return !!sf_readf_short(audio->file, (short *) buffer, samples_count);
+    res = sf_readf_short(audio->file, (short *) buf, len / 4);
+
+    return (res > 0) ? ((size_t) res * 4) : 0;
 }
 
 static uint64_t
@@ -284,6 +382,27 @@ audio_get_length(void *priv)
     return audio->info.frames * 4ull;
 }
 
+static int
+audio_read(void *priv, uint8_t *buffer, const uint64_t seek, const size_t count)
+{
+    track_file_t  *tf     = (track_file_t *) priv;
+    audio_file_t  *audio  = (audio_file_t *) tf->priv;
+    const uint64_t length = audio_get_length(tf);
+
+    if ((seek & 3) || (count & 3)) {
+        image_log(tf->log, "CD Audio file: Reading on non-4-aligned boundaries.\n");
+    }
+
+    if (audio->bin.chunk[0] == NULL)
+        return !!audio_fill(tf, buffer, seek, count);
+
+    /* A short last sector reads as much as there is. */
+    if (seek >= length)
+        return 0;
+
+    return bin_read_chunked(tf, buffer, seek, ((length - seek) < count) ? (size_t) (length - seek) : count) > 0;
+}
+
 static void
 audio_close(void *priv)
 {
@@ -291,8 +410,11 @@ audio_close(void *priv)
     audio_file_t *audio = (audio_file_t *) tf->priv;
 
     memset(tf->fn, 0x00, sizeof(tf->fn));
-    if (audio && audio->file)
-        sf_close(audio->file);
+    if (audio) {
+        bin_close_buffers(&audio->bin);
+        if (audio->file)
+            sf_close(audio->file);
+    }
     free(audio);
     free(tf);
 }
@@ -343,6 +465,16 @@ audio_init(const uint8_t id, const char *filename, int *error)
     sprintf(n, "CD-ROM %i Audio", id + 1);
     tf->log          = log_open(n);
 
+    audio->bin.fill = audio_fill;
+    if (cdrom_image_read_ahead > 0) {
+        /* Whole frames only. */
+        audio->bin.chunk_size = ((size_t) cdrom_image_read_ahead << 10) & ~((size_t) 3);
+        audio->bin.chunk[0]   = (uint8_t *) malloc(audio->bin.chunk_size);
+        audio->bin.chunk[1]   = (uint8_t *) malloc(audio->bin.chunk_size);
+        if ((audio->bin.chunk[0] == NULL) || (audio->bin.chunk[1] == NULL))
+            bin_close_buffers(&audio->bin);
+    }
+
     return tf;
 cleanup_error:
     free(tf);
@@ -352,10 +484,187 @@ cleanup_error:
 }
 
 /* Binary file functions. */
+static void
+bin_swap(uint8_t *buffer, const size_t count)
+{
+    size_t i = 0;
+
+#ifdef BIN_SWAP_SSE2
+    for (; (i + 16) <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) &buffer[i]);
+        _mm_storeu_si128((__m128i *) &buffer[i], _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+#endif
+
+    for (; (i + 1) < count; i += 2) {
+        const uint8_t buffer0 = buffer[i];
+        buffer[i]             = buffer[i + 1];
+        buffer[i + 1]         = buffer0;
+    }
+}
+
+static size_t
+bin_fill(track_file_t *tf, uint8_t *buf, const uint64_t start, const size_t len)
+{
+    if (fseeko64(tf->fp, start, SEEK_SET) == -1)
+        return 0;
+
+    return fread(buf, 1, len, tf->fp);
+}
+
+static void
+bin_thread(void *param)
+{
+    track_file_t *tf  = (track_file_t *) param;
+    bin_file_t   *bin = (bin_file_t *) tf->priv;
+    size_t        len;
+    int           c;
+
+    while (1) {
+        thread_wait_event(bin->wake_event, -1);
+        thread_reset_event(bin->wake_event);
+
+        thread_wait_mutex(bin->mutex);
+        c = bin->filling;
+        thread_release_mutex(bin->mutex);
+
+        if (c < 0) {
+            if (!bin->run)
+                break;
+            continue;
+        }
+
+        len = bin->fill(tf, bin->chunk[c], bin->chunk_start[c], bin->chunk_size);
+
+        thread_wait_mutex(bin->mutex);
+        bin->chunk_len[c] = len;
+        bin->filling      = -1;
+        thread_release_mutex(bin->mutex);
+        thread_set_event(bin->done_event);
+    }
+}
+
+/* The file is ours once the thread is done with the chunk it is filling. */
+static void
+bin_wait(bin_file_t *bin)
+{
+    if (bin->thread == NULL)
+        return;
+
+    while (1) {
+        thread_wait_mutex(bin->mutex);
+        if (bin->filling < 0) {
+            thread_release_mutex(bin->mutex);
+            return;
+        }
+        thread_reset_event(bin->done_event);
+        thread_release_mutex(bin->mutex);
+
+        thread_wait_event(bin->done_event, -1);
+    }
+}
+
+static int
+bin_is_filling(bin_file_t *bin, const int c)
+{
+    int ret;
+
+    if (bin->thread == NULL)
+        return 0;
+
+    thread_wait_mutex(bin->mutex);
+    ret = (bin->filling == c);
+    thread_release_mutex(bin->mutex);
+
+    return ret;
+}
+
+static void
+bin_read_ahead(track_file_t *tf, const int c, const uint64_t start)
+{
+    bin_file_t *bin = (bin_file_t *) tf->priv;
+
+    if (bin->thread == NULL) {
+        bin->mutex      = thread_create_mutex();
+        bin->wake_event = thread_create_event();
+        bin->done_event = thread_create_event();
+        bin->filling    = -1;
+        bin->run        = 1;
+        bin->thread     = thread_create_named(bin_thread, tf, "CD-ROM image read-ahead");
+    }
+
+    bin->chunk_start[c] = start;
+    bin->chunk_len[c]   = 0;
+
+    thread_wait_mutex(bin->mutex);
+    bin->filling = c;
+    thread_release_mutex(bin->mutex);
+    thread_set_event(bin->wake_event);
+}
+
+static int
+bin_read_chunked(track_file_t *tf, uint8_t *buffer, uint64_t seek, size_t count)
+{
+    bin_file_t *bin        = (bin_file_t *) tf->priv;
+    const int   sequential = (seek == bin->next);
+    uint64_t    end;
+    size_t      n;
+    int         c;
+
+    bin->next = seek + count;
+
+    while (count) {
+        c = -1;
+        for (int i = 0; i < 2; i++) {
+            if ((seek < bin->chunk_start[i]) || (seek >= (bin->chunk_start[i] + bin->chunk_size)))
+                continue;
+
+            if (bin_is_filling(bin, i))
+                bin_wait(bin);
+
+            if (seek < (bin->chunk_start[i] + bin->chunk_len[i])) {
+                c = i;
+                break;
+            }
+        }
+
+        if (c < 0) {
+            /* Keep the chunk that was read last, the guest may go back to it. */
+            bin_wait(bin);
+            c                   = bin->last ^ 1;
+            bin->chunk_start[c] = seek;
+            bin->chunk_len[c]   = bin->fill(tf, bin->chunk[c], seek, bin->chunk_size);
+
+            if (bin->chunk_len[c] == 0) {
+                image_log(tf->log, "binary_read failed during read!\n");
+                return -1;
+            }
+        }
+
+        end = bin->chunk_start[c] + bin->chunk_len[c];
+        n   = ((end - seek) < count) ? (size_t) (end - seek) : count;
+        memcpy(buffer, &bin->chunk[c][seek - bin->chunk_start[c]], n);
+
+        buffer += n;
+        seek += n;
+        count -= n;
+        bin->last = c;
+
+        /* A full chunk being streamed through gets the next one read ahead. */
+        if (sequential && (bin->chunk_len[c] == bin->chunk_size) && (bin->chunk_start[c ^ 1] != end)) {
+            bin_wait(bin);
+            bin_read_ahead(tf, c ^ 1, end);
+        }
+    }
+
+    return 1;
+}
+
 static int
 bin_read(void *priv, uint8_t *buffer, const uint64_t seek, const size_t count)
 {
-    const track_file_t *tf = (track_file_t *) priv;
+    track_file_t     *tf  = (track_file_t *) priv;
+    const bin_file_t *bin = (bin_file_t *) tf->priv;
 
     if (tf->fp == NULL)
         return 0;
@@ -363,27 +672,34 @@ bin_read(void *priv, uint8_t *buffer, const uint64_t seek, const size_t count)
     image_log(tf->log, "binary_read(%08lx, pos=%" PRIu64 " count=%lu)\n",
                     tf->fp, seek, count);
 
-    if (fseeko64(tf->fp, seek, SEEK_SET) == -1) {
-        image_log(tf->log, "binary_read failed during seek!\n");
+    if (bin->map != NULL) {
+        if ((seek + count) > bin->map_size) {
+            image_log(tf->log, "binary_read failed during read!\n");
 
-        return -1;
-    }
+            return -1;
+        }
 
-    if (fread(buffer, count, 1, tf->fp) != 1) {
-        image_log(tf->log, "binary_read failed during read!\n");
+        memcpy(buffer, &bin->map[seek], count);
+    } else if (bin->chunk[0] != NULL) {
+        if (bin_read_chunked(tf, buffer, seek, count) < 0)
+            return -1;
+    } else {
+        if (fseeko64(tf->fp, seek, SEEK_SET) == -1) {
+            image_log(tf->log, "binary_read failed during seek!\n");
 
-        return -1;
-    }
+            return -1;
+        }
+
+        if (fread(buffer, count, 1, tf->fp) != 1) {
+            image_log(tf->log, "binary_read failed during read!\n");
 
-    if (UNLIKELY(tf->motorola)) {
-        for (uint64_t i = 0; i < count; i += 2) {
-            const uint8_t buffer0 = buffer[i];
-            const uint8_t buffer1 = buffer[i + 1];
-            buffer[i] = buffer1;
-            buffer[i + 1] = buffer0;
+            return -1;
         }
     }
 
+    if (UNLIKELY(tf->motorola))
+        bin_swap(buffer, count);
+
     return 1;
 }
 
@@ -395,6 +711,8 @@ bin_get_length(void *priv)
     if (tf->fp == NULL)
         return 0;
 
+    bin_wait((bin_file_t *) tf->priv);
+
     fseeko64(tf->fp, 0, SEEK_END);
     const off64_t len = ftello64(tf->fp);
     image_log(tf->log, "binary_length(%08lx) = %" PRIu64 "\n", tf->fp, len);
@@ -402,14 +720,55 @@ bin_get_length(void *priv)
     return len;
 }
 
+/* Stop the read-ahead thread and release the map or the chunks. */
+static void
+bin_close_buffers(bin_file_t *bin)
+{
+    if (bin->thread != NULL) {
+        bin_wait(bin);
+        bin->run = 0;
+        thread_set_event(bin->wake_event);
+        thread_wait(bin->thread);
+
+        thread_destroy_event(bin->wake_event);
+        thread_destroy_event(bin->done_event);
+        thread_close_mutex(bin->mutex);
+        bin->thread = NULL;
+    }
+
+#ifdef BIN_HAVE_MMAP
+    if (bin->map != NULL) {
+#    ifdef _WIN32
+        UnmapViewOfFile(bin->map);
+        CloseHandle(bin->map_handle);
+#    else
+        munmap(bin->map, (size_t) bin->map_size);
+#    endif
+        bin->map = NULL;
+    }
+#endif
+
+    free(bin->chunk[0]);
+    free(bin->chunk[1]);
+    bin->chunk[0] = bin->chunk[1] = NULL;
+}
+
 static void
 bin_close(void *priv)
 {
     track_file_t *tf = (track_file_t *) priv;
+    bin_file_t   *bin;
 
     if (tf == NULL)
         return;
 
+    bin = (bin_file_t *) tf->priv;
+    if (bin != NULL) {
+        bin_close_buffers(bin);
+        free(bin);
+        tf->priv = NULL;
+    }
+
     if (tf->fp != NULL) {
         fclose(tf->fp);
         tf->fp = NULL;
@@ -423,6 +782,262 @@ bin_close(void *priv)
     free(priv);
 }
 
+#ifdef BIN_HAVE_MMAP
+static void
+bin_map(track_file_t *tf)
+{
+    bin_file_t *bin  = (bin_file_t *) tf->priv;
+    uint64_t    size = bin_get_length(tf);
+    uint8_t    *map  = NULL;
+
+    if ((size == 0) || (size > (uint64_t) SIZE_MAX))
+        return;
+
+#    ifdef _WIN32
+    bin->map_handle = CreateFileMapping((HANDLE) _get_osfhandle(_fileno(tf->fp)), NULL, PAGE_READONLY, 0, 0, NULL);
+    if (bin->map_handle == NULL)
+        return;
+
+    map = (uint8_t *) MapViewOfFile(bin->map_handle, FILE_MAP_READ, 0, 0, (SIZE_T) size);
+    if (map == NULL) {
+        CloseHandle(bin->map_handle);
+        bin->map_handle = NULL;
+        return;
+    }
+#    else
+    map = (uint8_t *) mmap(NULL, (size_t) size, PROT_READ, MAP_SHARED, fileno(tf->fp), 0);
+    if (map == MAP_FAILED)
+        return;
+#    endif
+
+    image_log(tf->log, "binary_map(%s) = %" PRIu64 " bytes\n", tf->fn, size);
+
+    bin->map      = map;
+    bin->map_size = size;
+}
+#endif
+
+/* Map the file if asked to, else set up the read chunks if there are any. */
+static void
+bin_open_buffers(track_file_t *tf)
+{
+    bin_file_t *bin = (bin_file_t *) tf->priv;
+
+    bin->fill = bin_fill;
+
+#ifdef BIN_HAVE_MMAP
+    if (cdrom_image_mmap) {
+        bin_map(tf);
+        if (bin->map != NULL)
+            return;
+    }
+#endif
+
+    if (cdrom_image_read_ahead > 0) {
+        bin->chunk_size = (size_t) cdrom_image_read_ahead << 10;
+        bin->chunk[0]   = (uint8_t *) malloc(bin->chunk_size);
+        bin->chunk[1]   = (uint8_t *) malloc(bin->chunk_size);
+    }
+}
+
+/* Compressed ISO functions. */
+static uint64_t
+cso_block_offset(const cso_file_t *cso, const uint32_t block)
+{
+    return ((uint64_t) (cso->index[block] & 0x7fffffff)) << cso->header.align;
+}
+
+/* Decompress a block into the cache, returns its data or NULL on error. */
+static uint8_t *
+cso_get_block(track_file_t *tf, const uint32_t block)
+{
+    cso_file_t        *cso   = (cso_file_t *) tf->priv;
+    const uint32_t     bsize = cso->header.block_size;
+    cso_cache_entry_t *entry = &cso->cache[0];
+    uint64_t           start;
+    size_t             size;
+    int                plain;
+
+    for (int i = 0; i < CSO_CACHE_BLOCKS; i++) {
+        if ((cso->cache[i].data != NULL) && (cso->cache[i].block == block)) {
+            cso->cache[i].last_use = ++cso->use_count;
+            return cso->cache[i].data;
+        }
+
+        if (cso->cache[i].last_use < entry->last_use)
+            entry = &cso->cache[i];
+    }
+
+    start = cso_block_offset(cso, block);
+    size  = (size_t) (cso_block_offset(cso, block + 1) - start);
+
+    /* Version 1 flags stored blocks in the index, version 2 stores every
+       block that would not shrink as is and uses the flag for LZ4. */
+    if (cso->header.version >= 2) {
+        if (cso->index[block] & 0x80000000) {
+            image_log(tf->log, "CSO: LZ4 blocks are not supported\n");
+            return NULL;
+        }
+        plain = (size >= bsize);
+    } else
+        plain = !!(cso->index[block] & 0x80000000);
+
+    if (plain && (size > bsize))
+        size = bsize;
+
+    if (size > cso->comp_size) {
+        uint8_t *comp = (uint8_t *) realloc(cso->comp, size);
+        if (comp == NULL)
+            return NULL;
+        cso->comp      = comp;
+        cso->comp_size = size;
+    }
+
+    if (entry->data == NULL) {
+        entry->data = (uint8_t *) malloc(bsize);
+        if (entry->data == NULL)
+            return NULL;
+    }
+    entry->block    = (uint32_t) -1;
+    entry->last_use = 0;
+
+    if ((fseeko64(tf->fp, start, SEEK_SET) == -1) || (fread(cso->comp, 1, size, tf->fp) != size)) {
+        image_log(tf->log, "CSO: Error reading block %i\n", block);
+        return NULL;
+    }
+
+    if (plain)
+        memcpy(entry->data, cso->comp, size);
+    else {
+        inflateReset(&cso->zs);
+        cso->zs.next_in   = cso->comp;
+        cso->zs.avail_in  = (uInt) size;
+        cso->zs.next_out  = entry->data;
+        cso->zs.avail_out = bsize;
+
+        const int ret = inflate(&cso->zs, Z_FINISH);
+        if ((ret != Z_STREAM_END) && ((ret != Z_BUF_ERROR) || (cso->zs.avail_out != 0))) {
+            image_log(tf->log, "CSO: Error decompressing block %i\n", block);
+            return NULL;
+        }
+    }
+
+    entry->block    = block;
+    entry->last_use = ++cso->use_count;
+
+    return entry->data;
+}
+
+static int
+cso_read(void *priv, uint8_t *buffer, const uint64_t seek, const size_t count)
+{
+    track_file_t     *tf    = (track_file_t *) priv;
+    const cso_file_t *cso   = (cso_file_t *) tf->priv;
+    const uint32_t    bsize = cso->header.block_size;
+    uint64_t          pos   = seek;
+    size_t            left  = count;
+
+    if ((seek + count) > cso->header.total_bytes) {
+        image_log(tf->log, "cso_read failed, reading past the end!\n");
+        return -1;
+    }
+
+    while (left) {
+        const uint8_t *data = cso_get_block(tf, (uint32_t) (pos / bsize));
+        const uint32_t offs = (uint32_t) (pos % bsize);
+        const size_t   n    = ((bsize - offs) < left) ? (bsize - offs) : left;
+
+        if (data == NULL)
+            return -1;
+
+        memcpy(buffer, &data[offs], n);
+        buffer += n;
+        pos += n;
+        left -= n;
+    }
+
+    if (UNLIKELY(tf->motorola))
+        bin_swap(buffer - count, count);
+
+    return 1;
+}
+
+static uint64_t
+cso_get_length(void *priv)
+{
+    const track_file_t *tf = (track_file_t *) priv;
+
+    return ((cso_file_t *) tf->priv)->header.total_bytes;
+}
+
+static void
+cso_close(void *priv)
+{
+    track_file_t *tf  = (track_file_t *) priv;
+    cso_file_t   *cso = (cso_file_t *) tf->priv;
+
+    if (cso != NULL) {
+        inflateEnd(&cso->zs);
+        for (int i = 0; i < CSO_CACHE_BLOCKS; i++)
+            free(cso->cache[i].data);
+        free(cso->index);
+        free(cso->comp);
+        free(cso);
+        tf->priv = NULL;
+    }
+
+    bin_close(tf);
+}
+
+/* Returns 1 if the file is a CSO and is ready for reading, 0 if it is not
+   a CSO, and -1 if it is one that can not be read. */
+static int
+cso_open(track_file_t *tf)
+{
+    cso_header_t header;
+    cso_file_t  *cso;
+    uint32_t     num_blocks;
+
+    if ((fseeko64(tf->fp, 0, SEEK_SET) == -1) || (fread(&header, 1, sizeof(header), tf->fp) != sizeof(header)) ||
+        memcmp(header.magic, "CISO", 4))
+        return 0;
+
+    if ((header.version > 2) || (header.block_size < 512) || (header.block_size > (1 << 20)) ||
+        (header.total_bytes == 0) || (header.align > 31)) {
+        image_log(tf->log, "CSO: Unsupported header\n");
+        return -1;
+    }
+
+    num_blocks = (uint32_t) ((header.total_bytes + header.block_size - 1) / header.block_size);
+
+    cso = (cso_file_t *) calloc(1, sizeof(cso_file_t));
+    if (cso == NULL)
+        return -1;
+    cso->header     = header;
+    cso->num_blocks = num_blocks;
+    cso->index      = (uint32_t *) malloc((num_blocks + 1) * sizeof(uint32_t));
+
+    /* The index always follows the 24-byte header. */
+    if ((cso->index == NULL) ||
+        (fread(cso->index, sizeof(uint32_t), num_blocks + 1, tf->fp) != (num_blocks + 1)) ||
+        (inflateInit2(&cso->zs, -15) != Z_OK)) {
+        image_log(tf->log, "CSO: Error reading the block index\n");
+        free(cso->index);
+        free(cso);
+        return -1;
+    }
+
+    image_log(tf->log, "CSO: %" PRIu64 " bytes in %i blocks of %i bytes\n",
+              header.total_bytes, num_blocks, header.block_size);
+
+    tf->priv       = cso;
+    tf->read       = cso_read;
+    tf->get_length = cso_get_length;
+    tf->close      = cso_close;
+
+    return 1;
+}
+
 static track_file_t *
 bin_init(const uint8_t id, const char *filename, int *error)
 {
@@ -450,11 +1065,27 @@ bin_init(const uint8_t id, const char *filename, int *error)
     }
     *error = ((tf->fp == NULL) || ((stats.st_mode & S_IFMT) == S_IFDIR));
 
+    if (!*error && ((stats.st_mode & S_IFMT) != S_IFDIR)) {
+        switch (cso_open(tf)) {
+            case 1:
+                return tf;
+            case -1:
+                bin_close(tf);
+                *error = 1;
+                return NULL;
+            default:
+                break;
+        }
+    }
+
     /* Set the function pointers. */
     if (!*error) {
         tf->read       = bin_read;
         tf->get_length = bin_get_length;
         tf->close      = bin_close;
+        tf->priv       = calloc(1, sizeof(bin_file_t));
+
+        bin_open_buffers(tf);
     } else {
         /* From the check above, error may still be non-zero if opening a directory.
          * The error is set for viso to try and open the directory following this function.
@@ -520,45 +1151,175 @@ index_file_close(track_index_t *idx)
 }
 
 /* Internal functions. */
-static int
-image_get_track(const cd_image_t *img, const uint32_t sector)
+
+/*
+   Find the last track with an index containing pos, and the first such index
+   in it, optionally only looking at tracks 01-99.
+ */
+static void
+image_scan_tracks(const cd_image_t *img, const uint64_t pos, const int toc,
+                  int *track, int *index)
 {
-    int ret = -1;
+    *track = -1;
+    *index = -1;
 
     for (int i = 0; i < img->tracks_num; i++) {
-        track_t *ct = &(img->tracks[i]);
+        const track_t *ct = &(img->tracks[i]);
+        if (toc && ((ct->point < 1) || (ct->point > 99)))
+            continue;
+
         for (int j = 0; j <= ct->max_index; j++) {
             const track_index_t *ci = &(ct->idx[j]);
             if ((ci->type >= INDEX_ZERO) && (ci->length != 0ULL) &&
-                ((sector + 150) >= ci->start) && ((sector + 150) <= (ci->start + ci->length - 1))) {
-                ret = i;
+                (pos >= ci->start) && (pos <= (ci->start + ci->length - 1))) {
+                *track = i;
+                *index = j;
                 break;
             }
         }
     }
+}
 
-    return ret;
+static int
+image_compare_u64(const void *a, const void *b)
+{
+    const uint64_t va = *((const uint64_t *) a);
+    const uint64_t vb = *((const uint64_t *) b);
+
+    return (va > vb) - (va < vb);
 }
 
+/*
+   Split the disc at every index start and end, then look up each piece the
+   slow way once, merging the neighbours that give the same answer.
+ */
 static void
-image_get_track_and_index(const cd_image_t *img, const uint32_t sector,
-                          int *track, int *index)
+image_build_ranges(cd_image_t *img)
 {
-    *track = -1;
-    *index = -1;
+    uint64_t      *bounds;
+    track_range_t *ranges;
+    int            bounds_num = 0;
+    int            num        = 0;
+    int            track;
+    int            index;
+    int            toc_track;
+    int            toc_index;
+
+    free(img->ranges);
+    img->ranges     = NULL;
+    img->ranges_num = 0;
+
+    bounds = (uint64_t *) malloc(img->tracks_num * 100 * 2 * sizeof(uint64_t));
+    if (bounds == NULL)
+        return;
 
     for (int i = 0; i < img->tracks_num; i++) {
-        track_t *ct = &(img->tracks[i]);
-        if ((ct->point >= 1) && (ct->point <= 99))  for (int j = 0; j <= ct->max_index; j++) {
-            track_index_t *ci = &(ct->idx[j]);
-            if ((ci->type >= INDEX_ZERO) && (ci->length != 0ULL) &&
-                ((sector + 150) >= ci->start) && ((sector + 150) <= (ci->start + ci->length - 1))) {
-                *track = i;
-                *index = j;
-                break;
+        const track_t *ct = &(img->tracks[i]);
+
+        for (int j = 0; j <= ct->max_index; j++) {
+            const track_index_t *ci = &(ct->idx[j]);
+            if ((ci->type >= INDEX_ZERO) && (ci->length != 0ULL)) {
+                bounds[bounds_num++] = ci->start;
+                bounds[bounds_num++] = ci->start + ci->length;
             }
         }
     }
+
+    qsort(bounds, bounds_num, sizeof(uint64_t), image_compare_u64);
+
+    ranges = (track_range_t *) malloc(MAX(bounds_num, 1) * sizeof(track_range_t));
+    if (ranges == NULL) {
+        free(bounds);
+        return;
+    }
+
+    for (int i = 0; i < (bounds_num - 1); i++) {
+        if (bounds[i] == bounds[i + 1])
+            continue;
+
+        image_scan_tracks(img, bounds[i], 0, &track, &index);
+        image_scan_tracks(img, bounds[i], 1, &toc_track, &toc_index);
+
+        /* Sectors in no index at all are left out. */
+        if ((track < 0) && (toc_track < 0))
+            continue;
+
+        if ((num > 0) && (ranges[num - 1].end == bounds[i]) && (ranges[num - 1].track == track) &&
+            (ranges[num - 1].toc_track == toc_track) && (ranges[num - 1].toc_index == toc_index)) {
+            ranges[num - 1].end = bounds[i + 1];
+            continue;
+        }
+
+        ranges[num].start     = bounds[i];
+        ranges[num].end       = bounds[i + 1];
+        ranges[num].track     = track;
+        ranges[num].toc_track = toc_track;
+        ranges[num].toc_index = toc_index;
+        num++;
+    }
+
+    free(bounds);
+
+    image_log(img->log, "%i sector ranges for %i tracks\n", num, img->tracks_num);
+
+    img->ranges     = ranges;
+    img->ranges_num = num;
+}
+
+static const track_range_t *
+image_find_range(const cd_image_t *img, const uint64_t pos)
+{
+    int lo = 0;
+    int hi = img->ranges_num - 1;
+
+    while (lo <= hi) {
+        const int            mid = (lo + hi) >> 1;
+        const track_range_t *r   = &(img->ranges[mid]);
+
+        if (pos < r->start)
+            hi = mid - 1;
+        else if (pos >= r->end)
+            lo = mid + 1;
+        else
+            return r;
+    }
+
+    return NULL;
+}
+
+static int
+image_get_track(const cd_image_t *img, const uint32_t sector)
+{
+    const uint64_t pos = (uint32_t) (sector + 150);
+    int            track;
+    int            index;
+
+    if (img->ranges != NULL) {
+        const track_range_t *r = image_find_range(img, pos);
+
+        return (r != NULL) ? r->track : -1;
+    }
+
+    image_scan_tracks(img, pos, 0, &track, &index);
+
+    return track;
+}
+
+static void
+image_get_track_and_index(const cd_image_t *img, const uint32_t sector,
+                          int *track, int *index)
+{
+    const uint64_t pos = (uint32_t) (sector + 150);
+
+    if (img->ranges != NULL) {
+        const track_range_t *r = image_find_range(img, pos);
+
+        *track = (r != NULL) ? r->toc_track : -1;
+        *index = (r != NULL) ? r->toc_index : -1;
+        return;
+    }
+
+    image_scan_tracks(img, pos, 1, track, index);
 }
 
 static int
@@ -2325,6 +3086,10 @@ image_clear_tracks(cd_image_t *img)
         /* Mark that there's no tracks. */
         img->tracks_num = 0;
     }
+
+    free(img->ranges);
+    img->ranges     = NULL;
+    img->ranges_num = 0;
 }
 
 /* Shared functions. */
@@ -2716,6 +3481,8 @@ image_open(cdrom_t *dev, const char *path)
         }
 
         if (ret > 0) {
+            image_build_ranges(img);
+
             if (img->is_dvd == 2) {
                 uint32_t lb = image_get_last_block(img); /* Should be safer than previous way of doing it? */
                 img->is_dvd = (lb >= 524287);    /* Minimum 1 GB total capacity as threshold for DVD. */
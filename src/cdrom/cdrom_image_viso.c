@@ -126,15 +126,28 @@ typedef struct {
     uint64_t pt_meta_offsets[2];
     int      format;
     uint8_t  use_version_suffix : 1;
-    size_t   metadata_sectors, all_sectors, entry_map_size, sector_size, file_fifo_pos;
+    size_t   metadata_sectors, all_sectors, entry_map_size, sector_size;
     uint8_t *metadata;
+    uint32_t open_count;
 
     track_file_t   tf;
     viso_entry_t  *root_dir;
     viso_entry_t **entry_map;
-    viso_entry_t  *file_fifo[VISO_OPEN_FILES];
+    viso_entry_t  *open_files[VISO_OPEN_FILES];
+    uint32_t       open_use[VISO_OPEN_FILES];
 } viso_t;
 
+/* Short names already given out in the directory being scanned, and the
+   next tail number worth trying for each name stem. */
+typedef struct {
+    size_t       size; /* power of 2 */
+    const char **names;
+    struct {
+        char key[16];
+        int  next;
+    } *tails;
+} viso_names_t;
+
 static const char rr_eid[]   = "RRIP_1991A"; /* identifiers used in ER field for Rock Ridge */
 static const char rr_edesc[] = "THE ROCK RIDGE INTERCHANGE PROTOCOL PROVIDES SUPPORT FOR POSIX FILE SYSTEM SEMANTICS.";
 static int8_t     tz_offset  = 0;
@@ -321,8 +334,77 @@ viso_convert_utf8(wchar_t *dest, const char *src, ssize_t buf_size)
 VISO_WRITE_STR_FUNC(viso_write_string, uint8_t, char, , 0)
 VISO_WRITE_STR_FUNC(viso_write_wstring, uint16_t, wchar_t, cpu_to_be16, c > 0xffff)
 
+static uint32_t
+viso_hash(const char *str)
+{
+    uint32_t hash = 2166136261u; /* FNV-1a */
+
+    while (*str)
+        hash = (hash ^ (uint8_t) *str++) * 16777619u;
+
+    return hash;
+}
+
+/* Prepare the name tables for a directory of up to count entries. */
+static int
+viso_names_reset(viso_names_t *names, size_t count)
+{
+    size_t size = 64;
+
+    while (size < (count * 2))
+        size <<= 1;
+
+    if (size > names->size) {
+        const char **new_names = (const char **) realloc(names->names, size * sizeof(names->names[0]));
+        if (new_names)
+            names->names = new_names;
+        void *new_tails = realloc(names->tails, size * sizeof(names->tails[0]));
+        if (new_tails)
+            names->tails = new_tails;
+        if (!new_names || !new_tails)
+            return 0;
+        names->size = size;
+    }
+
+    memset(names->names, 0x00, names->size * sizeof(names->names[0]));
+    memset(names->tails, 0x00, names->size * sizeof(names->tails[0]));
+    return 1;
+}
+
+/* Returns the slot holding this name, or the free slot where it belongs. */
+static size_t
+viso_names_find(const viso_names_t *names, const char *name)
+{
+    size_t i = viso_hash(name) & (names->size - 1);
+
+    while (names->names[i] && strcmp(names->names[i], name))
+        i = (i + 1) & (names->size - 1);
+
+    return i;
+}
+
+static void
+viso_names_add(viso_names_t *names, const char *name)
+{
+    names->names[viso_names_find(names, name)] = name;
+}
+
+static int *
+viso_names_tail(viso_names_t *names, const char *key)
+{
+    size_t i = viso_hash(key) & (names->size - 1);
+
+    while (names->tails[i].key[0] && strcmp(names->tails[i].key, key))
+        i = (i + 1) & (names->size - 1);
+
+    if (!names->tails[i].key[0])
+        strcpy(names->tails[i].key, key);
+
+    return &names->tails[i].next;
+}
+
 static int
-viso_fill_fn_short(char *data, const viso_entry_t *entry, viso_entry_t **entries)
+viso_fill_fn_short(char *data, const viso_entry_t *entry, viso_names_t *names)
 {
     /* Get name and extension length. */
     const char *ext_pos = strrchr(entry->basename, '.');
@@ -353,9 +435,16 @@ viso_fill_fn_short(char *data, const viso_entry_t *entry, viso_entry_t **entries
         viso_write_string((uint8_t *) &ext[1], &ext_pos[1], ext_len - 1, VISO_CHARSET_D);
     }
 
+    /* Names sharing a stem try the same tails in the same order, and every
+       tail below the last one given out for the stem is already taken, so
+       resume from there instead of testing all of them again. */
+    char key[16];
+    sprintf(key, "%s%s%c", data, ext, '0' + force_tail);
+    int *next_tail = viso_names_tail(names, key);
+
     /* Check if this filename is unique, and add a tail if required, while also adding the extension. */
     char tail[16];
-    for (int i = force_tail; i <= 999999; i++) {
+    for (int i = MAX(force_tail, *next_tail); i <= 999999; i++) {
         /* Add tail to the filename if this is not the first run. */
         int tail_len = -1;
         if (i) {
@@ -367,18 +456,16 @@ viso_fill_fn_short(char *data, const viso_entry_t *entry, viso_entry_t **entries
         if (ext[0])
             strcat(data, ext);
 
-        /* Go through files in this directory to make sure this filename is unique. */
-        for (size_t j = 0; entries[j] != entry; j++) {
-            /* Flag and stop if this filename was seen. */
-            if (!strcmp(data, entries[j]->name_short)) {
-                tail_len = 0;
-                break;
-            }
-        }
+        /* Make sure this filename is unique in this directory. */
+        if (names->names[viso_names_find(names, data)])
+            tail_len = 0;
 
         /* Stop if this is an unique name. */
-        if (tail_len)
+        if (tail_len) {
+            viso_names_add(names, data);
+            *next_tail = i + 1;
             return 0;
+        }
     }
     return 1;
 }
@@ -680,6 +767,49 @@ viso_compare_entries(const void *a, const void *b)
     return strcmp((*((viso_entry_t **) a))->name_short, (*((viso_entry_t **) b))->name_short);
 }
 
+/* Get an open handle for a file, closing the least recently used one if
+   too many are open. */
+static FILE *
+viso_get_file(viso_t *viso, viso_entry_t *entry)
+{
+    int slot = 0;
+
+    for (int i = 0; i < VISO_OPEN_FILES; i++) {
+        if (viso->open_files[i] == entry) {
+            viso->open_use[i] = ++viso->open_count;
+            return entry->file;
+        }
+
+        if (viso->open_use[i] < viso->open_use[slot])
+            slot = i;
+    }
+
+    /* Close the file in the slot being reused. */
+    viso_entry_t *other_entry = viso->open_files[slot];
+    if (other_entry && other_entry->file) {
+        image_viso_log(viso->tf.log, "Closing [%s]...\n", other_entry->path);
+        fclose(other_entry->file);
+        other_entry->file = NULL;
+        image_viso_log(viso->tf.log, "Done\n");
+    }
+
+    /* Open file. */
+    image_viso_log(viso->tf.log, "Opening [%s]...\n", entry->path);
+    if ((entry->file = fopen(entry->path, "rb"))) {
+        image_viso_log(viso->tf.log, "Done\n");
+
+        viso->open_files[slot] = entry;
+        viso->open_use[slot]   = ++viso->open_count;
+    } else {
+        image_viso_log(viso->tf.log, "Failed\n");
+
+        viso->open_files[slot] = NULL;
+        viso->open_use[slot]   = 0;
+    }
+
+    return entry->file;
+}
+
 int
 viso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
 {
@@ -703,38 +833,23 @@ viso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
             /* Get the file entry corresponding to this sector. */
             viso_entry_t *entry = viso->entry_map[sector - viso->metadata_sectors];
             if (entry) {
-                /* Open file if it's not already open. */
-                if (!entry->file) {
-                    /* Close any existing FIFO entry's file. */
-                    viso_entry_t *other_entry = viso->file_fifo[viso->file_fifo_pos];
-                    if (other_entry && other_entry->file) {
-                        image_viso_log(viso->tf.log, "Closing [%s]...\n", other_entry->path);
-                        fclose(other_entry->file);
-                        other_entry->file = NULL;
-                        image_viso_log(viso->tf.log, "Done\n");
-                    }
-
-                    /* Open file. */
-                    image_viso_log(viso->tf.log, "Opening [%s]...\n", entry->path);
-                    if ((entry->file = fopen(entry->path, "rb"))) {
-                        image_viso_log(viso->tf.log, "Done\n");
+                /* Read up to the end of this file's sectors in one go. */
+                uint64_t file_offset = seek - entry->data_offset;
+                uint64_t file_size   = entry->stats.st_size;
+                uint64_t file_end    = ((file_size + viso->sector_size - 1) / viso->sector_size) * viso->sector_size;
+                size_t   want        = 0;
 
-                        /* Add this entry to the FIFO. */
-                        viso->file_fifo[viso->file_fifo_pos++] = entry;
-                        viso->file_fifo_pos &= (sizeof(viso->file_fifo) / sizeof(viso->file_fifo[0])) - 1;
-                    } else {
-                        image_viso_log(viso->tf.log, "Failed\n");
+                sector_remain = MIN(count, file_end - file_offset);
+                if (file_offset < file_size)
+                    want = MIN(sector_remain, file_size - file_offset);
 
-                        /* Clear any existing FIFO entry. */
-                        viso->file_fifo[viso->file_fifo_pos] = NULL;
-                    }
-                }
+                FILE *fp = viso_get_file(viso, entry);
 
                 /* Read data. */
-                if (!entry->file || (fseeko64(entry->file, seek - entry->data_offset, SEEK_SET) == -1))
+                if (!fp || (fseeko64(fp, file_offset, SEEK_SET) == -1))
                     return -1;
-                read = fread(buffer, 1, sector_remain, entry->file);
-                if (sector_remain && !read)
+                read = fread(buffer, 1, want, fp);
+                if (want && !read)
                     return -1;
             }
 
@@ -871,6 +986,7 @@ viso_init(const uint8_t id, const char *dirname, int *error)
     /* Traverse directories, starting with the root. */
     viso_entry_t **dir_entries     = NULL;
     size_t         dir_entries_len = 0;
+    viso_names_t   names           = { 0 };
     while (dir) {
         /* Open directory for listing. */
         DIR *dirp = opendir(dir->path);
@@ -897,6 +1013,9 @@ viso_init(const uint8_t id, const char *dirname, int *error)
             }
         }
 
+        if (!viso_names_reset(&names, children_count))
+            goto next_dir;
+
         /* Add . and .. pseudo-directories. */
         dir_path_len = strlen(dir->path);
         for (children_count = 0; children_count < 2; children_count++) {
@@ -915,6 +1034,7 @@ viso_init(const uint8_t id, const char *dirname, int *error)
 
             /* Set basename. */
             strcpy(entry->name_short, children_count ? ".." : ".");
+            viso_names_add(&names, entry->name_short);
 
             image_viso_log(viso->tf.log, "[%08X] %s => %s\n", entry,
                            dir->path, entry->name_short);
@@ -998,7 +1118,7 @@ have_eltorito_entry:
                 }
 
                 /* Set short filename. */
-                if (viso_fill_fn_short(entry->name_short, entry, dir_entries)) {
+                if (viso_fill_fn_short(entry->name_short, entry, &names)) {
                     free(entry);
                     children_count--;
                     continue;
@@ -1037,6 +1157,8 @@ next_dir:
     }
     if (dir_entries)
         free(dir_entries);
+    free(names.names);
+    free(names.tails);
 
     /* Write 16 blank sectors. */
     for (int i = 0; i < 16; i++)
@@ -1526,6 +1648,27 @@ next_entry:
     viso->metadata_sectors = ftello64(viso->tf.fp) / viso->sector_size;
     viso->all_sectors      = viso->metadata_sectors;
 
+    /* Metadata is complete except for the file extents and volume size, read
+       it back to memory and fill those in there, which saves a seek and
+       write on the temporary file for every file. */
+    image_viso_log(viso->tf.log, "Reading back %zu %zu-byte sectors of metadata\n",
+                   viso->metadata_sectors, viso->sector_size);
+    viso->metadata = (uint8_t *) calloc(viso->metadata_sectors, viso->sector_size);
+    if (viso->metadata == NULL)
+        goto end;
+    fseeko64(viso->tf.fp, 0, SEEK_SET);
+    size_t metadata_size = viso->metadata_sectors * viso->sector_size;
+    size_t metadata_remain = metadata_size;
+    while (metadata_remain > 0)
+        metadata_remain -= fread(viso->metadata + (metadata_size - metadata_remain), 1, MIN(metadata_remain, viso->sector_size), viso->tf.fp);
+
+    /* We no longer need the temporary file; close and delete it. */
+    fclose(viso->tf.fp);
+    viso->tf.fp = NULL;
+#ifndef ENABLE_IMAGE_VISO_LOG
+    remove(nvr_path(viso->tf.fn));
+#endif
+
     /* Go through files, assigning sectors to them. */
     image_viso_log(viso->tf.log, "Assigning sectors to files:\n");
     size_t        base_factor  = viso->sector_size / orig_sector_size;
@@ -1557,12 +1700,12 @@ next_entry:
                 AS_U16(data[0]) = cpu_to_le16(1);
             }
             AS_U32(data[2]) = cpu_to_le32(viso->all_sectors * base_factor);
-            viso_pwrite(data, eltorito_offset, 6, 1, viso->tf.fp);
+            memcpy(viso->metadata + eltorito_offset, data, 6);
         } else {
             p = data;
             VISO_LBE_32(p, viso->all_sectors * base_factor);
             for (int i = 0; i <= max_vd; i++)
-                viso_pwrite(data, entry->dr_offsets[i] + 2, 8, 1, viso->tf.fp);
+                memcpy(viso->metadata + entry->dr_offsets[i] + 2, data, 8);
         }
 
         /* Save this file's base offset. This overwrites dr_offsets in the union. */
@@ -1589,26 +1732,7 @@ next_entry:
     p = data;
     VISO_LBE_32(p, viso->all_sectors);
     for (int i = 0; i < (sizeof(viso->vol_size_offsets) / sizeof(viso->vol_size_offsets[0])); i++)
-        viso_pwrite(data, viso->vol_size_offsets[i], 8, 1, viso->tf.fp);
-
-    /* Metadata processing is finished, read it back to memory. */
-    image_viso_log(viso->tf.log, "Reading back %zu %zu-byte sectors of metadata\n",
-                   viso->metadata_sectors, viso->sector_size);
-    viso->metadata = (uint8_t *) calloc(viso->metadata_sectors, viso->sector_size);
-    if (viso->metadata == NULL)
-        goto end;
-    fseeko64(viso->tf.fp, 0, SEEK_SET);
-    size_t metadata_size = viso->metadata_sectors * viso->sector_size;
-    size_t metadata_remain = metadata_size;
-    while (metadata_remain > 0)
-        metadata_remain -= fread(viso->metadata + (metadata_size - metadata_remain), 1, MIN(metadata_remain, viso->sector_size), viso->tf.fp);
-
-    /* We no longer need the temporary file; close and delete it. */
-    fclose(viso->tf.fp);
-    viso->tf.fp = NULL;
-#ifndef ENABLE_IMAGE_VISO_LOG
-    remove(nvr_path(viso->tf.fn));
-#endif
+        memcpy(viso->metadata + viso->vol_size_offsets[i], data, 8);
 
     /* All good. */
     *error = 0;
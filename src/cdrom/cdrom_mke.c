@@ -116,6 +116,7 @@ typedef struct mke_t {
     uint8_t    cdbuffer[624240 * 2];
 
     uint32_t   data_to_push;
+    uint8_t    data_in_fifo;
 
     pc_timer_t timer;
 
@@ -516,7 +517,11 @@ mke_command_callback(void *priv)
             break;
         }
         case CMD1_READ: {
-            fifo8_push_all(&mke->data_fifo, mke->cdbuffer, mke->data_to_push);
+            if (!mke->data_in_fifo)
+                fifo8_push_all(&mke->data_fifo, mke->cdbuffer, mke->data_to_push);
+            else if (fifo8_is_empty(&mke->data_fifo))
+                fifo8_commit(&mke->data_fifo, mke->data_to_push);
+            mke->data_in_fifo = 0;
             fifo8_push(&mke->info_fifo, mke_cdrom_status(mke->cdrom_dev, mke));
             mke->data_to_push = 0;
             ui_sb_update_icon(SB_CDROM | mke->cdrom_dev->id, 0);
@@ -577,6 +582,7 @@ mke_command(mke_t *mke, uint8_t value)
             case CMD1_READ: {
                 uint32_t count = mke->command_buffer[6];
                 uint8_t *buf   = mke->cdbuffer;
+                uint32_t avail = 0;
                 int      res   = 0;
                 uint64_t lba   = MSFtoLBA(mke->command_buffer[1], mke->command_buffer[2],
                                           mke->command_buffer[3]) - 150;
@@ -585,6 +591,17 @@ mke_command(mke_t *mke, uint8_t value)
                 CHECK_READY_READ();
                 mke->data_to_push = 0;
 
+                /* With the data FIFO drained, read straight into its storage;
+                   the sectors only show up once the callback commits them. */
+                mke->data_in_fifo = 0;
+                if (fifo8_is_empty(&mke->data_fifo)) {
+                    fifo8_reset(&mke->data_fifo);
+                    buf = fifo8_reserve_span(&mke->data_fifo, count * mke->cdrom_dev->sector_size, &avail);
+                    mke->data_in_fifo = (avail == (count * mke->cdrom_dev->sector_size));
+                    if (!mke->data_in_fifo)
+                        buf = mke->cdbuffer;
+                }
+
                 while (count) {
                     if ((res = cdrom_readsector_raw(mke->cdrom_dev, buf, lba, 0,
                                                     mke->sector_type, mke->sector_flags, &len, 0)) > 0) {
@@ -601,6 +618,7 @@ mke_command(mke_t *mke, uint8_t value)
                 if (count != 0) {
                     fifo8_reset(&mke->data_fifo);
                     mke->data_to_push = 0;
+                    mke->data_in_fifo = 0;
                 } else {
                     ui_sb_update_icon(SB_CDROM | mke->cdrom_dev->id, 1);
                     timer_on_auto(&mke->timer, (1000000.0 / (176400.0 * 2.)) * mke->data_to_push);
@@ -1639,6 +1639,7 @@ ali1543_init(const device_t *info)
 
     /* USB */
     dev->usb = device_add(&usb_device);
+    usb_set_slot(dev->usb, dev->usb_slot, PCI_INTA);
 
     dev->type   = info->local & 0xff;
     dev->offset = (info->local >> 8) & 0x7f;
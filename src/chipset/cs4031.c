@@ -56,6 +56,8 @@ cs4031_log(const char *fmt, ...)
 static void
 cs4031_shadow_recalc(cs4031_t *dev)
 {
+    mem_mapping_batch_begin();
+
     mem_set_mem_state_both(0xa0000, 0x10000, (dev->regs[0x18] & 0x01) ? (MEM_READ_INTERNAL | MEM_WRITE_INTERNAL) : (MEM_READ_EXTANY | MEM_WRITE_EXTANY));
     mem_set_mem_state_both(0xb0000, 0x10000, (dev->regs[0x18] & 0x02) ? (MEM_READ_INTERNAL | MEM_WRITE_INTERNAL) : (MEM_READ_EXTANY | MEM_WRITE_EXTANY));
 
@@ -65,6 +67,9 @@ cs4031_shadow_recalc(cs4031_t *dev)
         else
             mem_set_mem_state_both(0xd0000 + ((i - 4) << 16), 0x10000, ((dev->regs[0x19] & (1 << i)) ? MEM_READ_INTERNAL : MEM_READ_EXTANY) | ((dev->regs[0x1a] & (1 << i)) ? MEM_WRITE_INTERNAL : MEM_WRITE_EXTANY));
     }
+
+    mem_mapping_batch_commit();
+
     shadowbios       = !!(dev->regs[0x19] & 0x40);
     shadowbios_write = !!(dev->regs[0x1a] & 0x40);
 }
@@ -1576,8 +1576,10 @@ piix_init(const device_t *info)
     else
         sff_set_irq_mode(dev->bm[1], IRQ_MODE_MIRQ_0);
 
-    if (dev->type >= 3)
+    if (dev->type >= 3) {
         dev->usb   = device_add(&usb_device);
+        usb_set_slot(dev->usb, dev->pci_slot, PCI_INTD);
+    }
 
     if (dev->type > 3) {
         dev->nvr   = device_add(&piix4_nvr_device);
@@ -410,6 +410,8 @@ recalc_mappings(void *priv)
     int      bank_nr    = 0;
     int      phys_bank;
 
+    mem_mapping_batch_begin();
+
     mem_set_mem_state_both((1 << 20), (16256 - 1024) * 1024, MEM_READ_EXTERNAL | MEM_WRITE_EXTERNAL);
     mem_set_mem_state(0xfe0000, 0x20000, MEM_READ_EXTANY | MEM_WRITE_EXTANY);
 
@@ -640,6 +642,8 @@ recalc_mappings(void *priv)
             }
         }
     }
+
+    mem_mapping_batch_commit();
 }
 
 static void
@@ -148,6 +148,7 @@ sis_5511_init(UNUSED(const device_t *info))
     pci_add_card(PCI_ADD_SOUTHBRIDGE, sis_5513_read, sis_5513_write, dev, &dev->sb_slot);
 
     dev->sis = device_add(&sis_55xx_common_device);
+    dev->sis->sb_pci_slot = dev->sb_slot;
 
     dev->h2p = device_add_linked(&sis_5511_h2p_device, dev->sis);
 
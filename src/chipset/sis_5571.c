@@ -161,6 +161,7 @@ sis_5571_init(UNUSED(const device_t *info))
     pci_add_card(PCI_ADD_SOUTHBRIDGE, sis_5572_read, sis_5572_write, dev, &dev->sb_slot);
 
     dev->sis = device_add(&sis_55xx_common_device);
+    dev->sis->sb_pci_slot = dev->sb_slot;
 
     dev->h2p = device_add_linked(&sis_5571_h2p_device, dev->sis);
     dev->p2i = device_add_linked(&sis_5572_p2i_device, dev->sis);
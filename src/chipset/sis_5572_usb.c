@@ -274,6 +274,7 @@ sis_5572_usb_init(UNUSED(const device_t *info))
 
     /* USB */
     dev->usb = device_add(&usb_device);
+    usb_set_slot(dev->usb, dev->sis->sb_pci_slot, PCI_INTA);
 
     sis_5572_usb_reset(dev);
 
@@ -166,6 +166,7 @@ sis_5591_init(UNUSED(const device_t *info))
     pci_add_card(PCI_ADD_SOUTHBRIDGE, sis_5595_read, sis_5595_write, dev, &dev->sb_slot);
 
     dev->sis = device_add(&sis_55xx_common_device);
+    dev->sis->sb_pci_slot = dev->sb_slot;
 
     dev->ide = device_add_linked(&sis_5591_5600_ide_device, dev->sis);
     if (info->local)
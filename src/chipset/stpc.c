@@ -923,6 +923,7 @@ stpc_init(const device_t *info)
 
         dev->usb = device_add(&usb_device);
         pci_add_card(PCI_ADD_SOUTHBRIDGE_USB, stpc_usb_read, stpc_usb_write, dev, &dev->usb_slot);
+        usb_set_slot(dev->usb, dev->usb_slot, PCI_INTA);
     }
 
     dev->bm[0] = device_add_inst(&sff8038i_device, 1);
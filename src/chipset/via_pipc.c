@@ -1733,8 +1733,10 @@ pipc_init(const device_t *info)
     }
 
     dev->usb[0] = device_add_inst(&usb_device, 1);
+    usb_set_slot(dev->usb[0], dev->pci_slot, PCI_INTD);
     if (dev->local >= VIA_PIPC_686A) {
         dev->usb[1] = device_add_inst(&usb_device, 2);
+        usb_set_slot(dev->usb[1], dev->pci_slot, PCI_INTD);
 
         dev->ac97 = device_add(&ac97_via_device);
 
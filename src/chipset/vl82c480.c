@@ -69,6 +69,8 @@ vl82c480_recalc_shadow(vl82c480_t *dev)
     shadowbios       = 0;
     shadowbios_write = 0;
 
+    mem_mapping_batch_begin();
+
     for (uint8_t i = 0; i < 6; i++) {
         for (uint8_t j = 0; j < 8; j += 2) {
             base    = 0x000a0000 + (i << 16) + (j << 13);
@@ -79,7 +81,7 @@ vl82c480_recalc_shadow(vl82c480_t *dev)
         }
     }
 
-    flushmmucache();
+    mem_mapping_batch_commit();
 }
 
 static void
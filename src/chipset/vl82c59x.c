@@ -116,6 +116,8 @@ vl82c59x_recalc(vl82c59x_t *dev)
     shadowbios       = 0;
     shadowbios_write = 0;
 
+    mem_mapping_batch_begin();
+
     for (uint8_t i = 0; i < 4; i++) {
         for (uint8_t j = 0; j < 8; j += 2) {
             base   = 0x000c0000 + (i << 16) + (j << 13);
@@ -126,7 +128,7 @@ vl82c59x_recalc(vl82c59x_t *dev)
         }
     }
 
-    flushmmucache();
+    mem_mapping_batch_commit();
 }
 
 static void
@@ -1,4 +1,7 @@
+#include <inttypes.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/mem.h>
@@ -6,6 +9,7 @@
 
 #include "x86_ops.h"
 #include "codegen.h"
+#include "codegen_public.h"
 #include "x86.h"
 #include "x86seg_common.h"
 #include "x86seg.h"
@@ -57,6 +61,11 @@ int has_ea;
 
 codeblock_t *codeblock;
 uint16_t    *codeblock_hash;
+uint16_t    *codeblock_hash_l2;
+
+codegen_stats_t        codegen_stats;
+static codegen_stats_t codegen_stats_old;
+uint64_t               codegen_fallbacks[CODEGEN_FALLBACK_NR];
 
 void (*codegen_timing_start)(void);
 void (*codegen_timing_prefix)(uint8_t prefix, uint32_t fetchdat);
@@ -703,6 +712,16 @@ codegen_skip:
         recomp_op_table = recomp_opcodes;
     }
 
+    if (pc_off) /*x87 escape, opcode is the ModR/M byte*/
+        codegen_fallbacks[CODEGEN_FALLBACK_X87 | ((op87 >> 5) & 0x38) | ((opcode >> 3) & 7) | ((opcode >= 0xc0) ? CODEGEN_FALLBACK_X87_REG : 0)]++;
+    else if (op_table == x86_dynarec_opcodes_3DNOW)
+        codegen_fallbacks[CODEGEN_FALLBACK_3DNOW | opcode]++;
+    else if (op_table == x86_dynarec_opcodes_0f)
+        codegen_fallbacks[CODEGEN_FALLBACK_0F | opcode]++;
+    else
+        codegen_fallbacks[opcode]++;
+    codegen_stats.fallbacks++;
+
     if (in_lock && ((opcode == 0x90) || (opcode == 0xec)))
         /* This is always ILLEGAL. */
         op = x86_dynarec_opcodes_3DNOW[0xff];
@@ -769,3 +788,91 @@ codegen_skip:
         fatal("Has EA\n");
 #endif
 }
+
+void
+codegen_stats_text(char *buf, int len)
+{
+    uint64_t lookups   = codegen_stats.lookup_l1 + codegen_stats.lookup_l2 + codegen_stats.lookup_tree + codegen_stats.lookup_miss -
+                         (codegen_stats_old.lookup_l1 + codegen_stats_old.lookup_l2 + codegen_stats_old.lookup_tree + codegen_stats_old.lookup_miss);
+    uint64_t hash_hits = codegen_stats.lookup_l1 + codegen_stats.lookup_l2 - (codegen_stats_old.lookup_l1 + codegen_stats_old.lookup_l2);
+
+    snprintf(buf, len, "Dynarec: cache %i%%, %" PRIu64 " compiled/s, %" PRIu64 " evicted/s, hash hits %" PRIu64 "%%, "
+                       "%" PRIu64 " SMC/s (%" PRIu64 "/s to byte mask, page %08x)",
+             (int) (((uint64_t) codegen_allocator_usage * 100) / codegen_allocator_size),
+             codegen_stats.recompiles - codegen_stats_old.recompiles,
+             codegen_stats.evictions - codegen_stats_old.evictions,
+             lookups ? ((hash_hits * 100) / lookups) : 0,
+             codegen_stats.smc_invalidations - codegen_stats_old.smc_invalidations,
+             codegen_stats.smc_byte_mask - codegen_stats_old.smc_byte_mask,
+             codegen_stats.smc_hot_page);
+
+    codegen_stats_old = codegen_stats;
+}
+
+void
+codegen_stats_totals(codegen_totals_t *totals)
+{
+    totals->recompiles        = codegen_stats.recompiles;
+    totals->evictions         = codegen_stats.evictions;
+    totals->uops              = codegen_stats.uops;
+    totals->host_bytes        = codegen_stats.host_bytes;
+    totals->smc_invalidations = codegen_stats.smc_invalidations;
+    totals->flushed           = codegen_stats.flushed;
+    totals->fallbacks         = codegen_stats.fallbacks;
+}
+
+static const char *
+codegen_fallback_name(int index, char *buf, int len)
+{
+    if (index >= CODEGEN_FALLBACK_X87)
+        snprintf(buf, len, "%02X /%i%s", 0xd8 | ((index >> 3) & 7), index & 7,
+                 (index & CODEGEN_FALLBACK_X87_REG) ? " reg" : "");
+    else if (index >= CODEGEN_FALLBACK_3DNOW)
+        snprintf(buf, len, "0F 0F %02X", index & 0xff);
+    else if (index >= CODEGEN_FALLBACK_0F)
+        snprintf(buf, len, "0F %02X", index & 0xff);
+    else
+        snprintf(buf, len, "%02X", index);
+
+    return buf;
+}
+
+/*Log the totals since startup, with the opcodes most often left to the
+  interpreter*/
+void
+codegen_stats_dump(void)
+{
+    uint64_t counts[CODEGEN_FALLBACK_NR];
+    char     name[16];
+    uint64_t blocks = codegen_stats.recompiles ? codegen_stats.recompiles : 1;
+
+    if (!codegen_stats.recompiles)
+        return;
+
+    always_log("Dynarec: %" PRIu64 " blocks compiled, %" PRIu64 " uOPs (%" PRIu64 " per block), "
+               "%" PRIu64 " host bytes (%" PRIu64 " per block)\n",
+               codegen_stats.recompiles, codegen_stats.uops, codegen_stats.uops / blocks,
+               codegen_stats.host_bytes, codegen_stats.host_bytes / blocks);
+    always_log("Dynarec: blocks thrown out: %" PRIu64 " by code writes, %" PRIu64 " evicted, "
+               "%" PRIu64 " in %" PRIu64 " cache resets, %" PRIu64 " abandoned while compiling\n",
+               codegen_stats.smc_invalidations, codegen_stats.evictions, codegen_stats.flushed,
+               codegen_stats.flushes, codegen_stats.aborts);
+    always_log("Dynarec: %" PRIu64 " instructions compiled as interpreter calls, %" PRIu64 " uOPs folded, "
+               "%" PRIu64 " removed, %" PRIu64 " register spills\n",
+               codegen_stats.fallbacks, codegen_stats.ir_folded, codegen_stats.ir_dead, codegen_stats.reg_spills);
+
+    memcpy(counts, codegen_fallbacks, sizeof(counts));
+    for (int c = 0; c < 20; c++) {
+        int best = 0;
+
+        for (int d = 1; d < CODEGEN_FALLBACK_NR; d++) {
+            if (counts[d] > counts[best])
+                best = d;
+        }
+        if (!counts[best])
+            break;
+
+        always_log("Dynarec:   %-10s %12" PRIu64 "\n", codegen_fallback_name(best, name, sizeof(name)), counts[best]);
+        counts[best] = 0;
+    }
+}
@@ -28,6 +28,22 @@
   The 64 byte granularity appears to work reasonably well for most cases,
   avoiding most unnecessary evictions (eg when code & data are stored in the
   same page).
+
+  Translations only live for the duration of a run. The generated host code
+  embeds absolute host addresses (cpu_state, helper functions, memory
+  lookup tables and the code cache itself, which move between runs with
+  ASLR), and a block is only compiled on its second execution, with the
+  first, interpreted, pass building the code present masks and page lists
+  the compiled block relies on. Neither the host code nor the IR can
+  therefore be saved and reloaded against guest memory in a later run.
+
+  Blocks are already traces: unconditional jumps are followed during
+  recompilation, and conditional jumps become side exits with compilation
+  continuing on the fall-through path. A block covers at most the code from
+  its start to start + 0x400 (0x40 for byte masked blocks), which is what
+  limits it to two physical pages - one code present mask and dirty mask pair
+  per page. Joining blocks from unrelated pages would need a variable number
+  of those pairs per block, checked on every entry.
 */
 
 typedef struct codeblock_t {
@@ -62,6 +78,60 @@ typedef struct codeblock_t {
 extern codeblock_t *codeblock;
 
 extern uint16_t *codeblock_hash;
+/*Victim cache for codeblock_hash. Blocks displaced from the first level hash
+  move here, so that two hot blocks colliding in the first level do not have to
+  go through the page tree on every lookup.*/
+extern uint16_t *codeblock_hash_l2;
+
+typedef struct codegen_stats_t {
+    /*Block lookups, by the level that found the block*/
+    uint64_t lookup_l1;
+    uint64_t lookup_l2;
+    uint64_t lookup_tree;
+    uint64_t lookup_miss;
+    /*Blocks dispatched directly after the previous one, without going back
+      through the main CPU loop*/
+    uint64_t chained;
+    /*Blocks compiled, and blocks thrown out to make room for new ones*/
+    uint64_t recompiles;
+    uint64_t evictions;
+    /*uOPs folded into constants, and uOPs removed as their result is unused*/
+    uint64_t ir_folded;
+    uint64_t ir_dead;
+    /*Host registers evicted while their contents were still to be read*/
+    uint64_t reg_spills;
+    /*Blocks thrown out by writes to their code, and blocks moved to byte
+      granular dirty tracking because of that*/
+    uint64_t smc_invalidations;
+    uint64_t smc_byte_mask;
+    /*Page with the most blocks thrown out by writes*/
+    uint32_t smc_hot_page;
+    uint32_t smc_hot_page_count;
+    /*uOPs in compiled blocks after unrolling, and host code bytes emitted*/
+    uint64_t uops;
+    uint64_t host_bytes;
+    /*Instructions compiled as calls to their interpreter handler*/
+    uint64_t fallbacks;
+    /*Full cache resets, the blocks thrown out by them, and blocks abandoned
+      part way through compilation*/
+    uint64_t flushes;
+    uint64_t flushed;
+    uint64_t aborts;
+} codegen_stats_t;
+
+extern codegen_stats_t codegen_stats;
+
+/*Instructions compiled as interpreter calls, by opcode. One byte opcodes come
+  first, then 0F xx, then 3DNow! 0F 0F xx, then x87 escapes indexed by
+  (escape & 7) * 8 + ModR/M reg, with CODEGEN_FALLBACK_X87_REG set for the
+  register forms*/
+#define CODEGEN_FALLBACK_0F      0x100
+#define CODEGEN_FALLBACK_3DNOW   0x200
+#define CODEGEN_FALLBACK_X87     0x300
+#define CODEGEN_FALLBACK_X87_REG 0x040
+#define CODEGEN_FALLBACK_NR      0x380
+
+extern uint64_t codegen_fallbacks[CODEGEN_FALLBACK_NR];
 
 extern uint8_t *block_write_data;
 
@@ -81,6 +151,8 @@ extern uint8_t *block_write_data;
 #define CODEBLOCK_IN_DIRTY_LIST 0x40
 /*Code block is not inlining immediate parameters, parameters must be fetched from memory*/
 #define CODEBLOCK_NO_IMMEDIATES 0x80
+/*Code block has run since the eviction clock hand last passed it*/
+#define CODEBLOCK_REFERENCED 0x100
 
 #define BLOCK_PC_INVALID        0xffffffff
 
@@ -311,7 +383,10 @@ extern void codegen_check_regs(void);
 extern int codegen_purge_purgable_list(void);
 /*Delete a random code block to free memory. This is obviously quite expensive, and
   will only be called when the allocator is out of memory*/
-extern void codegen_delete_random_block(int required_mem_block);
+/*Evict a code block, other than keep_block and the block being compiled, to
+  make room. If required_mem_block is set then only blocks holding code memory
+  are considered.*/
+extern void codegen_evict_block(int required_mem_block, int keep_block);
 
 extern int      cpu_block_end;
 extern uint32_t codegen_endpc;
@@ -328,6 +403,11 @@ extern void (*codegen_timing_block_start)(void);
 extern void (*codegen_timing_block_end)(void);
 extern int (*codegen_timing_jump_cycles)(void);
 
+/*The timing models are only run while a block is being recompiled, once per
+  instruction, and the result is baked into the block as a cycle count; they
+  are not called when a block executes, nor by the interpreter, which charges
+  cycles from within each opcode handler. The models already look timings up
+  in per-opcode tables, with only the prefix/group selection done by switch.*/
 typedef struct codegen_timing_t {
     void (*start)(void);
     void (*prefix)(uint8_t prefix, uint32_t fetchdat);
@@ -25,21 +25,39 @@ typedef struct mem_block_t {
     uint16_t code_block;
 } mem_block_t;
 
-static mem_block_t mem_blocks[MEM_BLOCK_NR];
-static uint32_t    mem_block_free_list;
-static uint8_t    *mem_block_alloc = NULL;
+static mem_block_t *mem_blocks = NULL;
+static uint32_t     mem_block_free_list;
+static uint8_t     *mem_block_alloc = NULL;
 
-int codegen_allocator_usage = 0;
+int      codegen_allocator_usage = 0;
+uint32_t codegen_allocator_size  = MEM_BLOCK_NR;
 
 void
 codegen_allocator_init(void)
 {
-    mem_block_alloc = plat_mmap(MEM_BLOCK_NR * MEM_BLOCK_SIZE, 1);
+    uint32_t nr = MEM_BLOCK_NR;
+
+    if (dynarec_cache_size > 0) {
+        nr = (uint32_t) (((uint64_t) dynarec_cache_size << 20) / MEM_BLOCK_SIZE);
+        if (nr < MEM_BLOCK_NR_MIN)
+            nr = MEM_BLOCK_NR_MIN;
+        else if (nr > MEM_BLOCK_NR_MAX)
+            nr = MEM_BLOCK_NR_MAX;
+    }
+    codegen_allocator_size = nr;
+
+    mem_blocks      = malloc(nr * sizeof(mem_block_t));
+    if (mem_huge_pages)
+        mem_block_alloc = plat_mmap_large((size_t) nr * MEM_BLOCK_SIZE, 1, "Code cache");
+    else
+        mem_block_alloc = plat_mmap((size_t) nr * MEM_BLOCK_SIZE, 1);
+    if ((mem_blocks == NULL) || (mem_block_alloc == NULL))
+        fatal("codegen_allocator_init: unable to allocate %u kB of code cache\n", (nr * MEM_BLOCK_SIZE) >> 10);
 
-    for (uint32_t c = 0; c < MEM_BLOCK_NR; c++) {
+    for (uint32_t c = 0; c < nr; c++) {
         mem_blocks[c].offset     = c * MEM_BLOCK_SIZE;
         mem_blocks[c].code_block = BLOCK_INVALID;
-        if (c < MEM_BLOCK_NR - 1)
+        if (c < nr - 1)
             mem_blocks[c].next = c + 2;
         else
             mem_blocks[c].next = 0;
@@ -54,12 +72,8 @@ codegen_allocator_allocate(mem_block_t *parent, int code_block)
     uint32_t     block_nr;
 
     while (!mem_block_free_list) {
-        /*Pick a random memory block and free the owning code block*/
-        block_nr = rand() & MEM_BLOCK_MASK;
-        block    = &mem_blocks[block_nr];
-
-        if (block->code_block && block->code_block != code_block)
-            codegen_delete_block(&codeblock[block->code_block]);
+        /*Free the memory of the least recently run code block*/
+        codegen_evict_block(1, code_block);
     }
 
     /*Remove from free list*/
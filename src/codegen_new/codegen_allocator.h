@@ -12,12 +12,28 @@
 
   Due to the chaining, the total memory size is limited by the range of a jump
   instruction. ARMv8 is limited to +/- 128 MB, x86 to
-  +/- 2GB. It was 32 MB on ARMv7 before we removed it*/
+  +/- 2GB. It was 32 MB on ARMv7 before we removed it
 
-#define MEM_BLOCK_NR 131072
+  The number of blocks defaults to MEM_BLOCK_NR, and can be changed with the
+  dynarec_cache_size machine option (in MB) within the limits below.
+
+  The memory is a single mapping, written and executed at the same address.
+  On macOS arm64 it is MAP_JIT and the recompiler flips it between writable
+  and executable with pthread_jit_write_protect_np(), which is a per-thread
+  register write and not a protection change. Elsewhere it is mapped RWX once
+  (PROT_MPROTECT hosts mprotect() it once at allocation). A separate RW alias
+  would need every code address captured while writing (block->data, branch
+  targets, the jump tables and helper routine pointers) translated to the RX
+  view, so it is not done.*/
 
+#define MEM_BLOCK_NR 131072
+#define MEM_BLOCK_NR_MIN (MEM_BLOCK_NR / 8)
+#if defined __aarch64__ || defined _M_ARM64
+#    define MEM_BLOCK_NR_MAX MEM_BLOCK_NR
+#else
+#    define MEM_BLOCK_NR_MAX (MEM_BLOCK_NR * 8)
+#endif
 
-#define MEM_BLOCK_MASK (MEM_BLOCK_NR - 1)
 #define MEM_BLOCK_SIZE 0x3c0
 
 void codegen_allocator_init(void);
@@ -32,6 +48,7 @@ uint8_t *codeblock_allocator_get_ptr(struct mem_block_t *block);
 /*Cache clean memory block list*/
 void codegen_allocator_clean_blocks(struct mem_block_t *block);
 
-extern int codegen_allocator_usage;
+extern int      codegen_allocator_usage;
+extern uint32_t codegen_allocator_size;
 
 #endif
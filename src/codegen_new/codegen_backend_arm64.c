@@ -287,9 +287,11 @@ codegen_backend_init(void)
 
     codeblock      = malloc(BLOCK_SIZE * sizeof(codeblock_t));
     codeblock_hash = malloc(HASH_SIZE * sizeof(codeblock_t *));
+    codeblock_hash_l2 = malloc(HASH_SIZE * sizeof(uint16_t));
 
     memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
     memset(codeblock_hash, 0, HASH_SIZE * sizeof(codeblock_t *));
+    memset(codeblock_hash_l2, 0, HASH_SIZE * sizeof(uint16_t));
 
     for (int c = 0; c < BLOCK_SIZE; c++) {
         codeblock[c].pc = BLOCK_PC_INVALID;
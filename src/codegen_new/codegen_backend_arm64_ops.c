@@ -306,6 +306,7 @@ codegen_allocate_new_block(codeblock_t *block)
     *(uint32_t *) &block_write_data[block_pos] = OPCODE_B | OFFSET26(offset);
 
     /*Set write address to start of new block*/
+    codegen_stats.host_bytes += block_pos + 4;
     block_pos        = 0;
     block_write_data = new_ptr;
 }
@@ -452,6 +453,13 @@ host_arm64_B(codeblock_t *block, void *dest)
         fatal("host_arm64_B - offset out of range %x\n", offset);
     codegen_addlong(block, OPCODE_B | OFFSET26(offset));
 }
+uint32_t *
+host_arm64_B_(codeblock_t *block)
+{
+    codegen_alloc(block, 4);
+    codegen_addlong(block, OPCODE_B);
+    return (uint32_t *) &block_write_data[block_pos - 4];
+}
 
 void
 host_arm64_BFI(codeblock_t *block, int dst_reg, int src_reg, int lsb, int width)
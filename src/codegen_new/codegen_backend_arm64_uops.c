@@ -893,6 +893,85 @@ codegen_LOAD_SEG(codeblock_t *block, uop_t *uop)
     return 0;
 }
 
+/*The TLB hit path of a memory access is emitted inline. Misses and misaligned
+  accesses call the load or store routine, which looks the page up again and
+  falls back to the memory access functions*/
+static void
+codegen_mem_load_fast(codeblock_t *block, void *rout, int size, int is_float)
+{
+    uint32_t *miss_offset;
+    uint32_t *misaligned_offset = NULL;
+    uint32_t *done_offset;
+
+    /*In - W0 = address
+      Out - W0 = data (V_TEMP for 64-bit and floating point loads)
+      Corrupts X1, X2*/
+    host_arm64_MOV_REG_LSR(block, REG_W1, REG_W0, 12);
+    host_arm64_MOVX_IMM(block, REG_X2, (uint64_t) readlookup2);
+    host_arm64_LDRX_REG_LSL3(block, REG_X1, REG_X2, REG_X1);
+    if (size != 1) {
+        host_arm64_TST_IMM(block, REG_W0, size - 1);
+        misaligned_offset = host_arm64_BNE_(block);
+    }
+    host_arm64_CMPX_IMM(block, REG_X1, -1);
+    miss_offset = host_arm64_BEQ_(block);
+    if (size == 1 && !is_float)
+        host_arm64_LDRB_REG(block, REG_W0, REG_W1, REG_W0);
+    else if (size == 2 && !is_float)
+        host_arm64_LDRH_REG(block, REG_W0, REG_W1, REG_W0);
+    else if (size == 4 && !is_float)
+        host_arm64_LDR_REG(block, REG_W0, REG_W1, REG_W0);
+    else if (size == 4 && is_float)
+        host_arm64_LDR_REG_F32(block, REG_V_TEMP, REG_W1, REG_W0);
+    else
+        host_arm64_LDR_REG_F64(block, REG_V_TEMP, REG_W1, REG_W0);
+    done_offset = host_arm64_B_(block);
+
+    host_arm64_branch_set_offset(miss_offset, &block_write_data[block_pos]);
+    if (size != 1)
+        host_arm64_branch_set_offset(misaligned_offset, &block_write_data[block_pos]);
+    host_arm64_call(block, rout);
+    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    host_arm64_branch_set_offset(done_offset, &block_write_data[block_pos]);
+}
+static void
+codegen_mem_store_fast(codeblock_t *block, void *rout, int size, int is_float)
+{
+    uint32_t *miss_offset;
+    uint32_t *misaligned_offset = NULL;
+    uint32_t *done_offset;
+
+    /*In - W0 = address, W1 = data (V_TEMP for 64-bit and floating point stores)
+      Corrupts X1, X2, X3*/
+    host_arm64_MOV_REG_LSR(block, REG_W2, REG_W0, 12);
+    host_arm64_MOVX_IMM(block, REG_X3, (uint64_t) writelookup2);
+    host_arm64_LDRX_REG_LSL3(block, REG_X2, REG_X3, REG_X2);
+    if (size != 1) {
+        host_arm64_TST_IMM(block, REG_W0, size - 1);
+        misaligned_offset = host_arm64_BNE_(block);
+    }
+    host_arm64_CMPX_IMM(block, REG_X2, -1);
+    miss_offset = host_arm64_BEQ_(block);
+    if (size == 1 && !is_float)
+        host_arm64_STRB_REG(block, REG_X1, REG_X2, REG_X0);
+    else if (size == 2 && !is_float)
+        host_arm64_STRH_REG(block, REG_X1, REG_X2, REG_X0);
+    else if (size == 4 && !is_float)
+        host_arm64_STR_REG(block, REG_X1, REG_X2, REG_X0);
+    else if (size == 4 && is_float)
+        host_arm64_STR_REG_F32(block, REG_V_TEMP, REG_X2, REG_X0);
+    else
+        host_arm64_STR_REG_F64(block, REG_V_TEMP, REG_X2, REG_X0);
+    done_offset = host_arm64_B_(block);
+
+    host_arm64_branch_set_offset(miss_offset, &block_write_data[block_pos]);
+    if (size != 1)
+        host_arm64_branch_set_offset(misaligned_offset, &block_write_data[block_pos]);
+    host_arm64_call(block, rout);
+    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    host_arm64_branch_set_offset(done_offset, &block_write_data[block_pos]);
+}
+
 static int
 codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 {
@@ -902,14 +981,13 @@ codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_IMM(block, REG_X0, seg_reg, uop->imm_data);
     if (REG_IS_B(dest_size) || REG_IS_BH(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_byte);
+        codegen_mem_load_fast(block, codegen_mem_load_byte, 1, 0);
     } else if (REG_IS_W(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_word);
+        codegen_mem_load_fast(block, codegen_mem_load_word, 2, 0);
     } else if (REG_IS_L(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_long);
+        codegen_mem_load_fast(block, codegen_mem_load_long, 4, 0);
     } else
         fatal("MEM_LOAD_ABS - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_arm64_BFI(block, dest_reg, REG_X0, 0, 8);
     } else if (REG_IS_BH(dest_size)) {
@@ -936,16 +1014,15 @@ codegen_MEM_LOAD_REG(codeblock_t *block, uop_t *uop)
     if (uop->is_a16)
         host_arm64_AND_IMM(block, REG_X0, REG_X0, 0xffff);
     if (REG_IS_B(dest_size) || REG_IS_BH(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_byte);
+        codegen_mem_load_fast(block, codegen_mem_load_byte, 1, 0);
     } else if (REG_IS_W(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_word);
+        codegen_mem_load_fast(block, codegen_mem_load_word, 2, 0);
     } else if (REG_IS_L(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_long);
+        codegen_mem_load_fast(block, codegen_mem_load_long, 4, 0);
     } else if (REG_IS_Q(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_quad);
+        codegen_mem_load_fast(block, codegen_mem_load_quad, 8, 0);
     } else
         fatal("MEM_LOAD_REG - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_arm64_BFI(block, dest_reg, REG_X0, 0, 8);
     } else if (REG_IS_BH(dest_size)) {
@@ -974,8 +1051,7 @@ codegen_MEM_LOAD_DOUBLE(codeblock_t *block, uop_t *uop)
     host_arm64_ADD_REG(block, REG_X0, seg_reg, addr_reg, 0);
     if (uop->imm_data)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
-    host_arm64_call(block, codegen_mem_load_double);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_load_fast(block, codegen_mem_load_double, 8, 1);
     host_arm64_FMOV_D_D(block, dest_reg, REG_V_TEMP);
 
     return 0;
@@ -994,8 +1070,7 @@ codegen_MEM_LOAD_SINGLE(codeblock_t *block, uop_t *uop)
     host_arm64_ADD_REG(block, REG_X0, seg_reg, addr_reg, 0);
     if (uop->imm_data)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
-    host_arm64_call(block, codegen_mem_load_single);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_load_fast(block, codegen_mem_load_single, 4, 1);
     host_arm64_FCVT_D_S(block, dest_reg, REG_V_TEMP);
 
     return 0;
@@ -1011,19 +1086,18 @@ codegen_MEM_STORE_ABS(codeblock_t *block, uop_t *uop)
     host_arm64_ADD_IMM(block, REG_W0, seg_reg, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xff);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_store_fast(block, codegen_mem_store_byte, 1, 0);
     } else if (REG_IS_BH(src_size)) {
         host_arm64_UBFX(block, REG_W1, src_reg, 8, 8);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_store_fast(block, codegen_mem_store_byte, 1, 0);
     } else if (REG_IS_W(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xffff);
-        host_arm64_call(block, codegen_mem_store_word);
+        codegen_mem_store_fast(block, codegen_mem_store_word, 2, 0);
     } else if (REG_IS_L(src_size)) {
         host_arm64_MOV_REG(block, REG_W1, src_reg, 0);
-        host_arm64_call(block, codegen_mem_store_long);
+        codegen_mem_store_fast(block, codegen_mem_store_long, 4, 0);
     } else
         fatal("MEM_STORE_ABS - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
 
     return 0;
 }
@@ -1040,22 +1114,21 @@ codegen_MEM_STORE_REG(codeblock_t *block, uop_t *uop)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xff);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_store_fast(block, codegen_mem_store_byte, 1, 0);
     } else if (REG_IS_BH(src_size)) {
         host_arm64_UBFX(block, REG_W1, src_reg, 8, 8);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_store_fast(block, codegen_mem_store_byte, 1, 0);
     } else if (REG_IS_W(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xffff);
-        host_arm64_call(block, codegen_mem_store_word);
+        codegen_mem_store_fast(block, codegen_mem_store_word, 2, 0);
     } else if (REG_IS_L(src_size)) {
         host_arm64_MOV_REG(block, REG_W1, src_reg, 0);
-        host_arm64_call(block, codegen_mem_store_long);
+        codegen_mem_store_fast(block, codegen_mem_store_long, 4, 0);
     } else if (REG_IS_Q(src_size)) {
         host_arm64_FMOV_D_D(block, REG_V_TEMP, src_reg);
-        host_arm64_call(block, codegen_mem_store_quad);
+        codegen_mem_store_fast(block, codegen_mem_store_quad, 8, 0);
     } else
         fatal("MEM_STORE_REG - %02x\n", uop->src_reg_c_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
 
     return 0;
 }
@@ -1068,8 +1141,7 @@ codegen_MEM_STORE_IMM_8(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_byte);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_byte, 1, 0);
 
     return 0;
 }
@@ -1081,8 +1153,7 @@ codegen_MEM_STORE_IMM_16(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_word);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_word, 2, 0);
 
     return 0;
 }
@@ -1094,8 +1165,7 @@ codegen_MEM_STORE_IMM_32(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_long);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_long, 4, 0);
 
     return 0;
 }
@@ -1115,8 +1185,7 @@ codegen_MEM_STORE_SINGLE(codeblock_t *block, uop_t *uop)
     if (uop->imm_data)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
     host_arm64_FCVT_S_D(block, REG_V_TEMP, src_reg);
-    host_arm64_call(block, codegen_mem_store_single);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_single, 4, 1);
 
     return 0;
 }
@@ -1135,8 +1204,7 @@ codegen_MEM_STORE_DOUBLE(codeblock_t *block, uop_t *uop)
     if (uop->imm_data)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
     host_arm64_FMOV_D_D(block, REG_V_TEMP, src_reg);
-    host_arm64_call(block, codegen_mem_store_double);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_double, 8, 1);
 
     return 0;
 }
@@ -1335,6 +1403,8 @@ codegen_MOV_REG_PTR(codeblock_t *block, uop_t *uop)
     host_arm64_MOVX_IMM(block, REG_TEMP, (uint64_t) uop->p);
     if (REG_IS_L(dest_size)) {
         host_arm64_LDR_IMM_W(block, dest_reg, REG_TEMP, 0);
+    } else if (REG_IS_D(dest_size)) {
+        host_arm64_LDR_IMM_F64(block, dest_reg, REG_TEMP, 0);
     } else
         fatal("MOV_REG_PTR %02x\n", uop->dest_reg_a_real);
 
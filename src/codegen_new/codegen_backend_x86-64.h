@@ -8,6 +8,9 @@
 #define HASH_MASK   0x1ffff
 
 #define HASH(l)     ((l) &0x1ffff)
+/*Second level hash, blocks that collide in the first level (same low 17 bits)
+  map to different second level entries*/
+#define HASH_L2(l)  ((((l) >> 17) * 0x9e3779b1u ^ (l)) & HASH_MASK)
 
 #define BLOCK_MAX   0x3c0
 
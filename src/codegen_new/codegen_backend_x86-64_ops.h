@@ -45,6 +45,7 @@ uint32_t *host_x86_JB_long(codeblock_t *block);
 uint32_t *host_x86_JBE_long(codeblock_t *block);
 uint32_t *host_x86_JL_long(codeblock_t *block);
 uint32_t *host_x86_JLE_long(codeblock_t *block);
+uint32_t *host_x86_JMP_long(codeblock_t *block);
 uint32_t *host_x86_JO_long(codeblock_t *block);
 uint32_t *host_x86_JS_long(codeblock_t *block);
 uint32_t *host_x86_JZ_long(codeblock_t *block);
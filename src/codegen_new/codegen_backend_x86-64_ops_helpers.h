@@ -91,6 +91,7 @@ codegen_alloc_bytes(codeblock_t *block, int size)
         codegen_addlong(block, (uintptr_t) new_ptr - (uintptr_t) &block_write_data[block_pos + 4]);
 
         /*Set write address to start of new block*/
+        codegen_stats.host_bytes += block_pos;
         block_pos        = 0;
         block_write_data = new_ptr;
     }
@@ -81,14 +81,22 @@ void host_x86_PMULHW_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PMULLW_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 
 void host_x86_PSLLW_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
+void host_x86_PSLLW_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PSLLD_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
+void host_x86_PSLLD_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PSLLQ_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
+void host_x86_PSLLQ_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PSRAW_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
+void host_x86_PSRAW_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PSRAD_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
+void host_x86_PSRAD_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PSRAQ_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
 void host_x86_PSRLW_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
+void host_x86_PSRLW_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PSRLD_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
+void host_x86_PSRLD_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PSRLQ_XREG_IMM(codeblock_t *block, int dst_reg, int shift);
+void host_x86_PSRLQ_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 
 void host_x86_PSUBB_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_PSUBW_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
@@ -963,6 +963,91 @@ codegen_LOAD_SEG(codeblock_t *block, uop_t *uop)
     return 0;
 }
 
+/*The TLB hit path of a memory access is emitted inline. Misses and misaligned
+  accesses call the load or store routine, which looks the page up again and
+  falls back to the memory access functions*/
+static void
+codegen_mem_load_fast(codeblock_t *block, void *rout, int size, int is_float)
+{
+    uint32_t *miss_offset;
+    uint32_t *misaligned_offset = NULL;
+    uint32_t *done_offset;
+
+    /*In - ESI = address
+      Out - ECX = data (XMM_TEMP for 64-bit and floating point loads)
+      Corrupts ESI, EDI*/
+    host_x86_MOV32_REG_REG(block, REG_ECX, REG_ESI);
+    host_x86_SHR32_IMM(block, REG_ESI, 12);
+    host_x86_MOV64_REG_IMM(block, REG_RDI, (uint64_t) (uintptr_t) readlookup2);
+    host_x86_MOV64_REG_BASE_INDEX_SHIFT(block, REG_RSI, REG_RDI, REG_RSI, 3);
+    if (size != 1) {
+        host_x86_TEST32_REG_IMM(block, REG_ECX, size - 1);
+        misaligned_offset = host_x86_JNZ_long(block);
+    }
+    host_x86_CMP64_REG_IMM(block, REG_RSI, (uint32_t) -1);
+    miss_offset = host_x86_JZ_long(block);
+    if (size == 1 && !is_float)
+        host_x86_MOVZX_BASE_INDEX_32_8(block, REG_ECX, REG_RSI, REG_RCX);
+    else if (size == 2 && !is_float)
+        host_x86_MOVZX_BASE_INDEX_32_16(block, REG_ECX, REG_RSI, REG_RCX);
+    else if (size == 4 && !is_float)
+        host_x86_MOV32_REG_BASE_INDEX(block, REG_ECX, REG_RSI, REG_RCX);
+    else if (size == 4 && is_float)
+        host_x86_CVTSS2SD_XREG_BASE_INDEX(block, REG_XMM_TEMP, REG_RSI, REG_RCX);
+    else
+        host_x86_MOVQ_XREG_BASE_INDEX(block, REG_XMM_TEMP, REG_RSI, REG_RCX);
+    done_offset = host_x86_JMP_long(block);
+
+    *miss_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) miss_offset) - 4;
+    if (size != 1)
+        *misaligned_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) misaligned_offset) - 4;
+    host_x86_MOV32_REG_REG(block, REG_ESI, REG_ECX);
+    host_x86_CALL(block, rout);
+    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+    host_x86_JNZ(block, codegen_exit_rout);
+    *done_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) done_offset) - 4;
+}
+static void
+codegen_mem_store_fast(codeblock_t *block, void *rout, int size, int is_float)
+{
+    uint32_t *miss_offset;
+    uint32_t *misaligned_offset = NULL;
+    uint32_t *done_offset;
+
+    /*In - ECX = data (XMM_TEMP for 64-bit and floating point stores), ESI = address
+      Corrupts ESI, EDI, R8*/
+    host_x86_MOV32_REG_REG(block, REG_EDI, REG_ESI);
+    host_x86_SHR32_IMM(block, REG_ESI, 12);
+    host_x86_MOV64_REG_IMM(block, REG_R8, (uint64_t) (uintptr_t) writelookup2);
+    host_x86_MOV64_REG_BASE_INDEX_SHIFT(block, REG_RSI, REG_R8, REG_RSI, 3);
+    if (size != 1) {
+        host_x86_TEST32_REG_IMM(block, REG_EDI, size - 1);
+        misaligned_offset = host_x86_JNZ_long(block);
+    }
+    host_x86_CMP64_REG_IMM(block, REG_RSI, (uint32_t) -1);
+    miss_offset = host_x86_JZ_long(block);
+    if (size == 1 && !is_float)
+        host_x86_MOV8_BASE_INDEX_REG(block, REG_RSI, REG_RDI, REG_ECX);
+    else if (size == 2 && !is_float)
+        host_x86_MOV16_BASE_INDEX_REG(block, REG_RSI, REG_RDI, REG_ECX);
+    else if (size == 4 && !is_float)
+        host_x86_MOV32_BASE_INDEX_REG(block, REG_RSI, REG_RDI, REG_ECX);
+    else if (size == 4 && is_float)
+        host_x86_MOVD_BASE_INDEX_XREG(block, REG_RSI, REG_RDI, REG_XMM_TEMP);
+    else
+        host_x86_MOVQ_BASE_INDEX_XREG(block, REG_RSI, REG_RDI, REG_XMM_TEMP);
+    done_offset = host_x86_JMP_long(block);
+
+    *miss_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) miss_offset) - 4;
+    if (size != 1)
+        *misaligned_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) misaligned_offset) - 4;
+    host_x86_MOV32_REG_REG(block, REG_ESI, REG_EDI);
+    host_x86_CALL(block, rout);
+    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+    host_x86_JNZ(block, codegen_exit_rout);
+    *done_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) done_offset) - 4;
+}
+
 static int
 codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 {
@@ -972,18 +1057,16 @@ codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_IMM(block, REG_ESI, seg_reg, uop->imm_data);
     if (REG_IS_B(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_byte);
+        codegen_mem_load_fast(block, codegen_mem_load_byte, 1, 0);
     } else if (REG_IS_W(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_word);
+        codegen_mem_load_fast(block, codegen_mem_load_word, 2, 0);
     } else if (REG_IS_L(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_long);
+        codegen_mem_load_fast(block, codegen_mem_load_long, 4, 0);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_LOAD_ABS - %02x\n", uop->dest_reg_a_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_x86_MOV8_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_W(dest_size)) {
@@ -1010,20 +1093,18 @@ codegen_MEM_LOAD_REG(codeblock_t *block, uop_t *uop)
         }
     }
     if (REG_IS_B(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_byte);
+        codegen_mem_load_fast(block, codegen_mem_load_byte, 1, 0);
     } else if (REG_IS_W(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_word);
+        codegen_mem_load_fast(block, codegen_mem_load_word, 2, 0);
     } else if (REG_IS_L(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_long);
+        codegen_mem_load_fast(block, codegen_mem_load_long, 4, 0);
     } else if (REG_IS_Q(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_quad);
+        codegen_mem_load_fast(block, codegen_mem_load_quad, 8, 0);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_LOAD_REG - %02x\n", uop->dest_reg_a_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_x86_MOV8_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_W(dest_size)) {
@@ -1051,9 +1132,7 @@ codegen_MEM_LOAD_SINGLE(codeblock_t *block, uop_t *uop)
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     if (uop->imm_data)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_load_single);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_load_fast(block, codegen_mem_load_single, 4, 1);
     host_x86_MOVQ_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
 
     return 0;
@@ -1073,9 +1152,7 @@ codegen_MEM_LOAD_DOUBLE(codeblock_t *block, uop_t *uop)
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     if (uop->imm_data)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_load_double);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_load_fast(block, codegen_mem_load_double, 8, 1);
     host_x86_MOVQ_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
 
     return 0;
@@ -1091,20 +1168,18 @@ codegen_MEM_STORE_ABS(codeblock_t *block, uop_t *uop)
     host_x86_LEA_REG_IMM(block, REG_ESI, seg_reg, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_x86_MOV8_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_byte);
+        codegen_mem_store_fast(block, codegen_mem_store_byte, 1, 0);
     } else if (REG_IS_W(src_size)) {
         host_x86_MOV16_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_word);
+        codegen_mem_store_fast(block, codegen_mem_store_word, 2, 0);
     } else if (REG_IS_L(src_size)) {
         host_x86_MOV32_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_long);
+        codegen_mem_store_fast(block, codegen_mem_store_long, 4, 0);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_STORE_ABS - %02x\n", uop->src_reg_b_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
 
     return 0;
 }
@@ -1117,9 +1192,7 @@ codegen_MEM_STORE_IMM_8(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV8_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_byte);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_byte, 1, 0);
 
     return 0;
 }
@@ -1131,9 +1204,7 @@ codegen_MEM_STORE_IMM_16(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV16_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_word);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_word, 2, 0);
 
     return 0;
 }
@@ -1145,9 +1216,7 @@ codegen_MEM_STORE_IMM_32(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV32_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_long);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_long, 4, 0);
 
     return 0;
 }
@@ -1165,23 +1234,21 @@ codegen_MEM_STORE_REG(codeblock_t *block, uop_t *uop)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_x86_MOV8_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_byte);
+        codegen_mem_store_fast(block, codegen_mem_store_byte, 1, 0);
     } else if (REG_IS_W(src_size)) {
         host_x86_MOV16_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_word);
+        codegen_mem_store_fast(block, codegen_mem_store_word, 2, 0);
     } else if (REG_IS_L(src_size)) {
         host_x86_MOV32_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_long);
+        codegen_mem_store_fast(block, codegen_mem_store_long, 4, 0);
     } else if (REG_IS_Q(src_size)) {
         host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg);
-        host_x86_CALL(block, codegen_mem_store_quad);
+        codegen_mem_store_fast(block, codegen_mem_store_quad, 8, 0);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_STORE_REG - %02x\n", uop->src_reg_b_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
 
     return 0;
 }
@@ -1202,9 +1269,7 @@ codegen_MEM_STORE_SINGLE(codeblock_t *block, uop_t *uop)
     if (uop->imm_data)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
     host_x86_CVTSD2SS_XREG_XREG(block, REG_XMM_TEMP, src_reg);
-    host_x86_CALL(block, codegen_mem_store_single);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_single, 4, 1);
 
     return 0;
 }
@@ -1224,9 +1289,7 @@ codegen_MEM_STORE_DOUBLE(codeblock_t *block, uop_t *uop)
     if (uop->imm_data)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
     host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg);
-    host_x86_CALL(block, codegen_mem_store_double);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_store_fast(block, codegen_mem_store_double, 8, 1);
 
     return 0;
 }
@@ -1289,6 +1352,9 @@ codegen_MOV_REG_PTR(codeblock_t *block, uop_t *uop)
 
     if (REG_IS_L(dest_size)) {
         host_x86_MOV32_REG_ABS(block, dest_reg, uop->p);
+    } else if (REG_IS_D(dest_size)) {
+        host_x86_MOV64_REG_IMM(block, REG_RCX, (uint64_t) uop->p);
+        host_x86_MOVQ_XREG_BASE_OFFSET(block, dest_reg, REG_RCX, 0);
     } else
         fatal("MOV_REG_PTR %02x\n", uop->dest_reg_a_real);
 
@@ -2077,6 +2143,24 @@ codegen_PSLLW_IMM(codeblock_t *block, uop_t *uop)
     return 0;
 }
 static int
+codegen_PSLLW(codeblock_t *block, uop_t *uop)
+{
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg_b  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size_b = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if (REG_IS_Q(dest_size) && REG_IS_L(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
+        host_x86_MOVD_XREG_REG(block, REG_XMM_TEMP, src_reg_b);
+        host_x86_PSLLW_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
+    }
+#    ifdef RECOMPILER_DEBUG
+    else
+        fatal("PSLLW %02x %02x %02x\n", uop->dest_reg_a_real, uop->src_reg_a_real, uop->src_reg_b_real);
+#    endif
+    return 0;
+}
+static int
 codegen_PSLLD_IMM(codeblock_t *block, uop_t *uop)
 {
     int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
@@ -2092,6 +2176,24 @@ codegen_PSLLD_IMM(codeblock_t *block, uop_t *uop)
     return 0;
 }
 static int
+codegen_PSLLD(codeblock_t *block, uop_t *uop)
+{
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg_b  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size_b = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if (REG_IS_Q(dest_size) && REG_IS_L(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
+        host_x86_MOVD_XREG_REG(block, REG_XMM_TEMP, src_reg_b);
+        host_x86_PSLLD_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
+    }
+#    ifdef RECOMPILER_DEBUG
+    else
+        fatal("PSLLD %02x %02x %02x\n", uop->dest_reg_a_real, uop->src_reg_a_real, uop->src_reg_b_real);
+#    endif
+    return 0;
+}
+static int
 codegen_PSLLQ_IMM(codeblock_t *block, uop_t *uop)
 {
     int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
@@ -2107,6 +2209,24 @@ codegen_PSLLQ_IMM(codeblock_t *block, uop_t *uop)
     return 0;
 }
 static int
+codegen_PSLLQ(codeblock_t *block, uop_t *uop)
+{
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg_b  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size_b = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if (REG_IS_Q(dest_size) && REG_IS_L(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
+        host_x86_MOVD_XREG_REG(block, REG_XMM_TEMP, src_reg_b);
+        host_x86_PSLLQ_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
+    }
+#    ifdef RECOMPILER_DEBUG
+    else
+        fatal("PSLLQ %02x %02x %02x\n", uop->dest_reg_a_real, uop->src_reg_a_real, uop->src_reg_b_real);
+#    endif
+    return 0;
+}
+static int
 codegen_PSRAW_IMM(codeblock_t *block, uop_t *uop)
 {
     int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
@@ -2122,6 +2242,24 @@ codegen_PSRAW_IMM(codeblock_t *block, uop_t *uop)
     return 0;
 }
 static int
+codegen_PSRAW(codeblock_t *block, uop_t *uop)
+{
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg_b  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size_b = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if (REG_IS_Q(dest_size) && REG_IS_L(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
+        host_x86_MOVD_XREG_REG(block, REG_XMM_TEMP, src_reg_b);
+        host_x86_PSRAW_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
+    }
+#    ifdef RECOMPILER_DEBUG
+    else
+        fatal("PSRAW %02x %02x %02x\n", uop->dest_reg_a_real, uop->src_reg_a_real, uop->src_reg_b_real);
+#    endif
+    return 0;
+}
+static int
 codegen_PSRAD_IMM(codeblock_t *block, uop_t *uop)
 {
     int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
@@ -2137,6 +2275,24 @@ codegen_PSRAD_IMM(codeblock_t *block, uop_t *uop)
     return 0;
 }
 static int
+codegen_PSRAD(codeblock_t *block, uop_t *uop)
+{
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg_b  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size_b = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if (REG_IS_Q(dest_size) && REG_IS_L(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
+        host_x86_MOVD_XREG_REG(block, REG_XMM_TEMP, src_reg_b);
+        host_x86_PSRAD_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
+    }
+#    ifdef RECOMPILER_DEBUG
+    else
+        fatal("PSRAD %02x %02x %02x\n", uop->dest_reg_a_real, uop->src_reg_a_real, uop->src_reg_b_real);
+#    endif
+    return 0;
+}
+static int
 codegen_PSRAQ_IMM(codeblock_t *block, uop_t *uop)
 {
     int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
@@ -2167,6 +2323,24 @@ codegen_PSRLW_IMM(codeblock_t *block, uop_t *uop)
     return 0;
 }
 static int
+codegen_PSRLW(codeblock_t *block, uop_t *uop)
+{
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg_b  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size_b = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if (REG_IS_Q(dest_size) && REG_IS_L(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
+        host_x86_MOVD_XREG_REG(block, REG_XMM_TEMP, src_reg_b);
+        host_x86_PSRLW_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
+    }
+#    ifdef RECOMPILER_DEBUG
+    else
+        fatal("PSRLW %02x %02x %02x\n", uop->dest_reg_a_real, uop->src_reg_a_real, uop->src_reg_b_real);
+#    endif
+    return 0;
+}
+static int
 codegen_PSRLD_IMM(codeblock_t *block, uop_t *uop)
 {
     int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
@@ -2182,6 +2356,24 @@ codegen_PSRLD_IMM(codeblock_t *block, uop_t *uop)
     return 0;
 }
 static int
+codegen_PSRLD(codeblock_t *block, uop_t *uop)
+{
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg_b  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size_b = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if (REG_IS_Q(dest_size) && REG_IS_L(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
+        host_x86_MOVD_XREG_REG(block, REG_XMM_TEMP, src_reg_b);
+        host_x86_PSRLD_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
+    }
+#    ifdef RECOMPILER_DEBUG
+    else
+        fatal("PSRLD %02x %02x %02x\n", uop->dest_reg_a_real, uop->src_reg_a_real, uop->src_reg_b_real);
+#    endif
+    return 0;
+}
+static int
 codegen_PSRLQ_IMM(codeblock_t *block, uop_t *uop)
 {
     int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
@@ -2196,6 +2388,24 @@ codegen_PSRLQ_IMM(codeblock_t *block, uop_t *uop)
 #    endif
     return 0;
 }
+static int
+codegen_PSRLQ(codeblock_t *block, uop_t *uop)
+{
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg_b  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size_b = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if (REG_IS_Q(dest_size) && REG_IS_L(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
+        host_x86_MOVD_XREG_REG(block, REG_XMM_TEMP, src_reg_b);
+        host_x86_PSRLQ_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
+    }
+#    ifdef RECOMPILER_DEBUG
+    else
+        fatal("PSRLQ %02x %02x %02x\n", uop->dest_reg_a_real, uop->src_reg_a_real, uop->src_reg_b_real);
+#    endif
+    return 0;
+}
 
 static int
 codegen_PSUBB(codeblock_t *block, uop_t *uop)
@@ -3254,30 +3464,54 @@ const uOpFn uop_handlers[UOP_MAX] = {
     [UOP_PSLLW_IMM &
         UOP_MASK]
     = codegen_PSLLW_IMM,
+    [UOP_PSLLW &
+        UOP_MASK]
+    = codegen_PSLLW,
     [UOP_PSLLD_IMM &
         UOP_MASK]
     = codegen_PSLLD_IMM,
+    [UOP_PSLLD &
+        UOP_MASK]
+    = codegen_PSLLD,
     [UOP_PSLLQ_IMM &
         UOP_MASK]
     = codegen_PSLLQ_IMM,
+    [UOP_PSLLQ &
+        UOP_MASK]
+    = codegen_PSLLQ,
     [UOP_PSRAW_IMM &
         UOP_MASK]
     = codegen_PSRAW_IMM,
+    [UOP_PSRAW &
+        UOP_MASK]
+    = codegen_PSRAW,
     [UOP_PSRAD_IMM &
         UOP_MASK]
     = codegen_PSRAD_IMM,
+    [UOP_PSRAD &
+        UOP_MASK]
+    = codegen_PSRAD,
     [UOP_PSRAQ_IMM &
         UOP_MASK]
     = codegen_PSRAQ_IMM,
     [UOP_PSRLW_IMM &
         UOP_MASK]
     = codegen_PSRLW_IMM,
+    [UOP_PSRLW &
+        UOP_MASK]
+    = codegen_PSRLW,
     [UOP_PSRLD_IMM &
         UOP_MASK]
     = codegen_PSRLD_IMM,
+    [UOP_PSRLD &
+        UOP_MASK]
+    = codegen_PSRLD,
     [UOP_PSRLQ_IMM &
         UOP_MASK]
     = codegen_PSRLQ_IMM,
+    [UOP_PSRLQ &
+        UOP_MASK]
+    = codegen_PSRLQ,
 
     [UOP_PSUBB &
         UOP_MASK]
@@ -41,6 +41,7 @@ uint32_t recomp_page = -1;
 
 int        block_current = 0;
 static int block_num;
+static int evict_hand = 0;
 int        block_pos;
 
 uint32_t codegen_endpc;
@@ -204,7 +205,7 @@ block_free_list_get(void)
         }
         /*Free list is empty - free up a block*/
         if (!codegen_purge_purgable_list())
-            codegen_delete_random_block(0);
+            codegen_evict_block(0, BLOCK_INVALID);
     }
 
     block           = &codeblock[block_free_list];
@@ -243,11 +244,14 @@ codegen_reset(void)
             block->phys   = 0;
             block->phys_2 = 0;
             delete_block(block);
+            codegen_stats.flushed++;
         }
     }
+    codegen_stats.flushes++;
 
     memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
     memset(codeblock_hash, 0, HASH_SIZE * sizeof(uint16_t));
+    memset(codeblock_hash_l2, 0, HASH_SIZE * sizeof(uint16_t));
     mem_reset_page_blocks();
 
     block_free_list = 0;
@@ -255,6 +259,7 @@ codegen_reset(void)
         codeblock[c].pc = BLOCK_PC_INVALID;
         block_free_list_add(&codeblock[c]);
     }
+    evict_hand = 0;
 }
 
 void
@@ -391,6 +396,8 @@ delete_block(codeblock_t *block)
 
     if (block == &codeblock[codeblock_hash[HASH(block->phys)]])
         codeblock_hash[HASH(block->phys)] = BLOCK_INVALID;
+    if (block == &codeblock[codeblock_hash_l2[HASH_L2(block->phys)]])
+        codeblock_hash_l2[HASH_L2(block->phys)] = BLOCK_INVALID;
 
 #ifndef RELEASE_BUILD
     if (block->pc == BLOCK_PC_INVALID)
@@ -414,6 +421,8 @@ delete_dirty_block(codeblock_t *block)
 {
     if (block == &codeblock[codeblock_hash[HASH(block->phys)]])
         codeblock_hash[HASH(block->phys)] = BLOCK_INVALID;
+    if (block == &codeblock[codeblock_hash_l2[HASH_L2(block->phys)]])
+        codeblock_hash_l2[HASH_L2(block->phys)] = BLOCK_INVALID;
 
 #ifndef RELEASE_BUILD
     if (block->pc == BLOCK_PC_INVALID)
@@ -432,29 +441,37 @@ codegen_delete_block(codeblock_t *block)
         delete_block(block);
 }
 
+/*Clock eviction. The hand sweeps the block array, blocks that have run since
+  it last passed lose their referenced flag and get a second chance, the first
+  one that has not is evicted.*/
 void
-codegen_delete_random_block(int required_mem_block)
+codegen_evict_block(int required_mem_block, int keep_block)
 {
-    int block_nr = rand() & BLOCK_MASK;
-
     while (1) {
-        if (block_nr && block_nr != block_current) {
-            codeblock_t *block = &codeblock[block_nr];
+        evict_hand = (evict_hand + 1) & BLOCK_MASK;
+
+        if (evict_hand && evict_hand != block_current && evict_hand != keep_block) {
+            codeblock_t *block = &codeblock[evict_hand];
 
             if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block)) {
-                delete_block(block);
-                return;
+                if (block->flags & CODEBLOCK_REFERENCED)
+                    block->flags &= ~CODEBLOCK_REFERENCED;
+                else {
+                    delete_block(block);
+                    codegen_stats.evictions++;
+                    return;
+                }
             }
         }
-        block_nr = (block_nr + 1) & BLOCK_MASK;
     }
 }
 
 void
-codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_addr))
+codegen_check_flush(page_t *page, UNUSED(uint64_t mask), uint32_t phys_addr)
 {
     uint16_t block_nr               = page->block;
     int      remove_from_evict_list = 0;
+    uint32_t invalidations          = page->invalidations;
 
     while (block_nr) {
         codeblock_t *block      = &codeblock[block_nr];
@@ -462,6 +479,7 @@ codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_ad
 
         if (*block->dirty_mask & block->page_mask) {
             invalidate_block(block);
+            page->invalidations++;
         }
 #ifndef RELEASE_BUILD
         if (block_nr == next_block)
@@ -478,6 +496,7 @@ codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_ad
 
         if (*block->dirty_mask2 & block->page_mask2) {
             invalidate_block(block);
+            page->invalidations++;
         }
 #ifndef RELEASE_BUILD
         if (block_nr == next_block)
@@ -486,6 +505,12 @@ codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_ad
         block_nr = next_block;
     }
 
+    codegen_stats.smc_invalidations += page->invalidations - invalidations;
+    if (page->invalidations > codegen_stats.smc_hot_page_count) {
+        codegen_stats.smc_hot_page       = phys_addr & ~0xfff;
+        codegen_stats.smc_hot_page_count = page->invalidations;
+    }
+
     if (page->code_present_mask & page->dirty_mask)
         remove_from_evict_list = 1;
     page->code_present_mask &= ~page->dirty_mask;
@@ -561,6 +586,7 @@ codegen_block_start_recompile(codeblock_t *block)
 
     block->head_mem_block = codegen_allocator_allocate(NULL, block_current);
     block->data           = codeblock_allocator_get_ptr(block->head_mem_block);
+    codegen_stats.recompiles++;
 
     block->status = cpu_cur_status;
 
@@ -613,6 +639,7 @@ codegen_block_remove(void)
     codeblock_t *block = &codeblock[block_current];
 
     delete_block(block);
+    codegen_stats.aborts++;
 
     recomp_page = -1;
 }
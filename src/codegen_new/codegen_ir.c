@@ -84,7 +84,10 @@ codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
         }
     }
 
+    codegen_stats.uops += ir->wr_pos;
+
     codegen_reg_mark_as_required();
+    codegen_reg_fold_constants(ir);
     codegen_reg_process_dead_list(ir);
     block_write_data = codeblock_allocator_get_ptr(block->head_mem_block);
     block_pos        = 0;
@@ -93,6 +96,7 @@ codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
     for (c = 0; c < ir->wr_pos; c++) {
         uop_t *uop = &ir->uops[c];
 
+        ir->rd_pos = c;
         //                pclog("uOP %i : %08x\n", c, uop->type);
 
         if (uop->type & UOP_TYPE_BARRIER)
@@ -192,6 +196,7 @@ codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
     }
 
     codegen_backend_epilogue(block);
+    codegen_stats.host_bytes += block_pos;
     block_write_data = NULL;
 #if 0
     if (has_ea)
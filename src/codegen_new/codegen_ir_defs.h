@@ -324,7 +324,24 @@
 /*UOP_PFRSQRT - (packed float) dest_reg[0] = dest_reg[1] = 1.0 / sqrt(src_reg[0])*/
 #define UOP_PFRSQRT (UOP_TYPE_PARAMS_REGS | 0xc5)
 
-#define UOP_MAX     0xc6
+/*UOP_PSLLW - (packed word) dest_reg = src_reg_a << src_reg_b*/
+#define UOP_PSLLW (UOP_TYPE_PARAMS_REGS | 0xc6)
+/*UOP_PSLLD - (packed long) dest_reg = src_reg_a << src_reg_b*/
+#define UOP_PSLLD (UOP_TYPE_PARAMS_REGS | 0xc7)
+/*UOP_PSLLQ - (packed quad) dest_reg = src_reg_a << src_reg_b*/
+#define UOP_PSLLQ (UOP_TYPE_PARAMS_REGS | 0xc8)
+/*UOP_PSRAW - (packed word) dest_reg = src_reg_a >> src_reg_b*/
+#define UOP_PSRAW (UOP_TYPE_PARAMS_REGS | 0xc9)
+/*UOP_PSRAD - (packed long) dest_reg = src_reg_a >> src_reg_b*/
+#define UOP_PSRAD (UOP_TYPE_PARAMS_REGS | 0xca)
+/*UOP_PSRLW - (packed word) dest_reg = src_reg_a >> src_reg_b*/
+#define UOP_PSRLW (UOP_TYPE_PARAMS_REGS | 0xcb)
+/*UOP_PSRLD - (packed long) dest_reg = src_reg_a >> src_reg_b*/
+#define UOP_PSRLD (UOP_TYPE_PARAMS_REGS | 0xcc)
+/*UOP_PSRLQ - (packed quad) dest_reg = src_reg_a >> src_reg_b*/
+#define UOP_PSRLQ (UOP_TYPE_PARAMS_REGS | 0xcd)
+
+#define UOP_MAX     0xce
 
 #define UOP_INVALID 0xff
 
@@ -356,6 +373,9 @@ typedef struct uop_t {
 typedef struct ir_data_t {
     uop_t               uops[UOP_NR_MAX];
     int                 wr_pos;
+    /*uOP currently being compiled, used by the register allocator to look
+      ahead at upcoming register uses*/
+    int                 rd_pos;
     struct codeblock_t *block;
 } ir_data_t;
 
@@ -851,6 +871,14 @@ extern int codegen_fp_enter(void);
 #define uop_PSRLW_IMM(ir, dst_reg, src_reg, imm)                         uop_gen_reg_dst_src_imm(UOP_PSRLW_IMM, ir, dst_reg, src_reg, imm)
 #define uop_PSRLD_IMM(ir, dst_reg, src_reg, imm)                         uop_gen_reg_dst_src_imm(UOP_PSRLD_IMM, ir, dst_reg, src_reg, imm)
 #define uop_PSRLQ_IMM(ir, dst_reg, src_reg, imm)                         uop_gen_reg_dst_src_imm(UOP_PSRLQ_IMM, ir, dst_reg, src_reg, imm)
+#define uop_PSLLW(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSLLW, ir, dst_reg, src_reg_a, src_reg_b)
+#define uop_PSLLD(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSLLD, ir, dst_reg, src_reg_a, src_reg_b)
+#define uop_PSLLQ(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSLLQ, ir, dst_reg, src_reg_a, src_reg_b)
+#define uop_PSRAW(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSRAW, ir, dst_reg, src_reg_a, src_reg_b)
+#define uop_PSRAD(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSRAD, ir, dst_reg, src_reg_a, src_reg_b)
+#define uop_PSRLW(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSRLW, ir, dst_reg, src_reg_a, src_reg_b)
+#define uop_PSRLD(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSRLD, ir, dst_reg, src_reg_a, src_reg_b)
+#define uop_PSRLQ(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSRLQ, ir, dst_reg, src_reg_a, src_reg_b)
 
 #define uop_PSUBB(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSUBB, ir, dst_reg, src_reg_a, src_reg_b)
 #define uop_PSUBW(ir, dst_reg, src_reg_a, src_reg_b)                     uop_gen_reg_dst_src2(UOP_PSUBW, ir, dst_reg, src_reg_a, src_reg_b)
@@ -40,3 +40,48 @@ ropFLDZ(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32
 
     return op_pc;
 }
+
+/*These match the constants pushed by the interpreter, ln2 is given as a bit
+  pattern as the interpreter rounds it up.*/
+static const double fpu_const_l2t = 3.3219280948873623;
+static const double fpu_const_l2e = 1.4426950408889634;
+static const double fpu_const_pi  = 3.141592653589793;
+static const double fpu_const_lg2 = 0.3010299956639812;
+static const uint64_t fpu_const_ln2 = 0x3fe62e42fefa39f0ULL;
+
+static uint32_t
+ropFLD_const(codeblock_t *block, ir_data_t *ir, const void *p, uint32_t op_pc)
+{
+    uop_FP_ENTER(ir);
+    uop_MOV_REG_PTR(ir, IREG_ST(-1), (void *) p);
+    uop_MOV_IMM(ir, IREG_tag(-1), TAG_VALID);
+    fpu_PUSH(block, ir);
+
+    return op_pc;
+}
+
+uint32_t
+ropFLDL2T(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32_t fetchdat), UNUSED(uint32_t op_32), uint32_t op_pc)
+{
+    return ropFLD_const(block, ir, &fpu_const_l2t, op_pc);
+}
+uint32_t
+ropFLDL2E(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32_t fetchdat), UNUSED(uint32_t op_32), uint32_t op_pc)
+{
+    return ropFLD_const(block, ir, &fpu_const_l2e, op_pc);
+}
+uint32_t
+ropFLDPI(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32_t fetchdat), UNUSED(uint32_t op_32), uint32_t op_pc)
+{
+    return ropFLD_const(block, ir, &fpu_const_pi, op_pc);
+}
+uint32_t
+ropFLDEG2(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32_t fetchdat), UNUSED(uint32_t op_32), uint32_t op_pc)
+{
+    return ropFLD_const(block, ir, &fpu_const_lg2, op_pc);
+}
+uint32_t
+ropFLDLN2(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32_t fetchdat), UNUSED(uint32_t op_32), uint32_t op_pc)
+{
+    return ropFLD_const(block, ir, &fpu_const_ln2, op_pc);
+}
@@ -94,3 +94,40 @@ ropPSxxQ_imm(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), uint32_t
     codegen_mark_code_present(block, cs + op_pc + 1, 1);
     return op_pc + 2;
 }
+
+#define ropPshift(func)                                                                            \
+    uint32_t rop##func(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode),                  \
+                       uint32_t fetchdat, uint32_t op_32, uint32_t op_pc)                          \
+    {                                                                                              \
+        int dest_reg = (fetchdat >> 3) & 7;                                                        \
+                                                                                                   \
+        uop_MMX_ENTER(ir);                                                                         \
+        codegen_mark_code_present(block, cs + op_pc, 1);                                           \
+        if ((fetchdat & 0xc0) == 0xc0) {                                                           \
+            int src_reg = fetchdat & 7;                                                            \
+            uop_MOVZX(ir, IREG_temp0, IREG_MM(src_reg));                                           \
+        } else {                                                                                   \
+            x86seg *target_seg;                                                                    \
+                                                                                                   \
+            uop_MOV_IMM(ir, IREG_oldpc, cpu_state.oldpc);                                          \
+            target_seg = codegen_generate_ea(ir, op_ea_seg, fetchdat, op_ssegs, &op_pc, op_32, 0); \
+            codegen_check_seg_read(block, ir, target_seg);                                         \
+            uop_MEM_LOAD_REG(ir, IREG_temp0_B, ireg_seg_base(target_seg), IREG_eaaddr);            \
+        }                                                                                          \
+        /*Only the low byte of the count is used, as in the interpreter*/                          \
+        uop_MOVZX(ir, IREG_temp0, IREG_temp0_B);                                                   \
+        uop_##func(ir, IREG_MM(dest_reg), IREG_MM(dest_reg), IREG_temp0);                          \
+                                                                                                   \
+        return op_pc + 1;                                                                          \
+    }
+
+// clang-format off
+ropPshift(PSLLW)
+ropPshift(PSLLD)
+ropPshift(PSLLQ)
+ropPshift(PSRAW)
+ropPshift(PSRAD)
+ropPshift(PSRLW)
+ropPshift(PSRLD)
+ropPshift(PSRLQ)
+// clang-format on
@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/mem.h>
@@ -627,6 +628,72 @@ codegen_reg_alloc_register(ir_reg_t dest_reg_a, ir_reg_t src_reg_a, ir_reg_t src
         alloc_dest_reg(dest_reg_a, dest_reference);
 }
 
+/*Distance, in uOPs, to the next read of a register version. All registers are
+  written back and evicted at the next barrier, so uses past that point do not
+  count.*/
+static int
+reg_next_use(const ir_data_t *ir, ir_reg_t ir_reg)
+{
+    int reg = IREG_GET_REG(ir_reg.reg);
+
+    for (int c = ir->rd_pos + 1; c < ir->wr_pos; c++) {
+        const uop_t *uop = &ir->uops[c];
+
+        if (uop->type & UOP_TYPE_BARRIER)
+            break;
+        if ((uop->type & UOP_MASK) == UOP_INVALID)
+            continue;
+
+        if ((IREG_GET_REG(uop->src_reg_a.reg) == reg && uop->src_reg_a.version == ir_reg.version) ||
+            (IREG_GET_REG(uop->src_reg_b.reg) == reg && uop->src_reg_b.version == ir_reg.version) ||
+            (IREG_GET_REG(uop->src_reg_c.reg) == reg && uop->src_reg_c.version == ir_reg.version))
+            return c - ir->rd_pos;
+        /*Partial writes read the previous version*/
+        if (IREG_GET_REG(uop->dest_reg_a.reg) == reg && uop->dest_reg_a.version == ir_reg.version + 1 && !reg_is_native_size(uop->dest_reg_a))
+            return c - ir->rd_pos;
+    }
+
+    return UOP_NR_MAX;
+}
+
+/*Pick an unlocked host register to evict. Registers with no pending reads are
+  free to take, preferring ones that don't need writing back. Otherwise take the
+  one whose next use is furthest away, so the reload happens as late as
+  possible.*/
+static int
+reg_select_victim(host_reg_set_t *reg_set)
+{
+    const ir_data_t *ir        = codegen_get_ir_data();
+    int              victim    = -1;
+    int              victim_nu = -1;
+
+    for (int c = 0; c < reg_set->nr_regs; c++) {
+        if (!(reg_set->locked & (1 << c)) && IREG_GET_REG(reg_set->regs[c].reg) != IREG_INVALID && !ir_get_refcount(reg_set->regs[c])) {
+            if (!reg_set->dirty[c])
+                return c;
+            if (victim == -1)
+                victim = c;
+        }
+    }
+    if (victim != -1)
+        return victim;
+
+    for (int c = 0; c < reg_set->nr_regs; c++) {
+        if (!(reg_set->locked & (1 << c))) {
+            int next_use = ir_reg_is_invalid(reg_set->regs[c]) ? UOP_NR_MAX + 1 : reg_next_use(ir, reg_set->regs[c]);
+
+            if (next_use > victim_nu) {
+                victim    = c;
+                victim_nu = next_use;
+            }
+        }
+    }
+
+    if (victim != -1 && victim_nu <= UOP_NR_MAX)
+        codegen_stats.reg_spills++;
+    return victim;
+}
+
 ir_host_reg_t
 codegen_reg_alloc_read_reg(codeblock_t *block, ir_reg_t ir_reg, int *host_reg_idx)
 {
@@ -650,22 +717,12 @@ codegen_reg_alloc_read_reg(codeblock_t *block, ir_reg_t ir_reg, int *host_reg_id
     }
 
     if (c == reg_set->nr_regs) {
-        /*No unused registers. Search for an unlocked register with no pending reads*/
-        for (c = 0; c < reg_set->nr_regs; c++) {
-            if (!(reg_set->locked & (1 << c)) && IREG_GET_REG(reg_set->regs[c].reg) != IREG_INVALID && !ir_get_refcount(reg_set->regs[c]))
-                break;
-        }
-        if (c == reg_set->nr_regs) {
-            /*Search for any unlocked register*/
-            for (c = 0; c < reg_set->nr_regs; c++) {
-                if (!(reg_set->locked & (1 << c)))
-                    break;
-            }
+        /*No unused registers, evict one*/
+        c = reg_select_victim(reg_set);
 #ifndef RELEASE_BUILD
-            if (c == reg_set->nr_regs)
-                fatal("codegen_reg_alloc_read_reg - out of registers\n");
+        if (c == -1)
+            fatal("codegen_reg_alloc_read_reg - out of registers\n");
 #endif
-        }
         if (reg_set->dirty[c])
             codegen_reg_writeback(reg_set, block, c, 1);
         codegen_reg_load(reg_set, block, c, ir_reg);
@@ -734,13 +791,10 @@ codegen_reg_alloc_write_reg(codeblock_t *block, ir_reg_t ir_reg)
         }
 
         if (c == reg_set->nr_regs) {
-            /*No unused registers. Search for an unlocked register*/
-            for (c = 0; c < reg_set->nr_regs; c++) {
-                if (!(reg_set->locked & (1 << c)))
-                    break;
-            }
+            /*No unused registers, evict one*/
+            c = reg_select_victim(reg_set);
 #ifndef RELEASE_BUILD
-            if (c == reg_set->nr_regs)
+            if (c == -1)
                 fatal("codegen_reg_alloc_write_reg - out of registers\n");
 #endif
             if (reg_set->dirty[c])
@@ -905,8 +959,118 @@ codegen_reg_process_dead_list(ir_data_t *ir)
                     add_to_dead_list(src_regv, IREG_GET_REG(uop->src_reg_c.reg), uop->src_reg_c.version);
             }
             regv->flags |= REG_FLAGS_DEAD;
+            codegen_stats.ir_dead++;
         }
 
         reg_dead_list = regv->next;
     }
 }
+
+static int
+reg_is_dword(ir_reg_t ir_reg)
+{
+    return (ireg_data[IREG_GET_REG(ir_reg.reg)].native_size == REG_DWORD) && (IREG_GET_SIZE(ir_reg.reg) == IREG_SIZE_L);
+}
+
+/*Can this register version be optimised out once nothing reads it? Mirrors the
+  checks in codegen_reg_write() - the first four registers are never removed,
+  required versions must be kept, and a version followed by a partial write is
+  still read by that write.*/
+static int
+reg_version_removable(ir_data_t *ir, ir_reg_t ir_reg)
+{
+    int reg = IREG_GET_REG(ir_reg.reg);
+
+    if (reg <= IREG_EBX || (reg_version[reg][ir_reg.version].flags & REG_FLAGS_REQUIRED))
+        return 0;
+    if (ir_reg.version < reg_last_version[reg]) {
+        uop_t *next_uop = &ir->uops[reg_version[reg][ir_reg.version + 1].parent_uop];
+
+        if (!reg_is_native_size(next_uop->dest_reg_a))
+            return 0;
+    }
+    return 1;
+}
+
+void
+codegen_reg_fold_constants(ir_data_t *ir)
+{
+    static uint8_t is_jump_dest[UOP_NR_MAX];
+    int            run_start = 0;
+
+    memset(is_jump_dest, 0, ir->wr_pos);
+    for (int c = 0; c < ir->wr_pos; c++) {
+        uop_t *uop = &ir->uops[c];
+
+        if ((uop->type & UOP_TYPE_JUMP) && uop->jump_dest_uop >= 0 && uop->jump_dest_uop < ir->wr_pos)
+            is_jump_dest[uop->jump_dest_uop] = 1;
+    }
+
+    for (int c = 0; c < ir->wr_pos; c++) {
+        uop_t         *uop = &ir->uops[c];
+        uop_t         *parent;
+        reg_version_t *src_regv;
+        uint32_t       imm;
+
+        /*Register versions only describe a single value within a straight run
+          of uOPs. Barriers may modify guest registers behind our back, and
+          jumps may skip writes.*/
+        if (is_jump_dest[c] || (uop->type & (UOP_TYPE_BARRIER | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_JUMP))) {
+            run_start = c + 1;
+            continue;
+        }
+
+        switch (uop->type) {
+            case UOP_MOV:
+            case UOP_ADD_IMM:
+            case UOP_SUB_IMM:
+            case UOP_AND_IMM:
+            case UOP_OR_IMM:
+            case UOP_XOR_IMM:
+                break;
+            default:
+                continue;
+        }
+
+        if (!reg_is_dword(uop->src_reg_a) || !reg_is_dword(uop->dest_reg_a) || !uop->src_reg_a.version)
+            continue;
+
+        src_regv = &reg_version[IREG_GET_REG(uop->src_reg_a.reg)][uop->src_reg_a.version];
+        if (src_regv->parent_uop < run_start || src_regv->parent_uop >= c)
+            continue;
+        parent = &ir->uops[src_regv->parent_uop];
+        if (parent->type != UOP_MOV_IMM || !reg_is_dword(parent->dest_reg_a))
+            continue;
+
+        imm = (uint32_t) parent->imm_data;
+        switch (uop->type) {
+            case UOP_ADD_IMM:
+                imm += (uint32_t) uop->imm_data;
+                break;
+            case UOP_SUB_IMM:
+                imm -= (uint32_t) uop->imm_data;
+                break;
+            case UOP_AND_IMM:
+                imm &= (uint32_t) uop->imm_data;
+                break;
+            case UOP_OR_IMM:
+                imm |= (uint32_t) uop->imm_data;
+                break;
+            case UOP_XOR_IMM:
+                imm ^= (uint32_t) uop->imm_data;
+                break;
+            default:
+                break;
+        }
+
+        uop->type     = UOP_MOV_IMM;
+        uop->imm_data = imm;
+
+        src_regv->refcount--;
+        if (!src_regv->refcount && reg_version_removable(ir, uop->src_reg_a))
+            add_to_dead_list(src_regv, IREG_GET_REG(uop->src_reg_a.reg), uop->src_reg_a.version);
+        uop->src_reg_a = invalid_ir_reg;
+
+        codegen_stats.ir_folded++;
+    }
+}
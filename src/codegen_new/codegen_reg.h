@@ -423,4 +423,6 @@ void codegen_reg_rename(codeblock_t *block, ir_reg_t src, ir_reg_t dst);
 
 void codegen_reg_mark_as_required(void);
 void codegen_reg_process_dead_list(struct ir_data_t *ir);
+/*Replace ALU operations on constant 32-bit registers with UOP_MOV_IMM*/
+void codegen_reg_fold_constants(struct ir_data_t *ir);
 #endif
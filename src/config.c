@@ -93,6 +93,19 @@ static int   ch;
 static ini_t config;
 static ini_t global;
 
+/* Saves are snapshotted and handed to a writer thread, which waits for a
+   burst of them to settle before touching the disk. */
+#define CONFIG_WRITE_DELAY    250 /* ms of quiet before writing */
+#define CONFIG_WRITE_MAX_WAIT 8   /* delays to wait at most while saves keep coming */
+
+static mutex_t  *config_write_mutex; /* protects the pending snapshots */
+static mutex_t  *config_io_mutex;    /* serializes the actual file writes */
+static event_t  *config_write_event;
+static thread_t *config_write_thread;
+static volatile int config_write_quit;
+static ini_t     config_pending;
+static ini_t     global_pending;
+
 #ifdef ENABLE_CONFIG_LOG
 int config_do_log = ENABLE_CONFIG_LOG;
 
@@ -207,7 +220,11 @@ load_general(void)
     video_grayscale  = ini_section_get_int(cat, "video_grayscale", 0);
     video_graytype   = ini_section_get_int(cat, "video_graytype", 0);
 
+    video_screenshot_format = ini_section_get_int(cat, "video_screenshot_format", SCREENSHOT_FORMAT_PNG);
+
     force_10ms = !!ini_section_get_int(cat, "force_10ms", 0);
+    cpu_frame_adaptive = !!ini_section_get_int(cat, "cpu_frame_adaptive", 0);
+    hlt_fast_forward   = !!ini_section_get_int(cat, "hlt_fast_forward", 0);
 
     rctrl_is_lalt = ini_section_get_int(cat, "rctrl_is_lalt", 0);
     update_icons  = ini_section_get_int(cat, "update_icons", 1);
@@ -273,6 +290,15 @@ load_general(void)
         strncpy(uuid, p, sizeof(uuid) - 1);
     else
         strncpy(uuid, "", sizeof(uuid) - 1);
+
+    for (int i = THREAD_ROLE_CPU; i < THREAD_ROLE_MAX; i++) {
+        sprintf(temp, "%s_thread_affinity", thread_role_name(i));
+        p = ini_section_get_string(cat, temp, "");
+        strncpy(thread_policy[i].affinity, p, sizeof(thread_policy[i].affinity) - 1);
+
+        sprintf(temp, "%s_thread_priority", thread_role_name(i));
+        thread_policy[i].priority = thread_priority_from_name(ini_section_get_string(cat, temp, "default"));
+    }
 }
 
 /* Load monitor section. */
@@ -476,7 +502,10 @@ load_machine(void)
     if (mem_size > machine_get_max_ram(machine))
         mem_size = machine_get_max_ram(machine);
 
-    cpu_use_dynarec = !!ini_section_get_int(cat, "cpu_use_dynarec", 0);
+    cpu_use_dynarec    = !!ini_section_get_int(cat, "cpu_use_dynarec", 0);
+    dynarec_cache_size = ini_section_get_int(cat, "dynarec_cache_size", 0);
+    dynarec_stats      = !!ini_section_get_int(cat, "dynarec_stats", 0);
+    mem_huge_pages     = !!ini_section_get_int(cat, "mem_huge_pages", 0);
     fpu_softfloat = !!ini_section_get_int(cat, "fpu_softfloat", 0);
     if ((fpu_type != FPU_NONE) && machine_has_flags(machine, MACHINE_SOFTFLOAT_ONLY))
         fpu_softfloat = 1;
@@ -751,6 +780,8 @@ load_sound(void)
     else
         sound_is_float = 0;
 
+    sound_low_latency = !!ini_section_get_int(cat, "sound_low_latency", 0);
+
     p = ini_section_get_string(cat, "fm_driver", "nuked");
     if (!strcmp(p, "ymfm")) {
         fm_driver = FM_DRV_YMFM;
@@ -789,6 +820,8 @@ load_network(void)
                 nc->net_type = NET_TYPE_NMSWITCH;
             else if (!strcmp(p, "nrswitch") || !strcmp(p, "6"))
                 nc->net_type = NET_TYPE_NRSWITCH;
+            else if (!strcmp(p, "shmswitch") || !strcmp(p, "7"))
+                nc->net_type = NET_TYPE_SHMSWITCH;
             else
                 nc->net_type = NET_TYPE_NONE;
         } else
@@ -841,6 +874,8 @@ load_network(void)
                 nc->net_type = NET_TYPE_NMSWITCH;
             else if (!strcmp(p, "nrswitch") || !strcmp(p, "6"))
                 nc->net_type = NET_TYPE_NRSWITCH;
+            else if (!strcmp(p, "shmswitch") || !strcmp(p, "7"))
+                nc->net_type = NET_TYPE_SHMSWITCH;
             else
                 nc->net_type = NET_TYPE_NONE;
         } else
@@ -868,6 +903,9 @@ load_network(void)
          sprintf(temp, "net_%02i_promisc", c + 1);
          net_cards_conf[c].promisc_mode = ini_section_get_int(cat, temp, 0);
 
+         sprintf(temp, "net_%02i_switch_framing", c + 1);
+         net_cards_conf[c].switch_framing = ini_section_get_int(cat, temp, NET_SWITCH_FRAMING_PROTOBUF);
+
          sprintf(temp, "net_%02i_nrs_host", c + 1);
          p = ini_section_get_string(cat, temp, NULL);
          if (p != NULL)
@@ -875,6 +913,15 @@ load_network(void)
          else
             strncpy(net_cards_conf[c].nrs_hostname, "", sizeof(net_cards_conf[c].nrs_hostname) - 1);
 
+        sprintf(temp, "net_%02i_queue_len", c + 1);
+        nc->queue_len = ini_section_get_int(cat, temp, NET_QUEUE_DEF_LEN);
+
+        sprintf(temp, "net_%02i_rx_coalesce", c + 1);
+        nc->rx_coalesce = ini_section_get_int(cat, temp, 0);
+
+        sprintf(temp, "net_%02i_stats", c + 1);
+        nc->stats = ini_section_get_int(cat, temp, 0);
+
         sprintf(temp, "net_%02i_link", c + 1);
         nc->link_state = ini_section_get_int(cat, temp,
                                              (NET_LINK_10_HD | NET_LINK_10_FD |
@@ -1229,6 +1276,14 @@ load_hard_disks(void)
     uint32_t      board = 0;
     uint32_t      dev = 0;
 
+    hdd_image_mmap                = !!ini_section_get_int(cat, "image_mmap", 0);
+    hdd_image_cache_size          = ini_section_get_int(cat, "cache_size", 0);
+    hdd_image_cache_write_through = !!ini_section_get_int(cat, "cache_write_through", 0);
+    if (hdd_image_cache_size < 0)
+        hdd_image_cache_size = 0;
+    else if (hdd_image_cache_size > 1024)
+        hdd_image_cache_size = 1024;
+
     memset(temp, '\0', sizeof(temp));
     for (uint8_t c = 0; c < HDD_NUM; c++) {
         sprintf(temp, "hdd_%02i_parameters", c + 1);
@@ -1388,6 +1443,9 @@ load_hard_disks(void)
         p = ini_section_get_string(cat, temp, "");
         strncpy(hdd[c].vhd_parent, p, sizeof(hdd[c].vhd_parent) - 1);
 
+        sprintf(temp, "hdd_%02i_overlay", c + 1);
+        hdd[c].overlay = !!ini_section_get_int(cat, temp, 0);
+
         /* If disk is empty or invalid, mark it for deletion. */
         if (!hdd_is_valid(c)) {
             sprintf(temp, "hdd_%02i_parameters", c + 1);
@@ -1433,6 +1491,13 @@ load_floppy_and_cdrom_drives(void)
     fdd_audio_load_profiles();
 #endif
 
+    cdrom_image_mmap       = !!ini_section_get_int(cat, "cdrom_image_mmap", 0);
+    cdrom_image_read_ahead = ini_section_get_int(cat, "cdrom_image_read_ahead", 256);
+    if (cdrom_image_read_ahead < 0)
+        cdrom_image_read_ahead = 0;
+    else if (cdrom_image_read_ahead > 4096)
+        cdrom_image_read_ahead = 4096;
+
     memset(temp, 0x00, sizeof(temp));
     for (c = 0; c < FDD_NUM; c++) {
         sprintf(temp, "fdd_%02i_type", c + 1);
@@ -2395,6 +2460,14 @@ save_general(void)
     if (force_10ms == 0)
         ini_section_delete_var(cat, "force_10ms");
 
+    ini_section_set_int(cat, "cpu_frame_adaptive", cpu_frame_adaptive);
+    if (cpu_frame_adaptive == 0)
+        ini_section_delete_var(cat, "cpu_frame_adaptive");
+
+    ini_section_set_int(cat, "hlt_fast_forward", hlt_fast_forward);
+    if (hlt_fast_forward == 0)
+        ini_section_delete_var(cat, "hlt_fast_forward");
+
     ini_section_set_int(cat, "sound_muted", sound_muted);
     if (sound_muted == 0)
         ini_section_delete_var(cat, "sound_muted");
@@ -2454,6 +2527,11 @@ save_general(void)
     else
         ini_section_set_int(cat, "video_graytype", video_graytype);
 
+    if (video_screenshot_format == SCREENSHOT_FORMAT_PNG)
+        ini_section_delete_var(cat, "video_screenshot_format");
+    else
+        ini_section_set_int(cat, "video_screenshot_format", video_screenshot_format);
+
     if (rctrl_is_lalt == 0)
         ini_section_delete_var(cat, "rctrl_is_lalt");
     else
@@ -2555,6 +2633,20 @@ save_general(void)
     else
         ini_section_delete_var(cat, "uuid");
 
+    for (int i = THREAD_ROLE_CPU; i < THREAD_ROLE_MAX; i++) {
+        sprintf(temp, "%s_thread_affinity", thread_role_name(i));
+        if (thread_policy[i].affinity[0])
+            ini_section_set_string(cat, temp, thread_policy[i].affinity);
+        else
+            ini_section_delete_var(cat, temp);
+
+        sprintf(temp, "%s_thread_priority", thread_role_name(i));
+        if (thread_policy[i].priority != THREAD_PRIO_DEFAULT)
+            ini_section_set_string(cat, temp, thread_priority_name(thread_policy[i].priority));
+        else
+            ini_section_delete_var(cat, temp);
+    }
+
     ini_delete_section_if_empty(config, cat);
 }
 
@@ -2629,6 +2721,21 @@ save_machine(void)
 
     ini_section_set_int(cat, "cpu_use_dynarec", cpu_use_dynarec);
 
+    if (dynarec_cache_size == 0)
+        ini_section_delete_var(cat, "dynarec_cache_size");
+    else
+        ini_section_set_int(cat, "dynarec_cache_size", dynarec_cache_size);
+
+    if (dynarec_stats == 0)
+        ini_section_delete_var(cat, "dynarec_stats");
+    else
+        ini_section_set_int(cat, "dynarec_stats", dynarec_stats);
+
+    if (mem_huge_pages == 0)
+        ini_section_delete_var(cat, "mem_huge_pages");
+    else
+        ini_section_set_int(cat, "mem_huge_pages", mem_huge_pages);
+
     if (fpu_softfloat == 0)
         ini_section_delete_var(cat, "fpu_softfloat");
     else
@@ -2881,6 +2988,11 @@ save_sound(void)
     else
         ini_section_set_string(cat, "sound_type", (sound_is_float == 1) ? "float" : "int16");
 
+    if (sound_low_latency == 0)
+        ini_section_delete_var(cat, "sound_low_latency");
+    else
+        ini_section_set_int(cat, "sound_low_latency", sound_low_latency);
+
     if (fm_driver == FM_DRV_NUKED)
         ini_section_delete_var(cat, "fm_driver");
     else
@@ -2933,6 +3045,9 @@ save_network(void)
             case NET_TYPE_NRSWITCH:
                 ini_section_set_string(cat, temp, "nrswitch");
                 break;
+            case NET_TYPE_SHMSWITCH:
+                ini_section_set_string(cat, temp, "shmswitch");
+                break;
             default:
                 break;
         }
@@ -2966,6 +3081,12 @@ save_network(void)
         else
             ini_section_set_int(cat, temp, net_cards_conf[c].promisc_mode);
 
+        sprintf(temp, "net_%02i_switch_framing", c + 1);
+        if ((nc->device_num == 0) || (nc->switch_framing == NET_SWITCH_FRAMING_PROTOBUF))
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, nc->switch_framing);
+
         sprintf(temp, "net_%02i_nrs_host", c + 1);
         if (nc->device_num == 0)
             ini_section_delete_var(cat, temp);
@@ -2975,6 +3096,24 @@ save_network(void)
             else
                 ini_section_delete_var(cat, temp);
         }
+
+        sprintf(temp, "net_%02i_queue_len", c + 1);
+        if ((nc->device_num == 0) || (nc->queue_len == NET_QUEUE_DEF_LEN))
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, nc->queue_len);
+
+        sprintf(temp, "net_%02i_rx_coalesce", c + 1);
+        if ((nc->device_num == 0) || (nc->rx_coalesce == 0))
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, nc->rx_coalesce);
+
+        sprintf(temp, "net_%02i_stats", c + 1);
+        if ((nc->device_num == 0) || (nc->stats == 0))
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, nc->stats);
     }
 
     ini_delete_section_if_empty(config, cat);
@@ -3361,6 +3500,21 @@ save_hard_disks(void)
     char          tmp2[512];
     char         *p;
 
+    if (hdd_image_mmap)
+        ini_section_set_int(cat, "image_mmap", hdd_image_mmap);
+    else
+        ini_section_delete_var(cat, "image_mmap");
+
+    if (hdd_image_cache_size)
+        ini_section_set_int(cat, "cache_size", hdd_image_cache_size);
+    else
+        ini_section_delete_var(cat, "cache_size");
+
+    if (hdd_image_cache_write_through)
+        ini_section_set_int(cat, "cache_write_through", hdd_image_cache_write_through);
+    else
+        ini_section_delete_var(cat, "cache_write_through");
+
     memset(temp, 0x00, sizeof(temp));
     for (uint8_t c = 0; c < HDD_NUM; c++) {
         sprintf(temp, "hdd_%02i_parameters", c + 1);
@@ -3430,6 +3584,12 @@ save_hard_disks(void)
         } else
             ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "hdd_%02i_overlay", c + 1);
+        if (hdd_is_valid(c) && hdd[c].overlay)
+            ini_section_set_int(cat, temp, hdd[c].overlay);
+        else
+            ini_section_delete_var(cat, temp);
+
         sprintf(temp, "hdd_%02i_speed", c + 1);
         if (!hdd_is_valid(c) ||
             ((hdd[c].bus_type != HDD_BUS_ESDI) && (hdd[c].bus_type != HDD_BUS_IDE) &&
@@ -3451,6 +3611,16 @@ save_floppy_and_cdrom_drives(void)
     char          tmp2[512];
     int           c;
 
+    if (cdrom_image_mmap)
+        ini_section_set_int(cat, "cdrom_image_mmap", cdrom_image_mmap);
+    else
+        ini_section_delete_var(cat, "cdrom_image_mmap");
+
+    if (cdrom_image_read_ahead == 256)
+        ini_section_delete_var(cat, "cdrom_image_read_ahead");
+    else
+        ini_section_set_int(cat, "cdrom_image_read_ahead", cdrom_image_read_ahead);
+
     for (c = 0; c < FDD_NUM; c++) {
         sprintf(temp, "fdd_%02i_type", c + 1);
         if (fdd_get_type(c) == ((c < 2) ? 2 : 0))
@@ -3700,12 +3870,112 @@ save_other_removable_devices(void)
     ini_delete_section_if_empty(config, cat);
 }
 
+static void
+config_write_init(void)
+{
+    if (config_write_mutex == NULL) {
+        config_write_mutex = thread_create_mutex();
+        config_io_mutex    = thread_create_mutex();
+    }
+}
+
+/* Snapshot the ini if anything in it changed since the last snapshot. */
+static void
+config_queue_write(ini_t ini, ini_t *pending)
+{
+    ini_t snap;
+
+    if ((ini == NULL) || !ini_is_dirty(ini))
+        return;
+
+    snap = ini_copy(ini);
+    ini_clear_dirty(ini);
+
+    thread_wait_mutex(config_write_mutex);
+    if (*pending != NULL)
+        ini_close(*pending);
+    *pending = snap;
+    thread_release_mutex(config_write_mutex);
+}
+
+/* Write out whatever is pending. The snapshots are taken with the I/O lock
+   held, so an older snapshot can never land on disk after a newer one. */
+static void
+config_write_pending(void)
+{
+    ini_t cfg;
+    ini_t glb;
+
+    thread_wait_mutex(config_io_mutex);
+
+    thread_wait_mutex(config_write_mutex);
+    cfg            = config_pending;
+    glb            = global_pending;
+    config_pending = NULL;
+    global_pending = NULL;
+    thread_release_mutex(config_write_mutex);
+
+    if (cfg != NULL) {
+        config_log("Writing VM config file '%s'...\n", cfg_path);
+        ini_write(cfg, cfg_path);
+        ini_close(cfg);
+    }
+
+    if (glb != NULL) {
+        config_log("Writing global config file '%s'...\n", global_cfg_path);
+        ini_write(glb, global_cfg_path);
+        ini_close(glb);
+    }
+
+    thread_release_mutex(config_io_mutex);
+}
+
+static void
+config_write_thread_func(UNUSED(void *priv))
+{
+    while (!config_write_quit) {
+        thread_wait_event(config_write_event, -1);
+        thread_reset_event(config_write_event);
+
+        /* Let a burst of saves (e.g. a script swapping media) settle into one write. */
+        for (int i = 0; (i < CONFIG_WRITE_MAX_WAIT) && !config_write_quit; i++) {
+            if (thread_wait_event(config_write_event, CONFIG_WRITE_DELAY))
+                break;
+            thread_reset_event(config_write_event);
+        }
+
+        config_write_pending();
+    }
+}
+
+/* Write any pending changes now and stop the writer thread; later saves are synchronous. */
+void
+config_flush(void)
+{
+    if (config_write_mutex == NULL)
+        return;
+
+    if (config_write_thread != NULL) {
+        config_write_quit = 1;
+        thread_set_event(config_write_event);
+        thread_wait(config_write_thread);
+        config_write_thread = NULL;
+
+        thread_destroy_event(config_write_event);
+        config_write_event = NULL;
+    }
+
+    config_write_pending();
+}
+
 void
 config_save_global(void)
 {
     save_global();                  /* Global */
 
-    ini_write(global, global_cfg_path);
+    config_write_init();
+    config_queue_write(global, &global_pending);
+    config_write_pending();
 }
 
 void
@@ -3730,10 +4000,21 @@ config_save(void)
     save_gl3_shaders();             /* GL3 Shaders */
 #endif
     save_keybinds();                /* Key bindings */
+    save_global();                  /* Global */
 
-    ini_write(config, cfg_path);
+    config_write_init();
+    config_queue_write(config, &config_pending);
+    config_queue_write(global, &global_pending);
 
-    config_save_global();
+    if ((config_write_thread == NULL) && !config_write_quit) {
+        config_write_event  = thread_create_event();
+        config_write_thread = thread_create(config_write_thread_func, NULL);
+    }
+
+    if (config_write_thread != NULL)
+        thread_set_event(config_write_event);
+    else
+        config_write_pending();
 }
 
 ini_t
@@ -29,6 +29,7 @@
 #include "x86seg.h"
 #include "386_common.h"
 #include "x86_flags.h"
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 #ifdef USE_DYNAREC
@@ -83,6 +84,8 @@ int smi_latched = 0;
 int smm_in_hlt  = 0;
 int smi_block   = 0;
 
+uint32_t smi_count = 0;
+
 int prefetch_prefixes = 0;
 int rf_flag_no_clear = 0;
 
@@ -1322,6 +1325,7 @@ enter_smm(int in_hlt)
 
     flags_rebuild();
     in_smm = 1;
+    smi_count++;
     smram_backup_all();
     smram_recalc_all(0);
 
@@ -1648,6 +1652,10 @@ x86_int_sw(int num)
 {
     uint32_t addr;
 
+    /* The BIOS is handing over to the boot loader. */
+    if ((num == 0x19) && turbo_boot)
+        pc_turbo_boot_end();
+
     flags_rebuild();
     cycles -= timing_int;
 
@@ -1696,6 +1704,9 @@ x86_int_sw_rm(int num)
     uint16_t new_pc;
     uint16_t new_cs;
 
+    if ((num == 0x19) && turbo_boot)
+        pc_turbo_boot_end();
+
     flags_rebuild();
     cycles -= timing_int;
 
@@ -2225,6 +2236,115 @@ nmi_raise(void)
     nmi = 1;
 }
 
+/* Architectural state for machine snapshots, taken between two CPU frames. */
+void
+cpu_save_state(snapshot_t *snap)
+{
+    uint32_t size = sizeof(cpu_state_t);
+
+    snapshot_write_var(snap, size);
+    snapshot_write_var(snap, cpu_state);
+    snapshot_write_var(snap, cpu_cur_status);
+    snapshot_write_var(snap, fpu_state);
+    snapshot_write_var(snap, use32);
+    snapshot_write_var(snap, stack32);
+    snapshot_write_var(snap, oldcpl);
+    snapshot_write_var(snap, cr2);
+    snapshot_write_var(snap, cr3);
+    snapshot_write_var(snap, cr4);
+    snapshot_write_var(snap, dr);
+    snapshot_write_var(snap, gdt);
+    snapshot_write_var(snap, ldt);
+    snapshot_write_var(snap, idt);
+    snapshot_write_var(snap, tr);
+    snapshot_write_var(snap, msr);
+    snapshot_write_var(snap, amd_efer);
+    snapshot_write_var(snap, star);
+    snapshot_write_var(snap, cs_msr);
+    snapshot_write_var(snap, esp_msr);
+    snapshot_write_var(snap, eip_msr);
+    snapshot_write_var(snap, ccr0);
+    snapshot_write_var(snap, ccr1);
+    snapshot_write_var(snap, ccr2);
+    snapshot_write_var(snap, ccr3);
+    snapshot_write_var(snap, ccr4);
+    snapshot_write_var(snap, ccr5);
+    snapshot_write_var(snap, ccr6);
+    snapshot_write_var(snap, ccr7);
+    snapshot_write_var(snap, cyrix);
+    snapshot_write_var(snap, nmi);
+    snapshot_write_var(snap, nmi_enable);
+    snapshot_write_var(snap, nmi_mask);
+    snapshot_write_var(snap, in_sys);
+    snapshot_write_var(snap, old_rammask);
+    snapshot_write_var(snap, smi_latched);
+    snapshot_write_var(snap, smm_in_hlt);
+    snapshot_write_var(snap, smi_block);
+    snapshot_write_var(snap, smi_count);
+}
+
+int
+cpu_load_state(snapshot_t *snap)
+{
+    uint32_t size;
+
+    /* The layout differs between builds, with and without the new recompiler. */
+    if (!snapshot_read_var(snap, size) || (size != sizeof(cpu_state_t))) {
+        pclog("Snapshot: CPU state was saved by a different build\n");
+        return 0;
+    }
+
+    snapshot_read_var(snap, cpu_state);
+    snapshot_read_var(snap, cpu_cur_status);
+    snapshot_read_var(snap, fpu_state);
+    snapshot_read_var(snap, use32);
+    snapshot_read_var(snap, stack32);
+    snapshot_read_var(snap, oldcpl);
+    snapshot_read_var(snap, cr2);
+    snapshot_read_var(snap, cr3);
+    snapshot_read_var(snap, cr4);
+    snapshot_read_var(snap, dr);
+    snapshot_read_var(snap, gdt);
+    snapshot_read_var(snap, ldt);
+    snapshot_read_var(snap, idt);
+    snapshot_read_var(snap, tr);
+    snapshot_read_var(snap, msr);
+    snapshot_read_var(snap, amd_efer);
+    snapshot_read_var(snap, star);
+    snapshot_read_var(snap, cs_msr);
+    snapshot_read_var(snap, esp_msr);
+    snapshot_read_var(snap, eip_msr);
+    snapshot_read_var(snap, ccr0);
+    snapshot_read_var(snap, ccr1);
+    snapshot_read_var(snap, ccr2);
+    snapshot_read_var(snap, ccr3);
+    snapshot_read_var(snap, ccr4);
+    snapshot_read_var(snap, ccr5);
+    snapshot_read_var(snap, ccr6);
+    snapshot_read_var(snap, ccr7);
+    snapshot_read_var(snap, cyrix);
+    snapshot_read_var(snap, nmi);
+    snapshot_read_var(snap, nmi_enable);
+    snapshot_read_var(snap, nmi_mask);
+    snapshot_read_var(snap, in_sys);
+    snapshot_read_var(snap, old_rammask);
+    snapshot_read_var(snap, smi_latched);
+    snapshot_read_var(snap, smm_in_hlt);
+    snapshot_read_var(snap, smi_block);
+    if (!snapshot_read_var(snap, smi_count))
+        return 0;
+
+    cpu_state.abrt = 0;
+
+    /* Translations and compiled blocks were made for the old contents. */
+    flushmmucache();
+#ifdef USE_DYNAREC
+    codegen_reset();
+#endif
+
+    return 1;
+}
+
 #ifndef USE_DYNAREC
 /* This is for compatibility with new x87 code. */
 void
@@ -237,6 +237,9 @@ fetch_ea_16_long(uint32_t rmdat)
 int32_t         cycles_main = 0;
 static int32_t  cycles_old  = 0;
 static uint64_t tsc_old     = 0;
+#    ifdef USE_NEW_DYNAREC
+static int      block_ran   = 0;
+#    endif
 
 #    ifdef USE_ACYCS
 int32_t acycs = 0;
@@ -328,6 +331,7 @@ exec386_dynarec_int(void)
             cpu_state.eflags &= ~(RF_FLAG);
 #    endif
             x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
+            cpu_instructions++;
         }
 
 #    ifndef USE_NEW_DYNAREC
@@ -415,6 +419,27 @@ exec386_dynarec_dyn(void)
            and physical address. The physical address check will
            also catch any page faults at this stage */
         valid_block = (block->pc == cs + cpu_state.pc) && (block->_cs == cs) && (block->phys == phys_addr) && !((block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) && ((block->status & cpu_cur_status & CPU_STATUS_MASK) == (cpu_cur_status & CPU_STATUS_MASK));
+#    ifdef USE_NEW_DYNAREC
+        if (valid_block)
+            codegen_stats.lookup_l1++;
+        else {
+            /* Try the second level before walking the page tree. On a hit the
+               block moves to the front, and the one it displaces goes to the
+               second level slot of its own address, which is the only one
+               delete_block() clears. */
+            int          hash_l2  = HASH_L2(phys_addr);
+            codeblock_t *block_l2 = &codeblock[codeblock_hash_l2[hash_l2]];
+
+            valid_block = (block_l2->pc == cs + cpu_state.pc) && (block_l2->_cs == cs) && (block_l2->phys == phys_addr) && !((block_l2->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) && ((block_l2->status & cpu_cur_status & CPU_STATUS_MASK) == (cpu_cur_status & CPU_STATUS_MASK));
+            if (valid_block) {
+                if (codeblock_hash[hash] != BLOCK_INVALID)
+                    codeblock_hash_l2[HASH_L2(codeblock[codeblock_hash[hash]].phys)] = codeblock_hash[hash];
+                codeblock_hash[hash] = get_block_nr(block_l2);
+                block                = block_l2;
+                codegen_stats.lookup_l2++;
+            }
+        }
+#    endif
         if (!valid_block) {
             uint64_t mask = (uint64_t) 1 << ((phys_addr >> PAGE_MASK_SHIFT) & PAGE_MASK_MASK);
 #    ifdef USE_NEW_DYNAREC
@@ -434,11 +459,18 @@ exec386_dynarec_dyn(void)
                     if (valid_block) {
                         block = new_block;
 #    ifdef USE_NEW_DYNAREC
+                        if (codeblock_hash[hash] != BLOCK_INVALID)
+                            codeblock_hash_l2[HASH_L2(codeblock[codeblock_hash[hash]].phys)] = codeblock_hash[hash];
                         codeblock_hash[hash] = get_block_nr(block);
+                        codegen_stats.lookup_tree++;
 #    endif
                     }
                 }
             }
+#    ifdef USE_NEW_DYNAREC
+            if (!valid_block)
+                codegen_stats.lookup_miss++;
+#    endif
         }
 
         if (valid_block && (block->page_mask & *block->dirty_mask)) {
@@ -492,8 +524,10 @@ exec386_dynarec_dyn(void)
             block->flags &= ~CODEBLOCK_WAS_RECOMPILED;
             if (block->flags & CODEBLOCK_BYTE_MASK)
                 block->flags |= CODEBLOCK_NO_IMMEDIATES;
-            else
+            else {
                 block->flags |= CODEBLOCK_BYTE_MASK;
+                codegen_stats.smc_byte_mask++;
+            }
         }
         if (valid_block && (block->flags & CODEBLOCK_WAS_RECOMPILED) && (block->flags & CODEBLOCK_STATIC_TOP) && block->TOP != (cpu_state.TOP & 7))
 #    else
@@ -521,13 +555,21 @@ exec386_dynarec_dyn(void)
 
 #    ifndef USE_NEW_DYNAREC
         codeblock_hash[hash] = block;
+#    endif
+#    ifdef USE_NEW_DYNAREC
+        block->flags |= CODEBLOCK_REFERENCED;
 #    endif
         inrecomp = 1;
         code();
+        /* Blocks left early by an abort are counted in full. */
+        cpu_instructions += block->ins;
 #    ifdef USE_ACYCS
         acycs = 0;
 #    endif
         inrecomp = 0;
+#    ifdef USE_NEW_DYNAREC
+        block_ran = 1;
+#    endif
 
 #    ifndef USE_NEW_DYNAREC
         if (!use32)
@@ -578,6 +620,7 @@ exec386_dynarec_dyn(void)
                 codegen_generate_call(opcode, x86_opcodes[(opcode | cpu_state.op32) & 0x3ff], fetchdat, cpu_state.pc, cpu_state.pc - 1);
 
                 x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
+                cpu_instructions++;
 
                 if (x86_was_reset)
                     break;
@@ -680,6 +723,7 @@ exec386_dynarec_dyn(void)
                 cpu_state.pc++;
 
                 x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
+                cpu_instructions++;
 
                 if (x86_was_reset)
                     break;
@@ -742,6 +786,41 @@ exec386_dynarec_dyn(void)
 #    endif
 }
 
+#    ifdef USE_NEW_DYNAREC
+/* Returns non-zero if the next block can be dispatched straight away, without
+   going back through the interrupt, abort and timer handling below. This is
+   only the case if none of those would have anything to do. */
+static __inline int
+exec386_dynarec_can_chain(void)
+{
+    uint64_t now;
+
+    if (!block_ran)
+        return 0;
+    block_ran = 0;
+
+    if (gdbstub_single_ins(cs + cpu_state.pc))
+        return 0;
+
+    if ((cycles <= 0) || cpu_state.abrt || cpu_init || new_ne || smi_line || cpu_end_block_after_ins)
+        return 0;
+    if ((nmi && nmi_enable && nmi_mask) || ((cpu_state.flags & I_FLAG) && pic.int_pending))
+        return 0;
+    if (!CACHE_ON() || cpu_override_dynarec)
+        return 0;
+
+    /* Same accounting as update_tsc(), without committing it. */
+    now = tsc_old + (uint64_t) (cycles_old - cycles);
+    if (tsc > now)
+        now = tsc;
+    if (TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) now))
+        return 0;
+
+    codegen_stats.chained++;
+    return 1;
+}
+#    endif
+
 void
 exec386_dynarec(int32_t cycs)
 {
@@ -753,7 +832,7 @@ exec386_dynarec(int32_t cycs)
     uint64_t oldtsc;
     uint64_t delta;
 
-    int32_t cyc_period = cycs / (force_10ms ? 2000 : 200); /*5us*/
+    int32_t cyc_period = (int32_t) (cpu_s->rspeed / 200000); /*5us*/
 
 #    ifdef USE_ACYCS
     acycs = 0;
@@ -778,11 +857,21 @@ exec386_dynarec(int32_t cycs)
             cycles_old       = cycles;
             oldtsc           = tsc;
             tsc_old          = tsc;
-            if ((!CACHE_ON()) || cpu_override_dynarec) /*Interpret block*/
+            if (gdbstub_single_ins(cs + cpu_state.pc)) {
+                /* Interpret a single instruction, for the debugger to look at. */
+                cpu_end_block_after_ins = 1;
+                exec386_dynarec_int();
+            } else if ((!CACHE_ON()) || cpu_override_dynarec) /*Interpret block*/
             {
                 exec386_dynarec_int();
             } else {
+#    ifdef USE_NEW_DYNAREC
+                do
+                    exec386_dynarec_dyn();
+                while (exec386_dynarec_can_chain());
+#    else
                 exec386_dynarec_dyn();
+#    endif
             }
 
             if (cpu_init) {
@@ -879,6 +968,16 @@ exec386_dynarec(int32_t cycs)
 }
 #endif
 
+/* Plain interpreter loop, used when the recompiler is disabled.
+
+   Instructions are dispatched through the x86_opcodes function tables rather
+   than through threaded code over pre-decoded pages. The tables are picked
+   per CPU by x86_setopcodes(), and each handler does its own ModR/M decoding,
+   so there is no separate decode step to cache. Fetches go through the
+   one-entry pccache. The page dirty masks that would be needed to invalidate
+   a decoded-instruction cache are only maintained for pages holding
+   recompiled code, so such a cache would need its own tracking on every
+   guest store. */
 void
 exec386(int32_t cycs)
 {
@@ -951,6 +1050,7 @@ exec386(int32_t cycs)
                 cpu_state.eflags &= ~(RF_FLAG);
 #endif
                 x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
+                cpu_instructions++;
                 if (x86_was_reset)
                     break;
             }
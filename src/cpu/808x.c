@@ -600,20 +600,29 @@ pfq_fetch(void)
         return (uint16_t) pfq_fetchb();
 }
 
-/* Adds bytes to the prefetch queue based on the instruction's cycle count. */
+/* Adds bytes to the prefetch queue based on the instruction's cycle count.
+   A fetch happens every time the BIU cycle counter wraps to 0, so rather
+   than stepping through every cycle, only the wrap points are visited. */
 static void
 pfq_add(int c, int add)
 {
     int d;
+    int old_pos;
 
     if ((c <= 0) || (pfq_pos >= pfq_size))
         return;
 
-    for (d = 0; d < c; d++) {
-        biu_cycles = (biu_cycles + 1) & 0x03;
-        if (prefetching && add && (biu_cycles == 0x00))
+    if (prefetching && add) {
+        for (d = 4 - biu_cycles; d <= c; d += 4) {
+            old_pos = pfq_pos;
             pfq_write();
+            /* Nothing drains the queue in here, so once it is full it stays full. */
+            if (pfq_pos == old_pos)
+                break;
+        }
     }
+
+    biu_cycles = (biu_cycles + c) & 0x03;
 }
 
 /* Clear the prefetch queue - called on reset and on anything that affects either CS or IP. */
@@ -3286,7 +3295,11 @@ execx86(int cycs)
                     break;
                 case 0xCD: /*INT*/
                     wait_cycs(1, 0);
-                    interrupt(pfq_fetchb());
+                    cpu_data = pfq_fetchb();
+                    /* The BIOS is handing over to the boot loader. */
+                    if ((cpu_data == 0x19) && turbo_boot)
+                        pc_turbo_boot_end();
+                    interrupt(cpu_data);
                     break;
                 case 0xCE: /*INTO*/
                     wait_cycs(3, 0);
@@ -3845,6 +3858,7 @@ execx86(int cycs)
         }
 exec_completed:
         if (completed) {
+            cpu_instructions++;
             repeating  = 0;
             ovr_seg    = NULL;
             in_rep     = 0;
@@ -51,6 +51,24 @@
 
 extern void codegen_init(void);
 extern void codegen_flush(void);
+#ifdef USE_NEW_DYNAREC
+/*Format the code cache statistics gathered since the previous call*/
+extern void codegen_stats_text(char *buf, int len);
+typedef struct codegen_totals_t {
+    uint64_t recompiles;
+    uint64_t evictions;
+    uint64_t uops;
+    uint64_t host_bytes;
+    uint64_t smc_invalidations;
+    uint64_t flushed;
+    uint64_t fallbacks;
+} codegen_totals_t;
+
+/*Code cache counters since startup*/
+extern void codegen_stats_totals(codegen_totals_t *totals);
+/*Log the code cache counters since startup*/
+extern void codegen_stats_dump(void);
+#endif
 
 /*Current physical page of block being recompiled. -1 if no recompilation taking place */
 extern uint32_t recomp_page;
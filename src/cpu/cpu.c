@@ -43,6 +43,7 @@
 #include <86box/smram.h>
 #include <86box/timer.h>
 #include <86box/gdbstub.h>
+#include <86box/hash.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
 
@@ -258,6 +259,7 @@ uint8_t  _cache[2048];
 
 uint64_t cpu_CR4_mask;
 uint64_t tsc = 0;
+uint64_t cpu_instructions = 0;
 
 double cpu_dmulti;
 double cpu_busspeed;
@@ -342,10 +344,56 @@ cpu_set_edx(void)
         SF_FPU_reset();
 }
 
+/* CPU families by internal name, open addressing, must be a power of 2. */
+#define CPU_FAMILY_INDEX_SIZE 512
+
+static uint16_t cpu_family_index[CPU_FAMILY_INDEX_SIZE]; /* family + 1, 0 = free */
+static int      cpu_family_index_built = 0;
+
+/* Built on first use; keeps the table order, so a duplicate name finds the first family. */
+static void
+cpu_family_index_build(void)
+{
+    uint32_t hash;
+    int      count = 0;
+
+    while (cpu_families[count].package)
+        count++;
+
+    if ((count * 2) > CPU_FAMILY_INDEX_SIZE) {
+        cpu_family_index_built = -1;
+        return;
+    }
+
+    for (int c = 0; c < count; c++) {
+        hash = name_hash(cpu_families[c].internal_name, SIZE_MAX);
+        while (cpu_family_index[hash & (CPU_FAMILY_INDEX_SIZE - 1)])
+            hash++;
+        cpu_family_index[hash & (CPU_FAMILY_INDEX_SIZE - 1)] = c + 1;
+    }
+
+    cpu_family_index_built = 1;
+}
+
 cpu_family_t *
 cpu_get_family(const char *internal_name)
 {
-    int c = 0;
+    uint32_t hash;
+    int      c = 0;
+
+    if (!cpu_family_index_built)
+        cpu_family_index_build();
+
+    if (cpu_family_index_built > 0) {
+        hash = name_hash(internal_name, SIZE_MAX);
+        while ((c = cpu_family_index[hash & (CPU_FAMILY_INDEX_SIZE - 1)])) {
+            if (!strcmp(internal_name, cpu_families[c - 1].internal_name))
+                return (cpu_family_t *) &cpu_families[c - 1];
+            hash++;
+        }
+
+        return NULL;
+    }
 
     while (cpu_families[c].package) {
         if (!strcmp(internal_name, cpu_families[c].internal_name))
@@ -1850,12 +1898,12 @@ cpu_set(void)
     cpu_use_exec = 0;
 
     if (is386) {
-#if defined(USE_DYNAREC) && !defined(USE_GDBSTUB)
+#ifdef USE_DYNAREC
         if (cpu_use_dynarec) {
             cpu_exec = exec386_dynarec;
             cpu_use_exec = 1;
         } else
-#endif /* defined(USE_DYNAREC) && !defined(USE_GDBSTUB) */
+#endif /* USE_DYNAREC */
             /* Use exec386 for CPU_IBM486SLC because it can reach 100 MHz. */
             if ((cpu_s->cpu_type == CPU_IBM486SLC) || (cpu_s->cpu_type == CPU_IBM486BL) ||
                 cpu_iscyrix || (cpu_s->cpu_type > CPU_486DLC) || cpu_override_interpreter) {
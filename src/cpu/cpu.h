@@ -552,6 +552,9 @@ extern int smi_latched;
 extern int smm_in_hlt;
 extern int smi_block;
 
+/* SMM entries since the last one-second stats report. */
+extern uint32_t smi_count;
+
 #ifdef USE_NEW_DYNAREC
 extern uint16_t cpu_cur_status;
 #else
@@ -559,6 +562,7 @@ extern uint32_t cpu_cur_status;
 #endif
 extern uint64_t cpu_CR4_mask;
 extern uint64_t tsc;
+extern uint64_t cpu_instructions; /* guest instructions executed, for pc_perf_t */
 extern msr_t    msr;
 extern uint8_t  opcode;
 extern int      cpl_override;
@@ -816,6 +820,16 @@ extern void cpu_fast_off_advance(void);
 extern void cpu_fast_off_period_set(uint16_t vla, double period);
 extern void cpu_fast_off_reset(void);
 
+struct snapshot_t;
+extern void cpu_save_state(struct snapshot_t *snap);
+extern int  cpu_load_state(struct snapshot_t *snap);
+
+extern int  cpu_prof;
+extern char cpu_prof_path[1024];
+extern char cpu_prof_syms_path[1024];
+extern void cpu_prof_init(void);
+extern void cpu_prof_dump(void);
+
 extern void smi_raise(void);
 extern void nmi_raise(void);
 
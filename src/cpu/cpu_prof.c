@@ -0,0 +1,454 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Sampling profiler for guest code: CS:EIP, CPL and mode are
+ *          recorded on an emulated-time timer and aggregated into a
+ *          histogram, written as a flat profile and as collapsed stacks.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include "x86.h"
+#include <86box/timer.h>
+#include <86box/plat.h>
+#include <86box/plat_unused.h>
+
+#define CPU_PROF_RATE     10000 /* samples per emulated second */
+#define CPU_PROF_MIN_SIZE 4096
+#define CPU_PROF_MAX_SIZE (1 << 22)
+
+enum {
+    CPU_PROF_REAL = 0,
+    CPU_PROF_V86,
+    CPU_PROF_PM16,
+    CPU_PROF_PM32,
+    CPU_PROF_SMM = 0x80
+};
+
+typedef struct cpu_prof_entry_t {
+    uint32_t linear;
+    uint32_t eip;
+    uint16_t sel;
+    uint8_t  mode;
+    uint8_t  cpl;
+    uint32_t sym; /* Index into cpu_prof_syms + 1, only valid while dumping. */
+    uint64_t count;
+} cpu_prof_entry_t;
+
+typedef struct cpu_prof_sym_t {
+    uint32_t addr;
+    char    *name;
+} cpu_prof_sym_t;
+
+int  cpu_prof = 0;
+char cpu_prof_path[1024];
+char cpu_prof_syms_path[1024];
+
+static pc_timer_t        cpu_prof_timer;
+static cpu_prof_entry_t *cpu_prof_table;
+static uint32_t          cpu_prof_size;
+static uint32_t          cpu_prof_used;
+static uint64_t          cpu_prof_samples;
+static uint64_t          cpu_prof_dropped;
+static cpu_prof_sym_t   *cpu_prof_syms;
+static uint32_t          cpu_prof_nsyms;
+static int               cpu_prof_syms_loaded;
+
+#ifdef ENABLE_CPU_PROF_LOG
+int cpu_prof_do_log = ENABLE_CPU_PROF_LOG;
+
+static void
+cpu_prof_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (cpu_prof_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define cpu_prof_log(fmt, ...)
+#endif
+
+static __inline uint32_t
+cpu_prof_hash(uint32_t linear, uint16_t sel, uint8_t mode, uint8_t cpl)
+{
+    uint32_t h = linear ^ ((uint32_t) sel << 16) ^ ((uint32_t) mode << 8) ^ cpl;
+
+    h ^= h >> 16;
+    h *= 0x7feb352d;
+    h ^= h >> 15;
+    h *= 0x846ca68b;
+    h ^= h >> 16;
+
+    return h;
+}
+
+static cpu_prof_entry_t *
+cpu_prof_find(cpu_prof_entry_t *table, uint32_t size, uint32_t linear, uint32_t eip, uint16_t sel, uint8_t mode, uint8_t cpl)
+{
+    uint32_t          mask = size - 1;
+    uint32_t          i    = cpu_prof_hash(linear, sel, mode, cpl) & mask;
+    cpu_prof_entry_t *ent;
+
+    for (;;) {
+        ent = &table[i];
+        if (!ent->count || ((ent->linear == linear) && (ent->eip == eip) && (ent->sel == sel) &&
+                            (ent->mode == mode) && (ent->cpl == cpl)))
+            return ent;
+        i = (i + 1) & mask;
+    }
+}
+
+static int
+cpu_prof_grow(void)
+{
+    cpu_prof_entry_t *table;
+    cpu_prof_entry_t *ent;
+    uint32_t          size = cpu_prof_size ? (cpu_prof_size << 1) : CPU_PROF_MIN_SIZE;
+
+    if (size > CPU_PROF_MAX_SIZE)
+        return 0;
+
+    table = (cpu_prof_entry_t *) calloc(size, sizeof(cpu_prof_entry_t));
+    if (table == NULL)
+        return 0;
+
+    for (uint32_t i = 0; i < cpu_prof_size; i++) {
+        if (cpu_prof_table[i].count) {
+            ent  = cpu_prof_find(table, size, cpu_prof_table[i].linear, cpu_prof_table[i].eip,
+                                 cpu_prof_table[i].sel, cpu_prof_table[i].mode, cpu_prof_table[i].cpl);
+            *ent = cpu_prof_table[i];
+        }
+    }
+
+    free(cpu_prof_table);
+    cpu_prof_table = table;
+    cpu_prof_size  = size;
+
+    return 1;
+}
+
+/* The timer fires from timer_process(), which the 386 interpreter calls between
+   instructions and the recompiler between blocks, so cpu_state.pc is the next
+   instruction to be executed; the 808x core runs timers on bus cycles, so its
+   samples may land inside the instruction being executed. */
+static void
+cpu_prof_sample(UNUSED(void *priv))
+{
+    cpu_prof_entry_t *ent;
+    uint32_t          eip  = cpu_state.pc;
+    uint32_t          linear;
+    uint16_t          sel  = CS;
+    uint8_t           mode = CPU_PROF_REAL;
+    uint8_t           cpl  = 0;
+
+    timer_advance_u64(&cpu_prof_timer, TIMER_USEC * (1000000 / CPU_PROF_RATE));
+
+    if (is386 && (cr0 & 1)) {
+        if (cpu_state.eflags & VM_FLAG) {
+            mode = CPU_PROF_V86;
+            cpl  = 3;
+        } else {
+            mode = (use32 ? CPU_PROF_PM32 : CPU_PROF_PM16);
+            cpl  = CPL;
+        }
+    } else if (is286 && (msw & 1)) {
+        mode = CPU_PROF_PM16;
+        cpl  = CPL;
+    }
+    if (is386 && in_smm)
+        mode |= CPU_PROF_SMM;
+
+    linear = cpu_state.seg_cs.base + eip;
+
+    cpu_prof_samples++;
+
+    if ((cpu_prof_used >= (cpu_prof_size >> 1)) && !cpu_prof_grow()) {
+        ent = cpu_prof_find(cpu_prof_table, cpu_prof_size, linear, eip, sel, mode, cpl);
+        if (!ent->count) {
+            /* Table is at its size limit, only count the existing entries. */
+            if (cpu_prof_used >= (cpu_prof_size - (cpu_prof_size >> 3))) {
+                cpu_prof_dropped++;
+                return;
+            }
+        }
+    } else
+        ent = cpu_prof_find(cpu_prof_table, cpu_prof_size, linear, eip, sel, mode, cpl);
+
+    if (!ent->count) {
+        ent->linear = linear;
+        ent->eip    = eip;
+        ent->sel    = sel;
+        ent->mode   = mode;
+        ent->cpl    = cpl;
+        cpu_prof_used++;
+    }
+    ent->count++;
+}
+
+static int
+cpu_prof_sym_compare(const void *a, const void *b)
+{
+    const cpu_prof_sym_t *sa = (const cpu_prof_sym_t *) a;
+    const cpu_prof_sym_t *sb = (const cpu_prof_sym_t *) b;
+
+    if (sa->addr == sb->addr)
+        return 0;
+
+    return (sa->addr < sb->addr) ? -1 : 1;
+}
+
+/* Accepts "nm" style lines ("address [type] name") with linear addresses in hex. */
+static void
+cpu_prof_load_syms(void)
+{
+    FILE     *fp;
+    char      line[512];
+    char      name[256];
+    char      type[16];
+    uint32_t  size = 0;
+    unsigned  addr;
+
+    cpu_prof_syms_loaded = 1;
+
+    if (cpu_prof_syms_path[0] == '\0')
+        return;
+
+    fp = plat_fopen(cpu_prof_syms_path, "r");
+    if (fp == NULL) {
+        pclog("CPU: Unable to read the profiler symbols from %s\n", cpu_prof_syms_path);
+        return;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "%x %15s %255s", &addr, type, name) != 3) {
+            if (sscanf(line, "%x %255s", &addr, name) != 2)
+                continue;
+        }
+
+        if (cpu_prof_nsyms == size) {
+            cpu_prof_sym_t *syms;
+
+            size = size ? (size << 1) : 256;
+            syms = (cpu_prof_sym_t *) realloc(cpu_prof_syms, size * sizeof(cpu_prof_sym_t));
+            if (syms == NULL)
+                break;
+            cpu_prof_syms = syms;
+        }
+
+        cpu_prof_syms[cpu_prof_nsyms].addr = (uint32_t) addr;
+        cpu_prof_syms[cpu_prof_nsyms].name = strdup(name);
+        cpu_prof_nsyms++;
+    }
+
+    fclose(fp);
+
+    if (cpu_prof_nsyms)
+        qsort(cpu_prof_syms, cpu_prof_nsyms, sizeof(cpu_prof_sym_t), cpu_prof_sym_compare);
+
+    cpu_prof_log("CPU: Loaded %u profiler symbols\n", cpu_prof_nsyms);
+}
+
+/* Returns the index + 1 of the closest symbol at or below addr, or 0. */
+static uint32_t
+cpu_prof_lookup(uint32_t addr)
+{
+    uint32_t lo = 0;
+    uint32_t hi = cpu_prof_nsyms;
+
+    while (lo < hi) {
+        uint32_t mid = lo + ((hi - lo) >> 1);
+
+        if (cpu_prof_syms[mid].addr <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static const char *
+cpu_prof_mode_name(uint8_t mode)
+{
+    static const char *names[4] = { "real", "v86", "pm16", "pm32" };
+
+    return names[mode & 3];
+}
+
+static void
+cpu_prof_frame(const cpu_prof_entry_t *ent, char *buf, size_t len)
+{
+    if (ent->sym)
+        snprintf(buf, len, "%s", cpu_prof_syms[ent->sym - 1].name);
+    else
+        snprintf(buf, len, "%04X:%08X", ent->sel, ent->eip);
+}
+
+static int
+cpu_prof_count_compare(const void *a, const void *b)
+{
+    const cpu_prof_entry_t *pa = (const cpu_prof_entry_t *) a;
+    const cpu_prof_entry_t *pb = (const cpu_prof_entry_t *) b;
+
+    if (pa->count == pb->count)
+        return (pa->linear < pb->linear) ? -1 : (pa->linear > pb->linear);
+
+    return (pa->count < pb->count) ? 1 : -1;
+}
+
+/* Orders entries so that those sharing a collapsed stack are adjacent. */
+static int
+cpu_prof_stack_compare(const void *a, const void *b)
+{
+    const cpu_prof_entry_t *pa = (const cpu_prof_entry_t *) a;
+    const cpu_prof_entry_t *pb = (const cpu_prof_entry_t *) b;
+
+    if (pa->mode != pb->mode)
+        return (pa->mode < pb->mode) ? -1 : 1;
+    if (pa->cpl != pb->cpl)
+        return (pa->cpl < pb->cpl) ? -1 : 1;
+    if (pa->sym != pb->sym)
+        return (pa->sym < pb->sym) ? -1 : 1;
+    if (pa->sym)
+        return 0;
+    if (pa->sel != pb->sel)
+        return (pa->sel < pb->sel) ? -1 : 1;
+    if (pa->eip != pb->eip)
+        return (pa->eip < pb->eip) ? -1 : 1;
+
+    return 0;
+}
+
+static void
+cpu_prof_write_folded(cpu_prof_entry_t *sorted, uint32_t count)
+{
+    FILE    *fp;
+    char     fn[1040];
+    char     frame[288];
+    uint64_t total;
+
+    snprintf(fn, sizeof(fn), "%s.folded", cpu_prof_path);
+    fp = plat_fopen(fn, "w");
+    if (fp == NULL) {
+        pclog("CPU: Unable to write the collapsed profile to %s\n", fn);
+        return;
+    }
+
+    qsort(sorted, count, sizeof(cpu_prof_entry_t), cpu_prof_stack_compare);
+
+    /* There is no guest unwinder, so each stack is mode;ring;location. */
+    for (uint32_t i = 0; i < count;) {
+        uint32_t j = i + 1;
+
+        total = sorted[i].count;
+        while ((j < count) && !cpu_prof_stack_compare(&sorted[i], &sorted[j]))
+            total += sorted[j++].count;
+
+        cpu_prof_frame(&sorted[i], frame, sizeof(frame));
+        fprintf(fp, "%s%s;ring%u;%s %" PRIu64 "\n", (sorted[i].mode & CPU_PROF_SMM) ? "smm;" : "",
+                cpu_prof_mode_name(sorted[i].mode), sorted[i].cpl, frame, total);
+        i = j;
+    }
+
+    fclose(fp);
+}
+
+void
+cpu_prof_dump(void)
+{
+    cpu_prof_entry_t *sorted;
+    FILE             *fp;
+    char              frame[288];
+    uint32_t          count = 0;
+
+    if (!cpu_prof || !cpu_prof_samples)
+        return;
+
+    if (!cpu_prof_syms_loaded)
+        cpu_prof_load_syms();
+
+    sorted = (cpu_prof_entry_t *) malloc(cpu_prof_used * sizeof(cpu_prof_entry_t));
+    if (sorted == NULL)
+        return;
+
+    for (uint32_t i = 0; i < cpu_prof_size; i++) {
+        if (cpu_prof_table[i].count) {
+            sorted[count]     = cpu_prof_table[i];
+            sorted[count].sym = cpu_prof_nsyms ? cpu_prof_lookup(sorted[count].linear) : 0;
+            count++;
+        }
+    }
+    qsort(sorted, count, sizeof(cpu_prof_entry_t), cpu_prof_count_compare);
+
+    fp = plat_fopen(cpu_prof_path, "w");
+    if (fp == NULL) {
+        pclog("CPU: Unable to write the execution profile to %s\n", cpu_prof_path);
+        free(sorted);
+        return;
+    }
+
+    fprintf(fp, "# %" PRIu64 " samples at %u Hz, %u locations, %" PRIu64 " dropped\n",
+            cpu_prof_samples, CPU_PROF_RATE, count, cpu_prof_dropped);
+    fprintf(fp, "# %12s %7s %-8s %-13s %-8s %4s  %s\n", "samples", "%", "linear", "cs:eip", "mode", "cpl", "symbol");
+    for (uint32_t i = 0; i < count; i++) {
+        const cpu_prof_entry_t *ent = &sorted[i];
+
+        if (ent->sym)
+            snprintf(frame, sizeof(frame), "%s+0x%x", cpu_prof_syms[ent->sym - 1].name,
+                     ent->linear - cpu_prof_syms[ent->sym - 1].addr);
+        else
+            frame[0] = '\0';
+
+        fprintf(fp, "  %12" PRIu64 " %6.2f%% %08X %04X:%08X %-3s%-5s %4u  %s\n", ent->count,
+                ((double) ent->count * 100.0) / (double) cpu_prof_samples, ent->linear, ent->sel, ent->eip,
+                (ent->mode & CPU_PROF_SMM) ? "smm" : "", cpu_prof_mode_name(ent->mode), ent->cpl, frame);
+    }
+
+    fclose(fp);
+
+    cpu_prof_write_folded(sorted, count);
+
+    free(sorted);
+
+    memset(cpu_prof_table, 0x00, cpu_prof_size * sizeof(cpu_prof_entry_t));
+    cpu_prof_used    = 0;
+    cpu_prof_samples = 0;
+    cpu_prof_dropped = 0;
+}
+
+/* Called on hard reset, once the timer subsystem is back up. */
+void
+cpu_prof_init(void)
+{
+    if (!cpu_prof)
+        return;
+
+    if (cpu_prof_table == NULL)
+        (void) cpu_prof_grow();
+
+    if (cpu_prof_table == NULL) {
+        cpu_prof = 0;
+        return;
+    }
+
+    timer_add(&cpu_prof_timer, cpu_prof_sample, NULL, 0);
+    timer_on_auto(&cpu_prof_timer, 1000000.0 / CPU_PROF_RATE);
+}
@@ -70,6 +70,10 @@ FPU fpus_internal[] = {
     { .name = NULL,       .internal_name = NULL,       .type = 0            }
 };
 
+/* CPU_SUPPORTS_DYNAREC only goes on CPUs the recompiler can time: its blocks
+   are timed as on a 486 or later, and it assumes 32-bit registers and the
+   0x66/0x67 prefixes. The 808x, 286 and 386 families therefore always run
+   on the interpreter. */
 const cpu_family_t cpu_families[] = {
   // clang-format off
     {
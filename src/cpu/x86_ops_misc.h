@@ -700,6 +700,24 @@ opF7_l_a32(uint32_t fetchdat)
     return 0;
 }
 
+/* Cycles to burn per HLT iteration. Nothing but a timer callback can raise an
+   interrupt while the CPU is halted, so with fast-forwarding enabled, skip
+   straight to the next timer deadline, bounded by the cycles left to run. */
+static __inline int32_t
+hlt_cycles(void)
+{
+    int32_t skip;
+
+    if (!hlt_fast_forward)
+        return 100;
+
+    skip = (int32_t) (timer_target - (uint32_t) tsc) + 1;
+    if (skip > cycles)
+        skip = cycles;
+
+    return (skip > 100) ? skip : 100;
+}
+
 static int
 opHLT(UNUSED(uint32_t fetchdat))
 {
@@ -710,7 +728,7 @@ opHLT(UNUSED(uint32_t fetchdat))
     if (smi_line)
         enter_smm_check(1);
     else if (!((cpu_state.flags & I_FLAG) && pic.int_pending)) {
-        CLOCK_CYCLES_ALWAYS(100);
+        CLOCK_CYCLES_ALWAYS(hlt_cycles());
         if (!((cpu_state.flags & I_FLAG) && pic.int_pending))
             cpu_state.pc--;
     } else {
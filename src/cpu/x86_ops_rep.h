@@ -2,10 +2,13 @@
     static int opREP_INSB_##size(UNUSED(uint32_t fetchdat))                                                       \
     {                                                                                                             \
         int reads = 0, writes = 0, total_cycles = 0;                                                              \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
                                                                                                                   \
         addr64 = 0x00000000;                                                                                      \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint8_t temp;                                                                                         \
                                                                                                                   \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
@@ -29,6 +32,8 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 15;                                                                                   \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -41,10 +46,13 @@
     static int opREP_INSW_##size(UNUSED(uint32_t fetchdat))                                                       \
     {                                                                                                             \
         int reads = 0, writes = 0, total_cycles = 0;                                                              \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
                                                                                                                   \
         addr64a[0] = addr64a[1] = 0x00000000;                                                                     \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint16_t temp;                                                                                        \
                                                                                                                   \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
@@ -68,6 +76,8 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 15;                                                                                   \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -80,10 +90,13 @@
     static int opREP_INSL_##size(UNUSED(uint32_t fetchdat))                                                       \
     {                                                                                                             \
         int reads = 0, writes = 0, total_cycles = 0;                                                              \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
                                                                                                                   \
         addr64a[0] = addr64a[1] = addr64a[2] = addr64a[3] = 0x00000000;                                           \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint32_t temp;                                                                                        \
                                                                                                                   \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
@@ -107,6 +120,8 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 15;                                                                                   \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, 0, reads, 0, writes, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -120,8 +135,11 @@
     static int opREP_OUTSB_##size(UNUSED(uint32_t fetchdat))                                                      \
     {                                                                                                             \
         int reads = 0, writes = 0, total_cycles = 0;                                                              \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint8_t temp;                                                                                         \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
             CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG);                                                       \
@@ -139,6 +157,8 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 14;                                                                                   \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -151,8 +171,11 @@
     static int opREP_OUTSW_##size(UNUSED(uint32_t fetchdat))                                                      \
     {                                                                                                             \
         int reads = 0, writes = 0, total_cycles = 0;                                                              \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint16_t temp;                                                                                        \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
             CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG + 1UL);                                                 \
@@ -170,6 +193,8 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 14;                                                                                   \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -182,8 +207,11 @@
     static int opREP_OUTSL_##size(UNUSED(uint32_t fetchdat))                                                      \
     {                                                                                                             \
         int reads = 0, writes = 0, total_cycles = 0;                                                              \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint32_t temp;                                                                                        \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
             CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG + 3UL);                                                 \
@@ -201,6 +229,8 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 14;                                                                                   \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, 0, reads, 0, writes, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
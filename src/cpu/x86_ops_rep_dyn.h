@@ -1,9 +1,12 @@
 #define REP_OPS(size, CNT_REG, SRC_REG, DEST_REG)                                                                 \
     static int opREP_INSB_##size(UNUSED(uint32_t fetchdat))                                                       \
     {                                                                                                             \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
         addr64 = 0x00000000;                                                                                      \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint8_t temp;                                                                                         \
                                                                                                                   \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
@@ -24,6 +27,8 @@
                 DEST_REG++;                                                                                       \
             CNT_REG--;                                                                                            \
             cycles -= 15;                                                                                         \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -34,9 +39,12 @@
     }                                                                                                             \
     static int opREP_INSW_##size(UNUSED(uint32_t fetchdat))                                                       \
     {                                                                                                             \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
         addr64a[0] = addr64a[1] = 0x00000000;                                                                     \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint16_t temp;                                                                                        \
                                                                                                                   \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
@@ -57,6 +65,8 @@
                 DEST_REG += 2;                                                                                    \
             CNT_REG--;                                                                                            \
             cycles -= 15;                                                                                         \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -67,9 +77,12 @@
     }                                                                                                             \
     static int opREP_INSL_##size(UNUSED(uint32_t fetchdat))                                                       \
     {                                                                                                             \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
         addr64a[0] = addr64a[1] = addr64a[2] = addr64a[3] = 0x00000000;                                           \
                                                                                                                   \
-        if (CNT_REG > 0) {                                                                                        \
+        while (CNT_REG > 0) {                                                                                     \
             uint32_t temp;                                                                                        \
                                                                                                                   \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
@@ -90,6 +103,8 @@
                 DEST_REG += 4;                                                                                    \
             CNT_REG--;                                                                                            \
             cycles -= 15;                                                                                         \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -101,7 +116,10 @@
                                                                                                                   \
     static int opREP_OUTSB_##size(UNUSED(uint32_t fetchdat))                                                      \
     {                                                                                                             \
-        if (CNT_REG > 0) {                                                                                        \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
+        while (CNT_REG > 0) {                                                                                     \
             uint8_t temp;                                                                                         \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
             CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG);                                                       \
@@ -116,6 +134,8 @@
                 SRC_REG++;                                                                                        \
             CNT_REG--;                                                                                            \
             cycles -= 14;                                                                                         \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -126,7 +146,10 @@
     }                                                                                                             \
     static int opREP_OUTSW_##size(UNUSED(uint32_t fetchdat))                                                      \
     {                                                                                                             \
-        if (CNT_REG > 0) {                                                                                        \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
+        while (CNT_REG > 0) {                                                                                     \
             uint16_t temp;                                                                                        \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
             CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG + 1UL);                                                 \
@@ -141,6 +164,8 @@
                 SRC_REG += 2;                                                                                     \
             CNT_REG--;                                                                                            \
             cycles -= 14;                                                                                         \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -151,7 +176,10 @@
     }                                                                                                             \
     static int opREP_OUTSL_##size(UNUSED(uint32_t fetchdat))                                                      \
     {                                                                                                             \
-        if (CNT_REG > 0) {                                                                                        \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);                                      \
+        if (trap)                                                                                                 \
+            cycles_end = cycles + 1; /*Force the instruction to end after only one iteration when trap flag set*/ \
+        while (CNT_REG > 0) {                                                                                     \
             uint32_t temp;                                                                                        \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
             CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG + 3UL);                                                 \
@@ -166,6 +194,8 @@
                 SRC_REG += 4;                                                                                     \
             CNT_REG--;                                                                                            \
             cycles -= 14;                                                                                         \
+            if (smi_line || (cycles < cycles_end))                                                                \
+                break;                                                                                            \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -432,10 +432,15 @@ loadseg(uint16_t seg, x86seg *s)
         s->seg = seg;
         do_seg_load(s, segdat);
 
-        cpl_override = 1;
-        writememw(0, addr + 4, segdat[2] | 0x100); /* Set accessed bit */
-        cpl_override = 0;
-        s->checked   = 0;
+        /* Only write the descriptor back if the accessed bit is not yet set,
+           as the processor does; segment registers get reloaded constantly,
+           and the accessed bit is nearly always already set. */
+        if (!(segdat[2] & 0x0100)) {
+            cpl_override = 1;
+            writememw(0, addr + 4, segdat[2] | 0x100); /* Set accessed bit */
+            cpl_override = 0;
+        }
+        s->checked = 0;
 #ifdef USE_DYNAREC
         if (s == &cpu_state.seg_ds)
             codegen_flat_ds = 0;
@@ -2286,7 +2291,7 @@ taskswitch286(uint16_t seg, uint16_t *segdat, int is32)
         cr0 |= 8;
 
         cr3 = new_cr3;
-        flushmmucache();
+        flushmmucache_cr3();
 
         cpu_state.pc     = new_pc;
         cpu_state.flags  = new_flags;
@@ -1,3 +1,99 @@
+/* On x86 hosts the host x87 can do ADD, SUB, MUL and DIV on normal operands
+   with the guest's precision and rounding control and give the very same
+   result and flags as softfloat. Anything that raises more than a precision
+   exception, or produces a denormal, is redone in softfloat. */
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+#    define X87_SF_HOST_FAST
+
+static __inline int
+x87_sf_host_operand(floatx80 a)
+{
+    uint16_t exp = a.signExp & 0x7fff;
+
+    if (!exp)
+        return !a.signif;
+
+    return (exp != 0x7fff) && (a.signif >> 63);
+}
+
+static __inline uint16_t
+x87_sf_host_cw(const struct softfloat_status_t *status)
+{
+    uint16_t cw = 0x0040 | FPU_CW_Exceptions_Mask | (status->softfloat_roundingMode << 10);
+
+    if (status->extF80_roundingPrecision == 64)
+        cw |= FPU_PR_64_BITS;
+    else if (status->extF80_roundingPrecision == 80)
+        cw |= FPU_PR_80_BITS;
+
+    return cw;
+}
+
+/* Computes st(0) op st(1) with a in st(0) and b in st(1). */
+#    define X87_SF_HOST_OP(name, insn)                                                                     \
+        static __inline int                                                                                \
+        x87_sf_host_##name(floatx80 a, floatx80 b, floatx80 *r, struct softfloat_status_t *status)         \
+        {                                                                                                  \
+            uint16_t cw = x87_sf_host_cw(status);                                                          \
+            uint16_t old_cw;                                                                               \
+            uint16_t sw;                                                                                   \
+                                                                                                           \
+            if (!x87_sf_host_operand(a) || !x87_sf_host_operand(b))                                        \
+                return 0;                                                                                  \
+                                                                                                           \
+            __asm__ volatile("fnstcw %[old_cw]\n\t"                                                        \
+                             "fldcw %[cw]\n\t"                                                             \
+                             "fnclex\n\t"                                                                  \
+                             "fldt %[b]\n\t"                                                               \
+                             "fldt %[a]\n\t" insn " %%st(1), %%st\n\t"                                    \
+                             "fnstsw %[sw]\n\t"                                                            \
+                             "fstpt %[r]\n\t"                                                              \
+                             "fstp %%st(0)\n\t"                                                            \
+                             "fldcw %[old_cw]\n\t"                                                         \
+                             : [r] "=m"(*r), [sw] "=m"(sw), [old_cw] "=m"(old_cw)                          \
+                             : [a] "m"(a), [b] "m"(b), [cw] "m"(cw)                                        \
+                             : "st", "st(1)");                                                             \
+                                                                                                           \
+            if ((sw & (softfloat_all_exceptions_mask & ~softfloat_flag_inexact)) ||                        \
+                (!(r->signExp & 0x7fff) && r->signif))                                                     \
+                return 0;                                                                                  \
+                                                                                                           \
+            status->softfloat_exceptionFlags |= sw & (softfloat_flag_inexact | RAISE_SW_C1);               \
+            return 1;                                                                                      \
+        }
+
+X87_SF_HOST_OP(add, "fadd")
+X87_SF_HOST_OP(sub, "fsub")
+X87_SF_HOST_OP(mul, "fmul")
+X87_SF_HOST_OP(div, "fdiv")
+#endif
+
+#ifdef X87_SF_HOST_FAST
+#    define X87_SF_OP(name)                                                               \
+        static __inline floatx80                                                          \
+        x87_sf_##name(floatx80 a, floatx80 b, struct softfloat_status_t *status)          \
+        {                                                                                 \
+            floatx80 r;                                                                   \
+                                                                                          \
+            if (x87_sf_host_##name(a, b, &r, status))                                     \
+                return r;                                                                 \
+                                                                                          \
+            return extF80_##name(a, b, status);                                           \
+        }
+#else
+#    define X87_SF_OP(name)                                                               \
+        static __inline floatx80                                                          \
+        x87_sf_##name(floatx80 a, floatx80 b, struct softfloat_status_t *status)          \
+        {                                                                                 \
+            return extF80_##name(a, b, status);                                           \
+        }
+#endif
+
+X87_SF_OP(add)
+X87_SF_OP(sub)
+X87_SF_OP(mul)
+X87_SF_OP(div)
+
 #define sf_FPU(name, optype, a_size, load_var, rw, use_var, is_nan, cycle_postfix)                                                                 \
     static int sf_FADD##name##_a##a_size(uint32_t fetchdat)                                                                                        \
     {                                                                                                                                              \
@@ -19,7 +115,7 @@
         status = i387cw_to_softfloat_status_word(i387_get_control_word());                                                                         \
         a      = FPU_read_regi(0);                                                                                                                 \
         if (!is_nan)                                                                                                                               \
-            result = extF80_add(a, use_var, &status);                                                                                              \
+            result = x87_sf_add(a, use_var, &status);                                                                                              \
                                                                                                                                                    \
         if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))                                                                          \
             FPU_save_regi(result, 0);                                                                                                              \
@@ -49,7 +145,7 @@ next_ins:
         status = i387cw_to_softfloat_status_word(i387_get_control_word());                                                                         \
         a      = FPU_read_regi(0);                                                                                                                 \
         if (!is_nan) {                                                                                                                             \
-            result = extF80_div(a, use_var, &status);                                                                                              \
+            result = x87_sf_div(a, use_var, &status);                                                                                              \
         }                                                                                                                                          \
         if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))                                                                          \
             FPU_save_regi(result, 0);                                                                                                              \
@@ -79,7 +175,7 @@ next_ins:
         status = i387cw_to_softfloat_status_word(i387_get_control_word());                                                                         \
         a      = FPU_read_regi(0);                                                                                                                 \
         if (!is_nan) {                                                                                                                             \
-            result = extF80_div(use_var, a, &status);                                                                                              \
+            result = x87_sf_div(use_var, a, &status);                                                                                              \
         }                                                                                                                                          \
         if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))                                                                          \
             FPU_save_regi(result, 0);                                                                                                              \
@@ -109,7 +205,7 @@ next_ins:
         status = i387cw_to_softfloat_status_word(i387_get_control_word());                                                                         \
         a      = FPU_read_regi(0);                                                                                                                 \
         if (!is_nan) {                                                                                                                             \
-            result = extF80_mul(a, use_var, &status);                                                                                              \
+            result = x87_sf_mul(a, use_var, &status);                                                                                              \
         }                                                                                                                                          \
         if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))                                                                          \
             FPU_save_regi(result, 0);                                                                                                              \
@@ -139,7 +235,7 @@ next_ins:
         status = i387cw_to_softfloat_status_word(i387_get_control_word());                                                                         \
         a      = FPU_read_regi(0);                                                                                                                 \
         if (!is_nan)                                                                                                                               \
-            result = extF80_sub(a, use_var, &status);                                                                                              \
+            result = x87_sf_sub(a, use_var, &status);                                                                                              \
                                                                                                                                                    \
         if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))                                                                          \
             FPU_save_regi(result, 0);                                                                                                              \
@@ -169,7 +265,7 @@ next_ins:
         status = i387cw_to_softfloat_status_word(i387_get_control_word());                                                                         \
         a      = FPU_read_regi(0);                                                                                                                 \
         if (!is_nan)                                                                                                                               \
-            result = extF80_sub(use_var, a, &status);                                                                                              \
+            result = x87_sf_sub(use_var, a, &status);                                                                                              \
                                                                                                                                                    \
         if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))                                                                          \
             FPU_save_regi(result, 0);                                                                                                              \
@@ -218,7 +314,7 @@ static int sf_FADD_st0_stj(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_add(a, b, &status);
+    result = x87_sf_add(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))
         FPU_save_regi(result, 0);
@@ -247,7 +343,7 @@ sf_FADD_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_add(a, b, &status);
+    result = x87_sf_add(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))
         FPU_save_regi(result, fetchdat & 7);
@@ -277,7 +373,7 @@ sf_FADDP_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_add(a, b, &status);
+    result = x87_sf_add(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
@@ -309,7 +405,7 @@ sf_FDIV_st0_stj(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_div(a, b, &status);
+    result = x87_sf_div(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))
         FPU_save_regi(result, 0);
@@ -339,7 +435,7 @@ sf_FDIV_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_div(a, b, &status);
+    result = x87_sf_div(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))
         FPU_save_regi(result, fetchdat & 7);
@@ -368,7 +464,7 @@ sf_FDIVP_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_div(a, b, &status);
+    result = x87_sf_div(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
@@ -400,7 +496,7 @@ sf_FDIVR_st0_stj(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_div(a, b, &status);
+    result = x87_sf_div(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))
         FPU_save_regi(result, 0);
@@ -429,7 +525,7 @@ sf_FDIVR_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_div(a, b, &status);
+    result = x87_sf_div(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0))
         FPU_save_regi(result, fetchdat & 7);
@@ -458,7 +554,7 @@ sf_FDIVRP_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_div(a, b, &status);
+    result = x87_sf_div(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
@@ -490,7 +586,7 @@ sf_FMUL_st0_stj(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_mul(a, b, &status);
+    result = x87_sf_mul(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, 0);
@@ -520,7 +616,7 @@ sf_FMUL_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_mul(a, b, &status);
+    result = x87_sf_mul(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
@@ -550,7 +646,7 @@ sf_FMULP_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_mul(a, b, &status);
+    result = x87_sf_mul(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
@@ -582,7 +678,7 @@ sf_FSUB_st0_stj(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_sub(a, b, &status);
+    result = x87_sf_sub(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, 0);
@@ -612,7 +708,7 @@ sf_FSUB_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_sub(a, b, &status);
+    result = x87_sf_sub(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
@@ -642,7 +738,7 @@ sf_FSUBP_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_sub(a, b, &status);
+    result = x87_sf_sub(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
@@ -674,7 +770,7 @@ sf_FSUBR_st0_stj(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(fetchdat & 7);
     b      = FPU_read_regi(0);
-    result = extF80_sub(a, b, &status);
+    result = x87_sf_sub(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, 0);
@@ -704,7 +800,7 @@ sf_FSUBR_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_sub(a, b, &status);
+    result = x87_sf_sub(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
@@ -734,7 +830,7 @@ sf_FSUBRP_sti_st0(uint32_t fetchdat)
     status = i387cw_to_softfloat_status_word(i387_get_control_word());
     a      = FPU_read_regi(0);
     b      = FPU_read_regi(fetchdat & 7);
-    result = extF80_sub(a, b, &status);
+    result = x87_sf_sub(a, b, &status);
 
     if (!FPU_exception(fetchdat, status.softfloat_exceptionFlags, 0)) {
         FPU_save_regi(result, fetchdat & 7);
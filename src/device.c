@@ -49,20 +49,32 @@
 #include <86box/ini.h>
 #include <86box/config.h>
 #include <86box/device.h>
+#include <86box/device_prof.h>
 #include <86box/machine.h>
 #include <86box/mem.h>
 #include <86box/plat.h>
 #include <86box/rom.h>
+#include <86box/snapshot.h>
 #include <86box/sound.h>
+#include <86box/thread.h>
 #include <86box/ui.h>
 
-#define DEVICE_MAX 256 /* max # of devices */
+#define DEVICE_MAX       256 /* max # of devices */
+#define DEVICE_ASYNC_MAX 16  /* max # of init jobs running at once */
+
+typedef struct device_async_t {
+    void (*func)(void *priv);
+    void     *priv;
+    thread_t *thread;
+} device_async_t;
 
 static device_t        *devices[DEVICE_MAX];
 static void            *device_priv[DEVICE_MAX];
 static device_context_t device_current;
 static device_context_t device_prev;
 static void            *device_common_priv;
+static device_async_t   device_async[DEVICE_ASYNC_MAX];
+static int              device_async_count;
 
 #ifdef ENABLE_DEVICE_LOG
 int device_do_log = ENABLE_DEVICE_LOG;
@@ -89,6 +101,57 @@ device_init(void)
     memset(devices, 0x00, sizeof(devices));
 }
 
+static void
+device_async_thread(void *priv)
+{
+    const device_async_t *job      = (device_async_t *) priv;
+    uint64_t              start_ns = device_profile ? plat_get_nsecs() : 0;
+
+    job->func(job->priv);
+
+    if (device_profile)
+        device_prof_add(job->priv, DEVICE_PROF_WORKER, start_ns);
+}
+
+/*
+ * Run part of a device's initialization on a worker thread. The work is
+ * only guaranteed to be done after device_init_wait(), which is called
+ * before the machine starts running and before any device is closed, so
+ * it must not be needed by the device's reset handler nor touch anything
+ * but the device's own data.
+ */
+void
+device_init_async(void (*func)(void *priv), void *priv)
+{
+    device_async_t *job;
+
+    if (device_async_count == DEVICE_ASYNC_MAX) {
+        func(priv);
+        return;
+    }
+
+    job         = &device_async[device_async_count];
+    job->func   = func;
+    job->priv   = priv;
+    job->thread = thread_create_named(device_async_thread, job, "Device init");
+    if (job->thread == NULL) {
+        func(priv);
+        return;
+    }
+
+    device_async_count++;
+}
+
+/* Wait for all the initialization work queued by devices. */
+void
+device_init_wait(void)
+{
+    for (int i = 0; i < device_async_count; i++)
+        thread_wait(device_async[i].thread);
+
+    device_async_count = 0;
+}
+
 void
 device_set_context(device_context_t *ctx, const device_t *dev, int inst)
 {
@@ -324,6 +387,8 @@ device_get_common_priv(void)
 void
 device_close_all(void)
 {
+    device_init_wait();
+
     for (int16_t c = (DEVICE_MAX - 1); c >= 0; c--) {
         if (devices[c] != NULL) {
 #ifdef ENABLE_DEVICE_LOG
@@ -336,6 +401,10 @@ device_close_all(void)
             device_priv[c] = NULL;
         }
     }
+
+    /* The private data pointers are gone, don't let new devices inherit their time. */
+    if (device_profile)
+        device_prof_reset();
 }
 
 void
@@ -349,6 +418,121 @@ device_reset_all(uint32_t match_flags)
     }
 }
 
+static const char *
+device_snapshot_name(const device_t *dev)
+{
+    if (dev->internal_name != NULL)
+        return dev->internal_name;
+
+    return (dev->name != NULL) ? dev->name : "";
+}
+
+/* Returns 1 if every active device can have its state saved, otherwise
+   logs the ones that cannot, lists them in missing if given, and returns 0. */
+int
+device_snapshot_supported(char *missing, size_t size)
+{
+    const char *name;
+    size_t      len = 0;
+    int         ret = 1;
+
+    if ((missing != NULL) && (size > 0))
+        missing[0] = '\0';
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && ((devices[c]->save_state == NULL) || (devices[c]->load_state == NULL))) {
+            name = (devices[c]->name != NULL) ? devices[c]->name : device_snapshot_name(devices[c]);
+            pclog("Snapshot: device \"%s\" does not support save states\n", device_snapshot_name(devices[c]));
+            if ((missing != NULL) && (len < size))
+                len += snprintf(&missing[len], size - len, "%s%s", ret ? "" : ", ", name);
+            ret = 0;
+        }
+    }
+
+    return ret;
+}
+
+void
+device_snapshot_list(snapshot_t *snap)
+{
+    uint16_t    count = 0;
+    uint16_t    len;
+    const char *name;
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if (devices[c] != NULL)
+            count++;
+    }
+    snapshot_write_var(snap, count);
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if (devices[c] != NULL) {
+            name = device_snapshot_name(devices[c]);
+            len  = (uint16_t) strlen(name);
+            snapshot_write_var(snap, c);
+            snapshot_write_var(snap, len);
+            snapshot_write(snap, name, len);
+        }
+    }
+}
+
+/* Verifies that the device list in a snapshot matches the running machine. */
+int
+device_snapshot_check(snapshot_t *snap)
+{
+    uint16_t count = 0;
+    uint16_t saved;
+    uint16_t slot;
+    uint16_t len;
+    char     name[256];
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if (devices[c] != NULL)
+            count++;
+    }
+
+    if (!snapshot_read_var(snap, saved) || (saved != count)) {
+        pclog("Snapshot: device count mismatch\n");
+        return 0;
+    }
+
+    for (uint16_t c = 0; c < count; c++) {
+        if (!snapshot_read_var(snap, slot) || !snapshot_read_var(snap, len) ||
+            (slot >= DEVICE_MAX) || (len >= sizeof(name)) || !snapshot_read(snap, name, len))
+            return 0;
+        name[len] = '\0';
+
+        if ((devices[slot] == NULL) || strcmp(name, device_snapshot_name(devices[slot]))) {
+            pclog("Snapshot: device \"%s\" is not present in this machine\n", name);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void
+device_snapshot_save(snapshot_t *snap)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if (devices[c] != NULL)
+            devices[c]->save_state(device_priv[c], snap);
+    }
+}
+
+int
+device_snapshot_load(snapshot_t *snap)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && !devices[c]->load_state(device_priv[c], snap)) {
+            pclog("Snapshot: failed to restore device \"%s\"\n", device_snapshot_name(devices[c]));
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 void *
 device_find_first_priv(uint32_t match_flags)
 {
@@ -379,6 +563,20 @@ device_get_priv(const device_t *dev)
     return (NULL);
 }
 
+const char *
+device_get_name_by_priv(const void *priv)
+{
+    if (priv == NULL)
+        return NULL;
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && (device_priv[c] == priv))
+            return devices[c]->name;
+    }
+
+    return NULL;
+}
+
 int
 device_available(const device_t *dev)
 {
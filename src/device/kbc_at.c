@@ -62,6 +62,10 @@
 #define CCB_MASK           0x68
 #define MODE_MASK          0x6c
 
+/* Poll period while there is work, and while both sides only wait for input. */
+#define KBC_AT_POLL_PERIOD (100ULL * TIMER_USEC)
+#define KBC_AT_IDLE_PERIOD (1000ULL * TIMER_USEC)
+
 #define FLAG_CLOCK         0x01
 #define FLAG_CACHE         0x02
 #define FLAG_PS2           0x04
@@ -738,15 +742,100 @@ kbc_at_poll_ps2(atkbc_t *dev)
     }
 }
 
+static void
+kbc_at_poll_ports(void)
+{
+    if ((kbc_at_ports[0] != NULL) && (kbc_at_ports[0]->priv != NULL))
+        kbc_at_ports[0]->poll(kbc_at_ports[0]->priv);
+
+    if ((kbc_at_ports[1] != NULL) && (kbc_at_ports[1]->priv != NULL))
+        kbc_at_ports[1]->poll(kbc_at_ports[1]->priv);
+}
+
+/* Whether a device has anything to do that does not wait for the controller. */
+static int
+kbc_at_port_busy(const kbc_at_port_t *port, uint8_t status)
+{
+    const atkbc_dev_t *kbd;
+
+    if ((port == NULL) || (port->priv == NULL))
+        return 0;
+
+    kbd = (const atkbc_dev_t *) port->priv;
+
+    if (port->wantcmd || ((port->out_new != -1) && !(status & STAT_OFULL)))
+        return 1;
+
+    if ((kbd->state != DEV_STATE_MAIN_1) && (kbd->state != DEV_STATE_MAIN_2) && (kbd->state != DEV_STATE_MAIN_IN))
+        return 1;
+
+    return (kbd->cmd_queue_start != kbd->cmd_queue_end) ||
+           (!kbd->ignore && *kbd->scan && (kbd->queue_start != kbd->queue_end));
+}
+
+/*
+   Whether polling can make progress. When it cannot, the controller only
+   waits for the host, which wakes it up through the ports, or for a device
+   to queue data, which is picked up by the slow idle poll: keystrokes are
+   queued from the UI thread, which must not touch the timers.
+ */
+static int
+kbc_at_busy(const atkbc_t *dev)
+{
+    if ((dev->status & STAT_IFULL) || dev->pending || dev->do_irq)
+        return 1;
+
+    switch (dev->state) {
+        case STATE_RESET:
+        case STATE_MAIN_IBF:
+        case STATE_MAIN_KBD:
+        case STATE_MAIN_AUX:
+        case STATE_MAIN_BOTH:
+        case STATE_KBC_PARAM:
+            break;
+        case STATE_KBC_AMI_OUT:
+            if (dev->status & STAT_OFULL)
+                break;
+            fallthrough;
+        default:
+            return 1;
+    }
+
+    return kbc_at_port_busy(kbc_at_ports[0], dev->status) || kbc_at_port_busy(kbc_at_ports[1], dev->status);
+}
+
+/* Back to full speed polling, the device poll timer only runs while not idle. */
+static void
+kbc_at_wake(atkbc_t *dev)
+{
+    if (timer_is_enabled(&dev->kbc_dev_poll_timer))
+        return;
+
+    timer_set_delay_u64(&dev->kbc_poll_timer, KBC_AT_POLL_PERIOD);
+    timer_set_delay_u64(&dev->kbc_dev_poll_timer, KBC_AT_POLL_PERIOD);
+}
+
 static void
 kbc_at_poll(void *priv)
 {
-    atkbc_t *dev = (atkbc_t *) priv;
+    atkbc_t *dev  = (atkbc_t *) priv;
+    int      idle = !timer_is_enabled(&dev->kbc_dev_poll_timer);
 
-    timer_advance_u64(&dev->kbc_poll_timer, (100ULL * TIMER_USEC));
+    /* While idle, this timer also stands in for the device one. */
+    if (idle)
+        kbc_at_poll_ports();
 
     /* TODO: Implement the password security state. */
     kbc_at_do_poll(dev);
+
+    if (kbc_at_busy(dev)) {
+        timer_advance_u64(&dev->kbc_poll_timer, KBC_AT_POLL_PERIOD);
+        if (idle)
+            timer_set_delay_u64(&dev->kbc_dev_poll_timer, KBC_AT_POLL_PERIOD);
+    } else {
+        timer_advance_u64(&dev->kbc_poll_timer, idle ? KBC_AT_IDLE_PERIOD : KBC_AT_POLL_PERIOD);
+        timer_disable(&dev->kbc_dev_poll_timer);
+    }
 }
 
 static void
@@ -754,13 +843,9 @@ kbc_at_dev_poll(void *priv)
 {
     atkbc_t *dev = (atkbc_t *) priv;
 
-    timer_advance_u64(&dev->kbc_dev_poll_timer, (100ULL * TIMER_USEC));
+    timer_advance_u64(&dev->kbc_dev_poll_timer, KBC_AT_POLL_PERIOD);
 
-    if ((kbc_at_ports[0] != NULL) && (kbc_at_ports[0]->priv != NULL))
-        kbc_at_ports[0]->poll(kbc_at_ports[0]->priv);
-
-    if ((kbc_at_ports[1] != NULL) && (kbc_at_ports[1]->priv != NULL))
-        kbc_at_ports[1]->poll(kbc_at_ports[1]->priv);
+    kbc_at_poll_ports();
 }
 
 static void
@@ -2653,6 +2738,8 @@ kbc_at_port_1_write(uint16_t port, uint8_t val, void *priv)
 
     kbc_at_log("ATkbc: [%04X:%08X] write(%04X) = %02X\n", CS, cpu_state.pc, port, val);
 
+    kbc_at_wake(dev);
+
     dev->status &= ~STAT_CD;
 
     if (fast_a20 && dev->wantdata && (dev->command == 0xd1)) {
@@ -2685,6 +2772,8 @@ kbc_at_port_2_write(uint16_t port, uint8_t val, void *priv)
 
     kbc_at_log("ATkbc: [%04X:%08X] write(%04X) = %02X\n", CS, cpu_state.pc, port, val);
 
+    kbc_at_wake(dev);
+
     dev->status |= STAT_CD;
 
     if (fast_a20 && (val == 0xd1)) {
@@ -2753,6 +2842,7 @@ kbc_at_port_1_read(uint16_t port, void *priv)
 
     ret = dev->ob;
     dev->status &= ~STAT_OFULL;
+    kbc_at_wake(dev);
     /*
        TODO: IRQ is only tied to OBF on the AT KBC, on the PS/2 KBC, it is controlled by a P2 bit.
        This also means that in AT mode, the IRQ is level-triggered.
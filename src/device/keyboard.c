@@ -28,6 +28,7 @@
 #include <86box/device.h>
 #include <86box/keyboard.h>
 #include <86box/plat.h>
+#include <86box/replay.h>
 
 #include "cpu.h"
 
@@ -273,6 +274,17 @@ key_process(uint16_t scan, int down)
 /* Handle a keystroke event from the UI layer. */
 void
 keyboard_input(int down, uint16_t scan)
+{
+    /* Recorded and replayed keystrokes reach the machine from the replay timer. */
+    if (replay_mode != REPLAY_OFF)
+        replay_key(down, scan);
+    else
+        keyboard_process_input(down, scan);
+}
+
+/* Deliver a keystroke to the machine. */
+void
+keyboard_process_input(int down, uint16_t scan)
 {
     if (kbd_in_reset)
         return;
@@ -33,6 +33,7 @@
 #include <86box/video.h>
 #include <86box/plat.h>
 #include <86box/plat_unused.h>
+#include <86box/replay.h>
 
 typedef struct mouse_t {
     const device_t *device;
@@ -113,6 +114,18 @@ static ATOMIC_INT      mouse_z;
 static ATOMIC_INT      mouse_w;
 static ATOMIC_INT      mouse_buttons;
 
+/* Host movements are accumulated here lock-free by the UI and input threads,
+   and taken over once per report, by mouse_process() or, while inputs are
+   recorded or replayed, by the replay timer. The state above is then only
+   changed by the emulation thread. */
+static _Atomic(double) mouse_ui_x;
+static _Atomic(double) mouse_ui_y;
+static atomic_int      mouse_ui_z;
+static atomic_int      mouse_ui_w;
+static ATOMIC_INT      mouse_ui_buttons;
+static double          mouse_replay_x_abs;
+static double          mouse_replay_y_abs;
+
 static int             mouse_delta_b;
 static int             mouse_old_b;
 
@@ -162,6 +175,14 @@ mouse_clear_coords(void)
 
     mouse_z = 0;
     mouse_w = 0;
+
+    /* What the replay timer has not taken yet still belongs to the record. */
+    if (replay_mode == REPLAY_OFF) {
+        atomic_store(&mouse_ui_x, 0.0);
+        atomic_store(&mouse_ui_y, 0.0);
+        atomic_store(&mouse_ui_z, 0);
+        atomic_store(&mouse_ui_w, 0);
+    }
 }
 
 void
@@ -434,28 +455,39 @@ atomic_double_add(ATOMIC_DOUBLE *var, double val)
 }
 #endif
 
+/* Several host threads may add at once, so this has to be a real read-modify-write. */
+static void
+mouse_ui_add(_Atomic(double) *var, double val)
+{
+    double old = atomic_load_explicit(var, memory_order_relaxed);
+
+    while (!atomic_compare_exchange_weak_explicit(var, &old, old + val,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
 void
 mouse_scale_fx(double x)
 {
-    ATOMIC_DOUBLE_ADD(mouse_x, ((double) x) * mouse_sensitivity);
+    mouse_ui_add(&mouse_ui_x, ((double) x) * mouse_sensitivity);
 }
 
 void
 mouse_scale_fy(double y)
 {
-    ATOMIC_DOUBLE_ADD(mouse_y, ((double) y) * mouse_sensitivity);
+    mouse_ui_add(&mouse_ui_y, ((double) y) * mouse_sensitivity);
 }
 
 void
 mouse_scale_x(int x)
 {
-    ATOMIC_DOUBLE_ADD(mouse_x, ((double) x) * mouse_sensitivity);
+    mouse_ui_add(&mouse_ui_x, ((double) x) * mouse_sensitivity);
 }
 
 void
 mouse_scale_y(int y)
 {
-    ATOMIC_DOUBLE_ADD(mouse_y, ((double) y) * mouse_sensitivity);
+    mouse_ui_add(&mouse_ui_y, ((double) y) * mouse_sensitivity);
 }
 
 void
@@ -484,7 +516,7 @@ mouse_scale_axis(int axis, int val)
 void
 mouse_set_z(int z)
 {
-    ATOMIC_ADD(mouse_z, z);
+    atomic_fetch_add_explicit(&mouse_ui_z, z, memory_order_relaxed);
 }
 
 void
@@ -496,7 +528,7 @@ mouse_clear_z(void)
 void
 mouse_set_w(int w)
 {
-    ATOMIC_ADD(mouse_w, w);
+    atomic_fetch_add_explicit(&mouse_ui_w, w, memory_order_relaxed);
 }
 
 void
@@ -548,7 +580,10 @@ mouse_subtract_w(int *delta_w, int min, int max, int invert)
 void
 mouse_set_buttons_ex(int b)
 {
-    ATOMIC_STORE(mouse_buttons, b);
+    if (replay_mode != REPLAY_OFF)
+        ATOMIC_STORE(mouse_ui_buttons, b);
+    else
+        ATOMIC_STORE(mouse_buttons, b);
 }
 
 int
@@ -585,13 +620,64 @@ mouse_set_buttons(int buttons)
 void
 mouse_get_abs_coords(double *x_abs, double *y_abs)
 {
-    *x_abs = mouse_x_abs;
-    *y_abs = mouse_y_abs;
+    if (replay_mode != REPLAY_OFF) {
+        *x_abs = mouse_replay_x_abs;
+        *y_abs = mouse_replay_y_abs;
+    } else {
+        *x_abs = mouse_x_abs;
+        *y_abs = mouse_y_abs;
+    }
+}
+
+/* Collect what the UI staged since the last call, for the replay timer. */
+void
+mouse_replay_take(double *x, double *y, int *z, int *w, int *b)
+{
+    *x = atomic_exchange(&mouse_ui_x, 0.0);
+    *y = atomic_exchange(&mouse_ui_y, 0.0);
+    *z = atomic_exchange(&mouse_ui_z, 0);
+    *w = atomic_exchange(&mouse_ui_w, 0);
+    *b = ATOMIC_LOAD(mouse_ui_buttons);
+}
+
+/* Hand recorded or replayed movements to the machine, on the emulation thread. */
+void
+mouse_replay_give(double x, double y, int z, int w, int b, double x_abs, double y_abs)
+{
+    ATOMIC_DOUBLE_ADD(mouse_x, x);
+    ATOMIC_DOUBLE_ADD(mouse_y, y);
+    ATOMIC_ADD(mouse_z, z);
+    ATOMIC_ADD(mouse_w, w);
+    ATOMIC_STORE(mouse_buttons, b);
+    mouse_replay_x_abs = x_abs;
+    mouse_replay_y_abs = y_abs;
+}
+
+/* Take over the host movements since the last report, in one go. */
+static void
+mouse_collect(void)
+{
+    double x = atomic_exchange(&mouse_ui_x, 0.0);
+    double y = atomic_exchange(&mouse_ui_y, 0.0);
+    int    z = atomic_exchange(&mouse_ui_z, 0);
+    int    w = atomic_exchange(&mouse_ui_w, 0);
+
+    if (x != 0.0)
+        ATOMIC_DOUBLE_ADD(mouse_x, x);
+    if (y != 0.0)
+        ATOMIC_DOUBLE_ADD(mouse_y, y);
+    if (z)
+        ATOMIC_ADD(mouse_z, z);
+    if (w)
+        ATOMIC_ADD(mouse_w, w);
 }
 
 void
 mouse_process(void)
 {
+    if (replay_mode == REPLAY_OFF)
+        mouse_collect();
+
     if ((mouse_input_mode >= 1) && mouse_poll_ex)
         mouse_poll_ex();
     else if ((mouse_input_mode == 0) && (mouse_dev_poll != NULL))
@@ -160,8 +160,6 @@ serial_receive_timer(void *priv)
 
     serial_log("serial_receive_timer()\n");
 
-    timer_on_auto(&dev->receive_timer, /* dev->bits * */ dev->transmit_period);
-
     if (dev->fifo_enabled) {
         /* FIFO mode. */
         if (dev->out_new != 0xffff) {
@@ -214,6 +212,10 @@ write_fifo(serial_t *dev, uint8_t dat)
 
     /* Do this here, because in non-FIFO mode, this is read directly. */
     dev->out_new = (uint16_t) dat;
+
+    /* The receive timer only runs while there is a byte in the RSR. */
+    if (!timer_is_on(&dev->receive_timer))
+        timer_on_auto(&dev->receive_timer, /* dev->bits * */ dev->transmit_period);
 }
 
 void
@@ -228,6 +230,34 @@ serial_write_fifo(serial_t *dev, uint8_t dat)
         write_fifo(dev, dat);
 }
 
+/* Take up to len received bytes at once: in FIFO mode, as many as fit
+   go straight into the receiver FIFO, otherwise a single byte goes to
+   the RSR as with serial_write_fifo(). Returns the number of bytes taken,
+   the caller paces the next batch by that many character times. */
+int
+serial_write_fifo_buf(serial_t *dev, const uint8_t *buf, int len)
+{
+    int ret = 0;
+
+    if ((dev == NULL) || (dev->mctrl & 0x10) || (len <= 0) || (dev->out_new != 0xffff))
+        return 0;
+
+    if (dev->fifo_enabled) {
+        if (fifo_get_full(dev->rcvr_fifo))
+            return 0;
+
+        serial_clear_timeout(dev);
+        while ((ret < len) && !fifo_get_full(dev->rcvr_fifo))
+            fifo_write_evt(buf[ret++], dev->rcvr_fifo);
+        timer_on_auto(&dev->timeout_timer, 4.0 * dev->bits * dev->transmit_period);
+    } else if (!(dev->lsr & 0x01)) {
+        write_fifo(dev, buf[0]);
+        ret = 1;
+    }
+
+    return ret;
+}
+
 void
 serial_transmit(serial_t *dev, uint8_t val)
 {
@@ -364,7 +394,8 @@ static void
 serial_update_speed(serial_t *dev)
 {
     serial_log("serial_update_speed(%lf)\n", dev->transmit_period);
-    timer_on_auto(&dev->receive_timer, /* dev->bits * */ dev->transmit_period);
+    if (dev->out_new != 0xffff)
+        timer_on_auto(&dev->receive_timer, /* dev->bits * */ dev->transmit_period);
 
     if (dev->transmit_enabled & 3)
         timer_on_auto(&dev->transmit_timer, dev->transmit_period);
@@ -60,47 +60,51 @@ serial_passthrough_init(void)
     }
 }
 
+static void
+serial_passthrough_flush(serial_passthrough_t *dev)
+{
+    if (dev->tx_len) {
+        plat_serpt_write(dev, dev->tx_buf, dev->tx_len);
+        dev->tx_len = 0;
+    }
+}
+
 static void
 serial_passthrough_write(UNUSED(serial_t *s), void *priv, uint8_t val)
 {
-    plat_serpt_write(priv, val);
+    serial_passthrough_t *dev = (serial_passthrough_t *) priv;
+
+    /* Collected here and written out by the host timer, or once full. */
+    dev->tx_buf[dev->tx_len++] = val;
+    if (dev->tx_len == SERPT_BUF_LEN)
+        serial_passthrough_flush(dev);
 }
 
 static void
 host_to_serial_cb(void *priv)
 {
     serial_passthrough_t *dev = (serial_passthrough_t *) priv;
-
-    uint8_t byte;
+    int                   n   = 0;
 
     plat_serpt_set_line_state(priv);
 
-    /* write_fifo has no failure indication, but if we write to fast, the host
-     * can never fetch the bytes in time, so check if the fifo is full if in
-     * fifo mode or if lsr has bit 0 set if not in fifo mode */
-    if ((dev->serial->type >= SERIAL_16550) && dev->serial->fifo_enabled) {
-        if (fifo_get_full(dev->serial->rcvr_fifo)) {
-            goto no_write_to_machine;
-        }
-    } else {
-        if (dev->serial->lsr & 1) {
-            goto no_write_to_machine;
-        }
+    serial_passthrough_flush(dev);
+
+    /* Only go back to the host once everything read before has made it
+       into the machine, the host side buffers the rest meanwhile. */
+    if (dev->rx_pos == dev->rx_len) {
+        dev->rx_pos = 0;
+        dev->rx_len = plat_serpt_read(dev, dev->rx_buf, SERPT_BUF_LEN);
     }
-    if (plat_serpt_read(dev, &byte)) {
-#if 0
-        printf("got byte %02X\n", byte);
-#endif
-        serial_write_fifo(dev->serial, byte);
-#if 0
-        serial_set_dsr(dev->serial, 1);
-#endif
+
+    /* As much as the receiver FIFO takes, or one byte without a FIFO;
+       then wait for as many character times before the next batch. */
+    if (dev->rx_pos < dev->rx_len) {
+        n = serial_write_fifo_buf(dev->serial, &dev->rx_buf[dev->rx_pos], dev->rx_len - dev->rx_pos);
+        dev->rx_pos += n;
     }
-no_write_to_machine:
-#if 0
-    serial_device_timeout(dev->serial);
-#endif
-    timer_on_auto(&dev->host_to_serial_timer, (1000000.0 / dev->baudrate) * (double) dev->bits);
+
+    timer_on_auto(&dev->host_to_serial_timer, (1000000.0 / dev->baudrate) * (double) dev->bits * (double) MAX(n, 1));
 }
 
 static void
@@ -142,6 +146,7 @@ serial_passthrough_dev_close(void *priv)
     if (dev->serial && dev->serial->sd)
         memset(dev->serial->sd, 0, sizeof(serial_device_t));
 
+    serial_passthrough_flush(dev);
     plat_serpt_close(dev);
     free(dev);
 }
@@ -313,6 +313,9 @@ unknown_protocol:
             break;
     }
 
+    /* The transaction was carried out on the I2C bus as a whole above; only its
+       completion is deferred, as a single timer event with the bus time of all
+       its bytes, so polling guests see a realistic HOST_BUSY period. */
     if (dev->next_stat) { /* schedule dispatch of any pending status register update */
         dev->stat = 0x01; /* raise HOST_BUSY while waiting */
         timer_disable(&dev->response_timer);
@@ -15,6 +15,7 @@
  *
  *          Copyright 2024 GreaseMonkey.
  */
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -24,9 +25,14 @@
 #include <wchar.h>
 #define HAVE_STDARG_H
 #include <86box/86box.h>
+#include "cpu.h"
+#include <86box/device.h>
 #include <86box/io.h>
+#include <86box/machine.h>
+#include <86box/timer.h>
 #include <86box/plat.h>
 #include <86box/unittester.h>
+#include <86box/version.h>
 #include <86box/video.h>
 
 enum fsm1_value {
@@ -55,6 +61,26 @@ enum unittester_cmd {
     UT_CMD_READ_SCREEN_SNAPSHOT_RECTANGLE   = 0x02,
     UT_CMD_VERIFY_SCREEN_SNAPSHOT_RECTANGLE = 0x03,
     UT_CMD_EXIT                             = 0x04,
+    UT_CMD_READ_TIMERS                      = 0x05,
+    UT_CMD_BENCHMARK_START                  = 0x06,
+    UT_CMD_BENCHMARK_STOP                   = 0x07,
+};
+
+#define UT_BENCH_NAME_LEN 16
+#define UT_BENCH_RUNNING  16  /* Benchmarks measured at the same time */
+#define UT_BENCH_RESULTS  256 /* Results kept for the results file */
+
+/* One side of a benchmark measurement. */
+struct unittester_sample {
+    uint64_t  host_ns;
+    uint64_t  tsc;
+    pc_perf_t counters;
+};
+
+struct unittester_bench {
+    char                     name[UT_BENCH_NAME_LEN + 1];
+    struct unittester_sample start;
+    struct unittester_sample stop;
 };
 
 struct unittester_state {
@@ -101,6 +127,12 @@ struct unittester_state {
 
     /* 0x04: Exit */
     uint8_t exit_code;
+
+    /* 0x05: Read Timers */
+    /* 0x06: Benchmark Start */
+    /* 0x07: Benchmark Stop */
+    char    bench_name[UT_BENCH_NAME_LEN + 1];
+    uint8_t bench_out[24];
 };
 static struct unittester_state unittester;
 static struct unittester_state unittester_defaults = {
@@ -117,6 +149,11 @@ static bitmap_t *unittester_screen_buffer = NULL;
 
 static bool unittester_exit_enabled = true;
 
+static struct unittester_bench unittester_running[UT_BENCH_RUNNING];
+static struct unittester_bench unittester_results[UT_BENCH_RESULTS];
+static int                     unittester_results_count = 0;
+static char                    unittester_results_fn[1024];
+
 #ifdef ENABLE_UNITTESTER_LOG
 int unittester_do_log = ENABLE_UNITTESTER_LOG;
 
@@ -154,6 +191,143 @@ unittester_read_snap_rect_idx(uint64_t offs)
     }
 }
 
+static void
+unittester_sample(struct unittester_sample *sample)
+{
+    sample->host_ns = plat_get_nsecs();
+    sample->tsc     = tsc;
+    pc_get_perf_totals(&sample->counters);
+}
+
+static uint64_t
+unittester_emulated_ns(uint64_t ticks)
+{
+    return TIMER_USEC ? ((ticks * 1000ULL) / TIMER_USEC) : 0;
+}
+
+static void
+unittester_put_u64(uint8_t *out, uint64_t val)
+{
+    for (int i = 0; i < 8; i++)
+        out[i] = (uint8_t) (val >> (i * 8));
+}
+
+/* The whole file is rewritten after each benchmark, as the Exit command
+   may end the program at any point. */
+static void
+unittester_write_results(void)
+{
+    const struct unittester_bench *bench;
+    const pc_perf_t               *start;
+    const pc_perf_t               *stop;
+    uint64_t                       host_ns;
+    uint64_t                       ticks;
+    FILE                          *fp;
+
+    if (unittester_results_fn[0] == '\0')
+        return;
+
+    if ((fp = plat_fopen(unittester_results_fn, "w")) == NULL) {
+        pclog("[UT] Could not write benchmark results to \"%s\"\n", unittester_results_fn);
+        return;
+    }
+
+    fprintf(fp, "{\n  \"emulator\": \"86Box %s\",\n  \"machine\": \"%s\",\n  \"cpu\": \"%s\",\n  \"dynarec\": %s,\n  \"benchmarks\": [",
+            EMU_VERSION_FULL, machine_get_internal_name(), cpu_s->name, cpu_use_dynarec ? "true" : "false");
+
+    for (int i = 0; i < unittester_results_count; i++) {
+        bench   = &unittester_results[i];
+        start   = &bench->start.counters;
+        stop    = &bench->stop.counters;
+        host_ns = bench->stop.host_ns - bench->start.host_ns;
+        ticks   = bench->stop.tsc - bench->start.tsc;
+
+        fprintf(fp, "%s\n    {\n", i ? "," : "");
+        fprintf(fp, "      \"name\": \"%s\",\n", bench->name);
+        fprintf(fp, "      \"host_ns\": %" PRIu64 ",\n", host_ns);
+        fprintf(fp, "      \"emulated_ns\": %" PRIu64 ",\n", unittester_emulated_ns(ticks));
+        fprintf(fp, "      \"tsc\": %" PRIu64 ",\n", ticks);
+        fprintf(fp, "      \"speed\": %.2f,\n", host_ns ? (unittester_emulated_ns(ticks) * 100.0 / host_ns) : 0.0);
+        fprintf(fp, "      \"instructions\": %" PRIu64 ",\n", stop->instructions - start->instructions);
+        fprintf(fp, "      \"mips\": %.2f,\n", host_ns ? ((stop->instructions - start->instructions) * 1000.0 / host_ns) : 0.0);
+        fprintf(fp, "      \"timer_callbacks\": %" PRIu64 ",\n", stop->timer_callbacks - start->timer_callbacks);
+        fprintf(fp, "      \"audio_underruns\": %" PRIu32 ",\n", stop->audio_underruns - start->audio_underruns);
+        fprintf(fp, "      \"disk_ops\": %" PRIu64 ",\n", stop->disk_ops - start->disk_ops);
+        fprintf(fp, "      \"net_rx_packets\": %" PRIu64 ",\n", stop->net_rx_packets - start->net_rx_packets);
+        fprintf(fp, "      \"net_tx_packets\": %" PRIu64 ",\n", stop->net_tx_packets - start->net_tx_packets);
+        fprintf(fp, "      \"dynarec_compiled\": %" PRIu64 ",\n", stop->dynarec_compiled - start->dynarec_compiled);
+        fprintf(fp, "      \"dynarec_evicted\": %" PRIu64 ",\n", stop->dynarec_evicted - start->dynarec_evicted);
+        fprintf(fp, "      \"dynarec_smc\": %" PRIu64 ",\n", stop->dynarec_smc - start->dynarec_smc);
+        fprintf(fp, "      \"dynarec_flushed\": %" PRIu64 "\n", stop->dynarec_flushed - start->dynarec_flushed);
+        fprintf(fp, "    }");
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+}
+
+static struct unittester_bench *
+unittester_find_running(const char *name)
+{
+    for (int i = 0; i < UT_BENCH_RUNNING; i++) {
+        if (unittester_running[i].name[0] && !strcmp(unittester_running[i].name, name))
+            return &unittester_running[i];
+    }
+
+    return NULL;
+}
+
+static void
+unittester_bench_start(void)
+{
+    struct unittester_bench *bench = unittester_find_running(unittester.bench_name);
+
+    /* Restarting a running benchmark starts it over. */
+    for (int i = 0; (bench == NULL) && (i < UT_BENCH_RUNNING); i++) {
+        if (unittester_running[i].name[0] == '\0')
+            bench = &unittester_running[i];
+    }
+
+    if (bench == NULL) {
+        pclog("[UT] Too many benchmarks running, \"%s\" ignored\n", unittester.bench_name);
+        return;
+    }
+
+    strcpy(bench->name, unittester.bench_name);
+    unittester_sample(&bench->start);
+}
+
+static void
+unittester_bench_stop(void)
+{
+    struct unittester_bench *bench = unittester_find_running(unittester.bench_name);
+    uint64_t                 host_ns;
+    uint64_t                 ticks;
+
+    memset(unittester.bench_out, 0x00, sizeof(unittester.bench_out));
+    if (bench == NULL)
+        return;
+
+    unittester_sample(&bench->stop);
+    host_ns = bench->stop.host_ns - bench->start.host_ns;
+    ticks   = bench->stop.tsc - bench->start.tsc;
+
+    unittester_put_u64(&unittester.bench_out[0], host_ns);
+    unittester_put_u64(&unittester.bench_out[8], unittester_emulated_ns(ticks));
+    unittester_put_u64(&unittester.bench_out[16], ticks);
+
+    pclog("[UT] Benchmark \"%s\": %.3f ms host, %.3f ms emulated, %" PRIu64 " TSC ticks, %.2f MIPS\n", bench->name,
+          host_ns / 1000000.0, unittester_emulated_ns(ticks) / 1000000.0, ticks,
+          host_ns ? ((bench->stop.counters.instructions - bench->start.counters.instructions) * 1000.0 / host_ns) : 0.0);
+
+    if (unittester_results_count < UT_BENCH_RESULTS) {
+        unittester_results[unittester_results_count++] = *bench;
+        unittester_write_results();
+    }
+
+    bench->name[0] = '\0';
+}
+
 static void
 unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
 {
@@ -201,6 +375,26 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
                 unittester.write_len = 1;
                 break;
 
+            /* 0x05: Read Timers */
+            case UT_CMD_READ_TIMERS:
+                unittester.cmd_id   = UT_CMD_READ_TIMERS;
+                unittester.status   = UT_STATUS_AWAITING_READ;
+                unittester.read_len = 24;
+                unittester_put_u64(&unittester.bench_out[0], plat_get_nsecs());
+                unittester_put_u64(&unittester.bench_out[8], unittester_emulated_ns(tsc));
+                unittester_put_u64(&unittester.bench_out[16], tsc);
+                break;
+
+            /* 0x06: Benchmark Start */
+            /* 0x07: Benchmark Stop */
+            case UT_CMD_BENCHMARK_START:
+            case UT_CMD_BENCHMARK_STOP:
+                unittester.cmd_id    = val;
+                unittester.status    = UT_STATUS_AWAITING_WRITE;
+                unittester.write_len = UT_BENCH_NAME_LEN;
+                memset(unittester.bench_name, 0x00, sizeof(unittester.bench_name));
+                break;
+
             /* Unsupported command - terminate here */
             default:
                 unittester.cmd_id = UT_CMD_NOOP;
@@ -269,6 +463,14 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
                 }
                 break;
 
+            case UT_CMD_BENCHMARK_START:
+            case UT_CMD_BENCHMARK_STOP:
+                /* Keep the name printable and safe to put in a JSON string. */
+                if ((val != 0x00) && ((val < 0x20) || (val > 0x7E) || (val == '"') || (val == '\\')))
+                    val = '_';
+                unittester.bench_name[unittester.write_offs] = (char) val;
+                break;
+
             /* This should not be reachable, but just in case... */
             default:
                 break;
@@ -396,6 +598,20 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
                     }
                     break;
 
+                case UT_CMD_BENCHMARK_START:
+                    unittester_log("[UT] Benchmark start - \"%s\"\n", unittester.bench_name);
+                    unittester_bench_start();
+                    unittester.cmd_id = UT_CMD_NOOP;
+                    unittester.status = UT_STATUS_IDLE;
+                    break;
+
+                case UT_CMD_BENCHMARK_STOP:
+                    unittester_log("[UT] Benchmark stop - \"%s\"\n", unittester.bench_name);
+                    unittester_bench_stop();
+                    unittester.status   = UT_STATUS_AWAITING_READ;
+                    unittester.read_len = 24;
+                    break;
+
                 default:
                     /* Nothing to write? Stop here. */
                     unittester.cmd_id = UT_CMD_NOOP;
@@ -478,6 +694,11 @@ unittester_read(uint16_t port, UNUSED(void *priv))
                 outval = (uint8_t) (unittester.read_snap_crc >> (8 * unittester.read_offs));
                 break;
 
+            case UT_CMD_READ_TIMERS:
+            case UT_CMD_BENCHMARK_STOP:
+                outval = unittester.bench_out[unittester.read_offs];
+                break;
+
             /* This should not be reachable, but just in case... */
             default:
                 break;
@@ -578,10 +799,17 @@ unittester_trigger_write(UNUSED(uint16_t port), uint8_t val, UNUSED(void *priv))
 static void *
 unittester_init(UNUSED(const device_t *info))
 {
+    const char *fn;
+
     unittester = unittester_defaults;
 
     unittester_exit_enabled = !!device_get_config_int("exit_enabled");
 
+    fn = device_get_config_string("results_file");
+    snprintf(unittester_results_fn, sizeof(unittester_results_fn), "%s", (fn != NULL) ? fn : "");
+    memset(unittester_running, 0x00, sizeof(unittester_running));
+    unittester_results_count = 0;
+
     if (unittester_screen_buffer == NULL)
         unittester_screen_buffer = create_bitmap(2048, 2048);
 
@@ -622,6 +850,17 @@ static const device_config_t unittester_config[] = {
         .selection      = { { 0 } },
         .bios           = { { 0 } }
     },
+    {
+        .name           = "results_file",
+        .description    = "Benchmark results file",
+        .type           = CONFIG_FNAME,
+        .default_string = "",
+        .default_int    = 0,
+        .file_filter    = "JSON files (*.json)|*.json",
+        .spinner        = { 0 },
+        .selection      = { { 0 } },
+        .bios           = { { 0 } }
+    },
     { .name = "", .description = "", .type = CONFIG_END }
   // clang-format on
 };
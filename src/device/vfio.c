@@ -204,6 +204,7 @@ static int             epoll_fd           = -1;
 static int             irq_thread_wake_fd = -1;
 static int             closing            = 0;
 static int             intx_high          = 0;
+static int             host_lookups       = 0;
 static int             timing_readb       = 0;
 static int             timing_readw       = 0;
 static int             timing_readl       = 0;
@@ -308,6 +309,36 @@ VFIO_RW(io, b, uint16_t, 4, uint8_t, 2)
 VFIO_RW(io, w, uint16_t, 4, uint16_t, 4)
 VFIO_RW(io, l, uint16_t, 4, uint32_t, 8)
 
+/* Memory BARs of at least a page with mmap available: after going through the
+   handler once, a page is entered into the TLB lookups and the CPU accesses
+   the mmap directly. Quirks and the MSI-X table and PBA have mappings of their
+   own over whole pages, so they never reach these handlers. */
+#define VFIO_RW_HOST(length_char, val_type)                                                     \
+    static val_type                                                                             \
+    vfio_mem_read##length_char##_host(uint32_t addr, void *priv)                                \
+    {                                                                                           \
+        val_type ret = vfio_mem_read##length_char##_mm(addr, priv);                             \
+        if (cpu_use_exec) {                                                                     \
+            mem_add_host_readlookup(mem_logical_addr, &((uint8_t *) priv)[addr & ~0xfff]);      \
+            host_lookups = 1;                                                                   \
+        }                                                                                       \
+        return ret;                                                                             \
+    }                                                                                           \
+                                                                                                \
+    static void                                                                                 \
+    vfio_mem_write##length_char##_host(uint32_t addr, val_type val, void *priv)                 \
+    {                                                                                           \
+        vfio_mem_write##length_char##_mm(addr, val, priv);                                      \
+        if (cpu_use_exec) {                                                                     \
+            mem_add_host_writelookup(mem_logical_addr, &((uint8_t *) priv)[addr & ~0xfff]);     \
+            host_lookups = 1;                                                                   \
+        }                                                                                       \
+    }
+
+VFIO_RW_HOST(b, uint8_t)
+VFIO_RW_HOST(w, uint16_t)
+VFIO_RW_HOST(l, uint32_t)
+
 static void
 vfio_quirk_capture_io(vfio_device_t *dev, vfio_region_t *bar,
                       uint16_t base, uint16_t size, uint8_t enable,
@@ -2010,6 +2041,13 @@ vfio_irq_timer(void *priv)
                 /* Raise IRQ. */
                 pci_set_irq(dev->slot, dev->irq.intx.pin, &dev->irq.intx.state);
 
+                /* The falling edge is detected from BAR accesses, so make sure
+                   they go through the handlers again. */
+                if (host_lookups) {
+                    flushmmucache_nopc();
+                    host_lookups = 0;
+                }
+
                 /* Mark the IRQ as active, so that a BAR read/write can lower it. */
                 dev->irq.intx.raised = intx_high = 1;
             } else if (!intx_high) { /* falling edge */
@@ -2437,7 +2475,17 @@ end:
              region->name, region->offset, region->size);
 
     /* Create memory mapping for if we need it. */
-    if (region->mmap_base) { /* mmap available */
+    if (region->mmap_base && (region->size >= 4096)) { /* mmap available, whole pages */
+        vfio_log("(MM, host lookups)");
+        mem_mapping_add(&region->mem_mapping, 0, 0,
+                        region->read ? vfio_mem_readb_host : NULL,
+                        region->read ? vfio_mem_readw_host : NULL,
+                        region->read ? vfio_mem_readl_host : NULL,
+                        region->write ? vfio_mem_writeb_host : NULL,
+                        region->write ? vfio_mem_writew_host : NULL,
+                        region->write ? vfio_mem_writel_host : NULL,
+                        NULL, MEM_MAPPING_EXTERNAL, region->mmap_precalc);
+    } else if (region->mmap_base) { /* mmap available */
         vfio_log("(MM)");
         mem_mapping_add(&region->mem_mapping, 0, 0,
                         region->read ? vfio_mem_readb_mm : NULL,
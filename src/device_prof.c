@@ -0,0 +1,207 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Per-device host time accounting.
+ *
+ *          The port I/O and memory mapping dispatchers, the timer loop
+ *          and the device worker threads charge the host time spent in
+ *          each handler to its private data pointer. The totals are
+ *          grouped by device_t when they are read, for the status bar
+ *          and for the log on exit. Times are inclusive, a handler that
+ *          calls into another device is charged for both.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/device_prof.h>
+#include <86box/plat.h>
+
+/* Handler private data pointers tracked, must be a power of 2. */
+#define DEVICE_PROF_SIZE 512
+
+typedef struct device_prof_entry_t {
+    _Atomic(const void *) priv;
+    atomic_uint_fast64_t  ns[DEVICE_PROF_KINDS];
+    uint64_t              reported[DEVICE_PROF_KINDS]; /* owned by device_prof_get() */
+} device_prof_entry_t;
+
+/* (O) Account host time per device, for the status bar and the log on exit. */
+int device_profile = 0;
+
+static device_prof_entry_t device_prof[DEVICE_PROF_SIZE];
+static device_prof_stat_t  device_prof_window[DEVICE_PROF_SIZE]; /* device_prof_get() */
+static device_prof_stat_t  device_prof_totals[DEVICE_PROF_SIZE]; /* device_profile_dump() */
+static uint64_t            device_prof_last_ns;
+
+static const char *kind_names[DEVICE_PROF_KINDS] = { "I/O", "MMIO", "Timers", "Worker" };
+
+static device_prof_entry_t *
+device_prof_find(const void *priv)
+{
+    uint32_t             hash = (uint32_t) (((uintptr_t) priv >> 4) * 2654435761U);
+    device_prof_entry_t *entry;
+    const void          *old;
+
+    for (uint32_t i = 0; i < DEVICE_PROF_SIZE; i++) {
+        entry = &device_prof[(hash + i) & (DEVICE_PROF_SIZE - 1)];
+        old   = atomic_load_explicit(&entry->priv, memory_order_acquire);
+
+        if (old == priv)
+            return entry;
+
+        /* Worker threads may insert too, so claim empty slots atomically. */
+        if (old == NULL) {
+            if (atomic_compare_exchange_strong(&entry->priv, &old, priv) || (old == priv))
+                return entry;
+        }
+    }
+
+    /* Table full, lump everything else into the last probed slot. */
+    return entry;
+}
+
+void
+device_prof_add(const void *priv, int kind, uint64_t start_ns)
+{
+    device_prof_entry_t *entry;
+
+    if (priv == NULL)
+        return;
+
+    entry = device_prof_find(priv);
+    atomic_fetch_add_explicit(&entry->ns[kind], plat_get_nsecs() - start_ns, memory_order_relaxed);
+}
+
+void
+device_prof_reset(void)
+{
+    for (uint32_t i = 0; i < DEVICE_PROF_SIZE; i++) {
+        for (int k = 0; k < DEVICE_PROF_KINDS; k++)
+            atomic_store_explicit(&device_prof[i].ns[k], 0, memory_order_relaxed);
+        atomic_store_explicit(&device_prof[i].priv, NULL, memory_order_release);
+    }
+}
+
+static int
+device_prof_compare(const void *a, const void *b)
+{
+    const device_prof_stat_t *sa = (const device_prof_stat_t *) a;
+    const device_prof_stat_t *sb = (const device_prof_stat_t *) b;
+
+    if (sa->total_ns == sb->total_ns)
+        return 0;
+
+    return (sa->total_ns < sb->total_ns) ? 1 : -1;
+}
+
+/* Group the entries by device name, either as totals or as deltas since the last call. */
+static int
+device_prof_collect(device_prof_stat_t *agg, int delta)
+{
+    device_prof_entry_t *entry;
+    device_prof_stat_t  *stat;
+    const void          *priv;
+    const char          *name;
+    uint64_t             ns;
+    int                  count = 0;
+    int                  j;
+
+    for (uint32_t i = 0; i < DEVICE_PROF_SIZE; i++) {
+        entry = &device_prof[i];
+        priv  = atomic_load_explicit(&entry->priv, memory_order_acquire);
+        if (priv == NULL)
+            continue;
+
+        name = device_get_name_by_priv(priv);
+        if (name == NULL)
+            name = "(other)";
+
+        for (j = 0; j < count; j++) {
+            if (!strcmp(agg[j].name, name))
+                break;
+        }
+        stat = &agg[j];
+        if (j == count) {
+            memset(stat, 0, sizeof(device_prof_stat_t));
+            stat->name = name;
+            count++;
+        }
+
+        for (int k = 0; k < DEVICE_PROF_KINDS; k++) {
+            ns = atomic_load_explicit(&entry->ns[k], memory_order_relaxed);
+            if (delta) {
+                /* The table may have been reset under us. */
+                uint64_t last = entry->reported[k];
+
+                entry->reported[k] = ns;
+                ns                 = (ns >= last) ? (ns - last) : ns;
+            }
+            stat->ns[k] += ns;
+            stat->total_ns += ns;
+        }
+    }
+
+    qsort(agg, count, sizeof(device_prof_stat_t), device_prof_compare);
+
+    while ((count > 0) && !agg[count - 1].total_ns)
+        count--;
+
+    return count;
+}
+
+int
+device_prof_get(device_prof_stat_t *stats, int max, uint64_t *window_ns)
+{
+    uint64_t now = plat_get_nsecs();
+    int      count;
+
+    if (!device_profile)
+        return 0;
+
+    *window_ns          = device_prof_last_ns ? (now - device_prof_last_ns) : 0;
+    device_prof_last_ns = now;
+
+    count = device_prof_collect(device_prof_window, 1);
+    if (count > max)
+        count = max;
+    memcpy(stats, device_prof_window, count * sizeof(device_prof_stat_t));
+
+    return count;
+}
+
+void
+device_profile_dump(void)
+{
+    const device_prof_stat_t *stat;
+    int                       count;
+
+    if (!device_profile)
+        return;
+
+    count = device_prof_collect(device_prof_totals, 0);
+
+    always_log("Device profile (%i devices, sorted by total host time, in ms):\n", count);
+    always_log("%-40s %12s %12s %12s %12s %12s\n", "Device", "Total",
+               kind_names[DEVICE_PROF_IO], kind_names[DEVICE_PROF_MMIO],
+               kind_names[DEVICE_PROF_TIMER], kind_names[DEVICE_PROF_WORKER]);
+    for (int i = 0; i < count; i++) {
+        stat = &device_prof_totals[i];
+        always_log("%-40.40s %12.3f %12.3f %12.3f %12.3f %12.3f\n", stat->name,
+                   stat->total_ns / 1000000.0, stat->ns[DEVICE_PROF_IO] / 1000000.0,
+                   stat->ns[DEVICE_PROF_MMIO] / 1000000.0, stat->ns[DEVICE_PROF_TIMER] / 1000000.0,
+                   stat->ns[DEVICE_PROF_WORKER] / 1000000.0);
+    }
+}
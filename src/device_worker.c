@@ -0,0 +1,170 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Implementation of the device worker threads, which let a
+ *          device handle posted MMIO and port writes off the
+ *          emulation thread.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/device_prof.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/device_worker.h>
+
+#define DEVICE_WORKER_MASK (DEVICE_WORKER_SIZE - 1)
+
+typedef struct device_post_t {
+    uint32_t addr;
+    uint32_t val;
+    uint8_t  type;
+} device_post_t;
+
+struct device_worker_t {
+    device_post_t ring[DEVICE_WORKER_SIZE];
+
+    /* The emulation thread owns write_idx, the worker thread owns read_idx. */
+    atomic_uint write_idx;
+    atomic_uint read_idx;
+    atomic_int  run;
+    atomic_int  sleeping;
+
+    void (*handler)(void *priv, uint8_t type, uint32_t addr, uint32_t val);
+    void *priv;
+
+    thread_t *thread;
+    event_t  *wake_event;
+    event_t  *not_full_event;
+};
+
+static void
+device_worker_thread(void *param)
+{
+    device_worker_t *worker = (device_worker_t *) param;
+    device_post_t   *post;
+    uint32_t         read_idx;
+
+    while (atomic_load_explicit(&worker->run, memory_order_acquire)) {
+        read_idx = atomic_load_explicit(&worker->read_idx, memory_order_relaxed);
+
+        if (read_idx == atomic_load_explicit(&worker->write_idx, memory_order_acquire)) {
+            /* Announce that we are going to sleep, then check again so a post
+               made in between is not missed. */
+            atomic_store_explicit(&worker->sleeping, 1, memory_order_seq_cst);
+            thread_set_event(worker->not_full_event);
+            if (read_idx == atomic_load_explicit(&worker->write_idx, memory_order_seq_cst))
+                thread_wait_event(worker->wake_event, -1);
+            thread_reset_event(worker->wake_event);
+            atomic_store_explicit(&worker->sleeping, 0, memory_order_relaxed);
+            continue;
+        }
+
+        post = &worker->ring[read_idx & DEVICE_WORKER_MASK];
+        if (device_profile) {
+            uint64_t start = plat_get_nsecs();
+
+            worker->handler(worker->priv, post->type, post->addr, post->val);
+            device_prof_add(worker->priv, DEVICE_PROF_WORKER, start);
+        } else
+            worker->handler(worker->priv, post->type, post->addr, post->val);
+
+        atomic_store_explicit(&worker->read_idx, read_idx + 1, memory_order_release);
+    }
+
+    thread_set_event(worker->not_full_event);
+}
+
+device_worker_t *
+device_worker_create(const char *name,
+                     void (*handler)(void *priv, uint8_t type, uint32_t addr, uint32_t val),
+                     void *priv)
+{
+    device_worker_t *worker = (device_worker_t *) calloc(1, sizeof(device_worker_t));
+
+    worker->handler = handler;
+    worker->priv    = priv;
+
+    atomic_init(&worker->write_idx, 0);
+    atomic_init(&worker->read_idx, 0);
+    atomic_init(&worker->run, 1);
+    atomic_init(&worker->sleeping, 0);
+
+    worker->wake_event     = thread_create_event();
+    worker->not_full_event = thread_create_event();
+    worker->thread         = thread_create_named(device_worker_thread, worker, name);
+
+    return worker;
+}
+
+void
+device_worker_post(device_worker_t *worker, uint8_t type, uint32_t addr, uint32_t val)
+{
+    uint32_t       write_idx = atomic_load_explicit(&worker->write_idx, memory_order_relaxed);
+    device_post_t *post;
+
+    /* Wait for room in the ring. */
+    while ((write_idx - atomic_load_explicit(&worker->read_idx, memory_order_acquire)) >= DEVICE_WORKER_SIZE) {
+        thread_reset_event(worker->not_full_event);
+        thread_set_event(worker->wake_event);
+        if ((write_idx - atomic_load_explicit(&worker->read_idx, memory_order_acquire)) >= DEVICE_WORKER_SIZE)
+            thread_wait_event(worker->not_full_event, 1);
+    }
+
+    post       = &worker->ring[write_idx & DEVICE_WORKER_MASK];
+    post->addr = addr;
+    post->val  = val;
+    post->type = type;
+
+    atomic_store_explicit(&worker->write_idx, write_idx + 1, memory_order_seq_cst);
+
+    if (atomic_load_explicit(&worker->sleeping, memory_order_seq_cst))
+        thread_set_event(worker->wake_event);
+}
+
+int
+device_worker_busy(device_worker_t *worker)
+{
+    return atomic_load_explicit(&worker->read_idx, memory_order_acquire) !=
+           atomic_load_explicit(&worker->write_idx, memory_order_relaxed);
+}
+
+void
+device_worker_sync(device_worker_t *worker)
+{
+    while (device_worker_busy(worker)) {
+        thread_reset_event(worker->not_full_event);
+        thread_set_event(worker->wake_event);
+        if (device_worker_busy(worker))
+            thread_wait_event(worker->not_full_event, 1);
+    }
+}
+
+void
+device_worker_close(device_worker_t *worker)
+{
+    if (worker == NULL)
+        return;
+
+    device_worker_sync(worker);
+
+    atomic_store_explicit(&worker->run, 0, memory_order_release);
+    thread_set_event(worker->wake_event);
+    thread_wait(worker->thread);
+
+    thread_destroy_event(worker->wake_event);
+    thread_destroy_event(worker->not_full_event);
+
+    free(worker);
+}
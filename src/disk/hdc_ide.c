@@ -96,6 +96,7 @@
 #define WIN_SETIDLE1                   0xe3
 #define WIN_CHECKPOWERMODE1            0xe5
 #define WIN_SLEEP1                     0xe6
+#define WIN_FLUSH_CACHE                0xe7
 #define WIN_IDENTIFY                   0xec /* Ask drive to identify itself */
 #define WIN_SET_FEATURES               0xef
 #define WIN_READ_NATIVE_MAX            0xf8
@@ -623,6 +624,12 @@ ide_hd_identify(const ide_t *ide)
     ide->buffer[83] = ide->buffer[84] = 0x4000;
     ide->buffer[86] = 0x0000;
     ide->buffer[87] = 0x4000;
+
+    /* FLUSH CACHE supported and enabled. */
+    if (ide->buffer[80] & 0x0040) {
+        ide->buffer[83] |= 0x1000;
+        ide->buffer[86] |= 0x1000;
+    }
 }
 
 static void
@@ -788,6 +795,23 @@ ide_next_sector(ide_t *ide)
     ide->tf->head   = head & 0x0f;
 }
 
+/*
+ * Collect a sector of a PIO write, the whole command goes to the image in
+ * one request once its last sector is in.
+ */
+static int
+ide_write_sector(ide_t *ide)
+{
+    memcpy(&ide->sector_buffer[ide->sector_pos * 512], ide->buffer, 512);
+    ide->sector_pos++;
+
+    if (ide->tf->secount != 1)
+        return 0;
+
+    return hdd_image_write(ide->hdd_num, ide_get_sector(ide) - (ide->sector_pos - 1),
+                           ide->sector_pos, ide->sector_buffer);
+}
+
 static void
 loadhd(ide_t *ide, int d, UNUSED(const char *fn))
 {
@@ -1784,6 +1808,10 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
 
                     if (ide->type == IDE_HDD) {
                         ui_sb_update_icon(SB_HDD | hdd[ide->hdd_num].bus_type, 1);
+                        /* Let the host read run during the emulated seek. */
+                        if (ide->tf->lba || ide->cfg_spt)
+                            hdd_image_prefetch(ide->hdd_num, ide_get_sector(ide),
+                                               ide->tf->secount ? ide->tf->secount : 256);
                         uint32_t sec_count;
                         double   wait_time;
                         if ((val == WIN_READ_DMA) || (val == WIN_READ_DMA_ALT)) {
@@ -1832,6 +1860,7 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
                 case WIN_WRITE_NORETRY:
                     ide->tf->atastat = DRQ_STAT | DSC_STAT | DRDY_STAT;
                     ide->tf->pos    = 0;
+                    ide->sector_pos = 0;
                     break;
 
                 case WIN_WRITE_DMA:
@@ -1916,6 +1945,7 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
                 case WIN_SETIDLE1:          /* Idle */
                 case WIN_CHECKPOWERMODE1:
                 case WIN_SLEEP1:
+                case WIN_FLUSH_CACHE:
                     ide->tf->atastat = BSY_STAT;
                     ide_callback(ide);
                     break;
@@ -2344,6 +2374,18 @@ ide_callback(void *priv)
             ide_irq_raise(ide);
             break;
 
+        case WIN_FLUSH_CACHE:
+            if (ide->type == IDE_ATAPI)
+                err = ABRT_ERR;
+            else if (hdd_image_flush(ide->hdd_num) < 0) {
+                ide_log("IDE %i: Flush cache failed (image write error)\n", ide->channel);
+                err = ABRT_ERR;
+            } else {
+                ide->tf->atastat = DRDY_STAT | DSC_STAT;
+                ide_irq_raise(ide);
+            }
+            break;
+
         case WIN_READ:
         case WIN_READ_NORETRY:
             if (ide->type == IDE_ATAPI) {
@@ -2475,7 +2517,7 @@ ide_callback(void *priv)
                 err = IDNF_ERR;
             else {
                 ui_sb_update_icon_write(SB_HDD | hdd[ide->hdd_num].bus_type, 1);
-                ret = hdd_image_write(ide->hdd_num, ide_get_sector(ide), 1, (uint8_t *) ide->buffer);
+                ret = ide_write_sector(ide);
                 ide_irq_raise(ide);
                 ide->tf->secount--;
                 if (ide->tf->secount) {
@@ -2550,7 +2592,7 @@ ide_callback(void *priv)
             else if (!ide->tf->lba && (ide->cfg_spt == 0))
                 err = IDNF_ERR;
             else {
-                ret = hdd_image_write(ide->hdd_num, ide_get_sector(ide), 1, (uint8_t *) ide->buffer);
+                ret = ide_write_sector(ide);
                 ide->blockcount++;
                 if (ide->blockcount >= ide->blocksize || ide->tf->secount == 1) {
                     ide->blockcount = 0;
@@ -24,23 +24,136 @@
 #include <time.h>
 #include <wchar.h>
 #include <errno.h>
+#include <inttypes.h>
 #ifdef __unix__
 #include <unistd.h>
 #endif
+#ifdef _WIN32
+#    include <windows.h>
+#    include <io.h>
+#    define HDD_IMAGE_HAVE_MMAP
+#elif defined(__unix__) || defined(__APPLE__)
+#    include <sys/mman.h>
+#    define HDD_IMAGE_HAVE_MMAP
+#endif
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/random.h>
+#include <86box/thread.h>
 #include <86box/hdd.h>
+#include <86box/snapshot.h>
 #include "minivhd/minivhd.h"
 #include "minivhd/internal.h"
 
+#include <minitrace/minitrace.h>
+
 #define HDD_IMAGE_RAW 0
 #define HDD_IMAGE_HDI 1
 #define HDD_IMAGE_HDX 2
 #define HDD_IMAGE_VHD 3
 
+/* Largest read the controllers ask for ahead of time (a full 256 sector ATA
+   command), how far past it a sequential stream of commands is read ahead,
+   and how much written data may wait for the I/O thread before the
+   emulation blocks on it. */
+#define HDD_IO_PREFETCH_MAX 256
+#define HDD_IO_READ_AHEAD   256
+#define HDD_IO_WRITE_MAX    (4 << 20)
+
+/* A mapped image is synced in the background after this many written
+   sectors, and a guest streaming sectors gets this many read ahead. */
+#define HDD_MAP_SYNC_SECTORS 2048
+#define HDD_MAP_READ_AHEAD   2048
+
+enum {
+    HDD_IO_WRITE = 0,
+    HDD_IO_PREFETCH
+};
+
+enum {
+    PREFETCH_NONE = 0,
+    PREFETCH_QUEUED,
+    PREFETCH_DONE,
+    PREFETCH_STALE
+};
+
+typedef struct hdd_io_job_t {
+    struct hdd_io_job_t *next;
+
+    int      type;
+    uint32_t sector;
+    uint32_t count;
+    uint32_t seq;
+    uint8_t *data;
+} hdd_io_job_t;
+
+/*
+ * Host I/O for the RAW, HDI and HDX images runs on a thread of its own:
+ * writes are queued and return at once, and the controllers queue the read
+ * of a command as soon as it is issued, so the host read overlaps the seek
+ * and transfer time the controller emulates before it wants the data.
+ * Everything is done in submission order, and a read that was not queued
+ * ahead waits for the queue to drain, so the guest never sees stale data.
+ */
+typedef struct hdd_image_io_t {
+    thread_t *thread;
+    mutex_t  *mutex;
+    event_t  *wake_event;
+    event_t  *done_event;
+
+    hdd_io_job_t *head;
+    hdd_io_job_t *tail;
+    int           busy;
+    int           run;
+    int           write_error;
+    uint32_t      write_bytes;
+
+    int      prefetch_state;
+    int      prefetch_result;
+    uint32_t prefetch_seq;
+    uint32_t prefetch_sector;
+    uint32_t prefetch_count;
+    uint8_t  prefetch_buffer[(HDD_IO_PREFETCH_MAX + HDD_IO_READ_AHEAD) * 512];
+} hdd_image_io_t;
+
+/* The write-back cache works on lines of 4 kB. */
+#define HDD_CACHE_LINE_SECTORS 8
+#define HDD_CACHE_LINE_SHIFT   3
+#define HDD_CACHE_LINE_MASK    (HDD_CACHE_LINE_SECTORS - 1)
+
+/* Seconds without a write before dirty lines are written back. */
+#define HDD_CACHE_IDLE_SECS 2
+
+typedef struct hdd_image_cache_line_t {
+    uint32_t tag; /* Sector number >> HDD_CACHE_LINE_SHIFT. */
+    int32_t  hash_next;
+    int32_t  lru_prev;
+    int32_t  lru_next;
+    uint8_t  valid; /* One bit per sector. */
+    uint8_t  dirty;
+} hdd_image_cache_line_t;
+
+typedef struct hdd_image_cache_t {
+    hdd_image_cache_line_t *lines;
+    uint8_t                *data;
+    int32_t                *hash;
+    uint32_t                hash_mask;
+    uint32_t                num_lines;
+    uint32_t                used;
+    int32_t                 lru_head; /* Most recently used. */
+    int32_t                 lru_tail;
+    uint32_t                dirty_lines;
+    uint32_t                idle_secs;
+    uint8_t                 write_through;
+} hdd_image_cache_t;
+
+/* The overlay copies the base image in blocks of 64 kB. */
+#define HDD_OVERLAY_BLOCK_SECTORS 128
+#define HDD_OVERLAY_BLOCK_SHIFT   7
+#define HDD_OVERLAY_BLOCK_MASK    (HDD_OVERLAY_BLOCK_SECTORS - 1)
+
 typedef struct hdd_image_t {
     FILE     *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
     MVHDMeta *vhd;  /* Used for HDD_IMAGE_VHD. */
@@ -49,9 +162,38 @@ typedef struct hdd_image_t {
     uint32_t  last_sector;
     uint8_t   type; /* HDD_IMAGE_RAW, HDD_IMAGE_HDI, HDD_IMAGE_HDX, or HDD_IMAGE_VHD */
     uint8_t   loaded;
+
+    hdd_image_io_t *io;        /* Started on the first queued request. */
+    uint32_t        read_next; /* First sector after the last read, to spot sequential streams. */
+
+    /* RAW, HDI and HDX images mapped into memory, with hdd_image_mmap set. */
+    uint8_t *map;
+    uint64_t map_size;
+#ifdef _WIN32
+    HANDLE map_handle;
+#endif
+    uint32_t map_dirty;
+    uint32_t map_next;
+    uint8_t  map_failed;
+
+    hdd_image_cache_t *cache;
+
+    /* Copy-on-write overlay over the read-only image, with hdd[id].overlay
+       set. Blocks are appended to the overlay file on their first write,
+       the file is deleted when the image is closed. */
+    FILE     *overlay;
+    char      overlay_fn[1024];
+    uint32_t *overlay_map; /* Overlay block + 1 of each image block, 0 = not copied. */
+    uint32_t  overlay_num_blocks;
+    uint32_t  overlay_used;
+    uint8_t  *overlay_buffer;
 } hdd_image_t;
 
 hdd_image_t hdd_images[HDD_NUM];
+int         hdd_image_mmap                = 0; /* (C) map RAW, HDI and HDX images into memory */
+int         hdd_image_cache_size          = 0; /* (C) write-back cache size in MB, 0 = off */
+int         hdd_image_cache_write_through = 0; /* (C) the cache never holds dirty sectors */
+uint64_t    hdd_image_ops                 = 0; /* reads, writes and zeroes since startup */
 
 static char  empty_sector[512];
 #ifndef __unix__
@@ -248,8 +390,53 @@ hdd_image_init(void)
         memset(&hdd_images[i], 0, sizeof(hdd_image_t));
 }
 
-int
-hdd_image_load(int id)
+/* Start an empty overlay over the image that was just loaded, in the VM directory. */
+static int
+hdd_image_overlay_open(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+    char         prefix[16];
+    char         fn[1024];
+
+    sprintf(prefix, "hdd%02i", id);
+    plat_tempfile(fn, prefix, ".tmp");
+    path_append_filename(img->overlay_fn, usr_path, fn);
+
+    img->overlay = plat_fopen64(img->overlay_fn, "w+b");
+    if (img->overlay == NULL)
+        return 0;
+
+    img->overlay_num_blocks = (img->last_sector >> HDD_OVERLAY_BLOCK_SHIFT) + 1;
+    img->overlay_map        = (uint32_t *) calloc(img->overlay_num_blocks, sizeof(uint32_t));
+    img->overlay_buffer     = (uint8_t *) malloc(HDD_OVERLAY_BLOCK_SECTORS << 9);
+    img->overlay_used       = 0;
+
+    hdd_image_log("Hard disk image %i: Overlay in %s\n", id, img->overlay_fn);
+
+    return 1;
+}
+
+/* Throw the overlay and everything written to it away. */
+static void
+hdd_image_overlay_close(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    if (img->overlay == NULL)
+        return;
+
+    fclose(img->overlay);
+    img->overlay = NULL;
+    plat_remove(img->overlay_fn);
+
+    free(img->overlay_map);
+    img->overlay_map = NULL;
+    free(img->overlay_buffer);
+    img->overlay_buffer = NULL;
+}
+
+static int
+hdd_image_load_image(int id)
 {
     uint32_t sector_size = 512;
     uint32_t zero        = 0;
@@ -273,6 +460,7 @@ hdd_image_load(int id)
     hdd_images[id].base = 0;
 
     if (hdd_images[id].loaded) {
+        hdd_image_overlay_close(id);
         if (hdd_images[id].file) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
@@ -297,14 +485,15 @@ hdd_image_load(int id)
         memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
         goto fail_raw;
     }
-    hdd_images[id].file = plat_fopen(fn, "rb+");
+    /* An image with an overlay is never written to. */
+    hdd_images[id].file = plat_fopen(fn, hdd[id].overlay ? "rb" : "rb+");
     if (hdd_images[id].file == NULL) {
         /* Failed to open existing hard disk image */
         if (errno == ENOENT) {
             /* Failed because it does not exist,
                so try to create new file */
-            if (hdd[id].wp) {
-                hdd_image_log("A write-protected image must exist\n");
+            if (hdd[id].wp || hdd[id].overlay) {
+                hdd_image_log("A write-protected or overlaid image must exist\n");
                 memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
                 goto fail_raw;
             }
@@ -464,7 +653,7 @@ fail_raw:
         } else if (is_vhd[1]) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
-            hdd_images[id].vhd  = mvhd_open(fn, (bool) 0, &vhd_error);
+            hdd_images[id].vhd  = mvhd_open(fn, (bool) hdd[id].overlay, &vhd_error);
             if (hdd_images[id].vhd == NULL) {
                 if (vhd_error == MVHD_ERR_FILE)
                     fatal("hdd_image_load(): VHD: Error opening VHD file '%s': %s\n", fn, strerror(mvhd_errno));
@@ -497,7 +686,7 @@ fail_raw:
     if (fseeko64(hdd_images[id].file, 0, SEEK_END) == -1)
         fatal("hdd_image_load(): Error seeking to the end of file\n");
     s = ftello64(hdd_images[id].file);
-    if (s < (full_size + hdd_images[id].base))
+    if ((s < (full_size + hdd_images[id].base)) && !hdd[id].overlay)
         ret = prepare_new_hard_disk(id, full_size);
     else {
         hdd_images[id].last_sector = (uint32_t) (full_size >> 9) - 1;
@@ -508,6 +697,450 @@ fail_raw:
     return ret;
 }
 
+int
+hdd_image_load(int id)
+{
+    int ret = hdd_image_load_image(id);
+
+    if ((ret > 0) && hdd[id].overlay && hdd_images[id].loaded && !hdd_image_overlay_open(id))
+        fatal("hdd_image_load(): Could not create the overlay for '%s'\n", hdd[id].fn);
+
+    return ret;
+}
+
+static int
+hdd_image_io_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    size_t num_read;
+
+    if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
+        hdd_image_log("Hard disk image %i: Read error during seek\n", id);
+        return -1;
+    }
+
+    num_read = fread(buffer, 512, count, hdd_images[id].file);
+    if ((num_read < count) && !feof(hdd_images[id].file))
+        return -1;
+
+    return (int) num_read;
+}
+
+static int
+hdd_image_io_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
+        hdd_image_log("Hard disk image %i: Write error during seek\n", id);
+        return -1;
+    }
+
+    return (int) fwrite(buffer, 512, count, hdd_images[id].file);
+}
+
+static void
+hdd_image_io_thread(void *param)
+{
+    uint8_t         id = (uint8_t) (uintptr_t) param;
+    hdd_image_io_t *io = hdd_images[id].io;
+    hdd_io_job_t   *job;
+    int             ret;
+
+    while (1) {
+        thread_wait_event(io->wake_event, -1);
+        thread_reset_event(io->wake_event);
+
+        thread_wait_mutex(io->mutex);
+        while ((job = io->head) != NULL) {
+            thread_release_mutex(io->mutex);
+
+            if (job->type == HDD_IO_PREFETCH)
+                ret = hdd_image_io_read(id, job->sector, job->count, io->prefetch_buffer);
+            else
+                ret = hdd_image_io_write(id, job->sector, job->count, job->data);
+
+            /* Flush once the burst is over rather than after every write. */
+            if ((job->next == NULL) && (job->type == HDD_IO_WRITE))
+                fflush(hdd_images[id].file);
+
+            thread_wait_mutex(io->mutex);
+            /* A read made stale by a write may have been replaced already. */
+            if ((job->type == HDD_IO_PREFETCH) && (job->seq == io->prefetch_seq)) {
+                io->prefetch_result = ret;
+                if (io->prefetch_state == PREFETCH_QUEUED)
+                    io->prefetch_state = PREFETCH_DONE;
+            } else if (job->type == HDD_IO_WRITE) {
+                if (ret < (int) job->count)
+                    io->write_error = 1;
+                io->write_bytes -= job->count << 9;
+            }
+            io->head = job->next;
+            if (io->head == NULL)
+                io->tail = NULL;
+            io->busy = (io->head != NULL);
+            thread_set_event(io->done_event);
+            thread_release_mutex(io->mutex);
+
+            free(job->data);
+            free(job);
+
+            thread_wait_mutex(io->mutex);
+        }
+        ret = io->run;
+        thread_release_mutex(io->mutex);
+
+        if (!ret)
+            break;
+    }
+}
+
+static hdd_image_io_t *
+hdd_image_io_start(uint8_t id)
+{
+    hdd_image_io_t *io = hdd_images[id].io;
+
+    if ((io != NULL) || (hdd_images[id].type == HDD_IMAGE_VHD) || !hdd_images[id].file)
+        return io;
+
+    io             = (hdd_image_io_t *) calloc(1, sizeof(hdd_image_io_t));
+    io->mutex      = thread_create_mutex();
+    io->wake_event = thread_create_event();
+    io->done_event = thread_create_event();
+    io->run        = 1;
+
+    hdd_images[id].io = io;
+    io->thread        = thread_create_named(hdd_image_io_thread, (void *) (uintptr_t) id, "HDD I/O");
+
+    return io;
+}
+
+/* Block until the condition holds, checked under the lock after every
+   completed job. */
+static void
+hdd_image_io_wait(hdd_image_io_t *io, int (*done)(const hdd_image_io_t *io))
+{
+    while (1) {
+        thread_wait_mutex(io->mutex);
+        if (done(io)) {
+            thread_release_mutex(io->mutex);
+            return;
+        }
+        thread_reset_event(io->done_event);
+        thread_release_mutex(io->mutex);
+
+        thread_wait_event(io->done_event, -1);
+    }
+}
+
+static int
+hdd_image_io_idle(const hdd_image_io_t *io)
+{
+    return !io->busy;
+}
+
+static int
+hdd_image_io_prefetched(const hdd_image_io_t *io)
+{
+    return io->prefetch_state != PREFETCH_QUEUED;
+}
+
+static int
+hdd_image_io_has_room(const hdd_image_io_t *io)
+{
+    return io->write_bytes < HDD_IO_WRITE_MAX;
+}
+
+static void
+hdd_image_io_queue(hdd_image_io_t *io, hdd_io_job_t *job)
+{
+    thread_wait_mutex(io->mutex);
+    if (io->tail != NULL)
+        io->tail->next = job;
+    else
+        io->head = job;
+    io->tail = job;
+    io->busy = 1;
+    if (job->type == HDD_IO_WRITE)
+        io->write_bytes += job->count << 9;
+    thread_release_mutex(io->mutex);
+
+    thread_set_event(io->wake_event);
+}
+
+/* A changed range can no longer be served from an earlier read. Every path
+   that changes the image file while the I/O thread is running goes here. */
+static void
+hdd_image_io_invalidate(hdd_image_io_t *io, uint32_t sector, uint32_t count)
+{
+    if (io == NULL)
+        return;
+
+    thread_wait_mutex(io->mutex);
+    if ((io->prefetch_state != PREFETCH_NONE) && (sector < (io->prefetch_sector + io->prefetch_count)) &&
+        ((sector + count) > io->prefetch_sector))
+        io->prefetch_state = PREFETCH_STALE;
+    thread_release_mutex(io->mutex);
+}
+
+/* Make the file the emulation thread's again. */
+static void
+hdd_image_io_flush(uint8_t id)
+{
+    if (hdd_images[id].io != NULL)
+        hdd_image_io_wait(hdd_images[id].io, hdd_image_io_idle);
+}
+
+static void
+hdd_image_io_stop(uint8_t id)
+{
+    hdd_image_io_t *io = hdd_images[id].io;
+
+    if (io == NULL)
+        return;
+
+    hdd_image_io_wait(io, hdd_image_io_idle);
+
+    thread_wait_mutex(io->mutex);
+    io->run = 0;
+    thread_release_mutex(io->mutex);
+    thread_set_event(io->wake_event);
+    thread_wait(io->thread);
+
+    thread_destroy_event(io->wake_event);
+    thread_destroy_event(io->done_event);
+    thread_close_mutex(io->mutex);
+    free(io);
+
+    hdd_images[id].io = NULL;
+}
+
+#ifdef HDD_IMAGE_HAVE_MMAP
+/* Map the sectors of the image, data only, once the file has its full size. */
+static void
+hdd_image_map(uint8_t id)
+{
+    hdd_image_t *img      = &hdd_images[id];
+    uint64_t     map_size = ((uint64_t) img->last_sector + 1) << 9LL;
+    uint8_t     *map      = NULL;
+
+    img->map_failed = 1;
+
+    if (!img->loaded || !img->file || (img->type == HDD_IMAGE_VHD) || (img->last_sector == (uint32_t) -1))
+        return;
+    if ((map_size + img->base) > (uint64_t) SIZE_MAX)
+        return;
+
+    hdd_image_io_stop(id);
+    fflush(img->file);
+
+    if ((fseeko64(img->file, 0, SEEK_END) == -1) || (ftello64(img->file) < (off64_t) (map_size + img->base)))
+        return;
+
+#ifdef _WIN32
+    img->map_handle = CreateFileMapping((HANDLE) _get_osfhandle(_fileno(img->file)), NULL, PAGE_READWRITE, 0, 0, NULL);
+    if (img->map_handle == NULL)
+        return;
+
+    map = (uint8_t *) MapViewOfFile(img->map_handle, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T) (map_size + img->base));
+    if (map == NULL) {
+        CloseHandle(img->map_handle);
+        img->map_handle = NULL;
+        return;
+    }
+#else
+    map = (uint8_t *) mmap(NULL, (size_t) (map_size + img->base), PROT_READ | PROT_WRITE, MAP_SHARED,
+                           fileno(img->file), 0);
+    if (map == MAP_FAILED)
+        return;
+#endif
+
+    hdd_image_log("Hard disk image %i: Mapped %" PRIu64 " bytes\n", id, map_size);
+
+    img->map        = map;
+    img->map_size   = map_size;
+    img->map_dirty  = 0;
+    img->map_next   = (uint32_t) -1;
+    img->map_failed = 0;
+}
+
+static void
+hdd_image_map_sync(uint8_t id, int wait)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    if ((img->map == NULL) || !img->map_dirty)
+        return;
+
+#ifdef _WIN32
+    FlushViewOfFile(img->map, 0);
+    if (wait)
+        FlushFileBuffers((HANDLE) _get_osfhandle(_fileno(img->file)));
+#else
+    msync(img->map, (size_t) (img->map_size + img->base), wait ? MS_SYNC : MS_ASYNC);
+#endif
+    img->map_dirty = 0;
+}
+
+static void
+hdd_image_unmap(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    if (img->map != NULL) {
+        hdd_image_map_sync(id, 1);
+#ifdef _WIN32
+        UnmapViewOfFile(img->map);
+        CloseHandle(img->map_handle);
+        img->map_handle = NULL;
+#else
+        munmap(img->map, (size_t) (img->map_size + img->base));
+#endif
+        img->map = NULL;
+    }
+
+    img->map_failed = 0;
+}
+
+/* The mapping, if the image is (or can now be) mapped. */
+static uint8_t *
+hdd_image_get_map(uint8_t id)
+{
+    if ((hdd_images[id].map == NULL) && hdd_image_mmap && !hdd_images[id].map_failed && !hdd[id].overlay)
+        hdd_image_map(id);
+
+    return hdd_images[id].map;
+}
+
+/* Sectors of a request that are inside the mapping. */
+static uint32_t
+hdd_image_map_count(uint8_t id, uint32_t sector, uint32_t count)
+{
+    uint32_t sectors = (uint32_t) (hdd_images[id].map_size >> 9);
+
+    if (sector >= sectors)
+        return 0;
+
+    return ((sectors - sector) < count) ? (sectors - sector) : count;
+}
+
+static void
+hdd_image_map_read_ahead(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    /* Only hint once the guest reads the sectors right after the last ones. */
+    if (sector == img->map_next) {
+        uint32_t ahead = hdd_image_map_count(id, sector + count, HDD_MAP_READ_AHEAD);
+
+        if (ahead > 0) {
+#ifdef _WIN32
+            /* Windows already reads ahead on mapped files. */
+#else
+            uintptr_t page  = (uintptr_t) sysconf(_SC_PAGESIZE);
+            uintptr_t start = (uintptr_t) &img->map[img->base + ((uint64_t) (sector + count) << 9)];
+            uintptr_t end   = start + ((uintptr_t) ahead << 9);
+
+            start &= ~(page - 1);
+            madvise((void *) start, end - start, MADV_WILLNEED);
+#endif
+        }
+    }
+
+    img->map_next = sector + count;
+}
+#else
+#    define hdd_image_get_map(id)                    NULL
+#    define hdd_image_map_count(id, sector, count)   0
+#    define hdd_image_map_read_ahead(id, sector, count)
+#    define hdd_image_map_sync(id, wait)
+#    define hdd_image_unmap(id)
+#endif
+
+/* Whether a queued or finished read has all of the sectors. A read whose
+   range was written or zeroed since is stale and never handed out again,
+   see hdd_image_io_invalidate(). */
+static int
+hdd_image_io_has(hdd_image_io_t *io, uint32_t sector, uint32_t count)
+{
+    int ret;
+
+    thread_wait_mutex(io->mutex);
+    ret = ((io->prefetch_state == PREFETCH_QUEUED) || (io->prefetch_state == PREFETCH_DONE)) &&
+          (sector >= io->prefetch_sector) && ((sector + count) <= (io->prefetch_sector + io->prefetch_count));
+    thread_release_mutex(io->mutex);
+
+    return ret;
+}
+
+static void
+hdd_image_io_prefetch(hdd_image_io_t *io, uint32_t sector, uint32_t count)
+{
+    hdd_io_job_t *job;
+
+    /* The buffer is the I/O thread's until a queued read is done. */
+    hdd_image_io_wait(io, hdd_image_io_prefetched);
+
+    thread_wait_mutex(io->mutex);
+    io->prefetch_sector = sector;
+    io->prefetch_count  = count;
+    io->prefetch_state  = PREFETCH_QUEUED;
+    io->prefetch_seq++;
+    thread_release_mutex(io->mutex);
+
+    job         = (hdd_io_job_t *) calloc(1, sizeof(hdd_io_job_t));
+    job->type   = HDD_IO_PREFETCH;
+    job->sector = sector;
+    job->count  = count;
+    job->seq    = io->prefetch_seq;
+    hdd_image_io_queue(io, job);
+}
+
+/* After a read that continued the previous one, start on the one after it. */
+static void
+hdd_image_io_read_ahead(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_io_t *io;
+    int             sequential = (sector == hdd_images[id].read_next);
+
+    hdd_images[id].read_next = sector + count;
+
+    if (!sequential || (count > HDD_IO_READ_AHEAD) || ((io = hdd_image_io_start(id)) == NULL) ||
+        hdd_image_io_has(io, sector + count, count))
+        return;
+
+    hdd_image_io_prefetch(io, sector + count, count);
+}
+
+/* Start reading sectors the controller is about to ask for. */
+void
+hdd_image_prefetch(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_io_t *io;
+    uint32_t        ahead;
+
+    if (!hdd_images[id].loaded || (count == 0) || (count > HDD_IO_PREFETCH_MAX))
+        return;
+
+    /* A mapped image reads straight from the mapping. */
+    if (hdd_image_get_map(id) != NULL) {
+        hdd_image_map_read_ahead(id, sector, 0);
+        return;
+    }
+
+    if ((io = hdd_image_io_start(id)) == NULL)
+        return;
+
+    /* A command that picks up where the previous one ended gets the next
+       one read along with it, and finds its own sectors already there. */
+    if (hdd_image_io_has(io, sector, count)) {
+        hdd_images[id].read_next = sector + count;
+        return;
+    }
+
+    ahead                    = (sector == hdd_images[id].read_next) ? MIN(count, HDD_IO_READ_AHEAD) : 0;
+    hdd_images[id].read_next = sector + count;
+
+    hdd_image_io_prefetch(io, sector, count + ahead);
+}
+
 int
 hdd_image_seek(uint8_t id, uint32_t sector)
 {
@@ -515,7 +1148,8 @@ hdd_image_seek(uint8_t id, uint32_t sector)
     addr         = (uint64_t) sector << 9LL;
 
     hdd_images[id].pos = sector;
-    if (hdd_images[id].type != HDD_IMAGE_VHD) {
+    if ((hdd_images[id].type != HDD_IMAGE_VHD) && (hdd_images[id].map == NULL)) {
+        hdd_image_io_flush(id);
         if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, addr + hdd_images[id].base, SEEK_SET) == -1)) {
             hdd_image_log("hdd_image_seek(): Error seeking\n");
             return -1;
@@ -525,11 +1159,13 @@ hdd_image_seek(uint8_t id, uint32_t sector)
     return 0;
 }
 
-int
-hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static int
+hdd_image_read_file(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
-    int    non_transferred_sectors;
-    size_t num_read;
+    hdd_image_io_t *io = hdd_images[id].io;
+    uint8_t        *map;
+    int             non_transferred_sectors;
+    int             num_read;
 
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         hdd_images[id].vhd->error = 0;
@@ -537,16 +1173,44 @@ hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         hdd_images[id].pos        = sector + count - non_transferred_sectors - 1;
         if (hdd_images[id].vhd->error)
             return -1;
+    } else if ((map = hdd_image_get_map(id)) != NULL) {
+        num_read = (int) hdd_image_map_count(id, sector, count);
+        memcpy(buffer, &map[hdd_images[id].base + ((uint64_t) sector << 9)], (size_t) num_read << 9);
+        hdd_images[id].pos = sector + num_read;
+
+        hdd_image_map_read_ahead(id, sector, count);
     } else {
-        if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
-            hdd_image_log("Hard disk image %i: Read error during seek\n", id);
-            return -1;
+        if ((io != NULL) && hdd_image_io_has(io, sector, count)) {
+            hdd_image_io_wait(io, hdd_image_io_prefetched);
+
+            if (io->prefetch_state == PREFETCH_DONE) {
+                num_read = io->prefetch_result;
+                if (num_read < 0)
+                    return -1;
+
+                /* Short reads at the end of the image behave as fread. */
+                num_read -= (int) (sector - io->prefetch_sector);
+                if (num_read < 0)
+                    num_read = 0;
+                else if (num_read > (int) count)
+                    num_read = (int) count;
+
+                memcpy(buffer, &io->prefetch_buffer[(sector - io->prefetch_sector) << 9], num_read << 9);
+                hdd_images[id].pos = sector + num_read;
+
+                hdd_image_io_read_ahead(id, sector, count);
+                return 0;
+            }
         }
 
-        num_read           = fread(buffer, 512, count, hdd_images[id].file);
-        hdd_images[id].pos = sector + num_read;
-        if ((num_read < count) && !feof(hdd_images[id].file))
+        hdd_image_io_flush(id);
+
+        num_read = hdd_image_io_read(id, sector, count, buffer);
+        if (num_read < 0)
             return -1;
+        hdd_images[id].pos = sector + num_read;
+
+        hdd_image_io_read_ahead(id, sector, count);
     }
 
     return 0;
@@ -581,11 +1245,14 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
-int
-hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static int
+hdd_image_write_file(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
-    int    non_transferred_sectors;
-    size_t num_write;
+    hdd_image_io_t *io;
+    hdd_io_job_t   *job;
+    uint8_t        *map;
+    int             non_transferred_sectors;
+    int             num_write;
 
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         hdd_images[id].vhd->error = 0;
@@ -593,29 +1260,624 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         hdd_images[id].pos        = sector + count - non_transferred_sectors - 1;
         if (hdd_images[id].vhd->error)
             return -1;
-    } else {
-        if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
-            hdd_image_log("Hard disk image %i: Write error during seek\n", id);
+    } else if ((map = hdd_image_get_map(id)) != NULL) {
+        num_write = (int) hdd_image_map_count(id, sector, count);
+        memcpy(&map[hdd_images[id].base + ((uint64_t) sector << 9)], buffer, (size_t) num_write << 9);
+        hdd_images[id].pos = sector + num_write;
+
+        hdd_images[id].map_dirty += num_write;
+        if (hdd_images[id].map_dirty >= HDD_MAP_SYNC_SECTORS)
+            hdd_image_map_sync(id, 0);
+
+        if (num_write < (int) count)
             return -1;
-        }
+    } else if ((io = hdd_image_io_start(id)) != NULL) {
+        hdd_image_io_invalidate(io, sector, count);
+
+        if (!hdd_image_io_has_room(io))
+            hdd_image_io_wait(io, hdd_image_io_has_room);
+
+        /* A failed write can only be reported on a later one, the way a
+           drive with its write cache on reports it. */
+        thread_wait_mutex(io->mutex);
+        num_write       = io->write_error;
+        io->write_error = 0;
+        thread_release_mutex(io->mutex);
+        if (num_write)
+            return -1;
+
+        job         = (hdd_io_job_t *) calloc(1, sizeof(hdd_io_job_t));
+        job->type   = HDD_IO_WRITE;
+        job->sector = sector;
+        job->count  = count;
+        job->data   = (uint8_t *) malloc(count << 9);
+        memcpy(job->data, buffer, count << 9);
+        hdd_image_io_queue(io, job);
 
-        num_write          = fwrite(buffer, 512, count, hdd_images[id].file);
+        hdd_images[id].pos = sector + count;
+    } else {
+        num_write = hdd_image_io_write(id, sector, count, buffer);
+        if (num_write < 0)
+            return -1;
         hdd_images[id].pos = sector + num_write;
         fflush(hdd_images[id].file);
-        if (num_write < count)
+        if (num_write < (int) count)
             return -1;
     }
 
     return 0;
 }
 
-int
-hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static uint64_t
+hdd_image_overlay_offset(const hdd_image_t *img, uint32_t block, uint32_t sector)
 {
-    uint32_t transfer_sectors = count;
-    uint32_t sectors          = hdd_sectors(id);
+    return ((uint64_t) (img->overlay_map[block] - 1) << (HDD_OVERLAY_BLOCK_SHIFT + 9)) +
+           ((uint64_t) (sector & HDD_OVERLAY_BLOCK_MASK) << 9);
+}
 
-    if ((sectors - sector) < transfer_sectors)
+static int
+hdd_image_overlay_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_t *img = &hdd_images[id];
+    uint32_t     end = sector + count;
+    uint32_t     block;
+    uint32_t     run;
+
+    while (sector < end) {
+        block = sector >> HDD_OVERLAY_BLOCK_SHIFT;
+        run   = HDD_OVERLAY_BLOCK_SECTORS - (sector & HDD_OVERLAY_BLOCK_MASK);
+        if (run > (end - sector))
+            run = end - sector;
+
+        if ((block >= img->overlay_num_blocks) || (img->overlay_map[block] == 0)) {
+            /* Read every following block that is only in the image at once. */
+            while (((sector + run) < end) && (((sector + run) >> HDD_OVERLAY_BLOCK_SHIFT) < img->overlay_num_blocks) &&
+                   (img->overlay_map[(sector + run) >> HDD_OVERLAY_BLOCK_SHIFT] == 0)) {
+                run += HDD_OVERLAY_BLOCK_SECTORS;
+                if (run > (end - sector))
+                    run = end - sector;
+            }
+
+            if (hdd_image_read_file(id, sector, run, buffer) < 0)
+                return -1;
+        } else if ((fseeko64(img->overlay, hdd_image_overlay_offset(img, block, sector), SEEK_SET) == -1) ||
+                   (fread(buffer, 512, run, img->overlay) != run)) {
+            hdd_image_log("Hard disk image %i: Overlay read error\n", id);
+            return -1;
+        }
+
+        sector += run;
+        buffer += run << 9;
+    }
+
+    img->pos = end;
+
+    return 0;
+}
+
+static int
+hdd_image_overlay_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_t *img = &hdd_images[id];
+    uint32_t     end = sector + count;
+    uint32_t     block;
+    uint32_t     start;
+    uint32_t     run;
+    uint32_t     copy;
+    uint8_t     *data;
+
+    while (sector < end) {
+        block = sector >> HDD_OVERLAY_BLOCK_SHIFT;
+        run   = HDD_OVERLAY_BLOCK_SECTORS - (sector & HDD_OVERLAY_BLOCK_MASK);
+        if (run > (end - sector))
+            run = end - sector;
+
+        if (block >= img->overlay_num_blocks)
+            return -1;
+
+        start = sector;
+        copy  = run;
+        data  = buffer;
+
+        if (img->overlay_map[block] == 0) {
+            /* The first write to a block brings the rest of it over from
+               the image, and appends it to the overlay. */
+            start = block << HDD_OVERLAY_BLOCK_SHIFT;
+            copy  = HDD_OVERLAY_BLOCK_SECTORS;
+            data  = img->overlay_buffer;
+
+            if (run < HDD_OVERLAY_BLOCK_SECTORS) {
+                memset(data, 0, HDD_OVERLAY_BLOCK_SECTORS << 9);
+                if (hdd_image_read_file(id, start, MIN(copy, img->last_sector + 1 - start), data) < 0)
+                    return -1;
+            }
+            memcpy(&data[(sector - start) << 9], buffer, run << 9);
+
+            img->overlay_map[block] = ++img->overlay_used;
+        }
+
+        if ((fseeko64(img->overlay, hdd_image_overlay_offset(img, block, start), SEEK_SET) == -1) ||
+            (fwrite(data, 512, copy, img->overlay) != copy)) {
+            hdd_image_log("Hard disk image %i: Overlay write error\n", id);
+            /* A block that could not be appended is still in the image. */
+            if (data == img->overlay_buffer) {
+                img->overlay_map[block] = 0;
+                img->overlay_used--;
+            }
+            return -1;
+        }
+
+        sector += run;
+        buffer += run << 9;
+    }
+
+    img->pos = end;
+
+    return 0;
+}
+
+static int
+hdd_image_read_image(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (hdd_images[id].overlay != NULL)
+        return hdd_image_overlay_read(id, sector, count, buffer);
+
+    return hdd_image_read_file(id, sector, count, buffer);
+}
+
+static int
+hdd_image_write_image(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (hdd_images[id].overlay != NULL)
+        return hdd_image_overlay_write(id, sector, count, buffer);
+
+    return hdd_image_write_file(id, sector, count, buffer);
+}
+
+/* Push every dirty sector of the image to the image file and wait for it. */
+static int
+hdd_image_sync(uint8_t id)
+{
+    hdd_image_io_t *io = hdd_images[id].io;
+    int             ret = 0;
+
+    if (io != NULL) {
+        hdd_image_io_wait(io, hdd_image_io_idle);
+
+        thread_wait_mutex(io->mutex);
+        ret             = io->write_error ? -1 : 0;
+        io->write_error = 0;
+        thread_release_mutex(io->mutex);
+    }
+
+    if (hdd_images[id].overlay != NULL) {
+        if (fflush(hdd_images[id].overlay) != 0)
+            ret = -1;
+    } else if (hdd_images[id].vhd != NULL)
+        mvhd_flush(hdd_images[id].vhd);
+    else if (hdd_images[id].map != NULL)
+        hdd_image_map_sync(id, 1);
+    else if (hdd_images[id].file != NULL)
+        fflush(hdd_images[id].file);
+
+    return ret;
+}
+
+static void
+hdd_image_cache_unlink(hdd_image_cache_t *cache, int32_t idx)
+{
+    hdd_image_cache_line_t *line = &cache->lines[idx];
+
+    if (line->lru_prev >= 0)
+        cache->lines[line->lru_prev].lru_next = line->lru_next;
+    else
+        cache->lru_head = line->lru_next;
+
+    if (line->lru_next >= 0)
+        cache->lines[line->lru_next].lru_prev = line->lru_prev;
+    else
+        cache->lru_tail = line->lru_prev;
+}
+
+static void
+hdd_image_cache_touch(hdd_image_cache_t *cache, int32_t idx)
+{
+    hdd_image_cache_line_t *line = &cache->lines[idx];
+
+    if (cache->lru_head == idx)
+        return;
+
+    hdd_image_cache_unlink(cache, idx);
+
+    line->lru_prev = -1;
+    line->lru_next = cache->lru_head;
+    if (cache->lru_head >= 0)
+        cache->lines[cache->lru_head].lru_prev = idx;
+    cache->lru_head = idx;
+    if (cache->lru_tail < 0)
+        cache->lru_tail = idx;
+}
+
+static int32_t
+hdd_image_cache_find(const hdd_image_cache_t *cache, uint32_t tag)
+{
+    int32_t idx = cache->hash[tag & cache->hash_mask];
+
+    while ((idx >= 0) && (cache->lines[idx].tag != tag))
+        idx = cache->lines[idx].hash_next;
+
+    return idx;
+}
+
+static void
+hdd_image_cache_set_dirty(hdd_image_cache_t *cache, hdd_image_cache_line_t *line, uint8_t dirty)
+{
+    if (!line->dirty && dirty)
+        cache->dirty_lines++;
+    else if (line->dirty && !dirty)
+        cache->dirty_lines--;
+
+    line->dirty = dirty;
+}
+
+/* Write the dirty sectors of a line to the image, one request per run. */
+static int
+hdd_image_cache_write_back(uint8_t id, int32_t idx)
+{
+    hdd_image_cache_t      *cache = hdd_images[id].cache;
+    hdd_image_cache_line_t *line  = &cache->lines[idx];
+    uint8_t                *data  = &cache->data[(size_t) idx * (HDD_CACHE_LINE_SECTORS << 9)];
+    int                     ret   = 0;
+    int                     first;
+    int                     last;
+
+    for (first = 0; first < HDD_CACHE_LINE_SECTORS; first = last) {
+        if (!(line->dirty & (1 << first))) {
+            last = first + 1;
+            continue;
+        }
+
+        for (last = first + 1; (last < HDD_CACHE_LINE_SECTORS) && (line->dirty & (1 << last)); last++)
+            ;
+
+        if (hdd_image_write_image(id, (line->tag << HDD_CACHE_LINE_SHIFT) + first, last - first, &data[first << 9]) < 0)
+            ret = -1;
+    }
+
+    hdd_image_cache_set_dirty(cache, line, 0);
+
+    return ret;
+}
+
+/* The line for a tag, taking the least recently used one if it is not cached. */
+static int32_t
+hdd_image_cache_get(uint8_t id, uint32_t tag, int *ret)
+{
+    hdd_image_cache_t      *cache = hdd_images[id].cache;
+    hdd_image_cache_line_t *line;
+    int32_t                *link;
+    int32_t                 idx   = hdd_image_cache_find(cache, tag);
+
+    if (idx >= 0) {
+        hdd_image_cache_touch(cache, idx);
+        return idx;
+    }
+
+    if (cache->used < cache->num_lines) {
+        idx  = (int32_t) cache->used++;
+        line = &cache->lines[idx];
+
+        line->lru_prev = -1;
+        line->lru_next = cache->lru_head;
+        if (cache->lru_head >= 0)
+            cache->lines[cache->lru_head].lru_prev = idx;
+        cache->lru_head = idx;
+        if (cache->lru_tail < 0)
+            cache->lru_tail = idx;
+    } else {
+        idx  = cache->lru_tail;
+        line = &cache->lines[idx];
+
+        if (line->dirty && (hdd_image_cache_write_back(id, idx) < 0))
+            *ret = -1;
+
+        link = &cache->hash[line->tag & cache->hash_mask];
+        while (*link != idx)
+            link = &cache->lines[*link].hash_next;
+        *link = line->hash_next;
+
+        hdd_image_cache_touch(cache, idx);
+    }
+
+    line->tag       = tag;
+    line->valid     = 0;
+    line->dirty     = 0;
+    line->hash_next = cache->hash[tag & cache->hash_mask];
+
+    cache->hash[tag & cache->hash_mask] = idx;
+
+    return idx;
+}
+
+/* Bits of the line a request covers. */
+static uint8_t
+hdd_image_cache_mask(uint32_t tag, uint32_t sector, uint32_t end)
+{
+    uint32_t first = tag << HDD_CACHE_LINE_SHIFT;
+    uint32_t from  = (sector > first) ? (sector - first) : 0;
+    uint32_t to    = ((end - first) < HDD_CACHE_LINE_SECTORS) ? (end - first) : HDD_CACHE_LINE_SECTORS;
+
+    return (uint8_t) (((1 << to) - 1) & ~((1 << from) - 1));
+}
+
+static hdd_image_cache_t *
+hdd_image_get_cache(uint8_t id)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    uint32_t           hash_size;
+
+    if ((cache != NULL) || (hdd_image_cache_size <= 0) || !hdd_images[id].loaded)
+        return cache;
+
+    /* A mapped image already sits in the host page cache. */
+    if (hdd_image_get_map(id) != NULL)
+        return NULL;
+
+    cache                = (hdd_image_cache_t *) calloc(1, sizeof(hdd_image_cache_t));
+    cache->num_lines     = ((uint32_t) hdd_image_cache_size << 20) / (HDD_CACHE_LINE_SECTORS << 9);
+    cache->write_through = !!hdd_image_cache_write_through;
+    cache->lru_head      = -1;
+    cache->lru_tail      = -1;
+
+    for (hash_size = 1; hash_size < cache->num_lines; hash_size <<= 1)
+        ;
+    cache->hash_mask = hash_size - 1;
+
+    cache->lines = (hdd_image_cache_line_t *) calloc(cache->num_lines, sizeof(hdd_image_cache_line_t));
+    cache->data  = (uint8_t *) malloc((size_t) cache->num_lines * (HDD_CACHE_LINE_SECTORS << 9));
+    cache->hash  = (int32_t *) malloc(hash_size * sizeof(int32_t));
+    memset(cache->hash, 0xff, hash_size * sizeof(int32_t));
+
+    hdd_image_log("Hard disk image %i: %i MB %s cache\n", id, hdd_image_cache_size,
+                  cache->write_through ? "write-through" : "write-back");
+
+    hdd_images[id].cache = cache;
+
+    return cache;
+}
+
+static int
+hdd_image_cache_flush(uint8_t id)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    int                ret   = 0;
+
+    if ((cache == NULL) || !cache->dirty_lines)
+        return 0;
+
+    for (uint32_t i = 0; (i < cache->used) && cache->dirty_lines; i++) {
+        if (cache->lines[i].dirty && (hdd_image_cache_write_back(id, (int32_t) i) < 0))
+            ret = -1;
+    }
+
+    return ret;
+}
+
+static void
+hdd_image_cache_close(uint8_t id)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+
+    if (cache == NULL)
+        return;
+
+    hdd_image_cache_flush(id);
+
+    free(cache->lines);
+    free(cache->data);
+    free(cache->hash);
+    free(cache);
+
+    hdd_images[id].cache = NULL;
+}
+
+/* Drop cached sectors that are about to be overwritten behind the cache. */
+static void
+hdd_image_cache_invalidate(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    uint32_t           end   = sector + count;
+    int32_t            idx;
+    uint8_t            mask;
+
+    for (uint32_t tag = sector >> HDD_CACHE_LINE_SHIFT; (tag << HDD_CACHE_LINE_SHIFT) < end; tag++) {
+        if ((idx = hdd_image_cache_find(cache, tag)) < 0)
+            continue;
+
+        mask = hdd_image_cache_mask(tag, sector, end);
+        cache->lines[idx].valid &= ~mask;
+        hdd_image_cache_set_dirty(cache, &cache->lines[idx], cache->lines[idx].dirty & ~mask);
+    }
+}
+
+static int
+hdd_image_cache_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    uint32_t           end   = sector + count;
+    uint32_t           fill  = end;
+    uint32_t           tag;
+    uint32_t           first;
+    int32_t            idx;
+    int                hit   = 1;
+    int                ret   = 0;
+    uint8_t            mask;
+    uint8_t            copy;
+
+    for (tag = sector >> HDD_CACHE_LINE_SHIFT; hit && ((tag << HDD_CACHE_LINE_SHIFT) < end); tag++) {
+        idx  = hdd_image_cache_find(cache, tag);
+        mask = hdd_image_cache_mask(tag, sector, end);
+        hit  = (idx >= 0) && ((cache->lines[idx].valid & mask) == mask);
+    }
+
+    /* On a miss, the whole request comes from the image, and the sectors the
+       cache has newer copies of replace what was read. */
+    if (!hit) {
+        if (hdd_image_read_image(id, sector, count, buffer) < 0)
+            return -1;
+
+        if (end > (hdd_images[id].last_sector + 1))
+            fill = hdd_images[id].last_sector + 1;
+    }
+
+    for (tag = sector >> HDD_CACHE_LINE_SHIFT; (tag << HDD_CACHE_LINE_SHIFT) < end; tag++) {
+        if ((idx = hdd_image_cache_find(cache, tag)) < 0)
+            continue;
+
+        first = tag << HDD_CACHE_LINE_SHIFT;
+        mask  = hdd_image_cache_mask(tag, sector, end);
+        copy  = hit ? mask : (mask & cache->lines[idx].dirty);
+
+        hdd_image_cache_touch(cache, idx);
+
+        for (int i = 0; i < HDD_CACHE_LINE_SECTORS; i++) {
+            if (copy & (1 << i))
+                memcpy(&buffer[(first + i - sector) << 9],
+                       &cache->data[((size_t) idx * HDD_CACHE_LINE_SECTORS + i) << 9], 512);
+        }
+    }
+
+    if (hit) {
+        hdd_images[id].pos = end;
+        return 0;
+    }
+
+    /* Only fill once the buffer is complete, a line taken for the fill may be
+       one of the request's own dirty lines. */
+    for (tag = sector >> HDD_CACHE_LINE_SHIFT; (tag << HDD_CACHE_LINE_SHIFT) < fill; tag++) {
+        first = tag << HDD_CACHE_LINE_SHIFT;
+        mask  = hdd_image_cache_mask(tag, sector, fill);
+        idx   = hdd_image_cache_get(id, tag, &ret);
+
+        for (int i = 0; i < HDD_CACHE_LINE_SECTORS; i++) {
+            if ((mask & (1 << i)) && !(cache->lines[idx].valid & (1 << i))) {
+                memcpy(&cache->data[((size_t) idx * HDD_CACHE_LINE_SECTORS + i) << 9],
+                       &buffer[(first + i - sector) << 9], 512);
+                cache->lines[idx].valid |= (1 << i);
+            }
+        }
+    }
+
+    hdd_images[id].pos = end;
+
+    return ret;
+}
+
+static int
+hdd_image_cache_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    uint32_t           end   = sector + count;
+    uint32_t           first;
+    int32_t            idx;
+    int                ret   = 0;
+    uint8_t            mask;
+
+    if (cache->write_through && (hdd_image_write_image(id, sector, count, buffer) < 0))
+        ret = -1;
+
+    for (uint32_t tag = sector >> HDD_CACHE_LINE_SHIFT; (tag << HDD_CACHE_LINE_SHIFT) < end; tag++) {
+        first = tag << HDD_CACHE_LINE_SHIFT;
+        mask  = hdd_image_cache_mask(tag, sector, end);
+        idx   = hdd_image_cache_get(id, tag, &ret);
+
+        for (int i = 0; i < HDD_CACHE_LINE_SECTORS; i++) {
+            if (mask & (1 << i))
+                memcpy(&cache->data[((size_t) idx * HDD_CACHE_LINE_SECTORS + i) << 9],
+                       &buffer[(first + i - sector) << 9], 512);
+        }
+
+        cache->lines[idx].valid |= mask;
+        if (!cache->write_through)
+            hdd_image_cache_set_dirty(cache, &cache->lines[idx], cache->lines[idx].dirty | mask);
+    }
+
+    cache->idle_secs   = 0;
+    hdd_images[id].pos = end;
+
+    return ret;
+}
+
+int
+hdd_image_flush(uint8_t id)
+{
+    int ret;
+
+    if (!hdd_images[id].loaded)
+        return 0;
+
+    ret = hdd_image_cache_flush(id);
+    if (hdd_image_sync(id) < 0)
+        ret = -1;
+
+    return ret;
+}
+
+/* Called once a second, writes back caches that have seen no writes for a while. */
+void
+hdd_image_idle(void)
+{
+    for (uint8_t id = 0; id < HDD_NUM; id++) {
+        hdd_image_cache_t *cache = hdd_images[id].cache;
+
+        if ((cache != NULL) && cache->dirty_lines && (++cache->idle_secs >= HDD_CACHE_IDLE_SECS)) {
+            hdd_image_log("Hard disk image %i: Writing back %i idle lines\n", id, cache->dirty_lines);
+            hdd_image_cache_flush(id);
+        }
+    }
+}
+
+int
+hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    int ret;
+
+    hdd_image_ops++;
+
+    MTR_BEGIN_I("disk", "hdd_image_read", "sectors", count);
+    if (hdd_image_get_cache(id) != NULL)
+        ret = hdd_image_cache_read(id, sector, count, buffer);
+    else
+        ret = hdd_image_read_image(id, sector, count, buffer);
+    MTR_END("disk", "hdd_image_read");
+
+    return ret;
+}
+
+int
+hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    int ret;
+
+    hdd_image_ops++;
+
+    MTR_BEGIN_I("disk", "hdd_image_write", "sectors", count);
+    if (hdd_image_get_cache(id) != NULL)
+        ret = hdd_image_cache_write(id, sector, count, buffer);
+    else
+        ret = hdd_image_write_image(id, sector, count, buffer);
+    MTR_END("disk", "hdd_image_write");
+
+    return ret;
+}
+
+int
+hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    uint32_t transfer_sectors = count;
+    uint32_t sectors          = hdd_sectors(id);
+
+    if ((sectors - sector) < transfer_sectors)
         transfer_sectors = sectors - sector;
 
     if (hdd_image_write(id, sector, transfer_sectors, buffer) < 0)
@@ -629,15 +1891,45 @@ hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 int
 hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
 {
-    if (hdd_images[id].type == HDD_IMAGE_VHD) {
+    uint8_t *map;
+
+    hdd_image_ops++;
+
+    if (hdd_images[id].cache != NULL)
+        hdd_image_cache_invalidate(id, sector, count);
+
+    if (hdd_images[id].overlay != NULL) {
+        uint8_t *zero = (uint8_t *) calloc(HDD_OVERLAY_BLOCK_SECTORS, 512);
+        uint32_t run;
+        int      ret  = 0;
+
+        for (uint32_t i = 0; (i < count) && (ret == 0); i += run) {
+            run = MIN(count - i, HDD_OVERLAY_BLOCK_SECTORS);
+            ret = hdd_image_overlay_write(id, sector + i, run, zero);
+        }
+
+        free(zero);
+        return ret;
+    } else if (hdd_images[id].type == HDD_IMAGE_VHD) {
         hdd_images[id].vhd->error   = 0;
         int non_transferred_sectors = mvhd_format_sectors(hdd_images[id].vhd, sector, count);
         hdd_images[id].pos          = sector + count - non_transferred_sectors - 1;
         if (hdd_images[id].vhd->error)
             return -1;
+    } else if ((map = hdd_image_get_map(id)) != NULL) {
+        uint32_t num_zero = hdd_image_map_count(id, sector, count);
+
+        memset(&map[hdd_images[id].base + ((uint64_t) sector << 9)], 0, (size_t) num_zero << 9);
+        hdd_images[id].pos = sector + num_zero;
+
+        hdd_images[id].map_dirty += num_zero;
+        hdd_image_map_sync(id, 0);
     } else {
         memset(empty_sector, 0, 512);
 
+        hdd_image_io_flush(id);
+        hdd_image_io_invalidate(hdd_images[id].io, sector, count);
+
         if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
             hdd_image_log("Hard disk image %i: Zero error during seek\n", id);
             return -1;
@@ -693,6 +1985,10 @@ hdd_image_unload(uint8_t id, UNUSED(int fn_preserve))
         return;
 
     if (hdd_images[id].loaded) {
+        hdd_image_cache_close(id);
+        hdd_image_io_stop(id);
+        hdd_image_unmap(id);
+        hdd_image_overlay_close(id);
         if (hdd_images[id].file != NULL) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
@@ -716,6 +2012,11 @@ hdd_image_close(uint8_t id)
     if (!hdd_images[id].loaded)
         return;
 
+    hdd_image_cache_close(id);
+    hdd_image_io_stop(id);
+    hdd_image_unmap(id);
+    hdd_image_overlay_close(id);
+
     if (hdd_images[id].file != NULL) {
         fclose(hdd_images[id].file);
         hdd_images[id].file = NULL;
@@ -727,3 +2028,97 @@ hdd_image_close(uint8_t id)
     memset(&hdd_images[id], 0, sizeof(hdd_image_t));
     hdd_images[id].loaded = 0;
 }
+
+/* The image itself is only referenced by a snapshot - for images opened with
+   an overlay, the blocks written since the machine was started go with it. */
+int
+hdd_image_save_state(uint8_t id, snapshot_t *snap)
+{
+    hdd_image_t *img = &hdd_images[id];
+    uint8_t     *buf;
+    uint32_t     block_size = HDD_OVERLAY_BLOCK_SECTORS << 9;
+    int          ret        = 1;
+
+    if (img->loaded && (hdd_image_flush(id) < 0))
+        return 0;
+
+    snapshot_write_var(snap, img->last_sector);
+    snapshot_write_var(snap, img->overlay_used);
+
+    if (!img->loaded || (img->overlay == NULL) || (img->overlay_used == 0))
+        return 1;
+
+    buf = (uint8_t *) malloc(block_size);
+    for (uint32_t block = 0; ret && (block < img->overlay_num_blocks); block++) {
+        if (img->overlay_map[block] == 0)
+            continue;
+
+        if ((fseeko64(img->overlay, hdd_image_overlay_offset(img, block, 0), SEEK_SET) == -1) ||
+            (fread(buf, 512, HDD_OVERLAY_BLOCK_SECTORS, img->overlay) != HDD_OVERLAY_BLOCK_SECTORS)) {
+            hdd_image_log("Hard disk image %i: Overlay read error\n", id);
+            ret = 0;
+        } else {
+            snapshot_write_var(snap, block);
+            snapshot_write(snap, buf, block_size);
+        }
+    }
+    free(buf);
+
+    return ret;
+}
+
+int
+hdd_image_load_state(uint8_t id, snapshot_t *snap)
+{
+    hdd_image_t *img = &hdd_images[id];
+    uint8_t     *buf;
+    uint32_t     block_size = HDD_OVERLAY_BLOCK_SECTORS << 9;
+    uint32_t     last_sector;
+    uint32_t     used;
+    uint32_t     block;
+    int          ret = 1;
+
+    if (!snapshot_read_var(snap, last_sector) || !snapshot_read_var(snap, used))
+        return 0;
+
+    if (!img->loaded || (last_sector != img->last_sector)) {
+        pclog("Snapshot: hard disk %i does not match the saved image\n", id);
+        return 0;
+    }
+
+    if (img->overlay == NULL) {
+        if (used != 0) {
+            pclog("Snapshot: hard disk %i was saved with an overlay\n", id);
+            return 0;
+        }
+        /* Nothing to restore, the image has to be as it was when the
+           snapshot was made. */
+        return 1;
+    }
+
+    /* Whatever was written since goes away, along with the cached sectors. */
+    hdd_image_flush(id);
+    if (img->cache != NULL)
+        hdd_image_cache_invalidate(id, 0, img->last_sector + 1);
+    memset(img->overlay_map, 0x00, img->overlay_num_blocks * sizeof(uint32_t));
+    img->overlay_used = 0;
+
+    buf = (uint8_t *) malloc(block_size);
+    for (uint32_t i = 0; ret && (i < used); i++) {
+        if (!snapshot_read_var(snap, block) || (block >= img->overlay_num_blocks) ||
+            (img->overlay_map[block] != 0) || !snapshot_read(snap, buf, block_size)) {
+            ret = 0;
+            break;
+        }
+
+        img->overlay_map[block] = ++img->overlay_used;
+        if ((fseeko64(img->overlay, hdd_image_overlay_offset(img, block, 0), SEEK_SET) == -1) ||
+            (fwrite(buf, 512, HDD_OVERLAY_BLOCK_SECTORS, img->overlay) != HDD_OVERLAY_BLOCK_SECTORS)) {
+            hdd_image_log("Hard disk image %i: Overlay write error\n", id);
+            ret = 0;
+        }
+    }
+    free(buf);
+
+    return ret;
+}
@@ -113,24 +113,43 @@ mvhd_convert_to_vhd_sparse(const char* utf8_raw_path, const char* utf8_vhd_path,
         goto end;
     }
 
-    uint8_t buff[4096] = {0}; // 8 sectors
-    uint8_t empty_buff[4096] = {0};
+    uint8_t *buff = calloc(MVHD_COPY_SECTORS, MVHD_SECTOR_SIZE);
+    if (buff == NULL) {
+        *err = MVHD_ERR_MEM;
+        mvhd_close(vhdm);
+        vhdm = NULL;
+        goto end;
+    }
     int total_sectors = mvhd_calc_size_sectors(&geom);
     int copy_sect = 0;
 
-    for (int i = 0; i < total_sectors; i += 8) {
-        copy_sect = 8;
-        if ((i + 8) >= total_sectors) {
+    for (int i = 0; i < total_sectors; i += copy_sect) {
+        copy_sect = MVHD_COPY_SECTORS;
+        if ((i + copy_sect) >= total_sectors) {
             copy_sect = total_sectors - i;
-            memset(buff, 0, sizeof buff);
+            memset(buff, 0, (size_t)MVHD_COPY_SECTORS * MVHD_SECTOR_SIZE);
         }
         (void) !fread(buff, MVHD_SECTOR_SIZE, copy_sect, raw_img);
 
-        /* Only write data if there's data to write, to take advantage of the sparse VHD format */
-        if (memcmp(buff, empty_buff, sizeof buff) != 0) {
-            mvhd_write_sectors(vhdm, i, copy_sect, buff);
+        /**
+         * Only write data if there's data to write, to take advantage of the sparse VHD format.
+         * Zero detection is done in 4 KB (8 sector) units, and consecutive units holding data
+         * are written with a single call.
+         */
+        int run_start = -1;
+        for (int j = 0; j < (copy_sect + 8); j += 8) {
+            int has_data = (j < copy_sect) && !mvhd_is_zero(&buff[j * MVHD_SECTOR_SIZE], 8 * MVHD_SECTOR_SIZE);
+
+            if (has_data && (run_start < 0)) {
+                run_start = j;
+            } else if (!has_data && (run_start >= 0)) {
+                int run_end = (j < copy_sect) ? j : copy_sect;
+                mvhd_write_sectors(vhdm, i + run_start, run_end - run_start, &buff[run_start * MVHD_SECTOR_SIZE]);
+                run_start = -1;
+            }
         }
     }
+    free(buff);
 end:
     fclose(raw_img);
 
@@ -152,17 +171,24 @@ mvhd_convert_to_raw(const char* utf8_vhd_path, const char* utf8_raw_path, int *e
         return NULL;
     }
 
-    uint8_t buff[4096] = {0}; // 8 sectors
+    uint8_t *buff = calloc(MVHD_COPY_SECTORS, MVHD_SECTOR_SIZE);
+    if (buff == NULL) {
+        *err = MVHD_ERR_MEM;
+        mvhd_close(vhdm);
+        fclose(raw_img);
+        return NULL;
+    }
     int total_sectors = mvhd_calc_size_sectors((MVHDGeom*)&vhdm->footer.geom);
     int copy_sect = 0;
-    for (int i = 0; i < total_sectors; i += 8) {
-        copy_sect = 8;
-        if ((i + 8) >= total_sectors) {
+    for (int i = 0; i < total_sectors; i += copy_sect) {
+        copy_sect = MVHD_COPY_SECTORS;
+        if ((i + copy_sect) >= total_sectors) {
             copy_sect = total_sectors - i;
         }
         mvhd_read_sectors(vhdm, i, copy_sect, buff);
         fwrite(buff, MVHD_SECTOR_SIZE, copy_sect, raw_img);
     }
+    free(buff);
     mvhd_close(vhdm);
     mvhd_fseeko64(raw_img, 0, SEEK_SET);
 
@@ -231,7 +231,7 @@ mvhd_create_fixed(const char* path, MVHDGeom geom, int* err, mvhd_progress_callb
 MVHDMeta*
 mvhd_create_fixed_raw(const char* path, FILE* raw_img, uint64_t size_in_bytes, MVHDGeom* geom, int* err, mvhd_progress_callback progress_callback)
 {
-    uint8_t img_data[MVHD_SECTOR_SIZE] = {0};
+    uint8_t* img_data = NULL;
     uint8_t footer_buff[MVHD_FOOTER_SIZE] = {0};
 
     if (geom == NULL || (geom->cyl == 0 || geom->heads == 0 || geom->spt == 0)) {
@@ -245,6 +245,13 @@ mvhd_create_fixed_raw(const char* path, FILE* raw_img, uint64_t size_in_bytes, M
         goto end;
     }
 
+    /* Copy in large chunks, one progress update per chunk */
+    img_data = calloc(MVHD_COPY_SECTORS, MVHD_SECTOR_SIZE);
+    if (img_data == NULL) {
+        *err = MVHD_ERR_MEM;
+        goto cleanup_vhdm;
+    }
+
     FILE* fp = mvhd_fopen(path, "wb+", err);
     if (fp == NULL) {
         goto cleanup_vhdm;
@@ -253,6 +260,7 @@ mvhd_create_fixed_raw(const char* path, FILE* raw_img, uint64_t size_in_bytes, M
 
     uint32_t size_sectors = (uint32_t)(size_in_bytes / MVHD_SECTOR_SIZE);
     uint32_t s;
+    uint32_t n;
 
     if (progress_callback)
         progress_callback(0, size_sectors);
@@ -267,29 +275,39 @@ mvhd_create_fixed_raw(const char* path, FILE* raw_img, uint64_t size_in_bytes, M
         }
         gen_footer(&vhdm->footer, raw_size, geom, MVHD_TYPE_FIXED, 0);
         mvhd_fseeko64(raw_img, 0, SEEK_SET);
-        for (s = 0; s < size_sectors; s++) {
-            (void) !fread(img_data, sizeof img_data, 1, raw_img);
-            fwrite(img_data, sizeof img_data, 1, fp);
+        for (s = 0; s < size_sectors; s += n) {
+            n = size_sectors - s;
+            if (n > MVHD_COPY_SECTORS) {
+                n = MVHD_COPY_SECTORS;
+            }
+            (void) !fread(img_data, MVHD_SECTOR_SIZE, n, raw_img);
+            fwrite(img_data, MVHD_SECTOR_SIZE, n, fp);
             if (progress_callback)
-                progress_callback(s + 1, size_sectors);
+                progress_callback(s + n, size_sectors);
         }
     } else {
         gen_footer(&vhdm->footer, size_in_bytes, geom, MVHD_TYPE_FIXED, 0);
-        for (s = 0; s < size_sectors; s++) {
-            fwrite(img_data, sizeof img_data, 1, fp);
+        for (s = 0; s < size_sectors; s += n) {
+            n = size_sectors - s;
+            if (n > MVHD_COPY_SECTORS) {
+                n = MVHD_COPY_SECTORS;
+            }
+            fwrite(img_data, MVHD_SECTOR_SIZE, n, fp);
             if (progress_callback)
-                progress_callback(s + 1, size_sectors);
+                progress_callback(s + n, size_sectors);
         }
     }
     mvhd_footer_to_buffer(&vhdm->footer, footer_buff);
     fwrite(footer_buff, sizeof footer_buff, 1, fp);
     fclose(fp);
     fp = NULL;
+    free(img_data);
     free(vhdm);
     vhdm = mvhd_open(path, false, err);
     goto end;
 
 cleanup_vhdm:
+    free(img_data);
     free(vhdm);
     vhdm = NULL;
 
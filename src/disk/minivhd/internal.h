@@ -44,6 +44,9 @@
 #define MVHD_SECTOR_SIZE       512
 #define MVHD_BAT_ENT_PER_SECT  128
 
+/* Sectors copied per read/write when creating or converting images (1 MB). */
+#define MVHD_COPY_SECTORS      2048
+
 #define MVHD_MAX_SIZE_IN_BYTES 0x1fe00000000
 
 #define MVHD_SPARSE_BLK        0xffffffff
@@ -61,10 +64,23 @@
 #define MVHD_START_TS          946684800
 
 
+/* Number of sector bitmaps kept in memory per image. */
+#define MVHD_BITMAP_CACHE_SIZE 64
+
+typedef struct MVHDBitmapCacheEntry {
+    int      block;
+    uint32_t last_use;
+    bool     dirty;
+} MVHDBitmapCacheEntry;
+
 typedef struct MVHDSectorBitmap {
-    uint8_t* curr_bitmap;
+    uint8_t* curr_bitmap; /* Bitmap of curr_block, points into cache_data */
     int      sector_count;
     int      curr_block;
+    int      curr_entry;
+    uint32_t use_count;
+    uint8_t* cache_data;
+    MVHDBitmapCacheEntry cache[MVHD_BITMAP_CACHE_SIZE];
 } MVHDSectorBitmap;
 
 typedef struct MVHDFooter {
@@ -163,6 +179,16 @@ bool mvhd_is_conectix_str(const void* buffer);
  */
 void mvhd_generate_uuid(uint8_t *uuid);
 
+/**
+ * \brief Check whether a buffer only contains zero bytes
+ * 
+ * \param [in] buffer The buffer to check
+ * \param [in] len The length of the buffer, must be a multiple of 8
+ * 
+ * \return true if every byte of the buffer is zero
+ */
+bool mvhd_is_zero(const void* buffer, size_t len);
+
 /**
  * \brief Calculate a VHD formatted timestamp from the current time
  */
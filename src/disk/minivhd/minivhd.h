@@ -259,6 +259,15 @@ MVHDAPI MVHDMeta* mvhd_create_ex(MVHDCreationOptions options, int* err);
  */
 MVHDAPI void mvhd_close(MVHDMeta* vhdm);
 
+/**
+ * \brief Write the sector bitmaps held in memory back to the image
+ *
+ * Bitmap updates are batched in memory, this is done by mvhd_close() too.
+ *
+ * \param [in] vhdm MiniVHD data structure
+ */
+MVHDAPI void mvhd_flush(MVHDMeta* vhdm);
+
 /**
  * \brief Calculate hard disk geometry from a provided size
  *
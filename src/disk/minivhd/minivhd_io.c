@@ -85,10 +85,14 @@ check_sectors(uint32_t offset, int num_sectors, uint32_t total_sectors, int *tra
 bool
 mvhd_write_empty_sectors(FILE *f, int sector_count)
 {
-    uint8_t zero_bytes[MVHD_SECTOR_SIZE] = {0};
-
-    for (int i = 0; i < sector_count; i++) {
-        if (!fwrite(zero_bytes, sizeof zero_bytes, 1, f))
+    static const uint8_t zero_bytes[64 * MVHD_SECTOR_SIZE] = {0};
+    int                  count;
+
+    for (int i = 0; i < sector_count; i += count) {
+        count = sector_count - i;
+        if (count > 64)
+            count = 64;
+        if (fwrite(zero_bytes, MVHD_SECTOR_SIZE, count, f) != (size_t) count)
             return 0;
     }
 
@@ -97,10 +101,32 @@ mvhd_write_empty_sectors(FILE *f, int sector_count)
 }
 
 /**
- * \brief Read the sector bitmap for a block.
+ * \brief Write a cached sector bitmap to file
+ *
+ * \param [in] vhdm MiniVHD data structure
+ * \param [in] entry The bitmap cache entry to write
+ */
+static void
+write_sect_bitmap(MVHDMeta *vhdm, int entry)
+{
+    MVHDBitmapCacheEntry *e = &vhdm->bitmap.cache[entry];
+    int64_t abs_offset = (int64_t)vhdm->block_offset[e->block] * MVHD_SECTOR_SIZE;
+
+    if (mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET) == -1)
+        vhdm->error = 1;
+    if (!fwrite(vhdm->bitmap.cache_data + ((size_t)entry * vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE),
+                MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f))
+        vhdm->error = 1;
+
+    e->dirty = false;
+}
+
+/**
+ * \brief Make the sector bitmap for a block the current one.
  *
- * If the block is sparse, the sector bitmap in memory will be
- * zeroed. Otherwise, the sector bitmap is read from the VHD file.
+ * Recently used bitmaps are kept in memory, and only read from the VHD file
+ * on a miss. If the block is sparse, the sector bitmap in memory will be
+ * zeroed. A modified bitmap that has to make room is written back first.
  *
  * \param [in] vhdm MiniVHD data structure
  * \param [in] blk The block for which to read the sector bitmap from
@@ -108,31 +134,66 @@ mvhd_write_empty_sectors(FILE *f, int sector_count)
 static void
 read_sect_bitmap(MVHDMeta *vhdm, int blk)
 {
-    if (vhdm->block_offset[blk] != MVHD_SPARSE_BLK) {
-        mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET);
-        if (!fread(vhdm->bitmap.curr_bitmap, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE, 1, vhdm->f))
-            vhdm->error = 1;
-    } else
-        memset(vhdm->bitmap.curr_bitmap, 0, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE);
+    MVHDSectorBitmap *bm = &vhdm->bitmap;
+    int entry = 0;
+    int i;
+
+    for (i = 0; i < MVHD_BITMAP_CACHE_SIZE; i++) {
+        if (bm->cache[i].block == blk)
+            break;
+        if (bm->cache[i].last_use < bm->cache[entry].last_use)
+            entry = i;
+    }
+
+    if (i < MVHD_BITMAP_CACHE_SIZE)
+        entry = i;
+    else {
+        if (bm->cache[entry].dirty)
+            write_sect_bitmap(vhdm, entry);
+
+        uint8_t *data = bm->cache_data + ((size_t)entry * bm->sector_count * MVHD_SECTOR_SIZE);
+        if (vhdm->block_offset[blk] != MVHD_SPARSE_BLK) {
+            mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET);
+            if (!fread(data, bm->sector_count * MVHD_SECTOR_SIZE, 1, vhdm->f))
+                vhdm->error = 1;
+        } else
+            memset(data, 0, bm->sector_count * MVHD_SECTOR_SIZE);
 
-    vhdm->bitmap.curr_block = blk;
+        bm->cache[entry].block = blk;
+    }
+
+    bm->cache[entry].last_use = ++bm->use_count;
+    bm->curr_entry  = entry;
+    bm->curr_bitmap = bm->cache_data + ((size_t)entry * bm->sector_count * MVHD_SECTOR_SIZE);
+    bm->curr_block  = blk;
 }
 
 /**
- * \brief Write the current sector bitmap in memory to file
+ * \brief Mark the current sector bitmap in memory as modified
+ *
+ * The bitmap is written to file when it leaves the cache, or on mvhd_flush().
  *
  * \param [in] vhdm MiniVHD data structure
  */
 static void
 write_curr_sect_bitmap(MVHDMeta* vhdm)
 {
-    if (vhdm->bitmap.curr_block >= 0) {
-        int64_t abs_offset = (int64_t)vhdm->block_offset[vhdm->bitmap.curr_block] * MVHD_SECTOR_SIZE;
-        if (mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET) == -1)
-            vhdm->error = 1;
-        if (!fwrite(vhdm->bitmap.curr_bitmap, MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f))
-            vhdm->error = 1;
+    if (vhdm->bitmap.curr_block >= 0)
+        vhdm->bitmap.cache[vhdm->bitmap.curr_entry].dirty = true;
+}
+
+MVHDAPI void
+mvhd_flush(MVHDMeta* vhdm)
+{
+    if ((vhdm == NULL) || (vhdm->bitmap.cache_data == NULL))
+        return;
+
+    for (int i = 0; i < MVHD_BITMAP_CACHE_SIZE; i++) {
+        if (vhdm->bitmap.cache[i].dirty)
+            write_sect_bitmap(vhdm, i);
     }
+
+    fflush(vhdm->f);
 }
 
 /**
@@ -151,7 +212,6 @@ write_bat_entry(MVHDMeta *vhdm, int blk)
         vhdm->error = 1;
     if (!fwrite(&offset, sizeof offset, 1, vhdm->f))
         vhdm->error = 1;
-    fflush(vhdm->f);
 }
 
 /**
@@ -250,40 +310,62 @@ mvhd_sparse_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buf
     uint32_t s = 0;
     uint32_t ls = 0;
     int blk = 0;
-    int prev_blk = -1;
     int sib = 0;
+    int run = 0;
+    int present = 0;
     ls = offset + transfer_sectors;
 
-    for (s = offset; s < ls; s++) {
+    /* Sectors are handled in runs that are all present or all absent. */
+    for (s = offset; s < ls; s += run) {
         blk = s / vhdm->sect_per_block;
         sib = s % vhdm->sect_per_block;
-        if (blk != prev_blk) {
-            prev_blk = blk;
-            if (vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(vhdm, blk);
-                if (mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR) == -1)
-                    vhdm->error = 1;
-            } else {
-                addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                       MVHD_SECTOR_SIZE;
-                if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
-                    vhdm->error = 1;
-            }
+        if (vhdm->bitmap.curr_block != blk)
+            read_sect_bitmap(vhdm, blk);
+
+        present = !!VHD_TESTBIT(vhdm->bitmap.curr_bitmap, sib);
+        for (run = 1; ((s + run) < ls) && ((sib + run) < vhdm->sect_per_block); run++) {
+            int next = sib + run;
+            if (!!VHD_TESTBIT(vhdm->bitmap.curr_bitmap, next) != present)
+                break;
         }
 
-        if (VHD_TESTBIT(vhdm->bitmap.curr_bitmap, sib)) {
-            if (!fread(buff, MVHD_SECTOR_SIZE, 1, vhdm->f) && !feof(vhdm->f))
+        if (present) {
+            addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
+                   MVHD_SECTOR_SIZE;
+            if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
                 vhdm->error = 1;
-        } else {
-            memset(buff, 0, MVHD_SECTOR_SIZE);
-            mvhd_fseeko64(vhdm->f, MVHD_SECTOR_SIZE, SEEK_CUR);
-        }
-        buff += MVHD_SECTOR_SIZE;
+            if (!fread(buff, (size_t) run * MVHD_SECTOR_SIZE, 1, vhdm->f) && !feof(vhdm->f))
+                vhdm->error = 1;
+        } else
+            memset(buff, 0, (size_t) run * MVHD_SECTOR_SIZE);
+        buff += (size_t) run * MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
 }
 
+/**
+ * \brief Find the image in a differencing chain that holds a sector
+ *
+ * \param [in] vhdm MiniVHD data structure of the child image
+ * \param [in] s The sector to look up
+ */
+static MVHDMeta *
+diff_sector_owner(MVHDMeta *vhdm, uint32_t s)
+{
+    while (vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
+        int blk = s / vhdm->sect_per_block;
+        int sib = s % vhdm->sect_per_block;
+        if (vhdm->bitmap.curr_block != blk)
+            read_sect_bitmap(vhdm, blk);
+        if (VHD_TESTBIT(vhdm->bitmap.curr_bitmap, sib))
+            break;
+        vhdm = vhdm->parent;
+    }
+
+    return vhdm;
+}
+
 int
 mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
 {
@@ -297,36 +379,29 @@ mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
     MVHDMeta *curr_vhdm = vhdm;
     uint32_t s = 0;
     uint32_t ls = 0;
-    int blk = 0;
-    int sib = 0;
+    int run = 0;
     ls = offset + transfer_sectors;
 
-    for (s = offset; s < ls; s++) {
-        while (curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
-            blk = s / curr_vhdm->sect_per_block;
-            sib = s % curr_vhdm->sect_per_block;
-            if (curr_vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(curr_vhdm, blk);
-            }
-            if (!VHD_TESTBIT(curr_vhdm->bitmap.curr_bitmap, sib)) {
-                curr_vhdm = curr_vhdm->parent;
-            } else { break; }
-        }
+    /* Resolve the chain once per sector from the cached bitmaps, and read
+       each run of sectors that come from the same image in one go. */
+    for (s = offset; s < ls; s += run) {
+        curr_vhdm = diff_sector_owner(vhdm, s);
+        for (run = 1; ((s + run) < ls) && (diff_sector_owner(vhdm, s + run) == curr_vhdm); run++)
+            ;
 
         /* We handle actual sector reading using the fixed or sparse functions,
            as a differencing VHD is also a sparse VHD */
         if ((curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) ||
             (curr_vhdm->footer.disk_type == MVHD_TYPE_DYNAMIC))
-            mvhd_sparse_read(curr_vhdm, s, 1, buff);
+            mvhd_sparse_read(curr_vhdm, s, run, buff);
         else
-            mvhd_fixed_read(curr_vhdm, s, 1, buff);
+            mvhd_fixed_read(curr_vhdm, s, run, buff);
         if (curr_vhdm->error) {
             curr_vhdm->error = 0;
             vhdm->error = 1;
         }
 
-        curr_vhdm = vhdm;
-        buff += MVHD_SECTOR_SIZE;
+        buff += (size_t) run * MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
@@ -366,50 +441,49 @@ mvhd_sparse_diff_write(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *i
     uint32_t s = 0;
     uint32_t ls = 0;
     int blk = 0;
-    int prev_blk = -1;
     int sib = 0;
+    int run = 0;
+    bool changed;
     ls = offset + transfer_sectors;
 
     if (offset < total_sectors) {
-        for (s = offset; s < ls; s++) {
+        /* One write per block touched. */
+        for (s = offset; s < ls; s += run) {
             blk = s / vhdm->sect_per_block;
             sib = s % vhdm->sect_per_block;
-            if (vhdm->bitmap.curr_block != blk && prev_blk >= 0) {
-                /* Write the sector bitmap for the previous block, before we replace it. */
-                write_curr_sect_bitmap(vhdm);
-            }
+            run = vhdm->sect_per_block - sib;
+            if ((uint32_t) run > (ls - s))
+                run = ls - s;
 
-            if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK) {
-                /* "read" the sector bitmap first, before creating a new block, as the bitmap will be
-                   zero either way */
+            /* The bitmap of a sparse block is zero either way, make it the
+               current one before creating the block. */
+            if (vhdm->bitmap.curr_block != blk)
                 read_sect_bitmap(vhdm, blk);
+            if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK)
                 create_block(vhdm, blk);
-            }
 
-            if (blk != prev_blk) {
-                if (vhdm->bitmap.curr_block != blk) {
-                    read_sect_bitmap(vhdm, blk);
-                    if (mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR) == -1)
-                        vhdm->error = 1;
-                } else {
-                    addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                           MVHD_SECTOR_SIZE;
-                    if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
-                        vhdm->error = 1;
+            addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
+                   MVHD_SECTOR_SIZE;
+            if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
+                vhdm->error = 1;
+            if (!fwrite(buff, (size_t) run * MVHD_SECTOR_SIZE, 1, vhdm->f))
+                vhdm->error = 1;
+
+            /* Rewriting sectors that are already present leaves the bitmap alone. */
+            changed = false;
+            for (int i = sib; i < (sib + run); i++) {
+                if (!VHD_TESTBIT(vhdm->bitmap.curr_bitmap, i)) {
+                    VHD_SETBIT(vhdm->bitmap.curr_bitmap, i);
+                    changed = true;
                 }
-                prev_blk = blk;
             }
+            if (changed)
+                write_curr_sect_bitmap(vhdm);
 
-            if (!fwrite(buff, MVHD_SECTOR_SIZE, 1, vhdm->f))
-                vhdm->error = 1;
-            VHD_SETBIT(vhdm->bitmap.curr_bitmap, sib);
-            buff += MVHD_SECTOR_SIZE;
+            buff += (size_t) run * MVHD_SECTOR_SIZE;
         }
     }
 
-    /* And write the sector bitmap for the last block we visited to disk */
-    write_curr_sect_bitmap(vhdm);
-
     fflush(vhdm->f);
 
     return truncated_sectors;
@@ -145,6 +145,22 @@ mvhd_to_be64(uint64_t val)
 }
 
 
+bool
+mvhd_is_zero(const void* buffer, size_t len)
+{
+    const uint64_t* words = (const uint64_t*)buffer;
+    uint64_t acc = 0;
+
+    /* OR everything together rather than stopping at the first non-zero
+     * word, so the compiler can vectorize the loop. */
+    for (size_t i = 0; i < (len / sizeof *words); i++) {
+        acc |= words[i];
+    }
+
+    return acc == 0;
+}
+
+
 void
 mvhd_generate_uuid(uint8_t* uuid)
 {
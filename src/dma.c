@@ -31,6 +31,7 @@
 #include <86box/io.h>
 #include <86box/pic.h>
 #include <86box/dma.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 dma_t   dma[8];
@@ -1114,6 +1115,49 @@ dma_set_at(uint8_t at)
     dma_at = at;
 }
 
+/* Only the controller registers are saved, the transfer buffers are scratch
+   space and the scatter/gather I/O mapping belongs to the chipset. */
+void
+dma_save_state(snapshot_t *snap)
+{
+    snapshot_write_var(snap, dma);
+    snapshot_write_var(snap, dma_e);
+    snapshot_write_var(snap, dma_m);
+    snapshot_write_var(snap, dmaregs);
+    snapshot_write_var(snap, dma_wp);
+    snapshot_write_var(snap, dma_stat);
+    snapshot_write_var(snap, dma_stat_rq);
+    snapshot_write_var(snap, dma_stat_rq_pc);
+    snapshot_write_var(snap, dma_stat_adv_pend);
+    snapshot_write_var(snap, dma_command);
+    snapshot_write_var(snap, dma_req_is_soft);
+    snapshot_write_var(snap, dma_advanced);
+    snapshot_write_var(snap, dma_at);
+    snapshot_write_var(snap, dma_mask);
+    snapshot_write_var(snap, dma_ps2);
+}
+
+int
+dma_load_state(snapshot_t *snap)
+{
+    snapshot_read_var(snap, dma);
+    snapshot_read_var(snap, dma_e);
+    snapshot_read_var(snap, dma_m);
+    snapshot_read_var(snap, dmaregs);
+    snapshot_read_var(snap, dma_wp);
+    snapshot_read_var(snap, dma_stat);
+    snapshot_read_var(snap, dma_stat_rq);
+    snapshot_read_var(snap, dma_stat_rq_pc);
+    snapshot_read_var(snap, dma_stat_adv_pend);
+    snapshot_read_var(snap, dma_command);
+    snapshot_read_var(snap, dma_req_is_soft);
+    snapshot_read_var(snap, dma_advanced);
+    snapshot_read_var(snap, dma_at);
+    snapshot_read_var(snap, dma_mask);
+
+    return snapshot_read_var(snap, dma_ps2);
+}
+
 void
 dma_reset(void)
 {
@@ -1769,6 +1813,162 @@ dma_channel_write(int channel, uint16_t val)
     return 0;
 }
 
+/* Whether the channel is in a state where dma_channel_read() or
+   dma_channel_write() would move data, mode being 8 for reads and 4 for
+   writes. */
+static int
+dma_channel_block_ready(int channel, int mode)
+{
+    const dma_t *dma_c = &dma[channel];
+
+    if (dma_command[channel >> 2] & 0x04)
+        return 0;
+    if (!(dma_e & (1 << channel)))
+        return 0;
+    if ((dma_m & (1 << channel)) && !dma_req_is_soft)
+        return 0;
+
+    return ((dma_c->mode & 0xc) == mode);
+}
+
+/* Number of bytes that can be moved with a single memcpy() from the current
+   address: only plain incrementing 8-bit 8237 transfers qualify, and the run
+   stops at the terminal count, the 64k wrap of the address register and the
+   end of the memory granule. */
+static int
+dma_channel_block_run(int channel, int len)
+{
+    const dma_t *dma_c = &dma[channel];
+    int          run;
+
+    if (dma_advanced || dma_ps2.is_ps2 || dma_c->size || (dma_c->mode & 0x20) ||
+        (!dma_at && !channel) || (dma_stat_adv_pend & (1 << channel)))
+        return 0;
+
+    run = MIN(len, dma_c->cc + 1);
+    run = MIN(run, 0x10000 - (int) (dma_c->ac & 0xffff));
+    run = MIN(run, MEM_GRANULARITY_SIZE - (int) (dma_c->ac & MEM_GRANULARITY_MASK));
+
+    return run;
+}
+
+/* Advance the channel past a run moved by memcpy(), returns 1 if it hit the
+   terminal count. */
+static int
+dma_channel_block_advance(int channel, int run)
+{
+    dma_t *dma_c = &dma[channel];
+
+    dma_c->ac = (dma_c->ac & 0xffff0000 & dma_mask) | ((dma_c->ac + run) & 0xffff);
+
+    dma_stat_rq |= (1 << channel);
+
+    dma_c->cc -= run;
+    if (dma_c->cc < 0) {
+        if (dma_c->mode & 0x10) { /*Auto-init*/
+            dma_c->cc = dma_c->cb;
+            dma_c->ac = dma_c->ab;
+        } else
+            dma_m |= (1 << channel);
+        dma_stat |= (1 << channel);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Block variant of dma_channel_read(): transfers up to len bytes (words on
+   16-bit channels are stored little endian, so len should then be even) into
+   buf, stopping early at the terminal count or when the channel stops
+   accepting transfers. Returns the number of bytes transferred, with
+   DMA_OVER set if the terminal count was reached, or DMA_NODATA if nothing
+   was transferred. len must be below DMA_OVER. */
+int
+dma_channel_read_block(int channel, uint8_t *buf, int len)
+{
+    const dma_t *dma_c = &dma[channel];
+    uint8_t     *p;
+    int          done = 0;
+    int          run;
+    int          ret;
+
+    while (done < len) {
+        if (dma_channel_block_ready(channel, 8) && ((run = dma_channel_block_run(channel, len - done)) > 0) &&
+            ((p = mem_get_phys_ptr(dma_c->ac, 0)) != NULL)) {
+            memcpy(&buf[done], p, run);
+            done += run;
+            if (dma_channel_block_advance(channel, run))
+                return done | DMA_OVER;
+            continue;
+        }
+
+        if (dma_c->size && ((len - done) < 2))
+            break;
+
+        ret = dma_channel_read(channel);
+        if (ret == DMA_NODATA)
+            break;
+
+        buf[done++] = ret & 0xff;
+        if (dma_c->size)
+            buf[done++] = (ret >> 8) & 0xff;
+
+        if (ret & DMA_OVER)
+            return done | DMA_OVER;
+    }
+
+    return done ? done : DMA_NODATA;
+}
+
+/* Block variant of dma_channel_write(), with the same conventions as
+   dma_channel_read_block(). As with dma_channel_write(), DMA_OVER is only
+   returned when the channel got masked at the terminal count. */
+int
+dma_channel_write_block(int channel, const uint8_t *buf, int len)
+{
+    dma_t   *dma_c = &dma[channel];
+    uint8_t *p;
+    uint32_t addr;
+    int      done = 0;
+    int      run;
+    int      ret;
+
+    while (done < len) {
+        if (dma_channel_block_ready(channel, 4) && ((run = dma_channel_block_run(channel, len - done)) > 0) &&
+            ((p = mem_get_phys_ptr(dma_c->ac, 1)) != NULL)) {
+            addr = dma_c->ac;
+            memcpy(p, &buf[done], run);
+            if (dma_at)
+                mem_invalidate_range(addr, addr + run - 1);
+            done += run;
+            if (dma_channel_block_advance(channel, run) && (dma_m & (1 << channel)))
+                return done | DMA_OVER;
+            continue;
+        }
+
+        if (dma_c->size && ((len - done) < 2))
+            break;
+
+        if (dma_c->size) {
+            ret = dma_channel_write(channel, buf[done] | (buf[done + 1] << 8));
+            if (ret != DMA_NODATA)
+                done += 2;
+        } else {
+            ret = dma_channel_write(channel, buf[done]);
+            if (ret != DMA_NODATA)
+                done++;
+        }
+
+        if (ret == DMA_NODATA)
+            break;
+        if (ret & DMA_OVER)
+            return done | DMA_OVER;
+    }
+
+    return done ? done : DMA_NODATA;
+}
+
 static void
 dma_ps2_run(int channel)
 {
@@ -1874,10 +2074,24 @@ dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int Tra
     n  = TotalSize & ~(TransferSize - 1);
     n2 = TotalSize - n;
 
-    /* Do the divisible block, if there is one. */
-    if (n) {
-        for (uint32_t i = 0; i < n; i += TransferSize)
-            mem_read_phys((void *) &(DataRead[i]), PhysAddress + i, TransferSize);
+    /* Do the divisible block, if there is one. Plain RAM is copied a
+       granule at a time, anything else goes through the bus handlers. */
+    for (uint32_t i = 0; i < n;) {
+        const uint8_t *p     = mem_get_phys_ptr(PhysAddress + i, 0);
+        uint32_t       chunk = MEM_GRANULARITY_SIZE - ((PhysAddress + i) & MEM_GRANULARITY_MASK);
+
+        if (p != NULL) {
+            if (chunk > (n - i))
+                chunk = n - i;
+            memcpy(&(DataRead[i]), p, chunk);
+            i += chunk;
+        } else {
+            /* A RAM granule may have left us short of a full transfer. */
+            const int size = ((n - i) < (uint32_t) TransferSize) ? 1 : TransferSize;
+
+            mem_read_phys((void *) &(DataRead[i]), PhysAddress + i, size);
+            i += size;
+        }
     }
 
     /* Do the non-divisible block, if there is one. */
@@ -1898,9 +2112,22 @@ dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize,
     n2 = TotalSize - n;
 
     /* Do the divisible block, if there is one. */
-    if (n) {
-        for (uint32_t i = 0; i < n; i += TransferSize)
-            mem_write_phys((void *) &(DataWrite[i]), PhysAddress + i, TransferSize);
+    for (uint32_t i = 0; i < n;) {
+        uint8_t *p     = mem_get_phys_ptr(PhysAddress + i, 1);
+        uint32_t chunk = MEM_GRANULARITY_SIZE - ((PhysAddress + i) & MEM_GRANULARITY_MASK);
+
+        if (p != NULL) {
+            if (chunk > (n - i))
+                chunk = n - i;
+            memcpy(p, &(DataWrite[i]), chunk);
+            i += chunk;
+        } else {
+            /* A RAM granule may have left us short of a full transfer. */
+            const int size = ((n - i) < (uint32_t) TransferSize) ? 1 : TransferSize;
+
+            mem_write_phys((void *) &(DataWrite[i]), PhysAddress + i, size);
+            i += size;
+        }
     }
 
     /* Do the non-divisible block, if there is one. */
@@ -1884,7 +1884,9 @@ fdc_callback(void *priv)
                 fdc->interrupt = -4;
             } else
                 fdc->interrupt = -3;
-            timer_set_delay_u64(&fdc->timer, 2048 * TIMER_USEC);
+            /* In turbo mode the heads are already on track 0, only leave the
+               guest a moment to see the busy status. */
+            timer_set_delay_u64(&fdc->timer, (fdd_get_turbo(drive_num) ? 8 : 2048) * TIMER_USEC);
             fdc->stat = 0x10 | (1 << fdc->rw_drive);
             return;
         case 0x0d: /*Format track*/
@@ -2049,7 +2051,9 @@ fdc_is_verify(fdc_t *fdc)
 int
 fdc_data(fdc_t *fdc, uint8_t data, int last)
 {
-    int result = 0;
+    uint8_t buf[16];
+    int     count  = 0;
+    int     result = 0;
 
     if (fdc->deleted & 2) {
         /* We're in a VERIFY command, so return with 0. */
@@ -2105,14 +2109,17 @@ fdc_data(fdc_t *fdc, uint8_t data, int last)
                 fdc->stat       = 0x50;
                 dma_set_drq(fdc->dma_ch, 1);
 
-                while (!fifo_get_empty(fdc->fifo_p)) {
-                    result = dma_channel_write(fdc->dma_ch, fifo_read(fdc->fifo_p));
+                while (!fifo_get_empty(fdc->fifo_p) && (count < (int) sizeof(buf)))
+                    buf[count++] = fifo_read(fdc->fifo_p);
 
-                    if (result & DMA_OVER) {
-                        dma_set_drq(fdc->dma_ch, 0);
-                        fdc->tc = 1;
-                        return -1;
-                    }
+                /* Hand the whole FIFO to the DMA controller in one go, a
+                   short transfer means the channel stopped accepting data. */
+                result = dma_channel_write_block(fdc->dma_ch, buf, count);
+
+                if ((result < count) || (result & DMA_OVER)) {
+                    dma_set_drq(fdc->dma_ch, 0);
+                    fdc->tc = 1;
+                    return -1;
                 }
                 dma_set_drq(fdc->dma_ch, 0);
             }
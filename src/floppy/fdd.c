@@ -932,5 +932,6 @@ fdd_init(void)
 void
 fdd_do_writeback(int drive)
 {
+    d86f_cache_invalidate(drive);
     d86f_handler[drive].writeback(drive);
 }
\ No newline at end of file
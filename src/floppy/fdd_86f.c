@@ -178,6 +178,28 @@ typedef struct sector_t {
  *      If bits 6, 5 are 0, and bit 7 is 1, the extra bitcell count
  *      specifies the entire bitcell count
  */
+
+/* Poll period in turbo mode when the FDC is using DMA, in microseconds. */
+#define D86F_TURBO_DMA_PERIOD 4ULL
+
+/*
+ * Tracks of the sector image formats are encoded into bit cells on every
+ * seek; the last few encoded tracks are kept so that seeking back to one
+ * (the FAT, the directory) only copies it. An entry is dropped when its
+ * track gets written.
+ */
+#define D86F_CACHE_TRACKS 32
+
+typedef struct d86f_cache_t {
+    int       valid;
+    int       track;
+    uint32_t  last_use;
+    uint32_t  words[2];
+    uint32_t  size[2];
+    uint16_t  preceding_bit[2];
+    uint16_t *data[2];
+} d86f_cache_t;
+
 typedef struct d86f_t {
     FILE     *fp;
     uint8_t   state;
@@ -223,6 +245,9 @@ typedef struct d86f_t {
     uint8_t    *outbuf;
     sector_t   *last_side_sector[2];
     uint16_t    crc_table[256];
+
+    uint32_t     cache_use;
+    d86f_cache_t cache[D86F_CACHE_TRACKS];
 } d86f_t;
 
 static const uint8_t encoded_fm[64] = {
@@ -256,6 +281,7 @@ void     d86f_writeback(int drive);
 uint8_t  d86f_poll_read_data(int drive, int side, uint16_t pos);
 void     d86f_poll_write_data(int drive, int side, uint16_t pos, uint8_t data);
 int      d86f_format_conditions(int drive);
+static void d86f_cache_clear(int drive);
 
 #ifdef ENABLE_D86F_LOG
 int d86f_do_log = ENABLE_D86F_LOG;
@@ -565,6 +591,8 @@ d86f_unregister(int drive)
     if (dev == NULL)
         return;
 
+    d86f_cache_clear(drive);
+
     d86f_handler[drive].disk_flags        = null_disk_flags;
     d86f_handler[drive].side_flags        = null_side_flags;
     d86f_handler[drive].writeback         = null_writeback;
@@ -759,6 +787,12 @@ d86f_byteperiod(int drive)
     d86f_t   *dev = d86f[drive];
     uint64_t  ret = 32ULL * TIMER_USEC;
 
+    /* With DMA, a turbo poll moves a whole sector at once and the other
+       states take a single poll each, so nothing needs the guest to keep up
+       with a byte rate. PIO keeps the 32 us per byte the CPU can follow. */
+    if (fdd_get_turbo(drive) && (d86f_fdc != NULL) && fdc_is_dma(d86f_fdc))
+        ret = D86F_TURBO_DMA_PERIOD * TIMER_USEC;
+
     if (!fdd_get_turbo(drive) || (dev->version != 0x0063) || (dev->state == STATE_SECTOR_NOT_FOUND)) {
         double dusec = (double) TIMER_USEC;
         double p     = 2.0;
@@ -1913,8 +1947,10 @@ d86f_format_finish(int drive, int side, int mfm, UNUSED(uint16_t sc), uint16_t g
 
     dev->state = STATE_IDLE;
 
-    if (do_write)
+    if (do_write) {
+        d86f_cache_invalidate(drive);
         d86f_handler[drive].writeback(drive);
+    }
 
     dev->error_condition = 0;
     dev->datac           = 0;
@@ -1928,8 +1964,10 @@ d86f_format_turbo_finish(int drive, UNUSED(int side), int do_write)
 
     dev->state = STATE_IDLE;
 
-    if (do_write)
+    if (do_write) {
+        d86f_cache_invalidate(drive);
         d86f_handler[drive].writeback(drive);
+    }
 
     dev->error_condition = 0;
     dev->datac           = 0;
@@ -2245,6 +2283,7 @@ d86f_turbo_write(int drive, int side)
         dev->data_find.sync_marks = dev->data_find.bits_obtained = dev->data_find.bytes_obtained = 0;
         dev->error_condition                                                                     = 0;
         dev->state                                                                               = STATE_IDLE;
+        d86f_cache_invalidate(drive);
         d86f_handler[drive].writeback(drive);
         fdc_sector_finishread(d86f_fdc);
     }
@@ -3014,6 +3053,137 @@ d86f_zero_track(int drive)
     }
 }
 
+static uint32_t
+d86f_cache_words(int drive, int side)
+{
+    uint32_t raw_size = d86f_handler[drive].get_raw_size(drive, side);
+
+    return MIN((raw_size + 15) >> 4, 53048);
+}
+
+/* The encoding only depends on the track when writes are enabled, turbo
+   mode (which also builds the sector lists) is off, and there is no surface
+   description. */
+static int
+d86f_cache_usable(int drive)
+{
+    const d86f_t *dev = d86f[drive];
+
+    return (dev != NULL) && (dev->version == 0x0063) && !fdd_get_turbo(drive) &&
+           !d86f_has_surface_desc(drive) && !fdc_get_diswr(d86f_fdc);
+}
+
+/* Returns 1 if the track was restored, in which case it must not be prepared. */
+int
+d86f_cache_restore(int drive, int track)
+{
+    d86f_t       *dev = d86f[drive];
+    d86f_cache_t *c;
+    int           sides;
+
+    if (!d86f_cache_usable(drive))
+        return 0;
+
+    sides = d86f_get_sides(drive);
+
+    for (int i = 0; i < D86F_CACHE_TRACKS; i++) {
+        c = &dev->cache[i];
+        if (!c->valid || (c->track != track))
+            continue;
+
+        for (int side = 0; side < sides; side++) {
+            if (c->words[side] != d86f_cache_words(drive, side))
+                return 0;
+        }
+
+        for (int side = 0; side < sides; side++) {
+            memcpy(dev->track_encoded_data[side], c->data[side], c->words[side] * sizeof(uint16_t));
+            dev->preceding_bit[side]  = c->preceding_bit[side];
+            dev->index_hole_pos[side] = 0;
+        }
+
+        c->last_use = ++dev->cache_use;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Keep the track that was just prepared. */
+void
+d86f_cache_store(int drive, int track)
+{
+    d86f_t       *dev = d86f[drive];
+    d86f_cache_t *c   = &dev->cache[0];
+    int           sides;
+
+    if (!d86f_cache_usable(drive))
+        return;
+
+    sides = d86f_get_sides(drive);
+
+    for (int i = 0; i < D86F_CACHE_TRACKS; i++) {
+        if (dev->cache[i].valid && (dev->cache[i].track == track)) {
+            c = &dev->cache[i];
+            break;
+        }
+
+        if (!dev->cache[i].valid)
+            c = &dev->cache[i];
+        else if (c->valid && (dev->cache[i].last_use < c->last_use))
+            c = &dev->cache[i];
+    }
+
+    c->valid = 0;
+
+    for (int side = 0; side < sides; side++) {
+        c->words[side] = d86f_cache_words(drive, side);
+        if (c->words[side] > c->size[side]) {
+            uint16_t *data = (uint16_t *) realloc(c->data[side], c->words[side] * sizeof(uint16_t));
+            if (data == NULL)
+                return;
+            c->data[side] = data;
+            c->size[side] = c->words[side];
+        }
+
+        memcpy(c->data[side], dev->track_encoded_data[side], c->words[side] * sizeof(uint16_t));
+        c->preceding_bit[side] = dev->preceding_bit[side];
+    }
+
+    c->track    = track;
+    c->last_use = ++dev->cache_use;
+    c->valid    = 1;
+}
+
+/* The current track is being written back, its encoding is out of date. */
+void
+d86f_cache_invalidate(int drive)
+{
+    d86f_t *dev = d86f[drive];
+
+    if (dev == NULL)
+        return;
+
+    for (int i = 0; i < D86F_CACHE_TRACKS; i++) {
+        if (dev->cache[i].track == dev->cur_track)
+            dev->cache[i].valid = 0;
+    }
+}
+
+static void
+d86f_cache_clear(int drive)
+{
+    d86f_t *dev = d86f[drive];
+
+    for (int i = 0; i < D86F_CACHE_TRACKS; i++) {
+        free(dev->cache[i].data[0]);
+        free(dev->cache[i].data[1]);
+    }
+
+    memset(dev->cache, 0x00, sizeof(dev->cache));
+    dev->cache_use = 0;
+}
+
 void
 d86f_seek(int drive, int track)
 {
@@ -3985,6 +4155,8 @@ d86f_destroy(int drive)
     d86f_destroy_linked_lists(drive, 0);
     d86f_destroy_linked_lists(drive, 1);
 
+    d86f_cache_clear(drive);
+
     free(d86f[drive]);
     d86f[drive] = NULL;
 
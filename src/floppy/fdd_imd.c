@@ -307,6 +307,7 @@ imd_seek(int drive, int track)
     const char *n_map = NULL;
     uint8_t    *data;
     int         flags = 0x00;
+    int         cached;
 
     if (dev->fp == NULL)
         return;
@@ -334,6 +335,11 @@ imd_seek(int drive, int track)
     if (track > dev->track_count)
         return;
 
+    /* The sectors are still copied to the track buffers if the encoded track
+       was cached, only its preparation is skipped. */
+    cached      = d86f_cache_restore(drive, track);
+    current_pos = 0;
+
     for (int side = 0; side < dev->sides; side++) {
         if (!dev->tracks[track][side].is_present)
             continue;
@@ -369,7 +375,8 @@ imd_seek(int drive, int track)
 
         interleave_type = track_is_interleave(drive, side, track);
 
-        current_pos = d86f_prepare_pretrack(drive, side, 0);
+        if (!cached)
+            current_pos = d86f_prepare_pretrack(drive, side, 0);
 
         if (!xdf_type) {
             for (sector = 0; sector < dev->tracks[track][side].params[3]; sector++) {
@@ -400,7 +407,8 @@ imd_seek(int drive, int track)
 
                 sector_to_buffer(drive, track, side, data, actual_sector, ssize);
 
-                current_pos = d86f_prepare_sector(drive, side, current_pos, id, data, ssize, 22, track_gap3, flags);
+                if (!cached)
+                    current_pos = d86f_prepare_sector(drive, side, current_pos, id, data, ssize, 22, track_gap3, flags);
                 track_buf_pos[side] += ssize;
 
                 if (sector == 0)
@@ -433,10 +441,12 @@ imd_seek(int drive, int track)
 
                 sector_to_buffer(drive, track, side, data, ordered_pos, ssize);
 
-                if (is_trackx)
-                    current_pos = d86f_prepare_sector(drive, side, xdf_trackx_spos[xdf_type][xdf_sector], id, data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], flags);
-                else
-                    current_pos = d86f_prepare_sector(drive, side, current_pos, id, data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], flags);
+                if (!cached) {
+                    if (is_trackx)
+                        current_pos = d86f_prepare_sector(drive, side, xdf_trackx_spos[xdf_type][xdf_sector], id, data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], flags);
+                    else
+                        current_pos = d86f_prepare_sector(drive, side, current_pos, id, data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], flags);
+                }
 
                 track_buf_pos[side] += ssize;
 
@@ -445,6 +455,9 @@ imd_seek(int drive, int track)
             }
         }
     }
+
+    if (!cached)
+        d86f_cache_store(drive, track);
 }
 
 static uint16_t
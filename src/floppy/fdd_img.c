@@ -506,6 +506,7 @@ img_seek(int drive, int track)
     int      buf_pos;
     int      ssize   = 128 << ((int) dev->sector_size);
     uint32_t cur_pos = 0;
+    int      cached;
 
     if (dev->fp == NULL)
         return;
@@ -545,9 +546,15 @@ img_seek(int drive, int track)
         return;
     }
 
+    /* The sector positions are still worked out below if the encoded track
+       was cached, only its preparation is skipped. */
+    cached      = d86f_cache_restore(drive, track);
+    current_pos = 0;
+
     if (!dev->xdf_type || dev->is_cqm) {
         for (side = 0; side < dev->sides; side++) {
-            current_pos = d86f_prepare_pretrack(drive, side, 0);
+            if (!cached)
+                current_pos = d86f_prepare_pretrack(drive, side, 0);
 
             for (sector = 0; sector < dev->sectors; sector++) {
                 if (dev->is_cqm) {
@@ -571,7 +578,8 @@ img_seek(int drive, int track)
                 id[3]                          = dev->sector_size;
                 dev->sector_pos_side[side][sr] = side;
                 dev->sector_pos[side][sr]      = (sr - 1) * ssize;
-                current_pos                    = d86f_prepare_sector(drive, side, current_pos, id, &dev->track_data[side][(sr - 1) * ssize], ssize, dev->gap2_size, dev->gap3_size, 0);
+                if (!cached)
+                    current_pos = d86f_prepare_sector(drive, side, current_pos, id, &dev->track_data[side][(sr - 1) * ssize], ssize, dev->gap2_size, dev->gap3_size, 0);
 
                 if (sector == 0)
                     d86f_initialize_last_sector_id(drive, id[0], id[1], id[2], id[3]);
@@ -604,7 +612,8 @@ img_seek(int drive, int track)
 
         /* Pass 2, prepare the actual track. */
         for (side = 0; side < dev->sides; side++) {
-            current_pos = d86f_prepare_pretrack(drive, side, 0);
+            if (!cached)
+                current_pos = d86f_prepare_pretrack(drive, side, 0);
 
             for (sector = 0; sector < xdf_physical_sectors[current_xdft][!is_t0]; sector++) {
                 array_sector = (side * xdf_physical_sectors[current_xdft][!is_t0]) + sector;
@@ -616,12 +625,14 @@ img_seek(int drive, int track)
                 id[2] = xdf_disk_sector.id.r;
 
                 if (is_t0) {
-                    id[3]       = 2;
-                    current_pos = d86f_prepare_sector(drive, side, current_pos, id, &dev->track_data[buf_side][buf_pos], ssize, dev->gap2_size, xdf_gap3_sizes[current_xdft][!is_t0], 0);
+                    id[3] = 2;
+                    if (!cached)
+                        current_pos = d86f_prepare_sector(drive, side, current_pos, id, &dev->track_data[buf_side][buf_pos], ssize, dev->gap2_size, xdf_gap3_sizes[current_xdft][!is_t0], 0);
                 } else {
-                    id[3]       = id[2] & 7;
-                    ssize       = (128 << id[3]);
-                    current_pos = d86f_prepare_sector(drive, side, xdf_trackx_spos[current_xdft][array_sector], id, &dev->track_data[buf_side][buf_pos], ssize, dev->gap2_size, xdf_gap3_sizes[current_xdft][!is_t0], 0);
+                    id[3] = id[2] & 7;
+                    ssize = (128 << id[3]);
+                    if (!cached)
+                        current_pos = d86f_prepare_sector(drive, side, xdf_trackx_spos[current_xdft][array_sector], id, &dev->track_data[buf_side][buf_pos], ssize, dev->gap2_size, xdf_gap3_sizes[current_xdft][!is_t0], 0);
                 }
 
                 if (sector == 0)
@@ -629,6 +640,9 @@ img_seek(int drive, int track)
             }
         }
     }
+
+    if (!cached)
+        d86f_cache_store(drive, track);
 }
 
 void
@@ -42,7 +42,6 @@
 #include <86box/fdc.h>
 #include "lzw/lzw.h"
 
-#define BUFSZ         512 /* new input buffer */
 #define TD0_MAX_BUFSZ (1024UL * 1024UL * 4UL)
 
 /* LZSS Parameters */
@@ -64,16 +63,13 @@ typedef struct tdlzhuf_t {
     uint16_t bufcnt;      /* string buffer */
     uint16_t bufndx;      /* string buffer */
     uint16_t bufpos;      /* string buffer */
-                          /* the following to allow block reads
-                             from input in next_word() */
-    uint16_t ibufcnt;     /* input buffer counters */
-    uint16_t ibufndx;     /* input buffer counters */
-    uint8_t inbuf[BUFSZ]; /* input buffer */
 } tdlzhuf;
 
 typedef struct td0dsk_t {
-    FILE *fdd_file;
-    off_t fdd_file_offset;
+    /* The compressed data, read from the file in one go. */
+    const uint8_t *in;
+    uint32_t       in_len;
+    uint32_t       in_pos;
 
     tdlzhuf  tdctl;
     uint8_t  text_buf[N + F - 1];
@@ -248,36 +244,17 @@ dsk_identify(int drive)
     return 0;
 }
 
-static int
-state_data_read(td0dsk_t *state, uint8_t *buf, uint16_t size)
-{
-    uint32_t image_size = 0;
-
-    fseek(state->fdd_file, 0, SEEK_END);
-    image_size = ftell(state->fdd_file);
-    if (size > image_size - state->fdd_file_offset)
-        size = (image_size - state->fdd_file_offset) & 0xffff;
-    if (fseek(state->fdd_file, state->fdd_file_offset, SEEK_SET) == -1)
-        fatal("TD0: Failed to seek in state_data_read()\n");
-    if (fread(buf, 1, size, state->fdd_file) != size)
-        fatal("TD0: Error reading data in state_data_read()\n");
-    state->fdd_file_offset += size;
-
-    return size;
-}
-
 static int
 state_next_word(td0dsk_t *state)
 {
-    if (state->tdctl.ibufndx >= state->tdctl.ibufcnt) {
-        state->tdctl.ibufndx = 0;
-        state->tdctl.ibufcnt = state_data_read(state, state->tdctl.inbuf, BUFSZ);
-        if (state->tdctl.ibufcnt == 0)
-            return (-1);
-    }
+    /* Decoding stops once every input byte was consumed, like it did when
+       the input was read from the file a block at a time. */
+    if (state->in_pos >= state->in_len)
+        return (-1);
 
     while (state->getlen <= 8) { /* typically reads a word at a time */
-        state->getbuf |= state->tdctl.inbuf[state->tdctl.ibufndx++] << (8 - state->getlen);
+        if (state->in_pos < state->in_len)
+            state->getbuf |= state->in[state->in_pos++] << (8 - state->getlen);
         state->getlen += 8;
     }
 
@@ -489,10 +466,10 @@ state_DecodePosition(td0dsk_t *state)
 static void
 state_init_Decode(td0dsk_t *state)
 {
-    state->getbuf        = 0;
-    state->getlen        = 0;
-    state->tdctl.ibufcnt = state->tdctl.ibufndx = 0; /* input buffer is empty */
-    state->tdctl.bufcnt                         = 0;
+    state->getbuf       = 0;
+    state->getlen       = 0;
+    state->in_pos       = 0; /* input buffer is empty */
+    state->tdctl.bufcnt = 0;
 
     state_StartHuff(state);
     for (uint16_t i = 0; i < N - F; i++)
@@ -653,9 +630,13 @@ td0_initialize(int drive)
     if (header[0] == 't') {
         if (((header[4] / 10) % 10) == 2) {
             td0_log("TD0: File is compressed (TeleDisk 2.x, LZHUF)\n");
-            disk_decode.fdd_file = dev->fp;
+            if (fseek(dev->fp, 12, SEEK_SET) == -1)
+                fatal("td0_initialize(): Error seeking to offet 12\n");
+            if (fread(dev->lzw_buf, 1, file_size - 12, dev->fp) != (file_size - 12))
+                fatal("td0_initialize(): Error reading LZHUF-encoded buffer\n");
+            disk_decode.in     = dev->lzw_buf;
+            disk_decode.in_len = file_size - 12;
             state_init_Decode(&disk_decode);
-            disk_decode.fdd_file_offset = 12;
             state_Decode(&disk_decode, dev->imagebuf, TD0_MAX_BUFSZ);
         } else {
             td0_log("TD0: File is compressed (TeleDisk 1.x, LZW)\n");
@@ -1076,6 +1057,7 @@ td0_seek(int drive, int track)
     int     actual_sector   = 0;
     int     fm;
     int     sector_adjusted;
+    int     cached;
 
     if (dev->fp == NULL)
         return;
@@ -1102,6 +1084,11 @@ td0_seek(int drive, int track)
         return;
     }
 
+    /* The sector IDs are still gone through if the encoded track was
+       cached, only its preparation is skipped. */
+    cached      = d86f_cache_restore(drive, track);
+    current_pos = 0;
+
     for (int side = 0; side < dev->sides; side++) {
         track_rate = dev->current_side_flags[side] & 7;
         /* Make sure 300 kbps @ 360 rpm is treated the same as 250 kbps @ 300 rpm. */
@@ -1119,7 +1106,8 @@ td0_seek(int drive, int track)
 
         interleave_type = track_is_interleave(drive, side, track);
 
-        current_pos     = d86f_prepare_pretrack(drive, side, 0);
+        if (!cached)
+            current_pos = d86f_prepare_pretrack(drive, side, 0);
         sector_adjusted = 0;
 
         if (!xdf_type) {
@@ -1142,7 +1130,8 @@ td0_seek(int drive, int track)
                     ssize = 3;
                 else
                     ssize = 128 << ((uint32_t) id[3]);
-                current_pos = d86f_prepare_sector(drive, side, current_pos, id, dev->sects[track][side][actual_sector].data, ssize, track_gap2, track_gap3, dev->sects[track][side][actual_sector].flags);
+                if (!cached)
+                    current_pos = d86f_prepare_sector(drive, side, current_pos, id, dev->sects[track][side][actual_sector].data, ssize, track_gap2, track_gap3, dev->sects[track][side][actual_sector].flags);
 
                 if (sector_adjusted == 0)
                     d86f_initialize_last_sector_id(drive, id[0], id[1], id[2], id[3]);
@@ -1165,10 +1154,12 @@ td0_seek(int drive, int track)
                     ssize = 3;
                 else
                     ssize = 128 << ((uint32_t) id[3]);
-                if (is_trackx)
-                    current_pos = d86f_prepare_sector(drive, side, xdf_trackx_spos[xdf_type][xdf_sector], id, dev->sects[track][side][ordered_pos].data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], dev->sects[track][side][ordered_pos].flags);
-                else
-                    current_pos = d86f_prepare_sector(drive, side, current_pos, id, dev->sects[track][side][ordered_pos].data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], dev->sects[track][side][ordered_pos].flags);
+                if (!cached) {
+                    if (is_trackx)
+                        current_pos = d86f_prepare_sector(drive, side, xdf_trackx_spos[xdf_type][xdf_sector], id, dev->sects[track][side][ordered_pos].data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], dev->sects[track][side][ordered_pos].flags);
+                    else
+                        current_pos = d86f_prepare_sector(drive, side, current_pos, id, dev->sects[track][side][ordered_pos].data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], dev->sects[track][side][ordered_pos].flags);
+                }
 
                 if (sector_adjusted == 0)
                     d86f_initialize_last_sector_id(drive, id[0], id[1], id[2], id[3]);
@@ -1178,6 +1169,9 @@ td0_seek(int drive, int track)
             }
         }
     }
+
+    if (!cached)
+        d86f_cache_store(drive, track);
 }
 
 void
@@ -352,6 +352,31 @@ static gdbstub_breakpoint_t *first_awatch = NULL;
 int      gdbstub_step = 0;
 int      gdbstub_next_asap = 0;
 uint64_t gdbstub_watch_pages[(((uint32_t) -1) >> (MEM_GRANULARITY_BITS + 6)) + 1];
+uint64_t gdbstub_break_pages[(((uint32_t) -1) >> (MEM_GRANULARITY_BITS + 6)) + 1];
+
+static volatile int gdbstub_flush_lookups = 0;
+
+/* Rebuild the map of code pages with hardware breakpoints. A recompiled
+   block may run on from the page before, so that one is flagged as well. */
+static void
+gdbstub_update_break_pages(void)
+{
+    gdbstub_breakpoint_t *breakpoint = first_hwbreak;
+    uint32_t              page;
+
+    memset(gdbstub_break_pages, 0, sizeof(gdbstub_break_pages));
+
+    while (breakpoint) {
+        page = breakpoint->addr >> MEM_GRANULARITY_BITS;
+        gdbstub_break_pages[page >> 6] |= (1ULL << (page & 63));
+        if (page > 0) {
+            page--;
+            gdbstub_break_pages[page >> 6] |= (1ULL << (page & 63));
+        }
+
+        breakpoint = breakpoint->next;
+    }
+}
 
 static void
 gdbstub_break(void)
@@ -1359,7 +1384,11 @@ unknown:
                         l++;
                     }
                 }
-            }
+
+                /* Drop the lookups made before, which would let accesses slip past. */
+                gdbstub_flush_lookups = 1;
+            } else if (client->packet[1] == '1')
+                gdbstub_update_break_pages();
 
             /* Respond positively. */
             goto ok;
@@ -1377,6 +1406,11 @@ gdbstub_cpu_exec(int32_t cycs)
 
     /* Handle CPU execution if it isn't paused. */
     if (gdbstub_step <= GDBSTUB_SSTEP) {
+        if (gdbstub_flush_lookups) {
+            gdbstub_flush_lookups = 0;
+            flushmmucache();
+        }
+
         /* Swap in any software breakpoints. */
         gdbstub_breakpoint_t *swbreak = first_swbreak;
         while (swbreak) {
@@ -1833,8 +1867,9 @@ gdbstub_init(void)
     /* Create client list mutex. */
     client_list_mutex = thread_create_mutex();
 
-    /* Clear watchpoint page map. */
+    /* Clear watchpoint and breakpoint page maps. */
     memset(gdbstub_watch_pages, 0, sizeof(gdbstub_watch_pages));
+    memset(gdbstub_break_pages, 0, sizeof(gdbstub_break_pages));
 
     /* Start server thread. */
     pclog("GDB Stub: Listening on port %d\n", port);
@@ -147,6 +147,9 @@ extern "C" {
 /* Global variables. */
 extern int dump_on_exit;        /* (O) dump regs on exit*/
 extern int start_in_fullscreen; /* (O) start in fullscreen */
+#ifdef USE_SDL_UI
+extern int start_headless; /* (O) run without a display */
+#endif
 #ifdef _WIN32
 extern int force_debug; /* (O) force debug output */
 #endif
@@ -187,6 +190,7 @@ extern int      vid_cga_comp_hue;           /* (C) CGA composite hue */
 extern int      vid_cga_comp_saturation;    /* (C) CGA composite saturation */
 extern int      vid_cga_comp_contrast;      /* (C) CGA composite saturation */
 extern int      video_fullscreen;           /* (C) video */
+extern int      video_screenshot_format;    /* (C) screenshot file format */
 extern int      video_fullscreen_scale;     /* (C) video */
 extern int      enable_overscan;            /* (C) video */
 extern int      force_43;                   /* (C) video */
@@ -205,6 +209,7 @@ extern int      isamem_type[];              /* (C) enable ISA mem cards */
 extern int      isarom_type[];              /* (C) enable ISA ROM cards */
 extern int      isartc_type;                /* (C) enable ISA RTC card */
 extern int      sound_is_float;             /* (C) sound uses FP values */
+extern int      sound_low_latency;          /* (C) queue less audio ahead */
 extern int      voodoo_enabled;             /* (C) video option */
 extern int      ibm8514_standalone_enabled; /* (C) video option */
 extern int      xga_standalone_enabled;     /* (C) video option */
@@ -213,6 +218,9 @@ extern uint32_t mem_size;                   /* (C) memory size (Installed on sys
 extern uint32_t isa_mem_size;               /* (C) memory size (ISA Memory Cards) */
 extern int      cpu;                        /* (C) cpu type */
 extern int      cpu_use_dynarec;            /* (C) cpu uses/needs Dyna */
+extern int      dynarec_cache_size;         /* (C) dynarec code cache size in MB, 0 = default */
+extern int      dynarec_stats;              /* (C) show dynarec statistics in the status bar */
+extern int      mem_huge_pages;             /* (C) back guest RAM and the code cache with host huge pages */
 extern int      fpu_type;                   /* (C) fpu type */
 extern int      fpu_softfloat;              /* (C) fpu uses softfloat */
 extern int      time_sync;                  /* (C) enable time sync */
@@ -222,6 +230,11 @@ extern int      confirm_exit;               /* (G) enable exit confirmation */
 extern int      confirm_save;               /* (G) enable save confirmation */
 extern int      enable_discord;             /* (C) enable Discord integration */
 extern int      force_10ms;                 /* (C) force 10ms CPU frame interval */
+extern int      cpu_frame_adaptive;         /* (C) size CPU frames to the real time owed */
+extern int      cpu_frame_ms;               /* length of the last CPU frame, in ms */
+extern int      hlt_fast_forward;           /* (C) skip halted CPU time to the next timer */
+extern int      turbo_boot_ms;              /* (C) unpaced boot deadline in emulated ms */
+extern int      turbo_boot;                 /* unpaced boot currently in progress */
 extern int      jumpered_internal_ecp_dma;  /* (C) Jumpered internal EPC DMA */
 extern int      other_ide_present;          /* IDE controllers from non-IDE cards are present */
 extern int      other_scsi_present;         /* SCSI controllers from non-SCSI cards are present */
@@ -302,9 +315,34 @@ extern void pc_speed_changed(void);
 extern void pc_send_cad(void);
 extern void pc_send_cae(void);
 extern void pc_send_cab(void);
-extern void pc_run(void);
+extern int  pc_run(int budget_ms);
 extern void pc_start(void);
 extern void pc_onesec(void);
+extern void pc_turbo_boot_end(void);
+
+/* Performance counters, as rates over the last second; refreshed by pc_onesec(). */
+typedef struct pc_perf_t {
+    uint32_t speed;              /* emulated time per real time, in percent */
+    uint32_t frames;             /* video frames per emulated second */
+    uint32_t frames_dropped;     /* frames not blitted because the blitter was busy */
+    uint32_t frames_blocked;     /* frames where the emulation waited for the blitter */
+    uint32_t audio_underruns;
+    uint64_t timer_callbacks;
+    uint64_t instructions;       /* guest instructions executed */
+    uint64_t dynarec_compiled;   /* blocks */
+    uint64_t dynarec_evicted;
+    uint64_t dynarec_uops;       /* uOPs in the blocks compiled */
+    uint64_t dynarec_host_bytes; /* host code emitted for them */
+    uint64_t dynarec_smc;        /* blocks thrown out by writes to their code */
+    uint64_t dynarec_flushed;    /* blocks thrown out by code cache resets */
+    uint64_t dynarec_fallbacks;  /* instructions compiled as interpreter calls */
+    uint64_t disk_ops;           /* hard disk reads, writes and zeroes */
+    uint64_t net_rx_packets;
+    uint64_t net_tx_packets;
+} pc_perf_t;
+
+extern void pc_get_perf(pc_perf_t *perf);
+extern void pc_get_perf_totals(pc_perf_t *totals);
 
 extern uint16_t get_last_addr(void);
 
@@ -321,6 +359,9 @@ extern double isa_timing;
 extern int    io_delay;
 extern int    framecountx;
 
+/* Longest CPU frame used by the adaptive frame sizing, in ms. */
+#define CPU_FRAME_MAX_MS 10
+
 extern volatile int     cpu_thread_run;
 extern          uint8_t postcard_codes[POSTCARDS_NUM];
 
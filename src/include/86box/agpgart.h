@@ -15,6 +15,11 @@
 #ifndef EMU_AGPGART_H
 #define EMU_AGPGART_H
 
+typedef struct agpgart_page_s {
+    uint32_t entry; /* GART entry the pointer was looked up for */
+    uint8_t *ptr;   /* host RAM backing the remapped page, NULL if not RAM */
+} agpgart_page_t;
+
 typedef struct agpgart_s {
     int           aperture_enable;
     uint32_t      aperture_base;
@@ -22,6 +27,12 @@ typedef struct agpgart_s {
     uint32_t      aperture_mask;
     uint32_t      gart_base;
     mem_mapping_t aperture_mapping;
+
+    /* Translation cache, rebuilt when the memory map changes. */
+    uint32_t        cache_gen;
+    uint32_t        cache_pages;
+    const uint32_t *gart_table; /* host RAM holding the GART, NULL if not RAM */
+    agpgart_page_t *cache;
 } agpgart_t;
 
 extern void agpgart_set_aperture(agpgart_t *dev, uint32_t base, uint32_t size, int enable);
@@ -383,6 +383,8 @@ typedef struct cdrom {
 } cdrom_t;
 
 extern cdrom_t cdrom[CDROM_NUM];
+extern int     cdrom_image_mmap;
+extern int     cdrom_image_read_ahead;
 
 #define MSFtoLBA(m, s, f)  ((((m * 60) + s) * 75) + f)
 
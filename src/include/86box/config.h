@@ -141,6 +141,7 @@ extern void config_load_global(void);
 extern void config_load(void);
 extern void config_save_global(void);
 extern void config_save(void);
+extern void config_flush(void);
 
 #ifdef EMU_INI_H
 extern ini_t config_get_ini(void);
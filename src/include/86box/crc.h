@@ -25,7 +25,14 @@ typedef union {
 } crc_t;
 
 extern void crc16_setup(uint16_t *crc_table, uint16_t poly);
-extern void crc16_calc(uint16_t *crc_table, uint8_t byte, crc_t *crc_var);
+
+/* Called for every decoded byte of the floppy bitstream, so keep it inline. */
+static inline void
+crc16_calc(const uint16_t *crc_table, uint8_t byte, crc_t *crc_var)
+{
+    crc_var->word = (crc_var->word << 8) ^
+                    crc_table[(crc_var->word >> 8) ^ byte];
+}
 
 #ifdef __cplusplus
 }
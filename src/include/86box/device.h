@@ -155,6 +155,8 @@ typedef struct _device_config_ {
     const device_config_bios_t       bios[32];
 } device_config_t;
 
+struct snapshot_t;
+
 typedef struct _device_ {
     const char *name;
     const char *internal_name;
@@ -172,6 +174,10 @@ typedef struct _device_ {
     void (*force_redraw)(void *priv);
 
     const device_config_t *config;
+
+    /* Optional machine snapshot support, see snapshot.h. */
+    void (*save_state)(void *priv, struct snapshot_t *snap);
+    int  (*load_state)(void *priv, struct snapshot_t *snap);
 } device_t;
 
 typedef struct device_context_t {
@@ -185,6 +191,8 @@ extern "C" {
 #endif
 
 extern void  device_init(void);
+extern void  device_init_async(void (*func)(void *priv), void *priv);
+extern void  device_init_wait(void);
 extern void  device_set_context(device_context_t *ctx, const device_t *dev, int inst);
 extern void  device_context(const device_t *dev);
 extern void  device_context_inst(const device_t *dev, int inst);
@@ -203,11 +211,17 @@ extern void  device_close_all(void);
 extern void  device_reset_all(uint32_t match_flags);
 extern void *device_find_first_priv(uint32_t match_flags);
 extern void *device_get_priv(const device_t *dev);
+extern const char *device_get_name_by_priv(const void *priv);
 extern int   device_available(const device_t *dev);
 extern void  device_speed_changed(void);
 extern void  device_force_redraw(void);
 extern void  device_get_name(const device_t *dev, int bus, char *name);
 extern int   device_has_config(const device_t *dev);
+extern int   device_snapshot_supported(char *missing, size_t size);
+extern void  device_snapshot_list(struct snapshot_t *snap);
+extern void  device_snapshot_save(struct snapshot_t *snap);
+extern int   device_snapshot_check(struct snapshot_t *snap);
+extern int   device_snapshot_load(struct snapshot_t *snap);
 
 extern uint8_t     device_get_bios_type(const device_t *dev, const char *internal_name);
 extern uint8_t     device_get_bios_num_files(const device_t *dev, const char *internal_name);
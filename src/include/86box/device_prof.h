@@ -0,0 +1,52 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the per-device host time accounting.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifndef EMU_DEVICE_PROF_H
+#define EMU_DEVICE_PROF_H
+
+enum {
+    DEVICE_PROF_IO = 0, /* port I/O handlers */
+    DEVICE_PROF_MMIO,   /* memory mapping handlers */
+    DEVICE_PROF_TIMER,  /* timer callbacks */
+    DEVICE_PROF_WORKER, /* device worker threads */
+    DEVICE_PROF_KINDS
+};
+
+typedef struct device_prof_stat_t {
+    const char *name;
+    uint64_t    ns[DEVICE_PROF_KINDS];
+    uint64_t    total_ns;
+} device_prof_stat_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int device_profile;
+
+/* Charge the host time since start_ns (from plat_get_nsecs()) to the device owning priv. */
+extern void device_prof_add(const void *priv, int kind, uint64_t start_ns);
+
+/*
+ * Fill stats with up to max devices, hottest first, with the host time each
+ * one used since the previous call; window_ns receives the length of that
+ * interval. Meant for a single UI consumer.
+ */
+extern int  device_prof_get(device_prof_stat_t *stats, int max, uint64_t *window_ns);
+extern void device_prof_reset(void);
+extern void device_profile_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_DEVICE_PROF_H*/
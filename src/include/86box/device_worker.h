@@ -0,0 +1,54 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the device worker threads.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifndef EMU_DEVICE_WORKER_H
+#define EMU_DEVICE_WORKER_H
+
+/* Posted access types, the device is free to define its own on top. */
+#define DEVICE_POST_WRITE_B 0
+#define DEVICE_POST_WRITE_W 1
+#define DEVICE_POST_WRITE_L 2
+#define DEVICE_POST_OUT_B   3
+#define DEVICE_POST_OUT_W   4
+#define DEVICE_POST_OUT_L   5
+#define DEVICE_POST_USER    16
+
+/* Number of posted accesses that can be pending, must be a power of 2. */
+#define DEVICE_WORKER_SIZE  4096
+
+typedef struct device_worker_t device_worker_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A device worker is a thread fed by a single-producer/single-consumer
+ * lock-free ring of posted accesses. The emulation thread posts writes with
+ * device_worker_post() and carries on; the worker thread hands them to the
+ * device's handler in order. Anything that must observe the effect of the
+ * posted writes (register reads, status polls, rendering on the emulation
+ * thread) has to call device_worker_sync() first.
+ */
+extern device_worker_t *device_worker_create(const char *name,
+                                             void (*handler)(void *priv, uint8_t type, uint32_t addr, uint32_t val),
+                                             void *priv);
+extern void             device_worker_post(device_worker_t *worker, uint8_t type, uint32_t addr, uint32_t val);
+extern int              device_worker_busy(device_worker_t *worker);
+extern void             device_worker_sync(device_worker_t *worker);
+extern void             device_worker_close(device_worker_t *worker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_DEVICE_WORKER_H*/
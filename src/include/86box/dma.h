@@ -37,6 +37,8 @@
 #ifndef EMU_DMA_H
 #define EMU_DMA_H
 
+struct snapshot_t;
+
 #define DMA_NODATA -1
 #define DMA_OVER   0x10000
 #define DMA_VERIFY 0x20000
@@ -82,6 +84,8 @@ extern void dma_init(void);
 extern void dma16_init(void);
 extern void ps2_dma_init(void);
 extern void dma_reset(void);
+extern void dma_save_state(struct snapshot_t *snap);
+extern int  dma_load_state(struct snapshot_t *snap);
 extern int  dma_mode(int channel);
 
 extern void    readdma0(void);
@@ -98,6 +102,8 @@ extern int dma_channel_read_only(int channel);
 extern int dma_channel_advance(int channel);
 extern int dma_channel_read(int channel);
 extern int dma_channel_write(int channel, uint16_t val);
+extern int dma_channel_read_block(int channel, uint8_t *buf, int len);
+extern int dma_channel_write_block(int channel, const uint8_t *buf, int len);
 
 extern void dma_alias_set(void);
 extern void dma_alias_set_piix(void);
@@ -86,6 +86,9 @@ extern uint16_t d86f_prepare_pretrack(int drive, int side, int iso);
 extern void     d86f_set_track_pos(int drive, uint32_t track_pos);
 extern void     d86f_set_cur_track(int drive, int track);
 extern void     d86f_zero_track(int drive);
+extern int      d86f_cache_restore(int drive, int track);
+extern void     d86f_cache_store(int drive, int track);
+extern void     d86f_cache_invalidate(int drive);
 extern void     d86f_initialize_last_sector_id(int drive, int c, int h, int r, int n);
 extern void     d86f_initialize_linked_lists(int drive);
 extern void     d86f_destroy_linked_lists(int drive, int side);
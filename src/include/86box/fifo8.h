@@ -54,6 +54,32 @@ extern void fifo8_push(Fifo8 *fifo, uint8_t data);
 
 extern void fifo8_push_all(Fifo8 *fifo, const uint8_t *data, uint32_t num);
 
+/**
+ * fifo8_reserve_span:
+ * @fifo: FIFO to push to
+ * @max: maximum number of bytes to reserve
+ * @numptr: pointer filled with number of bytes reserved (can be NULL)
+ *
+ * Reserve up to @max bytes of contiguous free space at the tail of the FIFO,
+ * so that a device can fill the FIFO storage directly (from DMA or a disk
+ * read) with no intermediate buffer. The span returned may be shorter than
+ * requested when the free space wraps around in the ring buffer; after
+ * fifo8_commit() a second call returns the rest. The bytes only become part
+ * of the FIFO once committed. The span is invalidated by fifo8_reset().
+ *
+ * Returns: A pointer to the reserved space.
+ */
+extern uint8_t *fifo8_reserve_span(Fifo8 *fifo, uint32_t max, uint32_t *numptr);
+
+/**
+ * fifo8_commit:
+ * @fifo: FIFO to push to
+ * @num: number of bytes written into the span from fifo8_reserve_span()
+ *
+ * Append the first @num bytes of the reserved span to the FIFO.
+ */
+extern void fifo8_commit(Fifo8 *fifo, uint32_t num);
+
 /**
  * fifo8_pop:
  * @fifo: fifo to pop from
@@ -135,6 +161,21 @@ extern const uint8_t *fifo8_pop_bufptr(Fifo8 *fifo, uint32_t max, uint32_t *nump
  */
 extern const uint8_t *fifo8_peek_bufptr(Fifo8 *fifo, uint32_t max, uint32_t *numptr);
 
+/**
+ * fifo8_peek_span:
+ * @fifo: FIFO to read from
+ * @numptr: pointer filled with number of bytes returned (can be NULL)
+ *
+ * Return the contiguous run of data at the head of the FIFO, for a device to
+ * consume in place and then release with fifo8_drop(). Unlike
+ * fifo8_peek_bufptr() the FIFO may be empty, *@numptr is 0 then. The run
+ * stops at the end of the ring buffer; after fifo8_drop() a second call
+ * returns the data that wrapped around.
+ *
+ * Returns: A pointer to the data at the head of the FIFO.
+ */
+extern const uint8_t *fifo8_peek_span(Fifo8 *fifo, uint32_t *numptr);
+
 /**
  * fifo8_drop:
  * @fifo: FIFO to drop bytes
@@ -395,55 +395,53 @@ sb_iir(int c, int i, double NewSample)
 #define NCoef      1
 #define SB16_NCoef 51
 
-extern double low_fir_sb16_coef[5][SB16_NCoef];
+/* Dot product of n taps with the n most recent samples (newest first). */
+extern float sound_fir_dot(const float *coef, const float *hist, int n);
+
+extern float low_fir_sb16_coef[5][SB16_NCoef];
 
 static inline double
 low_fir_sb16(int c, int i, double NewSample)
 {
-    static double x[4][2][SB16_NCoef + 1]; // input samples
-    static int    pos[4] = { 0, 0, 0, 0 };
-    double        out    = 0.0;
-    int           n;
+    /* Input samples, each one stored twice so that the last SB16_NCoef are
+       always contiguous, newest first, starting at x[pos]. */
+    static float x[4][2][SB16_NCoef * 2];
+    static int   pos[4] = { 0, 0, 0, 0 };
+    double       out;
 
     /* Calculate the new output */
-    x[c][i][pos[c]] = NewSample;
+    x[c][i][pos[c]] = x[c][i][pos[c] + SB16_NCoef] = (float) NewSample;
 
-    for (n = 0; n < ((SB16_NCoef + 1) - pos[c]) && n < SB16_NCoef; n++)
-        out += low_fir_sb16_coef[c][n] * x[c][i][n + pos[c]];
-    for (; n < SB16_NCoef; n++)
-        out += low_fir_sb16_coef[c][n] * x[c][i][(n + pos[c]) - (SB16_NCoef + 1)];
+    out = sound_fir_dot(low_fir_sb16_coef[c], &x[c][i][pos[c]], SB16_NCoef);
 
     if (i == 1) {
-        pos[c]++;
-        if (pos[c] > SB16_NCoef)
-            pos[c] = 0;
+        pos[c]--;
+        if (pos[c] < 0)
+            pos[c] = SB16_NCoef - 1;
     }
 
     return out;
 }
 
-extern double low_fir_pas16_coef[SB16_NCoef];
+extern float low_fir_pas16_coef[SB16_NCoef];
 
 static inline double
 low_fir_pas16(const int i, const double NewSample)
 {
-    static double x[2][SB16_NCoef + 1]; // input samples
-    static int    pos = 0;
-    double        out = 0.0;
-    int           n;
+    /* Same layout as above. */
+    static float x[2][SB16_NCoef * 2];
+    static int   pos = 0;
+    double       out;
 
     /* Calculate the new output */
-    x[i][pos] = NewSample;
+    x[i][pos] = x[i][pos + SB16_NCoef] = (float) NewSample;
 
-    for (n = 0; n < ((SB16_NCoef + 1) - pos) && n < SB16_NCoef; n++)
-        out += low_fir_pas16_coef[n] * x[i][n + pos];
-    for (; n < SB16_NCoef; n++)
-        out += low_fir_pas16_coef[n] * x[i][(n + pos) - (SB16_NCoef + 1)];
+    out = sound_fir_dot(low_fir_pas16_coef, &x[i][pos], SB16_NCoef);
 
     if (i == 1) {
-        pos++;
-        if (pos > SB16_NCoef)
-            pos = 0;
+        pos--;
+        if (pos < 0)
+            pos = SB16_NCoef - 1;
     }
 
     return out;
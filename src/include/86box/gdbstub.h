@@ -50,6 +50,26 @@ enum {
 
 extern int      gdbstub_step, gdbstub_next_asap;
 extern uint64_t gdbstub_watch_pages[(((uint32_t) -1) >> (MEM_GRANULARITY_BITS + 6)) + 1];
+extern uint64_t gdbstub_break_pages[(((uint32_t) -1) >> (MEM_GRANULARITY_BITS + 6)) + 1];
+
+/* Accesses to pages with watchpoints are kept off the fast lookup tables. */
+static inline int
+gdbstub_page_watched(uint32_t addr)
+{
+    uint32_t page = addr >> MEM_GRANULARITY_BITS;
+
+    return !!(gdbstub_watch_pages[page >> 6] & (1ULL << (page & 63)));
+}
+
+/* The recompiler runs everything but single steps and the code pages with
+   hardware breakpoints, which go one instruction at a time. */
+static inline int
+gdbstub_single_ins(uint32_t addr)
+{
+    uint32_t page = addr >> MEM_GRANULARITY_BITS;
+
+    return (gdbstub_step != GDBSTUB_EXEC) || (gdbstub_break_pages[page >> 6] & (1ULL << (page & 63)));
+}
 
 extern void gdbstub_cpu_init(void);
 extern int  gdbstub_instruction(void);
@@ -66,6 +86,9 @@ extern void gdbstub_close(void);
 #    define gdbstub_step      0
 #    define gdbstub_next_asap 0
 
+#    define gdbstub_page_watched(addr) 0
+#    define gdbstub_single_ins(addr)   0
+
 #    define gdbstub_cpu_init()
 #    define gdbstub_instruction() 0
 #    define gdbstub_int3()        0
@@ -0,0 +1,36 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the string hash used by the name lookups.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifndef EMU_HASH_H
+#define EMU_HASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* FNV-1a over at most max bytes of a string; pass SIZE_MAX for all of it. */
+static inline uint32_t
+name_hash(const char *s, size_t max)
+{
+    uint32_t h = 0x811c9dc5;
+
+    for (size_t i = 0; (i < max) && s[i]; i++)
+        h = (h ^ (uint8_t) s[i]) * 0x01000193;
+
+    return h;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_HASH_H*/
@@ -17,6 +17,8 @@
 #ifndef EMU_HDD_H
 #define EMU_HDD_H
 
+struct snapshot_t;
+
 #define IMG_FMT_RAW         0
 #define IMG_FMT_HDI         1
 #define IMG_FMT_HDX         2
@@ -156,7 +158,9 @@ typedef struct hard_disk_t {
                                         Bit 1 = DMA supportd. */
     uint8_t            wp;           /* Disk has been mounted
                                         READ-ONLY */
-    uint8_t            pad;
+    uint8_t            overlay;      /* Writes go to a throwaway
+                                        overlay, the image is
+                                        left untouched */
     uint8_t            pad0;
 
     void              *priv;
@@ -207,20 +211,30 @@ extern int   hdd_string_to_bus(char *str, int cdrom);
 extern char *hdd_bus_to_string(int bus, int cdrom);
 extern int   hdd_is_valid(int c);
 
+extern int hdd_image_mmap;
+extern int hdd_image_cache_size;
+extern int hdd_image_cache_write_through;
+
 extern void     hdd_image_init(void);
 extern int      hdd_image_load(int id);
 extern int      hdd_image_seek(uint8_t id, uint32_t sector);
+extern uint64_t hdd_image_ops;
 extern int      hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern void     hdd_image_prefetch(uint8_t id, uint32_t sector, uint32_t count);
 extern int      hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int      hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int      hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int      hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count);
 extern int      hdd_image_zero_ex(uint8_t id, uint32_t sector, uint32_t count);
+extern int      hdd_image_flush(uint8_t id);
+extern void     hdd_image_idle(void);
 extern uint32_t hdd_image_get_last_sector(uint8_t id);
 extern uint32_t hdd_image_get_pos(uint8_t id);
 extern uint8_t  hdd_image_get_type(uint8_t id);
 extern void     hdd_image_unload(uint8_t id, int fn_preserve);
 extern void     hdd_image_close(uint8_t id);
+extern int      hdd_image_save_state(uint8_t id, struct snapshot_t *snap);
+extern int      hdd_image_load_state(uint8_t id, struct snapshot_t *snap);
 extern void     hdd_image_calc_chs(uint32_t *c, uint32_t *h, uint32_t *s, uint32_t size);
 
 extern int image_is_hdi(const char *s);
@@ -35,6 +35,9 @@ extern void  ini_write_ex(ini_t ini, const char *fn, int is_rom);
 extern void  ini_write(ini_t ini, const char *fn);
 extern void  ini_dump(ini_t ini);
 extern void  ini_close(ini_t ini);
+extern ini_t ini_copy(ini_t ini);
+extern int   ini_is_dirty(ini_t ini);
+extern void  ini_clear_dirty(ini_t ini);
 
 extern void     ini_section_delete_var(ini_section_t section, const char *name);
 extern int      ini_section_get_int(ini_section_t section, const char *name, int def);
@@ -38,7 +38,9 @@ extern void log_set_dev_name(void *priv, char *dev_name);
 #ifndef RELEASE_BUILD
 extern void log_out(void *priv, const char *fmt, va_list);
 extern void log_out_cyclic(void* priv, const char *fmt, va_list);
+extern void log_out_global(int suppr_seen, const char *fmt, va_list);
 #endif /*RELEASE_BUILD*/
+extern void log_flush(void);
 extern void log_fatal(void *priv, const char *fmt, ...);
 extern void log_warning(void *priv, const char *fmt, ...);
 extern void *log_open(const char *dev_name);
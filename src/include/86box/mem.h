@@ -19,6 +19,8 @@
 #ifndef EMU_MEM_H
 #define EMU_MEM_H
 
+struct snapshot_t;
+
 #define MEM_MAP_TO_SHADOW_RAM_MASK 1
 #define MEM_MAP_TO_RAM_ADDR_MASK   2
 
@@ -167,6 +169,17 @@ typedef union mem_state_t {
     state_t  states[4];
 } mem_state_t;
 
+/* Access types counted by the memory access profiler. */
+#define MEM_PROFILE_READ_B  0
+#define MEM_PROFILE_READ_W  1
+#define MEM_PROFILE_READ_L  2
+#define MEM_PROFILE_READ_Q  3
+#define MEM_PROFILE_WRITE_B 4
+#define MEM_PROFILE_WRITE_W 5
+#define MEM_PROFILE_WRITE_L 6
+#define MEM_PROFILE_WRITE_Q 7
+#define MEM_PROFILE_TYPES   8
+
 typedef struct _mem_mapping_ {
     struct _mem_mapping_ *prev;
     struct _mem_mapping_ *next;
@@ -193,6 +206,9 @@ typedef struct _mem_mapping_ {
     /* There is never a needed to pass a pointer to the mapping itself, it is much preferable to
        prepare a structure with the requires data (usually, the base address and mask) instead. */
     void *priv; /* backpointer to device */
+
+    /* Accesses that reached this mapping, by MEM_PROFILE_* type, if mem_profile is set. */
+    uint64_t profile[MEM_PROFILE_TYPES];
 } mem_mapping_t;
 
 #ifdef USE_NEW_DYNAREC
@@ -222,6 +238,9 @@ typedef struct page_t {
     uint32_t evict_prev;
     uint32_t evict_next;
 
+    /*Number of code blocks on this page thrown out by writes*/
+    uint32_t invalidations;
+
     uint64_t *byte_dirty_mask;
     uint64_t *byte_code_present_mask;
 } page_t;
@@ -355,6 +374,8 @@ extern uint64_t mmutranslatereal(uint32_t addr, int rw);
 extern uint32_t mmutranslatereal32(uint32_t addr, int rw);
 extern void     addreadlookup(uint32_t virt, uint32_t phys);
 extern void     addwritelookup(uint32_t virt, uint32_t phys);
+extern void     mem_add_host_readlookup(uint32_t virt, uint8_t *page);
+extern void     mem_add_host_writelookup(uint32_t virt, uint8_t *page);
 
 extern void mem_mapping_set(mem_mapping_t *,
                             uint32_t base,
@@ -404,6 +425,14 @@ extern void mem_mapping_set_mask(mem_mapping_t *, uint32_t mask);
 extern void mem_mapping_disable(mem_mapping_t *);
 extern void mem_mapping_enable(mem_mapping_t *);
 extern void mem_mapping_recalc(uint64_t base, uint64_t size);
+extern void mem_mapping_batch_begin(void);
+extern void mem_mapping_batch_commit(void);
+
+extern uint32_t mem_mapping_gen;
+
+extern int  mem_profile;
+extern char mem_profile_path[1024];
+extern void mem_profile_dump(void);
 
 extern void mem_set_wp(uint64_t base, uint64_t size, uint8_t flags, uint8_t wp);
 extern void mem_set_access(uint8_t bitmap, int mode, uint32_t base, uint32_t size, uint16_t access);
@@ -416,6 +445,7 @@ extern void     mem_writeb_phys(uint32_t addr, uint8_t val);
 extern void     mem_writew_phys(uint32_t addr, uint16_t val);
 extern void     mem_writel_phys(uint32_t addr, uint32_t val);
 extern void     mem_write_phys(void *src, uint32_t addr, int tranfer_size);
+extern uint8_t *mem_get_phys_ptr(uint32_t addr, int write);
 
 extern uint8_t  mem_read_ram(uint32_t addr, void *priv);
 extern uint16_t mem_read_ramw(uint32_t addr, void *priv);
@@ -445,6 +475,7 @@ extern void mem_flush_write_page(uint32_t addr, uint32_t virt);
 extern void mem_reset_page_blocks(void);
 
 extern void flushmmucache(void);
+extern void flushmmucache_cr3(void);
 extern void flushmmucache_write(void);
 extern void flushmmucache_pc(void);
 extern void flushmmucache_nopc(void);
@@ -458,6 +489,18 @@ extern void mem_init(void);
 extern void mem_close(void);
 extern void mem_zero(void);
 extern void mem_reset(void);
+extern void mem_save_state(struct snapshot_t *snap);
+extern int  mem_load_state(struct snapshot_t *snap);
+extern void mem_save_state_delta(struct snapshot_t *snap);
+extern int  mem_load_state_delta(struct snapshot_t *snap);
+extern int  mem_can_save_delta(void);
+extern void mem_checkpoint_begin(void);
+extern void mem_checkpoint_end(uint8_t *buf);
+extern void mem_checkpoint_fill(void);
+
+extern size_t mem_protect_page_size(void);
+extern int    mem_protect_init(int (*fault)(void *addr));
+extern int    mem_protect(void *ptr, size_t size, int writable);
 extern void mem_remap_top_ex(int kb, uint32_t start);
 extern void mem_remap_top_ex_nomid(int kb, uint32_t start);
 extern void mem_remap_top(int kb);
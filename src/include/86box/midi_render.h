@@ -0,0 +1,49 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the software synthesizer render threads.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifndef EMU_MIDI_RENDER_H
+#define EMU_MIDI_RENDER_H
+
+/* Number of MIDI events that can be pending, must be a power of 2. */
+#define MIDI_RENDER_QUEUE_SIZE 1024
+
+typedef struct midi_render_t midi_render_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A render thread owns a software synthesizer. The emulation thread queues
+ * MIDI events stamped with the emulated time they were sent at and keeps
+ * the clock going from the MIDI poll; the render thread renders the synth
+ * in blocks, splitting them at the event timestamps, and hands the result
+ * to the MIDI output. The synth is never called from the emulation thread.
+ *
+ * render is handed float frames when sound_is_float is set, 16-bit ones
+ * otherwise.
+ */
+extern midi_render_t *midi_render_create(const char *name, uint32_t samplerate,
+                                         void (*render)(void *priv, void *buf, uint32_t frames),
+                                         void (*msg)(void *priv, uint8_t *msg),
+                                         void (*sysex)(void *priv, uint8_t *data, unsigned int len),
+                                         void *priv);
+extern void           midi_render_msg(midi_render_t *render, uint8_t *msg);
+extern void           midi_render_sysex(midi_render_t *render, uint8_t *data, unsigned int len);
+extern void           midi_render_poll(midi_render_t *render);
+extern void           midi_render_close(midi_render_t *render);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_MIDI_RENDER_H*/
@@ -114,6 +114,8 @@ extern void            mouse_set_sample_rate(double new_rate);
 extern void            mouse_update_sample_rate(void);
 extern void            mouse_set_buttons(int buttons);
 extern void            mouse_get_abs_coords(double *x_abs, double *y_abs);
+extern void            mouse_replay_take(double *x, double *y, int *z, int *w, int *b);
+extern void            mouse_replay_give(double x, double y, int z, int w, int b, double x_abs, double y_abs);
 extern void            mouse_process(void);
 extern void            mouse_set_poll_ex(void (*poll_ex)(void));
 extern void            mouse_set_poll(int (*f)(void *), void *);
@@ -52,12 +52,16 @@
 #define NET_TYPE_TAP      4 /* use a linux TAP device */
 #define NET_TYPE_NMSWITCH 5 /* use the network multicast switch provider */
 #define NET_TYPE_NRSWITCH 6 /* use the network remote switch provider */
+#define NET_TYPE_SHMSWITCH 7 /* use the shared memory switch */
 
 #define NET_MAX_FRAME  1518
-/* Queue size must be a power of 2 */
+/* Packets moved per batch by the card timer and the host drivers */
 #define NET_QUEUE_LEN      16
-#define NET_QUEUE_LEN_MASK (NET_QUEUE_LEN - 1)
-#define NET_QUEUE_COUNT    4
+/* Ring depth, configurable per card; rounded up to a power of 2 */
+#define NET_QUEUE_DEF_LEN  256
+#define NET_QUEUE_MIN_LEN  16
+#define NET_QUEUE_MAX_LEN  4096
+#define NET_QUEUE_COUNT    5
 #define NET_CARD_MAX       4
 #define NET_HOST_INTF_MAX  64
 
@@ -87,9 +91,15 @@ enum {
     NET_QUEUE_RX       = 0,
     NET_QUEUE_TX_VM    = 1,
     NET_QUEUE_TX_HOST  = 2,
-    NET_QUEUE_RX_ON_TX = 3
+    NET_QUEUE_RX_ON_TX = 3,
+    NET_QUEUE_RX_LOCAL = 4
 };
 
+/* Network switch framing */
+#define NET_SWITCH_FRAMING_PROTOBUF   0
+#define NET_SWITCH_FRAMING_COMPACT    1
+#define NET_SWITCH_FRAMING_COMPRESSED 2
+
 typedef struct netcard_conf_t {
     uint16_t device_num;
     int      net_type;
@@ -97,7 +107,11 @@ typedef struct netcard_conf_t {
     uint32_t link_state;
     uint8_t  switch_group;
     uint8_t  promisc_mode;
+    uint8_t  switch_framing;
     char     nrs_hostname[128];
+    uint16_t queue_len;
+    uint16_t rx_coalesce; /* RX interrupt coalescing window in us, 0 = off */
+    uint16_t stats;       /* Throughput report interval in emulated seconds, 0 = off */
 } netcard_conf_t;
 
 extern netcard_conf_t net_cards_conf[NET_CARD_MAX];
@@ -112,11 +126,8 @@ typedef struct netpkt {
     int      len;
 } netpkt_t;
 
-typedef struct netqueue_t {
-    netpkt_t packets[NET_QUEUE_LEN];
-    int      head;
-    int      tail;
-} netqueue_t;
+/* Single producer, single consumer packet ring, private to network.c. */
+typedef struct netqueue_t netqueue_t;
 
 typedef struct _netcard_t netcard_t;
 
@@ -133,6 +144,7 @@ extern const netdrv_t net_vde_drv;
 extern const netdrv_t net_tap_drv;
 extern const netdrv_t net_null_drv;
 extern const netdrv_t net_netswitch_drv;
+extern const netdrv_t net_shmswitch_drv;
 
 struct _netcard_t {
     const device_t *device;
@@ -140,13 +152,21 @@ struct _netcard_t {
     struct netdrv_t host_drv;
     NETRXCB         rx;
     NETSETLINKSTATE set_link_state;
-    netqueue_t      queues[NET_QUEUE_COUNT];
+    netqueue_t     *queues[NET_QUEUE_COUNT];
     netpkt_t        queued_pkt;
-    mutex_t        *tx_mutex;
-    mutex_t        *rx_mutex;
     pc_timer_t      timer;
     uint16_t        card_num;
     double          byte_period;
+    uint32_t        rx_coalesce;
+    double          rx_wait;
+    uint32_t        stats_interval;
+    double          stats_elapsed;
+    uint32_t        stats_host_ticks;
+    uint32_t        stats_rx_frames;
+    uint32_t        stats_tx_frames;
+    uint64_t        stats_rx_bytes;
+    uint64_t        stats_tx_bytes;
+    uint32_t        stats_dropped;
     uint32_t        led_timer;
     uint32_t        led_state;
     uint32_t        link_state;
@@ -177,6 +197,8 @@ extern network_devmap_t network_devmap;
 extern int              network_ndev;   // Number of pcap devices
 extern network_devmap_t network_devmap; // Bitmap of available network types
 extern netdev_t         network_devs[NET_HOST_INTF_MAX];
+extern uint64_t         network_rx_packets; // Frames delivered to all cards since startup
+extern uint64_t         network_tx_packets; // Frames sent by all cards since startup
 
 
 /* Function prototypes. */
@@ -187,6 +209,8 @@ extern void       network_close(void);
 extern void       network_reset(void);
 extern int        network_available(void);
 extern void       network_tx(netcard_t *card, uint8_t *, int);
+extern uint8_t   *network_tx_buffer(netcard_t *card);
+extern void       network_tx_commit(netcard_t *card, int len);
 
 extern int net_pcap_prepare(netdev_t *);
 extern int net_vde_prepare(void);
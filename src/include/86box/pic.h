@@ -18,6 +18,8 @@
 #ifndef EMU_PIC_H
 #define EMU_PIC_H
 
+struct snapshot_t;
+
 typedef struct pic_latch {
     uint8_t d;
     uint8_t e;
@@ -79,6 +81,8 @@ extern void pic_init(void);
 extern void pic_init_pcjr(void);
 extern void pic2_init(void);
 extern void pic_reset(void);
+extern void pic_save_state(struct snapshot_t *snap);
+extern int  pic_load_state(struct snapshot_t *snap);
 
 extern uint8_t pic_read_icw(uint8_t pic_id, uint8_t icw);
 extern uint8_t pic_read_ocw(uint8_t pic_id, uint8_t ocw);
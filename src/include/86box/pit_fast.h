@@ -56,6 +56,12 @@ typedef struct ctrf_t {
 
     uint64_t pit_const;
 
+    /* While lazy, the timer is off and the count is derived from tsc, the
+       counter would have reloaded at lazy_ts and every lazy_period after. */
+    int      lazy;
+    uint64_t lazy_ts;
+    uint64_t lazy_period;
+
     pc_timer_t timer;
 
     void (*load_func)(uint8_t new_m, int new_count);
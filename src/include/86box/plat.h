@@ -138,6 +138,7 @@ extern int fullscreen_ui_visible;
 extern FILE    *plat_fopen(const char *path, const char *mode);
 extern FILE    *plat_fopen64(const char *path, const char *mode);
 extern void     plat_remove(char *path);
+extern int      plat_rename(const char *from, const char *to);
 extern int      plat_getcwd(char *bufp, int max);
 extern int      plat_chdir(char *path);
 extern void     plat_tempfile(char *bufp, char *prefix, char *suffix);
@@ -153,8 +154,11 @@ extern int      plat_file_check(const char *path);
 extern int      plat_dir_create(char *path);
 extern void    *plat_mmap(size_t size, uint8_t executable);
 extern void     plat_munmap(void *ptr, size_t size);
+extern void    *plat_mmap_large(size_t size, uint8_t executable, const char *what);
+extern void     plat_munmap_large(void *ptr, size_t size);
 extern uint64_t plat_timer_read(void);
 extern uint32_t plat_get_ticks(void);
+extern uint64_t plat_get_nsecs(void);
 extern void     plat_delay_ms(uint32_t count);
 extern void     plat_pause(int p);
 extern void     plat_mouse_capture(int on);
@@ -166,6 +170,8 @@ extern int      plat_language_code(char *langcode);
 extern void     plat_language_code_r(int id, char *outbuf, int len);
 extern void     plat_get_cpu_string(char *outbuf, uint8_t len);
 extern void     plat_set_thread_name(void *thread, const char *name);
+extern int      plat_set_thread_affinity(const uint64_t *mask, int max_cpus);
+extern int      plat_set_thread_priority(int prio);
 extern void     plat_break(void);
 
 /* Resource management. */
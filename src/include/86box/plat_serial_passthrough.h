@@ -24,8 +24,8 @@
 extern "C" {
 #endif
 
-extern void plat_serpt_write(void *priv, uint8_t data);
-extern int  plat_serpt_read(void *priv, uint8_t *data);
+extern void plat_serpt_write(void *priv, const uint8_t *data, int len);
+extern int  plat_serpt_read(void *priv, uint8_t *data, int len);
 extern int  plat_serpt_open_device(void *priv);
 extern void plat_serpt_close(void *priv);
 extern void plat_serpt_set_params(void *priv);
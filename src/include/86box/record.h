@@ -0,0 +1,33 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the session recorder.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifndef EMU_RECORD_H
+#define EMU_RECORD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int  record_enabled;
+extern int  record_raw;
+extern char record_path[1024];
+
+extern void record_init(void);
+extern void record_close(void);
+extern void record_video(int x, int y, int w, int h, int dirty_y1, int dirty_y2, int monitor_index);
+extern void record_audio(const int32_t *buffer, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_RECORD_H*/
@@ -0,0 +1,55 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the input record and replay module.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifndef EMU_REPLAY_H
+#define EMU_REPLAY_H
+
+#define REPLAY_VERSION 1
+
+enum {
+    REPLAY_OFF = 0,
+    REPLAY_RECORD,
+    REPLAY_PLAY
+};
+
+enum {
+    REPLAY_MEDIA_FLOPPY = 0,
+    REPLAY_MEDIA_CDROM
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int  replay_mode;
+
+extern void replay_set_file(int mode, const char *fn);
+
+extern void replay_init(void);
+extern void replay_reset(void);
+extern void replay_close(void);
+
+/* Asynchronous inputs from the UI, queued for the emulation thread. */
+extern void replay_key(int down, uint16_t scan);
+extern int  replay_media(int type, int drive, const char *fn, int wp);
+
+/* Consumption points on the emulation thread. */
+extern int  replay_hard_reset(int pending);
+extern void replay_net_log(int card, const uint8_t *data, int len);
+extern int  replay_net_rx(int card, uint8_t *data, int *len, int max);
+extern int  replay_rtc_time(int64_t *now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_REPLAY_H*/
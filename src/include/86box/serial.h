@@ -137,6 +137,7 @@ extern void      serial_setup(serial_t *dev, uint16_t addr, uint8_t irq);
 extern void      serial_irq(serial_t *dev, uint8_t irq);
 extern void      serial_clear_fifo(serial_t *dev);
 extern void      serial_write_fifo(serial_t *dev, uint8_t dat);
+extern int       serial_write_fifo_buf(serial_t *dev, const uint8_t *buf, int len);
 extern void      serial_set_next_inst(int ni);
 extern void      serial_standalone_init(void);
 extern void      serial_set_clock_src(serial_t *dev, double clock_src);
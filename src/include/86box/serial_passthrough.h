@@ -40,6 +40,9 @@ enum serial_passthrough_mode {
 
 extern const char *serpt_mode_names[SERPT_MODES_MAX];
 
+/* Host side buffers, moved with one read or write call each */
+#define SERPT_BUF_LEN 256
+
 typedef struct serial_passthrough_s {
     enum serial_passthrough_mode mode;
     pc_timer_t                   host_to_serial_timer;
@@ -56,6 +59,11 @@ typedef struct serial_passthrough_s {
     char  host_serial_path[1024];              /* Path to TTY/host serial port on the host */
     char  named_pipe[1024];                    /* (Windows only) Name of the pipe. */
     void *backend_priv;                        /* Private platform backend data */
+    uint8_t rx_buf[SERPT_BUF_LEN];             /* Read from the host, not yet in the FIFO */
+    int     rx_pos;
+    int     rx_len;
+    uint8_t tx_buf[SERPT_BUF_LEN];             /* Written by the guest, not yet on the host */
+    int     tx_len;
 } serial_passthrough_t;
 
 extern bool           serial_passthrough_enabled[SERIAL_MAX - 1];
@@ -0,0 +1,54 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the machine snapshot (save state) module.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifndef EMU_SNAPSHOT_H
+#define EMU_SNAPSHOT_H
+
+#define SNAPSHOT_VERSION 2
+
+typedef struct snapshot_t snapshot_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Serialization primitives, for use by the save_state/load_state callbacks. */
+extern void snapshot_write(snapshot_t *snap, const void *data, size_t len);
+extern int  snapshot_read(snapshot_t *snap, void *data, size_t len);
+extern size_t snapshot_reserve(snapshot_t *snap, size_t len);
+#define snapshot_write_var(snap, var) snapshot_write(snap, &(var), sizeof(var))
+#define snapshot_read_var(snap, var)  snapshot_read(snap, &(var), sizeof(var))
+
+#ifdef _TIMER_H_
+extern void snapshot_write_timer(snapshot_t *snap, pc_timer_t *timer);
+extern int  snapshot_read_timer(snapshot_t *snap, pc_timer_t *timer);
+#endif
+
+/* Requests are carried out by pc_run() between two CPU frames. */
+extern void snapshot_request_save(const char *fn);
+extern void snapshot_request_load(const char *fn);
+extern void snapshot_process(void);
+
+extern int  snapshot_save(const char *fn);
+extern int  snapshot_load(const char *fn);
+
+extern int  snapshot_checkpoint_secs;
+
+extern void snapshot_checkpoint(void);
+extern void snapshot_idle(void);
+extern void snapshot_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SNAPSHOT_H*/
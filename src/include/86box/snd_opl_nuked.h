@@ -149,6 +149,7 @@ typedef struct {
     int8_t    is_48k;
 
     uint16_t port;
+    uint8_t  newm;
     uint8_t  status;
     uint8_t  timer_ctrl;
     uint16_t timer_count[2];
@@ -159,6 +160,10 @@ typedef struct {
     int     pos;
     int32_t buffer[MUSICBUFLEN * 2];
 
+    /* Synthesis thread, register writes are posted to it stamped with the
+       buffer position they happened at. */
+    device_worker_t *worker;
+
     int32_t *(*update)(void *priv);
 } nuked_drv_t;
 
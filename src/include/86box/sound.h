@@ -58,6 +58,9 @@ extern int wavetable_pos_global;
 
 extern int sound_card_current[SOUND_CARD_MAX];
 
+/* Times the host output ran dry and had to be restarted */
+extern uint32_t sound_underruns;
+
 extern void sound_add_handler(void (*get_buffer)(int32_t *buffer,
                                                  int len, void *priv),
                               void *priv);
@@ -93,6 +96,13 @@ extern void        sound_set_cd_volume(unsigned int vol_l, unsigned int vol_r);
 extern void sound_speed_changed(void);
 
 extern void sound_init(void);
+extern void sound_profile_dump(void);
+
+/* Mixing helpers, len is in samples (so twice the frames for stereo). */
+extern void sound_mix_add(int32_t *dst, const int32_t *src, int len);
+extern void sound_mix_add_int16(int32_t *dst, const int16_t *src, int len);
+extern void sound_mix_to_int16(int16_t *dst, const int32_t *src, int len);
+extern void sound_mix_to_float(float *dst, const int32_t *src, int len);
 extern void sound_reset(void);
 
 extern void sound_card_reset(void);
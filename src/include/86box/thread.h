@@ -61,6 +61,39 @@ extern int      thread_test_mutex(mutex_t *arg);
 extern int      thread_wait_mutex(mutex_t *arg);
 extern int      thread_release_mutex(mutex_t *mutex);
 
+/* Host placement of the emulator threads, see thread_policy.c. */
+enum {
+    THREAD_ROLE_NONE = 0,
+    THREAD_ROLE_CPU,    /* the emulation thread */
+    THREAD_ROLE_RENDER, /* blitters and video FIFO/render threads */
+    THREAD_ROLE_AUDIO,  /* sound and MIDI rendering threads */
+    THREAD_ROLE_MAX
+};
+
+enum {
+    THREAD_PRIO_DEFAULT = 0, /* leave the host default alone */
+    THREAD_PRIO_LOW,
+    THREAD_PRIO_NORMAL,
+    THREAD_PRIO_HIGH,
+    THREAD_PRIO_REALTIME
+};
+
+#define THREAD_MAX_CPUS 256
+
+typedef struct thread_policy_t {
+    char affinity[128]; /* CPU list such as "0-3,8", or "node1"; empty = any */
+    int  priority;
+} thread_policy_t;
+
+extern thread_policy_t thread_policy[THREAD_ROLE_MAX];
+
+#define thread_create_role(thread_func, param, role) thread_create_named_role((thread_func), (param), #thread_func, (role))
+extern thread_t   *thread_create_named_role(void (*thread_func)(void *param), void *param, const char *name, int role);
+extern void        thread_set_role(int role);
+extern const char *thread_role_name(int role);
+extern int         thread_priority_from_name(const char *name);
+extern const char *thread_priority_name(int prio);
+
 #ifdef __cplusplus
 }
 #endif
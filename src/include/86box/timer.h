@@ -7,6 +7,7 @@ extern uint64_t tsc;
 #define MAX_USEC64    1000000ULL
 #define MAX_USEC      1000000.0
 
+#define TIMER_BATCHED 8
 #define TIMER_PROCESS 4
 #define TIMER_SPLIT   2
 #define TIMER_ENABLED 1
@@ -50,8 +51,12 @@ typedef struct pc_timer_t {
     void (*callback)(void *priv);
     void *priv;
 
-    struct pc_timer_t *prev;
-    struct pc_timer_t *next;
+    /* Batched timers: invoked once with the number of elapsed periods. */
+    void    (*batch_callback)(void *priv, uint32_t periods);
+    uint64_t batch_period; /* 32:32 */
+
+    uint32_t heap_pos; /* 1-based position in the timer heap, 0 if not queued. */
+    uint32_t seq;      /* Enable sequence number, used to order equal timestamps. */
 } pc_timer_t;
 
 #ifdef __cplusplus
@@ -74,10 +79,29 @@ extern void timer_process(void);
 extern void timer_close(void);
 extern void timer_init(void);
 
+/*Callback profiling, enabled from the command line*/
+extern int  timer_profile;
+extern void timer_profile_dump(void);
+
+/*Callbacks run since startup*/
+extern uint64_t timer_callback_count;
+
 /*Add new timer. If start_timer is set, timer will be enabled with a zero
   timestamp - this is useful for permanently enabled timers*/
 extern void timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start_timer);
 
+/*Add new batched timer. A batched timer is automatically re-armed every period
+  (specified in 32:32 format) and, whenever it is processed, its callback is
+  invoked once with the number of periods that have elapsed since it was last
+  run instead of once per period. This is meant for high frequency timers such
+  as audio sample clocks, where the per-period work is trivial and the
+  callback dispatch dominates. If start_timer is set, the timer is enabled with
+  a zero delay, like timer_add() does.*/
+extern void timer_add_batched(pc_timer_t *timer, void (*callback)(void *priv, uint32_t periods),
+                              void *priv, uint64_t period, int start_timer);
+/*Change the period of a batched timer, taking effect from the next period*/
+extern void timer_set_batch_period(pc_timer_t *timer, uint64_t period);
+
 /*1us in 32:32 format*/
 extern uint64_t TIMER_USEC;
 
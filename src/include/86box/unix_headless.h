@@ -0,0 +1,7 @@
+#ifndef _UNIX_HEADLESS_H
+#define _UNIX_HEADLESS_H
+
+extern int  headless_init(void);
+extern void headless_close(void);
+
+#endif /*_UNIX_HEADLESS_H*/
@@ -6,7 +6,7 @@
  *
  *          This file is part of the 86Box distribution.
  *
- *          Definitions for the Distributed DMA emulation.
+ *          Definitions for the Universal Serial Bus emulation.
  *
  * Authors: Miran Grca, <mgrca8@gmail.com>
  *
@@ -20,6 +20,9 @@
 extern "C" {
 #endif
 
+/* Frames run per timer period while no transfer descriptor is active. */
+#define USB_IDLE_FRAMES 32
+
 typedef struct usb_t {
     uint8_t       uhci_io[32];
     uint8_t       ohci_mmio[4096];
@@ -28,6 +31,21 @@ typedef struct usb_t {
     int           ohci_enable;
     uint32_t      ohci_mem_base;
     mem_mapping_t ohci_mmio_mapping;
+
+    uint8_t       pci_slot;
+    uint8_t       irq_pin;
+    uint8_t       irq_state;
+    uint8_t       uhci_irq;
+    uint8_t       ohci_irq;
+    uint8_t       ohci_smi;
+    uint8_t       ohci_done_delay;
+
+    /* Frames covered by the pending period of each frame timer. */
+    uint32_t      uhci_batch;
+    uint32_t      ohci_batch;
+
+    pc_timer_t    uhci_frame_timer;
+    pc_timer_t    ohci_frame_timer;
 } usb_t;
 
 /* Global variables. */
@@ -36,6 +54,7 @@ extern const device_t usb_device;
 /* Functions. */
 extern void uhci_update_io_mapping(usb_t *dev, uint8_t base_l, uint8_t base_h, int enable);
 extern void ohci_update_mem_mapping(usb_t *dev, uint8_t base1, uint8_t base2, uint8_t base3, int enable);
+extern void usb_set_slot(usb_t *dev, uint8_t slot, uint8_t irq_pin);
 
 #ifdef __cplusplus
 }
@@ -114,6 +114,11 @@ typedef struct svga_t {
     int lastline;
     int firstline_draw;
     int lastline_draw;
+    int blit_wx;
+    int blit_wy;
+    int blit_skipped;
+    int blit_dirty_y1;
+    int blit_dirty_y2;
     int displine;
     int fullchange;
     int left_overscan;
@@ -171,6 +176,7 @@ typedef struct svga_t {
     uint32_t  banked_mask;
     uint32_t  cursoraddr;
     uint32_t  overscan_color;
+    uint32_t  blit_overscan_color;
     uint32_t *map8;
     uint32_t  pallook[512];
 
@@ -314,6 +320,16 @@ typedef struct svga_t {
     /* Enable LUT mapping of >= 24 bpp modes. */
     int lut_map;
 
+    /* Bumped whenever pallook[] or anything else conv_16to32() depends on
+       changes, so the cached 15/16 bpp conversion table below is only
+       rebuilt once per change rather than per pixel or per DAC write. */
+    uint32_t pal_gen;
+    uint32_t *conv_lut;
+    uint32_t conv_lut_gen;
+    uint8_t  conv_lut_bpp;
+    int      conv_lut_lut_map;
+    uint32_t (*conv_lut_func)(struct svga_t *svga, uint16_t color, uint8_t bpp);
+
     /* Override the horizontal blanking stuff. */
     int hoverride;
 
@@ -416,6 +432,7 @@ enum {
 };
 
 uint32_t svga_lookup_lut_ram(svga_t* svga, uint32_t val);
+const uint32_t *svga_conv_16to32_lut(svga_t *svga, uint8_t bpp);
 
 /* We need a way to add a device with a pointer to a parent device so it can attach itself to it, and
    possibly also a second ATi 68860 RAM DAC type that auto-sets SVGA render on RAM DAC render change. */
@@ -494,6 +511,7 @@ extern uint8_t tkd8001_ramdac_in(uint16_t addr, void *priv, svga_t *svga);
 
 extern void     tvp3026_ramdac_out(uint16_t addr, int rs2, int rs3, uint8_t val, void *priv, svga_t *svga);
 extern uint8_t  tvp3026_ramdac_in(uint16_t addr, int rs2, int rs3, void *priv, svga_t *svga);
+extern uint32_t svga_conv_16to32(svga_t *svga, uint16_t color, uint8_t bpp);
 extern uint32_t tvp3026_conv_16to32(svga_t* svga, uint16_t color, uint8_t bpp);
 extern void     tvp3026_recalctimings(void *priv, svga_t *svga);
 extern void     tvp3026_hwcursor_draw(svga_t *svga, int displine);
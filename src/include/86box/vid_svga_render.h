@@ -32,6 +32,7 @@ extern int scrollcache;
 
 extern uint8_t edatlookup[4][4];
 extern uint8_t egaremap2bpp[256];
+extern uint32_t egaplanarlookup[4][256];
 
 extern void svga_recalc_remap_func(svga_t *svga);
 
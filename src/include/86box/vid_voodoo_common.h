@@ -86,6 +86,9 @@ enum {
     FIFO_WRITEL_2DREG = (0x05 << 24)
 };
 
+/* Render threads take interleaved scanlines, so the count must be a power of 2. */
+#define VOODOO_MAX_RENDER_THREADS 8
+
 #define PARAM_SIZE       1024
 #define PARAM_MASK       (PARAM_SIZE - 1)
 #define PARAM_ENTRY_SIZE (1 << 31)
@@ -224,7 +227,7 @@ typedef struct texture_t {
     uint32_t   base;
     uint32_t   tLOD;
     ATOMIC_INT refcount;
-    ATOMIC_INT refcount_r[4];
+    ATOMIC_INT refcount_r[VOODOO_MAX_RENDER_THREADS];
     int        is16;
     uint32_t   palette_checksum;
     uint32_t   addr_start[4];
@@ -352,25 +355,25 @@ typedef struct voodoo_t {
     int    ncc_dirty[2];
 
     thread_t *fifo_thread;
-    thread_t *render_thread[4];
+    thread_t *render_thread[VOODOO_MAX_RENDER_THREADS];
     event_t  *wake_fifo_thread;
     event_t  *wake_main_thread;
     event_t  *fifo_not_full_event;
-    event_t  *render_not_full_event[4];
-    event_t  *wake_render_thread[4];
+    event_t  *render_not_full_event[VOODOO_MAX_RENDER_THREADS];
+    event_t  *wake_render_thread[VOODOO_MAX_RENDER_THREADS];
 
     int voodoo_busy;
-    int render_voodoo_busy[4];
+    int render_voodoo_busy[VOODOO_MAX_RENDER_THREADS];
 
     int render_threads;
     int odd_even_mask;
 
-    int pixel_count[4];
-    int texel_count[4];
+    int pixel_count[VOODOO_MAX_RENDER_THREADS];
+    int texel_count[VOODOO_MAX_RENDER_THREADS];
     int tri_count;
     int frame_count;
-    int pixel_count_old[4];
-    int texel_count_old[4];
+    int pixel_count_old[VOODOO_MAX_RENDER_THREADS];
+    int texel_count_old[VOODOO_MAX_RENDER_THREADS];
     int wr_count;
     int rd_count;
     int tex_count;
@@ -401,7 +404,7 @@ typedef struct voodoo_t {
     ATOMIC_INT   cmd_written_fifo_2;
 
     voodoo_params_t params_buffer[PARAM_SIZE];
-    ATOMIC_INT      params_read_idx[4];
+    ATOMIC_INT      params_read_idx[VOODOO_MAX_RENDER_THREADS];
     ATOMIC_INT      params_write_idx;
 
     uint32_t   cmdfifo_base;
@@ -649,14 +652,14 @@ typedef struct voodoo_t {
     uint16_t purpleline[256][3];
 
     texture_t texture_cache[2][TEX_CACHE_MAX];
-    uint8_t   texture_present[2][16384];
+    uint16_t  texture_present[2][16384];
     int       texture_last_removed;
 
     uint32_t palette_checksum[2];
     int      palette_dirty[2];
 
     uint64_t time;
-    int      render_time[4];
+    int      render_time[VOODOO_MAX_RENDER_THREADS];
 
     int      force_blit_count;
     int      can_blit;
@@ -665,10 +668,13 @@ typedef struct voodoo_t {
     int   use_recompiler;
     void *codegen_data;
 
+    FILE    *capture_fp;
+    uint64_t capture_records;
+
     struct voodoo_set_t *set;
 
     uint8_t fifo_thread_run;
-    uint8_t render_thread_run[4];
+    uint8_t render_thread_run[VOODOO_MAX_RENDER_THREADS];
 
     uint8_t *vram;
     uint8_t *changedvram;
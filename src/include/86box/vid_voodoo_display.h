@@ -20,6 +20,7 @@ void voodoo_update_ncc(voodoo_t *voodoo, int tmu);
 void voodoo_pixelclock_update(voodoo_t *voodoo);
 void voodoo_generate_filter_v1(voodoo_t *voodoo);
 void voodoo_generate_filter_v2(voodoo_t *voodoo);
+void voodoo_generate_filter(void *priv);
 void voodoo_threshold_check(voodoo_t *voodoo);
 void voodoo_callback(void *priv);
 
@@ -138,6 +138,7 @@ typedef struct monitor_t {
     int                      mon_vid_type;
     atomic_bool              mon_interlace;
     atomic_bool              mon_composite;
+    atomic_bool              mon_visible; /* Whether a window is showing this monitor. */
     struct blit_data_struct *mon_blit_data_ptr;
 } monitor_t;
 
@@ -221,6 +222,8 @@ extern int          herc_blend;
 extern int          vid_cga_contrast;
 extern int          video_grayscale;
 extern int          video_graytype;
+extern int          voodoo_capture;
+extern char         voodoo_capture_path[1024];
 
 extern double cpuclock;
 extern int    emu_fps;
@@ -231,8 +234,15 @@ extern int    xga_active;
 
 /* Function handler pointers. */
 extern void (*video_recalctimings)(void);
+
+/* video_screenshot_format values. */
+#define SCREENSHOT_FORMAT_PNG 0
+#define SCREENSHOT_FORMAT_BMP 1
+
 extern void video_screenshot_monitor(uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index);
 extern void video_screenshot(uint32_t *buf, int start_x, int start_y, int row_len);
+extern void video_screenshot_flush(void);
+extern void (*video_screenshot_callback)(const char *fn, int monitor_index, int ok);
 
 #ifdef _WIN32
 extern void * (__cdecl *video_copy)(void *_Dst, const void *_Src, size_t _Size);
@@ -265,6 +275,11 @@ extern void video_blit_memtoscreen_8(int x, int y, int w, int h);
 extern void video_blend_monitor(int x, int y, int monitor_index);
 extern void video_process_8_monitor(int x, int y, int monitor_index);
 extern void video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index);
+extern void video_monitor_set_visible(int monitor_index, int visible);
+extern int  video_monitor_consumed(int monitor_index);
+extern void video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, int dirty_y1, int dirty_y2, int monitor_index);
+extern void video_blit_get_dirty_monitor(int monitor_index, int *dirty_y1, int *dirty_y2);
+extern void video_get_blit_stats_monitor(int monitor_index, uint32_t *dropped, uint32_t *blocked);
 extern void video_blit_complete_monitor(int monitor_index);
 extern void video_wait_for_blit_monitor(int monitor_index);
 extern void video_wait_for_buffer_monitor(int monitor_index);
@@ -296,6 +311,14 @@ extern int get_actual_size_y(void);
 
 extern uint32_t video_color_transform(uint32_t color);
 
+/* Byte orders of 4:2:2 pixel pairs for video_yuv422_to_rgb(). */
+enum {
+    VIDEO_YUV422_YCRYCB = 0, /* Y0 Cr Y1 Cb */
+    VIDEO_YUV422_CRYCBY      /* Cr Y0 Cb Y1 */
+};
+
+extern void video_yuv422_to_rgb(uint32_t *dst, const uint8_t *src, int pairs, int order);
+
 #define video_inform(type, video_timings_ptr) video_inform_monitor(type, video_timings_ptr, monitor_index_global)
 #define video_get_type()                      video_get_type_monitor(0)
 #define video_blend(x, y)                     video_blend_monitor(x, y, monitor_index_global)
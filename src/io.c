@@ -23,12 +23,14 @@
 #include <wchar.h>
 #define HAVE_STDARG_H
 #include <86box/86box.h>
+#include <86box/device_prof.h>
 #include <86box/io.h>
 #include <86box/timer.h>
 #include "cpu.h"
 #include "x86.h"
 #include <86box/m_amstrad.h>
 #include <86box/pci.h>
+#include <86box/plat.h>
 
 #define NPORTS 65536 /* PC/AT supports 64K ports */
 
@@ -54,10 +56,26 @@ typedef struct {
     void     *priv;
 } io_trap_t;
 
+/* Handlers on a port that a wider access has to fall back to. */
+#define IO_SPLIT_INW    0x01 /* inb but no inw */
+#define IO_SPLIT_INL_W  0x02 /* inw but no inl */
+#define IO_SPLIT_INL_B  0x04 /* inb but neither inw nor inl */
+#define IO_SPLIT_OUTW   0x10
+#define IO_SPLIT_OUTL_W 0x20
+#define IO_SPLIT_OUTL_B 0x40
+
 int   initialized = 0;
 io_t *io[NPORTS];
 io_t *io_last[NPORTS];
 
+/* Flattened view of the handler chains, rebuilt whenever a port's chain
+   changes: the handler if it is the only one on the port, and the
+   IO_SPLIT_* summary of the chain. An access to a port with a single
+   handler, which no narrower handlers on the ports it also covers have to
+   see, is a single direct call. */
+static io_t   *io_single[NPORTS];
+static uint8_t io_split[NPORTS];
+
 #ifdef ENABLE_IO_LOG
 int io_do_log = ENABLE_IO_LOG;
 
@@ -76,6 +94,75 @@ io_log(const char *fmt, ...)
 #    define io_log(fmt, ...)
 #endif
 
+/* Handler calls, timed per device with --devprof. The handler may remove itself, so keep priv. */
+#define IO_CALL_IN(type, name)                                       \
+    static __inline type                                             \
+    io_call_##name(const io_t *p, uint16_t port)                     \
+    {                                                                \
+        void    *priv = p->priv;                                     \
+        uint64_t start;                                              \
+        type     ret;                                                \
+                                                                     \
+        if (!device_profile)                                         \
+            return p->name(port, priv);                              \
+                                                                     \
+        start = plat_get_nsecs();                                    \
+        ret   = p->name(port, priv);                                 \
+        device_prof_add(priv, DEVICE_PROF_IO, start);                \
+        return ret;                                                  \
+    }
+
+#define IO_CALL_OUT(type, name)                                      \
+    static __inline void                                             \
+    io_call_##name(const io_t *p, uint16_t port, type val)           \
+    {                                                                \
+        void    *priv = p->priv;                                     \
+        uint64_t start;                                              \
+                                                                     \
+        if (!device_profile) {                                       \
+            p->name(port, val, priv);                                \
+            return;                                                  \
+        }                                                            \
+                                                                     \
+        start = plat_get_nsecs();                                    \
+        p->name(port, val, priv);                                    \
+        device_prof_add(priv, DEVICE_PROF_IO, start);                \
+    }
+
+IO_CALL_IN(uint8_t, inb)
+IO_CALL_IN(uint16_t, inw)
+IO_CALL_IN(uint32_t, inl)
+IO_CALL_OUT(uint8_t, outb)
+IO_CALL_OUT(uint16_t, outw)
+IO_CALL_OUT(uint32_t, outl)
+
+static void
+io_port_recalc(uint16_t port)
+{
+    const io_t *p     = io[port];
+    uint8_t     split = 0;
+
+    io_single[port] = (p && !p->next) ? io[port] : NULL;
+
+    while (p) {
+        if (p->inb && !p->inw)
+            split |= IO_SPLIT_INW;
+        if (p->inw && !p->inl)
+            split |= IO_SPLIT_INL_W;
+        if (p->inb && !p->inw && !p->inl)
+            split |= IO_SPLIT_INL_B;
+        if (p->outb && !p->outw)
+            split |= IO_SPLIT_OUTW;
+        if (p->outw && !p->outl)
+            split |= IO_SPLIT_OUTL_W;
+        if (p->outb && !p->outw && !p->outl)
+            split |= IO_SPLIT_OUTL_B;
+        p = p->next;
+    }
+
+    io_split[port] = split;
+}
+
 void
 io_init(void)
 {
@@ -104,6 +191,8 @@ io_init(void)
 
         /* io[c] should be NULL. */
         io[c] = io_last[c] = NULL;
+        io_single[c]       = NULL;
+        io_split[c]        = 0;
     }
 }
 
@@ -145,6 +234,8 @@ io_sethandler_common(uint16_t base, int size,
 
         io_last[base + c] = q;
 
+        io_port_recalc(base + c);
+
         q = NULL;
     }
 }
@@ -183,6 +274,7 @@ io_removehandler_common(uint16_t base, int size,
             }
             p = q;
         }
+        io_port_recalc(base + c);
     }
 }
 
@@ -361,12 +453,20 @@ inb(uint16_t port)
 #ifdef ENABLE_IO_LOG
         qfound = 1;
 #endif
+    } else if ((p = io_single[port]) != NULL) {
+        if (p->inb) {
+            ret   = io_call_inb(p, port);
+            found = 1;
+#ifdef ENABLE_IO_LOG
+            qfound = 1;
+#endif
+        }
     } else {
         p = io[port];
         while (p) {
             q = p->next;
             if (p->inb) {
-                ret &= p->inb(port, p->priv);
+                ret &= io_call_inb(p, port);
                 found |= 1;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -428,12 +528,20 @@ outb(uint16_t port, uint8_t val)
 #ifdef ENABLE_IO_LOG
         qfound = 1;
 #endif
+    } else if ((p = io_single[port]) != NULL) {
+        if (p->outb) {
+            io_call_outb(p, port, val);
+            found = 1;
+#ifdef ENABLE_IO_LOG
+            qfound = 1;
+#endif
+        }
     } else {
         p = io[port];
         while (p) {
             q = p->next;
             if (p->outb) {
-                p->outb(port, val, p->priv);
+                io_call_outb(p, port, val);
                 found |= 1;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -485,13 +593,20 @@ inw(uint16_t port)
         found = 2;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (((p = io_single[port]) != NULL) && p->inw &&
+               !(io_split[(port + 1) & 0xffff] & IO_SPLIT_INW)) {
+        ret   = io_call_inw(p, port);
+        found = 2;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
         while (p) {
             q = p->next;
             if (p->inw) {
-                ret &= p->inw(port, p->priv);
+                ret &= io_call_inw(p, port);
                 found |= 2;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -507,7 +622,7 @@ inw(uint16_t port)
             while (p) {
                 q = p->next;
                 if (p->inb && !p->inw) {
-                    ret8[i] &= p->inb(port + i, p->priv);
+                    ret8[i] &= io_call_inb(p, port + i);
                     found |= 1;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -564,13 +679,20 @@ outw(uint16_t port, uint16_t val)
         found = 2;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (((p = io_single[port]) != NULL) && p->outw &&
+               !(io_split[(port + 1) & 0xffff] & IO_SPLIT_OUTW)) {
+        io_call_outw(p, port, val);
+        found = 2;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
         while (p) {
             q = p->next;
             if (p->outw) {
-                p->outw(port, val, p->priv);
+                io_call_outw(p, port, val);
                 found |= 2;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -584,7 +706,7 @@ outw(uint16_t port, uint16_t val)
             while (p) {
                 q = p->next;
                 if (p->outb && !p->outw) {
-                    p->outb(port + i, val >> (i << 3), p->priv);
+                    io_call_outb(p, port + i, val >> (i << 3));
                     found |= 1;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -638,13 +760,22 @@ inl(uint16_t port)
         found = 4;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (((p = io_single[port]) != NULL) && p->inl &&
+               !(io_split[(port + 1) & 0xffff] & IO_SPLIT_INL_B) &&
+               !(io_split[(port + 2) & 0xffff] & (IO_SPLIT_INL_W | IO_SPLIT_INL_B)) &&
+               !(io_split[(port + 3) & 0xffff] & IO_SPLIT_INL_B)) {
+        ret   = io_call_inl(p, port);
+        found = 4;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
         while (p) {
             q = p->next;
             if (p->inl) {
-                ret &= p->inl(port, p->priv);
+                ret &= io_call_inl(p, port);
                 found |= 4;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -659,7 +790,7 @@ inl(uint16_t port)
         while (p) {
             q = p->next;
             if (p->inw && !p->inl) {
-                ret16[0] &= p->inw(port, p->priv);
+                ret16[0] &= io_call_inw(p, port);
                 found |= 2;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -672,7 +803,7 @@ inl(uint16_t port)
         while (p) {
             q = p->next;
             if (p->inw && !p->inl) {
-                ret16[1] &= p->inw(port + 2, p->priv);
+                ret16[1] &= io_call_inw(p, port + 2);
                 found |= 2;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -691,7 +822,7 @@ inl(uint16_t port)
             while (p) {
                 q = p->next;
                 if (p->inb && !p->inw && !p->inl) {
-                    ret8[i] &= p->inb(port + i, p->priv);
+                    ret8[i] &= io_call_inb(p, port + i);
                     found |= 1;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -749,6 +880,15 @@ outl(uint16_t port, uint32_t val)
         found = 4;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (((p = io_single[port]) != NULL) && p->outl &&
+               !(io_split[(port + 1) & 0xffff] & IO_SPLIT_OUTL_B) &&
+               !(io_split[(port + 2) & 0xffff] & (IO_SPLIT_OUTL_W | IO_SPLIT_OUTL_B)) &&
+               !(io_split[(port + 3) & 0xffff] & IO_SPLIT_OUTL_B)) {
+        io_call_outl(p, port, val);
+        found = 4;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -756,7 +896,7 @@ outl(uint16_t port, uint32_t val)
             while (p) {
                 q = p->next;
                 if (p->outl) {
-                    p->outl(port, val, p->priv);
+                    io_call_outl(p, port, val);
                     found |= 4;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -771,7 +911,7 @@ outl(uint16_t port, uint32_t val)
             while (p) {
                 q = p->next;
                 if (p->outw && !p->outl) {
-                    p->outw(port + i, val >> (i << 3), p->priv);
+                    io_call_outw(p, port + i, val >> (i << 3));
                     found |= 2;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -786,7 +926,7 @@ outl(uint16_t port, uint32_t val)
             while (p) {
                 q = p->next;
                 if (p->outb && !p->outw && !p->outl) {
-                    p->outb(port + i, val >> (i << 3), p->priv);
+                    io_call_outb(p, port + i, val >> (i << 3));
                     found |= 1;
 #ifdef ENABLE_IO_LOG
                     qfound++;
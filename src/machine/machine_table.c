@@ -29,6 +29,7 @@
 #include <86box/timer.h>
 #include <86box/fdd.h>
 #include <86box/fdc.h>
+#include <86box/hash.h>
 #include <86box/keyboard.h>
 #include <86box/sio.h>
 #include <86box/sound.h>
@@ -20650,10 +20651,52 @@ machine_get_chipset(int m)
     return (machines[m].chipset);
 }
 
+/* Machines by internal name, open addressing, must be a power of 2. */
+#define MACHINE_NAME_INDEX_SIZE 2048
+
+static uint16_t machine_name_index[MACHINE_NAME_INDEX_SIZE]; /* machine + 1, 0 = free */
+static int      machine_name_index_built = 0;
+
+/* Built on first use; keeps the table order, so a duplicate name finds the first machine. */
+static void
+machine_name_index_build(void)
+{
+    uint32_t hash;
+
+    if ((machine_count() * 2) > MACHINE_NAME_INDEX_SIZE) {
+        machine_name_index_built = -1;
+        return;
+    }
+
+    for (int c = 0; machines[c].init != NULL; c++) {
+        hash = name_hash(machines[c].internal_name, SIZE_MAX);
+        while (machine_name_index[hash & (MACHINE_NAME_INDEX_SIZE - 1)])
+            hash++;
+        machine_name_index[hash & (MACHINE_NAME_INDEX_SIZE - 1)] = c + 1;
+    }
+
+    machine_name_index_built = 1;
+}
+
 int
 machine_get_machine_from_internal_name(const char *s)
 {
-    int c = 0;
+    uint32_t hash;
+    int      c = 0;
+
+    if (!machine_name_index_built)
+        machine_name_index_build();
+
+    if (machine_name_index_built > 0) {
+        hash = name_hash(s, SIZE_MAX);
+        while ((c = machine_name_index[hash & (MACHINE_NAME_INDEX_SIZE - 1)])) {
+            if (!strcmp(machines[c - 1].internal_name, s))
+                return c - 1;
+            hash++;
+        }
+
+        return 0;
+    }
 
     while (machines[c].init != NULL) {
         if (!strcmp(machines[c].internal_name, s))
@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <wchar.h>
 #include <86box/86box.h>
+#include "cpu.h"
 #include <86box/device.h>
 #include <86box/mem.h>
 #include <86box/machine.h>
@@ -61,17 +62,38 @@ typedef struct flash_t {
     uint8_t pad0;
     uint8_t *array;
 
+    int dirty;
+    int lookups;
+
     mem_mapping_t mapping;
     mem_mapping_t mapping_h[2];
 } flash_t;
 
 static char flash_path[1024];
 
+static int
+flash_reads_array(const flash_t *dev)
+{
+    return (dev->command == CMD_ERASE_VERIFY) || (dev->command == CMD_PROGRAM_VERIFY) ||
+           (dev->command == CMD_RESET) || (dev->command == CMD_SET_READ);
+}
+
+/* While the array is being read, it is plain memory, so let the CPU read the
+   page straight from it until the command changes. Writes still come here. */
+static void
+flash_add_readlookup(flash_t *dev, uint32_t addr)
+{
+    if (cpu_use_exec && flash_reads_array(dev)) {
+        mem_add_host_readlookup(mem_logical_addr, &dev->array[addr & ~0xfff]);
+        dev->lookups = 1;
+    }
+}
+
 static uint8_t
 flash_read(uint32_t addr, void *priv)
 {
-    const flash_t *dev = (flash_t *) priv;
-    uint8_t        ret = 0xff;
+    flash_t *dev = (flash_t *) priv;
+    uint8_t  ret = 0xff;
 
     addr &= biosmask;
 
@@ -81,6 +103,7 @@ flash_read(uint32_t addr, void *priv)
         case CMD_RESET:
         case CMD_SET_READ:
             ret = dev->array[addr];
+            flash_add_readlookup(dev, addr);
             break;
 
         case CMD_READ_AUTO_SELECT:
@@ -118,6 +141,8 @@ flash_readw(uint32_t addr, void *priv)
 
     q = (uint16_t *) &(dev->array[addr]);
 
+    flash_add_readlookup(dev, addr);
+
     return *q;
 }
 
@@ -131,6 +156,8 @@ flash_readl(uint32_t addr, void *priv)
 
     q = (uint32_t *) &(dev->array[addr]);
 
+    flash_add_readlookup(dev, addr);
+
     return *q;
 }
 
@@ -143,16 +170,23 @@ flash_write(uint32_t addr, uint8_t val, void *priv)
 
     switch (dev->command) {
         case CMD_ERASE:
-            if (val == CMD_ERASE_CONFIRM)
+            if (val == CMD_ERASE_CONFIRM) {
                 memset(dev->array, 0xff, biosmask + 1);
+                dev->dirty = 1;
+            }
             break;
 
         case CMD_PROGRAM:
             dev->array[addr] = val;
+            dev->dirty       = 1;
             break;
 
         default:
             dev->command = val;
+            if (!flash_reads_array(dev) && dev->lookups) {
+                flushmmucache_nopc();
+                dev->lookups = 0;
+            }
             break;
     }
 }
@@ -222,7 +256,8 @@ catalyst_flash_init(UNUSED(const device_t *info))
     if (fp) {
         (void) !fread(dev->array, 0x20000, 1, fp);
         fclose(fp);
-    }
+    } else
+        dev->dirty = 1; /* It is by definition dirty on creation. */
 
     return dev;
 }
@@ -233,9 +268,14 @@ catalyst_flash_close(void *priv)
     FILE    *fp;
     flash_t *dev = (flash_t *) priv;
 
-    fp = nvr_fopen(flash_path, "wb");
-    fwrite(dev->array, 0x20000, 1, fp);
-    fclose(fp);
+    /* Only rewrite the file if the guest did program or erase the flash. */
+    if (dev->dirty) {
+        fp = nvr_fopen(flash_path, "wb");
+        if (fp) {
+            fwrite(dev->array, 0x20000, 1, fp);
+            fclose(fp);
+        }
+    }
 
     free(dev->array);
     dev->array = NULL;
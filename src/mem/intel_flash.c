@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <wchar.h>
 #include <86box/86box.h>
+#include "cpu.h"
 #include <86box/device.h>
 #include <86box/mem.h>
 #include <86box/machine.h>
@@ -62,6 +63,9 @@ typedef struct flash_t {
     uint8_t  flags;
     uint8_t *array;
 
+    int dirty;
+    int lookups;
+
     uint16_t flash_id;
     uint16_t pad16;
 
@@ -76,11 +80,31 @@ typedef struct flash_t {
 
 static char flash_path[1024];
 
+/* In read array mode the array is plain memory, so let the CPU read the page
+   straight from it until the command changes. Writes still come here. */
+static void
+flash_add_readlookup(flash_t *dev, uint32_t addr)
+{
+    if (cpu_use_exec && (dev->command == CMD_READ_ARRAY)) {
+        mem_add_host_readlookup(mem_logical_addr, &dev->array[addr & ~0xfff]);
+        dev->lookups = 1;
+    }
+}
+
+static void
+flash_command_changed(flash_t *dev, uint8_t old_command)
+{
+    if ((old_command == CMD_READ_ARRAY) && (dev->command != CMD_READ_ARRAY) && dev->lookups) {
+        flushmmucache_nopc();
+        dev->lookups = 0;
+    }
+}
+
 static uint8_t
 flash_read(uint32_t addr, void *priv)
 {
-    const flash_t *dev = (flash_t *) priv;
-    uint8_t        ret = 0xff;
+    flash_t *dev = (flash_t *) priv;
+    uint8_t  ret = 0xff;
 
     if (dev->flags & FLAG_INV_A16)
         addr ^= 0x10000;
@@ -90,6 +114,7 @@ flash_read(uint32_t addr, void *priv)
         default:
         case CMD_READ_ARRAY:
             ret = dev->array[addr];
+            flash_add_readlookup(dev, addr);
             break;
 
         case CMD_IID:
@@ -124,6 +149,8 @@ flash_readw(uint32_t addr, void *priv)
     q   = (uint16_t *) &(dev->array[addr]);
     ret = *q;
 
+    flash_add_readlookup(dev, addr);
+
     if (dev->flags & FLAG_WORD)
         switch (dev->command) {
             default:
@@ -157,6 +184,8 @@ flash_readl(uint32_t addr, void *priv)
 
     q = (uint32_t *) &(dev->array[addr]);
 
+    flash_add_readlookup(dev, addr);
+
     return *q;
 }
 
@@ -164,6 +193,7 @@ static void
 flash_write(uint32_t addr, uint8_t val, void *priv)
 {
     flash_t *dev = (flash_t *) priv;
+    uint8_t  old_command = dev->command;
     uint32_t bb_mask = biosmask & 0xffffe000;
     if (biosmask == 0x7ffff)
         bb_mask &= 0xffff8000;
@@ -178,8 +208,10 @@ flash_write(uint32_t addr, uint8_t val, void *priv)
         case CMD_ERASE_SETUP:
             if (val == CMD_ERASE_CONFIRM) {
                 for (uint8_t i = 0; i < 6; i++) {
-                    if ((i == dev->program_addr) && (addr >= dev->block_start[i]) && (addr <= dev->block_end[i]))
+                    if ((i == dev->program_addr) && (addr >= dev->block_start[i]) && (addr <= dev->block_end[i])) {
                         memset(&(dev->array[dev->block_start[i]]), 0xff, dev->block_len[i]);
+                        dev->dirty = 1;
+                    }
                 }
 
                 dev->status = 0x80;
@@ -189,8 +221,10 @@ flash_write(uint32_t addr, uint8_t val, void *priv)
 
         case CMD_PROGRAM_SETUP:
         case CMD_PROGRAM_SETUP_ALT:
-            if (((addr & bb_mask) != (dev->block_start[6] & bb_mask)) && (addr == dev->program_addr))
+            if (((addr & bb_mask) != (dev->block_start[6] & bb_mask)) && (addr == dev->program_addr)) {
                 dev->array[addr] = val;
+                dev->dirty       = 1;
+            }
             dev->command = CMD_READ_STATUS;
             dev->status  = 0x80;
             break;
@@ -216,12 +250,15 @@ flash_write(uint32_t addr, uint8_t val, void *priv)
                     break;
             }
     }
+
+    flash_command_changed(dev, old_command);
 }
 
 static void
 flash_writew(uint32_t addr, uint16_t val, void *priv)
 {
     flash_t *dev = (flash_t *) priv;
+    uint8_t  old_command = dev->command;
     uint32_t bb_mask = biosmask & 0xffffe000;
     if (biosmask == 0x7ffff)
         bb_mask &= 0xffff8000;
@@ -237,8 +274,10 @@ flash_writew(uint32_t addr, uint16_t val, void *priv)
             case CMD_ERASE_SETUP:
                 if (val == CMD_ERASE_CONFIRM) {
                     for (uint8_t i = 0; i < 6; i++) {
-                        if ((i == dev->program_addr) && (addr >= dev->block_start[i]) && (addr <= dev->block_end[i]))
+                        if ((i == dev->program_addr) && (addr >= dev->block_start[i]) && (addr <= dev->block_end[i])) {
                             memset(&(dev->array[dev->block_start[i]]), 0xff, dev->block_len[i]);
+                            dev->dirty = 1;
+                        }
                     }
 
                     dev->status = 0x80;
@@ -248,8 +287,10 @@ flash_writew(uint32_t addr, uint16_t val, void *priv)
 
             case CMD_PROGRAM_SETUP:
             case CMD_PROGRAM_SETUP_ALT:
-                if (((addr & bb_mask) != (dev->block_start[6] & bb_mask)) && (addr == dev->program_addr))
+                if (((addr & bb_mask) != (dev->block_start[6] & bb_mask)) && (addr == dev->program_addr)) {
                     *(uint16_t *) (&dev->array[addr]) = val;
+                    dev->dirty                        = 1;
+                }
                 dev->command = CMD_READ_STATUS;
                 dev->status  = 0x80;
                 break;
@@ -275,6 +316,8 @@ flash_writew(uint32_t addr, uint16_t val, void *priv)
                         break;
                 }
         }
+
+    flash_command_changed(dev, old_command);
 }
 
 static void
@@ -522,7 +565,8 @@ intel_flash_init(const device_t *info)
         (void) !fread(&(dev->array[dev->block_start[BLOCK_DATA1]]), dev->block_len[BLOCK_DATA1], 1, fp);
         (void) !fread(&(dev->array[dev->block_start[BLOCK_DATA2]]), dev->block_len[BLOCK_DATA2], 1, fp);
         fclose(fp);
-    }
+    } else
+        dev->dirty = 1; /* It is by definition dirty on creation. */
 
     return dev;
 }
@@ -533,18 +577,23 @@ intel_flash_close(void *priv)
     FILE    *fp;
     flash_t *dev = (flash_t *) priv;
 
-    fp = nvr_fopen(flash_path, "wb");
-    fwrite(&(dev->array[dev->block_start[BLOCK_MAIN1]]), dev->block_len[BLOCK_MAIN1], 1, fp);
-    if (dev->block_len[BLOCK_MAIN2])
-        fwrite(&(dev->array[dev->block_start[BLOCK_MAIN2]]), dev->block_len[BLOCK_MAIN2], 1, fp);
-    if (dev->block_len[BLOCK_MAIN3])
-        fwrite(&(dev->array[dev->block_start[BLOCK_MAIN3]]), dev->block_len[BLOCK_MAIN3], 1, fp);
-    if (dev->block_len[BLOCK_MAIN4])
-        fwrite(&(dev->array[dev->block_start[BLOCK_MAIN4]]), dev->block_len[BLOCK_MAIN4], 1, fp);
-
-    fwrite(&(dev->array[dev->block_start[BLOCK_DATA1]]), dev->block_len[BLOCK_DATA1], 1, fp);
-    fwrite(&(dev->array[dev->block_start[BLOCK_DATA2]]), dev->block_len[BLOCK_DATA2], 1, fp);
-    fclose(fp);
+    /* Only rewrite the file if the guest did program or erase the flash. */
+    if (dev->dirty) {
+        fp = nvr_fopen(flash_path, "wb");
+        if (fp) {
+            fwrite(&(dev->array[dev->block_start[BLOCK_MAIN1]]), dev->block_len[BLOCK_MAIN1], 1, fp);
+            if (dev->block_len[BLOCK_MAIN2])
+                fwrite(&(dev->array[dev->block_start[BLOCK_MAIN2]]), dev->block_len[BLOCK_MAIN2], 1, fp);
+            if (dev->block_len[BLOCK_MAIN3])
+                fwrite(&(dev->array[dev->block_start[BLOCK_MAIN3]]), dev->block_len[BLOCK_MAIN3], 1, fp);
+            if (dev->block_len[BLOCK_MAIN4])
+                fwrite(&(dev->array[dev->block_start[BLOCK_MAIN4]]), dev->block_len[BLOCK_MAIN4], 1, fp);
+
+            fwrite(&(dev->array[dev->block_start[BLOCK_DATA1]]), dev->block_len[BLOCK_DATA1], 1, fp);
+            fwrite(&(dev->array[dev->block_start[BLOCK_DATA2]]), dev->block_len[BLOCK_DATA2], 1, fp);
+            fclose(fp);
+        }
+    }
 
     free(dev->array);
     dev->array = NULL;
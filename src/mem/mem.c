@@ -18,6 +18,7 @@
  */
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -33,10 +34,12 @@
 #include <86box/machine.h>
 #include <86box/m_xt_xi8088.h>
 #include <86box/config.h>
+#include <86box/device_prof.h>
 #include <86box/io.h>
 #include <86box/mem.h>
 #include <86box/plat.h>
 #include <86box/rom.h>
+#include <86box/snapshot.h>
 #include <86box/gdbstub.h>
 #ifdef USE_DYNAREC
 #    include "codegen_public.h"
@@ -89,6 +92,21 @@ uint8_t    uncached = 0;
 int        writelnext;
 int        writelookup[256];
 
+/* Which lookup slots hold global pages, kept across CR3 loads. */
+static uint8_t  readlookup_global[256];
+static uint8_t  writelookup_global[256];
+/* Linear page of the last translation, if it was a global page. */
+static uint32_t mmu_global_page = 0xffffffff;
+
+/* Page walk cache, the upper level entries of recent walks. PDPTEs are cached
+   on PAE CPUs like the P6 does with its PDPTE registers, PDEs only on P6 class
+   CPUs, which may cache them as well. Cleared together with the lookups. */
+#define MMU_PWC_SIZE 64
+static uint32_t mmu_pwc_tag[MMU_PWC_SIZE];
+static uint64_t mmu_pwc_pde[MMU_PWC_SIZE];
+static uint64_t mmu_pwc_pdpte[4];
+static uint8_t  mmu_pwc_pdpte_valid = 0;
+
 /* The lookup tables. */
 page_t *page_lookup[1048576] = { 0 };
 uintptr_t readlookup2[1048576] = { 0 };
@@ -97,6 +115,9 @@ uintptr_t writelookup2[1048576] = { 0 };
 
 uint32_t mem_logical_addr;
 
+/* Bumped whenever the memory map is rebuilt, for users caching host pointers. */
+uint32_t mem_mapping_gen = 0;
+
 int shadowbios = 0;
 int shadowbios_write;
 int readlnum  = 0;
@@ -122,6 +143,10 @@ int      purgeable_page_count    = 0;
 
 uint8_t high_page = 0; /* if a high (> 4 gb) page was detected */
 
+/* (O) Count the accesses reaching each mapping, and dump them to mem_profile_path. */
+int  mem_profile = 0;
+char mem_profile_path[1024];
+
 mem_mapping_t        *read_mapping[MEM_MAPPINGS_NO];
 mem_mapping_t        *write_mapping[MEM_MAPPINGS_NO];
 
@@ -138,6 +163,21 @@ static mem_state_t    _mem_state[MEM_MAPPINGS_NO];
 static uint32_t       remap_start_addr;
 static uint32_t       remap_start_addr2;
 static size_t ram_size = 0;
+static int            ram_large = 0; /* RAM came from plat_mmap_large() */
+static uint64_t      *ram_page_hash = NULL; /* Page contents at the last checkpoint */
+static size_t         ram_wp_page   = 0;    /* Host page size RAM is write protected in, -1 if it cannot be */
+static int            ram_wp_armed  = 0;    /* RAM is write protected */
+static int            ram_wp_base   = 0;    /* ram_wp_dirty has every write since the last checkpoint */
+static uint8_t       *ram_wp_dirty  = NULL; /* Pages written since the last checkpoint */
+static atomic_uchar  *ram_cow_state = NULL; /* Pages held by the checkpoint being written */
+static size_t        *ram_cow_off   = NULL; /* Where in that snapshot each held page goes */
+static uint32_t      *ram_cow_list  = NULL;
+static uint32_t       ram_cow_count = 0;
+static uint8_t       *ram_cow_buf   = NULL;
+static int            ram_cow_defer = 0;    /* Pages are held as the checkpoint is taken, not copied */
+static int            mem_mapping_batch_depth = 0;
+static int            mem_mapping_batch_pending = 0;
+static uint64_t       mem_mapping_batch_dirty[MEM_MAPPINGS_NO / 64];
 
 #ifdef ENABLE_MEM_LOG
 int mem_do_log = ENABLE_MEM_LOG;
@@ -157,6 +197,55 @@ mem_log(const char *fmt, ...)
 #    define mem_log(fmt, ...)
 #endif
 
+static __inline void
+mem_profile_count(mem_mapping_t *map, int type)
+{
+    if (mem_profile && (map != NULL))
+        map->profile[type]++;
+}
+
+/* Handler calls, timed per device with --devprof; RAM and ROM mappings have no priv. */
+#define MEM_CALL_READ(type, name)                                    \
+    static __inline type                                             \
+    mem_call_##name(const mem_mapping_t *map, uint32_t addr)         \
+    {                                                                \
+        void    *priv = map->priv;                                   \
+        uint64_t start;                                              \
+        type     ret;                                                \
+                                                                     \
+        if (!device_profile || (priv == NULL))                       \
+            return map->name(addr, priv);                            \
+                                                                     \
+        start = plat_get_nsecs();                                    \
+        ret   = map->name(addr, priv);                               \
+        device_prof_add(priv, DEVICE_PROF_MMIO, start);              \
+        return ret;                                                  \
+    }
+
+#define MEM_CALL_WRITE(type, name)                                   \
+    static __inline void                                             \
+    mem_call_##name(const mem_mapping_t *map, uint32_t addr, type val) \
+    {                                                                \
+        void    *priv = map->priv;                                   \
+        uint64_t start;                                              \
+                                                                     \
+        if (!device_profile || (priv == NULL)) {                     \
+            map->name(addr, val, priv);                              \
+            return;                                                  \
+        }                                                            \
+                                                                     \
+        start = plat_get_nsecs();                                    \
+        map->name(addr, val, priv);                                  \
+        device_prof_add(priv, DEVICE_PROF_MMIO, start);              \
+    }
+
+MEM_CALL_READ(uint8_t, read_b)
+MEM_CALL_READ(uint16_t, read_w)
+MEM_CALL_READ(uint32_t, read_l)
+MEM_CALL_WRITE(uint8_t, write_b)
+MEM_CALL_WRITE(uint16_t, write_w)
+MEM_CALL_WRITE(uint32_t, write_l)
+
 int
 mem_addr_is_ram(uint32_t addr)
 {
@@ -166,9 +255,18 @@ mem_addr_is_ram(uint32_t addr)
            (mapping == &ram_mid_mapping2) || (mapping == &ram_remapped_mapping);
 }
 
+static __inline void
+mmu_pwc_flush(void)
+{
+    memset(mmu_pwc_tag, 0xff, sizeof(mmu_pwc_tag));
+    mmu_pwc_pdpte_valid = 0;
+}
+
 void
 resetreadlookup(void)
 {
+    mmu_pwc_flush();
+
     /* Initialize the page lookup table. */
     memset(page_lookup, 0x00, (1 << 20) * sizeof(page_t *));
 
@@ -192,6 +290,8 @@ resetreadlookup(void)
 void
 flushmmucache(void)
 {
+    mmu_pwc_flush();
+
     for (uint16_t c = 0; c < 256; c++) {
         if (readlookup[c] != (int) 0xffffffff) {
             readlookup2[readlookup[c]] = LOOKUP_INV;
@@ -213,6 +313,33 @@ flushmmucache(void)
 #endif
 }
 
+/* Flushes the lookups on a CR3 load, keeping those for global pages. */
+void
+flushmmucache_cr3(void)
+{
+    mmu_pwc_flush();
+
+    for (uint16_t c = 0; c < 256; c++) {
+        if ((readlookup[c] != (int) 0xffffffff) && !readlookup_global[c]) {
+            readlookup2[readlookup[c]] = LOOKUP_INV;
+            readlookup[c]              = 0xffffffff;
+        }
+        if ((writelookup[c] != (int) 0xffffffff) && !writelookup_global[c]) {
+            page_lookup[writelookup[c]]  = NULL;
+            writelookup2[writelookup[c]] = LOOKUP_INV;
+            writelookup[c]               = 0xffffffff;
+        }
+    }
+    mmuflush++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
 void
 flushmmucache_write(void)
 {
@@ -242,6 +369,8 @@ flushmmucache_pc(void)
 void
 flushmmucache_nopc(void)
 {
+    mmu_pwc_flush();
+
     for (uint16_t c = 0; c < 256; c++) {
         if (readlookup[c] != (int) 0xffffffff) {
             readlookup2[readlookup[c]] = LOOKUP_INV;
@@ -255,6 +384,40 @@ flushmmucache_nopc(void)
     }
 }
 
+/* Flushes the lookups that an A20 toggle changes. Without paging, linear addresses
+   are physical, so only the pages with bit 20 set are affected by the mask. */
+static void
+flushmmucache_a20(void)
+{
+    if (cr0 >> 31) {
+        flushmmucache();
+        return;
+    }
+
+    for (uint16_t c = 0; c < 256; c++) {
+        if ((readlookup[c] != (int) 0xffffffff) && (readlookup[c] & 0x100)) {
+            readlookup2[readlookup[c]] = LOOKUP_INV;
+            readlookup[c]              = 0xffffffff;
+        }
+        if ((writelookup[c] != (int) 0xffffffff) && (writelookup[c] & 0x100)) {
+            page_lookup[writelookup[c]]  = NULL;
+            writelookup2[writelookup[c]] = LOOKUP_INV;
+            writelookup[c]               = 0xffffffff;
+        }
+    }
+    mmuflush++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+    if (get_phys_virt & 0x100000)
+        get_phys_phys = (get_phys_virt & rammask) & ~0xfff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
 void
 mem_flush_write_page(uint32_t addr, uint32_t virt)
 {
@@ -284,12 +447,18 @@ mmutranslatereal_normal(uint32_t addr, int rw)
     uint32_t temp2;
     uint32_t temp3;
     uint32_t addr2;
+    uint32_t addr3;
+    uint32_t ad    = rw ? 0x60 : 0x20;
+    int      pwc   = (addr >> 22) & (MMU_PWC_SIZE - 1);
 
     if (cpu_state.abrt)
         return 0xffffffffffffffffULL;
 
     addr2 = ((cr3 & ~0xfff) + ((addr >> 20) & 0xffc));
-    temp = temp2 = rammap(addr2);
+    if (mmu_pwc_tag[pwc] == (addr >> 22))
+        temp = temp2 = (uint32_t) mmu_pwc_pde[pwc];
+    else
+        temp = temp2 = rammap(addr2);
     if (!(temp & 1)) {
         cr2 = addr;
         temp &= 1;
@@ -317,7 +486,16 @@ mmutranslatereal_normal(uint32_t addr, int rw)
             return 0xffffffffffffffffULL;
         }
 
-        rammap(addr2) |= (rw ? 0x60 : 0x20);
+        if ((temp & ad) != ad) {
+            rammap(addr2) |= ad;
+            temp |= ad;
+        }
+        if (is_p6) {
+            mmu_pwc_tag[pwc] = addr >> 22;
+            mmu_pwc_pde[pwc] = temp;
+        }
+
+        mmu_global_page = ((temp & 0x100) && (cr4 & CR4_PGE)) ? (addr >> 12) : 0xffffffff;
 
         uint64_t page = temp & ~0x3fffff;
         if (cpu_features & CPU_FEATURE_PSE36)
@@ -325,7 +503,8 @@ mmutranslatereal_normal(uint32_t addr, int rw)
         return page + (addr & 0x3fffff);
     }
 
-    temp  = rammap((temp & ~0xfff) + ((addr >> 10) & 0xffc));
+    addr3 = (temp & ~0xfff) + ((addr >> 10) & 0xffc);
+    temp  = rammap(addr3);
     temp3 = temp & temp2;
     if (!(temp & 1) || ((CPL == 3) && !(temp3 & 4) && !cpl_override) || (rw && !cpl_override && !(temp3 & 2) && (((CPL == 3) && !cpl_override) || ((is486 || isibm486) && (cr0 & WP_FLAG))))) {
         cr2 = addr;
@@ -339,8 +518,19 @@ mmutranslatereal_normal(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    rammap(addr2) |= 0x20;
-    rammap((temp2 & ~0xfff) + ((addr >> 10) & 0xffc)) |= (rw ? 0x60 : 0x20);
+    /* Skip the accessed and dirty bit writes if they are already set. */
+    if (!(temp2 & 0x20)) {
+        rammap(addr2) |= 0x20;
+        temp2 |= 0x20;
+    }
+    if ((temp & ad) != ad)
+        rammap(addr3) |= ad;
+    if (is_p6) {
+        mmu_pwc_tag[pwc] = addr >> 22;
+        mmu_pwc_pde[pwc] = temp2;
+    }
+
+    mmu_global_page = ((temp & 0x100) && (cr4 & CR4_PGE)) ? (addr >> 12) : 0xffffffff;
 
     return (uint64_t) ((temp & ~0xfff) + (addr & 0xfff));
 }
@@ -355,12 +545,17 @@ mmutranslatereal_pae(uint32_t addr, int rw)
     uint64_t addr2;
     uint64_t addr3;
     uint64_t addr4;
+    uint64_t ad  = rw ? 0x60 : 0x20;
+    int      pwc = (addr >> 21) & (MMU_PWC_SIZE - 1);
 
     if (cpu_state.abrt)
         return 0xffffffffffffffffULL;
 
     addr2 = (cr3 & ~0x1f) + ((addr >> 27) & 0x18);
-    temp = temp2 = rammap64(addr2) & 0x000000ffffffffffULL;
+    if (mmu_pwc_pdpte_valid & (1 << (addr >> 30)))
+        temp = temp2 = mmu_pwc_pdpte[addr >> 30];
+    else
+        temp = temp2 = rammap64(addr2) & 0x000000ffffffffffULL;
     if (!(temp & 1)) {
         cr2 = addr;
         temp &= 1;
@@ -373,8 +568,14 @@ mmutranslatereal_pae(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
+    mmu_pwc_pdpte[addr >> 30] = temp2;
+    mmu_pwc_pdpte_valid |= (1 << (addr >> 30));
+
     addr3 = (temp & ~0xfffULL) + ((addr >> 18) & 0xff8);
-    temp = temp4 = rammap64(addr3) & 0x000000ffffffffffULL;
+    if (mmu_pwc_tag[pwc] == (addr >> 21))
+        temp = temp4 = mmu_pwc_pde[pwc];
+    else
+        temp = temp4 = rammap64(addr3) & 0x000000ffffffffffULL;
     temp3        = temp & temp2;
     if (!(temp & 1)) {
         cr2 = addr;
@@ -402,7 +603,16 @@ mmutranslatereal_pae(uint32_t addr, int rw)
 
             return 0xffffffffffffffffULL;
         }
-        rammap64(addr3) |= (rw ? 0x60 : 0x20);
+        if ((temp & ad) != ad) {
+            rammap64(addr3) |= ad;
+            temp |= ad;
+        }
+        if (is_p6) {
+            mmu_pwc_tag[pwc] = addr >> 21;
+            mmu_pwc_pde[pwc] = temp;
+        }
+
+        mmu_global_page = ((temp & 0x100) && (cr4 & CR4_PGE)) ? (addr >> 12) : 0xffffffff;
 
         return ((temp & ~0x1fffffULL) + (addr & 0x1fffffULL)) & 0x000000ffffffffffULL;
     }
@@ -422,8 +632,19 @@ mmutranslatereal_pae(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    rammap64(addr3) |= 0x20;
-    rammap64(addr4) |= (rw ? 0x60 : 0x20);
+    /* Skip the accessed and dirty bit writes if they are already set. */
+    if (!(temp4 & 0x20)) {
+        rammap64(addr3) |= 0x20;
+        temp4 |= 0x20;
+    }
+    if ((temp & ad) != ad)
+        rammap64(addr4) |= ad;
+    if (is_p6) {
+        mmu_pwc_tag[pwc] = addr >> 21;
+        mmu_pwc_pde[pwc] = temp4;
+    }
+
+    mmu_global_page = ((temp & 0x100) && (cr4 & CR4_PGE)) ? (addr >> 12) : 0xffffffff;
 
     return ((temp & ~0xfffULL) + ((uint64_t) (addr & 0xfff))) & 0x000000ffffffffffULL;
 }
@@ -567,8 +788,21 @@ mem_addr_translate(uint32_t addr, uint32_t chunk_start, uint32_t len)
     return chunk_start + (addr & mask);
 }
 
-void
-addreadlookup(uint32_t virt, uint32_t phys)
+/*
+ * readlookup2[] and writelookup2[] are the direct host-pointer fast path for
+ * plain RAM: one entry per 4 KB virtual page, holding the host address of
+ * the page minus its virtual base, or LOOKUP_INV. The inline accessors in
+ * 386_common.h and the code emitted by the recompiler index them first and
+ * only drop into readmem*l()/writemem*l() (and from there into the mapping
+ * handlers) on a miss, a misaligned access or with debug registers armed.
+ * Entries are installed here, from the RAM handlers, and by handlers of
+ * mappings backed by plain host memory through mem_add_host_readlookup()
+ * and mem_add_host_writelookup(); other MMIO and ROM never get one. RAM
+ * pages holding recompiled code get a page_lookup[] entry instead so that
+ * writes still reach the dirty tracking.
+ */
+static void
+addreadlookup_host(uint32_t virt, uint8_t *page)
 {
     if (virt == 0xffffffff)
         return;
@@ -576,20 +810,64 @@ addreadlookup(uint32_t virt, uint32_t phys)
     if (readlookup2[virt >> 12] != (uintptr_t) LOOKUP_INV)
         return;
 
+    if (gdbstub_page_watched(virt))
+        return;
+
     if (readlookup[readlnext] != (int) 0xffffffff) {
         if ((readlookup[readlnext] == ((es + DI) >> 12)) || (readlookup[readlnext] == ((es + EDI) >> 12)))
             uncached = 1;
         readlookup2[readlookup[readlnext]] = LOOKUP_INV;
     }
 
-    readlookup2[virt >> 12] = (uintptr_t) &ram[(uintptr_t) (phys & ~0xFFF) - (uintptr_t) (virt & ~0xfff)];
+    readlookup2[virt >> 12] = (uintptr_t) page - (uintptr_t) (virt & ~0xfff);
 
-    readlookup[readlnext++] = virt >> 12;
+    readlookup_global[readlnext] = (mmu_global_page == (virt >> 12));
+    readlookup[readlnext++]      = virt >> 12;
     readlnext &= (cachesize - 1);
 
     cycles -= 9;
 }
 
+void
+addreadlookup(uint32_t virt, uint32_t phys)
+{
+    addreadlookup_host(virt, &ram[phys & ~0xfff]);
+}
+
+/* For handlers of mappings backed by host memory, such as an mmap()ed device
+   BAR, with page the host address of the physical page being accessed; later
+   accesses then bypass the handler until the next MMU cache flush. The
+   mapping must cover the whole page and never hold code, writes through the
+   lookup are not seen by the recompiler. */
+void
+mem_add_host_readlookup(uint32_t virt, uint8_t *page)
+{
+    addreadlookup_host(virt, page);
+}
+
+void
+mem_add_host_writelookup(uint32_t virt, uint8_t *page)
+{
+    if ((virt == 0xffffffff) || (writelookup2[virt >> 12] != (uintptr_t) LOOKUP_INV) || page_lookup[virt >> 12])
+        return;
+
+    if (gdbstub_page_watched(virt))
+        return;
+
+    if (writelookup[writelnext] != -1) {
+        page_lookup[writelookup[writelnext]]  = NULL;
+        writelookup2[writelookup[writelnext]] = LOOKUP_INV;
+    }
+
+    writelookup2[virt >> 12] = (uintptr_t) page - (uintptr_t) (virt & ~0xfff);
+
+    writelookup_global[writelnext] = (mmu_global_page == (virt >> 12));
+    writelookup[writelnext++]      = virt >> 12;
+    writelnext &= (cachesize - 1);
+
+    cycles -= 9;
+}
+
 void
 addwritelookup(uint32_t virt, uint32_t phys)
 {
@@ -599,6 +877,9 @@ addwritelookup(uint32_t virt, uint32_t phys)
     if (page_lookup[virt >> 12])
         return;
 
+    if (gdbstub_page_watched(virt))
+        return;
+
     if (writelookup[writelnext] != -1) {
         page_lookup[writelookup[writelnext]]  = NULL;
         writelookup2[writelookup[writelnext]] = LOOKUP_INV;
@@ -623,7 +904,8 @@ addwritelookup(uint32_t virt, uint32_t phys)
         writelookup2[virt >> 12] = (uintptr_t) &ram[(uintptr_t) (phys & ~0xFFF) - (uintptr_t) (virt & ~0xfff)];
     }
 
-    writelookup[writelnext++] = virt >> 12;
+    writelookup_global[writelnext] = (mmu_global_page == (virt >> 12));
+    writelookup[writelnext++]      = virt >> 12;
     writelnext &= (cachesize - 1);
 
     cycles -= 9;
@@ -674,8 +956,9 @@ read_mem_b(uint32_t addr)
     addr &= rammask;
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_READ_B);
     if (map && map->read_b)
-        ret = map->read_b(addr, map->priv);
+        ret = mem_call_read_b(map, addr);
 
     resub_cycles(old_cycles);
 
@@ -696,11 +979,12 @@ read_mem_w(uint32_t addr)
         ret = read_mem_b(addr) | (read_mem_b(addr + 1) << 8);
     else {
         map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+        mem_profile_count(map, MEM_PROFILE_READ_W);
 
         if (map && map->read_w)
-            ret = map->read_w(addr, map->priv);
+            ret = mem_call_read_w(map, addr);
         else if (map && map->read_b)
-            ret = map->read_b(addr, map->priv) | (map->read_b(addr + 1, map->priv) << 8);
+            ret = mem_call_read_b(map, addr) | (mem_call_read_b(map, addr + 1) << 8);
     }
 
     resub_cycles(old_cycles);
@@ -718,8 +1002,9 @@ write_mem_b(uint32_t addr, uint8_t val)
     addr &= rammask;
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_WRITE_B);
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_call_write_b(map, addr, val);
 
     resub_cycles(old_cycles);
 }
@@ -738,12 +1023,13 @@ write_mem_w(uint32_t addr, uint16_t val)
         write_mem_b(addr + 1, val >> 8);
     } else {
         map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+        mem_profile_count(map, MEM_PROFILE_WRITE_W);
         if (map) {
             if (map->write_w)
-                map->write_w(addr, val, map->priv);
+                mem_call_write_w(map, addr, val);
             else if (map->write_b) {
-                map->write_b(addr, val, map->priv);
-                map->write_b(addr + 1, val >> 8, map->priv);
+                mem_call_write_b(map, addr, val);
+                mem_call_write_b(map, addr + 1, val >> 8);
             }
         }
     }
@@ -777,8 +1063,9 @@ readmembl(uint32_t addr)
     addr = (uint32_t) (addr64 & rammask);
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_READ_B);
     if (map && map->read_b)
-        return map->read_b(addr, map->priv);
+        return mem_call_read_b(map, addr);
 
     return 0xff;
 }
@@ -814,8 +1101,9 @@ writemembl(uint32_t addr, uint8_t val)
     addr = (uint32_t) (addr64 & rammask);
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_WRITE_B);
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_call_write_b(map, addr, val);
 }
 
 /* Read a byte from memory without MMU translation - result of previous MMU translation passed as value. */
@@ -837,8 +1125,9 @@ readmembl_no_mmut(uint32_t addr, uint32_t a64)
         addr &= rammask;
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_READ_B);
     if (map && map->read_b)
-        return map->read_b(addr, map->priv);
+        return mem_call_read_b(map, addr);
 
     return 0xff;
 }
@@ -867,8 +1156,9 @@ writemembl_no_mmut(uint32_t addr, uint32_t a64, uint8_t val)
         addr &= rammask;
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_WRITE_B);
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_call_write_b(map, addr, val);
 }
 
 uint16_t
@@ -920,12 +1210,13 @@ readmemwl(uint32_t addr)
     addr = addr64a[0] & rammask;
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_READ_W);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv);
+        return mem_call_read_w(map, addr);
 
     if (map && map->read_b) {
-        return map->read_b(addr, map->priv) | ((uint16_t) (map->read_b(addr + 1, map->priv)) << 8);
+        return mem_call_read_b(map, addr) | ((uint16_t) (mem_call_read_b(map, addr + 1)) << 8);
     }
 
     return 0xffff;
@@ -994,15 +1285,16 @@ writememwl(uint32_t addr, uint16_t val)
     addr = addr64a[0] & rammask;
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_WRITE_W);
 
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
+        mem_call_write_w(map, addr, val);
         return;
     }
 
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
+        mem_call_write_b(map, addr, val);
+        mem_call_write_b(map, addr + 1, val >> 8);
         return;
     }
 }
@@ -1040,12 +1332,13 @@ readmemwl_no_mmut(uint32_t addr, uint32_t *a64)
         addr &= rammask;
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_READ_W);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv);
+        return mem_call_read_w(map, addr);
 
     if (map && map->read_b) {
-        return map->read_b(addr, map->priv) | ((uint16_t) (map->read_b(addr + 1, map->priv)) << 8);
+        return mem_call_read_b(map, addr) | ((uint16_t) (mem_call_read_b(map, addr + 1)) << 8);
     }
 
     return 0xffff;
@@ -1093,15 +1386,16 @@ writememwl_no_mmut(uint32_t addr, uint32_t *a64, uint16_t val)
         addr &= rammask;
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_WRITE_W);
 
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
+        mem_call_write_w(map, addr, val);
         return;
     }
 
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
+        mem_call_write_b(map, addr, val);
+        mem_call_write_b(map, addr + 1, val >> 8);
         return;
     }
 }
@@ -1169,15 +1463,16 @@ readmemll(uint32_t addr)
     addr = addr64a[0] & rammask;
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_READ_L);
 
     if (map && map->read_l)
-        return map->read_l(addr, map->priv);
+        return mem_call_read_l(map, addr);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv) | ((uint32_t) (map->read_w(addr + 2, map->priv)) << 16);
+        return mem_call_read_w(map, addr) | ((uint32_t) (mem_call_read_w(map, addr + 2)) << 16);
 
     if (map && map->read_b)
-        return map->read_b(addr, map->priv) | ((uint32_t) (map->read_b(addr + 1, map->priv)) << 8) | ((uint32_t) (map->read_b(addr + 2, map->priv)) << 16) | ((uint32_t) (map->read_b(addr + 3, map->priv)) << 24);
+        return mem_call_read_b(map, addr) | ((uint32_t) (mem_call_read_b(map, addr + 1)) << 8) | ((uint32_t) (mem_call_read_b(map, addr + 2)) << 16) | ((uint32_t) (mem_call_read_b(map, addr + 3)) << 24);
 
     return 0xffffffff;
 }
@@ -1258,21 +1553,22 @@ writememll(uint32_t addr, uint32_t val)
     addr = addr64a[0] & rammask;
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_WRITE_L);
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
+        mem_call_write_l(map, addr, val);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
+        mem_call_write_w(map, addr, val);
+        mem_call_write_w(map, addr + 2, val >> 16);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
+        mem_call_write_b(map, addr, val);
+        mem_call_write_b(map, addr + 1, val >> 8);
+        mem_call_write_b(map, addr + 2, val >> 16);
+        mem_call_write_b(map, addr + 3, val >> 24);
         return;
     }
 }
@@ -1310,15 +1606,16 @@ readmemll_no_mmut(uint32_t addr, uint32_t *a64)
         addr &= rammask;
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_READ_L);
 
     if (map && map->read_l)
-        return map->read_l(addr, map->priv);
+        return mem_call_read_l(map, addr);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv) | ((uint32_t) (map->read_w(addr + 2, map->priv)) << 16);
+        return mem_call_read_w(map, addr) | ((uint32_t) (mem_call_read_w(map, addr + 2)) << 16);
 
     if (map && map->read_b)
-        return map->read_b(addr, map->priv) | ((uint32_t) (map->read_b(addr + 1, map->priv)) << 8) | ((uint32_t) (map->read_b(addr + 2, map->priv)) << 16) | ((uint32_t) (map->read_b(addr + 3, map->priv)) << 24);
+        return mem_call_read_b(map, addr) | ((uint32_t) (mem_call_read_b(map, addr + 1)) << 8) | ((uint32_t) (mem_call_read_b(map, addr + 2)) << 16) | ((uint32_t) (mem_call_read_b(map, addr + 3)) << 24);
 
     return 0xffffffff;
 }
@@ -1365,21 +1662,22 @@ writememll_no_mmut(uint32_t addr, uint32_t *a64, uint32_t val)
         addr &= rammask;
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_WRITE_L);
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
+        mem_call_write_l(map, addr, val);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
+        mem_call_write_w(map, addr, val);
+        mem_call_write_w(map, addr + 2, val >> 16);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
+        mem_call_write_b(map, addr, val);
+        mem_call_write_b(map, addr + 1, val >> 8);
+        mem_call_write_b(map, addr + 2, val >> 16);
+        mem_call_write_b(map, addr + 3, val >> 24);
         return;
     }
 }
@@ -1446,26 +1744,27 @@ readmemql(uint32_t addr)
     addr = addr64a[0] & rammask;
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_READ_Q);
 
     if (map && map->read_l)
-        return map->read_l(addr, map->priv) |
-               ((uint64_t) map->read_l(addr + 4, map->priv) << 32);
+        return mem_call_read_l(map, addr) |
+               ((uint64_t) mem_call_read_l(map, addr + 4) << 32);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv) |
-               ((uint64_t) map->read_w(addr + 2, map->priv) << 16) |
-               ((uint64_t) map->read_w(addr + 4, map->priv) << 32) |
-               ((uint64_t) map->read_w(addr + 6, map->priv) << 48);
+        return mem_call_read_w(map, addr) |
+               ((uint64_t) mem_call_read_w(map, addr + 2) << 16) |
+               ((uint64_t) mem_call_read_w(map, addr + 4) << 32) |
+               ((uint64_t) mem_call_read_w(map, addr + 6) << 48);
 
     if (map && map->read_b)
-        return map->read_b(addr, map->priv) |
-               ((uint64_t) map->read_b(addr + 1, map->priv) << 8) |
-               ((uint64_t) map->read_b(addr + 2, map->priv) << 16) |
-               ((uint64_t) map->read_b(addr + 3, map->priv) << 24) |
-               ((uint64_t) map->read_b(addr + 4, map->priv) << 32) |
-               ((uint64_t) map->read_b(addr + 5, map->priv) << 40) |
-               ((uint64_t) map->read_b(addr + 6, map->priv) << 48) |
-               ((uint64_t) map->read_b(addr + 7, map->priv) << 56);
+        return mem_call_read_b(map, addr) |
+               ((uint64_t) mem_call_read_b(map, addr + 1) << 8) |
+               ((uint64_t) mem_call_read_b(map, addr + 2) << 16) |
+               ((uint64_t) mem_call_read_b(map, addr + 3) << 24) |
+               ((uint64_t) mem_call_read_b(map, addr + 4) << 32) |
+               ((uint64_t) mem_call_read_b(map, addr + 5) << 40) |
+               ((uint64_t) mem_call_read_b(map, addr + 6) << 48) |
+               ((uint64_t) mem_call_read_b(map, addr + 7) << 56);
 
     return 0xffffffffffffffffULL;
 }
@@ -1544,28 +1843,29 @@ writememql(uint32_t addr, uint64_t val)
     addr = addr64a[0] & rammask;
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
+    mem_profile_count(map, MEM_PROFILE_WRITE_Q);
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
-        map->write_l(addr + 4, val >> 32, map->priv);
+        mem_call_write_l(map, addr, val);
+        mem_call_write_l(map, addr + 4, val >> 32);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
-        map->write_w(addr + 4, val >> 32, map->priv);
-        map->write_w(addr + 6, val >> 48, map->priv);
+        mem_call_write_w(map, addr, val);
+        mem_call_write_w(map, addr + 2, val >> 16);
+        mem_call_write_w(map, addr + 4, val >> 32);
+        mem_call_write_w(map, addr + 6, val >> 48);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
-        map->write_b(addr + 4, val >> 32, map->priv);
-        map->write_b(addr + 5, val >> 40, map->priv);
-        map->write_b(addr + 6, val >> 48, map->priv);
-        map->write_b(addr + 7, val >> 56, map->priv);
+        mem_call_write_b(map, addr, val);
+        mem_call_write_b(map, addr + 1, val >> 8);
+        mem_call_write_b(map, addr + 2, val >> 16);
+        mem_call_write_b(map, addr + 3, val >> 24);
+        mem_call_write_b(map, addr + 4, val >> 32);
+        mem_call_write_b(map, addr + 5, val >> 40);
+        mem_call_write_b(map, addr + 6, val >> 48);
+        mem_call_write_b(map, addr + 7, val >> 56);
         return;
     }
 }
@@ -1625,13 +1925,14 @@ mem_readb_phys(uint32_t addr)
     mem_mapping_t *map = read_mapping_bus[addr >> MEM_GRANULARITY_BITS];
     uint8_t        ret = 0xff;
 
+    mem_profile_count(map, MEM_PROFILE_READ_B);
     mem_logical_addr = 0xffffffff;
 
     if (map) {
         if (cpu_use_exec && map->exec)
             ret = map->exec[(addr - map->base) & map->mask];
         else if (map->read_b)
-            ret = map->read_b(addr, map->priv);
+            ret = mem_call_read_b(map, addr);
     }
 
     return ret;
@@ -1644,13 +1945,14 @@ mem_readw_phys(uint32_t addr)
     uint16_t        ret;
     const uint16_t *p;
 
+    mem_profile_count(map, MEM_PROFILE_READ_W);
     mem_logical_addr = 0xffffffff;
 
     if (cpu_use_exec && ((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_HBOUND) && (map && map->exec)) {
         p   = (uint16_t *) &(map->exec[(addr - map->base) & map->mask]);
         ret = *p;
     } else if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_HBOUND) && (map && map->read_w))
-        ret = map->read_w(addr, map->priv);
+        ret = mem_call_read_w(map, addr);
     else {
         ret = mem_readb_phys(addr + 1) << 8;
         ret |= mem_readb_phys(addr);
@@ -1666,13 +1968,14 @@ mem_readl_phys(uint32_t addr)
     uint32_t        ret;
     const uint32_t *p;
 
+    mem_profile_count(map, MEM_PROFILE_READ_L);
     mem_logical_addr = 0xffffffff;
 
     if (cpu_use_exec && ((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) && (map && map->exec)) {
         p   = (uint32_t *) &(map->exec[(addr - map->base) & map->mask]);
         ret = *p;
     } else if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) && (map && map->read_l))
-        ret = map->read_l(addr, map->priv);
+        ret = mem_call_read_l(map, addr);
     else {
         ret = mem_readw_phys(addr + 2) << 16;
         ret |= mem_readw_phys(addr);
@@ -1705,13 +2008,14 @@ mem_writeb_phys(uint32_t addr, uint8_t val)
 {
     mem_mapping_t *map = write_mapping_bus[addr >> MEM_GRANULARITY_BITS];
 
+    mem_profile_count(map, MEM_PROFILE_WRITE_B);
     mem_logical_addr = 0xffffffff;
 
     if (map) {
         if (cpu_use_exec && map->exec)
             map->exec[(addr - map->base) & map->mask] = val;
         else if (map->write_b)
-            map->write_b(addr, val, map->priv);
+            mem_call_write_b(map, addr, val);
     }
 }
 
@@ -1721,13 +2025,14 @@ mem_writew_phys(uint32_t addr, uint16_t val)
     mem_mapping_t *map = write_mapping_bus[addr >> MEM_GRANULARITY_BITS];
     uint16_t      *p;
 
+    mem_profile_count(map, MEM_PROFILE_WRITE_W);
     mem_logical_addr = 0xffffffff;
 
     if (cpu_use_exec && ((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_HBOUND) && (map && map->exec)) {
         p  = (uint16_t *) &(map->exec[(addr - map->base) & map->mask]);
         *p = val;
     } else if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_HBOUND) && (map && map->write_w))
-        map->write_w(addr, val, map->priv);
+        mem_call_write_w(map, addr, val);
     else {
         mem_writeb_phys(addr, val & 0xff);
         mem_writeb_phys(addr + 1, (val >> 8) & 0xff);
@@ -1740,19 +2045,36 @@ mem_writel_phys(uint32_t addr, uint32_t val)
     mem_mapping_t *map = write_mapping_bus[addr >> MEM_GRANULARITY_BITS];
     uint32_t      *p;
 
+    mem_profile_count(map, MEM_PROFILE_WRITE_L);
     mem_logical_addr = 0xffffffff;
 
     if (cpu_use_exec && ((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) && (map && map->exec)) {
         p  = (uint32_t *) &(map->exec[(addr - map->base) & map->mask]);
         *p = val;
     } else if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) && (map && map->write_l))
-        map->write_l(addr, val, map->priv);
+        mem_call_write_l(map, addr, val);
     else {
         mem_writew_phys(addr, val & 0xffff);
         mem_writew_phys(addr + 2, (val >> 16) & 0xffff);
     }
 }
 
+/* Host pointer to the bus view of physical address addr, if the rest of its
+   granule is plain host memory that the _phys accessors would access
+   directly anyway, NULL otherwise. */
+uint8_t *
+mem_get_phys_ptr(uint32_t addr, int write)
+{
+    mem_mapping_t *map = write ? write_mapping_bus[addr >> MEM_GRANULARITY_BITS] :
+                                 read_mapping_bus[addr >> MEM_GRANULARITY_BITS];
+
+    if (!cpu_use_exec || (map == NULL) || (map->exec == NULL) ||
+        ((map->mask & MEM_GRANULARITY_MASK) != MEM_GRANULARITY_MASK))
+        return NULL;
+
+    return &(map->exec[(addr - map->base) & map->mask]);
+}
+
 void
 mem_write_phys(void *src, uint32_t addr, int transfer_size)
 {
@@ -2279,8 +2601,8 @@ mem_mapping_access_allowed(uint32_t flags, uint16_t access)
     return ret;
 }
 
-void
-mem_mapping_recalc(uint64_t base, uint64_t size)
+static void
+mem_mapping_recalc_range(uint64_t base, uint64_t size)
 {
     mem_mapping_t *map;
     int            n;
@@ -2383,9 +2705,15 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
         map = map->next;
     }
 
-    flushmmucache_nopc();
+    mem_mapping_gen++;
+}
 
 #ifdef ENABLE_MEM_LOG
+static void
+mem_mapping_log_map(void)
+{
+    uint64_t c;
+
     pclog("\nMemory map:\n");
     mem_mapping_t *write = (mem_mapping_t *) -1, *read = (mem_mapping_t *) -1, *write_bus = (mem_mapping_t *) -1, *read_bus = (mem_mapping_t *) -1;
     for (c = 0; c < (sizeof(write_mapping) / sizeof(write_mapping[0])); c++) {
@@ -2433,6 +2761,93 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
         }
     }
     pclog("\n");
+}
+#endif
+
+static void
+mem_mapping_batch_mark(uint64_t base, uint64_t size)
+{
+    uint64_t first = base >> MEM_GRANULARITY_BITS;
+    uint64_t last  = (base + size - 1) >> MEM_GRANULARITY_BITS;
+
+    if (first >= MEM_MAPPINGS_NO)
+        return;
+    if (last >= MEM_MAPPINGS_NO)
+        last = MEM_MAPPINGS_NO - 1;
+
+    for (uint64_t c = first; c <= last; c++)
+        mem_mapping_batch_dirty[c >> 6] |= (1ULL << (c & 63));
+
+    mem_mapping_batch_pending = 1;
+}
+
+void
+mem_mapping_recalc(uint64_t base, uint64_t size)
+{
+    if (!size || (base_mapping == NULL))
+        return;
+
+    if (mem_mapping_batch_depth) {
+        mem_mapping_batch_mark(base, size);
+        return;
+    }
+
+    mem_mapping_recalc_range(base, size);
+
+    flushmmucache_nopc();
+
+#ifdef ENABLE_MEM_LOG
+    mem_mapping_log_map();
+#endif
+}
+
+/*
+ * Chipsets that change the state of several ranges in a row (shadow RAM
+ * segments, SMRAM, PAM registers) can bracket the changes with
+ * mem_mapping_batch_begin() and mem_mapping_batch_commit(). In between, the
+ * recalculations are only recorded, and the commit redoes the mapping
+ * tables for the touched granules and flushes the MMU cache once. Calls
+ * nest; memory must not be accessed through the mappings before the outer
+ * commit.
+ */
+void
+mem_mapping_batch_begin(void)
+{
+    mem_mapping_batch_depth++;
+}
+
+void
+mem_mapping_batch_commit(void)
+{
+    uint64_t start = 0;
+    int      in_run = 0;
+
+    if (!mem_mapping_batch_depth || --mem_mapping_batch_depth || !mem_mapping_batch_pending)
+        return;
+
+    for (uint64_t c = 0; c <= MEM_MAPPINGS_NO; c++) {
+        int dirty = (c < MEM_MAPPINGS_NO) && (mem_mapping_batch_dirty[c >> 6] & (1ULL << (c & 63)));
+
+        if (dirty && !in_run) {
+            start  = c;
+            in_run = 1;
+        } else if (!dirty && in_run) {
+            mem_mapping_recalc_range(start << MEM_GRANULARITY_BITS, (c - start) << MEM_GRANULARITY_BITS);
+            in_run = 0;
+        }
+
+        /* Skip clean words quickly. */
+        if (!in_run && !(c & 63) && (c < MEM_MAPPINGS_NO) && !mem_mapping_batch_dirty[c >> 6])
+            c += 63;
+    }
+
+    memset(mem_mapping_batch_dirty, 0x00, sizeof(mem_mapping_batch_dirty));
+    mem_mapping_batch_pending = 0;
+
+    flushmmucache_nopc();
+
+#ifdef ENABLE_MEM_LOG
+    mem_mapping_log_map();
 #endif
 }
 
@@ -2532,6 +2947,8 @@ mem_mapping_add(mem_mapping_t *map,
     }
     last_mapping = map;
 
+    memset(map->profile, 0x00, sizeof(map->profile));
+
     mem_mapping_set(map, base, size, read_b, read_w, read_l,
                     write_b, write_w, write_l, exec, fl, priv);
 }
@@ -2707,6 +3124,58 @@ mem_a20_init(void)
     }
 }
 
+/*
+ * Write the access counts of every mapping to mem_profile_path as JSON and
+ * clear them. Only accesses that go through the mapping handlers are seen;
+ * RAM hits on the readlookup2/writelookup2 fast path never get here. The
+ * handlers are written as host addresses, addr2line resolves them.
+ */
+void
+mem_profile_dump(void)
+{
+    static const char *names[MEM_PROFILE_TYPES] = { "read_b", "read_w", "read_l", "read_q",
+                                                    "write_b", "write_w", "write_l", "write_q" };
+    mem_mapping_t     *map = base_mapping;
+    FILE              *fp;
+    int                first = 1;
+
+    if (!mem_profile)
+        return;
+
+    fp = plat_fopen(mem_profile_path, "w");
+    if (fp == NULL) {
+        pclog("MEM: Unable to write the access profile to %s\n", mem_profile_path);
+        return;
+    }
+
+    fprintf(fp, "{\n  \"mappings\": [");
+    while (map != NULL) {
+        uint64_t total = 0;
+
+        for (uint8_t i = 0; i < MEM_PROFILE_TYPES; i++)
+            total += map->profile[i];
+
+        if (total) {
+            fprintf(fp, "%s\n    { \"base\": %u, \"size\": %u, \"flags\": %u, \"enabled\": %s, ",
+                    first ? "" : ",", map->base, map->size, map->flags, map->enable ? "true" : "false");
+            fprintf(fp, "\"read_handler\": \"%p\", \"write_handler\": \"%p\", \"priv\": \"%p\", \"total\": %" PRIu64,
+                    map->read_b ? (void *) (uintptr_t) map->read_b : (map->read_l ? (void *) (uintptr_t) map->read_l : NULL),
+                    map->write_b ? (void *) (uintptr_t) map->write_b : (map->write_l ? (void *) (uintptr_t) map->write_l : NULL),
+                    map->priv, total);
+            for (uint8_t i = 0; i < MEM_PROFILE_TYPES; i++)
+                fprintf(fp, ", \"%s\": %" PRIu64, names[i], map->profile[i]);
+            fprintf(fp, " }");
+            first = 0;
+        }
+
+        memset(map->profile, 0x00, sizeof(map->profile));
+        map = map->next;
+    }
+    fprintf(fp, "\n  ]\n}\n");
+
+    fclose(fp);
+}
+
 /* Close all the memory mappings. */
 void
 mem_close(void)
@@ -2739,12 +3208,422 @@ mem_init_ram_mapping(mem_mapping_t *mapping, uint32_t base, uint32_t size)
     mem_add_ram_mapping(mapping, base, size);
 }
 
+static void mem_wp_disarm(void);
+
 void
 mem_zero(void)
 {
+    mem_wp_disarm();
     memset(ram, 0x00, ram_size + 16);
 }
 
+static int
+mem_page_is_zero(const uint8_t *p, size_t len)
+{
+    const uint64_t *q = (const uint64_t *) p;
+
+    for (size_t i = 0; i < (len >> 3); i++) {
+        if (q[i] != 0ULL)
+            return 0;
+    }
+    for (size_t i = len & ~7; i < len; i++) {
+        if (p[i] != 0x00)
+            return 0;
+    }
+
+    return 1;
+}
+
+static uint64_t
+mem_page_hash(const uint8_t *p, size_t len)
+{
+    const uint64_t *q = (const uint64_t *) p;
+    uint64_t        h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < (len >> 3); i++) {
+        h = (h ^ q[i]) * 0x100000001b3ULL;
+        h ^= h >> 32;
+    }
+    for (size_t i = len & ~7; i < len; i++)
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+
+    return h;
+}
+
+static uint32_t
+mem_page_count(void)
+{
+    return (uint32_t) ((ram_size + 4095) >> 12);
+}
+
+static size_t
+mem_page_len(uint32_t page)
+{
+    return MIN(4096, ram_size - ((size_t) page << 12));
+}
+
+/* Forget the checkpoint the next delta would be taken against. */
+static void
+mem_page_hash_reset(void)
+{
+    free(ram_page_hash);
+    ram_page_hash = NULL;
+}
+
+/* Copy-on-write checkpoints. Once a checkpoint is taken RAM is write
+   protected, and the first write to a page faults: the page is marked
+   dirty for the next delta and made writable again. The pages a checkpoint
+   holds are not copied while it is taken, the checkpoint writer thread
+   copies them into the snapshot while the machine runs on; a write that
+   gets to a held page first copies it there itself before it goes ahead.
+
+   The state of a held page goes from pending to copying to done exactly
+   once, whoever gets to it first - the writer or a fault - does the copy,
+   and the other waits for it. Hosts that cannot protect RAM in 4 kB steps
+   or better, or RAM on huge pages, fall back to the page hashes and copy
+   the pages while the checkpoint is taken.
+
+   Checkpoints are taken between two CPU frames, when only the emulation
+   thread writes to RAM. */
+#define RAM_COW_NONE    0 /* Not held by the checkpoint being written */
+#define RAM_COW_PENDING 1
+#define RAM_COW_COPYING 2
+#define RAM_COW_DONE    3
+
+static void
+mem_cow_copy(uint32_t page)
+{
+    unsigned char state = RAM_COW_PENDING;
+
+    if (atomic_compare_exchange_strong(&ram_cow_state[page], &state, RAM_COW_COPYING)) {
+        memcpy(&ram_cow_buf[ram_cow_off[page]], &ram[(size_t) page << 12], mem_page_len(page));
+        atomic_store_explicit(&ram_cow_state[page], RAM_COW_DONE, memory_order_release);
+    } else {
+        while (atomic_load_explicit(&ram_cow_state[page], memory_order_acquire) == RAM_COW_COPYING)
+            ;
+    }
+}
+
+/* Called from the host fault handler, on whatever thread did the write. */
+static int
+mem_wp_fault(void *addr)
+{
+    size_t off;
+
+    if (!ram_wp_armed || ((uint8_t *) addr < ram) || ((uint8_t *) addr >= (ram + ram_size)))
+        return 0;
+
+    off = ((size_t) ((uint8_t *) addr - ram)) & ~(ram_wp_page - 1);
+    for (uint32_t page = (uint32_t) (off >> 12); page < (uint32_t) ((off + ram_wp_page) >> 12); page++) {
+        if (ram_cow_buf != NULL)
+            mem_cow_copy(page);
+        ram_wp_dirty[page] = 1;
+    }
+
+    return mem_protect(&ram[off], ram_wp_page, 1);
+}
+
+/* Settles whether RAM can be write protected, once per allocation. */
+static int
+mem_wp_available(void)
+{
+    size_t page;
+
+    if (ram_wp_page != 0)
+        return (ram_wp_page != (size_t) -1);
+
+    page        = mem_protect_page_size();
+    ram_wp_page = (size_t) -1;
+
+    if (ram_large || (page < 4096) || (page & (page - 1)) || (ram_size & (page - 1)) || !mem_protect_init(mem_wp_fault))
+        return 0;
+
+    ram_wp_dirty  = (uint8_t *) calloc(mem_page_count(), 1);
+    ram_cow_state = (atomic_uchar *) calloc(mem_page_count(), sizeof(atomic_uchar));
+    ram_cow_off   = (size_t *) malloc(mem_page_count() * sizeof(size_t));
+    ram_cow_list  = (uint32_t *) malloc(mem_page_count() * sizeof(uint32_t));
+    if ((ram_wp_dirty == NULL) || (ram_cow_state == NULL) || (ram_cow_off == NULL) || (ram_cow_list == NULL)) {
+        free(ram_wp_dirty);
+        free((void *) ram_cow_state);
+        free(ram_cow_off);
+        free(ram_cow_list);
+        ram_wp_dirty  = NULL;
+        ram_cow_state = NULL;
+        ram_cow_off   = NULL;
+        ram_cow_list  = NULL;
+        return 0;
+    }
+
+    ram_wp_page = page;
+    mem_log("MEM: checkpoints write protect RAM in %" PRIu64 " byte pages\n", (uint64_t) page);
+
+    return 1;
+}
+
+/* Drops what the last checkpoint held, its writer must be done. */
+static void
+mem_cow_release(void)
+{
+    for (uint32_t c = 0; c < ram_cow_count; c++)
+        atomic_store_explicit(&ram_cow_state[ram_cow_list[c]], RAM_COW_NONE, memory_order_relaxed);
+
+    ram_cow_count = 0;
+    ram_cow_buf   = NULL;
+}
+
+/* Before RAM is written in bulk: the checkpoint being written gets the
+   pages it still holds, and the next one has to be a full one. */
+static void
+mem_wp_disarm(void)
+{
+    if (!ram_wp_armed)
+        return;
+
+    for (uint32_t c = 0; c < ram_cow_count; c++)
+        mem_cow_copy(ram_cow_list[c]);
+
+    ram_wp_armed = 0;
+    ram_wp_base  = 0;
+    mem_protect(ram, ram_size, 1);
+}
+
+/* Everything goes, the checkpoint writer must be done. */
+static void
+mem_wp_close(void)
+{
+    mem_wp_disarm();
+    if (ram_cow_state != NULL)
+        mem_cow_release();
+
+    free(ram_wp_dirty);
+    free((void *) ram_cow_state);
+    free(ram_cow_off);
+    free(ram_cow_list);
+    ram_wp_dirty  = NULL;
+    ram_cow_state = NULL;
+    ram_cow_off   = NULL;
+    ram_cow_list  = NULL;
+    ram_wp_page   = 0;
+}
+
+static void
+mem_cow_hold(snapshot_t *snap, uint32_t page)
+{
+    ram_cow_off[page]              = snapshot_reserve(snap, mem_page_len(page));
+    ram_cow_list[ram_cow_count++] = page;
+    atomic_store_explicit(&ram_cow_state[page], RAM_COW_PENDING, memory_order_relaxed);
+}
+
+/* Called before a checkpoint is built, with the writer of the last one done. */
+void
+mem_checkpoint_begin(void)
+{
+    if (ram_cow_state != NULL)
+        mem_cow_release();
+
+    ram_cow_defer = mem_wp_available();
+}
+
+/* Called once it is built, with the snapshot buffer, or NULL if it failed. */
+void
+mem_checkpoint_end(uint8_t *buf)
+{
+    if (!ram_cow_defer)
+        return;
+
+    ram_cow_defer = 0;
+
+    if (buf == NULL) {
+        mem_cow_release();
+        mem_wp_disarm();
+        ram_wp_base = 0;
+        return;
+    }
+
+    ram_cow_buf  = buf;
+    ram_wp_armed = mem_protect(ram, ram_size, 0);
+    ram_wp_base  = ram_wp_armed;
+    if (!ram_wp_armed) {
+        /* Nothing would protect the held pages, copy them now. */
+        for (uint32_t c = 0; c < ram_cow_count; c++)
+            mem_cow_copy(ram_cow_list[c]);
+    }
+}
+
+/* Called by the checkpoint writer thread, before the snapshot is written out. */
+void
+mem_checkpoint_fill(void)
+{
+    for (uint32_t c = 0; c < ram_cow_count; c++)
+        mem_cow_copy(ram_cow_list[c]);
+}
+
+int
+mem_can_save_delta(void)
+{
+    if (ram_cow_defer)
+        return ram_wp_base;
+
+    return (ram_page_hash != NULL);
+}
+
+/* RAM goes into snapshots in 1 MB groups of 4 kB pages, each group being a
+   bitmap followed by only the pages that are not all zeroes. The contents
+   of every page are hashed on the way, for the deltas of later checkpoints,
+   unless a copy-on-write checkpoint is being taken. */
+void
+mem_save_state(snapshot_t *snap)
+{
+    uint64_t size = ram_size;
+    uint8_t  map[32];
+    size_t   len;
+
+    if (ram_cow_defer)
+        memset(ram_wp_dirty, 0x00, mem_page_count());
+    else if (ram_page_hash == NULL)
+        ram_page_hash = (uint64_t *) malloc(mem_page_count() * sizeof(uint64_t));
+
+    snapshot_write_var(snap, size);
+    snapshot_write_var(snap, mem_a20_key);
+    snapshot_write_var(snap, mem_a20_alt);
+
+    for (size_t base = 0; base < ram_size; base += (1 << 20)) {
+        memset(map, 0x00, sizeof(map));
+        for (uint32_t c = 0; (c < 256) && ((base + (c << 12)) < ram_size); c++) {
+            len = MIN(4096, ram_size - (base + (c << 12)));
+            if (!mem_page_is_zero(&ram[base + (c << 12)], len))
+                map[c >> 3] |= (1 << (c & 7));
+            if (!ram_cow_defer && (ram_page_hash != NULL))
+                ram_page_hash[(base >> 12) + c] = mem_page_hash(&ram[base + (c << 12)], len);
+        }
+
+        snapshot_write_var(snap, map);
+        for (uint32_t c = 0; c < 256; c++) {
+            if (!(map[c >> 3] & (1 << (c & 7))))
+                continue;
+
+            if (ram_cow_defer)
+                mem_cow_hold(snap, (uint32_t) (base >> 12) + c);
+            else
+                snapshot_write(snap, &ram[base + (c << 12)], MIN(4096, ram_size - (base + (c << 12))));
+        }
+    }
+}
+
+int
+mem_load_state(snapshot_t *snap)
+{
+    uint64_t size;
+    uint8_t  map[32];
+    uint8_t *p;
+    size_t   len;
+
+    if (!snapshot_read_var(snap, size) || (size != ram_size)) {
+        pclog("Snapshot: RAM size mismatch\n");
+        return 0;
+    }
+
+    mem_wp_disarm();
+
+    snapshot_read_var(snap, mem_a20_key);
+    snapshot_read_var(snap, mem_a20_alt);
+
+    for (size_t base = 0; base < ram_size; base += (1 << 20)) {
+        if (!snapshot_read_var(snap, map))
+            return 0;
+
+        for (uint32_t c = 0; (c < 256) && ((base + (c << 12)) < ram_size); c++) {
+            p   = &ram[base + (c << 12)];
+            len = MIN(4096, ram_size - (base + (c << 12)));
+            if (map[c >> 3] & (1 << (c & 7))) {
+                if (!snapshot_read(snap, p, len))
+                    return 0;
+            } else if (!mem_page_is_zero(p, len)) {
+                /* Pages that were never touched stay unbacked. */
+                memset(p, 0x00, len);
+            }
+        }
+    }
+
+    mem_page_hash_reset();
+
+    /* Force the A20 mask to be recalculated from the restored gates. */
+    mem_a20_state = !(mem_a20_key | mem_a20_alt);
+    mem_a20_recalc();
+
+    return 1;
+}
+
+/* Only the pages that changed since the last checkpoint: the ones that took
+   a write fault, or else the ones whose hashes changed. Writes reach RAM
+   through the page tables, the lookup tables and bus master DMA alike, and
+   the page dirty masks belong to the recompiler. */
+void
+mem_save_state_delta(snapshot_t *snap)
+{
+    uint64_t size  = ram_size;
+    uint32_t count = mem_page_count();
+    uint32_t end   = 0xffffffff;
+    uint64_t h;
+
+    snapshot_write_var(snap, size);
+    snapshot_write_var(snap, mem_a20_key);
+    snapshot_write_var(snap, mem_a20_alt);
+
+    for (uint32_t c = 0; c < count; c++) {
+        if (ram_cow_defer) {
+            if (!ram_wp_dirty[c])
+                continue;
+
+            ram_wp_dirty[c] = 0;
+            snapshot_write_var(snap, c);
+            mem_cow_hold(snap, c);
+            continue;
+        }
+
+        h = mem_page_hash(&ram[(size_t) c << 12], mem_page_len(c));
+        if (h != ram_page_hash[c]) {
+            ram_page_hash[c] = h;
+            snapshot_write_var(snap, c);
+            snapshot_write(snap, &ram[(size_t) c << 12], mem_page_len(c));
+        }
+    }
+
+    snapshot_write_var(snap, end);
+}
+
+/* Applied on top of the RAM of the checkpoint the delta was taken against. */
+int
+mem_load_state_delta(snapshot_t *snap)
+{
+    uint64_t size;
+    uint32_t page;
+
+    if (!snapshot_read_var(snap, size) || (size != ram_size)) {
+        pclog("Snapshot: RAM size mismatch\n");
+        return 0;
+    }
+
+    mem_wp_disarm();
+
+    snapshot_read_var(snap, mem_a20_key);
+    snapshot_read_var(snap, mem_a20_alt);
+
+    while (snapshot_read_var(snap, page) && (page != 0xffffffff)) {
+        if ((page >= mem_page_count()) || !snapshot_read(snap, &ram[(size_t) page << 12], mem_page_len(page)))
+            return 0;
+    }
+    if (page != 0xffffffff)
+        return 0;
+
+    mem_page_hash_reset();
+
+    mem_a20_state = !(mem_a20_key | mem_a20_alt);
+    mem_a20_recalc();
+
+    return 1;
+}
+
 /* Reset the memory state. */
 void
 mem_reset(void)
@@ -2771,22 +3650,35 @@ mem_reset(void)
         pages = NULL;
     }
 
+    /* The checkpoint writer is done by now, see pc_reset_hard_init(). */
+    mem_wp_close();
+
     if (ram != NULL) {
-        plat_munmap(ram, ram_size);
+        if (ram_large)
+            plat_munmap_large(ram, ram_size + 16);
+        else
+            plat_munmap(ram, ram_size);
         ram      = NULL;
         ram_size = 0;
     }
+    mem_page_hash_reset();
 
     m = 1024UL * (size_t) mem_size;
 
     ram_size = m;
     /* Allocate 16 extra bytes of RAM to mitigate some dynarec recompiler memory access quirks. */
-    ram      = (uint8_t *) plat_mmap(ram_size + 16, 0); /* allocate and clear the RAM block */
+    ram_large = mem_huge_pages;
+    if (ram_large)
+        ram = (uint8_t *) plat_mmap_large(ram_size + 16, 0, "Guest RAM");
+    else
+        ram = (uint8_t *) plat_mmap(ram_size + 16, 0); /* allocate and clear the RAM block */
     if (ram == NULL) {
         fatal("Failed to allocate RAM block. Make sure you have enough RAM available.\n");
         return;
     }
-    memset(ram, 0x00, ram_size + 16);
+    /* Fresh anonymous mappings read as zero and are only backed by host memory
+       once written, so do not clear the block here - that would commit all of
+       it up front, however little of it the guest actually uses. */
 
     /*
      * Allocate the page table based on how much RAM we have.
@@ -2822,11 +3714,9 @@ mem_reset(void)
     memset(pages, 0x00, pages_sz * sizeof(page_t));
 
 #ifdef USE_NEW_DYNAREC
-    byte_dirty_mask = malloc((mem_size * 1024) / 8);
-    memset(byte_dirty_mask, 0, (mem_size * 1024) / 8);
-
-    byte_code_present_mask = malloc((mem_size * 1024) / 8);
-    memset(byte_code_present_mask, 0, (mem_size * 1024) / 8);
+    /* Same as above, calloc() of blocks this size gets zeroed pages on demand. */
+    byte_dirty_mask        = calloc(1, (mem_size * 1024) / 8);
+    byte_code_present_mask = calloc(1, (mem_size * 1024) / 8);
 #endif
 
     for (uint32_t c = 0; c < pages_sz; c++) {
@@ -3131,12 +4021,12 @@ mem_a20_recalc(void)
         rammask = cpu_16bitbus ? 0xffffff : 0xffffffff;
         if (is6117)
             rammask |= 0x03000000;
-        flushmmucache();
+        flushmmucache_a20();
     } else if (!state && mem_a20_state) {
         rammask = cpu_16bitbus ? 0xefffff : 0xffefffff;
         if (is6117)
             rammask |= 0x03000000;
-        flushmmucache();
+        flushmmucache_a20();
     }
 
     mem_a20_state = state;
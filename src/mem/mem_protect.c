@@ -0,0 +1,165 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Host page write protection, for the copy-on-write RAM of
+ *          checkpoints.
+ *
+ *          A write to a protected page is handed to the fault callback,
+ *          which returns non-zero once it has dealt with it (in practice:
+ *          made the page writable again), and the write is then retried.
+ *          Faults the callback does not claim go on to whatever handled
+ *          them before.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <stddef.h>
+#include <stdint.h>
+#ifdef _WIN32
+#    include <windows.h>
+#    define MEM_PROTECT_WIN32
+#elif defined(__unix__) || defined(__APPLE__)
+#    include <signal.h>
+#    include <string.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#    define MEM_PROTECT_POSIX
+#endif
+#include <86box/mem.h>
+#include <86box/plat_unused.h>
+
+static int (*mem_protect_fault)(void *addr) = NULL;
+
+#if defined(MEM_PROTECT_WIN32)
+static LONG CALLBACK
+mem_protect_exception(PEXCEPTION_POINTERS ep)
+{
+    PEXCEPTION_RECORD rec = ep->ExceptionRecord;
+
+    /* ExceptionInformation[0] is 1 for a write, [1] is the address. */
+    if ((rec->ExceptionCode == EXCEPTION_ACCESS_VIOLATION) && (rec->NumberParameters >= 2) &&
+        (rec->ExceptionInformation[0] == 1) && mem_protect_fault((void *) rec->ExceptionInformation[1]))
+        return EXCEPTION_CONTINUE_EXECUTION;
+
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+
+size_t
+mem_protect_page_size(void)
+{
+    SYSTEM_INFO si;
+
+    GetSystemInfo(&si);
+
+    return (size_t) si.dwPageSize;
+}
+
+int
+mem_protect_init(int (*fault)(void *addr))
+{
+    if (mem_protect_fault != NULL)
+        return 1;
+
+    mem_protect_fault = fault;
+    if (AddVectoredExceptionHandler(1, mem_protect_exception) == NULL) {
+        mem_protect_fault = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+int
+mem_protect(void *ptr, size_t size, int writable)
+{
+    DWORD old;
+
+    return VirtualProtect(ptr, size, writable ? PAGE_READWRITE : PAGE_READONLY, &old) != 0;
+}
+#elif defined(MEM_PROTECT_POSIX)
+static struct sigaction mem_protect_old_segv;
+static struct sigaction mem_protect_old_bus;
+
+/* Some hosts (macOS among them) raise SIGBUS rather than SIGSEGV for a
+   write to a read-only page. */
+static void
+mem_protect_signal(int sig, siginfo_t *info, void *ctx)
+{
+    struct sigaction *old = (sig == SIGBUS) ? &mem_protect_old_bus : &mem_protect_old_segv;
+
+    if (mem_protect_fault(info->si_addr))
+        return;
+
+    if (old->sa_flags & SA_SIGINFO)
+        old->sa_sigaction(sig, info, ctx);
+    else if ((old->sa_handler != SIG_DFL) && (old->sa_handler != SIG_IGN))
+        old->sa_handler(sig);
+    else {
+        /* The access faults again on return, this time with the default action. */
+        sigaction(sig, old, NULL);
+    }
+}
+
+size_t
+mem_protect_page_size(void)
+{
+    long size = sysconf(_SC_PAGESIZE);
+
+    return (size > 0) ? (size_t) size : 0;
+}
+
+int
+mem_protect_init(int (*fault)(void *addr))
+{
+    struct sigaction sa;
+
+    if (mem_protect_fault != NULL)
+        return 1;
+
+    memset(&sa, 0x00, sizeof(sa));
+    sa.sa_sigaction = mem_protect_signal;
+    sa.sa_flags     = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+
+    mem_protect_fault = fault;
+    if (sigaction(SIGSEGV, &sa, &mem_protect_old_segv) != 0) {
+        mem_protect_fault = NULL;
+        return 0;
+    }
+    if (sigaction(SIGBUS, &sa, &mem_protect_old_bus) != 0) {
+        sigaction(SIGSEGV, &mem_protect_old_segv, NULL);
+        mem_protect_fault = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+int
+mem_protect(void *ptr, size_t size, int writable)
+{
+    return mprotect(ptr, size, PROT_READ | (writable ? PROT_WRITE : 0)) == 0;
+}
+#else
+size_t
+mem_protect_page_size(void)
+{
+    return 0;
+}
+
+int
+mem_protect_init(UNUSED(int (*fault)(void *addr)))
+{
+    return 0;
+}
+
+int
+mem_protect(UNUSED(void *ptr), UNUSED(size_t size), UNUSED(int writable))
+{
+    return 0;
+}
+#endif
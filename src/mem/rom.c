@@ -799,6 +799,13 @@ bios_load_linear_combined2_ex(const char *fn1, const char *fn2, const char *fn3,
         (!fn5 || bios_load_aux_linear(fn5, 0x000fc000, 16384, 0));
 }
 
+/*
+ * The image buffers stay private heap copies rather than mappings of the
+ * files: they are padded with 0xff past the end of short images, loaded at
+ * an offset or interleaved from several chips, patched in place by devices
+ * (EGA byte swapping, Bochs VBE, checksum fixups) and free()d by some of
+ * them. At a few hundred KB per machine the copy is not worth sharing.
+ */
 int
 rom_init(rom_t *rom, const char *fn, uint32_t addr, int sz, int mask, int off, uint32_t flags)
 {
@@ -152,6 +152,10 @@ smram_recalc_all(int ret)
     if (base_smram == NULL)
         return;
 
+    /* The old and new ranges usually coincide, so let the batch recalculate
+       each granule once, and flush the MMU cache only once below. */
+    mem_mapping_batch_begin();
+
     if (ret) {
         while (temp_smram != NULL) {
             if (temp_smram->old_size != 0x00000000)
@@ -173,6 +177,8 @@ smram_recalc_all(int ret)
         temp_smram = next;
     }
 
+    mem_mapping_batch_commit();
+
     flushmmucache();
 }
 
@@ -42,6 +42,7 @@ typedef struct sst_t {
     int command_state;
     int id_mode;
     int dirty;
+    int lookups;
 
     uint32_t size;
     uint32_t mask;
@@ -142,6 +143,28 @@ static char flash_path[1024];
 #define SIZE_8M     0x100000
 #define SIZE_16M    0x200000
 
+/* Outside of ID mode the array is plain memory, so let the CPU read the page
+   straight from it until ID mode is entered. Writes still come here. */
+static void
+sst_add_readlookup(sst_t *dev, uint32_t addr)
+{
+    if (cpu_use_exec && !dev->id_mode) {
+        mem_add_host_readlookup(mem_logical_addr, &dev->array[(addr - biosaddr) & ~0xfff]);
+        dev->lookups = 1;
+    }
+}
+
+static void
+sst_set_id_mode(sst_t *dev)
+{
+    if (!dev->id_mode && dev->lookups) {
+        flushmmucache_nopc();
+        dev->lookups = 0;
+    }
+
+    dev->id_mode = 1;
+}
+
 static void
 sst_sector_erase(sst_t *dev, uint32_t addr)
 {
@@ -194,6 +217,7 @@ sst_new_command(sst_t *dev, uint32_t addr, uint8_t val)
                     size -= 0x2000;
 
                 memset(&(dev->array[base]), 0xff, size);
+                dev->dirty         = 1;
                 dev->command_state = 0;
                 break;
 
@@ -210,7 +234,7 @@ sst_new_command(sst_t *dev, uint32_t addr, uint8_t val)
                 break;
 
             case SST_SET_ID_MODE_ALT:
-                dev->id_mode       = 1;
+                sst_set_id_mode(dev);
                 dev->command_state = 0;
                 break;
 
@@ -225,7 +249,7 @@ sst_new_command(sst_t *dev, uint32_t addr, uint8_t val)
                 break;
 
             case SST_SET_ID_MODE:
-                dev->id_mode       = 1;
+                sst_set_id_mode(dev);
                 dev->command_state = 0;
                 break;
 
@@ -413,16 +437,18 @@ sst_write(uint32_t addr, uint8_t val, void *priv)
 static uint8_t
 sst_read(uint32_t addr, void *priv)
 {
-    const sst_t  *dev = (sst_t *) priv;
-    uint8_t       ret = 0xff;
+    sst_t  *dev = (sst_t *) priv;
+    uint8_t ret = 0xff;
 
     addr &= 0x000fffff;
 
     if (dev->id_mode)
         ret = sst_read_id(addr, priv);
     else {
-        if ((addr >= biosaddr) && (addr <= (biosaddr + biosmask)))
+        if ((addr >= biosaddr) && (addr <= (biosaddr + biosmask))) {
             ret = dev->array[addr - biosaddr];
+            sst_add_readlookup(dev, addr);
+        }
     }
 
     return ret;
@@ -439,8 +465,10 @@ sst_readw(uint32_t addr, void *priv)
     if (dev->id_mode)
         ret = sst_read(addr, priv) | (sst_read(addr + 1, priv) << 8);
     else {
-        if ((addr >= biosaddr) && (addr <= (biosaddr + biosmask)))
+        if ((addr >= biosaddr) && (addr <= (biosaddr + biosmask))) {
             ret = *(uint16_t *) &dev->array[addr - biosaddr];
+            sst_add_readlookup(dev, addr);
+        }
     }
 
     return ret;
@@ -457,8 +485,10 @@ sst_readl(uint32_t addr, void *priv)
     if (dev->id_mode)
         ret = sst_readw(addr, priv) | (sst_readw(addr + 2, priv) << 16);
     else {
-        if ((addr >= biosaddr) && (addr <= (biosaddr + biosmask)))
+        if ((addr >= biosaddr) && (addr <= (biosaddr + biosmask))) {
             ret = *(uint32_t *) &dev->array[addr - biosaddr];
+            sst_add_readlookup(dev, addr);
+        }
     }
 
     return ret;
@@ -429,29 +429,29 @@ modem_data_mode_process_byte(modem_t *modem, uint8_t data)
 static void
 host_to_modem_cb(void *priv)
 {
-    modem_t *modem = (modem_t *) priv;
+    modem_t       *modem = (modem_t *) priv;
+    Fifo8         *fifo  = NULL;
+    const uint8_t *buf;
+    uint32_t       avail;
+    int            n     = 0;
 
     if (modem->in_warmup || (modem->serial == NULL))
         goto no_write_to_machine;
 
-    if ((modem->serial->type >= SERIAL_16550) && modem->serial->fifo_enabled) {
-        if (fifo_get_full(modem->serial->rcvr_fifo)) {
-            goto no_write_to_machine;
-        }
-    } else {
-        if (modem->serial->lsr & 1) {
-            goto no_write_to_machine;
-        }
-    }
-
     if (!((modem->serial->mctrl & 2) || modem->flowcontrol != 3))
         goto no_write_to_machine;
 
-    if (modem->mode == MODEM_MODE_DATA && fifo8_num_used(&modem->rx_data) && !modem->cooldown) {
-        serial_write_fifo(modem->serial, fifo8_pop(&modem->rx_data));
-    } else if (fifo8_num_used(&modem->data_pending)) {
-        uint8_t val = fifo8_pop(&modem->data_pending);
-        serial_write_fifo(modem->serial, val);
+    if (modem->mode == MODEM_MODE_DATA && fifo8_num_used(&modem->rx_data) && !modem->cooldown)
+        fifo = &modem->rx_data;
+    else if (fifo8_num_used(&modem->data_pending))
+        fifo = &modem->data_pending;
+
+    /* Fill the receiver FIFO as far as it goes, then wait for as many
+       character times before the next batch. */
+    if (fifo != NULL) {
+        buf = fifo8_peek_bufptr(fifo, fifo8_num_used(fifo), &avail);
+        n   = serial_write_fifo_buf(modem->serial, buf, avail);
+        fifo8_drop(fifo, n);
     }
 
     if (fifo8_num_used(&modem->data_pending) == 0) {
@@ -459,7 +459,7 @@ host_to_modem_cb(void *priv)
     }
 
 no_write_to_machine:
-    timer_on_auto(&modem->host_to_serial_timer, (1000000.0 / (double) modem->baudrate) * (double) 9);
+    timer_on_auto(&modem->host_to_serial_timer, (1000000.0 / (double) modem->baudrate) * (double) 9 * (double) MAX(n, 1));
 }
 
 static void
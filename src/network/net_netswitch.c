@@ -208,13 +208,55 @@ maintenance_timer(void *priv)
     timer_on_auto(&netswitch->maintenance_timer, SWITCH_KEEPALIVE_INTERVAL);
 }
 
+static void
+net_netswitch_rx(net_netswitch_t *net_netswitch, const char *switch_type)
+{
+    /* A datagram is available for reading */
+    const bool status = ns_recv_pb(net_netswitch->nsconn, &net_netswitch->rx_packet, NET_MAX_FRAME, 0);
+    if (!status) {
+        net_switch_log("Receive packet failed. Skipping.\n");
+        return;
+    }
+
+    /* These types are handled in the backend and don't need to be considered */
+    if (is_control_packet(&net_netswitch->rx_packet) || is_fragment_packet(&net_netswitch->rx_packet)) {
+        return;
+    }
+    data_packet_info_t packet_info = get_data_packet_info(&net_netswitch->rx_packet.pkt, net_netswitch->mac_addr);
+#if defined(NET_PRINT_PACKET_RX) || defined(NET_PRINT_PACKET_ALL)
+    print_packet(net_netswitch->rx_packet.pkt);
+#endif
+    /*
+     * Accept packets that are
+       * Unicast for us
+       * Broadcasts that are not from us
+       * All other packets *if* promiscuous mode is enabled (excluding our own)
+     */
+    if (packet_info.is_packet_for_me || (packet_info.is_broadcast && !packet_info.is_packet_from_me)) {
+        /* Temporarily disable log suppression for packet logging */
+        pclog_toggle_suppr();
+        net_switch_log("%s Net Switch: RX: %s\n", switch_type, packet_info.printable);
+        pclog_toggle_suppr();
+        network_rx_put_pkt(net_netswitch->card, &net_netswitch->rx_packet.pkt);
+    } else if (packet_info.is_packet_from_me) {
+        net_switch_log("%s Net Switch: Got my own packet... ignoring\n", switch_type);
+    } else {
+        /* Not our packet. Pass it along if promiscuous mode is enabled. */
+        if (ns_flags(net_netswitch->nsconn) & FLAGS_PROMISC) {
+            net_switch_log("%s Net Switch: Got packet from %s (not mine, promiscuous is set, getting)\n", switch_type, packet_info.src_mac_h);
+            network_rx_put_pkt(net_netswitch->card, &net_netswitch->rx_packet.pkt);
+        } else {
+            net_switch_log("%s Net Switch: RX: %s (not mine, dest %s != %s, promiscuous not set, ignoring)\n", switch_type, packet_info.printable, packet_info.dest_mac_h, packet_info.my_mac_h);
+        }
+    }
+}
+
 /* Lots of #ifdef madness here thanks to the polling differences on windows */
 static void
 net_netswitch_thread(void *priv)
 {
     net_netswitch_t *net_netswitch = (net_netswitch_t *) priv;
     NSCONN         *nsconn        = (NSCONN *) net_netswitch->nsconn;
-    bool status;
     char switch_type[32];
     snprintf(switch_type, sizeof(switch_type), "%s", nsconn->switch_type == SWITCH_TYPE_REMOTE ? "Remote" : "Local");
 
@@ -266,29 +308,34 @@ net_netswitch_thread(void *priv)
 #endif
                 net_event_clear(&net_netswitch->tx_event);
 
-                const int packets = network_tx_popv(net_netswitch->card, net_netswitch->pktv, SWITCH_PKT_BATCH);
-                if (packets > nsconn->stats.max_vec) {
-                    nsconn->stats.max_vec = packets;
-                }
-                for (int i = 0; i < packets; i++) {
-                    //                net_switch_log("%d packet(s) to send\n", packets);
+                /* Drain the queue, the datagrams go out in batches */
+                int packets;
+                do {
+                    packets = network_tx_popv(net_netswitch->card, net_netswitch->pktv, SWITCH_PKT_BATCH);
+                    if (packets > nsconn->stats.max_vec) {
+                        nsconn->stats.max_vec = packets;
+                    }
+                    for (int i = 0; i < packets; i++) {
+                        //                net_switch_log("%d packet(s) to send\n", packets);
 #if defined(NET_PRINT_PACKET_TX) || defined(NET_PRINT_PACKET_ALL)
-                    data_packet_info_t packet_info = get_data_packet_info(&net_netswitch->pktv[i], net_netswitch->mac_addr);
-                    /* Temporarily disable log suppression for packet logging */
-                    pclog_toggle_suppr();
-                    net_switch_log("%s Net Switch: TX: %s\n", switch_type, packet_info.printable);
-                    pclog_toggle_suppr();
-                    print_packet(net_netswitch->pktv[i]);
+                        data_packet_info_t packet_info = get_data_packet_info(&net_netswitch->pktv[i], net_netswitch->mac_addr);
+                        /* Temporarily disable log suppression for packet logging */
+                        pclog_toggle_suppr();
+                        net_switch_log("%s Net Switch: TX: %s\n", switch_type, packet_info.printable);
+                        pclog_toggle_suppr();
+                        print_packet(net_netswitch->pktv[i]);
 #endif
-                    /* Only send if we're in a connected state (always true for local) */
-                    if(ns_connected(net_netswitch->nsconn)) {
-                        const ssize_t nc = ns_send_pb(net_netswitch->nsconn, &net_netswitch->pktv[i], 0);
-                        if (nc < 1) {
-                            perror("Got");
-                            net_switch_log("%s Net Switch: Problem, no bytes sent. Got back %i\n", switch_type, nc);
+                        /* Only send if we're in a connected state (always true for local) */
+                        if(ns_connected(net_netswitch->nsconn)) {
+                            const ssize_t nc = ns_send_frame(net_netswitch->nsconn, &net_netswitch->pktv[i]);
+                            if (nc < 1) {
+                                perror("Got");
+                                net_switch_log("%s Net Switch: Problem, no bytes sent. Got back %i\n", switch_type, nc);
+                            }
                         }
                     }
-                }
+                } while (packets == SWITCH_PKT_BATCH);
+                ns_send_flush(nsconn);
 #ifdef _WIN32
                 break;
             case NET_EVENT_RX:
@@ -297,43 +344,9 @@ net_netswitch_thread(void *priv)
         if (pfd[NET_EVENT_RX].revents & POLLIN) {
 #endif
 
-                /* Packets are available for reading */
-                status = ns_recv_pb(net_netswitch->nsconn, &net_netswitch->rx_packet, NET_MAX_FRAME, 0);
-                if (!status) {
-                    net_switch_log("Receive packet failed. Skipping.\n");
-                    continue;
-                }
-
-                /* These types are handled in the backend and don't need to be considered */
-                if (is_control_packet(&net_netswitch->rx_packet) || is_fragment_packet(&net_netswitch->rx_packet)) {
-                    continue;
-                }
-                data_packet_info_t packet_info = get_data_packet_info(&net_netswitch->rx_packet.pkt, net_netswitch->mac_addr);
-#if defined(NET_PRINT_PACKET_RX) || defined(NET_PRINT_PACKET_ALL)
-                print_packet(net_netswitch->rx_packet.pkt);
-#endif
-                /*
-                 * Accept packets that are
-                   * Unicast for us
-                   * Broadcasts that are not from us
-                   * All other packets *if* promiscuous mode is enabled (excluding our own)
-                 */
-                if (packet_info.is_packet_for_me || (packet_info.is_broadcast && !packet_info.is_packet_from_me)) {
-                    /* Temporarily disable log suppression for packet logging */
-                    pclog_toggle_suppr();
-                    net_switch_log("%s Net Switch: RX: %s\n", switch_type, packet_info.printable);
-                    pclog_toggle_suppr();
-                    network_rx_put_pkt(net_netswitch->card, &net_netswitch->rx_packet.pkt);
-                } else if (packet_info.is_packet_from_me) {
-                    net_switch_log("%s Net Switch: Got my own packet... ignoring\n", switch_type);
-                } else {
-                    /* Not our packet. Pass it along if promiscuous mode is enabled. */
-                    if (ns_flags(net_netswitch->nsconn) & FLAGS_PROMISC) {
-                        net_switch_log("%s Net Switch: Got packet from %s (not mine, promiscuous is set, getting)\n", switch_type, packet_info.src_mac_h);
-                        network_rx_put_pkt(net_netswitch->card, &net_netswitch->rx_packet.pkt);
-                    } else {
-                        net_switch_log("%s Net Switch: RX: %s (not mine, dest %s != %s, promiscuous not set, ignoring)\n", switch_type, packet_info.printable, packet_info.dest_mac_h, packet_info.my_mac_h);
-                    }
+                /* Decode everything that arrived since the last wakeup */
+                for (int i = ns_recv_batch(nsconn); i > 0; i--) {
+                    net_netswitch_rx(net_netswitch, switch_type);
                 }
 #ifdef _WIN32
                 break;
@@ -372,6 +385,12 @@ net_netswitch_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, c
         if(netcard->promisc_mode) {
             flags |= FLAGS_PROMISC;
         }
+        /* Every 86Box on the group must understand it, so it's opt-in */
+        if(netcard->switch_framing == NET_SWITCH_FRAMING_COMPACT) {
+            flags |= FLAGS_COMPACT;
+        } else if(netcard->switch_framing == NET_SWITCH_FRAMING_COMPRESSED) {
+            flags |= FLAGS_COMPACT | FLAGS_COMPRESS;
+        }
     } else {
         net_switch_log("Failed: Unknown net switch type %d\n", net_type);
         return NULL;
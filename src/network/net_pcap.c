@@ -282,17 +282,23 @@ net_pcap_thread(void *priv)
 
             case NET_EVENT_TX:
                 net_event_clear(&pcap->tx_event);
-                int packets = network_tx_popv(pcap->card, pcap->pktv, PCAP_PKT_BATCH);
-                for (int i = 0; i < packets; i++) {
-                    h.caplen = pcap->pktv[i].len;
-                    f_pcap_sendqueue_queue(pcap->pcap_queue, &h, pcap->pktv[i].data);
-                }
-                f_pcap_sendqueue_transmit(pcap->pcap, pcap->pcap_queue, 0);
-                pcap->pcap_queue->len = 0;
+                /* One send queue transmission per batch, until the queue is drained. */
+                int packets;
+                do {
+                    packets = network_tx_popv(pcap->card, pcap->pktv, PCAP_PKT_BATCH);
+                    for (int i = 0; i < packets; i++) {
+                        h.caplen = h.len = pcap->pktv[i].len;
+                        f_pcap_sendqueue_queue(pcap->pcap_queue, &h, pcap->pktv[i].data);
+                    }
+                    if (packets > 0)
+                        f_pcap_sendqueue_transmit(pcap->pcap, pcap->pcap_queue, 0);
+                    pcap->pcap_queue->len = 0;
+                } while (packets == PCAP_PKT_BATCH);
                 break;
 
             case NET_EVENT_RX:
-                f_pcap_dispatch(pcap->pcap, PCAP_PKT_BATCH, net_pcap_rx_handler, (unsigned char *) pcap);
+                /* Everything in the current capture buffer at once. */
+                f_pcap_dispatch(pcap->pcap, -1, net_pcap_rx_handler, (unsigned char *) pcap);
                 break;
 
             default:
@@ -332,14 +338,19 @@ net_pcap_thread(void *priv)
         if (pfd[NET_EVENT_TX].revents & POLLIN) {
             net_event_clear(&pcap->tx_event);
 
-            int packets = network_tx_popv(pcap->card, pcap->pktv, PCAP_PKT_BATCH);
-            for (int i = 0; i < packets; i++) {
-                net_pcap_in(pcap->pcap, pcap->pktv[i].data, pcap->pktv[i].len);
-            }
+            int packets;
+            do {
+                packets = network_tx_popv(pcap->card, pcap->pktv, PCAP_PKT_BATCH);
+                for (int i = 0; i < packets; i++) {
+                    net_pcap_in(pcap->pcap, pcap->pktv[i].data, pcap->pktv[i].len);
+                }
+            } while (packets == PCAP_PKT_BATCH);
         }
 
         if (pfd[NET_EVENT_RX].revents & POLLIN) {
-            f_pcap_dispatch(pcap->pcap, PCAP_PKT_BATCH, net_pcap_rx_handler, (unsigned char *) pcap);
+            /* Everything in the current capture buffer (a TPACKET_V3 block on
+               Linux) at once. */
+            f_pcap_dispatch(pcap->pcap, -1, net_pcap_rx_handler, (unsigned char *) pcap);
         }
     }
 
@@ -518,7 +529,8 @@ net_pcap_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, char *
     }
 
 #ifdef _WIN32
-    pcap->pcap_queue = f_pcap_sendqueue_alloc(PCAP_PKT_BATCH * NET_MAX_FRAME);
+    /* Every queued packet is preceded by its header. */
+    pcap->pcap_queue = f_pcap_sendqueue_alloc(PCAP_PKT_BATCH * (NET_MAX_FRAME + sizeof(struct pcap_pkthdr)));
 #endif
 
     for (int i = 0; i < PCAP_PKT_BATCH; i++) {
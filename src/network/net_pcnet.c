@@ -439,7 +439,8 @@ pcnetIsLinkUp(nic_t *dev)
 
 /**
  * Load transmit message descriptor
- * Make sure we read the own flag first.
+ * The whole descriptor is fetched in one read, so the own flag and the
+ * rest of the fields always come from the same snapshot.
  *
  * @param pThis         adapter private data
  * @param addr          physical address of the descriptor
@@ -449,43 +450,30 @@ pcnetIsLinkUp(nic_t *dev)
 static __inline int
 pcnetTmdLoad(nic_t *dev, TMD *tmd, uint32_t addr, int fRetIfNotOwn)
 {
-    uint8_t  ownbyte;
-    uint8_t  bytes[4] = { 0, 0, 0, 0 };
     uint16_t xda[4];
     uint32_t xda32[4];
 
     if (BCR_SWSTYLE(dev) == 0) {
-        dma_bm_read(addr, (uint8_t *) bytes, 4, dev->transfer_size);
-        ownbyte = bytes[3];
-        if (!(ownbyte & 0x80) && fRetIfNotOwn)
-            return 0;
         dma_bm_read(addr, (uint8_t *) &xda[0], sizeof(xda), dev->transfer_size);
+        if (!(xda[1] & 0x8000) && fRetIfNotOwn)
+            return 0;
         ((uint32_t *) tmd)[0] = (uint32_t) xda[0] | ((uint32_t) (xda[1] & 0x00ff) << 16);
         ((uint32_t *) tmd)[1] = (uint32_t) xda[2] | ((uint32_t) (xda[1] & 0xff00) << 16);
         ((uint32_t *) tmd)[2] = (uint32_t) xda[3] << 16;
         ((uint32_t *) tmd)[3] = 0;
     } else if (BCR_SWSTYLE(dev) != 3) {
-        dma_bm_read(addr + 4, (uint8_t *) bytes, 4, dev->transfer_size);
-        ownbyte = bytes[3];
-        if (!(ownbyte & 0x80) && fRetIfNotOwn)
-            return 0;
         dma_bm_read(addr, (uint8_t *) tmd, 16, dev->transfer_size);
-    } else {
-        dma_bm_read(addr + 4, (uint8_t *) bytes, 4, dev->transfer_size);
-        ownbyte = bytes[3];
-        if (!(ownbyte & 0x80) && fRetIfNotOwn)
+        if (!tmd->tmd1.own && fRetIfNotOwn)
             return 0;
+    } else {
         dma_bm_read(addr, (uint8_t *) &xda32[0], sizeof(xda32), dev->transfer_size);
+        if (!(xda32[1] & 0x80000000) && fRetIfNotOwn)
+            return 0;
         ((uint32_t *) tmd)[0] = xda32[2];
         ((uint32_t *) tmd)[1] = xda32[1];
         ((uint32_t *) tmd)[2] = xda32[0];
         ((uint32_t *) tmd)[3] = xda32[3];
     }
-    /* Double check the own bit; guest drivers might be buggy and lock prefixes in the recompiler are ignored by other threads. */
-    if (tmd->tmd1.own == 1 && !(ownbyte & 0x80))
-        pcnet_log(3, "%s: pcnetTmdLoad: own bit flipped while reading!!\n", dev->name);
-    if (!(ownbyte & 0x80))
-        tmd->tmd1.own = 0;
 
     return !!tmd->tmd1.own;
 }
@@ -533,7 +521,7 @@ pcnetTmdStorePassHost(nic_t *dev, TMD *tmd, uint32_t addr)
 
 /**
  * Load receive message descriptor
- * Make sure we read the own flag first.
+ * The whole descriptor is fetched in one read, like the transmit one.
  *
  * @param pThis         adapter private data
  * @param addr          physical address of the descriptor
@@ -543,44 +531,30 @@ pcnetTmdStorePassHost(nic_t *dev, TMD *tmd, uint32_t addr)
 static __inline int
 pcnetRmdLoad(nic_t *dev, RMD *rmd, uint32_t addr, int fRetIfNotOwn)
 {
-    uint8_t  ownbyte;
-    uint8_t  bytes[4] = { 0, 0, 0, 0 };
     uint16_t rda[4];
     uint32_t rda32[4];
 
     if (BCR_SWSTYLE(dev) == 0) {
-        dma_bm_read(addr, (uint8_t *) bytes, 4, dev->transfer_size);
-        ownbyte = bytes[3];
-        if (!(ownbyte & 0x80) && fRetIfNotOwn)
-            return 0;
         dma_bm_read(addr, (uint8_t *) &rda[0], sizeof(rda), dev->transfer_size);
+        if (!(rda[1] & 0x8000) && fRetIfNotOwn)
+            return 0;
         ((uint32_t *) rmd)[0] = (uint32_t) rda[0] | ((rda[1] & 0x00ff) << 16);
         ((uint32_t *) rmd)[1] = (uint32_t) rda[2] | ((rda[1] & 0xff00) << 16);
         ((uint32_t *) rmd)[2] = (uint32_t) rda[3];
         ((uint32_t *) rmd)[3] = 0;
     } else if (BCR_SWSTYLE(dev) != 3) {
-        dma_bm_read(addr + 4, (uint8_t *) bytes, 4, dev->transfer_size);
-        ownbyte = bytes[3];
-        if (!(ownbyte & 0x80) && fRetIfNotOwn)
-            return 0;
         dma_bm_read(addr, (uint8_t *) rmd, 16, dev->transfer_size);
-    } else {
-        dma_bm_read(addr + 4, (uint8_t *) bytes, 4, dev->transfer_size);
-        ownbyte = bytes[3];
-        if (!(ownbyte & 0x80) && fRetIfNotOwn)
+        if (!rmd->rmd1.own && fRetIfNotOwn)
             return 0;
+    } else {
         dma_bm_read(addr, (uint8_t *) &rda32[0], sizeof(rda32), dev->transfer_size);
+        if (!(rda32[1] & 0x80000000) && fRetIfNotOwn)
+            return 0;
         ((uint32_t *) rmd)[0] = rda32[2];
         ((uint32_t *) rmd)[1] = rda32[1];
         ((uint32_t *) rmd)[2] = rda32[0];
         ((uint32_t *) rmd)[3] = rda32[3];
     }
-    /* Double check the own bit; guest drivers might be buggy and lock prefixes in the recompiler are ignored by other threads. */
-    if (rmd->rmd1.own == 1 && !(ownbyte & 0x80))
-        pcnet_log(3, "%s: pcnetRmdLoad: own bit flipped while reading!!\n", dev->name);
-
-    if (!(ownbyte & 0x80))
-        rmd->rmd1.own = 0;
 
     return !!rmd->rmd1.own;
 }
@@ -1481,7 +1455,7 @@ pcnetAsyncTransmit(nic_t *dev)
      * Iterate the transmit descriptors.
      */
     unsigned cFlushIrq = 0;
-    int      cMax      = 32;
+    int      cMax      = MAX(CSR_XMTRL(dev), 32);
     do {
         TMD tmd;
         if (!pcnetTdtePoll(dev, &tmd))
@@ -1511,16 +1485,23 @@ pcnetAsyncTransmit(nic_t *dev)
                  * zero length if it is not the last one in the chain. */
                 if (cb <= MAX_FRAME) {
                     dev->xmit_pos = cb;
-                    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf, cb, dev->transfer_size);
 
                     if (fLoopback) {
+                        dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf, cb, dev->transfer_size);
+
                         if (HOST_IS_OWNER(CSR_CRST(dev)))
                             pcnetRdtePoll(dev);
 
                         pcnetReceiveNoSync(dev, dev->abLoopBuf, dev->xmit_pos);
-                    } else {
-                        pcnet_log(3, "%s: pcnetAsyncTransmit: transmit loopbuf stp and enp, xmit pos = %d\n", dev->name, dev->xmit_pos);
-                        network_tx(dev->netcard, dev->abLoopBuf, dev->xmit_pos);
+                    } else if (cb <= NET_MAX_FRAME) {
+                        /* A single buffer frame goes straight into the transmit queue. */
+                        uint8_t *buf = network_tx_buffer(dev->netcard);
+
+                        pcnet_log(3, "%s: pcnetAsyncTransmit: transmit stp and enp, xmit pos = %d\n", dev->name, dev->xmit_pos);
+                        if (buf != NULL) {
+                            dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), buf, cb, dev->transfer_size);
+                            network_tx_commit(dev->netcard, cb);
+                        }
                     }
                 } else if (cb == 4096) {
                     /* The Windows NT4 pcnet driver sometimes marks the first
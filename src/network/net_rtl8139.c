@@ -618,26 +618,28 @@ net_crc32(const uint8_t *p, int len)
     return crc;
 }
 
+/* Runs over every received frame, so go a byte at a time through a table. */
 uint32_t
 net_crc32_le(const uint8_t *p, int len)
 {
-    uint32_t crc;
-    int      carry;
-    uint8_t  b;
+    static uint32_t crc_le_table[256];
+    static int      crc_le_table_init = 0;
+    uint32_t        crc;
 
-    crc = 0xffffffff;
-    for (int i = 0; i < len; i++) {
-        b = *p++;
-        for (uint8_t j = 0; j < 8; j++) {
-            carry = (crc & 0x1) ^ (b & 0x01);
-            crc >>= 1;
-            b >>= 1;
-            if (carry) {
-                crc ^= 0xedb88320;
-            }
+    if (!crc_le_table_init) {
+        for (int i = 0; i < 256; i++) {
+            crc = i;
+            for (uint8_t j = 0; j < 8; j++)
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+            crc_le_table[i] = crc;
         }
+        crc_le_table_init = 1;
     }
 
+    crc = 0xffffffff;
+    for (int i = 0; i < len; i++)
+        crc = (crc >> 8) ^ crc_le_table[(crc ^ *p++) & 0xff];
+
     return crc;
 }
 
@@ -800,19 +802,18 @@ rtl8139_do_receive(void *priv, uint8_t *buf, int size_)
                 s->RxRingAddrLO, cplus_rx_ring_desc);
 
         uint32_t val;
+        uint32_t desc[4];
         uint32_t rxdw0;
         uint32_t rxdw1;
         uint32_t rxbufLO;
         uint32_t rxbufHI;
 
-        dma_bm_read(cplus_rx_ring_desc, (uint8_t *) &val, 4, 4);
-        rxdw0 = val;
-        dma_bm_read(cplus_rx_ring_desc + 4, (uint8_t *) &val, 4, 4);
-        rxdw1 = val;
-        dma_bm_read(cplus_rx_ring_desc + 8, (uint8_t *) &val, 4, 4);
-        rxbufLO = val;
-        dma_bm_read(cplus_rx_ring_desc + 12, (uint8_t *) &val, 4, 4);
-        rxbufHI = val;
+        /* Fetch the whole descriptor at once. */
+        dma_bm_read(cplus_rx_ring_desc, (uint8_t *) desc, sizeof(desc), 4);
+        rxdw0   = le32_to_cpu(desc[0]);
+        rxdw1   = le32_to_cpu(desc[1]);
+        rxbufLO = le32_to_cpu(desc[2]);
+        rxbufHI = le32_to_cpu(desc[3]);
 
         rtl8139_log("+++ C+ mode RX descriptor %d %08x %08x %08x %08x\n",
                     descriptor, rxdw0, rxdw1, rxbufLO, rxbufHI);
@@ -1716,19 +1717,18 @@ rtl8139_cplus_transmit_one(RTL8139State *s)
                 s->TxAddr[0], cplus_tx_ring_desc);
 
     uint32_t val;
+    uint32_t desc[4];
     uint32_t txdw0;
     uint32_t txdw1;
     uint32_t txbufLO;
     uint32_t txbufHI;
 
-    dma_bm_read(cplus_tx_ring_desc, (uint8_t *) &val, 4, 4);
-    txdw0 = le32_to_cpu(val);
-    dma_bm_read(cplus_tx_ring_desc + 4, (uint8_t *) &val, 4, 4);
-    txdw1 = le32_to_cpu(val);
-    dma_bm_read(cplus_tx_ring_desc + 8, (uint8_t *) &val, 4, 4);
-    txbufLO = le32_to_cpu(val);
-    dma_bm_read(cplus_tx_ring_desc + 12, (uint8_t *) &val, 4, 4);
-    txbufHI = le32_to_cpu(val);
+    /* Fetch the whole descriptor at once. */
+    dma_bm_read(cplus_tx_ring_desc, (uint8_t *) desc, sizeof(desc), 4);
+    txdw0   = le32_to_cpu(desc[0]);
+    txdw1   = le32_to_cpu(desc[1]);
+    txbufLO = le32_to_cpu(desc[2]);
+    txbufHI = le32_to_cpu(desc[3]);
 
     rtl8139_log("+++ C+ mode TX descriptor %d %08x %08x %08x %08x\n", descriptor,
                 txdw0, txdw1, txbufLO, txbufHI);
@@ -0,0 +1,517 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Shared memory switch, connecting the emulated cards of every
+ *          86Box instance on the same host that uses the same name.
+ *
+ *          The switch is a POSIX shared memory segment with a fixed
+ *          number of ports. Every port owns a ring of frames that the
+ *          other ports read with their own cursor, so a frame is written
+ *          once no matter how many ports receive it. A port that falls
+ *          more than a ring behind simply loses the oldest frames, like
+ *          a switch dropping under load. Idle ports sleep in poll() on a
+ *          datagram socket which the sender only writes to when needed.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifdef _WIN32
+#    error The shared memory switch is only supported on POSIX systems
+#endif
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/thread.h>
+#include <86box/timer.h>
+#include <86box/network.h>
+#include <86box/net_event.h>
+
+/* Bump the version whenever the segment layout changes. */
+#define SHMSW_MAGIC    (0x77536800 | 1) /* "\x01hSw" */
+#define SHMSW_PORTS    16
+#define SHMSW_RING_LEN 256 /* Power of two. */
+#define SHMSW_PKT_BATCH NET_QUEUE_LEN
+/* How long a sleeping port waits before looking at the rings anyway. */
+#define SHMSW_POLL_MS 1000
+
+typedef struct shmsw_slot_t {
+    atomic_uint seq; /* (2 * position) + 1 while written, + 2 once complete. */
+    uint32_t    len;
+    uint8_t     data[NET_MAX_FRAME];
+} shmsw_slot_t;
+
+typedef struct shmsw_port_t {
+    atomic_int   pid;     /* Owner, 0 if free. */
+    atomic_uint  gen;     /* Bumped on every claim, so readers resync. */
+    atomic_uint  waiting; /* The owner is about to sleep, ring its doorbell. */
+    atomic_uint  head;    /* Frames published so far. */
+    atomic_uint  start;   /* Head when the port was claimed. */
+    uint8_t      mac[6];
+    uint8_t      promisc;
+    uint8_t      pad;
+    shmsw_slot_t ring[SHMSW_RING_LEN];
+} shmsw_port_t;
+
+typedef struct shmsw_seg_t {
+    atomic_uint  magic;
+    shmsw_port_t port[SHMSW_PORTS];
+} shmsw_seg_t;
+
+typedef struct net_shmswitch_t {
+    shmsw_seg_t  *seg;
+    shmsw_port_t *me;
+    int           port;
+    char          shm_name[32];
+    netcard_t    *card;
+    thread_t     *poll_tid;
+    net_evt_t     tx_event;
+    net_evt_t     stop_event;
+    int           bell_fd;
+    uint32_t      cursor[SHMSW_PORTS];
+    uint32_t      gen[SHMSW_PORTS];
+    uint32_t      dropped;
+    netpkt_t      pktv[SHMSW_PKT_BATCH];
+    uint8_t       rx_buf[NET_MAX_FRAME];
+} net_shmswitch_t;
+
+#ifdef ENABLE_SHMSWITCH_LOG
+int shmswitch_do_log = ENABLE_SHMSWITCH_LOG;
+
+static void
+shmswitch_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (shmswitch_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define shmswitch_log(fmt, ...)
+#endif
+
+static void
+net_shmswitch_bell_addr(const net_shmswitch_t *shm, int port, struct sockaddr_un *addr, socklen_t *len)
+{
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+#ifdef __linux__
+    /* Abstract socket, nothing to clean up if we crash. */
+    snprintf(&addr->sun_path[1], sizeof(addr->sun_path) - 1, "%s-%d", shm->shm_name, port);
+    *len = offsetof(struct sockaddr_un, sun_path) + 1 + strlen(&addr->sun_path[1]);
+#else
+    snprintf(addr->sun_path, sizeof(addr->sun_path), "/tmp%s-%d.sock", shm->shm_name, port);
+    *len = sizeof(struct sockaddr_un);
+#endif
+}
+
+static int
+net_shmswitch_wants(const shmsw_port_t *port, const uint8_t *frame)
+{
+    /* Broadcast and multicast go everywhere. */
+    return (frame[0] & 1) || port->promisc || !memcmp(frame, port->mac, 6);
+}
+
+static void
+net_shmswitch_ring(net_shmswitch_t *shm, uint32_t mask)
+{
+    struct sockaddr_un addr;
+    socklen_t          len;
+    const uint8_t      byte = 0;
+
+    /* Pairs with the fence in net_shmswitch_thread(), either the peer sees
+       the new head or we see it waiting. */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    for (int i = 0; i < SHMSW_PORTS; i++) {
+        if (!(mask & (1 << i)) || !atomic_load_explicit(&shm->seg->port[i].waiting, memory_order_relaxed))
+            continue;
+
+        net_shmswitch_bell_addr(shm, i, &addr, &len);
+        sendto(shm->bell_fd, &byte, 1, MSG_DONTWAIT, (struct sockaddr *) &addr, len);
+    }
+}
+
+static void
+net_shmswitch_tx(net_shmswitch_t *shm)
+{
+    shmsw_port_t *me   = shm->me;
+    uint32_t      mask = 0;
+    int           packets;
+
+    do {
+        packets = network_tx_popv(shm->card, shm->pktv, SHMSW_PKT_BATCH);
+        for (int i = 0; i < packets; i++) {
+            uint32_t      pos  = atomic_load_explicit(&me->head, memory_order_relaxed);
+            shmsw_slot_t *slot = &me->ring[pos & (SHMSW_RING_LEN - 1)];
+
+            if (shm->pktv[i].len < 6)
+                continue;
+
+            atomic_store_explicit(&slot->seq, (pos << 1) + 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_release);
+            slot->len = shm->pktv[i].len;
+            memcpy(slot->data, shm->pktv[i].data, shm->pktv[i].len);
+            atomic_store_explicit(&slot->seq, (pos << 1) + 2, memory_order_release);
+            atomic_store_explicit(&me->head, pos + 1, memory_order_release);
+
+            /* Only wake up the ports that will take the frame. */
+            for (int p = 0; p < SHMSW_PORTS; p++) {
+                shmsw_port_t *port = &shm->seg->port[p];
+
+                if ((p != shm->port) && atomic_load_explicit(&port->pid, memory_order_relaxed) && net_shmswitch_wants(port, slot->data))
+                    mask |= (1 << p);
+            }
+        }
+    } while (packets == SHMSW_PKT_BATCH);
+
+    if (mask)
+        net_shmswitch_ring(shm, mask);
+}
+
+/* Copy everything new from the other ports into the card. */
+static int
+net_shmswitch_rx(net_shmswitch_t *shm)
+{
+    int frames = 0;
+
+    for (int p = 0; p < SHMSW_PORTS; p++) {
+        shmsw_port_t *port = &shm->seg->port[p];
+        uint32_t      head;
+        uint32_t      gen;
+
+        if ((p == shm->port) || !atomic_load_explicit(&port->pid, memory_order_acquire))
+            continue;
+
+        head = atomic_load_explicit(&port->head, memory_order_acquire);
+        gen  = atomic_load_explicit(&port->gen, memory_order_acquire);
+        if (gen != shm->gen[p]) {
+            /* New owner, start with the first frame it sent. */
+            shm->gen[p]    = gen;
+            shm->cursor[p] = atomic_load_explicit(&port->start, memory_order_relaxed);
+        }
+
+        if ((head - shm->cursor[p]) > SHMSW_RING_LEN) {
+            shm->dropped += (head - shm->cursor[p]) - SHMSW_RING_LEN;
+            shm->cursor[p] = head - SHMSW_RING_LEN;
+        }
+
+        while (shm->cursor[p] != head) {
+            uint32_t      pos  = shm->cursor[p]++;
+            shmsw_slot_t *slot = &port->ring[pos & (SHMSW_RING_LEN - 1)];
+            uint32_t      len;
+
+            if (atomic_load_explicit(&slot->seq, memory_order_acquire) != ((pos << 1) + 2))
+                goto lapped;
+            len = slot->len;
+            if ((len > NET_MAX_FRAME) || !net_shmswitch_wants(shm->me, slot->data))
+                continue;
+            memcpy(shm->rx_buf, slot->data, len);
+            atomic_thread_fence(memory_order_acquire);
+            /* The writer came around and reused the slot while we copied. */
+            if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != ((pos << 1) + 2))
+                goto lapped;
+
+            network_rx_put(shm->card, shm->rx_buf, len);
+            frames++;
+            continue;
+
+lapped:
+            shm->dropped++;
+            head           = atomic_load_explicit(&port->head, memory_order_acquire);
+            shm->cursor[p] = head - SHMSW_RING_LEN + 1;
+        }
+    }
+
+    return frames;
+}
+
+static int
+net_shmswitch_pending(const net_shmswitch_t *shm)
+{
+    for (int p = 0; p < SHMSW_PORTS; p++) {
+        const shmsw_port_t *port = &shm->seg->port[p];
+
+        if ((p != shm->port) && atomic_load_explicit(&port->pid, memory_order_relaxed) &&
+            (atomic_load_explicit(&port->head, memory_order_relaxed) != shm->cursor[p]))
+            return 1;
+    }
+
+    return 0;
+}
+
+static void
+net_shmswitch_thread(void *priv)
+{
+    enum {
+        NET_EVENT_STOP = 0,
+        NET_EVENT_TX,
+        NET_EVENT_BELL,
+        NET_EVENT_MAX
+    };
+    net_shmswitch_t *shm = (net_shmswitch_t *) priv;
+    struct pollfd    pfd[NET_EVENT_MAX];
+    uint8_t          bell[64];
+
+    shmswitch_log("SHM Switch: polling started on port %d.\n", shm->port);
+
+    pfd[NET_EVENT_STOP].fd     = net_event_get_fd(&shm->stop_event);
+    pfd[NET_EVENT_STOP].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_TX].fd     = net_event_get_fd(&shm->tx_event);
+    pfd[NET_EVENT_TX].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_BELL].fd     = shm->bell_fd;
+    pfd[NET_EVENT_BELL].events = POLLIN;
+
+    while (1) {
+        net_shmswitch_rx(shm);
+
+        /* Announce that we are going to sleep, then look once more so a
+           frame published in between is not left waiting for the timeout. */
+        atomic_store_explicit(&shm->me->waiting, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (net_shmswitch_pending(shm)) {
+            atomic_store_explicit(&shm->me->waiting, 0, memory_order_relaxed);
+            continue;
+        }
+
+        poll(pfd, NET_EVENT_MAX, SHMSW_POLL_MS);
+        atomic_store_explicit(&shm->me->waiting, 0, memory_order_relaxed);
+
+        if (pfd[NET_EVENT_STOP].revents & POLLIN) {
+            net_event_clear(&shm->stop_event);
+            break;
+        }
+
+        if (pfd[NET_EVENT_TX].revents & POLLIN) {
+            net_event_clear(&shm->tx_event);
+            net_shmswitch_tx(shm);
+        }
+
+        if (pfd[NET_EVENT_BELL].revents & POLLIN) {
+            while (recv(shm->bell_fd, bell, sizeof(bell), MSG_DONTWAIT) > 0)
+                ;
+        }
+    }
+
+    shmswitch_log("SHM Switch: polling stopped.\n");
+}
+
+static int
+net_shmswitch_alive(int pid)
+{
+    return (kill(pid, 0) == 0) || (errno != ESRCH);
+}
+
+/* Take a free port, or one whose owner is gone. */
+static int
+net_shmswitch_claim(net_shmswitch_t *shm)
+{
+    int self = getpid();
+
+    for (int p = 0; p < SHMSW_PORTS; p++) {
+        shmsw_port_t *port = &shm->seg->port[p];
+        int           pid  = atomic_load_explicit(&port->pid, memory_order_acquire);
+
+        if (((pid == 0) || ((pid != self) && !net_shmswitch_alive(pid))) &&
+            atomic_compare_exchange_strong(&port->pid, &pid, self)) {
+            atomic_store_explicit(&port->waiting, 0, memory_order_relaxed);
+            atomic_store_explicit(&port->start, atomic_load_explicit(&port->head, memory_order_relaxed), memory_order_relaxed);
+            atomic_fetch_add_explicit(&port->gen, 1, memory_order_release);
+            return p;
+        }
+    }
+
+    return -1;
+}
+
+static void
+net_shmswitch_unmap(net_shmswitch_t *shm)
+{
+    int in_use = 0;
+
+    for (int p = 0; p < SHMSW_PORTS; p++) {
+        int pid = atomic_load_explicit(&shm->seg->port[p].pid, memory_order_relaxed);
+
+        if (pid && net_shmswitch_alive(pid))
+            in_use = 1;
+    }
+
+    munmap(shm->seg, sizeof(shmsw_seg_t));
+    /* The last one out takes the switch down. */
+    if (!in_use)
+        shm_unlink(shm->shm_name);
+}
+
+void *
+net_shmswitch_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, char *netdrv_errbuf)
+{
+    const netcard_conf_t *conf = (const netcard_conf_t *) priv;
+    struct sockaddr_un    addr;
+    socklen_t             len;
+    struct stat           st;
+    unsigned int          magic = 0;
+    int                   fd;
+
+    net_shmswitch_t *shm = calloc(1, sizeof(net_shmswitch_t));
+    shm->card            = (netcard_t *) card;
+    shm->bell_fd         = -1;
+
+    /* A name from the configuration, otherwise the switch group. Keep it
+       short, macOS limits shared memory names to 31 characters. */
+    if ((conf->host_dev_name[0] != '\0') && strcmp(conf->host_dev_name, "none"))
+        snprintf(shm->shm_name, sizeof(shm->shm_name), "/86box-sw-%.20s", conf->host_dev_name);
+    else
+        snprintf(shm->shm_name, sizeof(shm->shm_name), "/86box-sw-%d", conf->switch_group + 1);
+    shmswitch_log("SHM Switch: joining %s\n", shm->shm_name);
+
+    fd = shm_open(shm->shm_name, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "Unable to open the shared memory switch %s (%s)", shm->shm_name, strerror(errno));
+        goto fail;
+    }
+    /* The first one in sizes it, a zeroed segment is a switch with no ports in use. */
+    if ((fstat(fd, &st) != 0) || ((st.st_size < (off_t) sizeof(shmsw_seg_t)) && (ftruncate(fd, sizeof(shmsw_seg_t)) != 0))) {
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "Unable to size the shared memory switch %s (%s)", shm->shm_name, strerror(errno));
+        close(fd);
+        goto fail;
+    }
+    shm->seg = mmap(NULL, sizeof(shmsw_seg_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm->seg == MAP_FAILED) {
+        shm->seg = NULL;
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "Unable to map the shared memory switch %s (%s)", shm->shm_name, strerror(errno));
+        goto fail;
+    }
+
+    if (!atomic_compare_exchange_strong(&shm->seg->magic, &magic, SHMSW_MAGIC) && (magic != SHMSW_MAGIC)) {
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "The shared memory switch %s belongs to an incompatible 86Box version", shm->shm_name);
+        munmap(shm->seg, sizeof(shmsw_seg_t));
+        shm->seg = NULL;
+        goto fail;
+    }
+
+    shm->port = net_shmswitch_claim(shm);
+    if (shm->port < 0) {
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "All %d ports of the shared memory switch %s are in use", SHMSW_PORTS, shm->shm_name);
+        net_shmswitch_unmap(shm);
+        shm->seg = NULL;
+        goto fail;
+    }
+    shm->me = &shm->seg->port[shm->port];
+    memcpy(shm->me->mac, mac_addr, 6);
+    shm->me->promisc = conf->promisc_mode;
+
+    /* Start reading the other ports from where they are now. */
+    for (int p = 0; p < SHMSW_PORTS; p++) {
+        shm->gen[p]    = atomic_load_explicit(&shm->seg->port[p].gen, memory_order_relaxed);
+        shm->cursor[p] = atomic_load_explicit(&shm->seg->port[p].head, memory_order_acquire);
+    }
+
+    shm->bell_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    net_shmswitch_bell_addr(shm, shm->port, &addr, &len);
+#ifndef __linux__
+    unlink(addr.sun_path);
+#endif
+    if ((shm->bell_fd < 0) || (bind(shm->bell_fd, (struct sockaddr *) &addr, len) != 0)) {
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "Unable to create the shared memory switch doorbell (%s)", strerror(errno));
+        atomic_store_explicit(&shm->me->pid, 0, memory_order_release);
+        net_shmswitch_unmap(shm);
+        shm->seg = NULL;
+        goto fail;
+    }
+
+    for (int i = 0; i < SHMSW_PKT_BATCH; i++)
+        shm->pktv[i].data = calloc(1, NET_MAX_FRAME);
+
+    net_event_init(&shm->tx_event);
+    net_event_init(&shm->stop_event);
+    shm->poll_tid = thread_create(net_shmswitch_thread, shm);
+
+    shmswitch_log("SHM Switch: using port %d of %s\n", shm->port, shm->shm_name);
+    return shm;
+
+fail:
+    if (shm->bell_fd >= 0)
+        close(shm->bell_fd);
+    free(shm);
+    return NULL;
+}
+
+void
+net_shmswitch_in_available(void *priv)
+{
+    net_shmswitch_t *shm = (net_shmswitch_t *) priv;
+
+    net_event_set(&shm->tx_event);
+}
+
+void
+net_shmswitch_close(void *priv)
+{
+    net_shmswitch_t   *shm = (net_shmswitch_t *) priv;
+    struct sockaddr_un addr;
+    socklen_t          len;
+
+    if (shm == NULL)
+        return;
+
+    shmswitch_log("SHM Switch: closing.\n");
+
+    net_event_set(&shm->stop_event);
+    thread_wait(shm->poll_tid);
+
+    if (shm->dropped)
+        pclog("SHM Switch: %u frames lost to full rings on %s\n", shm->dropped, shm->shm_name);
+
+    atomic_store_explicit(&shm->me->pid, 0, memory_order_release);
+    net_shmswitch_unmap(shm);
+
+    close(shm->bell_fd);
+#ifndef __linux__
+    net_shmswitch_bell_addr(shm, shm->port, &addr, &len);
+    unlink(addr.sun_path);
+#else
+    (void) addr;
+    (void) len;
+#endif
+
+    for (int i = 0; i < SHMSW_PKT_BATCH; i++)
+        free(shm->pktv[i].data);
+
+    net_event_close(&shm->tx_event);
+    net_event_close(&shm->stop_event);
+
+    free(shm);
+}
+
+const netdrv_t net_shmswitch_drv = {
+    .notify_in = &net_shmswitch_in_available,
+    .init      = &net_shmswitch_init,
+    .close     = &net_shmswitch_close,
+    .priv      = NULL
+};
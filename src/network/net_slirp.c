@@ -43,6 +43,10 @@
 #ifdef _WIN32
 #    define WIN32_LEAN_AND_MEAN
 #    include <windows.h>
+#elif defined(__linux__)
+#    include <errno.h>
+#    include <unistd.h>
+#    include <sys/epoll.h>
 #else
 #    include <poll.h>
 #endif
@@ -57,6 +61,18 @@ enum {
     NET_EVENT_MAX
 };
 
+#ifdef __linux__
+/* A descriptor stays registered with epoll for as long as libslirp keeps
+   asking for it, instead of being handed to poll() on every iteration. */
+typedef struct net_slirp_epfd_t {
+    uint32_t round; /* Last iteration it was asked for. */
+    uint32_t events;
+    int      revents;
+    int      registered;
+    int      listed;
+} net_slirp_epfd_t;
+#endif
+
 typedef struct net_slirp_t {
     Slirp *        slirp;
     uint8_t        mac_addr[6];
@@ -71,6 +87,15 @@ typedef struct net_slirp_t {
     int            recv_on_tx;
 #ifdef _WIN32
     HANDLE         sock_event;
+#elif defined(__linux__)
+    int                 epfd;
+    uint32_t            ep_round;
+    uint32_t            ep_fds_size; /* Indexed by descriptor. */
+    net_slirp_epfd_t   *ep_fds;
+    int                *ep_list;     /* Registered descriptors. */
+    int                 ep_list_len;
+    int                 ep_list_size;
+    struct epoll_event *ep_events;
 #else
     uint32_t       pfd_len;
     uint32_t       pfd_size;
@@ -159,8 +184,17 @@ net_slirp_register_poll_socket(slirp_os_socket fd, void *opaque)
 net_slirp_register_poll_fd(int fd, void *opaque)
 #endif
 {
+#ifdef __linux__
+    net_slirp_t *slirp = (net_slirp_t *) opaque;
+
+    /* A new socket may reuse the number of one that was closed (and so
+       dropped by epoll), make sure it gets added again. */
+    if ((fd >= 0) && ((uint32_t) fd < slirp->ep_fds_size))
+        slirp->ep_fds[fd].registered = 0;
+#else
     (void) fd;
     (void) opaque;
+#endif
 }
 
 static void
@@ -170,8 +204,17 @@ net_slirp_unregister_poll_socket(slirp_os_socket fd, void *opaque)
 net_slirp_unregister_poll_fd(int fd, void *opaque)
 #endif
 {
+#ifdef __linux__
+    net_slirp_t *slirp = (net_slirp_t *) opaque;
+
+    if ((fd >= 0) && ((uint32_t) fd < slirp->ep_fds_size) && slirp->ep_fds[fd].registered) {
+        epoll_ctl(slirp->epfd, EPOLL_CTL_DEL, fd, NULL);
+        slirp->ep_fds[fd].registered = 0;
+    }
+#else
     (void) fd;
     (void) opaque;
+#endif
 }
 
 static void
@@ -224,6 +267,82 @@ net_slirp_add_poll(int fd, int events, void *opaque)
     WSAEventSelect(fd, slirp->sock_event, bitmask);
     return fd;
 }
+#elif defined(__linux__)
+static int
+#    if SLIRP_CHECK_VERSION(4, 9, 0)
+net_slirp_add_poll(slirp_os_socket fd, int events, void *opaque)
+#    else
+net_slirp_add_poll(int fd, int events, void *opaque)
+#    endif
+{
+    net_slirp_t       *slirp = (net_slirp_t *) opaque;
+    net_slirp_epfd_t  *e;
+    struct epoll_event ev = { 0 };
+
+    if (fd < 0)
+        return -1;
+
+    if ((uint32_t) fd >= slirp->ep_fds_size) {
+        uint32_t          size = slirp->ep_fds_size ? slirp->ep_fds_size : 64;
+        net_slirp_epfd_t *new;
+
+        while (size <= (uint32_t) fd)
+            size <<= 1;
+        new = realloc(slirp->ep_fds, size * sizeof(net_slirp_epfd_t));
+        if (new == NULL)
+            return -1;
+        memset(&new[slirp->ep_fds_size], 0, (size - slirp->ep_fds_size) * sizeof(net_slirp_epfd_t));
+        slirp->ep_fds      = new;
+        slirp->ep_fds_size = size;
+    }
+
+    if (events & SLIRP_POLL_IN)
+        ev.events |= EPOLLIN;
+    if (events & SLIRP_POLL_OUT)
+        ev.events |= EPOLLOUT;
+    if (events & SLIRP_POLL_PRI)
+        ev.events |= EPOLLPRI;
+    if (events & SLIRP_POLL_ERR)
+        ev.events |= EPOLLERR;
+    if (events & SLIRP_POLL_HUP)
+        ev.events |= EPOLLHUP;
+    ev.data.fd = fd;
+
+    e = &slirp->ep_fds[fd];
+    if (!e->listed) {
+        if (slirp->ep_list_len >= slirp->ep_list_size) {
+            int                 size = slirp->ep_list_size + 16;
+            int                *list = realloc(slirp->ep_list, size * sizeof(int));
+            struct epoll_event *evs  = realloc(slirp->ep_events, size * sizeof(struct epoll_event));
+
+            if (list != NULL)
+                slirp->ep_list = list;
+            if (evs != NULL)
+                slirp->ep_events = evs;
+            if ((list == NULL) || (evs == NULL))
+                return -1;
+            slirp->ep_list_size = size;
+        }
+        slirp->ep_list[slirp->ep_list_len++] = fd;
+        e->listed = 1;
+    }
+
+    /* Only talk to the kernel when the registration changes. */
+    if (!e->registered) {
+        if ((epoll_ctl(slirp->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) && (errno == EEXIST))
+            epoll_ctl(slirp->epfd, EPOLL_CTL_MOD, fd, &ev);
+        e->registered = 1;
+    } else if (e->events != ev.events) {
+        if ((epoll_ctl(slirp->epfd, EPOLL_CTL_MOD, fd, &ev) != 0) && (errno == ENOENT))
+            epoll_ctl(slirp->epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    e->events  = ev.events;
+    e->round   = slirp->ep_round;
+    e->revents = 0;
+
+    return fd;
+}
 #else
 static int
 #    if SLIRP_CHECK_VERSION(4, 9, 0)
@@ -297,6 +416,64 @@ net_slirp_get_revents(int idx, void *opaque)
 
     return ret;
 }
+#elif defined(__linux__)
+static int
+net_slirp_get_revents(int idx, void *opaque)
+{
+    net_slirp_t *slirp  = (net_slirp_t *) opaque;
+    int          ret    = 0;
+    int          events;
+
+    if ((idx < 0) || ((uint32_t) idx >= slirp->ep_fds_size))
+        return 0;
+
+    events = slirp->ep_fds[idx].revents;
+    if (events & EPOLLIN)
+        ret |= SLIRP_POLL_IN;
+    if (events & EPOLLOUT)
+        ret |= SLIRP_POLL_OUT;
+    if (events & EPOLLPRI)
+        ret |= SLIRP_POLL_PRI;
+    if (events & EPOLLERR)
+        ret |= SLIRP_POLL_ERR;
+    if (events & EPOLLHUP)
+        ret |= SLIRP_POLL_HUP;
+    return ret;
+}
+
+/* Start an iteration, the descriptors are added again by libslirp. */
+static void
+net_slirp_poll_begin(net_slirp_t *slirp)
+{
+    slirp->ep_round++;
+}
+
+static int
+net_slirp_poll_wait(net_slirp_t *slirp, int timeout)
+{
+    int i = 0;
+    int ret;
+
+    /* Drop what libslirp did not ask for this time. */
+    while (i < slirp->ep_list_len) {
+        int               fd = slirp->ep_list[i];
+        net_slirp_epfd_t *e  = &slirp->ep_fds[fd];
+
+        if (e->round != slirp->ep_round) {
+            if (e->registered)
+                epoll_ctl(slirp->epfd, EPOLL_CTL_DEL, fd, NULL);
+            e->registered = e->listed = 0;
+            slirp->ep_list[i] = slirp->ep_list[--slirp->ep_list_len];
+        } else
+            i++;
+    }
+
+    ret = epoll_wait(slirp->epfd, slirp->ep_events, slirp->ep_list_len, timeout);
+    for (i = 0; i < ret; i++)
+        slirp->ep_fds[slirp->ep_events[i].data.fd].revents = slirp->ep_events[i].events;
+
+    return ret;
+}
 #else
 static int
 net_slirp_get_revents(int idx, void *opaque)
@@ -316,6 +493,18 @@ net_slirp_get_revents(int idx, void *opaque)
         ret |= SLIRP_POLL_HUP;
     return ret;
 }
+
+static void
+net_slirp_poll_begin(net_slirp_t *slirp)
+{
+    slirp->pfd_len = 0;
+}
+
+static int
+net_slirp_poll_wait(net_slirp_t *slirp, int timeout)
+{
+    return poll(slirp->pfd, slirp->pfd_len, timeout);
+}
 #endif
 
 static const SlirpCb slirp_cb = {
@@ -432,9 +621,9 @@ net_slirp_thread(void *priv)
     while (1) {
         uint32_t timeout = -1;
 
-        slirp->pfd_len = 0;
-        net_slirp_add_poll(net_event_get_fd(&slirp->stop_event), SLIRP_POLL_IN, slirp);
-        net_slirp_add_poll(net_event_get_fd(&slirp->tx_event), SLIRP_POLL_IN, slirp);
+        net_slirp_poll_begin(slirp);
+        int stop_idx = net_slirp_add_poll(net_event_get_fd(&slirp->stop_event), SLIRP_POLL_IN, slirp);
+        int tx_idx   = net_slirp_add_poll(net_event_get_fd(&slirp->tx_event), SLIRP_POLL_IN, slirp);
 
 #    if SLIRP_CHECK_VERSION(4, 9, 0)
         slirp_pollfds_fill_socket(slirp->slirp, &timeout, net_slirp_add_poll, slirp);
@@ -442,22 +631,26 @@ net_slirp_thread(void *priv)
         slirp_pollfds_fill(slirp->slirp, &timeout, net_slirp_add_poll, slirp);
 #    endif
 
-        int ret = poll(slirp->pfd, slirp->pfd_len, timeout);
+        int ret = net_slirp_poll_wait(slirp, (int) timeout);
 
         slirp_pollfds_poll(slirp->slirp, (ret < 0), net_slirp_get_revents, slirp);
 
-        if (slirp->pfd[NET_EVENT_STOP].revents & POLLIN) {
+        if (net_slirp_get_revents(stop_idx, slirp) & SLIRP_POLL_IN) {
             net_event_clear(&slirp->stop_event);
             break;
         }
 
-        if (slirp->pfd[NET_EVENT_TX].revents & POLLIN) {
+        if (net_slirp_get_revents(tx_idx, slirp) & SLIRP_POLL_IN) {
             net_event_clear(&slirp->tx_event);
 
+            /* Drain everything queued since the last wakeup. */
             slirp->during_tx = 1;
-            int packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
-            for (int i = 0; i < packets; i++)
-                net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+            int packets;
+            do {
+                packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
+                for (int i = 0; i < packets; i++)
+                    net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+            } while (packets == SLIRP_PKT_BATCH);
             slirp->during_tx = 0;
 
             net_slirp_rx_deferred_packets(slirp);
@@ -479,7 +672,15 @@ net_slirp_init(const netcard_t *card, const uint8_t *mac_addr, UNUSED(void *priv
     memcpy(slirp->mac_addr, mac_addr, sizeof(slirp->mac_addr));
     slirp->card = (netcard_t *) card;
 
-#ifndef _WIN32
+#ifdef __linux__
+    slirp->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (slirp->epfd < 0) {
+        slirp_log("SLiRP: epoll_create1 failed\n");
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "SLiRP initialization failed");
+        free(slirp);
+        return NULL;
+    }
+#elif !defined(_WIN32)
     slirp->pfd_size = 16 * sizeof(struct pollfd);
     slirp->pfd      = calloc(1, slirp->pfd_size);
 #endif
@@ -632,6 +833,12 @@ net_slirp_close(void *priv)
     net_event_close(&slirp->tx_event);
     net_event_close(&slirp->rx_event);
     slirp_cleanup(slirp->slirp);
+#ifdef __linux__
+    close(slirp->epfd);
+    free(slirp->ep_fds);
+    free(slirp->ep_list);
+    free(slirp->ep_events);
+#endif
     for (int i = 0; i < SLIRP_PKT_BATCH; i++) {
         free(slirp->pkt_tx_v[i].data);
     }
@@ -155,24 +155,34 @@ static void net_tap_thread(void *priv) {
         }
         if (pfd[NET_EVENT_TX].revents & POLLIN) {
             net_event_clear(&tap->tx_event);
-            int packets = network_tx_popv(tap->card, tap->pkts_tx,
+            // Drain the whole queue, the card only signals once per batch
+            int packets;
+            do {
+                packets = network_tx_popv(tap->card, tap->pkts_tx,
                                           NET_QUEUE_LEN);
-            for(int i = 0; i < packets; i++) {
-                netpkt_t *pkt = &tap->pkts_tx[i];
-                ssize_t ret = write(tap->fd, pkt->data, pkt->len);
-                if (ret < 0) {
-                    tap_log("TAP: write error: %s\n", strerror(errno));
+                for(int i = 0; i < packets; i++) {
+                    netpkt_t *pkt = &tap->pkts_tx[i];
+                    ssize_t ret = write(tap->fd, pkt->data, pkt->len);
+                    if (ret < 0) {
+                        tap_log("TAP: write error: %s\n", strerror(errno));
+                    }
                 }
-            }
+            } while (packets == NET_QUEUE_LEN);
         }
         if (pfd[NET_EVENT_RX].revents & POLLIN) {
-            ssize_t len = read(tap->fd, tap->pkt_rx.data, NET_MAX_FRAME);
-            if (len < 0) {
-                tap_log("TAP: read error: %s\n", strerror(errno));
-                continue;
+            // A TAP read returns one frame, so read a batch of them per
+            // wakeup instead of going back to poll() for each
+            for (int i = 0; i < NET_QUEUE_LEN; i++) {
+                ssize_t len = read(tap->fd, tap->pkt_rx.data, NET_MAX_FRAME);
+                if (len < 0) {
+                    if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                        tap_log("TAP: read error: %s\n", strerror(errno));
+                    }
+                    break;
+                }
+                tap->pkt_rx.len = len;
+                network_rx_put_pkt(tap->card, &tap->pkt_rx);
             }
-            tap->pkt_rx.len = len;
-            network_rx_put_pkt(tap->card, &tap->pkt_rx);
         }
         if (pfd[NET_EVENT_STOP].revents & POLLIN) {
             net_event_clear(&tap->stop_event);
@@ -199,6 +209,8 @@ void net_tap_close(void *priv)
     if (tap->fd >= 0) {
         close(tap->fd);
     }
+    net_event_close(&tap->tx_event);
+    net_event_close(&tap->stop_event);
     free(tap);
 }
 
@@ -12,6 +12,7 @@
  *
  *          Copyright 2024 cold-brewed
  */
+#define _GNU_SOURCE
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -21,6 +22,7 @@
 #include <stdbool.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <zlib.h>
 #ifdef _WIN32
 #    define WIN32_LEAN_AND_MEAN
 #    include <windows.h>
@@ -230,8 +232,21 @@ ns_open(struct ns_open_args *open_args) {
     }
 //    net_switch_log("Fragment buffers: %d total, %d each\n", FRAGMENT_BUFFER_LENGTH, MAX_FRAME_SEND_SIZE);
 
+    /* Datagram batches and the compression scratch buffer */
+    conn->tx_batch  = calloc(NS_BATCH_LEN, NET_SWITCH_BUFFER_LENGTH);
+    conn->rx_batch  = calloc(NS_BATCH_LEN, NET_SWITCH_BUFFER_LENGTH);
+    conn->zbuf_size = compressBound(NET_MAX_FRAME);
+    conn->zbuf      = calloc(1, conn->zbuf_size);
+
     snprintf(conn->mcast_group, MAX_MCAST_GROUP_LEN, "%s", mcast_group);
     conn->flags = open_args->flags;
+    if (conn->flags & FLAGS_COMPRESS)
+        conn->flags |= FLAGS_COMPACT;
+    /* The remote switch only speaks protobuf */
+    if ((conn->switch_type == SWITCH_TYPE_REMOTE) && (conn->flags & FLAGS_COMPACT)) {
+        net_switch_log("Compact framing is only available in local mode, using protobuf\n");
+        conn->flags &= ~(FLAGS_COMPACT | FLAGS_COMPRESS);
+    }
 
     /* Increment the multicast port by the switch group number. Each group is
      * just a different port. */
@@ -305,6 +320,10 @@ fail:
     for (int i = 0; i < FRAGMENT_BUFFER_LENGTH; i++) {
         free(conn->fragment_buffer[i]);
     }
+    free(conn->tx_batch);
+    free(conn->rx_batch);
+    free(conn->zbuf);
+    free(conn);
     return NULL;
 }
 
@@ -341,6 +360,172 @@ ns_sock_send(NSCONN *conn,const void *buf, const size_t len, const int flags) {
     }
 }
 
+/* Next free buffer in the outgoing batch, flushing it when full */
+static uint8_t *
+ns_tx_slot(NSCONN *conn) {
+    if (conn->tx_count == NS_BATCH_LEN) {
+        ns_send_flush(conn);
+    }
+    return conn->tx_batch + (conn->tx_count * NET_SWITCH_BUFFER_LENGTH);
+}
+
+static void
+ns_tx_commit(NSCONN *conn, const size_t len) {
+    conn->tx_len[conn->tx_count++] = len;
+}
+
+void
+ns_send_flush(NSCONN *conn) {
+    int sent = 0;
+
+    if (conn->tx_count == 0) {
+        return;
+    }
+
+    if (!fd_valid(conn->fddata)) {
+        net_switch_log("Dropping %d queued datagrams, socket is gone\n", conn->tx_count);
+        conn->tx_count = 0;
+        return;
+    }
+
+#ifdef __linux__
+    struct mmsghdr msgs[NS_BATCH_LEN];
+    struct iovec   iov[NS_BATCH_LEN];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < conn->tx_count; i++) {
+        iov[i].iov_base              = conn->tx_batch + (i * NET_SWITCH_BUFFER_LENGTH);
+        iov[i].iov_len               = conn->tx_len[i];
+        msgs[i].msg_hdr.msg_iov      = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen   = 1;
+        msgs[i].msg_hdr.msg_name     = &conn->outaddr;
+        msgs[i].msg_hdr.msg_namelen  = sizeof(conn->outaddr);
+    }
+
+    while (sent < conn->tx_count) {
+        const int ret = sendmmsg(conn->fdout, &msgs[sent], conn->tx_count - sent, 0);
+        if (ret <= 0) {
+            net_switch_log("Error sending data on the socket (%d of %d sent)\n", sent, conn->tx_count);
+            break;
+        }
+        sent += ret;
+    }
+#else
+    for (; sent < conn->tx_count; sent++) {
+        if (sendto(conn->fdout, (const char *) (conn->tx_batch + (sent * NET_SWITCH_BUFFER_LENGTH)), conn->tx_len[sent], 0,
+                   (struct sockaddr *) &conn->outaddr, sizeof(conn->outaddr)) < 0) {
+            net_switch_log("Error sending data on the socket\n");
+        }
+    }
+#endif
+
+    conn->tx_count = 0;
+}
+
+static inline void
+ns_put16(uint8_t *p, const uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static inline void
+ns_put32(uint8_t *p, const uint32_t v) {
+    ns_put16(p, v & 0xffff);
+    ns_put16(p + 2, v >> 16);
+}
+
+static inline uint16_t
+ns_get16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t
+ns_get32(const uint8_t *p) {
+    return ns_get16(p) | ((uint32_t) ns_get16(p + 2) << 16);
+}
+
+/*
+ * Compact framing, all fields little endian:
+ *   0  magic "86NS"           20  fragment id (u32)
+ *   4  version                24  timestamp (i64)
+ *   5  message type           32  frame length before compression (u16)
+ *   6  flags                  34  fragment total
+ *   7  fragment sequence      35  reserved
+ *   8  mac address
+ *  14  sequence (u16)
+ *  16  client id (u32)
+ * followed by the (possibly compressed) frame data of this fragment.
+ */
+static ssize_t
+ns_send_compact(NSCONN *conn, const netpkt_t *packet) {
+    const uint8_t *data  = packet->data;
+    uint32_t       len   = packet->len;
+    uint8_t        flags = 0;
+    uint8_t        fragment_count;
+
+    /* Only keep the compressed frame if it is actually smaller */
+    if ((conn->flags & FLAGS_COMPRESS) && (packet->len >= NS_COMPRESS_MIN_SIZE)) {
+        uLongf zlen = conn->zbuf_size;
+        if ((compress2(conn->zbuf, &zlen, packet->data, packet->len, Z_BEST_SPEED) == Z_OK) && (zlen < (uLongf) packet->len)) {
+            data  = conn->zbuf;
+            len   = zlen;
+            flags = NS_COMPACT_COMPRESSED;
+        }
+    }
+
+    fragment_count = (len + MAX_FRAME_SEND_SIZE - 1) / MAX_FRAME_SEND_SIZE;
+
+    const uint32_t fragment_sequence = conn->sequence;
+    const int64_t  packet_timestamp  = ns_get_current_millis();
+    for (uint8_t fragment_index = 0; fragment_index < fragment_count; fragment_index++) {
+        uint8_t       *buffer      = ns_tx_slot(conn);
+        const uint32_t copy_offset = fragment_index * MAX_FRAME_SEND_SIZE;
+        const uint32_t copy_length = ((len - copy_offset) > MAX_FRAME_SEND_SIZE) ? MAX_FRAME_SEND_SIZE : (len - copy_offset);
+
+        memcpy(buffer, NS_COMPACT_MAGIC, 4);
+        buffer[4] = conn->version;
+        buffer[5] = fragment_count > 1 ? MessageType_MESSAGE_TYPE_FRAGMENT : MessageType_MESSAGE_TYPE_DATA;
+        buffer[6] = flags;
+        buffer[7] = fragment_index + 1;
+        memcpy(&buffer[8], conn->mac_addr, PB_MAC_ADDR_SIZE);
+        ns_put16(&buffer[14], conn->sequence);
+        ns_put32(&buffer[16], conn->client_id);
+        ns_put32(&buffer[20], fragment_sequence);
+        ns_put32(&buffer[24], (uint32_t) packet_timestamp);
+        ns_put32(&buffer[28], (uint32_t) ((uint64_t) packet_timestamp >> 32));
+        ns_put16(&buffer[32], packet->len);
+        buffer[34] = fragment_count;
+        buffer[35] = 0;
+        memcpy(&buffer[NS_COMPACT_HEADER_SIZE], data + copy_offset, copy_length);
+        ns_tx_commit(conn, NS_COMPACT_HEADER_SIZE + copy_length);
+
+        /* Stats */
+        if (copy_length > conn->stats.max_tx_frame) {
+            conn->stats.max_tx_frame = copy_length;
+        }
+        if ((NS_COMPACT_HEADER_SIZE + copy_length) > conn->stats.max_tx_packet) {
+            conn->stats.max_tx_packet = NS_COMPACT_HEADER_SIZE + copy_length;
+        }
+        conn->stats.total_tx_packets++;
+
+        seq_increment(conn);
+    }
+    if (fragment_count > 1) {
+        conn->stats.total_fragments += fragment_count;
+    }
+    memcpy(conn->stats.last_tx_ethertype, &packet->data[12], 2);
+
+    return packet->len;
+}
+
+ssize_t
+ns_send_frame(NSCONN *conn, const netpkt_t *packet) {
+    if (conn->flags & FLAGS_COMPACT) {
+        return ns_send_compact(conn, packet);
+    }
+    return ns_send_pb(conn, packet, 0);
+}
+
 ssize_t
 ns_send_pb(NSCONN *conn, const netpkt_t *packet,int flags) {
 
@@ -364,8 +549,8 @@ ns_send_pb(NSCONN *conn, const netpkt_t *packet,int flags) {
     const uint32_t fragment_sequence = conn->sequence;
     const int64_t  packet_timestamp  = ns_get_current_millis();
     for (uint8_t fragment_index = 0; fragment_index < fragment_count; fragment_index++) {
-        uint8_t buffer[NET_SWITCH_BUFFER_LENGTH];
-        pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
+        uint8_t     *buffer = ns_tx_slot(conn);
+        pb_ostream_t stream = pb_ostream_from_buffer(buffer, NET_SWITCH_BUFFER_LENGTH);
 #ifdef ENABLE_NET_SWITCH_PB_FILE_DEBUG
         uint8_t file_buffer[NET_SWITCH_BUFFER_LENGTH];
         /* file_stream used for debugging and writing the message to a file */
@@ -418,17 +603,13 @@ ns_send_pb(NSCONN *conn, const netpkt_t *packet,int flags) {
         if (!pb_encode_ex(&stream, NetworkMessage_fields, &network_message,PB_ENCODE_DELIMITED)) {
             net_switch_log("Encoding failed: %s\n", PB_GET_ERROR(&stream));
             errno = EBADF;
-            return -1;
-        }
-
-        /* Send on the socket */
-        const ssize_t nc = ns_sock_send(conn, buffer, stream.bytes_written, 0);
-        if(!nc) {
-            net_switch_log("Error sending data on the socket\n");
-            errno=EBADF;
             pb_release(NetworkMessage_fields, &network_message);
             return -1;
         }
+
+        /* Queue for sending, ns_send_flush() puts it on the socket */
+        const ssize_t nc = (ssize_t) stream.bytes_written;
+        ns_tx_commit(conn, nc);
 #ifdef ENABLE_NET_SWITCH_PB_FILE_DEBUG
         /* File writing for troubleshooting when needed */
         FILE *f = fopen("/var/tmp/pbuf", "wb");
@@ -467,32 +648,34 @@ ns_send_pb(NSCONN *conn, const netpkt_t *packet,int flags) {
     return packet->len;
 }
 
-bool store_fragment(const NSCONN *conn, const NetworkMessage *network_message) {
-
-    if(conn == NULL || network_message == NULL) {
-        return false;
-    }
+/* Shared by the protobuf and compact paths. fragment_sequence is one indexed */
+static bool
+ns_store_fragment_data(const NSCONN *conn, const uint32_t fragment_id, const uint32_t fragment_sequence, const uint32_t fragment_total,
+                       const uint32_t packet_sequence, const uint8_t *data, const uint32_t fragment_size) {
 
     /* The fragment sequence indicates which fragment this is in the overall fragment
      * collection. This is used to index the fragments while being stored for reassembly
      * (zero indexed locally) */
-    const uint32_t fragment_index = network_message->fragment.sequence - 1;
-    const uint32_t fragment_size  = network_message->frame->size;
+    const uint32_t fragment_index = fragment_sequence - 1;
 
     /* Make sure the fragments aren't too small
      * (see header notes about size requirements for MIN_FRAG_RECV_SIZE and FRAGMENT_BUFFER_LENGTH)
      * NOTE: The last packet is exempt from this rule because it can have a smaller amount.
      * This is primarily to ensure there's enough space to fit all the fragments. */
-    if(network_message->fragment.sequence != network_message->fragment.total) {
-        if (network_message->frame->size < MIN_FRAG_RECV_SIZE) {
-            net_switch_log("size: %d < %d\n", network_message->frame->size, MIN_FRAG_RECV_SIZE);
+    if(fragment_sequence != fragment_total) {
+        if (fragment_size < MIN_FRAG_RECV_SIZE) {
+            net_switch_log("size: %d < %d\n", fragment_size, MIN_FRAG_RECV_SIZE);
             return false;
         }
     }
 
     /* Make sure we can handle the amount of incoming fragments */
-    if (network_message->fragment.total > FRAGMENT_BUFFER_LENGTH) {
-        net_switch_log("buflen: %d > %d\n", network_message->fragment.total, FRAGMENT_BUFFER_LENGTH);
+    if (fragment_total > FRAGMENT_BUFFER_LENGTH) {
+        net_switch_log("buflen: %d > %d\n", fragment_total, FRAGMENT_BUFFER_LENGTH);
+        return false;
+    }
+    if ((fragment_sequence == 0) || (fragment_sequence > fragment_total)) {
+        net_switch_log("Fragment sequence %d out of range (total %d)\n", fragment_sequence, fragment_total);
         return false;
     }
 
@@ -511,17 +694,15 @@ bool store_fragment(const NSCONN *conn, const NetworkMessage *network_message) {
 
     /* Each fragment will belong to a particular ID. All members will have the same ID,
      * which is generally set to the sequence number of the first fragment */
-    conn->fragment_buffer[fragment_index]->id       = network_message->fragment.id;
-    /* The sequence here is set to the index of the packet in the total fragment collection
-     * (network_message->fragment.sequence) */
+    conn->fragment_buffer[fragment_index]->id       = fragment_id;
+    /* The sequence here is set to the index of the packet in the total fragment collection */
     conn->fragment_buffer[fragment_index]->sequence = fragment_index;
     /* Total number of fragments in this set */
-    conn->fragment_buffer[fragment_index]->total    = network_message->fragment.total;
+    conn->fragment_buffer[fragment_index]->total    = fragment_total;
     /* The sequence number from the packet that contained the fragment */
-    conn->fragment_buffer[fragment_index]->packet_sequence = network_message->sequence;
+    conn->fragment_buffer[fragment_index]->packet_sequence = packet_sequence;
     /* Copy the fragment data and size */
-    /* The size of fragment_buffer[fragment_index]->data is checked against MAX_FRAME_SEND_SIZE above */
-    memcpy(conn->fragment_buffer[fragment_index]->data, network_message->frame->bytes, fragment_size);
+    memcpy(conn->fragment_buffer[fragment_index]->data, data, fragment_size);
     conn->fragment_buffer[fragment_index]->size     = fragment_size;
     /* 10 seconds for a TTL */
     conn->fragment_buffer[fragment_index]->ttl      = ns_get_current_millis() + 10000;
@@ -529,6 +710,17 @@ bool store_fragment(const NSCONN *conn, const NetworkMessage *network_message) {
     return true;
 }
 
+bool store_fragment(const NSCONN *conn, const NetworkMessage *network_message) {
+
+    if(conn == NULL || network_message == NULL) {
+        return false;
+    }
+
+    return ns_store_fragment_data(conn, network_message->fragment.id, network_message->fragment.sequence,
+                                  network_message->fragment.total, network_message->sequence,
+                                  network_message->frame->bytes, network_message->frame->size);
+}
+
 bool
 reassemble_fragment(const NSCONN *conn, netpkt_t *pkt, const uint32_t packet_count)
 {
@@ -581,21 +773,147 @@ reassemble_fragment(const NSCONN *conn, netpkt_t *pkt, const uint32_t packet_cou
     return true;
 }
 
+int
+ns_recv_batch(NSCONN *conn) {
+    /* Anything left over is dropped, the caller decodes the whole batch */
+    conn->rx_count = 0;
+    conn->rx_next  = 0;
+
+#ifdef __linux__
+    struct mmsghdr msgs[NS_BATCH_LEN];
+    struct iovec   iov[NS_BATCH_LEN];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < NS_BATCH_LEN; i++) {
+        iov[i].iov_base         = conn->rx_batch + (i * NET_SWITCH_BUFFER_LENGTH);
+        iov[i].iov_len          = NET_SWITCH_BUFFER_LENGTH;
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const int ret = recvmmsg(conn->fddata, msgs, NS_BATCH_LEN, MSG_DONTWAIT, NULL);
+    for (int i = 0; i < ret; i++) {
+        conn->rx_len[i] = msgs[i].msg_len;
+    }
+    if (ret > 0) {
+        conn->rx_count = ret;
+    }
+#else
+    /* One datagram per wakeup, as before */
+    const ssize_t nc = ns_sock_recv(conn, conn->rx_batch, NET_SWITCH_BUFFER_LENGTH, 0);
+    if (nc > 0) {
+        conn->rx_len[0] = nc;
+        conn->rx_count  = 1;
+    }
+#endif
+
+    return conn->rx_count;
+}
+
+static bool
+ns_recv_compact(NSCONN *conn, ns_rx_packet_t *packet, const uint8_t *buffer, const size_t nc) {
+    ns_rx_packet_t *ns_packet = packet;
+    const uint8_t  *data      = &buffer[NS_COMPACT_HEADER_SIZE];
+    uint32_t        size      = nc - NS_COMPACT_HEADER_SIZE;
+    const uint8_t   flags     = buffer[6];
+    const uint16_t  frame_len = ns_get16(&buffer[32]);
+
+    /* Basic checks for validity */
+    ns_packet->client_id = ns_get32(&buffer[16]);
+    ns_packet->type      = buffer[5];
+    if ((ns_packet->client_id == 0) || (ns_packet->type == MessageType_MESSAGE_TYPE_UNSPECIFIED) || (frame_len > NET_MAX_FRAME)) {
+        net_switch_log("Invalid compact packet received! Skipping..\n");
+        return false;
+    }
+
+    memcpy(ns_packet->mac, &buffer[8], PB_MAC_ADDR_SIZE);
+    ns_packet->timestamp    = (int64_t) (ns_get32(&buffer[24]) | ((uint64_t) ns_get32(&buffer[28]) << 32));
+    ns_packet->version      = buffer[4];
+    conn->remote_sequence   = ns_get16(&buffer[14]);
+    conn->last_packet_stamp = ns_packet->timestamp;
+
+    if ((ns_packet->type != MessageType_MESSAGE_TYPE_DATA) && (ns_packet->type != MessageType_MESSAGE_TYPE_FRAGMENT)) {
+        process_control_packet(conn, ns_packet);
+        return true;
+    }
+
+    if (ns_packet->type == MessageType_MESSAGE_TYPE_FRAGMENT) {
+        if (!ns_store_fragment_data(conn, ns_get32(&buffer[20]), buffer[7], buffer[34], conn->remote_sequence, data, size)) {
+            net_switch_log("Failed to store fragment\n");
+            return false;
+        }
+
+        /* Is this the last fragment? If not, return */
+        if (buffer[7] != buffer[34]) {
+            return true;
+        }
+
+        /* Compressed frames are reassembled into the scratch buffer first */
+        netpkt_t assembled = { .data = (flags & NS_COMPACT_COMPRESSED) ? conn->zbuf : ns_packet->pkt.data };
+        if (!reassemble_fragment(conn, &assembled, buffer[34])) {
+            net_switch_log("Failed to reassemble fragment\n");
+            return false;
+        }
+        data = assembled.data;
+        size = assembled.len;
+        ns_packet->type = MessageType_MESSAGE_TYPE_DATA;
+    }
+
+    if (flags & NS_COMPACT_COMPRESSED) {
+        uLongf dlen = NET_MAX_FRAME;
+        if ((uncompress(ns_packet->pkt.data, &dlen, data, size) != Z_OK) || (dlen != frame_len)) {
+            net_switch_log("Failed to decompress frame\n");
+            return false;
+        }
+    } else if (size != frame_len) {
+        net_switch_log("Frame size mismatch (%d != %d)! Skipping..\n", size, frame_len);
+        return false;
+    } else if (data != ns_packet->pkt.data) {
+        memcpy(ns_packet->pkt.data, data, size);
+    }
+    ns_packet->pkt.len = frame_len;
+
+    /* Stats */
+    if (frame_len > conn->stats.max_rx_frame) {
+        conn->stats.max_rx_frame = frame_len;
+    }
+    if (nc > conn->stats.max_rx_packet) {
+        conn->stats.max_rx_packet = nc;
+    }
+    memcpy(conn->stats.last_rx_ethertype, &packet->pkt.data[12], 2);
+    conn->stats.total_rx_packets++;
+
+    return true;
+}
+
 bool
 ns_recv_pb(NSCONN *conn, ns_rx_packet_t *packet,size_t len,int flags) {
     NetworkMessage  network_message = NetworkMessage_init_zero;
     ns_rx_packet_t *ns_packet       = packet;
-
-    uint8_t buffer[NET_SWITCH_BUFFER_LENGTH];
-
-    /* TODO: Use the passed len? Most likely not needed */
-    const ssize_t nc = ns_sock_recv(conn, buffer, NET_SWITCH_BUFFER_LENGTH, 0);
-    if(!nc) {
+    uint8_t         local_buffer[NET_SWITCH_BUFFER_LENGTH];
+    uint8_t        *buffer;
+    ssize_t         nc;
+
+    if (conn->rx_next < conn->rx_count) {
+        /* Already read by ns_recv_batch() */
+        buffer = conn->rx_batch + (conn->rx_next * NET_SWITCH_BUFFER_LENGTH);
+        nc     = conn->rx_len[conn->rx_next++];
+    } else {
+        /* TODO: Use the passed len? Most likely not needed */
+        buffer = local_buffer;
+        nc     = ns_sock_recv(conn, buffer, NET_SWITCH_BUFFER_LENGTH, 0);
+    }
+    if(nc <= 0) {
         net_switch_log("Error receiving data on the socket\n");
         errno=EBADF;
         return false;
     }
-    pb_istream_t stream = pb_istream_from_buffer(buffer, sizeof(buffer));
+
+    if ((nc >= NS_COMPACT_HEADER_SIZE) && !memcmp(buffer, NS_COMPACT_MAGIC, 4)) {
+        return ns_recv_compact(conn, packet, buffer, nc);
+    }
+
+    pb_istream_t stream = pb_istream_from_buffer(buffer, nc);
 
     if (!pb_decode_delimited(&stream, NetworkMessage_fields, &network_message)) {
         /* Decode failed */
@@ -827,6 +1145,9 @@ ns_close(NSCONN *conn) {
         }
         free(conn->fragment_buffer[i]);
     }
+    free(conn->tx_batch);
+    free(conn->rx_batch);
+    free(conn->zbuf);
     close(conn->fddata);
     close(conn->fdout);
     return 0;
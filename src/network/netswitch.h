@@ -61,10 +61,24 @@
 #define MAX_PRINTABLE_MAC 32
 /* Maximum hostname length for a remote switch host */
 #define MAX_HOSTNAME 128
+/* Datagrams handed to the kernel per recvmmsg / sendmmsg call */
+#define NS_BATCH_LEN 16
+/* Compact framing, a fixed header in front of the frame data instead of a protobuf message.
+ * The magic can never start a delimited NetworkMessage (0x4E would be wire type 6). */
+#define NS_COMPACT_MAGIC       "86NS"
+#define NS_COMPACT_HEADER_SIZE 36
+/* Compact header flags */
+#define NS_COMPACT_COMPRESSED 0x01
+/* Frames smaller than this are never worth compressing */
+#define NS_COMPRESS_MIN_SIZE 256
 
 typedef enum {
-    FLAGS_NONE    =      0,
-    FLAGS_PROMISC = 1 << 0,
+    FLAGS_NONE     =      0,
+    FLAGS_PROMISC  = 1 << 0,
+    /* Send data frames with the compact framing (local mode only) */
+    FLAGS_COMPACT  = 1 << 1,
+    /* Compress large frames, implies FLAGS_COMPACT */
+    FLAGS_COMPRESS = 1 << 2,
 } ns_flags_t;
 
 typedef enum {
@@ -156,6 +170,19 @@ struct nsconn {
      */
     uint16_t           remote_source_port;
     ns_fragment_t      *fragment_buffer[FRAGMENT_BUFFER_LENGTH];
+    /* Outgoing datagrams waiting for ns_send_flush(), NS_BATCH_LEN buffers
+     * of NET_SWITCH_BUFFER_LENGTH bytes */
+    uint8_t            *tx_batch;
+    size_t              tx_len[NS_BATCH_LEN];
+    int                 tx_count;
+    /* Datagrams read by ns_recv_batch() and not yet decoded */
+    uint8_t            *rx_batch;
+    size_t              rx_len[NS_BATCH_LEN];
+    int                 rx_count;
+    int                 rx_next;
+    /* Scratch space for compressing and decompressing frames */
+    uint8_t            *zbuf;
+    size_t              zbuf_size;
 };
 
 typedef struct {
@@ -215,16 +242,30 @@ int ns_flags(const NSCONN *conn);
 int ns_pollfd(const NSCONN *conn);
 
 /* This should be used to receive serialized protobuf packets
- * and have the output placed in the packet struct */
+ * and have the output placed in the packet struct.
+ * Compact frames are recognized and decoded as well. Datagrams already
+ * read by ns_recv_batch() are consumed first. */
 bool ns_recv_pb(NSCONN *conn, ns_rx_packet_t *packet,size_t len,int flags);
 
+/* Read all the datagrams waiting on the socket (up to NS_BATCH_LEN) without
+ * blocking. Returns how many are ready for ns_recv_pb() */
+int ns_recv_batch(NSCONN *conn);
+
 /* Do not call directly! Used internally */
 ssize_t ns_sock_recv(const NSCONN *conn,void *buf,size_t len,int flags);
 
 /* This should be used to send serialized protobuf packets
-* and have the output placed in the packet struct */
+* and have the output placed in the packet struct.
+* The datagrams are queued, see ns_send_flush() */
 ssize_t ns_send_pb(NSCONN *conn, const netpkt_t *packet,int flags);
 
+/* Send a frame with the framing selected for the connection.
+ * Datagrams are queued, call ns_send_flush() once the batch is done */
+ssize_t ns_send_frame(NSCONN *conn, const netpkt_t *packet);
+
+/* Send out all the queued datagrams */
+void ns_send_flush(NSCONN *conn);
+
 /* Send control messages */
 bool ns_send_control(NSCONN *conn, MessageType type);
 
@@ -63,12 +63,15 @@
 #include <86box/plat.h>
 #include <86box/thread.h>
 #include <86box/ui.h>
+#include <86box/replay.h>
 #include <86box/timer.h>
 #include <86box/network.h>
 #include <86box/net_ne2000.h>
 #include <86box/net_pcnet.h>
 #include <86box/net_wd8003.h>
 
+#include <minitrace/minitrace.h>
+
 #ifdef _WIN32
 #    define WIN32_LEAN_AND_MEAN
 #    include <windows.h>
@@ -129,6 +132,8 @@ uint16_t       net_card_current = 0;
 
 /* Global variables. */
 network_devmap_t network_devmap = {0};
+uint64_t         network_rx_packets = 0;
+uint64_t         network_tx_packets = 0;
 int  network_ndev;
 netdev_t network_devs[NET_HOST_INTF_MAX];
 
@@ -274,26 +279,46 @@ network_init(void)
 #endif
 }
 
-void
-network_queue_init(netqueue_t *queue)
+/*
+ * Each queue has exactly one producer and one consumer thread: the card
+ * timer fills TX_VM and TX_HOST and drains RX and RX_LOCAL, the host
+ * driver thread drains TX_HOST and fills RX and RX_ON_TX. The indices run
+ * freely and are masked on access; a slot belongs to the consumer from
+ * the moment head passes it until tail does, so the packet buffers can
+ * be swapped in and out without any lock.
+ */
+struct netqueue_t {
+    netpkt_t   *packets;
+    uint32_t    size;
+    uint32_t    mask;
+    atomic_uint head;
+    atomic_uint tail;
+    uint32_t    dropped; /* Written by the producer only. */
+};
+
+static netqueue_t *
+network_queue_init(int len)
 {
-    queue->head = queue->tail = 0;
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
+    netqueue_t *queue = calloc(1, sizeof(netqueue_t));
+    uint32_t    size  = NET_QUEUE_MIN_LEN;
+
+    if (len <= 0)
+        len = NET_QUEUE_DEF_LEN;
+    else if (len > NET_QUEUE_MAX_LEN)
+        len = NET_QUEUE_MAX_LEN;
+    while (size < (uint32_t) len)
+        size <<= 1;
+
+    queue->packets = calloc(size, sizeof(netpkt_t));
+    queue->size    = size;
+    queue->mask    = size - 1;
+    for (uint32_t i = 0; i < size; i++)
         queue->packets[i].data = calloc(1, NET_MAX_FRAME);
-        queue->packets[i].len  = 0;
-    }
-}
 
-static bool
-network_queue_full(netqueue_t *queue)
-{
-    return ((queue->head + 1) & NET_QUEUE_LEN_MASK) == queue->tail;
-}
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
 
-static bool
-network_queue_empty(netqueue_t *queue)
-{
-    return (queue->head == queue->tail);
+    return queue;
 }
 
 static inline void
@@ -304,24 +329,56 @@ network_swap_packet(netpkt_t *pkt1, netpkt_t *pkt2)
     *pkt1        = tmp;
 }
 
+/* Producer side: the slot to fill, or NULL if the queue is full. */
+static netpkt_t *
+network_queue_slot(netqueue_t *queue)
+{
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    if ((head - atomic_load_explicit(&queue->tail, memory_order_acquire)) >= queue->size) {
+        queue->dropped++;
+        return NULL;
+    }
+
+    return &queue->packets[head & queue->mask];
+}
+
+static uint32_t
+network_queue_count(netqueue_t *queue)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    return atomic_load_explicit(&queue->head, memory_order_acquire) - tail;
+}
+
+static void
+network_queue_publish(netqueue_t *queue)
+{
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+}
+
 int
 network_queue_put(netqueue_t *queue, uint8_t *data, int len)
 {
-    if (len == 0 || len > NET_MAX_FRAME || network_queue_full(queue)) {
+    netpkt_t *pkt;
+
+    if ((len == 0) || (len > NET_MAX_FRAME) || ((pkt = network_queue_slot(queue)) == NULL))
         return 0;
-    }
 
-    netpkt_t *pkt = &queue->packets[queue->head];
     memcpy(pkt->data, data, len);
-    pkt->len    = len;
-    queue->head = (queue->head + 1) & NET_QUEUE_LEN_MASK;
+    pkt->len = len;
+    network_queue_publish(queue);
     return 1;
 }
 
 int
 network_queue_put_swap(netqueue_t *queue, netpkt_t *src_pkt)
 {
-    if (src_pkt->len == 0 || src_pkt->len > NET_MAX_FRAME || network_queue_full(queue)) {
+    netpkt_t *dst_pkt;
+
+    if ((src_pkt->len == 0) || (src_pkt->len > NET_MAX_FRAME) || ((dst_pkt = network_queue_slot(queue)) == NULL)) {
 #ifdef DEBUG
         if (src_pkt->len == 0) {
             network_log("Discarded zero length packet.\n");
@@ -334,41 +391,45 @@ network_queue_put_swap(netqueue_t *queue, netpkt_t *src_pkt)
         return 0;
     }
 
-    netpkt_t *dst_pkt = &queue->packets[queue->head];
     network_swap_packet(src_pkt, dst_pkt);
-
-    queue->head = (queue->head + 1) & NET_QUEUE_LEN_MASK;
+    network_queue_publish(queue);
     return 1;
 }
 
 static int
 network_queue_get_swap(netqueue_t *queue, netpkt_t *dst_pkt)
 {
-    if (network_queue_empty(queue))
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    if (tail == atomic_load_explicit(&queue->head, memory_order_acquire))
         return 0;
 
-    netpkt_t *src_pkt = &queue->packets[queue->tail];
-    network_swap_packet(src_pkt, dst_pkt);
-    queue->tail = (queue->tail + 1) & NET_QUEUE_LEN_MASK;
+    network_swap_packet(&queue->packets[tail & queue->mask], dst_pkt);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
     return 1;
 }
 
 static int
 network_queue_move(netqueue_t *dst_q, netqueue_t *src_q)
 {
-    if (network_queue_empty(src_q))
+    uint32_t  src_tail = atomic_load_explicit(&src_q->tail, memory_order_relaxed);
+    uint32_t  dst_head = atomic_load_explicit(&dst_q->head, memory_order_relaxed);
+    netpkt_t *src_pkt;
+    netpkt_t *dst_pkt;
+
+    if (src_tail == atomic_load_explicit(&src_q->head, memory_order_acquire))
         return 0;
 
-    if (network_queue_full(dst_q)) {
+    /* Full is not a drop here, the packet waits in the source queue. */
+    if ((dst_head - atomic_load_explicit(&dst_q->tail, memory_order_acquire)) >= dst_q->size)
         return 0;
-    }
 
-    netpkt_t *src_pkt = &src_q->packets[src_q->tail];
-    netpkt_t *dst_pkt = &dst_q->packets[dst_q->head];
+    src_pkt = &src_q->packets[src_tail & src_q->mask];
+    dst_pkt = &dst_q->packets[dst_head & dst_q->mask];
 
     network_swap_packet(src_pkt, dst_pkt);
-    dst_q->head = (dst_q->head + 1) & NET_QUEUE_LEN_MASK;
-    src_q->tail = (src_q->tail + 1) & NET_QUEUE_LEN_MASK;
+    atomic_store_explicit(&dst_q->head, dst_head + 1, memory_order_release);
+    atomic_store_explicit(&src_q->tail, src_tail + 1, memory_order_release);
 
     return dst_pkt->len;
 }
@@ -376,11 +437,67 @@ network_queue_move(netqueue_t *dst_q, netqueue_t *src_q)
 void
 network_queue_clear(netqueue_t *queue)
 {
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
+    if (queue == NULL)
+        return;
+
+    for (uint32_t i = 0; i < queue->size; i++)
         free(queue->packets[i].data);
-        queue->packets[i].len = 0;
-    }
-    queue->tail = queue->head = 0;
+    free(queue->packets);
+    free(queue);
+}
+
+static uint32_t
+network_dropped(netcard_t *card)
+{
+    return card->queues[NET_QUEUE_RX]->dropped + card->queues[NET_QUEUE_RX_ON_TX]->dropped +
+           card->queues[NET_QUEUE_RX_LOCAL]->dropped + card->queues[NET_QUEUE_TX_VM]->dropped;
+}
+
+/* Report what went through the card's register and DMA paths, per second
+   of emulated time and along with the host time it took. */
+static void
+network_stats_report(netcard_t *card)
+{
+    double   secs    = card->stats_elapsed / 1000000.0;
+    uint32_t now     = plat_get_ticks();
+    uint32_t dropped = network_dropped(card);
+
+    pclog("NETWORK: card %i (%s): RX %.0f frames/s %.1f KB/s, TX %.0f frames/s %.1f KB/s, "
+          "%u dropped, %.1f emulated s in %u host ms\n",
+          card->card_num + 1, network_card_get_internal_name(net_cards_conf[card->card_num].device_num),
+          card->stats_rx_frames / secs, card->stats_rx_bytes / secs / 1024.0,
+          card->stats_tx_frames / secs, card->stats_tx_bytes / secs / 1024.0,
+          dropped - card->stats_dropped, secs, now - card->stats_host_ticks);
+
+    card->stats_elapsed    = 0.0;
+    card->stats_host_ticks = now;
+    card->stats_rx_frames  = 0;
+    card->stats_tx_frames  = 0;
+    card->stats_rx_bytes   = 0;
+    card->stats_tx_bytes   = 0;
+    card->stats_dropped    = dropped;
+}
+
+/* Fetch the next frame for the card. Frames from the host are what a replay
+   records, and are taken from the replay log when one is played back. */
+static int
+network_rx_next(netcard_t *card, int rx_hold)
+{
+    netpkt_t *pkt = &card->queued_pkt;
+
+    if (network_queue_get_swap(card->queues[NET_QUEUE_RX_LOCAL], pkt))
+        return 1;
+
+    if (replay_mode == REPLAY_PLAY)
+        return replay_net_rx(card->card_num, pkt->data, &pkt->len, NET_MAX_FRAME);
+
+    if (rx_hold || !network_queue_get_swap(card->queues[NET_QUEUE_RX], pkt))
+        return 0;
+
+    if (replay_mode == REPLAY_RECORD)
+        replay_net_log(card->card_num, pkt->data, pkt->len);
+
+    return 1;
 }
 
 static void
@@ -395,34 +512,46 @@ network_rx_queue(void *priv)
         card->link_state = new_link_state;
     }
 
-    uint32_t rx_bytes = 0;
+    /* Opt-in interrupt mitigation: let received packets gather for up to
+       the coalescing window, unless a full batch is already waiting. It
+       depends on the host queue, so it is off while inputs are replayed. */
+    int rx_hold = 0;
+    if (card->rx_coalesce && (replay_mode == REPLAY_OFF)) {
+        uint32_t pending = network_queue_count(card->queues[NET_QUEUE_RX]);
+
+        if (pending == 0)
+            card->rx_wait = 0.0;
+        else if ((pending < NET_QUEUE_LEN) && (card->rx_wait < card->rx_coalesce))
+            rx_hold = 1;
+    }
+
+    MTR_BEGIN("network", "network_rx_queue");
+
+    uint32_t rx_bytes  = 0;
+    uint32_t rx_frames = 0;
     for (int i = 0; i < NET_QUEUE_LEN; i++) {
-        if (card->queued_pkt.len == 0) {
-            thread_wait_mutex(card->rx_mutex);
-            int res = network_queue_get_swap(&card->queues[NET_QUEUE_RX], &card->queued_pkt);
-            thread_release_mutex(card->rx_mutex);
-            if (!res)
-                break;
-        }
+        if ((card->queued_pkt.len == 0) && !network_rx_next(card, rx_hold))
+            break;
 
         network_dump_packet(&card->queued_pkt);
         int res = card->rx(card->card_drv, card->queued_pkt.data, card->queued_pkt.len);
         if (!res)
             break;
         rx_bytes += card->queued_pkt.len;
+        rx_frames++;
         card->queued_pkt.len = 0;
     }
 
     /* Transmission. */
-    uint32_t tx_bytes = 0;
-    thread_wait_mutex(card->tx_mutex);
+    uint32_t tx_bytes  = 0;
+    uint32_t tx_frames = 0;
     for (int i = 0; i < NET_QUEUE_LEN; i++) {
-        uint32_t bytes = network_queue_move(&card->queues[NET_QUEUE_TX_HOST], &card->queues[NET_QUEUE_TX_VM]);
+        uint32_t bytes = network_queue_move(card->queues[NET_QUEUE_TX_HOST], card->queues[NET_QUEUE_TX_VM]);
         if (!bytes)
             break;
         tx_bytes += bytes;
+        tx_frames++;
     }
-    thread_release_mutex(card->tx_mutex);
     if (tx_bytes) {
         /* Notify host that a packet is available in the TX queue */
         card->host_drv.notify_in(card->host_drv.priv);
@@ -434,6 +563,24 @@ network_rx_queue(void *priv)
 
     timer_on_auto(&card->timer, timer_period);
 
+    if (rx_hold)
+        card->rx_wait += timer_period;
+    else
+        card->rx_wait = 0.0;
+
+    network_rx_packets += rx_frames;
+    network_tx_packets += tx_frames;
+
+    if (card->stats_interval) {
+        card->stats_rx_frames += rx_frames;
+        card->stats_tx_frames += tx_frames;
+        card->stats_rx_bytes += rx_bytes;
+        card->stats_tx_bytes += tx_bytes;
+        card->stats_elapsed += timer_period;
+        if (card->stats_elapsed >= (card->stats_interval * 1000000.0))
+            network_stats_report(card);
+    }
+
     bool activity = rx_bytes || tx_bytes;
     bool led_on   = card->led_timer & 0x80000000;
     if ((activity && !led_on) || (card->led_timer & 0x7fffffff) >= 150000) {
@@ -443,6 +590,8 @@ network_rx_queue(void *priv)
     }
 
     card->led_timer += timer_period;
+
+    MTR_END("network", "network_rx_queue");
 }
 
 /*
@@ -461,16 +610,16 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
     card->card_drv        = card_drv;
     card->rx              = rx;
     card->set_link_state  = set_link_state;
-    card->tx_mutex        = thread_create_mutex();
-    card->rx_mutex        = thread_create_mutex();
     card->card_num        = net_card_current;
     card->byte_period     = NET_PERIOD_10M;
+    card->rx_coalesce     = net_cards_conf[net_card_current].rx_coalesce;
+    card->stats_interval  = net_cards_conf[net_card_current].stats;
 
     char net_drv_error[NET_DRV_ERRBUF_SIZE];
     wchar_t tempmsg[NET_DRV_ERRBUF_SIZE * 2];
 
     for (int i = 0; i < NET_QUEUE_COUNT; i++) {
-        network_queue_init(&card->queues[i]);
+        card->queues[i] = network_queue_init(net_cards_conf[net_card_current].queue_len);
     }
 
     if ((!strcmp(network_card_get_internal_name(net_cards_conf[net_card_current].device_num), "modem") ||
@@ -508,6 +657,12 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
             card->host_drv.priv = card->host_drv.init(card, mac, &net_cards_conf[net_card_current], net_drv_error);
             break;
 #endif /* USE_NETSWITCH */
+#ifdef HAS_SHMSWITCH
+        case NET_TYPE_SHMSWITCH:
+            card->host_drv      = net_shmswitch_drv;
+            card->host_drv.priv = card->host_drv.init(card, mac, &net_cards_conf[net_card_current], net_drv_error);
+            break;
+#endif
         default:
             card->host_drv.priv = NULL;
             break;
@@ -543,10 +698,8 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
         // If null fails, something is very wrong
         // Clean up and fatal
         if(!card->host_drv.priv) {
-            thread_close_mutex(card->tx_mutex);
-            thread_close_mutex(card->rx_mutex);
             for (int i = 0; i < NET_QUEUE_COUNT; i++) {
-                network_queue_clear(&card->queues[i]);
+                network_queue_clear(card->queues[i]);
             }
 
             free(card->queued_pkt.data);
@@ -558,6 +711,8 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
 
     }
 
+    card->stats_host_ticks = plat_get_ticks();
+
     timer_add(&card->timer, network_rx_queue, card, 0);
     timer_on_auto(&card->timer, 100);
 
@@ -567,13 +722,24 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
 void
 netcard_close(netcard_t *card)
 {
+    uint32_t rx_dropped;
+    uint32_t tx_dropped;
+
     timer_stop(&card->timer);
     card->host_drv.close(card->host_drv.priv);
 
-    thread_close_mutex(card->tx_mutex);
-    thread_close_mutex(card->rx_mutex);
+    if (card->stats_interval && (card->stats_elapsed > 0.0))
+        network_stats_report(card);
+
+    rx_dropped = card->queues[NET_QUEUE_RX]->dropped + card->queues[NET_QUEUE_RX_ON_TX]->dropped +
+                 card->queues[NET_QUEUE_RX_LOCAL]->dropped;
+    tx_dropped = card->queues[NET_QUEUE_TX_VM]->dropped;
+    if (rx_dropped || tx_dropped)
+        pclog("NETWORK: card %i dropped %u received and %u transmitted packets on full queues\n",
+              card->card_num + 1, rx_dropped, tx_dropped);
+
     for (int i = 0; i < NET_QUEUE_COUNT; i++) {
-        network_queue_clear(&card->queues[i]);
+        network_queue_clear(card->queues[i]);
     }
 
     free(card->queued_pkt.data);
@@ -626,19 +792,40 @@ network_reset(void)
 void
 network_tx(netcard_t *card, uint8_t *bufp, int len)
 {
-    network_queue_put(&card->queues[NET_QUEUE_TX_VM], bufp, len);
+    network_queue_put(card->queues[NET_QUEUE_TX_VM], bufp, len);
 }
 
-int
-network_tx_pop(netcard_t *card, netpkt_t *out_pkt)
+/*
+ * Zero-copy transmission: the card assembles the frame (NET_MAX_FRAME
+ * bytes at most) straight into the free slot of its queue and then
+ * commits it; from there the buffer is only swapped until the host driver
+ * sends it. Returns NULL, and counts a drop, when the queue is full.
+ */
+uint8_t *
+network_tx_buffer(netcard_t *card)
 {
-    int ret = 0;
+    netpkt_t *pkt = network_queue_slot(card->queues[NET_QUEUE_TX_VM]);
 
-    thread_wait_mutex(card->tx_mutex);
-    ret = network_queue_get_swap(&card->queues[NET_QUEUE_TX_HOST], out_pkt);
-    thread_release_mutex(card->tx_mutex);
+    return (pkt != NULL) ? pkt->data : NULL;
+}
 
-    return ret;
+void
+network_tx_commit(netcard_t *card, int len)
+{
+    netqueue_t *queue = card->queues[NET_QUEUE_TX_VM];
+    uint32_t    head  = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    if ((len == 0) || (len > NET_MAX_FRAME))
+        return;
+
+    queue->packets[head & queue->mask].len = len;
+    network_queue_publish(queue);
+}
+
+int
+network_tx_pop(netcard_t *card, netpkt_t *out_pkt)
+{
+    return network_queue_get_swap(card->queues[NET_QUEUE_TX_HOST], out_pkt);
 }
 
 int
@@ -646,8 +833,7 @@ network_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size)
 {
     int pkt_count = 0;
 
-    netqueue_t *queue = &card->queues[NET_QUEUE_TX_HOST];
-    thread_wait_mutex(card->tx_mutex);
+    netqueue_t *queue = card->queues[NET_QUEUE_TX_HOST];
     for (int i = 0; i < vec_size; i++) {
         if (!network_queue_get_swap(queue, pkt_vec))
             break;
@@ -655,21 +841,15 @@ network_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size)
         pkt_count++;
         pkt_vec++;
     }
-    thread_release_mutex(card->tx_mutex);
 
     return pkt_count;
 }
 
+/* Loop a packet back from the card itself, on the emulation thread. */
 int
 network_rx_put(netcard_t *card, uint8_t *bufp, int len)
 {
-    int ret = 0;
-
-    thread_wait_mutex(card->rx_mutex);
-    ret = network_queue_put(&card->queues[NET_QUEUE_RX], bufp, len);
-    thread_release_mutex(card->rx_mutex);
-
-    return ret;
+    return network_queue_put(card->queues[NET_QUEUE_RX_LOCAL], bufp, len);
 }
 
 int
@@ -677,7 +857,7 @@ network_rx_on_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size)
 {
     int pkt_count = 0;
 
-    netqueue_t *queue = &card->queues[NET_QUEUE_RX_ON_TX];
+    netqueue_t *queue = card->queues[NET_QUEUE_RX_ON_TX];
     for (int i = 0; i < vec_size; i++) {
         if (!network_queue_get_swap(queue, pkt_vec))
             break;
@@ -694,7 +874,7 @@ network_rx_on_tx_put(netcard_t *card, uint8_t *bufp, int len)
 {
     int ret = 0;
 
-    ret = network_queue_put(&card->queues[NET_QUEUE_RX_ON_TX], bufp, len);
+    ret = network_queue_put(card->queues[NET_QUEUE_RX_ON_TX], bufp, len);
 
     return ret;
 }
@@ -704,7 +884,7 @@ network_rx_on_tx_put_pkt(netcard_t *card, netpkt_t *pkt)
 {
     int ret = 0;
 
-    ret = network_queue_put_swap(&card->queues[NET_QUEUE_RX_ON_TX], pkt);
+    ret = network_queue_put_swap(card->queues[NET_QUEUE_RX_ON_TX], pkt);
 
     return ret;
 }
@@ -712,13 +892,7 @@ network_rx_on_tx_put_pkt(netcard_t *card, netpkt_t *pkt)
 int
 network_rx_put_pkt(netcard_t *card, netpkt_t *pkt)
 {
-    int ret = 0;
-
-    thread_wait_mutex(card->rx_mutex);
-    ret = network_queue_put_swap(&card->queues[NET_QUEUE_RX], pkt);
-    thread_release_mutex(card->rx_mutex);
-
-    return ret;
+    return network_queue_put_swap(card->queues[NET_QUEUE_RX], pkt);
 }
 
 void
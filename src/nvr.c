@@ -57,6 +57,7 @@
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/nvr.h>
+#include <86box/replay.h>
 
 int nvr_dosave; /* NVR is dirty, needs saved */
 
@@ -310,9 +311,14 @@ nvr_time_sync(void)
 {
     struct tm tm;
     time_t    now;
+    int64_t   base;
 
-    /* Get the current time of day, and convert to local time. */
-    (void) time(&now);
+    /* Get the current time of day, and convert to local time. Recorded
+       runs all start from the time of day of the recording. */
+    if (replay_rtc_time(&base))
+        now = (time_t) base;
+    else
+        (void) time(&now);
 
 #ifdef _WIN32
     if (time_sync & TIME_SYNC_UTC)
@@ -219,6 +219,7 @@
  */
 #include <inttypes.h>
 #include <stdio.h>
+#include <math.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
@@ -323,6 +324,8 @@ typedef struct local_t {
 
     uint64_t   ecount;
     uint64_t   rtc_time;
+    uint64_t   period;  /* periodic interrupt rate, 32:32 */
+    double     pf_next; /* tsc of the next periodic edge, while rtc_timer is stopped */
     pc_timer_t update_timer;
     pc_timer_t rtc_timer;
 } local_t;
@@ -502,6 +505,56 @@ timer_update(void *priv)
     }
 }
 
+/*
+ * The periodic timer only runs while it can raise an interrupt. With PIE
+ * clear, the time of the next edge is kept instead and the periodic flag
+ * is worked out from it when register C is read.
+ */
+static void
+timer_periodic_stop(local_t *local)
+{
+    if (timer_is_enabled(&local->rtc_timer)) {
+        local->pf_next = (double) tsc + (timer_get_remaining_u64(&local->rtc_timer) / 4294967296.0);
+        timer_disable(&local->rtc_timer);
+    }
+}
+
+static void
+timer_periodic_catch_up(nvr_t *nvr)
+{
+    local_t *local = (local_t *) nvr->data;
+    double   period;
+    double   now;
+
+    if ((local->state != 1) || timer_is_enabled(&local->rtc_timer))
+        return;
+
+    now = (double) tsc;
+    if (now >= local->pf_next) {
+        period = local->period / 4294967296.0;
+        local->pf_next += (floor((now - local->pf_next) / period) + 1.0) * period;
+
+        nvr->regs[RTC_REGC] |= REGC_PF;
+    }
+}
+
+static void
+timer_periodic_update(nvr_t *nvr)
+{
+    local_t *local = (local_t *) nvr->data;
+    double   delay;
+
+    timer_periodic_stop(local);
+    timer_periodic_catch_up(nvr);
+
+    if ((local->state == 1) && (nvr->regs[RTC_REGB] & REGB_PIE)) {
+        delay = local->pf_next - (double) tsc;
+        if (delay < 0.0)
+            delay = 0.0;
+        timer_set_delay_u64(&local->rtc_timer, (uint64_t) (delay * 4294967296.0));
+    }
+}
+
 static void
 timer_load_count(nvr_t *nvr)
 {
@@ -524,23 +577,27 @@ timer_load_count(nvr_t *nvr)
         case 1:
         case 2:
             local->count = 1 << (c + 6);
-            timer_set_delay_u64(&local->rtc_timer, (local->count) * RTCCONST);
             break;
         default:
             local->count = 1 << (c - 1);
-            timer_set_delay_u64(&local->rtc_timer, (local->count) * RTCCONST);
             break;
     }
+
+    if (local->state == 1) {
+        local->period  = local->count * RTCCONST;
+        local->pf_next = (double) tsc + (local->period / 4294967296.0);
+        timer_periodic_update(nvr);
+    }
 }
 
 static void
 timer_intr(void *priv)
 {
-    nvr_t         *nvr   = (nvr_t *) priv;
-    const local_t *local = (local_t *) nvr->data;
+    nvr_t   *nvr   = (nvr_t *) priv;
+    local_t *local = (local_t *) nvr->data;
 
     if (local->state == 1) {
-        timer_load_count(nvr);
+        timer_advance_u64(&local->rtc_timer, local->period);
 
         nvr->regs[RTC_REGC] |= REGC_PF;
         timer_update_irq(nvr);
@@ -617,6 +674,8 @@ nvr_reg_write(uint16_t reg, uint8_t val, void *priv)
             }
 
             nvr->regs[RTC_REGB] = val;
+            if ((old ^ val) & REGB_PIE)
+                timer_periodic_update(nvr);
             timer_update_irq(nvr);
             break;
 
@@ -723,6 +782,7 @@ nvr_read(uint16_t addr, void *priv)
                 break;
 
             case RTC_REGC:
+                timer_periodic_catch_up(nvr);
                 ret = nvr->regs[RTC_REGC] & (REGC_IRQF | REGC_PF | REGC_AF | REGC_UF);
                 nvr->regs[RTC_REGC] &= ~(REGC_IRQF | REGC_PF | REGC_AF | REGC_UF);
                 timer_update_irq(nvr);
@@ -1068,6 +1128,8 @@ nvr_at_reset(void *priv)
     /* These bits are reset on reset. */
     nvr->regs[RTC_REGB] &= ~(REGB_PIE | REGB_AIE | REGB_UIE | REGB_SQWE);
     nvr->regs[RTC_REGC] &= ~(REGC_PF | REGC_AF | REGC_UF | REGC_IRQF);
+
+    timer_periodic_stop((local_t *) nvr->data);
 }
 
 static void *
@@ -357,6 +357,33 @@ pci_reg_write(uint16_t port, uint8_t val)
             pci_card, pci_bus, pci_func, pci_index | (port & 0x03), val);
 }
 
+/* Aligned 32-bit configuration write, the bytes still go to the card in
+   ascending order as with four pci_write() calls. */
+static void
+pci_reg_writel(uint16_t port, uint32_t val)
+{
+    pci_card_t *dev;
+    uint8_t     slot = 0;
+
+    if (port >= 0xc000) {
+        pci_card  = (port >> 8) & 0xf;
+        pci_index = port & 0xfc;
+    }
+
+    slot = pci_card_to_slot_mapping[pci_bus_number_to_index_mapping[pci_bus]][pci_card];
+    if ((slot != PCI_CARD_INVALID) && pci_cards[slot].write) {
+        dev = &pci_cards[slot];
+        dev->write(pci_func, pci_index, val & 0xff, dev->priv);
+        dev->write(pci_func, pci_index | 1, (val >> 8) & 0xff, dev->priv);
+        dev->write(pci_func, pci_index | 2, (val >> 16) & 0xff, dev->priv);
+        dev->write(pci_func, pci_index | 3, val >> 24, dev->priv);
+    }
+    pci_log("PCI: [WL] Mechanism #%i, slot %02X, %s card %02X:%02X, function %02X, index %02X = %08X\n",
+            (port >= 0xc000) ? 2 : 1, slot,
+            (slot == PCI_CARD_INVALID) ? "non-existent" : (pci_cards[slot].write ? "used" : "unused"),
+            pci_card, pci_bus, pci_func, pci_index, val);
+}
+
 static void
 pci_reset_regs(void)
 {
@@ -543,10 +570,16 @@ pci_writel(uint16_t port, uint32_t val, UNUSED(void *priv))
                 }
                 break;
             case 0xcfc:
-            case 0xc000 ... 0xcffc:
-                /* Still split because we cheat. */
-                pci_writew(port, val & 0xffff, priv);
-                pci_writew(port + 2, val >> 16, priv);
+                if ((pci_flags & FLAG_MECHANISM_1) && (pci_flags & FLAG_CONFIG_M1_IO_ON))
+                    pci_reg_writel(port, val);
+                break;
+            case 0xc000 ... 0xc0fc:
+                if ((pci_flags & FLAG_MECHANISM_2) && (pci_flags & (FLAG_CONFIG_IO_ON | FLAG_CONFIG_DEV0_IO_ON)))
+                    pci_reg_writel(port, val);
+                break;
+            case 0xc100 ... 0xcffc:
+                if ((pci_flags & FLAG_MECHANISM_2) && (pci_flags & FLAG_CONFIG_IO_ON))
+                    pci_reg_writel(port, val);
                 break;
 
             default:
@@ -579,6 +612,36 @@ pci_reg_read(uint16_t port)
     return ret;
 }
 
+/* Aligned 32-bit configuration read, resolves the card once instead of
+   going through pci_read() for each byte. */
+static uint32_t
+pci_reg_readl(uint16_t port)
+{
+    pci_card_t *dev;
+    uint8_t     slot = 0;
+    uint32_t    ret  = 0xffffffff;
+
+    if (port >= 0xc000) {
+        pci_card  = (port >> 8) & 0xf;
+        pci_index = port & 0xfc;
+    }
+
+    slot = pci_card_to_slot_mapping[pci_bus_number_to_index_mapping[pci_bus]][pci_card];
+    if ((slot != PCI_CARD_INVALID) && pci_cards[slot].read) {
+        dev = &pci_cards[slot];
+        ret = dev->read(pci_func, pci_index, dev->priv);
+        ret |= ((uint32_t) dev->read(pci_func, pci_index | 1, dev->priv)) << 8;
+        ret |= ((uint32_t) dev->read(pci_func, pci_index | 2, dev->priv)) << 16;
+        ret |= ((uint32_t) dev->read(pci_func, pci_index | 3, dev->priv)) << 24;
+    }
+    pci_log("PCI: [RL] Mechanism #%i, slot %02X, %s card %02X:%02X, function %02X, index %02X = %08X\n",
+            (port >= 0xc000) ? 2 : 1, slot,
+            (slot == PCI_CARD_INVALID) ? "non-existent" : (pci_cards[slot].read ? "used" : "unused"),
+            pci_card, pci_bus, pci_func, pci_index, ret);
+
+    return ret;
+}
+
 uint8_t
 pci_read(uint16_t port, UNUSED(void *priv))
 {
@@ -680,10 +743,16 @@ pci_readl(uint16_t port, UNUSED(void *priv))
                 }
                 break;
             case 0xcfc:
-            case 0xc000 ... 0xcffc:
-                /* Still split because we cheat. */
-                ret = pci_readw(port, priv);
-                ret |= ((uint32_t) pci_readw(port + 2, priv)) << 16;
+                if ((pci_flags & FLAG_MECHANISM_1) && (pci_flags & FLAG_CONFIG_M1_IO_ON))
+                    ret = pci_reg_readl(port);
+                break;
+            case 0xc000 ... 0xc0fc:
+                if ((pci_flags & FLAG_MECHANISM_2) && (pci_flags & (FLAG_CONFIG_IO_ON | FLAG_CONFIG_DEV0_IO_ON)))
+                    ret = pci_reg_readl(port);
+                break;
+            case 0xc100 ... 0xcffc:
+                if ((pci_flags & FLAG_MECHANISM_2) && (pci_flags & FLAG_CONFIG_IO_ON))
+                    ret = pci_reg_readl(port);
                 break;
         }
     }
@@ -17,6 +17,7 @@
  */
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,6 +32,7 @@
 #include <86box/pci.h>
 #include <86box/pic.h>
 #include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/pit.h>
 #include <86box/device.h>
 #include <86box/apm.h>
@@ -278,6 +280,40 @@ pic_reset(void)
     pic_pci = 0;
 }
 
+void
+pic_save_state(snapshot_t *snap)
+{
+    snapshot_write(snap, &pic, offsetof(pic_t, slaves));
+    snapshot_write(snap, &pic2, offsetof(pic_t, slaves));
+    snapshot_write_var(snap, shadow);
+    snapshot_write_var(snap, pic_pci);
+    snapshot_write_var(snap, kbd_latch);
+    snapshot_write_var(snap, mouse_latch);
+    snapshot_write_var(snap, smi_irq_mask);
+    snapshot_write_var(snap, smi_irq_status);
+    snapshot_write_var(snap, latched_irqs);
+    snapshot_write_timer(snap, &pic_timer);
+}
+
+int
+pic_load_state(snapshot_t *snap)
+{
+    /* The slave pointers are set up by pic_reset() and stay as they are. */
+    if (!snapshot_read(snap, &pic, offsetof(pic_t, slaves)) ||
+        !snapshot_read(snap, &pic2, offsetof(pic_t, slaves)))
+        return 0;
+
+    snapshot_read_var(snap, shadow);
+    snapshot_read_var(snap, pic_pci);
+    snapshot_read_var(snap, kbd_latch);
+    snapshot_read_var(snap, mouse_latch);
+    snapshot_read_var(snap, smi_irq_mask);
+    snapshot_read_var(snap, smi_irq_status);
+    snapshot_read_var(snap, latched_irqs);
+
+    return snapshot_read_timer(snap, &pic_timer);
+}
+
 void
 pic_set_shadow(int sh)
 {
@@ -504,12 +540,15 @@ static void
 pic_write(uint16_t addr, uint8_t val, void *priv)
 {
     pic_t *dev = (pic_t *) priv;
+    int    old_state;
 
     pic_log("pic_write(%04X, %02X, %08X)\n", addr, val, priv);
 
     dev->data_bus = val;
 
     if (addr & 0x0001) {
+        old_state = dev->state;
+
         switch (dev->state) {
             case STATE_ICW2:
                 dev->icw2 = val;
@@ -537,6 +576,11 @@ pic_write(uint16_t addr, uint8_t val, void *priv)
             default:
                 break;
         }
+
+        /* Requests latched while the ICW sequence was in progress can only
+           be delivered now, so do not wait for the next IRR change. */
+        if ((old_state != STATE_NONE) && (dev->state == STATE_NONE))
+            update_pending();
     } else {
         if (val & 0x10) {
             /* Treat any write with any of the bits 7 to 5 set as invalid if PCI. */
@@ -689,6 +733,8 @@ picint_common(uint16_t num, int level, int set, uint8_t *irq_state)
     uint8_t slaves = 0;
     uint16_t w;
     uint16_t lines = level ? 0x0000 : num;
+    uint8_t  irr   = pic.irr;
+    uint8_t  irr2  = pic2.irr;
     pic_t   *dev;
 
     /*
@@ -797,7 +843,10 @@ picint_common(uint16_t num, int level, int set, uint8_t *irq_state)
             }
         }
 
-        update_pending();
+        /* Raising an IRQ that is already requested or lowering one that is
+           not is very common, and leaves the pending interrupt as it is. */
+        if ((pic.irr != irr) || (pic2.irr != irr2))
+            update_pending();
     }
 }
 
@@ -76,6 +76,74 @@ pitf_ctr_set_out(ctrf_t *ctr, int out, void *priv)
     ctr->out = out;
 }
 
+static uint64_t
+pitf_get_remaining(ctrf_t *ctr)
+{
+    uint64_t now;
+
+    if (!ctr->lazy)
+        return timer_get_remaining_u64(&ctr->timer);
+
+    now = (uint64_t) tsc << 32;
+    if (now < ctr->lazy_ts)
+        return ctr->lazy_ts - now;
+
+    return ctr->lazy_period - ((now - ctr->lazy_ts) % ctr->lazy_period);
+}
+
+static int
+pitf_read_timer(ctrf_t *ctr)
+{
+    if (ctr->using_timer && !(ctr->m == 3 && !ctr->gate) && (timer_is_enabled(&ctr->timer) || ctr->lazy)) {
+        int read = (int) (pitf_get_remaining(ctr) / ctr->pit_const);
+        if (ctr->m == 2)
+            read++;
+        if (read < 0)
+            read = 0;
+        if (read > 0x10000)
+            read = 0x10000;
+        if ((ctr->m == 3) && ctr->using_timer)
+            read <<= 1;
+        return read;
+    }
+    if (ctr->m == 2)
+        return ctr->count + 1;
+    return ctr->count;
+}
+
+/*Dump timer count back to pit->count[], and disable timer. This should be used
+  when stopping a PIT timer, to ensure the correct value can be read back.*/
+static void
+pitf_dump_and_disable_timer(ctrf_t *ctr)
+{
+    if (ctr->using_timer && (timer_is_enabled(&ctr->timer) || ctr->lazy)) {
+        ctr->count = pitf_read_timer(ctr);
+        if (ctr->m == 2)
+            ctr->count--; /* Don't store the offset from pitf_read_timer */
+        timer_disable(&ctr->timer);
+        ctr->lazy = 0;
+    }
+}
+
+static __inline void
+pitf_ctr_set_delay(ctrf_t *ctr, uint64_t delay)
+{
+    ctr->lazy = 0;
+    timer_set_delay_u64(&ctr->timer, delay);
+}
+
+/*Called from the timer callback instead of advancing the timer, when the next
+  reloads can't change the output or nobody listens to it. The count keeps
+  running and is worked out from tsc when read.*/
+static void
+pitf_ctr_set_lazy(ctrf_t *ctr, int period)
+{
+    ctr->lazy_period = (uint64_t) (period * ctr->pit_const);
+    ctr->lazy_ts     = ctr->timer.ts.ts64 + ctr->lazy_period;
+    ctr->lazy        = 1;
+    timer_disable(&ctr->timer);
+}
+
 static void
 pitf_ctr_set_load_func(void *data, int counter_id, void (*func)(uint8_t new_m, int new_count))
 {
@@ -106,6 +174,10 @@ pitf_ctr_set_out_func(void *data, int counter_id, void (*func)(int new_out, int
     pitf_t *pit = (pitf_t *) data;
     ctrf_t *ctr = &pit->counters[counter_id];
 
+    /* A lazy rate generator has to tick again once somebody listens. */
+    if ((func != NULL) && ctr->lazy && !ctr->thit && !ctr->disabled)
+        pitf_ctr_set_delay(ctr, pitf_get_remaining(ctr));
+
     ctr->out_func = func;
 }
 
@@ -117,42 +189,11 @@ pitf_ctr_set_using_timer(void *data, int counter_id, int using_timer)
 
     pitf_t *pit      = (pitf_t *) data;
     ctrf_t *ctr      = &pit->counters[counter_id];
+    if (!using_timer && ctr->lazy)
+        pitf_dump_and_disable_timer(ctr);
     ctr->using_timer = using_timer;
 }
 
-static int
-pitf_read_timer(ctrf_t *ctr)
-{
-    if (ctr->using_timer && !(ctr->m == 3 && !ctr->gate) && timer_is_enabled(&ctr->timer)) {
-        int read = (int) ((timer_get_remaining_u64(&ctr->timer)) / ctr->pit_const);
-        if (ctr->m == 2)
-            read++;
-        if (read < 0)
-            read = 0;
-        if (read > 0x10000)
-            read = 0x10000;
-        if ((ctr->m == 3) && ctr->using_timer)
-            read <<= 1;
-        return read;
-    }
-    if (ctr->m == 2)
-        return ctr->count + 1;
-    return ctr->count;
-}
-
-/*Dump timer count back to pit->count[], and disable timer. This should be used
-  when stopping a PIT timer, to ensure the correct value can be read back.*/
-static void
-pitf_dump_and_disable_timer(ctrf_t *ctr)
-{
-    if (ctr->using_timer && timer_is_enabled(&ctr->timer)) {
-        ctr->count = pitf_read_timer(ctr);
-        if (ctr->m == 2)
-            ctr->count--; /* Don't store the offset from pitf_read_timer */
-        timer_disable(&ctr->timer);
-    }
-}
-
 static void
 pitf_ctr_load(ctrf_t *ctr, void *priv)
 {
@@ -166,7 +207,7 @@ pitf_ctr_load(ctrf_t *ctr, void *priv)
         case 0: /*Interrupt on terminal count*/
             ctr->count = l;
             if (ctr->using_timer)
-                timer_set_delay_u64(&ctr->timer, (uint64_t) (l * ctr->pit_const));
+                pitf_ctr_set_delay(ctr, (uint64_t) (l * ctr->pit_const));
             pitf_ctr_set_out(ctr, 0, pit);
             ctr->thit    = 0;
             ctr->enabled = ctr->gate;
@@ -178,7 +219,7 @@ pitf_ctr_load(ctrf_t *ctr, void *priv)
             if (ctr->initial) {
                 ctr->count = l - 1;
                 if (ctr->using_timer)
-                    timer_set_delay_u64(&ctr->timer, (uint64_t) ((l - 1) * ctr->pit_const));
+                    pitf_ctr_set_delay(ctr, (uint64_t) ((l - 1) * ctr->pit_const));
                 pitf_ctr_set_out(ctr, 1, pit);
                 ctr->thit = 0;
             }
@@ -188,7 +229,7 @@ pitf_ctr_load(ctrf_t *ctr, void *priv)
             if (ctr->initial) {
                 ctr->count = l;
                 if (ctr->using_timer)
-                    timer_set_delay_u64(&ctr->timer, (uint64_t) (((l + 1) >> 1) * ctr->pit_const));
+                    pitf_ctr_set_delay(ctr, (uint64_t) (((l + 1) >> 1) * ctr->pit_const));
                 else
                     ctr->newcount = (l & 1);
                 pitf_ctr_set_out(ctr, 1, pit);
@@ -202,7 +243,7 @@ pitf_ctr_load(ctrf_t *ctr, void *priv)
             else {
                 ctr->count = l;
                 if (ctr->using_timer)
-                    timer_set_delay_u64(&ctr->timer, (uint64_t) (l * ctr->pit_const));
+                    pitf_ctr_set_delay(ctr, (uint64_t) (l * ctr->pit_const));
                 pitf_ctr_set_out(ctr, 0, pit);
                 ctr->thit = 0;
             }
@@ -240,7 +281,7 @@ pitf_set_gate_no_timer(ctrf_t *ctr, int gate, void *priv)
         case 0: /*Interrupt on terminal count*/
         case 4: /*Software triggered stobe*/
             if (ctr->using_timer && !ctr->running)
-                timer_set_delay_u64(&ctr->timer, (uint64_t) (l * ctr->pit_const));
+                pitf_ctr_set_delay(ctr, (uint64_t) (l * ctr->pit_const));
             ctr->enabled = gate;
             break;
         case 1: /*Hardware retriggerable one-shot*/
@@ -248,7 +289,7 @@ pitf_set_gate_no_timer(ctrf_t *ctr, int gate, void *priv)
             if (gate && !ctr->gate) {
                 ctr->count = l;
                 if (ctr->using_timer)
-                    timer_set_delay_u64(&ctr->timer, (uint64_t) (l * ctr->pit_const));
+                    pitf_ctr_set_delay(ctr, (uint64_t) (l * ctr->pit_const));
                 pitf_ctr_set_out(ctr, 0, pit);
                 ctr->thit    = 0;
                 ctr->enabled = 1;
@@ -258,7 +299,7 @@ pitf_set_gate_no_timer(ctrf_t *ctr, int gate, void *priv)
             if (gate && !ctr->gate) {
                 ctr->count = l - 1;
                 if (ctr->using_timer)
-                    timer_set_delay_u64(&ctr->timer, (uint64_t) (l * ctr->pit_const));
+                    pitf_ctr_set_delay(ctr, (uint64_t) (l * ctr->pit_const));
                 pitf_ctr_set_out(ctr, 1, pit);
                 ctr->thit = 0;
             }
@@ -268,7 +309,7 @@ pitf_set_gate_no_timer(ctrf_t *ctr, int gate, void *priv)
             if (gate && !ctr->gate) {
                 ctr->count = l;
                 if (ctr->using_timer)
-                    timer_set_delay_u64(&ctr->timer, (uint64_t) (((l + 1) >> 1) * ctr->pit_const));
+                    pitf_ctr_set_delay(ctr, (uint64_t) (((l + 1) >> 1) * ctr->pit_const));
                 else
                     ctr->newcount = (l & 1);
                 pitf_ctr_set_out(ctr, 1, pit);
@@ -308,7 +349,7 @@ pitf_over(ctrf_t *ctr, void *priv)
     if (ctr->disabled) {
         ctr->count += 0xffff;
         if (ctr->using_timer)
-            timer_advance_u64(&ctr->timer, (uint64_t) (0xffff * ctr->pit_const));
+            pitf_ctr_set_lazy(ctr, 0xffff);
         return;
     }
 
@@ -320,11 +361,13 @@ pitf_over(ctrf_t *ctr, void *priv)
             ctr->thit = 1;
             ctr->count += 0xffff;
             if (ctr->using_timer)
-                timer_advance_u64(&ctr->timer, (uint64_t) (0xffff * ctr->pit_const));
+                pitf_ctr_set_lazy(ctr, 0xffff);
             break;
         case 2: /*Rate generator*/
             ctr->count += l;
-            if (ctr->using_timer)
+            if (ctr->using_timer && (ctr->out_func == NULL))
+                pitf_ctr_set_lazy(ctr, l);
+            else if (ctr->using_timer)
                 timer_advance_u64(&ctr->timer, (uint64_t) (l * ctr->pit_const));
             pitf_ctr_set_out(ctr, 0, pit);
             pitf_ctr_set_out(ctr, 1, pit);
@@ -369,7 +412,7 @@ pitf_over(ctrf_t *ctr, void *priv)
                 ctr->thit = 1;
                 ctr->count += 0xffff;
                 if (ctr->using_timer)
-                    timer_advance_u64(&ctr->timer, (uint64_t) (0xffff * ctr->pit_const));
+                    pitf_ctr_set_lazy(ctr, 0xffff);
             }
             break;
         case 5: /*Hardware triggered strove*/
@@ -380,7 +423,7 @@ pitf_over(ctrf_t *ctr, void *priv)
             ctr->thit = 1;
             ctr->count += 0xffff;
             if (ctr->using_timer)
-                timer_advance_u64(&ctr->timer, (uint64_t) (0xffff * ctr->pit_const));
+                pitf_ctr_set_lazy(ctr, 0xffff);
             break;
 
         default:
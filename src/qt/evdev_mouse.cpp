@@ -45,6 +45,11 @@ evdev_thread_func()
     }
 
     while (!stopped) {
+        /* Add up everything the kernel has queued on all the mice, the machine
+           only sees the sum at its next report anyway. */
+        int delta_x = 0;
+        int delta_y = 0;
+
         poll(pfds, evdev_mice.size(), 500);
         for (unsigned int i = 0; i < evdev_mice.size(); i++) {
             struct input_event ev;
@@ -52,13 +57,16 @@ evdev_thread_func()
                 while (libevdev_next_event(evdev_mice[i].second, LIBEVDEV_READ_FLAG_NORMAL, &ev) == 0) {
                     if (evdev_mice.size() && (ev.type == EV_REL) && mouse_capture) {
                         if (ev.code == REL_X)
-                            mouse_scale_x(ev.value);
+                            delta_x += ev.value;
                         if (ev.code == REL_Y)
-                            mouse_scale_y(ev.value);
+                            delta_y += ev.value;
                     }
                 }
             }
         }
+
+        if (delta_x || delta_y)
+            mouse_scale(delta_x, delta_y);
     }
 
     for (unsigned int i = 0; i < evdev_mice.size(); i++) {
@@ -21,6 +21,7 @@ extern "C" {
 #include <86box/timer.h>
 #include <86box/86box.h>
 #include <86box/device.h>
+#include <86box/device_prof.h>
 #include <86box/cartridge.h>
 #include <86box/cassette.h>
 #include <86box/cdrom.h>
@@ -319,17 +320,23 @@ struct MachineStatus::States {
     std::array<StateActive, HDD_BUS_USB>       hdds;
     std::array<StateEmptyActive, NET_CARD_MAX> net;
     std::unique_ptr<ClickableLabel>            sound;
+    std::unique_ptr<QLabel>                    prof;
     std::unique_ptr<QLabel>                    text;
 };
 
 MachineStatus::MachineStatus(QObject *parent)
     : QObject(parent)
     , refreshTimer(new QTimer(this))
+    , profileTimer(new QTimer(this))
 {
     d         = std::make_unique<MachineStatus::States>(this);
     soundMenu = nullptr;
     connect(refreshTimer, &QTimer::timeout, this, &MachineStatus::refreshIcons);
     refreshTimer->start(75);
+    if (device_profile) {
+        connect(profileTimer, &QTimer::timeout, this, &MachineStatus::refreshDeviceProfile);
+        profileTimer->start(1000);
+    }
 }
 
 MachineStatus::~MachineStatus() = default;
@@ -545,6 +552,40 @@ MachineStatus::refreshIcons()
     }
 }
 
+void
+MachineStatus::refreshDeviceProfile()
+{
+    device_prof_stat_t stats[8];
+    uint64_t           window_ns = 0;
+    int                count     = device_prof_get(stats, 8, &window_ns);
+    QString            tip;
+
+    if (!d->prof || !window_ns)
+        return;
+
+    /* Share of one host core over the last second, for the hottest devices. */
+    auto pct = [window_ns](uint64_t ns) { return QString::number(100.0 * ns / window_ns, 'f', 1); };
+
+    if (count == 0) {
+        d->prof->setText(tr("Devices: idle"));
+        d->prof->setToolTip(tr("Host time per device"));
+        return;
+    }
+
+    d->prof->setText(QString("%1: %2%").arg(QString(stats[0].name), pct(stats[0].total_ns)));
+
+    tip = tr("Host time per device");
+    for (int i = 0; i < count; i++) {
+        tip += QString("\n%1: %2% (%3 %4%, %5 %6%, %7 %8%, %9 %10%)")
+                   .arg(QString(stats[i].name), pct(stats[i].total_ns),
+                        tr("I/O"), pct(stats[i].ns[DEVICE_PROF_IO]),
+                        tr("MMIO"), pct(stats[i].ns[DEVICE_PROF_MMIO]),
+                        tr("Timers"), pct(stats[i].ns[DEVICE_PROF_TIMER]))
+                   .arg(tr("Worker"), pct(stats[i].ns[DEVICE_PROF_WORKER]));
+    }
+    d->prof->setToolTip(tip);
+}
+
 void
 MachineStatus::clearActivity()
 {
@@ -871,6 +912,11 @@ MachineStatus::refresh(QStatusBar *sbar)
 
     d->sound->setToolTip(tr("Sound"));
     sbar->addWidget(d->sound.get());
+    if (device_profile) {
+        d->prof = std::make_unique<QLabel>();
+        d->prof->setToolTip(tr("Host time per device"));
+        sbar->addWidget(d->prof.get());
+    }
     d->text = std::make_unique<QLabel>();
     sbar->addWidget(d->text.get());
 
@@ -85,12 +85,14 @@ public slots:
     void updateTip(int tag);
     void refreshEmptyIcons();
     void refreshIcons();
+    void refreshDeviceProfile();
     void updateSoundIcon();
 
 private:
     struct States;
     std::unique_ptr<States> d;
     QTimer                 *refreshTimer;
+    QTimer                 *profileTimer;
     QMenu                  *soundMenu;
 };
 
@@ -47,7 +47,9 @@ extern "C" {
 #include <86box/86box.h>
 #include <86box/config.h>
 #include <86box/plat.h>
+#include <86box/thread.h>
 #include <86box/ui.h>
+#include <86box/replay.h>
 #include <86box/video.h>
 #ifdef DISCORD
 #    include <86box/discord.h>
@@ -437,6 +439,7 @@ main_thread_fn()
 
     QThread::currentThread()->setPriority(QThread::HighestPriority);
     plat_set_thread_name(nullptr, "main_thread");
+    thread_set_role(THREAD_ROLE_CPU);
     framecountx = 0;
     // title_update = 1;
     uint64_t old_time = elapsed_timer.elapsed();
@@ -452,6 +455,9 @@ main_thread_fn()
 #endif
             drawits += static_cast<int>(new_time - old_time);
         old_time = new_time;
+        /* Do not wait for real time to catch up while booting unpaced or replaying. */
+        if ((turbo_boot || (replay_mode == REPLAY_PLAY)) && (drawits <= 0))
+            drawits = 10;
         if (drawits > 0 && !dopause) {
             /* Yes, so run frames now. */
             do {
@@ -459,7 +465,7 @@ main_thread_fn()
                 uint64_t start_time = elapsed_timer.nsecsElapsed();
 #endif
                 /* Run a block of code. */
-                pc_run();
+                const int frame_ms = pc_run(drawits);
 
 #ifdef USE_INSTRUMENT
                 if (instru_enabled) {
@@ -471,13 +477,14 @@ main_thread_fn()
                 }
 #endif
                 /* Every 2 emulated seconds we save the machine status. */
-                if (++frames >= (force_10ms ? 200 : 2000) && nvr_dosave) {
+                frames += frame_ms;
+                if ((frames >= 2000) && nvr_dosave) {
                     qt_nvr_save();
                     nvr_dosave = 0;
                     frames     = 0;
                 }
-                
-                drawits -= force_10ms ? 10 : 1;
+
+                drawits -= frame_ms;
                 if (drawits > 50)
                     drawits = 0;
             } while (drawits > 0);
@@ -485,6 +492,8 @@ main_thread_fn()
             /* Just so we dont overload the host OS. */
 
             /* Trigger a hard reset if one is pending. */
+            if (replay_mode != REPLAY_OFF)
+                hard_reset_pending = replay_hard_reset(hard_reset_pending);
             if (hard_reset_pending) {
                 hard_reset_pending = 0;
                 pc_reset_hard_close();
@@ -730,6 +739,7 @@ main(int argc, char *argv[])
             settings.save();
             config_save();
         }
+        config_flush();
         return 0;
     }
 
@@ -53,6 +53,7 @@ extern "C" {
 #include <86box/nvr.h>
 #include <86box/acpi.h>
 #include <86box/renderdefs.h>
+#include <86box/snapshot.h>
 
 #ifdef USE_VNC
 #    include <86box/vnc.h>
@@ -86,6 +87,7 @@ extern bool cpu_thread_running;
 #include <QScreen>
 #include <QString>
 #include <QDir>
+#include <QDateTime>
 #include <QSysInfo>
 #if QT_CONFIG(vulkan)
 #    include <QVulkanInstance>
@@ -448,6 +450,11 @@ MainWindow::MainWindow(QWidget *parent)
         ui->actionOpenGL_3_0_Core->setVisible(false);
     }
 
+#ifndef USE_SNAPSHOTS
+    ui->actionSave_snapshot->setVisible(false);
+    ui->actionLoad_snapshot->setVisible(false);
+#endif
+
 #ifndef USE_VNC
     if (vid_api == RENDERER_VNC)
         vid_api = RENDERER_SOFTWARE;
@@ -786,8 +793,15 @@ MainWindow::MainWindow(QWidget *parent)
         ui->actionEnd_trace->setShortcut(QKeySequence(Qt::Key_Control + Qt::Key_T));
         ui->actionEnd_trace->setDisabled(true);
         static auto init_trace = [&] {
-            mtr_init("trace.json");
+            /* One Chrome-trace JSON per capture, next to the VM's config instead of the working directory. */
+            QString path = QDir(usr_path).filePath(QString("trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+            FILE   *fp   = plat_fopen(path.toUtf8().constData(), "wb");
+            if (fp == nullptr)
+                return false;
+            mtr_init_from_stream(fp);
             mtr_start();
+            MTR_META_PROCESS_NAME("86Box");
+            return true;
         };
         static auto shutdown_trace = [&] {
             mtr_stop();
@@ -801,9 +815,10 @@ MainWindow::MainWindow(QWidget *parent)
         connect(ui->actionBegin_trace, &QAction::triggered, this, [this] {
             if (trace)
                 return;
+            if (!init_trace())
+                return;
             ui->actionBegin_trace->setDisabled(true);
             ui->actionEnd_trace->setDisabled(false);
-            init_trace();
             trace = true;
         });
         connect(ui->actionEnd_trace, &QAction::triggered, this, [this] {
@@ -1090,7 +1105,8 @@ MainWindow::initRendererMonitorSlot(int monitor_index)
 
                 device_force_redraw();
             }
-        }
+        } else
+            video_monitor_set_visible(monitor_index, 0);
     }
 }
 
@@ -2234,6 +2250,20 @@ MainWindow::on_actionTake_screenshot_triggered()
     device_force_redraw();
 }
 
+/* The snapshot goes next to the configuration, and is taken or restored by
+   the emulation thread between two frames. */
+void
+MainWindow::on_actionSave_snapshot_triggered()
+{
+    snapshot_request_save(QDir(usr_path).filePath("snapshot.86s").toUtf8().constData());
+}
+
+void
+MainWindow::on_actionLoad_snapshot_triggered()
+{
+    snapshot_request_load(QDir(usr_path).filePath("snapshot.86s").toUtf8().constData());
+}
+
 void
 MainWindow::on_actionMute_Unmute_triggered()
 {
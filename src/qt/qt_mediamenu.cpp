@@ -59,6 +59,7 @@ extern "C" {
 #include <86box/ui.h>
 #include <86box/thread.h>
 #include <86box/network.h>
+#include <86box/replay.h>
 };
 
 #include "qt_newfloppydialog.hpp"
@@ -453,6 +454,9 @@ MediaMenu::floppySelectImage(int i, bool wp)
 void
 MediaMenu::floppyMount(int i, const QString &filename, bool wp)
 {
+    if (replay_media(REPLAY_MEDIA_FLOPPY, i, filename.toUtf8().data(), wp))
+        return;
+
     auto previous_image = QFileInfo(floppyfns[i]);
     fdd_close(i);
     ui_writeprot[i] = wp ? 1 : 0;
@@ -478,6 +482,9 @@ MediaMenu::floppyMount(int i, const QString &filename, bool wp)
 void
 MediaMenu::floppyEject(int i)
 {
+    if (replay_media(REPLAY_MEDIA_FLOPPY, i, "", 0))
+        return;
+
     mhm.addImageToHistory(i, ui::MediaType::Floppy, floppyfns[i], QString());
     fdd_close(i);
     ui_sb_update_icon_state(SB_FLOPPY | i, 1);
@@ -551,6 +558,9 @@ MediaMenu::cdromMount(int i, const QString &filename)
     QByteArray fn        = filename.toUtf8().data();
     int        was_empty = cdrom_is_empty(i);
 
+    if (replay_media(REPLAY_MEDIA_CDROM, i, fn.data(), 0))
+        return;
+
     cdrom_exit(i);
 
     memset(cdrom[i].image_path, 0, sizeof(cdrom[i].image_path));
@@ -608,6 +618,9 @@ MediaMenu::cdromMount(int i, int dir, const QString &arg)
 void
 MediaMenu::cdromEject(int i)
 {
+    if (replay_media(REPLAY_MEDIA_CDROM, i, "", 0))
+        return;
+
     mhm.addImageToHistory(i, ui::MediaType::Optical, cdrom[i].image_path, QString());
     cdrom_eject(i);
     cdromUpdateMenu(i);
@@ -1182,6 +1195,9 @@ MediaMenu::nicUpdateMenu(int i)
         case NET_TYPE_NRSWITCH:
             netType = "Remote Switch";
             break;
+        case NET_TYPE_SHMSWITCH:
+            netType = "Host Switch";
+            break;
     }
 
     QString devName = DeviceConfig::DeviceName(network_card_getdevice(net_cards_conf[i].device_num), network_card_get_internal_name(net_cards_conf[i].device_num), 1);
@@ -41,6 +41,7 @@ extern MainWindow *main_window;
 
 #include <QImage>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdarg>
 #define HAVE_STDARG_H
@@ -66,6 +67,12 @@ extern bool cpu_thread_running;
 #define SCALE_VIEWPORT 1
 #define SCALE_ABSOLUTE 2
 
+#define OPENGL_IMAGEBUF_SIZE (2048 * 2048 * 4)
+
+/* From ARB_buffer_storage, not in every set of GL headers. */
+#define OPENGL_MAP_PERSISTENT_BIT 0x0040
+#define OPENGL_MAP_COHERENT_BIT   0x0080
+
 static GLfloat matrix[] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
 
 extern int video_filter_method;
@@ -819,8 +826,8 @@ OpenGLRenderer::OpenGLRenderer(QWidget *parent)
     , renderTimer(new QTimer(this))
 {
     connect(renderTimer, &QTimer::timeout, this, [this]() { this->render(); });
-    imagebufs[0] = std::unique_ptr<uint8_t>(new uint8_t[2048 * 2048 * 4]);
-    imagebufs[1] = std::unique_ptr<uint8_t>(new uint8_t[2048 * 2048 * 4]);
+    imagebufs[0] = std::unique_ptr<uint8_t>(new uint8_t[OPENGL_IMAGEBUF_SIZE]);
+    imagebufs[1] = std::unique_ptr<uint8_t>(new uint8_t[OPENGL_IMAGEBUF_SIZE]);
 
     buf_usage = std::vector<std::atomic_flag>(2);
     buf_usage[0].clear();
@@ -918,6 +925,8 @@ OpenGLRenderer::initialize()
 
         create_texture(&scene_texture);
 
+        initializePBO();
+
         /* load shader */
         //        const char* shaders[1];
         //        shaders[0] = gl3_shader_file;
@@ -1133,6 +1142,7 @@ OpenGLRenderer::finalize()
     context->makeCurrent(this);
 
     delete_texture(&scene_texture);
+    deletePBO();
 
     if (active_shader) {
         delete_glsl(active_shader);
@@ -1150,8 +1160,13 @@ OpenGLRenderer::finalize()
 void
 OpenGLRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
 {
-    if (notReady())
+    int dirty_y1 = y;
+    int dirty_y2 = y + h - 1;
+
+    if (notReady()) {
+        textureStale = true;
         return;
+    }
 
     context->makeCurrent(this);
 
@@ -1159,15 +1174,44 @@ OpenGLRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
         glw.glBindTexture(GL_TEXTURE_2D, scene_texture.id);
         glw.glTexImage2D(GL_TEXTURE_2D, 0, (GLenum) QOpenGLTexture::RGB8_UNorm, w, h, 0, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, NULL);
         glw.glBindTexture(GL_TEXTURE_2D, 0);
+        textureStale = true;
     }
 
+    /* The texture already holds the previous frame, only upload the lines
+       that changed since. */
+    if (!textureStale && (source == QRect(x, y, w, h))) {
+        dirty_y1 = std::max(dirtyLines[buf_idx].first, y);
+        dirty_y2 = std::min(dirtyLines[buf_idx].second, y + h - 1);
+    }
+    textureStale = false;
+
     source.setRect(x, y, w, h);
 
-    glw.glBindTexture(GL_TEXTURE_2D, scene_texture.id);
-    glw.glPixelStorei(GL_UNPACK_ROW_LENGTH, 2048);
-    glw.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, (const void *) ((uintptr_t) imagebufs[buf_idx].get() + (uintptr_t) (2048 * 4 * y + x * 4)));
-    glw.glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glw.glBindTexture(GL_TEXTURE_2D, 0);
+    if (dirty_y1 <= dirty_y2)
+        frameDirty = true;
+
+    if ((dirty_y1 <= dirty_y2) && pboPtr) {
+        /* Source offsets are relative to the bound unpack buffer. */
+        glw.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackPBO);
+        glw.glBindTexture(GL_TEXTURE_2D, scene_texture.id);
+        glw.glPixelStorei(GL_UNPACK_ROW_LENGTH, 2048);
+        glw.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirty_y1 - y, w, dirty_y2 - dirty_y1 + 1, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, (const void *) ((uintptr_t) (buf_idx * OPENGL_IMAGEBUF_SIZE) + (uintptr_t) (2048 * 4 * dirty_y1 + x * 4)));
+        glw.glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glw.glBindTexture(GL_TEXTURE_2D, 0);
+        glw.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        /* The blitter may overwrite the buffer as soon as it is released,
+           so wait for the GPU to have pulled the pixels out of it. */
+        GLsync fence = glw.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glw.glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glw.glDeleteSync(fence);
+    } else if (dirty_y1 <= dirty_y2) {
+        glw.glBindTexture(GL_TEXTURE_2D, scene_texture.id);
+        glw.glPixelStorei(GL_UNPACK_ROW_LENGTH, 2048);
+        glw.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirty_y1 - y, w, dirty_y2 - dirty_y1 + 1, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, (const void *) ((uintptr_t) imagebufs[buf_idx].get() + (uintptr_t) (2048 * 4 * dirty_y1 + x * 4)));
+        glw.glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glw.glBindTexture(GL_TEXTURE_2D, 0);
+    }
 
     buf_usage[buf_idx].clear();
     source.setRect(x, y, w, h);
@@ -1191,12 +1235,63 @@ OpenGLRenderer::getBuffers()
 {
     std::vector<std::tuple<uint8_t *, std::atomic_flag *>> buffers;
 
-    buffers.push_back(std::make_tuple(imagebufs[0].get(), &buf_usage[0]));
-    buffers.push_back(std::make_tuple(imagebufs[1].get(), &buf_usage[1]));
+    if (pboPtr) {
+        buffers.push_back(std::make_tuple(pboPtr, &buf_usage[0]));
+        buffers.push_back(std::make_tuple(pboPtr + OPENGL_IMAGEBUF_SIZE, &buf_usage[1]));
+    } else {
+        buffers.push_back(std::make_tuple(imagebufs[0].get(), &buf_usage[0]));
+        buffers.push_back(std::make_tuple(imagebufs[1].get(), &buf_usage[1]));
+    }
 
     return buffers;
 }
 
+/* Map both image buffers persistently into a pixel unpack buffer if the
+   driver has ARB_buffer_storage, otherwise keep the plain heap buffers. */
+void
+OpenGLRenderer::initializePBO()
+{
+    typedef void(QOPENGLF_APIENTRYP buffer_storage_t)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+    const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | OPENGL_MAP_PERSISTENT_BIT | OPENGL_MAP_COHERENT_BIT;
+    buffer_storage_t buffer_storage;
+
+    if (context->isOpenGLES() ||
+        (((gl_version[0] * 10 + gl_version[1]) < 44) && !context->hasExtension("GL_ARB_buffer_storage")))
+        return;
+
+    buffer_storage = (buffer_storage_t) context->getProcAddress("glBufferStorage");
+    if (buffer_storage == NULL)
+        return;
+
+    glw.glGenBuffers(1, &unpackPBO);
+    glw.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackPBO);
+    buffer_storage(GL_PIXEL_UNPACK_BUFFER, 2 * OPENGL_IMAGEBUF_SIZE, NULL, flags);
+    pboPtr = (uint8_t *) glw.glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, 2 * OPENGL_IMAGEBUF_SIZE, flags);
+    glw.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (pboPtr == nullptr)
+        deletePBO();
+    else
+        ogl3_log("Using a persistently mapped unpack buffer\n");
+}
+
+void
+OpenGLRenderer::deletePBO()
+{
+    if (unpackPBO == 0)
+        return;
+
+    if (pboPtr) {
+        glw.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackPBO);
+        glw.glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glw.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pboPtr = nullptr;
+    }
+
+    glw.glDeleteBuffers(1, &unpackPBO);
+    unpackPBO = 0;
+}
+
 void
 OpenGLRenderer::exposeEvent(QExposeEvent *event)
 {
@@ -1205,6 +1300,7 @@ OpenGLRenderer::exposeEvent(QExposeEvent *event)
     if (!isInitialized)
         initialize();
 
+    frameDirty       = true;
     this->pixelRatio = devicePixelRatio();
     onResize(size().width(), size().height());
 }
@@ -1214,6 +1310,7 @@ OpenGLRenderer::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
 
+    frameDirty       = true;
     this->pixelRatio = devicePixelRatio();
     onResize(event->size().width(), event->size().height());
 
@@ -1395,6 +1492,26 @@ OpenGLRenderer::getOptions(QWidget *parent)
 
 extern void standalone_scale(QRect &destination, int width, int height, QRect source, int scalemode);
 
+/* Whether the output can change without a new input frame, i.e. some pass
+   reads FrameCount or the previous frames. */
+bool
+OpenGLRenderer::shaderAnimated() const
+{
+    for (int s = 0; s < active_shader->num_shaders; ++s) {
+        const struct glsl_shader *shader = &active_shader->shaders[s];
+
+        if (shader->has_prev)
+            return true;
+
+        for (int i = 0; i < shader->num_passes; ++i) {
+            if (shader->passes[i].uniforms.frame_count >= 0)
+                return true;
+        }
+    }
+
+    return active_shader->final_pass.active && (active_shader->final_pass.uniforms.frame_count >= 0);
+}
+
 void
 OpenGLRenderer::render()
 {
@@ -1404,6 +1521,16 @@ OpenGLRenderer::render()
     if (notReady())
         return;
 
+    /* Nothing to do if neither the frame nor the window changed, the last
+       swapped image is still on screen. */
+    if (!frameDirty && (destination == lastDestination) && (lastFilter == video_filter_method) &&
+        !monitors[r_monitor_index].mon_screenshots && !shaderAnimated())
+        return;
+
+    frameDirty      = false;
+    lastDestination = destination;
+    lastFilter      = video_filter_method;
+
     struct {
         uint32_t x;
         uint32_t y;
@@ -68,6 +68,7 @@ public:
     bool     hasOptions() const override { return true; }
     QDialog *getOptions(QWidget *parent) override;
     bool     reloadRendererOption() override { return true; }
+    void     setDirtyLines(int buf_idx, int y1, int y2) override { dirtyLines[buf_idx] = { y1, y2 }; }
 
 signals:
     void initialized();
@@ -83,6 +84,19 @@ protected:
 
 private:
     std::array<std::unique_ptr<uint8_t>, 2> imagebufs;
+    std::array<std::pair<int, int>, 2>      dirtyLines {};
+    /* Persistently mapped pixel unpack buffer holding both image buffers,
+       when the driver supports it; the emulator side copies straight into
+       it and the texture upload becomes a GPU side copy. */
+    GLuint   unpackPBO = 0;
+    uint8_t *pboPtr    = nullptr;
+    bool                                    textureStale = true;
+    /* Set when the scene texture or the output geometry changed since the
+       last rendered frame; the shader chain is skipped while it is clear,
+       unless a pass animates on its own. */
+    bool  frameDirty      = true;
+    QRect lastDestination;
+    int   lastFilter      = -1;
 
     QTimer *renderTimer;
 
@@ -105,6 +119,8 @@ private:
     void initialize();
     void initializeExtensions();
     void initializeBuffers();
+    void initializePBO();
+    void deletePBO();
     void applyOptions();
 
     void create_scene_shader();
@@ -136,6 +152,7 @@ private:
     void read_shader_config();
 
     void render_pass(struct render_data *data);
+    bool shaderAnimated() const;
 
 private slots:
     void render();
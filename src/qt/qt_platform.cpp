@@ -58,8 +58,17 @@
 
 #ifdef Q_OS_UNIX
 #    include <pthread.h>
+#    include <sched.h>
 #    include <sys/mman.h>
 #endif
+#ifdef Q_OS_LINUX
+#    include <sys/resource.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+#ifdef Q_OS_DARWIN
+#    include <pthread/qos.h>
+#endif
 
 #include <sys/stat.h>
 
@@ -124,12 +133,14 @@ extern "C" {
 #include <86box/rom.h>
 #include <86box/config.h>
 #include <86box/ui.h>
+#include <86box/replay.h>
 #ifdef DISCORD
 #    include <86box/discord.h>
 #endif
 
 #include "../cpu/cpu.h"
 #include <86box/plat.h>
+#include <86box/thread.h>
 
 volatile int cpu_thread_run  = 1;
 int          mouse_capture   = 0;
@@ -212,6 +223,12 @@ plat_timer_read(void)
     return elapsed_timer.elapsed();
 }
 
+uint64_t
+plat_get_nsecs(void)
+{
+    return elapsed_timer.nsecsElapsed();
+}
+
 FILE *
 plat_fopen(const char *path, const char *mode)
 {
@@ -420,6 +437,24 @@ plat_remove(char *path)
     QFile(path).remove();
 }
 
+int
+plat_rename(const char *from, const char *to)
+{
+#ifdef Q_OS_WINDOWS
+    /* Unlike rename(), this replaces an existing target in one step. */
+    return MoveFileExW(QString::fromUtf8(from).toStdWString().c_str(), QString::fromUtf8(to).toStdWString().c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+#elif defined(Q_OS_MACOS) or defined(Q_OS_LINUX)
+    QFileInfo fi_from(from);
+    QFileInfo fi_to(to);
+    QString   from_name = (fi_from.isRelative() && !fi_from.filePath().isEmpty()) ? usr_path + fi_from.filePath() : fi_from.filePath();
+    QString   to_name   = (fi_to.isRelative() && !fi_to.filePath().isEmpty()) ? usr_path + fi_to.filePath() : fi_to.filePath();
+    return rename(from_name.toUtf8().constData(), to_name.toUtf8().constData());
+#else
+    return rename(from, to);
+#endif
+}
+
 void *
 plat_mmap(size_t size, uint8_t executable)
 {
@@ -449,6 +484,88 @@ plat_munmap(void *ptr, size_t size)
 #endif
 }
 
+/* Huge page sizes are 2 MB on the hosts we care about, round large mappings up
+   to that so that plat_munmap_large() can release what was actually mapped. */
+#define LARGE_PAGE_SIZE (2ULL << 20)
+
+#ifdef Q_OS_WINDOWS
+/* Large pages need SeLockMemoryPrivilege, which has to be granted to the user
+   and then enabled in the process token. */
+static bool
+plat_enable_lock_memory()
+{
+    static int       enabled = -1;
+    HANDLE           token;
+    TOKEN_PRIVILEGES tp;
+
+    if (enabled >= 0)
+        return enabled;
+
+    enabled = 0;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+        return false;
+    tp.PrivilegeCount           = 1;
+    tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    if (LookupPrivilegeValueW(NULL, L"SeLockMemoryPrivilege", &tp.Privileges[0].Luid) &&
+        AdjustTokenPrivileges(token, FALSE, &tp, 0, NULL, NULL) && (GetLastError() == ERROR_SUCCESS))
+        enabled = 1;
+    CloseHandle(token);
+
+    return enabled;
+}
+#endif
+
+void *
+plat_mmap_large(size_t size, uint8_t executable, const char *what)
+{
+    const char *backing = "normal pages";
+    void       *ret     = nullptr;
+
+#if defined Q_OS_WINDOWS
+    SIZE_T min = GetLargePageMinimum();
+
+    if (min && plat_enable_lock_memory()) {
+        ret = VirtualAlloc(NULL, (size + min - 1) & ~(min - 1), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                           executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE);
+        if (ret != nullptr)
+            backing = "large pages";
+    }
+#else
+    size = (size + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1);
+#    ifdef MAP_HUGETLB
+    ret = mmap(0, size, PROT_READ | PROT_WRITE | (executable ? PROT_EXEC : 0), MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+    if (ret == MAP_FAILED)
+        ret = nullptr;
+    else
+        backing = "huge pages";
+#    endif
+#endif
+
+    if (ret == nullptr) {
+        ret = plat_mmap(size, executable);
+#ifdef MADV_HUGEPAGE
+        /* No reserved huge pages, let the kernel use transparent ones if it can. */
+        if ((ret != nullptr) && !madvise(ret, size, MADV_HUGEPAGE))
+            backing = "transparent huge pages";
+#endif
+    }
+
+    if (ret != nullptr)
+        pclog("%s: %llu kB backed by %s\n", what, (unsigned long long) (size >> 10), backing);
+
+    return ret;
+}
+
+void
+plat_munmap_large(void *ptr, size_t size)
+{
+#if defined Q_OS_WINDOWS
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, (size + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1));
+#endif
+}
+
 extern bool cpu_thread_running;
 
 #ifdef Q_OS_WINDOWS
@@ -530,7 +647,7 @@ plat_pause(int p)
         return;
     }
 
-    if ((p == 0) && (time_sync & TIME_SYNC_ENABLED))
+    if ((p == 0) && (time_sync & TIME_SYNC_ENABLED) && (replay_mode == REPLAY_OFF))
         nvr_time_sync();
 
 #ifdef Q_OS_WINDOWS
@@ -969,6 +1086,66 @@ plat_set_thread_name(void *thread, const char *name)
 #endif
 }
 
+int
+plat_set_thread_affinity(const uint64_t *mask, int max_cpus)
+{
+#if defined(Q_OS_WINDOWS)
+    DWORD_PTR wmask = 0;
+
+    for (int i = 0; (i < max_cpus) && (i < (int) (8 * sizeof(DWORD_PTR))); i++) {
+        if (mask[i >> 6] & (1ULL << (i & 63)))
+            wmask |= ((DWORD_PTR) 1) << i;
+    }
+
+    return wmask && SetThreadAffinityMask(GetCurrentThread(), wmask);
+#elif defined(Q_OS_LINUX)
+    /* The kernel wants an array of longs, which is not a uint64_t array on 32-bit big endian. */
+    unsigned long kmask[THREAD_MAX_CPUS / (8 * sizeof(unsigned long))] = { 0 };
+
+    for (int i = 0; (i < max_cpus) && (i < THREAD_MAX_CPUS); i++) {
+        if (mask[i >> 6] & (1ULL << (i & 63)))
+            kmask[i / (8 * sizeof(unsigned long))] |= 1UL << (i % (8 * sizeof(unsigned long)));
+    }
+
+    return !syscall(SYS_sched_setaffinity, 0, sizeof(kmask), kmask);
+#else
+    /* No thread affinity on this host. */
+    (void) mask;
+    (void) max_cpus;
+    return 0;
+#endif
+}
+
+int
+plat_set_thread_priority(int prio)
+{
+#ifdef Q_OS_WINDOWS
+    static const int win_prio[] = { THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL,
+                                    THREAD_PRIORITY_HIGHEST, THREAD_PRIORITY_TIME_CRITICAL };
+
+    return !!SetThreadPriority(GetCurrentThread(), win_prio[prio]);
+#else
+    struct sched_param param = {};
+
+    if (prio == THREAD_PRIO_REALTIME) {
+        param.sched_priority = sched_get_priority_min(SCHED_RR);
+        return !pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+    }
+
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+#    if defined(Q_OS_LINUX)
+    /* Linux keeps a nice value per thread. */
+    return !setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid),
+                        (prio == THREAD_PRIO_LOW) ? 10 : ((prio == THREAD_PRIO_HIGH) ? -5 : 0));
+#    elif defined(Q_OS_DARWIN)
+    return !pthread_set_qos_class_self_np((prio == THREAD_PRIO_LOW) ? QOS_CLASS_UTILITY :
+                                          ((prio == THREAD_PRIO_HIGH) ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_USER_INITIATED), 0);
+#    else
+    return (prio == THREAD_PRIO_NORMAL);
+#    endif
+#endif
+}
+
 void
 plat_break(void)
 {
@@ -39,6 +39,9 @@ public:
     virtual bool reloadRendererOption() { return false; }
     /* Should the renderer take screenshots itself? */
     virtual bool rendererTakeScreenshot() { return false; }
+    /* Lines (inclusive) changed since the previous frame handed to the renderer,
+       set from the blitter thread just before the buffer is passed on. */
+    virtual void setDirtyLines(int buf_idx, int y1, int y2) { }
 
     int    r_monitor_index = 0;
     QRectF destinationF    = QRectF(0, 0, 1, 1); /* normalized to 0.0-1.0 range. */
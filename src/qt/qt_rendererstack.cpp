@@ -30,6 +30,7 @@
 
 #include "evdev_mouse.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <stdexcept>
 
@@ -464,7 +465,37 @@ RendererStack::createRenderer(Renderer renderer)
 void
 RendererStack::blit(int x, int y, int w, int h)
 {
-    if ((x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || ((w + y) > 2048) || ((h + x) > 2048) || (switchInProgress) || (monitors[m_monitor_index].target_buffer == NULL) || imagebufs.empty() || std::get<std::atomic_flag *>(imagebufs[currentBuf])->test_and_set()) {
+    int dirty_y1;
+    int dirty_y2;
+
+    if ((x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || ((w + y) > 2048) || ((h + x) > 2048) || (switchInProgress) || (monitors[m_monitor_index].target_buffer == NULL) || imagebufs.empty()) {
+        bufDirty.clear();
+        video_blit_complete_monitor(m_monitor_index);
+        return;
+    }
+
+    /* Each image buffer only needs the lines that changed since it was last
+       filled, start over whenever the buffers or the frame geometry change. */
+    if ((bufDirty.size() != imagebufs.size()) || (bufDirtyBase != std::get<uint8_t *>(imagebufs[0])) || (QRect(x, y, w, h) != bufDirtyRect)) {
+        bufDirty.assign(imagebufs.size(), { y, y + h - 1 });
+        bufDirtyBase = std::get<uint8_t *>(imagebufs[0]);
+        bufDirtyRect = QRect(x, y, w, h);
+        uploadDirty  = { y, y + h - 1 };
+    }
+
+    video_blit_get_dirty_monitor(m_monitor_index, &dirty_y1, &dirty_y2);
+    dirty_y1 = std::max(dirty_y1, y);
+    dirty_y2 = std::min(dirty_y2, y + h - 1);
+    if (dirty_y1 <= dirty_y2) {
+        for (auto &dirty : bufDirty) {
+            dirty.first  = std::min(dirty.first, dirty_y1);
+            dirty.second = std::max(dirty.second, dirty_y2);
+        }
+        uploadDirty.first  = std::min(uploadDirty.first, dirty_y1);
+        uploadDirty.second = std::max(uploadDirty.second, dirty_y2);
+    }
+
+    if (std::get<std::atomic_flag *>(imagebufs[currentBuf])->test_and_set()) {
         video_blit_complete_monitor(m_monitor_index);
         return;
     }
@@ -473,10 +504,15 @@ RendererStack::blit(int x, int y, int w, int h)
     sw = this->w = w;
     sh = this->h       = h;
     uint8_t *imagebits = std::get<uint8_t *>(imagebufs[currentBuf]);
-    for (int y1 = y; y1 < (y + h); y1++) {
+    for (int y1 = bufDirty[currentBuf].first; y1 <= bufDirty[currentBuf].second; y1++) {
         auto scanline = imagebits + (y1 * rendererWindow->getBytesPerRow()) + (x * 4);
         video_copy(scanline, &(monitors[m_monitor_index].target_buffer->line[y1][x]), w * 4);
     }
+    bufDirty[currentBuf] = { 2048, -1 };
+
+    /* The renderer's texture has seen every frame handed to it so far. */
+    rendererWindow->setDirtyLines(currentBuf, uploadDirty.first, uploadDirty.second);
+    uploadDirty = { 2048, -1 };
 
     if (monitors[m_monitor_index].mon_screenshots && !rendererTakesScreenshots) {
         video_screenshot_monitor((uint32_t *) imagebits, x, y, 2048, m_monitor_index);
@@ -505,6 +541,28 @@ RendererStack::changeEvent(QEvent *event)
         monitor_settings[m_monitor_index].mon_window_maximized = isMaximized();
         config_save();
     }
+
+    /* A minimised secondary window does not need its card to render. */
+    if ((m_monitor_index != 0) && (event->type() == QEvent::WindowStateChange))
+        video_monitor_set_visible(m_monitor_index, isVisible() && !isMinimized());
+}
+
+void
+RendererStack::showEvent(QShowEvent *event)
+{
+    if (m_monitor_index != 0)
+        video_monitor_set_visible(m_monitor_index, !isMinimized());
+
+    QWidget::showEvent(event);
+}
+
+void
+RendererStack::hideEvent(QHideEvent *event)
+{
+    if (m_monitor_index != 0)
+        video_monitor_set_visible(m_monitor_index, 0);
+
+    QWidget::hideEvent(event);
 }
 
 bool
@@ -48,6 +48,8 @@ public:
     void leaveEvent(QEvent *event) override;
     void closeEvent(QCloseEvent *event) override;
     void changeEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
     void resizeEvent(QResizeEvent *event) override
     {
         if (this->m_monitor_index != 0 && vid_resize != 1) {
@@ -136,6 +138,12 @@ private:
 
     std::vector<std::tuple<uint8_t *, std::atomic_flag *>> imagebufs;
 
+    /* Lines each image buffer, and the renderer, is missing. Blitter thread only. */
+    std::vector<std::pair<int, int>> bufDirty;
+    std::pair<int, int>              uploadDirty { 2048, -1 };
+    uint8_t                         *bufDirtyBase { nullptr };
+    QRect                            bufDirtyRect;
+
     RendererCommon          *rendererWindow { nullptr };
     std::unique_ptr<QWidget> current;
 
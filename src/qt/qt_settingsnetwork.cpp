@@ -169,6 +169,21 @@ SettingsNetwork::enableElements(Ui::SettingsNetwork *ui)
                     break;
 #endif /* USE_NETSWITCH */
 
+#ifdef HAS_SHMSWITCH
+                case NET_TYPE_SHMSWITCH:
+                    option_list_label->setVisible(true);
+                    option_list_line->setVisible(true);
+
+                    // Switch group
+                    switch_group_label->setVisible(true);
+                    switch_group_value->setVisible(true);
+
+                    // Promiscuous options
+                    promisc_label->setVisible(true);
+                    promisc_value->setVisible(true);
+                    break;
+#endif
+
                 case NET_TYPE_SLIRP:
                 default:
                     break;
@@ -211,15 +226,28 @@ SettingsNetwork::save()
 #if defined(__unix__) || defined(__APPLE__)
         auto *bridge_line = findChild<QLineEdit *>(QString("bridgeTAPNIC%1").arg(i + 1));
 #endif
+        const int old_net_type       = net_cards_conf[i].net_type;
         net_cards_conf[i].device_num = cbox->currentData().toInt();
         cbox                         = findChild<QComboBox *>(QString("comboBoxNet%1").arg(i + 1));
         net_cards_conf[i].net_type   = cbox->currentData().toInt();
         cbox                         = findChild<QComboBox *>(QString("comboBoxIntf%1").arg(i + 1));
 #ifdef USE_NETSWITCH
         auto *hostname_value         = findChild<QLineEdit *>(QString("hostnameSwitch%1").arg(i + 1));
+#endif /* USE_NETSWITCH */
+#if defined(USE_NETSWITCH) || defined(HAS_SHMSWITCH)
         auto *promisc_value          = findChild<QCheckBox *>(QString("boxPromisc%1").arg(i + 1));
         auto *switch_group_value     = findChild<QSpinBox *>(QString("spinnerSwitch%1").arg(i + 1));
-#endif /* USE_NETSWITCH */
+#endif
+#ifdef HAS_SHMSWITCH
+        // A switch name can only be set in the configuration file, keep it
+        if (net_cards_conf[i].net_type == NET_TYPE_SHMSWITCH) {
+            if (old_net_type != NET_TYPE_SHMSWITCH)
+                memset(net_cards_conf[i].host_dev_name, '\0', sizeof(net_cards_conf[i].host_dev_name));
+            net_cards_conf[i].promisc_mode = promisc_value->isChecked();
+            net_cards_conf[i].switch_group = switch_group_value->value() - 1;
+            continue;
+        }
+#endif
         memset(net_cards_conf[i].host_dev_name, '\0', sizeof(net_cards_conf[i].host_dev_name));
         if (net_cards_conf[i].net_type == NET_TYPE_PCAP)
             strncpy(net_cards_conf[i].host_dev_name, network_devs[cbox->currentData().toInt()].device, sizeof(net_cards_conf[i].host_dev_name) - 1);
@@ -313,6 +341,10 @@ SettingsNetwork::onCurrentMachineChanged(int machineId)
         Models::AddEntry(model, "TAP", NET_TYPE_TAP);
 #endif
 
+#ifdef HAS_SHMSWITCH
+        Models::AddEntry(model, tr("Host Switch"), NET_TYPE_SHMSWITCH);
+#endif
+
 #ifdef USE_NETSWITCH
         Models::AddEntry(model, "Local Switch", NET_TYPE_NMSWITCH);
 #    ifdef ENABLE_NET_NRSWITCH
@@ -366,6 +398,13 @@ SettingsNetwork::onCurrentMachineChanged(int machineId)
             auto *switch_group_value = findChild<QSpinBox *>(QString("spinnerSwitch%1").arg(i + 1));
             switch_group_value->setValue(net_cards_conf[i].switch_group + 1);
 #endif /* USE_NETSWITCH */
+#ifdef HAS_SHMSWITCH
+        } else if (net_cards_conf[i].net_type == NET_TYPE_SHMSWITCH) {
+            auto *promisc_value = findChild<QCheckBox *>(QString("boxPromisc%1").arg(i + 1));
+            promisc_value->setCheckState(net_cards_conf[i].promisc_mode == 1 ? Qt::CheckState::Checked : Qt::CheckState::Unchecked);
+            auto *switch_group_value = findChild<QSpinBox *>(QString("spinnerSwitch%1").arg(i + 1));
+            switch_group_value->setValue(net_cards_conf[i].switch_group + 1);
+#endif
         }
     }
 }
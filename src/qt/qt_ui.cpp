@@ -324,6 +324,17 @@ ui_sb_update_icon_state(int tag, int state)
         main_window->updateStatusEmptyIcons();
 }
 
+/* Disk and network emulation report activity for every transfer, far more
+   often than MachineStatus samples the flags (every 75 ms), so only store
+   when the value changes; that keeps the flags' cache line shared and
+   avoids a locked store per call. */
+static inline void
+sb_set_flag(atomic_bool_t &flag, bool value)
+{
+    if (flag.load(std::memory_order_relaxed) != value)
+        flag.store(value, std::memory_order_relaxed);
+}
+
 void
 ui_sb_update_icon(int tag, int active)
 {
@@ -337,22 +348,22 @@ ui_sb_update_icon(int tag, int active)
         case SB_CARTRIDGE:
             break;
         case SB_FLOPPY:
-            machine_status.fdd[item].active = active > 0 ? true : false;
+            sb_set_flag(machine_status.fdd[item].active, active > 0);
             break;
         case SB_CDROM:
-            machine_status.cdrom[item].active = active > 0 ? true : false;
+            sb_set_flag(machine_status.cdrom[item].active, active > 0);
             break;
         case SB_RDISK:
-            machine_status.rdisk[item].active = active > 0 ? true : false;
+            sb_set_flag(machine_status.rdisk[item].active, active > 0);
             break;
         case SB_MO:
-            machine_status.mo[item].active = active > 0 ? true : false;
+            sb_set_flag(machine_status.mo[item].active, active > 0);
             break;
         case SB_HDD:
-            machine_status.hdd[item].active = active > 0 ? true : false;
+            sb_set_flag(machine_status.hdd[item].active, active > 0);
             break;
         case SB_NETWORK:
-            machine_status.net[item].active = active > 0 ? true : false;
+            sb_set_flag(machine_status.net[item].active, active > 0);
             break;
         case SB_SOUND:
         case SB_TEXT:
@@ -373,22 +384,22 @@ ui_sb_update_icon_write(int tag, int write)
         case SB_CARTRIDGE:
             break;
         case SB_FLOPPY:
-            machine_status.fdd[item].write_active = write > 0 ? true : false;
+            sb_set_flag(machine_status.fdd[item].write_active, write > 0);
             break;
         case SB_CDROM:
-            machine_status.cdrom[item].write_active = write > 0 ? true : false;
+            sb_set_flag(machine_status.cdrom[item].write_active, write > 0);
             break;
         case SB_RDISK:
-            machine_status.rdisk[item].write_active = write > 0 ? true : false;
+            sb_set_flag(machine_status.rdisk[item].write_active, write > 0);
             break;
         case SB_MO:
-            machine_status.mo[item].write_active = write > 0 ? true : false;
+            sb_set_flag(machine_status.mo[item].write_active, write > 0);
             break;
         case SB_HDD:
-            machine_status.hdd[item].write_active = write > 0 ? true : false;
+            sb_set_flag(machine_status.hdd[item].write_active, write > 0);
             break;
         case SB_NETWORK:
-            machine_status.net[item].write_active = write > 0 ? true : false;
+            sb_set_flag(machine_status.net[item].write_active, write > 0);
             break;
         case SB_SOUND:
         case SB_TEXT:
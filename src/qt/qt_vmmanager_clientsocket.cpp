@@ -19,6 +19,7 @@
 #include <QJsonObject>
 
 extern "C" {
+#include "86box/86box.h"
 #include "86box/plat.h"
 #include "86box/config.h"
 }
@@ -189,6 +190,9 @@ VMManagerClientSocket::jsonReceived(const QJsonObject &json)
 #endif
                 break;
             }
+        case VMManagerProtocol::ManagerMessage::RequestPerformanceCounters:
+            sendPerformanceCounters();
+            break;
         default:
             qDebug("Unknown client message type received:");
             qDebug() << json;
@@ -242,6 +246,33 @@ VMManagerClientSocket::sendWinIdMessage(WId id)
     sendMessageWithObject(VMManagerProtocol::ClientMessage::WinIdMessage, extra_object);
 }
 
+void
+VMManagerClientSocket::sendPerformanceCounters() const
+{
+    pc_perf_t   perf;
+    QJsonObject extra_object;
+
+    // Rates over the last second, see pc_onesec()
+    pc_get_perf(&perf);
+    extra_object["speed"]              = static_cast<qint64>(perf.speed);
+    extra_object["frames"]             = static_cast<qint64>(perf.frames);
+    extra_object["frames_dropped"]     = static_cast<qint64>(perf.frames_dropped);
+    extra_object["frames_blocked"]     = static_cast<qint64>(perf.frames_blocked);
+    extra_object["audio_underruns"]    = static_cast<qint64>(perf.audio_underruns);
+    extra_object["timer_callbacks"]    = static_cast<qint64>(perf.timer_callbacks);
+    extra_object["dynarec_compiled"]   = static_cast<qint64>(perf.dynarec_compiled);
+    extra_object["dynarec_evicted"]    = static_cast<qint64>(perf.dynarec_evicted);
+    extra_object["dynarec_uops"]       = static_cast<qint64>(perf.dynarec_uops);
+    extra_object["dynarec_host_bytes"] = static_cast<qint64>(perf.dynarec_host_bytes);
+    extra_object["dynarec_smc"]        = static_cast<qint64>(perf.dynarec_smc);
+    extra_object["dynarec_flushed"]    = static_cast<qint64>(perf.dynarec_flushed);
+    extra_object["dynarec_fallbacks"]  = static_cast<qint64>(perf.dynarec_fallbacks);
+    extra_object["disk_ops"]           = static_cast<qint64>(perf.disk_ops);
+    extra_object["net_rx_packets"]     = static_cast<qint64>(perf.net_rx_packets);
+    extra_object["net_tx_packets"]     = static_cast<qint64>(perf.net_tx_packets);
+    sendMessageWithObject(VMManagerProtocol::ClientMessage::PerformanceCounters, extra_object);
+}
+
 void
 VMManagerClientSocket::clientRunningStateChanged(VMManagerProtocol::RunningState state) const
 {
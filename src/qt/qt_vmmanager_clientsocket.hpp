@@ -29,6 +29,7 @@ public:
     bool IPCConnect(const QString &server);
 
     void sendWinIdMessage(WId id);
+    void sendPerformanceCounters() const;
 
 signals:
     void pause();
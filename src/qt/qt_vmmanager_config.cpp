@@ -60,13 +60,17 @@ VMManagerConfig::setStringValue(const QString &key, const QString &value) const
         remove(key);
         return;
     }
-    settings->setValue(key, value);
+    // Every change makes QSettings rewrite the whole file, and all the systems
+    // save their settings on startup, so leave unchanged values alone
+    if (settings->value(key).toString() != value)
+        settings->setValue(key, value);
 }
 
 void
 VMManagerConfig::remove(const QString &key) const
 {
-    settings->remove(key);
+    if (settings->contains(key))
+        settings->remove(key);
 }
 
 void
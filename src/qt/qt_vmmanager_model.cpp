@@ -100,19 +100,14 @@ VMManagerModel::getConfigObjectForIndex(const QModelIndex &index) const
 void
 VMManagerModel::reload(QWidget *parent)
 {
-    // Scan for configs
-    auto machines_vec = VMManagerSystem::scanForConfigs(parent);
-    for (const auto &scanned_config : machines_vec) {
-        int found = 0;
-        for (const auto &existing_config : machines) {
-            if (*scanned_config == *existing_config) {
-                found = 1;
-            }
-        }
-        if (!found) {
-            addConfigToModel(scanned_config);
-        }
-    }
+    // Scan for configs, only loading the ones not in the model yet
+    QStringList known;
+    for (const auto &existing_config : machines)
+        known.append(existing_config->config_file.filePath());
+
+    auto machines_vec = VMManagerSystem::scanForConfigs(parent, {}, known);
+    for (const auto &scanned_config : machines_vec)
+        addConfigToModel(scanned_config);
     // TODO: Remove missing configs
 }
 
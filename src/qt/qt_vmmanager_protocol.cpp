@@ -97,6 +97,8 @@ VMManagerProtocol::getClientMessageType(const QJsonObject &json_document)
         return VMManagerProtocol::ClientMessage::WinIdMessage;
     else if (message_type == "GlobalConfigurationChanged")
         return VMManagerProtocol::ClientMessage::GlobalConfigurationChanged;
+    else if (message_type == "PerformanceCounters")
+        return VMManagerProtocol::ClientMessage::PerformanceCounters;
 
     return VMManagerProtocol::ClientMessage::UnknownMessage;
 }
@@ -131,6 +133,9 @@ VMManagerProtocol::getManagerMessageType(const QJsonObject &json_document)
     if (message_type == "GlobalConfigurationChanged")
         return VMManagerProtocol::ManagerMessage::GlobalConfigurationChanged;
 
+    if (message_type == "RequestPerformanceCounters")
+        return VMManagerProtocol::ManagerMessage::RequestPerformanceCounters;
+
     return VMManagerProtocol::ManagerMessage::UnknownMessage;
 }
 
@@ -41,6 +41,7 @@ public:
         RequestShutdown,
         ForceShutdown,
         GlobalConfigurationChanged,
+        RequestPerformanceCounters,
         UnknownMessage,
     };
 
@@ -55,6 +56,7 @@ public:
         ConfigurationChanged,
         WinIdMessage,
         GlobalConfigurationChanged,
+        PerformanceCounters,
         UnknownMessage,
     };
     Q_ENUM(ClientMessage);
@@ -194,6 +194,11 @@ VMManagerServerSocket::jsonReceived(const QJsonObject &json)
             qDebug("Global configuration change received from client");
             emit globalConfigurationChanged();
             break;
+        case VMManagerProtocol::ClientMessage::PerformanceCounters:
+            params_object = VMManagerProtocol::getParams(json);
+            if (!params_object.isEmpty())
+                emit performanceCountersReceived(params_object);
+            break;
         default:
             qDebug("Unknown client message type received:");
             qDebug() << json;
@@ -75,6 +75,7 @@ signals:
     void configurationChanged();
     void globalConfigurationChanged();
     void winIdReceived(WId id);
+    void performanceCountersReceived(const QJsonObject &counters);
 };
 
 #endif // QT_VMMANAGER_SERVERSOCKET_H
@@ -25,6 +25,10 @@
 #include <QMessageBox>
 #include <QProgressDialog>
 #include <QWindow>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "qt_util.hpp"
 #include "qt_vmmanager_system.hpp"
 // #include "qt_vmmanager_details_section.hpp"
@@ -67,7 +71,7 @@ extern "C" {
 
 using namespace VMManager;
 
-VMManagerSystem::VMManagerSystem(const QString &sysconfig_file)
+VMManagerSystem::VMManagerSystem(const QString &sysconfig_file, const config_hash_t *preloaded_config)
 {
 
     // The 86Box configuration file
@@ -82,6 +86,10 @@ VMManagerSystem::VMManagerSystem(const QString &sysconfig_file)
     uuid = util::generateUuid(sysconfig_file);
     // That unique value is used to map the information to each individual system.
     config_settings = new VMManagerConfig(VMManagerConfig::ConfigType::System, uuid);
+    if (preloaded_config) {
+        config_hash      = *preloaded_config;
+        config_preloaded = true;
+    }
 
     // On non-windows platforms, shortened_dir will replace the home directory path with ~
     // and be used as the tool tip in the list view
@@ -170,14 +178,50 @@ VMManagerSystem::scanForConfigs(QWidget *parent, const QString &searchPath)
     // foreach (QFileInfo hit, matches) {
     //     system_configs.append(new VMManagerSystem(hit));
     // }
-    progDialog.setMaximum(found);
+    // Systems already known to the caller are left alone
+    if (!known.isEmpty()) {
+        QSet<QString> known_set;
+        for (const auto &filename : known)
+            known_set.insert(filename);
+        matches.erase(std::remove_if(matches.begin(), matches.end(), [&known_set](const QString &filename) {
+            return known_set.contains(filename);
+        }), matches.end());
+    }
+
+    // Parsing the configuration files is most of the load time, so spread it
+    // over worker threads. The systems themselves are widgets and have to be
+    // created on this thread.
+    std::vector<config_hash_t> parsed(matches.size());
+    std::atomic<qsizetype>     next_match { 0 };
+    std::atomic<qsizetype>     parsed_count { 0 };
+    std::vector<std::thread>   workers;
+    const auto                 parse_matches = [&matches, &parsed, &next_match, &parsed_count] {
+        for (qsizetype m; (m = next_match++) < matches.size();) {
+            parsed[m] = parseConfigFile(matches.at(m));
+            parsed_count++;
+        }
+    };
+    for (int t = 1; t < std::min<qsizetype>(QThread::idealThreadCount(), matches.size()); t++)
+        workers.emplace_back(parse_matches);
+
+    progDialog.setMaximum(matches.size() * 2);
     progDialog.setValue(0);
+    progDialog.setLabelText(tr("Loading %1 VMs...").arg(QString::number(matches.size())));
+    for (qsizetype m; (m = next_match++) < matches.size();) {
+        parsed[m] = parseConfigFile(matches.at(m));
+        parsed_count++;
+        progDialog.setValue(static_cast<int>(parsed_count.load()));
+        QApplication::processEvents();
+    }
+    for (auto &worker : workers)
+        worker.join();
+
     unsigned int appended = 0;
-    for (const auto &filename : matches) {
-        system_configs.append(new VMManagerSystem(filename));
+    for (int m = 0; m < matches.size(); m++) {
+        system_configs.append(new VMManagerSystem(matches[m], &parsed[m]));
         appended++;
         progDialog.setLabelText(system_configs.last()->displayName);
-        progDialog.setValue(appended);
+        progDialog.setValue(matches.size() + appended);
         QApplication::processEvents();
     }
     if (matches.size()) {
@@ -212,23 +256,20 @@ VMManagerSystem::getScreenshots()
     return screenshot_files;
 }
 
-void
-VMManagerSystem::loadSettings()
+// Safe to call from any thread
+VMManagerSystem::config_hash_t
+VMManagerSystem::parseConfigFile(const QString &filename)
 {
-    // First, load the information from the 86box.cfg
-    QSettings settings(config_file.filePath(), QSettings::IniFormat);
+    config_hash_t config_hash;
+    QSettings     settings(filename, QSettings::IniFormat);
     if (settings.status() != QSettings::NoError)
-        qWarning() << "Error loading" << config_file.path() << " status:" << settings.status();
+        qWarning() << "Error loading" << filename << " status:" << settings.status();
 
-    // qInfo() << "Loaded "<< config_file.filePath() << "status:" << settings.status();
+    // qInfo() << "Loaded "<< filename << "status:" << settings.status();
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     settings.setIniCodec("UTF-8");
 #endif
-    // Clear out the config hash in case the config is reloaded
-    for (const auto &outer_key : config_hash.keys()) {
-        config_hash[outer_key].clear();
-    }
 
     // General
     for (const auto &key_name : settings.childKeys()) {
@@ -255,6 +296,18 @@ VMManagerSystem::loadSettings()
         settings.endGroup();
     }
 
+    return config_hash;
+}
+
+void
+VMManagerSystem::loadSettings()
+{
+    // First, load the information from the 86box.cfg, unless the scan already did
+    if (config_preloaded)
+        config_preloaded = false;
+    else
+        config_hash = parseConfigFile(config_file.filePath());
+
     // Next, load the information from the vmm config for this system
     // Display name
     auto loadedDisplayName = config_settings->getStringValue("display_name");
@@ -84,7 +84,8 @@ public:
     };
     Q_ENUM(ProcessStatus);
 
-    explicit VMManagerSystem(const QString &sysconfig_file);
+    // preloaded_config, when given, is used instead of parsing the 86box configuration file
+    explicit VMManagerSystem(const QString &sysconfig_file, const config_hash_t *preloaded_config = nullptr);
     // Default constructor will generate a temporary filename as the config file
     // but it will not be valid (isValid() will return false)
     VMManagerSystem()
@@ -94,7 +95,8 @@ public:
 
     ~VMManagerSystem() override;
 
-    static QVector<VMManagerSystem *> scanForConfigs(QWidget *parent = nullptr, const QString &searchPath = {});
+    // Configuration files listed in known are skipped
+    static QVector<VMManagerSystem *> scanForConfigs(QWidget *parent = nullptr, const QString &searchPath = {}, const QStringList &known = {});
     static QString                    generateTemporaryFilename();
 
     QFileInfo   config_file;
@@ -162,6 +164,8 @@ signals:
     void globalConfigurationChanged();
 
 private:
+    static config_hash_t parseConfigFile(const QString &filename);
+
     void loadSettings();
     void saveSettings();
     void generateSearchTerms();
@@ -189,6 +193,7 @@ private:
     WId id;
 
     bool serverIsRunning;
+    bool config_preloaded = false;
     bool startServer();
 
     bool has86BoxBinary();
@@ -364,17 +364,29 @@ VulkanRenderer2::ensureTexture()
             m_texStagingTransferLayout = true;
         }
 
-        VkImageCopy copyInfo;
-        memset(&copyInfo, 0, sizeof(copyInfo));
-        copyInfo.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyInfo.srcSubresource.layerCount = 1;
-        copyInfo.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyInfo.dstSubresource.layerCount = 1;
-        copyInfo.extent.width              = m_texSize.width();
-        copyInfo.extent.height             = m_texSize.height();
-        copyInfo.extent.depth              = 1;
-        m_devFuncs->vkCmdCopyImage(cb, m_texStaging, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                   m_texImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyInfo);
+        /* The optimal image keeps its contents between frames, so after the
+           initial full copy only the area of frames blitted since the last
+           one needs to come across, and nothing at all if none was. */
+        QRect copyRect = m_texCopyFull ? QRect(QPoint(0, 0), m_texSize) : (m_texDirtyRect & QRect(QPoint(0, 0), m_texSize));
+        m_texCopyFull  = false;
+        m_texDirtyRect = QRect();
+
+        if (!copyRect.isEmpty()) {
+            VkImageCopy copyInfo;
+            memset(&copyInfo, 0, sizeof(copyInfo));
+            copyInfo.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copyInfo.srcSubresource.layerCount = 1;
+            copyInfo.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copyInfo.dstSubresource.layerCount = 1;
+            copyInfo.srcOffset.x               = copyRect.x();
+            copyInfo.srcOffset.y               = copyRect.y();
+            copyInfo.dstOffset                 = copyInfo.srcOffset;
+            copyInfo.extent.width              = copyRect.width();
+            copyInfo.extent.height             = copyRect.height();
+            copyInfo.extent.depth              = 1;
+            m_devFuncs->vkCmdCopyImage(cb, m_texStaging, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                       m_texImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyInfo);
+        }
 
         barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -53,6 +53,10 @@ public:
 
     void startNextFrame() override;
 
+    /* Called for every blitted frame, so only the area it covers is copied
+       from the staging image on the next frame. */
+    void markDirty(const QRect &rect) { m_texDirtyRect |= rect; }
+
 private:
     VkShaderModule createShader(const QString &name);
     bool           createTexture();
@@ -87,6 +91,8 @@ private:
     VkDeviceMemory m_texStagingMem            = VK_NULL_HANDLE;
     bool           m_texStagingPending        = false;
     bool           m_texStagingTransferLayout = false;
+    bool           m_texCopyFull              = true;
+    QRect          m_texDirtyRect;
     QSize          m_texSize;
     VkFormat       m_texFormat;
 
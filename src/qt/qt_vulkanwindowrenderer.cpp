@@ -866,6 +866,8 @@ VulkanWindowRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
 {
     auto origSource = source;
     source.setRect(x, y, w, h);
+    if (renderer)
+        renderer->markDirty(source);
     if (isExposed())
         requestUpdate();
     buf_usage[0].clear();
@@ -33,7 +33,7 @@ private:
     friend class VulkanRendererEmu;
     friend class VulkanRenderer2;
 
-    VulkanRenderer2 *renderer;
+    VulkanRenderer2 *renderer = nullptr;
 };
 #endif // QT_CONFIG(vulkan)
 
@@ -74,6 +74,36 @@ parse_valuators(const double        *input_values,
 
 static bool exitthread = false;
 
+/* Axes of the last device that moved, so that motion events do not each need a
+   round trip to the server. Dropped when the device changes. */
+static XIDeviceInfo *xidevinfo_cache    = nullptr;
+static int           xidevinfo_deviceid = -1;
+
+static void
+xinput2_drop_device_info()
+{
+    if (xidevinfo_cache)
+        XIFreeDeviceInfo(xidevinfo_cache);
+    xidevinfo_cache    = nullptr;
+    xidevinfo_deviceid = -1;
+}
+
+static XIDeviceInfo *
+xinput2_get_device_info(int deviceid)
+{
+    int devs;
+
+    if (xidevinfo_cache && (xidevinfo_deviceid == deviceid))
+        return xidevinfo_cache;
+
+    xinput2_drop_device_info();
+    xidevinfo_cache = XIQueryDevice(disp, deviceid, &devs);
+    if (xidevinfo_cache)
+        xidevinfo_deviceid = deviceid;
+
+    return xidevinfo_cache;
+}
+
 static int
 xinput2_get_xtest_pointer()
 {
@@ -152,9 +182,8 @@ common_motion:
                         if ((rawev->time == prev_time) && (coords[0] == prev_coords[0]) && (coords[1] == prev_coords[1]))
                             break;
 
-                        /* SDL2 queries the device on every event, so doing that should be fine. */
                         int           i;
-                        XIDeviceInfo *xidevinfo = XIQueryDevice(disp, rawev->deviceid, &i);
+                        XIDeviceInfo *xidevinfo = xinput2_get_device_info(rawev->deviceid);
                         if (xidevinfo) {
                             /* Process the device's axes. */
                             int axis = 0;
@@ -225,16 +254,22 @@ common_motion:
                     {
                         /* Re-scan for XTEST pointer, just in case. */
                         xtest_pointer = xinput2_get_xtest_pointer();
+                        xinput2_drop_device_info();
 
                         break;
                     }
             }
         }
 
+        /* Device changes are not seen while uncaptured, so query again later. */
+        if (!mouse_capture)
+            xinput2_drop_device_info();
+
         XFreeEventData(disp, cookie);
         if (exitthread)
             break;
     }
+    xinput2_drop_device_info();
     XCloseDisplay(disp);
 }
 
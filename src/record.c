@@ -0,0 +1,434 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Implementation of the session recorder, which streams the
+ *          frames of the primary monitor and the sound output to a
+ *          file from a background thread.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/video.h>
+#include <86box/sound.h>
+#include <86box/record.h>
+
+/*
+ * Recording file format, all fields little endian:
+ *   header: "86RC", version, sample rate, channels, flags (32-bit each)
+ *   chunk:  type, payload size (32-bit each), payload
+ *
+ * RECORD_CHUNK_AUDIO payloads are interleaved signed 16-bit stereo samples.
+ *
+ * RECORD_CHUNK_VIDEO payloads start with the audio position of the frame
+ * in sample frames (64-bit), then width, height, first line and line count
+ * (32-bit each). Each of the lines that follows has a 32-bit length and its
+ * data. A length of 0 means the line is the same as in the previous frame,
+ * as are all lines outside the range, so a repeated frame has no lines at
+ * all. With RECORD_FLAG_RLE lines are a sequence of 16-bit tokens: with
+ * bit 15 set, the next 32-bit pixel repeats (token & 0x7fff) + 1 times,
+ * otherwise (token + 1) literal pixels follow. Without it lines are raw
+ * 32-bit pixels.
+ */
+#define RECORD_VERSION     1
+#define RECORD_FLAG_RLE    1
+#define RECORD_CHUNK_VIDEO 1
+#define RECORD_CHUNK_AUDIO 2
+
+/* How much captured data may wait for the writer before the producer blocks. */
+#define RECORD_MAX_QUEUED  (64 << 20)
+
+typedef struct record_item_t {
+    struct record_item_t *next;
+
+    int      type;
+    uint64_t sample_pos;
+    int      w;
+    int      h;
+    int      first_line;
+    int      num_lines;
+    size_t   size;
+    uint8_t  data[];
+} record_item_t;
+
+/* (O) Record the session to record_path, RLE compressed unless record_raw is set. */
+int  record_enabled = 0;
+int  record_raw     = 0;
+char record_path[1024];
+
+static FILE          *record_fp;
+static thread_t      *record_thread;
+static mutex_t       *record_mutex;
+static event_t       *record_wake_event;
+static event_t       *record_done_event;
+static record_item_t *record_head;
+static record_item_t *record_tail;
+static size_t         record_queued;
+static volatile int   record_run;
+static uint64_t       record_samples;
+
+/* Producer side geometry, a change forces a full frame. */
+static int record_last_x = -1;
+static int record_last_y = -1;
+static int record_last_w = -1;
+static int record_last_h = -1;
+
+/* Writer side copy of the last frame, used to drop unchanged lines. */
+static uint32_t *record_prev;
+static int       record_prev_w;
+static int       record_prev_h;
+static int       record_prev_valid;
+static uint8_t  *record_chunk_buf;
+static size_t    record_chunk_size;
+static uint64_t  record_frames;
+static uint64_t  record_bytes;
+
+static void
+record_write(const void *data, size_t size)
+{
+    fwrite(data, 1, size, record_fp);
+    record_bytes += size;
+}
+
+static size_t
+record_rle_line(uint8_t *out, const uint32_t *src, int w)
+{
+    uint8_t *p = out;
+    int      i = 0;
+    int      lit_start;
+    uint16_t token;
+
+    while (i < w) {
+        int run = 1;
+
+        while (((i + run) < w) && (run < 0x8000) && (src[i + run] == src[i]))
+            run++;
+
+        if (run >= 2) {
+            token = 0x8000 | (run - 1);
+            memcpy(p, &token, 2);
+            memcpy(p + 2, &src[i], 4);
+            p += 6;
+            i += run;
+            continue;
+        }
+
+        /* Gather literals up to the next run of 2 or more. */
+        lit_start = i;
+        while ((i < w) && ((i - lit_start) < 0x8000) &&
+               !(((i + 1) < w) && (src[i + 1] == src[i])))
+            i++;
+        if (i == lit_start)
+            i++;
+
+        token = (uint16_t) (i - lit_start - 1);
+        memcpy(p, &token, 2);
+        memcpy(p + 2, &src[lit_start], (i - lit_start) * 4);
+        p += 2 + (i - lit_start) * 4;
+    }
+
+    return p - out;
+}
+
+static void
+record_write_video(record_item_t *item)
+{
+    const uint32_t *lines = (const uint32_t *) item->data;
+    uint32_t        hdr[6];
+    uint64_t        sample_pos = item->sample_pos;
+    int             first      = -1;
+    int             last       = -1;
+    uint32_t        len;
+    size_t          need;
+    uint8_t        *p;
+
+    if ((item->w != record_prev_w) || (item->h != record_prev_h)) {
+        free(record_prev);
+        record_prev       = (uint32_t *) malloc((size_t) item->w * item->h * sizeof(uint32_t));
+        record_prev_w     = item->w;
+        record_prev_h     = item->h;
+        record_prev_valid = 0;
+    }
+
+    /* Find the lines that really changed; the producer only knows which ones
+       the card redrew. */
+    for (int i = 0; i < item->num_lines; i++) {
+        const uint32_t *src  = &lines[(size_t) i * item->w];
+        uint32_t       *prev = &record_prev[(size_t) (item->first_line + i) * item->w];
+
+        if (record_prev_valid && !memcmp(prev, src, item->w * sizeof(uint32_t)))
+            continue;
+
+        if (first < 0)
+            first = i;
+        last = i;
+    }
+
+    /* The whole payload is built first, so the output never has to seek and
+       can be a pipe. RLE never needs more than 6 bytes per pixel. */
+    need = (first < 0) ? 0 : ((size_t) (last - first + 1) * (((size_t) item->w * 6) + sizeof(uint32_t)));
+    if (need > record_chunk_size) {
+        free(record_chunk_buf);
+        record_chunk_buf  = (uint8_t *) malloc(need);
+        record_chunk_size = need;
+    }
+    p = record_chunk_buf;
+
+    for (int i = first; (first >= 0) && (i <= last); i++) {
+        const uint32_t *src  = &lines[(size_t) i * item->w];
+        uint32_t       *prev = &record_prev[(size_t) (item->first_line + i) * item->w];
+
+        if (record_prev_valid && !memcmp(prev, src, item->w * sizeof(uint32_t))) {
+            len = 0;
+            memcpy(p, &len, sizeof(uint32_t));
+            p += sizeof(uint32_t);
+            continue;
+        }
+
+        memcpy(prev, src, item->w * sizeof(uint32_t));
+
+        if (record_raw) {
+            len = item->w * sizeof(uint32_t);
+            memcpy(p + sizeof(uint32_t), src, len);
+        } else
+            len = (uint32_t) record_rle_line(p + sizeof(uint32_t), src, item->w);
+        memcpy(p, &len, sizeof(uint32_t));
+        p += sizeof(uint32_t) + len;
+    }
+
+    /* A full frame has been seen once every line has been written. */
+    if ((item->first_line == 0) && (item->num_lines == item->h))
+        record_prev_valid = 1;
+
+    hdr[0] = RECORD_CHUNK_VIDEO;
+    hdr[1] = (uint32_t) (sizeof(uint64_t) + (4 * sizeof(uint32_t)) + (p - record_chunk_buf));
+    hdr[2] = item->w;
+    hdr[3] = item->h;
+    hdr[4] = (first < 0) ? 0 : (item->first_line + first);
+    hdr[5] = (first < 0) ? 0 : (last - first + 1);
+
+    record_write(hdr, 2 * sizeof(uint32_t));
+    record_write(&sample_pos, sizeof(uint64_t));
+    record_write(&hdr[2], 4 * sizeof(uint32_t));
+    if (p != record_chunk_buf)
+        record_write(record_chunk_buf, p - record_chunk_buf);
+
+    record_frames++;
+}
+
+static void
+record_write_audio(record_item_t *item)
+{
+    uint32_t hdr[2] = { RECORD_CHUNK_AUDIO, (uint32_t) item->size };
+
+    record_write(hdr, sizeof(hdr));
+    record_write(item->data, item->size);
+}
+
+static void
+record_writer_thread(UNUSED(void *param))
+{
+    record_item_t *item;
+
+    while (1) {
+        thread_wait_mutex(record_mutex);
+        item = record_head;
+        if (item != NULL) {
+            record_head = item->next;
+            if (record_head == NULL)
+                record_tail = NULL;
+        }
+        thread_release_mutex(record_mutex);
+
+        if (item == NULL) {
+            thread_set_event(record_done_event);
+            if (!record_run)
+                break;
+            thread_wait_event(record_wake_event, -1);
+            thread_reset_event(record_wake_event);
+            continue;
+        }
+
+        if (item->type == RECORD_CHUNK_VIDEO)
+            record_write_video(item);
+        else
+            record_write_audio(item);
+
+        thread_wait_mutex(record_mutex);
+        record_queued -= item->size;
+        thread_release_mutex(record_mutex);
+        thread_set_event(record_done_event);
+
+        free(item);
+    }
+}
+
+static void
+record_post(record_item_t *item)
+{
+    /* Rather than dropping data, wait for a slow disk to catch up. */
+    thread_wait_mutex(record_mutex);
+    while (record_queued > RECORD_MAX_QUEUED) {
+        thread_reset_event(record_done_event);
+        thread_release_mutex(record_mutex);
+        thread_set_event(record_wake_event);
+        thread_wait_event(record_done_event, 10);
+        thread_wait_mutex(record_mutex);
+    }
+
+    item->next = NULL;
+    if (record_tail != NULL)
+        record_tail->next = item;
+    else
+        record_head = item;
+    record_tail = item;
+    record_queued += item->size;
+    thread_release_mutex(record_mutex);
+
+    thread_set_event(record_wake_event);
+}
+
+void
+record_init(void)
+{
+    uint32_t header[5];
+
+    if (!record_enabled || (record_fp != NULL))
+        return;
+
+    record_fp = plat_fopen(record_path, "wb");
+    if (record_fp == NULL) {
+        pclog("Record: unable to open %s\n", record_path);
+        return;
+    }
+
+    memcpy(&header[0], "86RC", 4);
+    header[1] = RECORD_VERSION;
+    header[2] = SOUND_FREQ;
+    header[3] = 2;
+    header[4] = record_raw ? 0 : RECORD_FLAG_RLE;
+    record_write(header, sizeof(header));
+
+    record_samples    = 0;
+    record_frames     = 0;
+    record_last_x     = -1;
+    record_prev_valid = 0;
+
+    record_mutex      = thread_create_mutex();
+    record_wake_event = thread_create_event();
+    record_done_event = thread_create_event();
+    record_run        = 1;
+    record_thread     = thread_create_named(record_writer_thread, NULL, "Session recorder");
+}
+
+void
+record_close(void)
+{
+    if (record_fp == NULL)
+        return;
+
+    record_run = 0;
+    thread_set_event(record_wake_event);
+    thread_wait(record_thread);
+    record_thread = NULL;
+
+    thread_destroy_event(record_wake_event);
+    thread_destroy_event(record_done_event);
+    thread_close_mutex(record_mutex);
+
+    pclog("Record: wrote %" PRIu64 " frames and %" PRIu64 " sample frames, %" PRIu64 " bytes\n",
+          record_frames, record_samples, record_bytes);
+
+    fclose(record_fp);
+    record_fp = NULL;
+
+    free(record_prev);
+    record_prev   = NULL;
+    record_prev_w = record_prev_h = 0;
+    free(record_chunk_buf);
+    record_chunk_buf  = NULL;
+    record_chunk_size = 0;
+}
+
+void
+record_video(int x, int y, int w, int h, int dirty_y1, int dirty_y2, int monitor_index)
+{
+    const bitmap_t *b = monitors[monitor_index].target_buffer;
+    record_item_t  *item;
+    int             lines;
+
+    if ((record_fp == NULL) || monitor_index || (b == NULL) ||
+        (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || ((x + w) > b->w) || ((y + h) > b->h))
+        return;
+
+    if ((x != record_last_x) || (y != record_last_y) || (w != record_last_w) || (h != record_last_h)) {
+        dirty_y1      = y;
+        dirty_y2      = y + h - 1;
+        record_last_x = x;
+        record_last_y = y;
+        record_last_w = w;
+        record_last_h = h;
+    }
+    if (dirty_y1 < y)
+        dirty_y1 = y;
+    if (dirty_y2 > (y + h - 1))
+        dirty_y2 = y + h - 1;
+    lines = (dirty_y1 <= dirty_y2) ? (dirty_y2 - dirty_y1 + 1) : 0;
+
+    /* Only the lines the card redrew are copied here, the comparison and
+       compression are left to the writer thread. */
+    item             = (record_item_t *) malloc(sizeof(record_item_t) + (size_t) lines * w * sizeof(uint32_t));
+    item->type       = RECORD_CHUNK_VIDEO;
+    item->sample_pos = record_samples;
+    item->w          = w;
+    item->h          = h;
+    item->first_line = lines ? (dirty_y1 - y) : 0;
+    item->num_lines  = lines;
+    item->size       = (size_t) lines * w * sizeof(uint32_t);
+
+    for (int i = 0; i < lines; i++)
+        memcpy(&item->data[(size_t) i * w * sizeof(uint32_t)], &b->line[dirty_y1 + i][x], w * sizeof(uint32_t));
+
+    record_post(item);
+}
+
+void
+record_audio(const int32_t *buffer, int len)
+{
+    record_item_t *item;
+    int16_t       *out;
+
+    if (record_fp == NULL)
+        return;
+
+    item       = (record_item_t *) malloc(sizeof(record_item_t) + (size_t) len * 2 * sizeof(int16_t));
+    item->type = RECORD_CHUNK_AUDIO;
+    item->size = (size_t) len * 2 * sizeof(int16_t);
+    out        = (int16_t *) item->data;
+
+    for (int c = 0; c < (len * 2); c++) {
+        if (buffer[c] > 32767)
+            out[c] = 32767;
+        else if (buffer[c] < -32768)
+            out[c] = -32768;
+        else
+            out[c] = (int16_t) buffer[c];
+    }
+
+    record_samples += len;
+
+    record_post(item);
+}
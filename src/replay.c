@@ -0,0 +1,541 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Input record and replay.
+ *
+ *          Everything that reaches the machine from outside of the
+ *          emulation thread (keystrokes, mouse movements, frames from
+ *          the host network, media changes, UI hard resets and the time
+ *          of day the RTC starts from) is logged with the emulated time
+ *          it was consumed at. Played back against the same configuration,
+ *          the log feeds the same inputs at the same emulated times with
+ *          the UI and the host network cut off, as fast as the host can go.
+ *
+ *          Keystrokes, mouse movements and media changes are taken from
+ *          the UI by a 1 ms emulated timer, network frames by the card
+ *          timers and hard resets between two frames. An event due in the
+ *          past that was not consumed means the run has diverged, the
+ *          replay then stops and the machine goes on with live input, as
+ *          it does at the end of the log.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/timer.h>
+#include <86box/machine.h>
+#include <86box/keyboard.h>
+#include <86box/mouse.h>
+#include <86box/fdd.h>
+#include <86box/cdrom.h>
+#include <86box/plat.h>
+#include <86box/plat_unused.h>
+#include <86box/thread.h>
+#include <86box/ui.h>
+#include <86box/replay.h>
+
+#define REPLAY_MAGIC     "86RP"
+#define REPLAY_PERIOD    1000.0 /* Emulated us between two UI input polls */
+#define REPLAY_QUEUE_LEN 256
+#define REPLAY_MAX_DATA  65535
+
+enum {
+    REPLAY_EV_KEY = 1, /* unit = down, scan code */
+    REPLAY_EV_MOUSE,   /* replay_mouse_t */
+    REPLAY_EV_NET,     /* unit = card, frame */
+    REPLAY_EV_MEDIA,   /* unit = drive, media type, write protect, path */
+    REPLAY_EV_RESET
+};
+
+typedef struct replay_header_t {
+    char     magic[4];
+    uint32_t version;
+    int64_t  rtc_base;
+    char     machine[32];
+} replay_header_t;
+
+typedef struct replay_event_t {
+    uint64_t tsc;
+    uint32_t epoch;
+    uint8_t  type;
+    uint8_t  unit;
+    uint16_t len;
+} replay_event_t;
+
+typedef struct replay_mouse_t {
+    double  x;
+    double  y;
+    double  x_abs;
+    double  y_abs;
+    int32_t z;
+    int32_t w;
+    int32_t buttons;
+    int32_t pad;
+} replay_mouse_t;
+
+typedef struct replay_input_t {
+    uint8_t  type;
+    uint8_t  unit;
+    uint8_t  media;
+    uint8_t  wp;
+    uint16_t scan;
+    char    *fn;
+} replay_input_t;
+
+int replay_mode = REPLAY_OFF; /* (O) Record or play back the inputs */
+
+static char           replay_fn[1024];
+static FILE          *replay_fp;
+static pc_timer_t     replay_timer;
+static uint32_t       replay_epoch; /* Hard resets so far, tsc restarts at each */
+static int64_t        replay_rtc_base;
+static uint64_t       replay_events;
+static int            replay_dirty;
+
+static replay_event_t replay_head; /* Next event to play back */
+static int            replay_have_head;
+static uint8_t       *replay_data;
+
+static replay_mouse_t replay_last_mouse;
+
+static mutex_t       *replay_mutex;
+static replay_input_t replay_queue[REPLAY_QUEUE_LEN];
+static int            replay_queue_count;
+static int            replay_queue_full;
+
+#ifdef ENABLE_REPLAY_LOG
+int replay_do_log = ENABLE_REPLAY_LOG;
+
+static void
+replay_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (replay_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define replay_log(fmt, ...)
+#endif
+
+void
+replay_set_file(int mode, const char *fn)
+{
+    snprintf(replay_fn, sizeof(replay_fn), "%s", fn);
+    replay_mode = mode;
+}
+
+static void
+replay_stop(void)
+{
+    if (replay_fp != NULL) {
+        fclose(replay_fp);
+        replay_fp = NULL;
+    }
+
+    replay_have_head = 0;
+    replay_mode      = REPLAY_OFF;
+}
+
+static void
+replay_write(int type, int unit, const void *data, int len)
+{
+    replay_event_t ev = { 0 };
+
+    ev.tsc   = tsc;
+    ev.epoch = replay_epoch;
+    ev.type  = type;
+    ev.unit  = unit;
+    ev.len   = len;
+
+    if ((fwrite(&ev, 1, sizeof(ev), replay_fp) != sizeof(ev)) ||
+        (len && (fwrite(data, 1, len, replay_fp) != (size_t) len))) {
+        pclog("Replay: could not write to \"%s\", recording stopped\n", replay_fn);
+        replay_stop();
+        return;
+    }
+
+    replay_events++;
+    replay_dirty = 1;
+    replay_log("Replay: recorded event %i/%i (%i bytes) at %" PRIu32 ":%" PRIu64 "\n", type, unit, len, replay_epoch, tsc);
+}
+
+/* Load the next event to play back. */
+static void
+replay_next(void)
+{
+    replay_have_head = 0;
+
+    if (fread(&replay_head, 1, sizeof(replay_head), replay_fp) != sizeof(replay_head))
+        return;
+    if (replay_head.len && (fread(replay_data, 1, replay_head.len, replay_fp) != replay_head.len))
+        return;
+
+    replay_events++;
+    replay_have_head = 1;
+}
+
+/* Is the next event of this type, and due now? */
+static int
+replay_due(int type, int unit)
+{
+    return replay_have_head && (replay_head.type == type) && ((unit < 0) || (replay_head.unit == unit)) &&
+           (replay_head.epoch == replay_epoch) && (replay_head.tsc == tsc);
+}
+
+/* Stop at the end of the log, or when an event was not consumed in time. */
+static void
+replay_check(void)
+{
+    if (!replay_have_head) {
+        pclog("Replay: end of \"%s\" after %" PRIu64 " events, continuing with live input\n", replay_fn, replay_events);
+        replay_stop();
+    } else if ((replay_head.epoch < replay_epoch) ||
+               ((replay_head.epoch == replay_epoch) && (replay_head.tsc < tsc))) {
+        pclog("Replay: diverged at %" PRIu32 ":%" PRIu64 ", event %" PRIu64 " (type %i) was due at %" PRIu32 ":%" PRIu64
+              ", continuing with live input\n",
+              replay_epoch, tsc, replay_events, replay_head.type, replay_head.epoch, replay_head.tsc);
+        replay_stop();
+    }
+}
+
+static void
+replay_apply_media(int type, int drive, const char *fn, int wp)
+{
+    char path[1024];
+    int  was_empty;
+
+    if (type == REPLAY_MEDIA_FLOPPY) {
+        if (drive >= FDD_NUM)
+            return;
+
+        fdd_close(drive);
+        if (fn[0]) {
+            ui_writeprot[drive] = wp;
+            if (wp && strncmp(fn, "wp://", 5))
+                snprintf(path, sizeof(path), "wp://%s", fn);
+            else
+                snprintf(path, sizeof(path), "%s", fn);
+            fdd_load(drive, path);
+        }
+
+        ui_sb_update_icon_state(SB_FLOPPY | drive, floppyfns[drive][0] ? 0 : 1);
+        ui_sb_update_icon_wp(SB_FLOPPY | drive, ui_writeprot[drive]);
+        ui_sb_update_tip(SB_FLOPPY | drive);
+    } else if (type == REPLAY_MEDIA_CDROM) {
+        if (drive >= CDROM_NUM)
+            return;
+
+        was_empty = cdrom_is_empty(drive);
+        cdrom_exit(drive);
+        memset(cdrom[drive].image_path, 0, sizeof(cdrom[drive].image_path));
+
+        if (fn[0]) {
+            cdrom_load(&(cdrom[drive]), fn, 1);
+
+            /* Signal media change to the emulated machine. */
+            if (cdrom[drive].insert) {
+                cdrom[drive].insert(cdrom[drive].priv);
+
+                /* The drive was previously empty, transition directly to UNIT ATTENTION. */
+                if (was_empty)
+                    cdrom[drive].insert(cdrom[drive].priv);
+            }
+        }
+
+        plat_cdrom_ui_update(drive, 0);
+    }
+}
+
+/* Log and deliver an input the UI queued. */
+static void
+replay_record_input(const replay_input_t *input)
+{
+    uint8_t data[2 + 1024];
+    int     len;
+
+    if (input->type == REPLAY_EV_KEY) {
+        replay_write(REPLAY_EV_KEY, input->unit, &input->scan, sizeof(input->scan));
+        keyboard_process_input(input->unit, input->scan);
+    } else {
+        len     = snprintf((char *) &data[2], sizeof(data) - 2, "%s", input->fn) + 1;
+        data[0] = input->media;
+        data[1] = input->wp;
+        if (len > (int) (sizeof(data) - 2))
+            len = sizeof(data) - 2;
+        replay_write(REPLAY_EV_MEDIA, input->unit, data, len + 2);
+        replay_apply_media(input->media, input->unit, input->fn, input->wp);
+    }
+}
+
+static void
+replay_tick(UNUSED(void *priv))
+{
+    replay_input_t input[REPLAY_QUEUE_LEN];
+    replay_mouse_t mouse = { 0 };
+    int            count;
+    int            z;
+    int            w;
+    int            b;
+
+    if (replay_mode == REPLAY_OFF)
+        return;
+
+    timer_on_auto(&replay_timer, REPLAY_PERIOD);
+
+    thread_wait_mutex(replay_mutex);
+    count = replay_queue_count;
+    memcpy(input, replay_queue, count * sizeof(replay_input_t));
+    replay_queue_count = 0;
+    thread_release_mutex(replay_mutex);
+
+    mouse_replay_take(&mouse.x, &mouse.y, &z, &w, &b);
+    mouse.z       = z;
+    mouse.w       = w;
+    mouse.buttons = b;
+    mouse.x_abs   = mouse_x_abs;
+    mouse.y_abs   = mouse_y_abs;
+
+    if (replay_mode == REPLAY_RECORD) {
+        for (int i = 0; (i < count) && (replay_mode == REPLAY_RECORD); i++)
+            replay_record_input(&input[i]);
+
+        if ((replay_mode == REPLAY_RECORD) &&
+            ((mouse.x != 0.0) || (mouse.y != 0.0) || mouse.z || mouse.w ||
+             (mouse.buttons != replay_last_mouse.buttons) ||
+             (mouse.x_abs != replay_last_mouse.x_abs) || (mouse.y_abs != replay_last_mouse.y_abs))) {
+            replay_write(REPLAY_EV_MOUSE, 0, &mouse, sizeof(mouse));
+            mouse_replay_give(mouse.x, mouse.y, mouse.z, mouse.w, mouse.buttons, mouse.x_abs, mouse.y_abs);
+            replay_last_mouse = mouse;
+        }
+
+        if (replay_dirty && (replay_fp != NULL))
+            fflush(replay_fp);
+        replay_dirty = 0;
+    } else {
+        /* The UI is cut off from the machine while playing back. */
+        while (replay_have_head && (replay_head.epoch == replay_epoch) && (replay_head.tsc == tsc)) {
+            if (replay_head.type == REPLAY_EV_KEY) {
+                uint16_t scan;
+
+                memcpy(&scan, replay_data, sizeof(scan));
+                keyboard_process_input(replay_head.unit, scan);
+            } else if (replay_head.type == REPLAY_EV_MOUSE) {
+                memcpy(&mouse, replay_data, sizeof(mouse));
+                mouse_replay_give(mouse.x, mouse.y, mouse.z, mouse.w, mouse.buttons, mouse.x_abs, mouse.y_abs);
+            } else if (replay_head.type == REPLAY_EV_MEDIA) {
+                replay_data[replay_head.len - 1] = '\0';
+                replay_apply_media(replay_data[0], replay_head.unit, (char *) &replay_data[2], replay_data[1]);
+            } else
+                break;
+
+            replay_next();
+        }
+
+        replay_check();
+    }
+
+    for (int i = 0; i < count; i++)
+        free(input[i].fn);
+}
+
+void
+replay_key(int down, uint16_t scan)
+{
+    if ((replay_mode == REPLAY_PLAY) || (replay_mutex == NULL))
+        return;
+
+    thread_wait_mutex(replay_mutex);
+    if (replay_queue_count < REPLAY_QUEUE_LEN) {
+        replay_queue[replay_queue_count].type = REPLAY_EV_KEY;
+        replay_queue[replay_queue_count].unit = !!down;
+        replay_queue[replay_queue_count].scan = scan;
+        replay_queue[replay_queue_count++].fn = NULL;
+    } else if (!replay_queue_full) {
+        replay_queue_full = 1;
+        pclog("Replay: UI input queue full, keystrokes dropped\n");
+    }
+    thread_release_mutex(replay_mutex);
+}
+
+/* Media changes are made by the replay timer too, the caller must do nothing
+   more if this returns 1. */
+int
+replay_media(int type, int drive, const char *fn, int wp)
+{
+    if ((replay_mode == REPLAY_OFF) || (replay_mutex == NULL))
+        return 0;
+
+    if (replay_mode == REPLAY_PLAY) {
+        pclog("Replay: media changes from the UI are ignored while playing back\n");
+        return 1;
+    }
+
+    thread_wait_mutex(replay_mutex);
+    if (replay_queue_count < REPLAY_QUEUE_LEN) {
+        replay_queue[replay_queue_count].type  = REPLAY_EV_MEDIA;
+        replay_queue[replay_queue_count].unit  = drive;
+        replay_queue[replay_queue_count].media = type;
+        replay_queue[replay_queue_count].wp    = !!wp;
+        replay_queue[replay_queue_count++].fn  = strdup((fn != NULL) ? fn : "");
+    } else
+        pclog("Replay: UI input queue full, media change dropped\n");
+    thread_release_mutex(replay_mutex);
+
+    return 1;
+}
+
+int
+replay_hard_reset(int pending)
+{
+    if (replay_mode == REPLAY_RECORD) {
+        if (pending)
+            replay_write(REPLAY_EV_RESET, 0, NULL, 0);
+        return pending;
+    }
+
+    if (replay_mode == REPLAY_PLAY) {
+        if (!replay_due(REPLAY_EV_RESET, -1))
+            return 0;
+        replay_next();
+        return 1;
+    }
+
+    return pending;
+}
+
+void
+replay_net_log(int card, const uint8_t *data, int len)
+{
+    replay_write(REPLAY_EV_NET, card, data, len);
+}
+
+int
+replay_net_rx(int card, uint8_t *data, int *len, int max)
+{
+    if (!replay_due(REPLAY_EV_NET, card))
+        return 0;
+
+    *len = (replay_head.len > max) ? max : replay_head.len;
+    memcpy(data, replay_data, *len);
+    replay_next();
+
+    return 1;
+}
+
+int
+replay_rtc_time(int64_t *now)
+{
+    if (replay_mode == REPLAY_OFF)
+        return 0;
+
+    *now = replay_rtc_base;
+    return 1;
+}
+
+void
+replay_init(void)
+{
+    replay_header_t hdr = { 0 };
+
+    if (replay_mode == REPLAY_OFF)
+        return;
+
+    replay_fp = plat_fopen(replay_fn, (replay_mode == REPLAY_RECORD) ? "wb" : "rb");
+    if (replay_fp == NULL) {
+        pclog("Replay: could not open \"%s\"\n", replay_fn);
+        replay_mode = REPLAY_OFF;
+        return;
+    }
+
+    if (replay_mode == REPLAY_RECORD) {
+        memcpy(hdr.magic, REPLAY_MAGIC, sizeof(hdr.magic));
+        hdr.version  = REPLAY_VERSION;
+        hdr.rtc_base = (int64_t) time(NULL);
+        snprintf(hdr.machine, sizeof(hdr.machine), "%s", machine_get_internal_name());
+
+        if (fwrite(&hdr, 1, sizeof(hdr), replay_fp) != sizeof(hdr)) {
+            pclog("Replay: could not write to \"%s\"\n", replay_fn);
+            replay_stop();
+            return;
+        }
+    } else {
+        if ((fread(&hdr, 1, sizeof(hdr), replay_fp) != sizeof(hdr)) ||
+            memcmp(hdr.magic, REPLAY_MAGIC, sizeof(hdr.magic)) || (hdr.version != REPLAY_VERSION)) {
+            pclog("Replay: \"%s\" is not an input log of this version\n", replay_fn);
+            replay_stop();
+            return;
+        }
+
+        hdr.machine[sizeof(hdr.machine) - 1] = '\0';
+        if (strcmp(hdr.machine, machine_get_internal_name()))
+            pclog("Replay: \"%s\" was recorded on machine \"%s\", it will likely diverge\n", replay_fn, hdr.machine);
+
+        replay_data = (uint8_t *) malloc(REPLAY_MAX_DATA);
+        replay_next();
+    }
+
+    replay_rtc_base = hdr.rtc_base;
+    replay_epoch    = 0;
+    replay_events   = 0;
+    replay_mutex    = thread_create_mutex();
+
+    pclog("Replay: %s inputs %s \"%s\"\n", (replay_mode == REPLAY_RECORD) ? "recording" : "playing back",
+          (replay_mode == REPLAY_RECORD) ? "to" : "from", replay_fn);
+}
+
+/* Called on every hard reset, the emulated time restarts from zero. */
+void
+replay_reset(void)
+{
+    if (replay_mode == REPLAY_OFF)
+        return;
+
+    replay_epoch++;
+    memset(&replay_last_mouse, 0, sizeof(replay_last_mouse));
+    mouse_replay_give(0.0, 0.0, 0, 0, 0, 0.0, 0.0);
+
+    timer_add(&replay_timer, replay_tick, NULL, 0);
+    timer_on_auto(&replay_timer, REPLAY_PERIOD);
+
+    /* The log may be empty, or have events left from before the reset. */
+    if (replay_mode == REPLAY_PLAY)
+        replay_check();
+}
+
+void
+replay_close(void)
+{
+    if ((replay_mode == REPLAY_RECORD) && (replay_fp != NULL))
+        pclog("Replay: recorded %" PRIu64 " events to \"%s\"\n", replay_events, replay_fn);
+
+    replay_stop();
+
+    if (replay_mutex != NULL) {
+        for (int i = 0; i < replay_queue_count; i++)
+            free(replay_queue[i].fn);
+        replay_queue_count = 0;
+
+        thread_close_mutex(replay_mutex);
+        replay_mutex = NULL;
+    }
+
+    free(replay_data);
+    replay_data = NULL;
+}
@@ -455,6 +455,33 @@ ncr53c8xx_soft_reset(ncr53c8xx_t *dev)
     }
 }
 
+/* Whether an access falls entirely within the on-chip RAM of the 53C875. */
+static __inline int
+ncr53c8xx_is_ram(const ncr53c8xx_t *dev, uint32_t addr, uint32_t len)
+{
+    return dev->ram_mapping.enable && (addr >= dev->ram_mapping.base) &&
+           ((addr - dev->ram_mapping.base + len) <= sizeof(dev->ram));
+}
+
+/* The chip reads and writes its own RAM without going out on the bus. */
+static __inline void
+ncr53c8xx_fetch(ncr53c8xx_t *dev, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (ncr53c8xx_is_ram(dev, addr, len))
+        memcpy(buf, &dev->ram[addr - dev->ram_mapping.base], len);
+    else
+        dma_bm_read(addr, buf, len, 4);
+}
+
+static __inline void
+ncr53c8xx_store(ncr53c8xx_t *dev, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (ncr53c8xx_is_ram(dev, addr, len))
+        memcpy(&dev->ram[addr - dev->ram_mapping.base], buf, len);
+    else
+        dma_bm_write(addr, buf, len, 4);
+}
+
 static void
 ncr53c8xx_read(ncr53c8xx_t *dev, uint32_t addr, uint8_t *buf, uint32_t len)
 {
@@ -466,7 +493,7 @@ ncr53c8xx_read(ncr53c8xx_t *dev, uint32_t addr, uint8_t *buf, uint32_t len)
             buf[i] = inb((uint16_t) (addr + i));
     } else {
         ncr53c8xx_log("NCR 810: Reading from memory address %08X\n", addr);
-        dma_bm_read(addr, buf, len, 4);
+        ncr53c8xx_fetch(dev, addr, buf, len);
     }
 }
 
@@ -481,16 +508,16 @@ ncr53c8xx_write(ncr53c8xx_t *dev, uint32_t addr, uint8_t *buf, uint32_t len)
             outb((uint16_t) (addr + i), buf[i]);
     } else {
         ncr53c8xx_log("NCR 810: Writing to memory address %08X\n", addr);
-        dma_bm_write(addr, buf, len, 4);
+        ncr53c8xx_store(dev, addr, buf, len);
     }
 }
 
 static __inline uint32_t
-read_dword(UNUSED(ncr53c8xx_t *dev), uint32_t addr)
+read_dword(ncr53c8xx_t *dev, uint32_t addr)
 {
     uint32_t buf;
     ncr53c8xx_log("Reading the next DWORD from memory (%08X)...\n", addr);
-    dma_bm_read(addr, (uint8_t *) &buf, 4, 4);
+    ncr53c8xx_fetch(dev, addr, (uint8_t *) &buf, 4);
     return buf;
 }
 
@@ -1033,7 +1060,9 @@ ncr53c8xx_process_script(ncr53c8xx_t *dev)
     dev->sstop = 0;
 again:
     insn_processed++;
-    insn = read_dword(dev, dev->dsp);
+    /* Both words of the instruction in one fetch. */
+    ncr53c8xx_fetch(dev, dev->dsp, (uint8_t *) buf, 8);
+    insn = buf[0];
     if (!insn) {
         /* If we receive an empty opcode increment the DSP by 4 bytes
            instead of 8 and execute the next opcode at that location */
@@ -1045,7 +1074,7 @@ again:
             return;
         }
     }
-    addr = read_dword(dev, dev->dsp + 4);
+    addr = buf[1];
     ncr53c8xx_log("SCRIPTS dsp=%08x opcode %08x arg %08x\n", dev->dsp, insn, addr);
     dev->dsps = addr;
     dev->dcmd = insn >> 24;
@@ -1073,7 +1102,7 @@ again:
 
                 /* 32-bit Table indirect */
                 offset = sextract32(addr, 0, 24);
-                dma_bm_read(dev->dsa + offset, (uint8_t *) buf, 8, 4);
+                ncr53c8xx_fetch(dev, dev->dsa + offset, (uint8_t *) buf, 8);
                 /* byte count is stored in bits 0:23 only */
                 dev->dbc = buf[0] & 0xffffff;
                 addr     = buf[1];
@@ -1369,14 +1398,14 @@ again:
                 n   = (insn & 7);
                 reg = (insn >> 16) & 0xff;
                 if (insn & (1 << 24)) {
-                    dma_bm_read(addr, data, n, 4);
+                    ncr53c8xx_fetch(dev, addr, data, n);
                     for (i = 0; i < n; i++)
                         ncr53c8xx_reg_writeb(dev, reg + i, data[i]);
                 } else {
                     ncr53c8xx_log("Store reg 0x%x size %d addr 0x%08x\n", reg, n, addr);
                     for (i = 0; i < n; i++)
                         data[i] = ncr53c8xx_reg_readb(dev, reg + i);
-                    dma_bm_write(addr, data, n, 4);
+                    ncr53c8xx_store(dev, addr, data, n);
                 }
             }
             break;
@@ -0,0 +1,733 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Machine snapshots (save states).
+ *
+ *          A snapshot holds the machine configuration it was made on, the
+ *          CPU state, the RAM (sparsely, pages of zeroes are left out), the
+ *          core PIC and DMA state, the references to the hard disk images
+ *          along with their overlays, and the state of every device. It is
+ *          only restored onto an identically configured, running machine.
+ *
+ *          Devices opt in through the save_state and load_state members of
+ *          their device_t; a machine with any device that has not is not
+ *          saved. Until the devices have caught up, the Tools menu actions
+ *          and the --resume and --checkpoint options are only built with
+ *          the SNAPSHOTS development branch option.
+ *
+ *          Periodic checkpoints are snapshots that only hold the RAM pages
+ *          changed since the previous checkpoint, which they refer to. Where
+ *          the host allows, RAM is copy-on-write while a checkpoint is being
+ *          written, so that its pages are not copied between the two frames
+ *          it is taken in, see mem_checkpoint_begin().
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/device.h>
+#include <86box/machine.h>
+#include <86box/mem.h>
+#include <86box/timer.h>
+#include <86box/pic.h>
+#include <86box/dma.h>
+#include <86box/hdd.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/ui.h>
+#include <86box/snapshot.h>
+
+#define SNAPSHOT_MAGIC    "86BSNAP"
+#define SNAPSHOT_TAG(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+#define SNAPSHOT_MACHINE  SNAPSHOT_TAG('M', 'A', 'C', 'H')
+#define SNAPSHOT_CPU      SNAPSHOT_TAG('C', 'P', 'U', ' ')
+#define SNAPSHOT_RAM      SNAPSHOT_TAG('R', 'A', 'M', ' ')
+#define SNAPSHOT_PIC      SNAPSHOT_TAG('P', 'I', 'C', ' ')
+#define SNAPSHOT_DMA      SNAPSHOT_TAG('D', 'M', 'A', ' ')
+#define SNAPSHOT_HDD      SNAPSHOT_TAG('H', 'D', 'D', ' ')
+#define SNAPSHOT_DEVICES  SNAPSHOT_TAG('D', 'E', 'V', 'S')
+#define SNAPSHOT_END      SNAPSHOT_TAG('E', 'N', 'D', ' ')
+
+#define SNAPSHOT_RAM_FULL  0
+#define SNAPSHOT_RAM_DELTA 1
+
+#define SNAPSHOT_CHECKPOINT_FULL 16 /* Deltas between two full checkpoints */
+#define SNAPSHOT_CHAIN_MAX       64
+
+struct snapshot_t {
+    uint8_t *buf;
+    size_t   size;  /* Bytes in the buffer */
+    size_t   alloc; /* Bytes allocated */
+    size_t   pos;
+    size_t   end;   /* End of the section being read */
+    size_t   sect;  /* Start of the section being written */
+    int      error;
+};
+
+enum {
+    SNAPSHOT_NONE = 0,
+    SNAPSHOT_SAVE,
+    SNAPSHOT_LOAD
+};
+
+typedef struct snapshot_job_t {
+    char     fn[2048];
+    uint8_t *buf;
+    size_t   size;
+} snapshot_job_t;
+
+int snapshot_checkpoint_secs = 0; /* checkpoint every so many emulated seconds, 0 = off */
+
+static int  snapshot_pending = SNAPSHOT_NONE;
+static char snapshot_fn[1024];
+
+static thread_t    *checkpoint_thread = NULL;
+static volatile int checkpoint_failed = 0;
+static int          checkpoint_elapsed = 0;
+static int          checkpoint_deltas  = 0; /* Deltas since the last full checkpoint */
+static uint32_t     checkpoint_num     = 0;
+static char         checkpoint_parent[64];  /* The checkpoint the next delta is taken against */
+
+#ifdef ENABLE_SNAPSHOT_LOG
+int snapshot_do_log = ENABLE_SNAPSHOT_LOG;
+
+static void
+snapshot_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (snapshot_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define snapshot_log(fmt, ...)
+#endif
+
+static int
+snapshot_grow(snapshot_t *snap, size_t len)
+{
+    uint8_t *buf;
+    size_t   alloc;
+
+    if (snap->error)
+        return 0;
+
+    if ((snap->size + len) > snap->alloc) {
+        alloc = snap->alloc ? snap->alloc : (1 << 20);
+        while (alloc < (snap->size + len))
+            alloc <<= 1;
+
+        buf = (uint8_t *) realloc(snap->buf, alloc);
+        if (buf == NULL) {
+            snap->error = 1;
+            return 0;
+        }
+        snap->buf   = buf;
+        snap->alloc = alloc;
+    }
+
+    return 1;
+}
+
+void
+snapshot_write(snapshot_t *snap, const void *data, size_t len)
+{
+    if (!snapshot_grow(snap, len))
+        return;
+
+    memcpy(&snap->buf[snap->size], data, len);
+    snap->size += len;
+}
+
+/* Leaves room for len bytes that are filled in later, and returns where in
+   the snapshot buffer they are. */
+size_t
+snapshot_reserve(snapshot_t *snap, size_t len)
+{
+    size_t pos = snap->size;
+
+    if (!snapshot_grow(snap, len))
+        return 0;
+
+    snap->size += len;
+
+    return pos;
+}
+
+/* Reading past the end of a section fails, and so does everything after it. */
+int
+snapshot_read(snapshot_t *snap, void *data, size_t len)
+{
+    if (snap->error || (len > (snap->end - snap->pos))) {
+        snap->error = 1;
+        memset(data, 0x00, len);
+        return 0;
+    }
+
+    memcpy(data, &snap->buf[snap->pos], len);
+    snap->pos += len;
+
+    return 1;
+}
+
+/* Timers are stored relative to the current time, and restarted from it. */
+void
+snapshot_write_timer(snapshot_t *snap, pc_timer_t *timer)
+{
+    uint8_t  enabled   = timer_is_enabled(timer);
+    uint64_t remaining = timer_get_remaining_u64(timer);
+
+    snapshot_write_var(snap, enabled);
+    snapshot_write_var(snap, remaining);
+}
+
+int
+snapshot_read_timer(snapshot_t *snap, pc_timer_t *timer)
+{
+    uint8_t  enabled;
+    uint64_t remaining;
+
+    if (!snapshot_read_var(snap, enabled) || !snapshot_read_var(snap, remaining))
+        return 0;
+
+    if (enabled)
+        timer_set_delay_u64(timer, remaining);
+    else
+        timer_disable(timer);
+
+    return 1;
+}
+
+static void
+snapshot_write_string(snapshot_t *snap, const char *str)
+{
+    uint16_t len = (uint16_t) strlen(str);
+
+    snapshot_write_var(snap, len);
+    snapshot_write(snap, str, len);
+}
+
+static int
+snapshot_read_string(snapshot_t *snap, char *str, size_t size)
+{
+    uint16_t len;
+
+    if (!snapshot_read_var(snap, len) || (len >= size) || !snapshot_read(snap, str, len))
+        return 0;
+    str[len] = '\0';
+
+    return 1;
+}
+
+static void
+snapshot_begin(snapshot_t *snap, uint32_t tag)
+{
+    uint32_t len = 0;
+
+    snap->sect = snap->size;
+    snapshot_write_var(snap, tag);
+    snapshot_write_var(snap, len);
+}
+
+static void
+snapshot_end(snapshot_t *snap)
+{
+    uint32_t len;
+
+    if (snap->error)
+        return;
+
+    len = (uint32_t) (snap->size - snap->sect - 8);
+    memcpy(&snap->buf[snap->sect + 4], &len, sizeof(len));
+}
+
+/* Sections come in a fixed order; the unread end of one is skipped, so that
+   newer versions can append to them. */
+static int
+snapshot_section_open(snapshot_t *snap, uint32_t tag)
+{
+    uint32_t t;
+    uint32_t len;
+
+    snap->end = snap->size;
+    if (!snapshot_read_var(snap, t) || !snapshot_read_var(snap, len) || (t != tag) ||
+        (len > (snap->size - snap->pos))) {
+        pclog("Snapshot: section %08X missing or damaged\n", tag);
+        snap->error = 1;
+        return 0;
+    }
+    snap->end = snap->pos + len;
+
+    return 1;
+}
+
+static int
+snapshot_section_close(snapshot_t *snap)
+{
+    if (snap->error)
+        return 0;
+
+    snap->pos = snap->end;
+    snap->end = snap->size;
+
+    return 1;
+}
+
+static void
+snapshot_save_machine(snapshot_t *snap)
+{
+    snapshot_write_string(snap, machine_get_internal_name());
+    snapshot_write_string(snap, cpu_f->internal_name);
+    snapshot_write_var(snap, cpu);
+    snapshot_write_var(snap, fpu_type);
+    snapshot_write_var(snap, mem_size);
+    device_snapshot_list(snap);
+}
+
+static int
+snapshot_check_machine(snapshot_t *snap)
+{
+    char     name[256];
+    char     family[256];
+    int      saved_cpu;
+    int      saved_fpu;
+    uint32_t saved_mem;
+
+    if (!snapshot_read_string(snap, name, sizeof(name)) || !snapshot_read_string(snap, family, sizeof(family)) ||
+        !snapshot_read_var(snap, saved_cpu) || !snapshot_read_var(snap, saved_fpu) ||
+        !snapshot_read_var(snap, saved_mem))
+        return 0;
+
+    if (strcmp(name, machine_get_internal_name()) || strcmp(family, cpu_f->internal_name) ||
+        (saved_cpu != cpu) || (saved_fpu != fpu_type) || (saved_mem != mem_size)) {
+        pclog("Snapshot: made on %s with a different CPU or memory size\n", name);
+        return 0;
+    }
+
+    return device_snapshot_check(snap);
+}
+
+static int
+snapshot_save_hdd(snapshot_t *snap)
+{
+    uint8_t count = 0;
+
+    for (uint8_t c = 0; c < HDD_NUM; c++) {
+        if (hdd_is_valid(c))
+            count++;
+    }
+    snapshot_write_var(snap, count);
+
+    for (uint8_t c = 0; c < HDD_NUM; c++) {
+        if (!hdd_is_valid(c))
+            continue;
+
+        if (!hdd[c].overlay)
+            pclog("Snapshot: hard disk %i has no overlay, its image must stay as it is for the snapshot to be restored\n", c);
+
+        snapshot_write_var(snap, c);
+        snapshot_write_string(snap, hdd[c].fn);
+        if (!hdd_image_save_state(c, snap))
+            return 0;
+    }
+
+    return 1;
+}
+
+static int
+snapshot_load_hdd(snapshot_t *snap)
+{
+    char    fn[1024];
+    uint8_t count;
+    uint8_t id;
+
+    if (!snapshot_read_var(snap, count))
+        return 0;
+
+    for (uint8_t c = 0; c < count; c++) {
+        if (!snapshot_read_var(snap, id) || (id >= HDD_NUM) || !snapshot_read_string(snap, fn, sizeof(fn)))
+            return 0;
+
+        if (!hdd_is_valid(id) || strcmp(fn, hdd[id].fn)) {
+            pclog("Snapshot: hard disk %i is not %s\n", id, fn);
+            return 0;
+        }
+
+        if (!hdd_image_load_state(id, snap))
+            return 0;
+    }
+
+    return 1;
+}
+
+/* Builds the whole snapshot in memory, against the given checkpoint for the
+   RAM if there is one. */
+static int
+snapshot_build(snapshot_t *snap, const char *parent)
+{
+    uint32_t version = SNAPSHOT_VERSION;
+    uint8_t  kind    = (parent != NULL) ? SNAPSHOT_RAM_DELTA : SNAPSHOT_RAM_FULL;
+
+    memset(snap, 0x00, sizeof(snapshot_t));
+
+    snapshot_write(snap, SNAPSHOT_MAGIC, 8);
+    snapshot_write_var(snap, version);
+
+    snapshot_begin(snap, SNAPSHOT_MACHINE);
+    snapshot_save_machine(snap);
+    snapshot_end(snap);
+
+    snapshot_begin(snap, SNAPSHOT_CPU);
+    cpu_save_state(snap);
+    snapshot_end(snap);
+
+    snapshot_begin(snap, SNAPSHOT_RAM);
+    snapshot_write_var(snap, kind);
+    if (parent != NULL) {
+        snapshot_write_string(snap, parent);
+        mem_save_state_delta(snap);
+    } else
+        mem_save_state(snap);
+    snapshot_end(snap);
+
+    snapshot_begin(snap, SNAPSHOT_PIC);
+    pic_save_state(snap);
+    snapshot_end(snap);
+
+    snapshot_begin(snap, SNAPSHOT_DMA);
+    dma_save_state(snap);
+    snapshot_end(snap);
+
+    snapshot_begin(snap, SNAPSHOT_HDD);
+    if (!snapshot_save_hdd(snap))
+        snap->error = 1;
+    snapshot_end(snap);
+
+    snapshot_begin(snap, SNAPSHOT_DEVICES);
+    device_snapshot_save(snap);
+    snapshot_end(snap);
+
+    snapshot_begin(snap, SNAPSHOT_END);
+    snapshot_end(snap);
+
+    return !snap->error;
+}
+
+static int
+snapshot_write_file(const char *fn, const uint8_t *buf, size_t size)
+{
+    FILE *fp;
+    int   ret;
+
+    if ((fp = plat_fopen(fn, "wb")) == NULL)
+        return 0;
+
+    ret = (fwrite(buf, 1, size, fp) == size);
+    if (fclose(fp) != 0)
+        ret = 0;
+    if (!ret)
+        plat_remove((char *) fn);
+
+    return ret;
+}
+
+static int
+snapshot_read_file(const char *fn, snapshot_t *snap)
+{
+    char     magic[8];
+    uint32_t version;
+    FILE    *fp;
+    long     size;
+
+    memset(snap, 0x00, sizeof(snapshot_t));
+
+    if ((fp = plat_fopen(fn, "rb")) == NULL) {
+        pclog("Snapshot: could not open %s\n", fn);
+        return 0;
+    }
+
+    if ((fseek(fp, 0, SEEK_END) == 0) && ((size = ftell(fp)) > 0) && (fseek(fp, 0, SEEK_SET) == 0)) {
+        snap->buf  = (uint8_t *) malloc(size);
+        snap->size = snap->alloc = snap->end = size;
+        if ((snap->buf == NULL) || (fread(snap->buf, 1, size, fp) != (size_t) size))
+            snap->size = snap->end = 0;
+    }
+    fclose(fp);
+
+    if (!snapshot_read(snap, magic, 8) || memcmp(magic, SNAPSHOT_MAGIC, 8) ||
+        !snapshot_read_var(snap, version) || (version != SNAPSHOT_VERSION)) {
+        pclog("Snapshot: %s is not a snapshot of this version\n", fn);
+        free(snap->buf);
+        snap->buf = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+/* A delta brings in the RAM of its parent checkpoint first, which may be a
+   delta itself, from the same directory. */
+static int
+snapshot_load_ram(snapshot_t *snap, const char *fn, int depth)
+{
+    snapshot_t parent_snap;
+    char       parent[1024];
+    char       dir[1024];
+    char       path[2048];
+    uint8_t    kind;
+    int        ret;
+
+    if (!snapshot_read_var(snap, kind))
+        return 0;
+
+    if (kind == SNAPSHOT_RAM_FULL)
+        return mem_load_state(snap);
+
+    if ((kind != SNAPSHOT_RAM_DELTA) || (depth >= SNAPSHOT_CHAIN_MAX) ||
+        !snapshot_read_string(snap, parent, sizeof(parent)))
+        return 0;
+
+    path_get_dirname(dir, fn);
+    path_append_filename(path, dir, parent);
+    if (!snapshot_read_file(path, &parent_snap))
+        return 0;
+
+    ret = snapshot_section_open(&parent_snap, SNAPSHOT_MACHINE) && snapshot_section_close(&parent_snap) &&
+          snapshot_section_open(&parent_snap, SNAPSHOT_CPU) && snapshot_section_close(&parent_snap) &&
+          snapshot_section_open(&parent_snap, SNAPSHOT_RAM) && snapshot_load_ram(&parent_snap, path, depth + 1);
+    free(parent_snap.buf);
+
+    if (!ret) {
+        pclog("Snapshot: could not restore the RAM of %s\n", path);
+        return 0;
+    }
+
+    return mem_load_state_delta(snap);
+}
+
+int
+snapshot_save(const char *fn)
+{
+    snapshot_t snap;
+    char       missing[1024];
+    char       msg[1280];
+    int        ret;
+
+    if (!device_snapshot_supported(missing, sizeof(missing))) {
+        pclog("Snapshot: this machine cannot be saved\n");
+        snprintf(msg, sizeof(msg), "A snapshot of this machine cannot be taken, as these devices do not support it yet:\n\n%s", missing);
+        ui_msgbox_header(MBX_ERROR | MBX_ANSI, "Snapshot not saved", msg);
+        return 0;
+    }
+
+    ret = snapshot_build(&snap, NULL) && snapshot_write_file(fn, snap.buf, snap.size);
+
+    /* The page hashes now describe this snapshot, not the last checkpoint. */
+    checkpoint_parent[0] = '\0';
+
+    if (ret)
+        snapshot_log("Snapshot: %" PRIu64 " bytes saved to %s\n", (uint64_t) snap.size, fn);
+    else {
+        pclog("Snapshot: could not save %s\n", fn);
+        snprintf(msg, sizeof(msg), "The snapshot could not be written to %s.", fn);
+        ui_msgbox_header(MBX_ERROR | MBX_ANSI, "Snapshot not saved", msg);
+    }
+
+    free(snap.buf);
+
+    return ret;
+}
+
+int
+snapshot_load(const char *fn)
+{
+    snapshot_t snap;
+    char       msg[1280];
+    int        ret = 0;
+
+    if (!snapshot_read_file(fn, &snap)) {
+        snprintf(msg, sizeof(msg), "%s could not be read, or is not a snapshot of this version.", fn);
+        ui_msgbox_header(MBX_ERROR | MBX_ANSI, "Snapshot not restored", msg);
+        return 0;
+    }
+
+    /* Nothing is touched until the snapshot is known to fit this machine. */
+    if (snapshot_section_open(&snap, SNAPSHOT_MACHINE) && snapshot_check_machine(&snap) && snapshot_section_close(&snap)) {
+        ret = snapshot_section_open(&snap, SNAPSHOT_CPU) && cpu_load_state(&snap) && snapshot_section_close(&snap) &&
+              snapshot_section_open(&snap, SNAPSHOT_RAM) && snapshot_load_ram(&snap, fn, 0) && snapshot_section_close(&snap) &&
+              snapshot_section_open(&snap, SNAPSHOT_PIC) && pic_load_state(&snap) && snapshot_section_close(&snap) &&
+              snapshot_section_open(&snap, SNAPSHOT_DMA) && dma_load_state(&snap) && snapshot_section_close(&snap) &&
+              snapshot_section_open(&snap, SNAPSHOT_HDD) && snapshot_load_hdd(&snap) && snapshot_section_close(&snap) &&
+              snapshot_section_open(&snap, SNAPSHOT_DEVICES) && device_snapshot_load(&snap) && snapshot_section_close(&snap);
+
+        /* The machine is in an undefined state now. */
+        if (!ret)
+            pc_reset_hard();
+    }
+
+    /* The next checkpoint starts a new chain. */
+    checkpoint_parent[0] = '\0';
+
+    if (ret)
+        snapshot_log("Snapshot: %s restored\n", fn);
+    else {
+        pclog("Snapshot: could not restore %s\n", fn);
+        snprintf(msg, sizeof(msg), "%s does not match this machine, or is damaged. See the log for details.", fn);
+        ui_msgbox_header(MBX_ERROR | MBX_ANSI, "Snapshot not restored", msg);
+    }
+
+    free(snap.buf);
+
+    return ret;
+}
+
+static void
+snapshot_writer_thread(void *priv)
+{
+    snapshot_job_t *job = (snapshot_job_t *) priv;
+
+    /* The RAM pages the checkpoint holds go in first. */
+    mem_checkpoint_fill();
+
+    if (!snapshot_write_file(job->fn, job->buf, job->size)) {
+        pclog("Snapshot: could not write checkpoint %s\n", job->fn);
+        checkpoint_failed = 1;
+    }
+
+    free(job->buf);
+    free(job);
+}
+
+/* Wait for the checkpoint being written, if any. */
+static void
+snapshot_checkpoint_wait(void)
+{
+    if (checkpoint_thread != NULL) {
+        thread_wait(checkpoint_thread);
+        checkpoint_thread = NULL;
+    }
+
+    /* A delta against a checkpoint that was not written is of no use. */
+    if (checkpoint_failed) {
+        checkpoint_parent[0] = '\0';
+        checkpoint_failed    = 0;
+    }
+}
+
+/* Only the pages changed since the last checkpoint are taken, every
+   SNAPSHOT_CHECKPOINT_FULL checkpoints a full one starts the chain over.
+   The state is copied here, the file is written on its own thread. */
+void
+snapshot_checkpoint(void)
+{
+    snapshot_job_t *job;
+    snapshot_t      snap;
+    char            dir[1024];
+    char            name[64];
+    int             delta;
+
+    if (!device_snapshot_supported(NULL, 0)) {
+        pclog("Snapshot: this machine cannot be saved, checkpoints disabled\n");
+        snapshot_checkpoint_secs = 0;
+        return;
+    }
+
+    snapshot_checkpoint_wait();
+    mem_checkpoint_begin();
+
+    delta = (checkpoint_parent[0] != '\0') && mem_can_save_delta() && (checkpoint_deltas < SNAPSHOT_CHECKPOINT_FULL);
+
+    if (!snapshot_build(&snap, delta ? checkpoint_parent : NULL)) {
+        pclog("Snapshot: could not take checkpoint %u\n", checkpoint_num);
+        mem_checkpoint_end(NULL);
+        checkpoint_parent[0] = '\0';
+        free(snap.buf);
+        return;
+    }
+
+    /* From here on RAM is copy-on-write until the writer has the pages. */
+    mem_checkpoint_end(snap.buf);
+
+    path_append_filename(dir, usr_path, "checkpoints");
+    if (!plat_dir_check(dir))
+        plat_dir_create(dir);
+
+    snprintf(name, sizeof(name), "checkpoint-%05u.86s", checkpoint_num++);
+
+    job = (snapshot_job_t *) calloc(1, sizeof(snapshot_job_t));
+    path_append_filename(job->fn, dir, name);
+    job->buf  = snap.buf;
+    job->size = snap.size;
+
+    snapshot_log("Snapshot: checkpoint %s, %" PRIu64 " bytes%s\n", name, (uint64_t) snap.size, delta ? " (delta)" : "");
+
+    checkpoint_thread = thread_create(snapshot_writer_thread, job);
+
+    strncpy(checkpoint_parent, name, sizeof(checkpoint_parent) - 1);
+    checkpoint_deltas = delta ? (checkpoint_deltas + 1) : 0;
+}
+
+/* Called once every emulated second. */
+void
+snapshot_idle(void)
+{
+    if ((snapshot_checkpoint_secs > 0) && (++checkpoint_elapsed >= snapshot_checkpoint_secs)) {
+        checkpoint_elapsed = 0;
+        snapshot_checkpoint();
+    }
+}
+
+void
+snapshot_close(void)
+{
+    snapshot_checkpoint_wait();
+}
+
+void
+snapshot_request_save(const char *fn)
+{
+    strncpy(snapshot_fn, fn, sizeof(snapshot_fn) - 1);
+    snapshot_pending = SNAPSHOT_SAVE;
+}
+
+void
+snapshot_request_load(const char *fn)
+{
+    strncpy(snapshot_fn, fn, sizeof(snapshot_fn) - 1);
+    snapshot_pending = SNAPSHOT_LOAD;
+}
+
+/* Called from the emulation thread, with the CPU between two frames. */
+void
+snapshot_process(void)
+{
+    int op = snapshot_pending;
+
+    if (op == SNAPSHOT_NONE)
+        return;
+
+    snapshot_pending = SNAPSHOT_NONE;
+
+    if (op == SNAPSHOT_SAVE)
+        snapshot_save(snapshot_fn);
+    else
+        snapshot_load(snapshot_fn);
+}
@@ -1,4 +1,5 @@
 /* some code borrowed from scummvm */
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,27 +8,41 @@
 #ifdef __unix__
 #    include <unistd.h>
 #endif
+#ifdef _WIN32
+#    include <windows.h>
+#    include <io.h>
+#else
+#    include <sys/mman.h>
+#endif
 #include <fluidsynth.h>
 
 #include <86box/86box.h>
 #include <86box/config.h>
 #include <86box/device.h>
 #include <86box/midi.h>
-#include <86box/thread.h>
+#include <86box/midi_render.h>
+#include <86box/plat.h>
 #include <86box/sound.h>
+#include <86box/thread.h>
 #include <86box/plat_unused.h>
 
-#define RENDER_RATE                100
-#define BUFFER_SEGMENTS            10
-
 /* Check the FluidSynth version to determine wheteher to use the older reverb/chorus
    control functions that were deprecated in 2.2.0, or their newer replacements */
 #if (FLUIDSYNTH_VERSION_MAJOR < 2) || ((FLUIDSYNTH_VERSION_MAJOR == 2) && (FLUIDSYNTH_VERSION_MINOR < 2))
 #    define USE_OLD_FLUIDSYNTH_API
 #endif
 
-extern void givealbuffer_midi(void *buf, uint32_t size);
-extern void al_set_midi(int freq, int buf_size);
+/* SoundFont loader file callbacks appeared in 2.0.0, with 64-bit offsets from 2.2.0. */
+#if FLUIDSYNTH_VERSION_MAJOR >= 2
+#    define USE_FLUIDSYNTH_MMAP_LOADER
+#    ifdef USE_OLD_FLUIDSYNTH_API
+typedef long fluidsynth_off_t;
+typedef int  fluidsynth_count_t;
+#    else
+typedef fluid_long_long_t fluidsynth_off_t;
+typedef fluid_long_long_t fluidsynth_count_t;
+#    endif
+#endif
 
 typedef struct fluidsynth {
     fluid_settings_t *settings;
@@ -35,16 +50,30 @@ typedef struct fluidsynth {
     int               samplerate;
     int               sound_font;
 
-    thread_t *thread_h;
-    event_t  *event, *start_event;
-    int       buf_size;
-    float    *buffer;
-    int16_t  *buffer_int16;
-    int       midi_pos;
+    /* The SoundFont is loaded in the background into a synth of its own, then
+       handed to the render thread, which moves it to the playing synth. */
+    char                     sound_font_path[1024];
+    fluid_synth_t           *loader_synth;
+    thread_t                *loader_thread;
+    _Atomic(fluid_sfont_t *) pending_sfont;
 
-    int on;
+    midi_render_t *render;
 } fluidsynth_t;
 
+#ifdef USE_FLUIDSYNTH_MMAP_LOADER
+/* A SoundFont file mapped into memory, the mapping shares the page cache
+   between every emulator process using the same bank. */
+typedef struct fluidsynth_map_t {
+    FILE    *fp;
+#    ifdef _WIN32
+    HANDLE   handle;
+#    endif
+    uint8_t *data;
+    uint64_t size;
+    uint64_t pos;
+} fluidsynth_map_t;
+#endif
+
 fluidsynth_t fsdev;
 
 int
@@ -57,54 +86,178 @@ void
 fluidsynth_poll(void)
 {
     fluidsynth_t *data = &fsdev;
-    data->midi_pos++;
-    if (data->midi_pos == SOUND_FREQ / RENDER_RATE) {
-        data->midi_pos = 0;
-        thread_set_event(data->event);
+
+    midi_render_poll(data->render);
+}
+
+#ifdef USE_FLUIDSYNTH_MMAP_LOADER
+static void *
+fluidsynth_map_open(const char *filename)
+{
+    fluidsynth_map_t *map = (fluidsynth_map_t *) calloc(1, sizeof(fluidsynth_map_t));
+
+    if ((map->fp = plat_fopen64(filename, "rb")) == NULL)
+        goto fail;
+
+    if ((fseeko64(map->fp, 0, SEEK_END) == -1) || ((int64_t) (map->size = ftello64(map->fp)) <= 0) ||
+        (map->size > (uint64_t) SIZE_MAX))
+        goto fail;
+
+#    ifdef _WIN32
+    map->handle = CreateFileMapping((HANDLE) _get_osfhandle(_fileno(map->fp)), NULL, PAGE_READONLY, 0, 0, NULL);
+    if (map->handle == NULL)
+        goto fail;
+
+    map->data = (uint8_t *) MapViewOfFile(map->handle, FILE_MAP_READ, 0, 0, (SIZE_T) map->size);
+    if (map->data == NULL) {
+        CloseHandle(map->handle);
+        goto fail;
+    }
+#    else
+    map->data = (uint8_t *) mmap(NULL, (size_t) map->size, PROT_READ, MAP_SHARED, fileno(map->fp), 0);
+    if (map->data == MAP_FAILED)
+        goto fail;
+#    endif
+
+    return map;
+
+fail:
+    if (map->fp != NULL)
+        fclose(map->fp);
+    free(map);
+
+    return NULL;
+}
+
+static int
+fluidsynth_map_read(void *buf, fluidsynth_count_t count, void *handle)
+{
+    fluidsynth_map_t *map = (fluidsynth_map_t *) handle;
+
+    if ((count < 0) || ((uint64_t) count > (map->size - map->pos)))
+        return FLUID_FAILED;
+
+    memcpy(buf, &map->data[map->pos], (size_t) count);
+    map->pos += count;
+
+    return FLUID_OK;
+}
+
+static int
+fluidsynth_map_seek(void *handle, fluidsynth_off_t offset, int origin)
+{
+    fluidsynth_map_t *map = (fluidsynth_map_t *) handle;
+    int64_t           pos;
+
+    switch (origin) {
+        case SEEK_SET:
+            pos = offset;
+            break;
+        case SEEK_CUR:
+            pos = (int64_t) map->pos + offset;
+            break;
+        case SEEK_END:
+            pos = (int64_t) map->size + offset;
+            break;
+        default:
+            return FLUID_FAILED;
+    }
+
+    if ((pos < 0) || ((uint64_t) pos > map->size))
+        return FLUID_FAILED;
+
+    map->pos = pos;
+
+    return FLUID_OK;
+}
+
+static fluidsynth_off_t
+fluidsynth_map_tell(void *handle)
+{
+    const fluidsynth_map_t *map = (fluidsynth_map_t *) handle;
+
+    return (fluidsynth_off_t) map->pos;
+}
+
+static int
+fluidsynth_map_close(void *handle)
+{
+    fluidsynth_map_t *map = (fluidsynth_map_t *) handle;
+
+#    ifdef _WIN32
+    UnmapViewOfFile(map->data);
+    CloseHandle(map->handle);
+#    else
+    munmap(map->data, (size_t) map->size);
+#    endif
+    fclose(map->fp);
+    free(map);
+
+    return FLUID_OK;
+}
+#endif
+
+static void
+fluidsynth_load_thread(void *priv)
+{
+    fluidsynth_t  *data = (fluidsynth_t *) priv;
+    fluid_sfont_t *sfont;
+    int            id;
+
+    data->loader_synth = new_fluid_synth(data->settings);
+    if (data->loader_synth == NULL)
+        return;
+
+#ifdef USE_FLUIDSYNTH_MMAP_LOADER
+    fluid_sfloader_t *loader = new_fluid_defsfloader(data->settings);
+
+    if (loader != NULL) {
+        fluid_sfloader_set_callbacks(loader, fluidsynth_map_open, fluidsynth_map_read, fluidsynth_map_seek,
+                                     fluidsynth_map_tell, fluidsynth_map_close);
+        /* Added loaders are tried first, the default one remains as the fallback. */
+        fluid_synth_add_sfloader(data->loader_synth, loader);
     }
+#endif
+
+    id = fluid_synth_sfload(data->loader_synth, data->sound_font_path, 0);
+    if (id == FLUID_FAILED) {
+        pclog("FluidSynth: Unable to load SoundFont \"%s\"\n", data->sound_font_path);
+        return;
+    }
+
+    /* The loader synth stays around until close, it owns the loader which
+       dynamic sample loading keeps reading through. */
+    sfont = fluid_synth_get_sfont_by_id(data->loader_synth, id);
+    fluid_synth_remove_sfont(data->loader_synth, sfont);
+    atomic_store(&data->pending_sfont, sfont);
 }
 
+/* These run on the render thread, which is the only one talking to the synth. */
 static void
-fluidsynth_thread(void *param)
+fluidsynth_render(void *priv, void *buf, uint32_t frames)
 {
-    fluidsynth_t *data     = (fluidsynth_t *) param;
-    int           buf_pos  = 0;
-    int           buf_size = data->buf_size / BUFFER_SEGMENTS;
-
-    thread_set_event(data->start_event);
-
-    while (data->on) {
-        thread_wait_event(data->event, -1);
-        thread_reset_event(data->event);
-
-        if (sound_is_float) {
-            float *buf = (float *) ((uint8_t *) data->buffer + buf_pos);
-            memset(buf, 0, buf_size);
-            if (data->synth)
-                fluid_synth_write_float(data->synth, buf_size / (2 * sizeof(float)), buf, 0, 2, buf, 1, 2);
-            buf_pos += buf_size;
-            if (buf_pos >= data->buf_size) {
-                givealbuffer_midi(data->buffer, data->buf_size / sizeof(float));
-                buf_pos = 0;
-            }
-        } else {
-            int16_t *buf = (int16_t *) ((uint8_t *) data->buffer_int16 + buf_pos);
-            memset(buf, 0, buf_size);
-            if (data->synth)
-                fluid_synth_write_s16(data->synth, buf_size / (2 * sizeof(int16_t)), buf, 0, 2, buf, 1, 2);
-            buf_pos += buf_size;
-            if (buf_pos >= data->buf_size) {
-                givealbuffer_midi(data->buffer_int16, data->buf_size / sizeof(int16_t));
-                buf_pos = 0;
-            }
-        }
+    fluidsynth_t  *data = (fluidsynth_t *) priv;
+    fluid_sfont_t *sfont;
+
+    if (!data->synth)
+        return;
+
+    /* The SoundFont is ready, the channels keep the programs selected so far. */
+    if ((sfont = atomic_exchange(&data->pending_sfont, NULL)) != NULL) {
+        data->sound_font = fluid_synth_add_sfont(data->synth, sfont);
+        fluid_synth_program_reset(data->synth);
     }
+
+    if (sound_is_float)
+        fluid_synth_write_float(data->synth, frames, buf, 0, 2, buf, 1, 2);
+    else
+        fluid_synth_write_s16(data->synth, frames, buf, 0, 2, buf, 1, 2);
 }
 
-void
-fluidsynth_msg(uint8_t *msg)
+static void
+fluidsynth_render_msg(void *priv, uint8_t *msg)
 {
-    fluidsynth_t *data = &fsdev;
+    const fluidsynth_t *data = (fluidsynth_t *) priv;
 
     uint32_t val = *((uint32_t *) msg);
 
@@ -141,14 +294,26 @@ fluidsynth_msg(uint8_t *msg)
     }
 }
 
-void
-fluidsynth_sysex(uint8_t *data, unsigned int len)
+static void
+fluidsynth_render_sysex(void *priv, uint8_t *data, unsigned int len)
 {
-    fluidsynth_t *d = &fsdev;
+    const fluidsynth_t *d = (fluidsynth_t *) priv;
 
     fluid_synth_sysex(d->synth, (const char *) data, len, 0, 0, 0, 0);
 }
 
+void
+fluidsynth_msg(uint8_t *msg)
+{
+    midi_render_msg(fsdev.render, msg);
+}
+
+void
+fluidsynth_sysex(uint8_t *data, unsigned int len)
+{
+    midi_render_sysex(fsdev.render, data, len);
+}
+
 void *
 fluidsynth_init(UNUSED(const device_t *info))
 {
@@ -171,7 +336,7 @@ fluidsynth_init(UNUSED(const device_t *info))
         sound_font = (access("/usr/share/sounds/sf2/FluidR3_GM.sf2", F_OK) == 0 ? "/usr/share/sounds/sf2/FluidR3_GM.sf2" :
                       (access("/usr/share/soundfonts/default.sf2", F_OK) == 0 ? "/usr/share/soundfonts/default.sf2" : ""));
 #endif
-    data->sound_font = fluid_synth_sfload(data->synth, sound_font, 1);
+    snprintf(data->sound_font_path, sizeof(data->sound_font_path), "%s", sound_font ? sound_font : "");
 
     if (device_get_config_int("chorus")) {
 #ifndef USE_OLD_FLUIDSYNTH_API
@@ -251,17 +416,6 @@ fluidsynth_init(UNUSED(const device_t *info))
     double samplerate;
     fluid_settings_getnum(data->settings, "synth.sample-rate", &samplerate);
     data->samplerate = (int) samplerate;
-    if (sound_is_float) {
-        data->buf_size     = (data->samplerate / RENDER_RATE) * 2 * sizeof(float) * BUFFER_SEGMENTS;
-        data->buffer       = malloc(data->buf_size);
-        data->buffer_int16 = NULL;
-    } else {
-        data->buf_size     = (data->samplerate / RENDER_RATE) * 2 * sizeof(int16_t) * BUFFER_SEGMENTS;
-        data->buffer       = NULL;
-        data->buffer_int16 = malloc(data->buf_size);
-    }
-
-    al_set_midi(data->samplerate, data->buf_size);
 
     dev = calloc(1, sizeof(midi_device_t));
 
@@ -269,17 +423,13 @@ fluidsynth_init(UNUSED(const device_t *info))
     dev->play_sysex = fluidsynth_sysex;
     dev->poll       = fluidsynth_poll;
 
-    midi_out_init(dev);
-
-    data->on = 1;
+    data->render = midi_render_create("FluidSynth render", data->samplerate,
+                                      fluidsynth_render, fluidsynth_render_msg, fluidsynth_render_sysex, data);
 
-    data->start_event = thread_create_event();
+    /* Large banks take seconds to load, so the machine starts without waiting. */
+    data->loader_thread = thread_create_named(fluidsynth_load_thread, data, "FluidSynth SoundFont loader");
 
-    data->event    = thread_create_event();
-    data->thread_h = thread_create(fluidsynth_thread, data);
-
-    thread_wait_event(data->start_event, -1);
-    thread_reset_event(data->start_event);
+    midi_out_init(dev);
 
     return dev;
 }
@@ -292,29 +442,34 @@ fluidsynth_close(void *priv)
 
     fluidsynth_t *data = &fsdev;
 
-    data->on = 0;
-    thread_set_event(data->event);
-    thread_wait(data->thread_h);
+    midi_render_close(data->render);
+    data->render = NULL;
+
+    if (data->loader_thread) {
+        thread_wait(data->loader_thread);
+        data->loader_thread = NULL;
+    }
 
     if (data->synth) {
+        fluid_sfont_t *sfont = atomic_exchange(&data->pending_sfont, NULL);
+
+        /* Loaded but never picked up, let the synth free it. */
+        if (sfont != NULL)
+            fluid_synth_add_sfont(data->synth, sfont);
+
         delete_fluid_synth(data->synth);
         data->synth = NULL;
     }
 
+    if (data->loader_synth) {
+        delete_fluid_synth(data->loader_synth);
+        data->loader_synth = NULL;
+    }
+
     if (data->settings) {
         delete_fluid_settings(data->settings);
         data->settings = NULL;
     }
-
-    if (data->buffer) {
-        free(data->buffer);
-        data->buffer = NULL;
-    }
-
-    if (data->buffer_int16) {
-        free(data->buffer_int16);
-        data->buffer_int16 = NULL;
-    }
 }
 
 static const device_config_t fluidsynth_config[] = {
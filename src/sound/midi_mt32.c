@@ -8,8 +8,8 @@
 #include <86box/device.h>
 #include <86box/mem.h>
 #include <86box/midi.h>
+#include <86box/midi_render.h>
 #include <86box/plat.h>
-#include <86box/thread.h>
 #include <86box/rom.h>
 #include <86box/sound.h>
 #include <86box/ui.h>
@@ -24,9 +24,6 @@
 #define CM32LN_CTRL_ROM   "roms/sound/cm32ln/CM32LN_CONTROL.ROM"
 #define CM32LN_PCM_ROM    "roms/sound/cm32ln/CM32LN_PCM.ROM"
 
-extern void givealbuffer_midi(void *buf, uint32_t size);
-extern void al_set_midi(int freq, int buf_size);
-
 static mt32emu_report_handler_version get_mt32_report_handler_version(mt32emu_report_handler_i i);
 static void                           display_mt32_message(void *instance_data, const char *message);
 
@@ -150,19 +147,7 @@ cm32ln_available(void)
     return roms_present[1];
 }
 
-static thread_t *thread_h    = NULL;
-static event_t  *event       = NULL;
-static event_t  *start_event = NULL;
-static int       mt32_on     = 0;
-
-#define RENDER_RATE     100
-#define BUFFER_SEGMENTS 10
-
-static uint32_t samplerate   = 44100;
-static int      buf_size     = 0;
-static float   *buffer       = NULL;
-static int16_t *buffer_int16 = NULL;
-static int      midi_pos     = 0;
+static midi_render_t *render = NULL;
 
 static mt32emu_report_handler_version
 get_mt32_report_handler_version(UNUSED(mt32emu_report_handler_i i))
@@ -201,63 +186,45 @@ mt32_stream_int16(int16_t *stream, int len)
 void
 mt32_poll(void)
 {
-    midi_pos++;
-    if (midi_pos == SOUND_FREQ / RENDER_RATE) {
-        midi_pos = 0;
-        thread_set_event(event);
-    }
+    midi_render_poll(render);
 }
 
+/* These run on the render thread, which is the only one talking to munt. */
 static void
-mt32_thread(UNUSED(void *param))
+mt32_render(UNUSED(void *priv), void *buf, uint32_t frames)
 {
-    int      buf_pos = 0;
-    int      bsize   = buf_size / BUFFER_SEGMENTS;
-    float   *buf;
-    int16_t *buf16;
-
-    thread_set_event(start_event);
-
-    while (mt32_on) {
-        thread_wait_event(event, -1);
-        thread_reset_event(event);
-
-        if (sound_is_float) {
-            buf = (float *) ((uint8_t *) buffer + buf_pos);
-            memset(buf, 0, bsize);
-            mt32_stream(buf, bsize / (2 * sizeof(float)));
-            buf_pos += bsize;
-            if (buf_pos >= buf_size) {
-                givealbuffer_midi(buffer, buf_size / sizeof(float));
-                buf_pos = 0;
-            }
-        } else {
-            buf16 = (int16_t *) ((uint8_t *) buffer_int16 + buf_pos);
-            memset(buf16, 0, bsize);
-            mt32_stream_int16(buf16, bsize / (2 * sizeof(int16_t)));
-            buf_pos += bsize;
-            if (buf_pos >= buf_size) {
-                givealbuffer_midi(buffer_int16, buf_size / sizeof(int16_t));
-                buf_pos = 0;
-            }
-        }
-    }
+    if (sound_is_float)
+        mt32_stream((float *) buf, frames);
+    else
+        mt32_stream_int16((int16_t *) buf, frames);
 }
 
-void
-mt32_msg(uint8_t *val)
+static void
+mt32_render_msg(UNUSED(void *priv), uint8_t *val)
 {
     if (context)
         mt32_check("mt32emu_play_msg", mt32emu_play_msg(context, *(uint32_t *) val), MT32EMU_RC_OK);
 }
 
-void
-mt32_sysex(uint8_t *data, unsigned int len)
+static void
+mt32_render_sysex(UNUSED(void *priv), uint8_t *data, unsigned int len)
 {
     if (context)
         mt32_check("mt32emu_play_sysex", mt32emu_play_sysex(context, data, len), MT32EMU_RC_OK);
 }
 
+void
+mt32_msg(uint8_t *val)
+{
+    midi_render_msg(render, val);
+}
+
+void
+mt32_sysex(uint8_t *data, unsigned int len)
+{
+    midi_render_sysex(render, data, len);
+}
+
 void *
 mt32emu_init(char *control_rom, char *pcm_rom)
 {
@@ -278,43 +245,22 @@ mt32emu_init(char *control_rom, char *pcm_rom)
     if (!mt32_check("mt32emu_open_synth", mt32emu_open_synth(context), MT32EMU_RC_OK))
         return 0;
 
-    samplerate = mt32emu_get_actual_stereo_output_samplerate(context);
-    /* buf_size = samplerate/RENDER_RATE*2; */
-    if (sound_is_float) {
-        buf_size     = (samplerate / RENDER_RATE) * 2 * BUFFER_SEGMENTS * sizeof(float);
-        buffer       = malloc(buf_size);
-        buffer_int16 = NULL;
-    } else {
-        buf_size     = (samplerate / RENDER_RATE) * 2 * BUFFER_SEGMENTS * sizeof(int16_t);
-        buffer       = NULL;
-        buffer_int16 = malloc(buf_size);
-    }
-
     mt32emu_set_output_gain(context, device_get_config_int("output_gain") / 100.0f);
     mt32emu_set_reverb_enabled(context, device_get_config_int("reverb"));
     mt32emu_set_reverb_output_gain(context, device_get_config_int("reverb_output_gain") / 100.0f);
     mt32emu_set_reversed_stereo_enabled(context, device_get_config_int("reversed_stereo"));
     mt32emu_set_nice_amp_ramp_enabled(context, device_get_config_int("nice_ramp"));
 
-    al_set_midi(samplerate, buf_size);
-
     dev = calloc(1, sizeof(midi_device_t));
 
     dev->play_msg   = mt32_msg;
     dev->play_sysex = mt32_sysex;
     dev->poll       = mt32_poll;
 
-    midi_out_init(dev);
-
-    mt32_on = 1;
-
-    start_event = thread_create_event();
-
-    event    = thread_create_event();
-    thread_h = thread_create(mt32_thread, 0);
+    render = midi_render_create("MT-32 render", mt32emu_get_actual_stereo_output_samplerate(context),
+                                mt32_render, mt32_render_msg, mt32_render_sysex, NULL);
 
-    thread_wait_event(start_event, -1);
-    thread_reset_event(start_event);
+    midi_out_init(dev);
 
     return dev;
 }
@@ -349,13 +295,8 @@ mt32_close(void *priv)
     if (!priv)
         return;
 
-    mt32_on = 0;
-    thread_set_event(event);
-    thread_wait(thread_h);
-
-    event       = NULL;
-    start_event = NULL;
-    thread_h    = NULL;
+    midi_render_close(render);
+    render = NULL;
 
     if (context) {
         mt32emu_close_synth(context);
@@ -364,14 +305,6 @@ mt32_close(void *priv)
     context = NULL;
 
     ui_sb_mt32lcd("");
-
-    if (buffer)
-        free(buffer);
-    buffer = NULL;
-
-    if (buffer_int16)
-        free(buffer_int16);
-    buffer_int16 = NULL;
 }
 
 static const device_config_t mt32_config[] = {
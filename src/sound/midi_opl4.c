@@ -694,7 +694,7 @@ opl4_init(UNUSED(const device_t *info))
         opl4_midi_cur->voice_data[voice].reg_lfo_vibrato = 0;
     }
     opl4_midi_cur->wait_event = thread_create_event();
-    opl4_midi_cur->thread     = thread_create(opl4_midi_thread, NULL);
+    opl4_midi_cur->thread     = thread_create_role(opl4_midi_thread, NULL, THREAD_ROLE_AUDIO);
     return dev;
 }
 
@@ -0,0 +1,293 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Render threads for the software synthesizers, fed with
+ *          timestamped MIDI events through a lock-free queue.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/sound.h>
+#include <86box/thread.h>
+#include <86box/midi_render.h>
+
+#define RENDER_RATE     100
+#define BUFFER_SEGMENTS 10
+
+#define MIDI_RENDER_QUEUE_MASK (MIDI_RENDER_QUEUE_SIZE - 1)
+
+extern void givealbuffer_midi(const void *buf, uint32_t size);
+extern void al_set_midi(int freq, int buf_size);
+
+typedef struct midi_render_event_t {
+    uint64_t     time;
+    uint32_t     msg;
+    unsigned int len;
+    uint8_t     *sysex;
+} midi_render_event_t;
+
+struct midi_render_t {
+    midi_render_event_t queue[MIDI_RENDER_QUEUE_SIZE];
+
+    /* The emulation thread owns write_idx and the clock, the render thread
+       owns read_idx. */
+    atomic_uint   write_idx;
+    atomic_uint   read_idx;
+    atomic_ullong clock;
+    atomic_int    run;
+
+    int poll_count;
+
+    /* Render thread only. */
+    uint32_t samplerate;
+    uint32_t seg_frames;
+    uint64_t rendered;
+    int      sample_size;
+    int      buf_size;
+    int      buf_pos;
+    uint8_t *buffer;
+
+    void (*render)(void *priv, void *buf, uint32_t frames);
+    void (*msg)(void *priv, uint8_t *msg);
+    void (*sysex)(void *priv, uint8_t *data, unsigned int len);
+    void *priv;
+
+    thread_t *thread;
+    event_t  *wake_event;
+    event_t  *not_full_event;
+};
+
+static void
+midi_render_dispatch(midi_render_t *render, midi_render_event_t *ev)
+{
+    if (ev->sysex != NULL) {
+        render->sysex(render->priv, ev->sysex, ev->len);
+        free(ev->sysex);
+        ev->sysex = NULL;
+    } else
+        render->msg(render->priv, (uint8_t *) &ev->msg);
+}
+
+/* Emulated time of an event, in frames at the synth's rate. */
+static inline uint64_t
+midi_render_frame(const midi_render_t *render, uint64_t time)
+{
+    return (time * render->samplerate) / SOUND_FREQ;
+}
+
+static void
+midi_render_segment(midi_render_t *render)
+{
+    midi_render_event_t *ev;
+    uint64_t             end = render->rendered + render->seg_frames;
+    uint64_t             next;
+    uint64_t             t;
+    uint32_t             read_idx;
+    uint32_t             frames;
+    uint8_t             *buf = render->buffer + render->buf_pos;
+
+    while (render->rendered < end) {
+        next     = end;
+        read_idx = atomic_load_explicit(&render->read_idx, memory_order_relaxed);
+
+        /* Play every event that is due, and render up to the next one. */
+        while (read_idx != atomic_load_explicit(&render->write_idx, memory_order_acquire)) {
+            ev = &render->queue[read_idx & MIDI_RENDER_QUEUE_MASK];
+            t  = midi_render_frame(render, ev->time);
+            if (t > render->rendered) {
+                if (t < next)
+                    next = t;
+                break;
+            }
+
+            midi_render_dispatch(render, ev);
+            atomic_store_explicit(&render->read_idx, ++read_idx, memory_order_release);
+        }
+
+        frames = (uint32_t) (next - render->rendered);
+        memset(buf, 0, frames * 2 * render->sample_size);
+        render->render(render->priv, buf, frames);
+
+        buf += frames * 2 * render->sample_size;
+        render->rendered = next;
+    }
+
+    render->buf_pos += render->seg_frames * 2 * render->sample_size;
+    if (render->buf_pos >= render->buf_size) {
+        givealbuffer_midi(render->buffer, render->buf_size / render->sample_size);
+        render->buf_pos = 0;
+    }
+}
+
+/* Play all queued events right away, regardless of their timestamps. */
+static void
+midi_render_drain(midi_render_t *render)
+{
+    uint32_t read_idx = atomic_load_explicit(&render->read_idx, memory_order_relaxed);
+
+    while (read_idx != atomic_load_explicit(&render->write_idx, memory_order_acquire)) {
+        midi_render_dispatch(render, &render->queue[read_idx & MIDI_RENDER_QUEUE_MASK]);
+        atomic_store_explicit(&render->read_idx, ++read_idx, memory_order_release);
+    }
+}
+
+static void
+midi_render_thread(void *param)
+{
+    midi_render_t *render = (midi_render_t *) param;
+    uint64_t       target;
+    uint32_t       pending;
+
+    while (atomic_load_explicit(&render->run, memory_order_acquire)) {
+        thread_wait_event(render->wake_event, -1);
+        thread_reset_event(render->wake_event);
+
+        /* Only render what the emulation has caught up with, so that every
+           event in a block is already queued when the block is rendered. */
+        target = midi_render_frame(render, atomic_load_explicit(&render->clock, memory_order_acquire));
+        while ((render->rendered + render->seg_frames) <= target)
+            midi_render_segment(render);
+
+        /* A burst that filled the queue within one block (a big SysEx dump
+           split into messages) would otherwise stall the emulation until the
+           block is due, play it early instead. */
+        pending = atomic_load_explicit(&render->write_idx, memory_order_acquire) - atomic_load_explicit(&render->read_idx, memory_order_relaxed);
+        if (pending >= MIDI_RENDER_QUEUE_SIZE)
+            midi_render_drain(render);
+
+        thread_set_event(render->not_full_event);
+    }
+
+    midi_render_drain(render);
+}
+
+static midi_render_event_t *
+midi_render_get_slot(midi_render_t *render)
+{
+    uint32_t write_idx = atomic_load_explicit(&render->write_idx, memory_order_relaxed);
+
+    while ((write_idx - atomic_load_explicit(&render->read_idx, memory_order_acquire)) >= MIDI_RENDER_QUEUE_SIZE) {
+        thread_reset_event(render->not_full_event);
+        thread_set_event(render->wake_event);
+        if ((write_idx - atomic_load_explicit(&render->read_idx, memory_order_acquire)) >= MIDI_RENDER_QUEUE_SIZE)
+            thread_wait_event(render->not_full_event, 1);
+    }
+
+    return &render->queue[write_idx & MIDI_RENDER_QUEUE_MASK];
+}
+
+static void
+midi_render_publish(midi_render_t *render)
+{
+    uint32_t write_idx = atomic_load_explicit(&render->write_idx, memory_order_relaxed);
+
+    atomic_store_explicit(&render->write_idx, write_idx + 1, memory_order_release);
+}
+
+void
+midi_render_msg(midi_render_t *render, uint8_t *msg)
+{
+    midi_render_event_t *ev = midi_render_get_slot(render);
+
+    ev->time  = atomic_load_explicit(&render->clock, memory_order_relaxed);
+    ev->msg   = *(uint32_t *) msg;
+    ev->len   = 0;
+    ev->sysex = NULL;
+
+    midi_render_publish(render);
+}
+
+void
+midi_render_sysex(midi_render_t *render, uint8_t *data, unsigned int len)
+{
+    midi_render_event_t *ev;
+    uint8_t             *copy;
+
+    if (len == 0)
+        return;
+
+    copy = (uint8_t *) malloc(len);
+    memcpy(copy, data, len);
+
+    ev        = midi_render_get_slot(render);
+    ev->time  = atomic_load_explicit(&render->clock, memory_order_relaxed);
+    ev->msg   = 0;
+    ev->len   = len;
+    ev->sysex = copy;
+
+    midi_render_publish(render);
+}
+
+/* Called at SOUND_FREQ by the MIDI poll. */
+void
+midi_render_poll(midi_render_t *render)
+{
+    atomic_store_explicit(&render->clock, atomic_load_explicit(&render->clock, memory_order_relaxed) + 1,
+                          memory_order_release);
+
+    if (++render->poll_count == (SOUND_FREQ / RENDER_RATE)) {
+        render->poll_count = 0;
+        thread_set_event(render->wake_event);
+    }
+}
+
+midi_render_t *
+midi_render_create(const char *name, uint32_t samplerate,
+                   void (*render_func)(void *priv, void *buf, uint32_t frames),
+                   void (*msg)(void *priv, uint8_t *msg),
+                   void (*sysex)(void *priv, uint8_t *data, unsigned int len),
+                   void *priv)
+{
+    midi_render_t *render = (midi_render_t *) calloc(1, sizeof(midi_render_t));
+
+    render->samplerate  = samplerate;
+    render->seg_frames  = samplerate / RENDER_RATE;
+    render->sample_size = sound_is_float ? sizeof(float) : sizeof(int16_t);
+    render->buf_size    = render->seg_frames * 2 * BUFFER_SEGMENTS * render->sample_size;
+    render->buffer      = (uint8_t *) malloc(render->buf_size);
+    render->render      = render_func;
+    render->msg         = msg;
+    render->sysex       = sysex;
+    render->priv        = priv;
+
+    atomic_init(&render->write_idx, 0);
+    atomic_init(&render->read_idx, 0);
+    atomic_init(&render->clock, 0);
+    atomic_init(&render->run, 1);
+
+    al_set_midi(samplerate, render->buf_size);
+
+    render->wake_event     = thread_create_event();
+    render->not_full_event = thread_create_event();
+    render->thread         = thread_create_named_role(midi_render_thread, render, name, THREAD_ROLE_AUDIO);
+
+    return render;
+}
+
+void
+midi_render_close(midi_render_t *render)
+{
+    if (render == NULL)
+        return;
+
+    atomic_store_explicit(&render->run, 0, memory_order_release);
+    thread_set_event(render->wake_event);
+    thread_wait(render->thread);
+
+    thread_destroy_event(render->wake_event);
+    thread_destroy_event(render->not_full_event);
+
+    free(render->buffer);
+    free(render);
+}
@@ -35,6 +35,14 @@
 #define FREQ   SOUND_FREQ
 #define BUFLEN SOUNDBUFLEN
 
+/* Low latency mode: the main output is queued as 5 ms slices of each
+   block, and at most LL_BUFFERS of them are ever queued. */
+#define LL_SLICES  4
+#define LL_SUBLEN  (BUFLEN / LL_SLICES)
+#define LL_BUFFERS 8
+#define LL_PREFILL 2
+#define LL_TARGET  5
+
 #define I_NORMAL 0
 #define I_MUSIC  1
 #define I_WT     2
@@ -50,6 +58,12 @@ ALuint        buffers_fdd[4];   /* front and back buffers */
 ALuint        buffers_midi[4];  /* front and back buffers */
 static ALuint source[6];        /* audio source - CHANGED FROM 5 TO 6 */
 
+static ALuint ll_buffers[LL_BUFFERS];
+static ALuint ll_free[LL_BUFFERS];
+static int    ll_free_num;
+static float  ll_pitch = 1.0f;
+static int    ll_active;
+
 static int         midi_freq     = 44100;
 static int         midi_buf_size = 4410;
 static int         initialized   = 0;
@@ -110,7 +124,10 @@ closeal(void)
     alDeleteBuffers(4, buffers_fdd);
     alDeleteBuffers(4, buffers_cd);
     alDeleteBuffers(4, buffers_music);
-    alDeleteBuffers(4, buffers);
+    if (ll_active)
+        alDeleteBuffers(LL_BUFFERS, ll_buffers);
+    else
+        alDeleteBuffers(4, buffers);
 
     alutExit();
 
@@ -146,7 +163,8 @@ inital(void)
         init_midi = 1; /* If the device is neither none, nor system MIDI, initialize the
                           MIDI buffer and source, otherwise, do not. */
 
-    sources = 5 + !!init_midi;
+    sources   = 5 + !!init_midi;
+    ll_active = sound_low_latency;
     if (sound_is_float) {
         buf       = (float *) calloc((BUFLEN << 1), sizeof(float));
         music_buf = (float *) calloc((MUSICBUFLEN << 1), sizeof(float));
@@ -165,7 +183,10 @@ inital(void)
             midi_buf_int16 = (int16_t *) calloc(midi_buf_size, sizeof(int16_t));
     }
 
-    alGenBuffers(4, buffers);
+    if (ll_active)
+        alGenBuffers(LL_BUFFERS, ll_buffers);
+    else
+        alGenBuffers(4, buffers);
     alGenBuffers(4, buffers_cd);
     alGenBuffers(4, buffers_fdd);
     alGenBuffers(4, buffers_music);
@@ -237,9 +258,25 @@ inital(void)
             memset(midi_buf_int16, 0, midi_buf_size * sizeof(int16_t));
     }
 
+    if (ll_active) {
+        /* Start with a short cushion of silence, the rest of the buffers
+           wait for audio. */
+        for (uint8_t c = 0; c < LL_PREFILL; c++) {
+            if (sound_is_float)
+                alBufferData(ll_buffers[c], AL_FORMAT_STEREO_FLOAT32, buf, LL_SUBLEN * 2 * sizeof(float), FREQ);
+            else
+                alBufferData(ll_buffers[c], AL_FORMAT_STEREO16, buf_int16, LL_SUBLEN * 2 * sizeof(int16_t), FREQ);
+        }
+        ll_free_num = 0;
+        for (uint8_t c = LL_PREFILL; c < LL_BUFFERS; c++)
+            ll_free[ll_free_num++] = ll_buffers[c];
+        ll_pitch = 1.0f;
+    }
+
     for (uint8_t c = 0; c < 4; c++) {
         if (sound_is_float) {
-            alBufferData(buffers[c], AL_FORMAT_STEREO_FLOAT32, buf, BUFLEN * 2 * sizeof(float), FREQ);
+            if (!ll_active)
+                alBufferData(buffers[c], AL_FORMAT_STEREO_FLOAT32, buf, BUFLEN * 2 * sizeof(float), FREQ);
             alBufferData(buffers_music[c], AL_FORMAT_STEREO_FLOAT32, music_buf, MUSICBUFLEN * 2 * sizeof(float), MUSIC_FREQ);
             alBufferData(buffers_wt[c], AL_FORMAT_STEREO_FLOAT32, wt_buf, WTBUFLEN * 2 * sizeof(float), WT_FREQ);
             alBufferData(buffers_cd[c], AL_FORMAT_STEREO_FLOAT32, cd_buf, CD_BUFLEN * 2 * sizeof(float), CD_FREQ);
@@ -247,7 +284,8 @@ inital(void)
             if (init_midi)
                 alBufferData(buffers_midi[c], AL_FORMAT_STEREO_FLOAT32, midi_buf, midi_buf_size * (int) sizeof(float), midi_freq);
         } else {
-            alBufferData(buffers[c], AL_FORMAT_STEREO16, buf_int16, BUFLEN * 2 * sizeof(int16_t), FREQ);
+            if (!ll_active)
+                alBufferData(buffers[c], AL_FORMAT_STEREO16, buf_int16, BUFLEN * 2 * sizeof(int16_t), FREQ);
             alBufferData(buffers_music[c], AL_FORMAT_STEREO16, music_buf_int16, MUSICBUFLEN * 2 * sizeof(int16_t), MUSIC_FREQ);
             alBufferData(buffers_wt[c], AL_FORMAT_STEREO16, wt_buf_int16, WTBUFLEN * 2 * sizeof(int16_t), WT_FREQ);
             alBufferData(buffers_cd[c], AL_FORMAT_STEREO16, cd_buf_int16, CD_BUFLEN * 2 * sizeof(int16_t), CD_FREQ);
@@ -257,7 +295,10 @@ inital(void)
         }
     }
 
-    alSourceQueueBuffers(source[I_NORMAL], 4, buffers);
+    if (ll_active)
+        alSourceQueueBuffers(source[I_NORMAL], LL_PREFILL, ll_buffers);
+    else
+        alSourceQueueBuffers(source[I_NORMAL], 4, buffers);
     alSourceQueueBuffers(source[I_MUSIC], 4, buffers_music);
     alSourceQueueBuffers(source[I_WT], 4, buffers_wt);
     alSourceQueueBuffers(source[I_CD], 4, buffers_cd);
@@ -306,6 +347,7 @@ givealbuffer_common(const void *buf, const uint8_t src, const int size, const in
     alGetSourcei(source[src], AL_SOURCE_STATE, &state);
 
     if (state == 0x1014) {
+        sound_underruns++;
         alSourcePlay(source[src]);
     }
 
@@ -325,10 +367,67 @@ givealbuffer_common(const void *buf, const uint8_t src, const int size, const in
     }
 }
 
+static void
+givealbuffer_low_latency(const void *buf)
+{
+    const size_t sample_size = sound_is_float ? sizeof(float) : sizeof(int16_t);
+    ALuint       done[LL_BUFFERS];
+    int          processed;
+    int          queued;
+    int          state;
+    float        pitch;
+    double       gain;
+
+    if (!initialized)
+        return;
+
+    alGetSourcei(source[I_NORMAL], AL_BUFFERS_PROCESSED, &processed);
+    if (processed > 0) {
+        alSourceUnqueueBuffers(source[I_NORMAL], processed, done);
+        for (int i = 0; i < processed; i++)
+            ll_free[ll_free_num++] = done[i];
+    }
+
+    gain = sound_muted ? 0.0 : pow(10.0, (double) sound_gain / 20.0);
+    alListenerf(AL_GAIN, (float) gain);
+
+    /* Queue the block as slices while there are free buffers, anything past
+       that means the emulation is running ahead and is dropped. */
+    for (int i = 0; (i < LL_SLICES) && ll_free_num; i++) {
+        ALuint      buffer = ll_free[--ll_free_num];
+        const void *slice  = (const uint8_t *) buf + (i * LL_SUBLEN * 2 * sample_size);
+
+        alBufferData(buffer, sound_is_float ? AL_FORMAT_STEREO_FLOAT32 : AL_FORMAT_STEREO16,
+                     slice, LL_SUBLEN * 2 * (int) sample_size, FREQ);
+        alSourceQueueBuffers(source[I_NORMAL], 1, &buffer);
+    }
+
+    /* Nudge the playback rate by up to 1% to keep the queue around its
+       target, absorbing emulation speed jitter without audible gaps. */
+    alGetSourcei(source[I_NORMAL], AL_BUFFERS_QUEUED, &queued);
+    pitch = 1.0f + ((float) (queued - LL_TARGET) * 0.0025f);
+    if (pitch < 0.99f)
+        pitch = 0.99f;
+    else if (pitch > 1.01f)
+        pitch = 1.01f;
+    ll_pitch += (pitch - ll_pitch) * 0.25f;
+    alSourcef(source[I_NORMAL], AL_PITCH, ll_pitch);
+
+    alGetSourcei(source[I_NORMAL], AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING) {
+        if (state == AL_STOPPED)
+            sound_underruns++;
+        alSourcePlay(source[I_NORMAL]);
+    }
+}
+
 void
 givealbuffer(const void *buf)
 {
-    givealbuffer_common(buf, 0, BUFLEN << 1, FREQ);
+    if (ll_active)
+        givealbuffer_low_latency(buf);
+    else
+        givealbuffer_common(buf, 0, BUFLEN << 1, FREQ);
 }
 
 void
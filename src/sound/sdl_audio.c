@@ -0,0 +1,253 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Pull-model sound output through SDL2, which drives WASAPI,
+ *          CoreAudio, PipeWire and the other native APIs from their own
+ *          device callbacks.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+
+#include <86box/86box.h>
+#include <86box/sound.h>
+#include <86box/plat_unused.h>
+
+#define I_NORMAL 0
+#define I_MUSIC  1
+#define I_WT     2
+#define I_CD     3
+#define I_FDD    4
+#define I_MIDI   5
+#define I_NUM    6
+
+/* Per-output ring, must be a power of 2 and hold a few of the largest
+   (CD) blocks. */
+#define RING_SIZE (1 << 18)
+#define RING_MASK (RING_SIZE - 1)
+
+/* Device period in sample frames, about 5 ms at these rates. */
+#define DEVICE_SAMPLES 256
+
+/*
+ * Each output has a single-producer/single-consumer ring: the sound poll
+ * (or the CD, floppy and MIDI threads) writes whole blocks, and the
+ * device callback pulls exactly as much as the device asks for.
+ */
+typedef struct sdl_audio_out_t {
+    SDL_AudioDeviceID dev;
+    uint8_t          *ring;
+    atomic_uint       write_pos;
+    atomic_uint       read_pos;
+    int               freq;
+    int               sample_size;
+} sdl_audio_out_t;
+
+static sdl_audio_out_t outs[I_NUM];
+static int             midi_freq   = 44100;
+static int             initialized = 0;
+static atomic_int      out_gain    = 0;
+
+static void
+sdl_audio_callback(void *userdata, Uint8 *stream, int len)
+{
+    sdl_audio_out_t *out   = (sdl_audio_out_t *) userdata;
+    uint32_t         rp    = atomic_load_explicit(&out->read_pos, memory_order_relaxed);
+    uint32_t         avail = atomic_load_explicit(&out->write_pos, memory_order_acquire) - rp;
+    uint32_t         n     = ((uint32_t) len < avail) ? (uint32_t) len : avail;
+    uint32_t         first = RING_SIZE - (rp & RING_MASK);
+    float            gain  = (float) atomic_load_explicit(&out_gain, memory_order_relaxed) / 65536.0f;
+
+    if (first > n)
+        first = n;
+    memcpy(stream, &out->ring[rp & RING_MASK], first);
+    memcpy(stream + first, out->ring, n - first);
+
+    /* Running dry plays silence instead of stalling the device. */
+    if (n < (uint32_t) len)
+        memset(stream + n, 0, len - n);
+
+    atomic_store_explicit(&out->read_pos, rp + n, memory_order_release);
+
+    if (gain == 1.0f)
+        return;
+
+    if (out->sample_size == sizeof(float)) {
+        float *s = (float *) stream;
+        for (int i = 0; i < (int) (n / sizeof(float)); i++)
+            s[i] *= gain;
+    } else {
+        int16_t *s = (int16_t *) stream;
+        for (int i = 0; i < (int) (n / sizeof(int16_t)); i++)
+            s[i] = (int16_t) (s[i] * gain);
+    }
+}
+
+static void
+sdl_audio_open(sdl_audio_out_t *out, int freq)
+{
+    SDL_AudioSpec want;
+    SDL_AudioSpec have;
+
+    memset(&want, 0, sizeof(want));
+    want.freq     = freq;
+    want.format   = sound_is_float ? AUDIO_F32SYS : AUDIO_S16SYS;
+    want.channels = 2;
+    want.samples  = DEVICE_SAMPLES;
+    want.callback = sdl_audio_callback;
+    want.userdata = out;
+
+    out->freq        = freq;
+    out->sample_size = sound_is_float ? sizeof(float) : sizeof(int16_t);
+    out->ring        = (uint8_t *) calloc(1, RING_SIZE);
+    atomic_init(&out->write_pos, 0);
+    atomic_init(&out->read_pos, 0);
+
+    /* No allowed changes: if the device runs at another rate or format,
+       SDL converts once, in the callback thread. */
+    out->dev = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+    if (out->dev == 0) {
+        pclog("SDL audio: unable to open a %i Hz output (%s)\n", freq, SDL_GetError());
+        return;
+    }
+
+    SDL_PauseAudioDevice(out->dev, 0);
+}
+
+void
+al_set_midi(const int freq, UNUSED(const int buf_size))
+{
+    midi_freq = freq;
+
+    /* The MIDI synths pick their rate after the outputs are up. */
+    if (initialized && (outs[I_MIDI].freq != freq)) {
+        if (outs[I_MIDI].dev != 0)
+            SDL_CloseAudioDevice(outs[I_MIDI].dev);
+        free(outs[I_MIDI].ring);
+        sdl_audio_open(&outs[I_MIDI], freq);
+    }
+}
+
+void
+closeal(void)
+{
+    if (!initialized)
+        return;
+
+    for (int i = 0; i < I_NUM; i++) {
+        if (outs[i].dev != 0)
+            SDL_CloseAudioDevice(outs[i].dev);
+        outs[i].dev = 0;
+
+        free(outs[i].ring);
+        outs[i].ring = NULL;
+    }
+
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    initialized = 0;
+}
+
+void
+inital(void)
+{
+    if (initialized)
+        return;
+
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        pclog("SDL audio: initialization failed (%s)\n", SDL_GetError());
+        return;
+    }
+    atexit(closeal);
+
+    sdl_audio_open(&outs[I_NORMAL], SOUND_FREQ);
+    sdl_audio_open(&outs[I_MUSIC], MUSIC_FREQ);
+    sdl_audio_open(&outs[I_WT], WT_FREQ);
+    sdl_audio_open(&outs[I_CD], CD_FREQ);
+    sdl_audio_open(&outs[I_FDD], SOUND_FREQ);
+    sdl_audio_open(&outs[I_MIDI], midi_freq);
+
+    initialized = 1;
+}
+
+static void
+givealbuffer_common(const void *buf, const uint8_t src, const int size)
+{
+    sdl_audio_out_t *out = &outs[src];
+    uint32_t         bytes;
+    uint32_t         wp;
+    uint32_t         first;
+    uint32_t         used;
+    double           gain;
+
+    if (!initialized || (out->dev == 0))
+        return;
+
+    gain = sound_muted ? 0.0 : pow(10.0, (double) sound_gain / 20.0);
+    atomic_store_explicit(&out_gain, (int) (gain * 65536.0), memory_order_relaxed);
+
+    bytes = (uint32_t) size * out->sample_size;
+    wp    = atomic_load_explicit(&out->write_pos, memory_order_relaxed);
+
+    used  = wp - atomic_load_explicit(&out->read_pos, memory_order_acquire);
+
+    /* More than a couple of blocks waiting means the emulation is running
+       ahead of the device, drop the block rather than let the latency grow. */
+    if (((used + bytes) > RING_SIZE) || (used > (bytes * 2)))
+        return;
+
+    first = RING_SIZE - (wp & RING_MASK);
+    if (first > bytes)
+        first = bytes;
+    memcpy(&out->ring[wp & RING_MASK], buf, first);
+    memcpy(out->ring, (const uint8_t *) buf + first, bytes - first);
+
+    atomic_store_explicit(&out->write_pos, wp + bytes, memory_order_release);
+}
+
+void
+givealbuffer(const void *buf)
+{
+    givealbuffer_common(buf, I_NORMAL, SOUNDBUFLEN << 1);
+}
+
+void
+givealbuffer_music(const void *buf)
+{
+    givealbuffer_common(buf, I_MUSIC, MUSICBUFLEN << 1);
+}
+
+void
+givealbuffer_wt(const void *buf)
+{
+    givealbuffer_common(buf, I_WT, WTBUFLEN << 1);
+}
+
+void
+givealbuffer_cd(const void *buf)
+{
+    givealbuffer_common(buf, I_CD, CD_BUFLEN << 1);
+}
+
+void
+givealbuffer_midi(const void *buf, const uint32_t size)
+{
+    givealbuffer_common(buf, I_MIDI, (int) size);
+}
+
+void
+givealbuffer_fdd(const void *buf, const uint32_t size)
+{
+    givealbuffer_common(buf, I_FDD, (int) size);
+}
@@ -135,6 +135,9 @@ cmi8x38_log(const char *fmt, ...)
 #    define cmi8x38_log(fmt, ...)
 #endif
 
+/* Frames (dwords) moved by one run of the DMA timer at most. */
+#define CMI8X38_DMA_BURST 16
+
 static const double   freqs[]             = { 5512.0, 11025.0, 22050.0, 44100.0, 8000.0, 16000.0, 32000.0, 48000.0 };
 static const uint16_t opl_ports_cmi8738[] = { 0x388, 0x3c8, 0x3e0, 0x3e8 };
 
@@ -1061,69 +1064,91 @@ cmi8x38_dma_process(void *priv)
         return;
     }
 
-    /* Schedule next run. */
-    timer_on_auto(&dma->dma_timer, dma->dma_latch);
-
-    /* Process DMA if it's active, and the FIFO has room or is disabled. */
-    uint8_t dma_status = dev->io_regs[0x00] >> dma->id;
-    if (!(dma_status & 0x04) && (dma->always_run || ((dma->fifo_end - dma->fifo_pos) <= (sizeof(dma->fifo) - 4)))) {
-        /* Start DMA if requested. */
-        if (dma->restart) {
-            /* Set up base address and counters.
-               Nothing reads sample_count_out; it's implemented as an assumption. */
-            dma->restart         = 0;
-            dma->sample_ptr      = AS_U32(dev->io_regs[dma->reg]);
-            dma->frame_count_dma = dma->sample_count_out = AS_U16(dev->io_regs[dma->reg | 0x4]) + 1;
-            dma->frame_count_fragment                    = AS_U16(dev->io_regs[dma->reg | 0x6]) + 1;
-
-            cmi8x38_log("CMI8x38: Starting DMA %d at %08X (count %04X fragment %04X)\n", dma->id, dma->sample_ptr, dma->frame_count_dma, dma->frame_count_fragment);
-        }
+    /* Process DMA if it's active, and the FIFO has room or is disabled. Up to
+       a burst of frames is moved at once, ending at the fragment or buffer end
+       so that those are never crossed within a burst. */
+    uint8_t  dma_status = dev->io_regs[0x00] >> dma->id;
+    uint32_t frames     = 1;
+    uint32_t room;
+    uint8_t  data[CMI8X38_DMA_BURST << 2];
+
+    if (!dma->restart) {
+        frames = MIN(CMI8X38_DMA_BURST, MAX(dma->frame_count_fragment, 1));
+        frames = MIN(frames, MAX(dma->frame_count_dma, 1));
+    }
+    room = dma->always_run ? frames : ((sizeof(dma->fifo) - (dma->fifo_end - dma->fifo_pos)) >> 2);
 
-        if (dma_status & 0x01) {
-            /* Write channel: read data from FIFO. */
-            mem_writel_phys(dma->sample_ptr, AS_U32(dma->fifo[dma->fifo_end & (sizeof(dma->fifo) - 1)]));
-        } else {
-            /* Read channel: write data to FIFO. */
-            AS_U32(dma->fifo[dma->fifo_end & (sizeof(dma->fifo) - 1)]) = mem_readl_phys(dma->sample_ptr);
-        }
-        dma->fifo_end += 4;
-        dma->sample_ptr += 4;
+    if ((dma_status & 0x04) || (room < frames)) {
+        /* Check again once the FIFO could have drained enough for the burst. */
+        timer_on_auto(&dma->dma_timer, dma->dma_latch * ((dma_status & 0x04) ? 1 : (frames - room)));
+        return;
+    }
 
-        /* Check if the fragment size was reached. */
-        if (--dma->frame_count_fragment <= 0) {
-            /* Reset fragment counter. */
-            dma->frame_count_fragment = AS_U16(dev->io_regs[dma->reg | 0x6]) + 1;
+    /* Schedule next run. */
+    timer_on_auto(&dma->dma_timer, dma->dma_latch * frames);
+
+    /* Start DMA if requested. */
+    if (dma->restart) {
+        /* Set up base address and counters.
+           Nothing reads sample_count_out; it's implemented as an assumption. */
+        dma->restart         = 0;
+        dma->sample_ptr      = AS_U32(dev->io_regs[dma->reg]);
+        dma->frame_count_dma = dma->sample_count_out = AS_U16(dev->io_regs[dma->reg | 0x4]) + 1;
+        dma->frame_count_fragment                    = AS_U16(dev->io_regs[dma->reg | 0x6]) + 1;
+
+        cmi8x38_log("CMI8x38: Starting DMA %d at %08X (count %04X fragment %04X)\n", dma->id, dma->sample_ptr, dma->frame_count_dma, dma->frame_count_fragment);
+    }
+
+    if (dma_status & 0x01) {
+        /* Write channel: read data from FIFO. */
+        for (uint32_t i = 0; i < frames; i++)
+            AS_U32(data[i << 2]) = AS_U32(dma->fifo[(dma->fifo_end + (i << 2)) & (sizeof(dma->fifo) - 1)]);
+        dma_bm_write(dma->sample_ptr, data, frames << 2, 4);
+    } else {
+        /* Read channel: write data to FIFO. */
+        dma_bm_read(dma->sample_ptr, data, frames << 2, 4);
+        for (uint32_t i = 0; i < frames; i++)
+            AS_U32(dma->fifo[(dma->fifo_end + (i << 2)) & (sizeof(dma->fifo) - 1)]) = AS_U32(data[i << 2]);
+    }
+    dma->fifo_end += frames << 2;
+    dma->sample_ptr += frames << 2;
+
+    /* Check if the fragment size was reached. */
+    dma->frame_count_fragment -= frames;
+    if (dma->frame_count_fragment <= 0) {
+        /* Reset fragment counter. */
+        dma->frame_count_fragment = AS_U16(dev->io_regs[dma->reg | 0x6]) + 1;
 #ifdef ENABLE_CMI8X38_LOG
-            if (dma->frame_count_fragment > 1) /* avoid log spam if fragment counting is unused, like on the newer WDM drivers (cmudax3) */
-                cmi8x38_log("CMI8x38: DMA %d fragment size reached at %04X frames left", dma->id, dma->frame_count_dma - 1);
+        if (dma->frame_count_fragment > 1) /* avoid log spam if fragment counting is unused, like on the newer WDM drivers (cmudax3) */
+            cmi8x38_log("CMI8x38: DMA %d fragment size reached at %04X frames left", dma->id, dma->frame_count_dma - frames);
 #endif
-            /* Fire interrupt if requested. */
-            if (dev->io_regs[0x0e] & dma_bit) {
+        /* Fire interrupt if requested. */
+        if (dev->io_regs[0x0e] & dma_bit) {
 #ifdef ENABLE_CMI8X38_LOG
-                if (dma->frame_count_fragment > 1)
-                    cmi8x38_log(", firing interrupt\n");
+            if (dma->frame_count_fragment > 1)
+                cmi8x38_log(", firing interrupt\n");
 #endif
-                /* Set channel interrupt flag. */
-                dev->io_regs[0x10] |= dma_bit;
+            /* Set channel interrupt flag. */
+            dev->io_regs[0x10] |= dma_bit;
 
-                /* Fire interrupt. */
-                cmi8x38_update_irqs(dev);
-            } else {
+            /* Fire interrupt. */
+            cmi8x38_update_irqs(dev);
+        } else {
 #ifdef ENABLE_CMI8X38_LOG
-                if (dma->frame_count_fragment > 1)
-                    cmi8x38_log("\n");
+            if (dma->frame_count_fragment > 1)
+                cmi8x38_log("\n");
 #endif
-            }
         }
+    }
 
-        /* Check if the buffer's end was reached. */
-        if (--dma->frame_count_dma <= 0) {
-            dma->frame_count_dma = 0;
-            cmi8x38_log("CMI8x38: DMA %d end reached, restarting\n", dma->id);
+    /* Check if the buffer's end was reached. */
+    dma->frame_count_dma -= frames;
+    if (dma->frame_count_dma <= 0) {
+        dma->frame_count_dma = 0;
+        cmi8x38_log("CMI8x38: DMA %d end reached, restarting\n", dma->id);
 
-            /* Restart DMA on the next run. */
-            dma->restart = 1;
-        }
+        /* Restart DMA on the next run. */
+        dma->restart = 1;
     }
 }
 
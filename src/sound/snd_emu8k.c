@@ -1750,6 +1750,39 @@ emu8k_vol_slide(emu8k_slide_t *slide, int32_t target)
     return slide->last;
 }
 
+/*
+ * A voice that is silent, has its envelope engine off and whose volume
+ * slide has settled at zero produces no output and sends nothing to the
+ * effects, all it does per sample is move its address.
+ */
+static inline int
+emu8k_voice_idle(const emu8k_voice_t *emu_voice)
+{
+    return !emu_voice->cvcf_curr_volume && !emu_voice->env_engine_on && !emu_voice->vtft_vol_target && !emu_voice->volumeslide.last;
+}
+
+/* Advance an idle voice by count samples, exactly like the full loop would. */
+static void
+emu8k_voice_skip(emu8k_voice_t *emu_voice, int count)
+{
+    for (int pos = 0; pos < count; pos++) {
+        /* Stopped (PITCH at zero) and inside its loop, nothing will move. */
+        if (!emu_voice->cpf_curr_pitch && !emu_voice->ptrx_pit_target && (emu_voice->addr.addr < emu_voice->loop_end.addr))
+            break;
+
+        emu_voice->addr.addr += ((uint64_t) emu_voice->cpf_curr_pitch) << 18;
+        if (emu_voice->addr.addr >= emu_voice->loop_end.addr) {
+            emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
+            emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
+        }
+
+        emu_voice->cpf_curr_pitch = emu_voice->ptrx_pit_target;
+    }
+
+    if (count > 0)
+        emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+}
+
 #if 0
 int32_t old_pitch[32] = { 0 };
 int32_t old_cut[32]   = { 0 };
@@ -1776,7 +1809,14 @@ emu8k_update(emu8k_t *emu8k)
         emu_voice = &emu8k->voice[c];
         buf       = &emu8k->buffer[emu8k->pos * 2];
 
-        for (pos = emu8k->pos; pos < wavetable_pos_global; pos++) {
+        /* Most of the 32 voices are idle most of the time. */
+        if (emu8k_voice_idle(emu_voice)) {
+            emu8k_voice_skip(emu_voice, wavetable_pos_global - emu8k->pos);
+            pos = wavetable_pos_global;
+        } else
+            pos = emu8k->pos;
+
+        for (; pos < wavetable_pos_global; pos++) {
             int32_t dat;
 
             if (emu_voice->cvcf_curr_volume) {
@@ -2144,60 +2184,13 @@ emu8k_change_addr(emu8k_t *emu8k, uint16_t emu_addr)
     }
 }
 
-/* onboard_ram in kilobytes */
-void
-emu8k_init(emu8k_t *emu8k, uint16_t emu_addr, int onboard_ram)
-{
-    uint32_t const BLOCK_SIZE_WORDS = 0x10000;
-    FILE          *fp;
-    int            c;
-    double         out;
-
-    fp = rom_fopen(EMU8K_ROM_PATH, "rb");
-    if (!fp)
-        fatal("AWE32.RAW not found\n");
-
-    emu8k->rom = malloc(1024 * 1024);
-    if (fread(emu8k->rom, 1, 1048576, fp) != 1048576)
-        fatal("emu8k_init(): Error reading data\n");
-    fclose(fp);
-    /*AWE-DUMP creates ROM images offset by 2 bytes, so if we detect this
-      then correct it*/
-    if (emu8k->rom[3] == 0x314d && emu8k->rom[4] == 0x474d) {
-        memmove(&emu8k->rom[0], &emu8k->rom[1], (1024 * 1024) - 2);
-        emu8k->rom[0x7ffff] = 0;
-    }
+static int emu8k_tables_made = 0;
 
-    emu8k->empty = calloc(2, BLOCK_SIZE_WORDS);
-
-    int j = 0;
-    for (; j < 0x8; j++) {
-        emu8k->ram_pointers[j] = emu8k->rom + (j * BLOCK_SIZE_WORDS);
-    }
-    for (; j < 0x20; j++) {
-        emu8k->ram_pointers[j] = emu8k->empty;
-    }
-
-    if (onboard_ram) {
-        /*Clip to 28MB, since that's the max that we can address. */
-        if (onboard_ram > 0x7000)
-            onboard_ram = 0x7000;
-        emu8k->ram = calloc(1024, onboard_ram);
-        const int i_end = onboard_ram >> 7;
-        int       i     = 0;
-        for (; i < i_end; i++, j++) {
-            emu8k->ram_pointers[j] = emu8k->ram + (i * BLOCK_SIZE_WORDS);
-        }
-        emu8k->ram_end_addr = EMU8K_RAM_MEM_START + (onboard_ram << 9);
-    } else {
-        emu8k->ram          = 0;
-        emu8k->ram_end_addr = EMU8K_RAM_MEM_START;
-    }
-    for (; j < 0x100; j++) {
-        emu8k->ram_pointers[j] = emu8k->empty;
-    }
-
-    emu8k_change_addr(emu8k, emu_addr);
+static void
+emu8k_init_tables(void)
+{
+    int    c;
+    double out;
 
     /*Create frequency table. (Convert initial pitch register value to a linear speed change)
      * The input is encoded such as 0xe000 is center note (no pitch shift)
@@ -2332,6 +2325,79 @@ emu8k_init(emu8k_t *emu8k, uint16_t emu_addr, int onboard_ram)
             // out = 100.0 + (c+1.0)*31.25; //31.25Hz steps */
         }
     }
+
+    /* Cubic Resampling  ( 4point cubic spline) */
+    double const resdouble = 1.0 / (double) CUBIC_RESOLUTION;
+    for (c = 0; c < CUBIC_RESOLUTION; c++) {
+        double x = (double) c * resdouble;
+        /* Cubic resolution is made of four table, but I've put them all in one table to optimize memory access. */
+        cubic_table[c * 4]     = (-0.5 * x * x * x + x * x - 0.5 * x);
+        cubic_table[c * 4 + 1] = (1.5 * x * x * x - 2.5 * x * x + 1.0);
+        cubic_table[c * 4 + 2] = (-1.5 * x * x * x + 2.0 * x * x + 0.5 * x);
+        cubic_table[c * 4 + 3] = (0.5 * x * x * x - 0.5 * x * x);
+    }
+}
+
+/* onboard_ram in kilobytes */
+void
+emu8k_init(emu8k_t *emu8k, uint16_t emu_addr, int onboard_ram)
+{
+    uint32_t const BLOCK_SIZE_WORDS = 0x10000;
+    FILE          *fp;
+    int            c;
+
+    fp = rom_fopen(EMU8K_ROM_PATH, "rb");
+    if (!fp)
+        fatal("AWE32.RAW not found\n");
+
+    emu8k->rom = malloc(1024 * 1024);
+    if (fread(emu8k->rom, 1, 1048576, fp) != 1048576)
+        fatal("emu8k_init(): Error reading data\n");
+    fclose(fp);
+    /*AWE-DUMP creates ROM images offset by 2 bytes, so if we detect this
+      then correct it*/
+    if (emu8k->rom[3] == 0x314d && emu8k->rom[4] == 0x474d) {
+        memmove(&emu8k->rom[0], &emu8k->rom[1], (1024 * 1024) - 2);
+        emu8k->rom[0x7ffff] = 0;
+    }
+
+    emu8k->empty = calloc(2, BLOCK_SIZE_WORDS);
+
+    int j = 0;
+    for (; j < 0x8; j++) {
+        emu8k->ram_pointers[j] = emu8k->rom + (j * BLOCK_SIZE_WORDS);
+    }
+    for (; j < 0x20; j++) {
+        emu8k->ram_pointers[j] = emu8k->empty;
+    }
+
+    if (onboard_ram) {
+        /*Clip to 28MB, since that's the max that we can address. */
+        if (onboard_ram > 0x7000)
+            onboard_ram = 0x7000;
+        emu8k->ram = calloc(1024, onboard_ram);
+        const int i_end = onboard_ram >> 7;
+        int       i     = 0;
+        for (; i < i_end; i++, j++) {
+            emu8k->ram_pointers[j] = emu8k->ram + (i * BLOCK_SIZE_WORDS);
+        }
+        emu8k->ram_end_addr = EMU8K_RAM_MEM_START + (onboard_ram << 9);
+    } else {
+        emu8k->ram          = 0;
+        emu8k->ram_end_addr = EMU8K_RAM_MEM_START;
+    }
+    for (; j < 0x100; j++) {
+        emu8k->ram_pointers[j] = emu8k->empty;
+    }
+
+    emu8k_change_addr(emu8k, emu_addr);
+
+    /* The lookup tables are the same for all cards, build them once. */
+    if (!emu8k_tables_made) {
+        emu8k_init_tables();
+        emu8k_tables_made = 1;
+    }
+
     /* NOTE! read_pos and buffer content is implicitly initialized to zero by the sb_t structure memset on sb_awe32_init() */
     emu8k->reverb_engine.reflections[0].bufsize = 2 * REV_BUFSIZE_STEP;
     emu8k->reverb_engine.reflections[1].bufsize = 4 * REV_BUFSIZE_STEP;
@@ -2348,16 +2414,6 @@ emu8k_init(emu8k_t *emu8k, uint16_t emu_addr, int onboard_ram)
         emu8k->reverb_engine.allpass[7 - c].bufsize  = (4 * c) * REV_BUFSIZE_STEP + 55;
     }
 
-    /* Cubic Resampling  ( 4point cubic spline) */
-    double const resdouble = 1.0 / (double) CUBIC_RESOLUTION;
-    for (c = 0; c < CUBIC_RESOLUTION; c++) {
-        double x = (double) c * resdouble;
-        /* Cubic resolution is made of four table, but I've put them all in one table to optimize memory access. */
-        cubic_table[c * 4]     = (-0.5 * x * x * x + x * x - 0.5 * x);
-        cubic_table[c * 4 + 1] = (1.5 * x * x * x - 2.5 * x * x + 1.0);
-        cubic_table[c * 4 + 2] = (-1.5 * x * x * x + 2.0 * x * x + 0.5 * x);
-        cubic_table[c * 4 + 3] = (0.5 * x * x * x - 0.5 * x * x);
-    }
     /* Even when the documentation says that this has to be written by applications to initialize the card,
      * several applications and drivers ( aweman on windows, linux oss driver..) read it to detect an AWE card. */
     emu8k->hwcf1 = 0x59;
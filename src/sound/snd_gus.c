@@ -60,6 +60,11 @@ enum {
     GUS_ICS2101_MAX     = 6
 };
 
+/* Wave engine samples mixed at a time, and at most run or looked ahead at once. */
+#define GUS_WAVE_BLOCK 256
+#define GUS_WAVE_MAX   65536
+#define GUS_WAVE_AHEAD 16384
+
 typedef struct ics2101_chan_t {
     uint8_t ctrl[2];
     double level[2];
@@ -117,6 +122,7 @@ typedef struct gus_t {
 
     pc_timer_t samp_timer;
     uint64_t   samp_latch;
+    uint64_t   samp_ts; /* time of the next wave engine sample */
 
     uint8_t *ram;
     uint32_t gus_end_ram;
@@ -198,6 +204,9 @@ double ics2101_pan[] = { 0.35481, 0.35481, 0.35481, 0.37584, 0.47315, 0.53088, 0
 void    gus_write(uint16_t addr, uint8_t val, void *priv);
 uint8_t gus_read(uint16_t addr, void *priv);
 
+static void gus_wave_update(gus_t *gus);
+static void gus_wave_schedule(gus_t *gus);
+
 void
 gus_update_int_status(gus_t *gus)
 {
@@ -303,6 +312,10 @@ gus_write(uint16_t addr, uint8_t val, void *priv)
     else
         port = addr & 0xf0f;
 
+    /* The voices run on the current registers and memory up to this point. */
+    if ((port == 0x304) || (port == 0x305) || (port == 0x307))
+        gus_wave_update(gus);
+
     switch (port) {
         case 0x300: /*MIDI control*/
             old            = gus->midi_ctrl;
@@ -799,6 +812,9 @@ gus_write(uint16_t addr, uint8_t val, void *priv)
         default:
             break;
     }
+
+    if ((port == 0x304) || (port == 0x305))
+        gus_wave_schedule(gus);
 }
 
 uint8_t
@@ -813,6 +829,9 @@ gus_read(uint16_t addr, void *priv)
     else
         port = addr & 0xf0f;
 
+    if ((port == 0x304) || (port == 0x305))
+        gus_wave_update(gus);
+
     switch (port) {
         case 0x300: /*MIDI status*/
             val = gus->midi_status;
@@ -876,6 +895,7 @@ gus_read(uint16_t addr, void *priv)
                     gus->rampirqs[gus->irqstatus2 & 0x1F] = 0;
                     gus->waveirqs[gus->irqstatus2 & 0x1F] = 0;
                     gus_update_int_status(gus);
+                    gus_wave_schedule(gus);
                     return val;
 
                 case 0x00:
@@ -930,6 +950,7 @@ gus_read(uint16_t addr, void *priv)
                     gus->rampirqs[gus->irqstatus2 & 0x1F] = 0;
                     gus->waveirqs[gus->irqstatus2 & 0x1F] = 0;
                     gus_update_int_status(gus);
+                    gus_wave_schedule(gus);
                     return val;
 
                 case 0x41: /*DMA control*/
@@ -1105,176 +1126,388 @@ gus_poll_timer_2(void *priv)
     gus_update_int_status(gus);
 }
 
+static __inline void
+gus_output(gus_t *gus, int32_t out_l, int32_t out_r)
+{
+    if (out_l < -32768)
+        gus->buffer[0][gus->pos] = -32768;
+    else if (out_l > 32767)
+        gus->buffer[0][gus->pos] = 32767;
+    else
+        gus->buffer[0][gus->pos] = out_l;
+    if (out_r < -32768)
+        gus->buffer[1][gus->pos] = -32768;
+    else if (out_r > 32767)
+        gus->buffer[1][gus->pos] = 32767;
+    else
+        gus->buffer[1][gus->pos] = out_r;
+}
+
 static void
 gus_update(gus_t *gus)
 {
-    for (; gus->pos < sound_pos_global; gus->pos++) {
-        if (gus->out_l < -32768)
-            gus->buffer[0][gus->pos] = -32768;
-        else if (gus->out_l > 32767)
-            gus->buffer[0][gus->pos] = 32767;
-        else
-            gus->buffer[0][gus->pos] = gus->out_l;
-        if (gus->out_r < -32768)
-            gus->buffer[1][gus->pos] = -32768;
-        else if (gus->out_r > 32767)
-            gus->buffer[1][gus->pos] = 32767;
-        else
-            gus->buffer[1][gus->pos] = gus->out_r;
-    }
+    for (; gus->pos < sound_pos_global; gus->pos++)
+        gus_output(gus, gus->out_l, gus->out_r);
 }
 
-void
-gus_poll_wave(void *priv)
+/* Voice sample at the given position, before the volume is applied. */
+static __inline int16_t
+gus_voice_fetch(const gus_t *gus, int d, uint32_t cur)
 {
-    gus_t   *gus = (gus_t *) priv;
     uint32_t addr;
-    int16_t  v;
     int32_t  vl;
-    int      update_irqs = 0;
 
-    gus_update(gus);
+    if (gus->ctrl[d] & 4) {
+        addr = cur >> 9;
+        addr = (addr & 0xC0000) | ((addr << 1) & 0x3FFFE);
+        if (!(gus->freq[d] >> 10)) {
+            /* Interpolate */
+            if (((addr + 1) & 0xfffff) < gus->gus_end_ram)
+                vl = (int16_t) (int8_t) ((gus->ram[(addr + 1) & 0xfffff] ^ 0x80) - 0x80) *
+                     (511 - (cur & 511));
+            else
+                vl = 0;
 
-    timer_advance_u64(&gus->samp_timer, gus->samp_latch);
+            if (((addr + 3) & 0xfffff) < gus->gus_end_ram)
+                vl += (int16_t) (int8_t) ((gus->ram[(addr + 3) & 0xfffff] ^ 0x80) - 0x80) *
+                      (cur & 511);
 
-    gus->out_l = gus->out_r = 0;
+            return vl >> 9;
+        } else if (((addr + 1) & 0xfffff) < gus->gus_end_ram)
+            return (int16_t) (int8_t) ((gus->ram[(addr + 1) & 0xfffff] ^ 0x80) - 0x80);
+    } else {
+        if (!(gus->freq[d] >> 10)) {
+            /* Interpolate */
+            if (((cur >> 9) & 0xfffff) < gus->gus_end_ram)
+                vl = ((int8_t) ((gus->ram[(cur >> 9) & 0xfffff] ^ 0x80) - 0x80)) *
+                               (511 - (cur & 511));
+            else
+                vl = 0;
 
-    if ((gus->reset & 3) != 3)
-        return;
-    for (uint8_t d = 0; d < 32; d++) {
-        if (!(gus->ctrl[d] & 3)) {
-            if (gus->ctrl[d] & 4) {
-                addr = gus->cur[d] >> 9;
-                addr = (addr & 0xC0000) | ((addr << 1) & 0x3FFFE);
-                if (!(gus->freq[d] >> 10)) {
-                    /* Interpolate */
-                    if (((addr + 1) & 0xfffff) < gus->gus_end_ram)
-                        vl = (int16_t) (int8_t) ((gus->ram[(addr + 1) & 0xfffff] ^ 0x80) - 0x80) *
-                             (511 - (gus->cur[d] & 511));
-                    else
-                        vl = 0;
-
-                    if (((addr + 3) & 0xfffff) < gus->gus_end_ram)
-                        vl += (int16_t) (int8_t) ((gus->ram[(addr + 3) & 0xfffff] ^ 0x80) - 0x80) *
-                              (gus->cur[d] & 511);
-
-                    v = vl >> 9;
-                } else if (((addr + 1) & 0xfffff) < gus->gus_end_ram)
-                    v = (int16_t) (int8_t) ((gus->ram[(addr + 1) & 0xfffff] ^ 0x80) - 0x80);
-                else
-                    v = 0x0000;
-            } else {
-                if (!(gus->freq[d] >> 10)) {
-                    /* Interpolate */
-                    if (((gus->cur[d] >> 9) & 0xfffff) < gus->gus_end_ram)
-                        vl = ((int8_t) ((gus->ram[(gus->cur[d] >> 9) & 0xfffff] ^ 0x80) - 0x80)) *
-                                       (511 - (gus->cur[d] & 511));
-                    else
-                        vl = 0;
+            if ((((cur >> 9) + 1) & 0xfffff) < gus->gus_end_ram)
+                vl += ((int8_t) ((gus->ram[((cur >> 9) + 1) & 0xfffff] ^ 0x80) - 0x80)) *
+                      (cur & 511);
 
-                    if ((((gus->cur[d] >> 9) + 1) & 0xfffff) < gus->gus_end_ram)
-                        vl += ((int8_t) ((gus->ram[((gus->cur[d] >> 9) + 1) & 0xfffff] ^ 0x80) - 0x80)) *
-                              (gus->cur[d] & 511);
+            return vl >> 9;
+        } else if (((cur >> 9) & 0xfffff) < gus->gus_end_ram)
+            return (int16_t) (int8_t) ((gus->ram[(cur >> 9) & 0xfffff] ^ 0x80) - 0x80);
+    }
 
-                    v = vl >> 9;
-                } else if (((gus->cur[d] >> 9) & 0xfffff) < gus->gus_end_ram)
-                    v = (int16_t) (int8_t) ((gus->ram[(gus->cur[d] >> 9) & 0xfffff] ^ 0x80) - 0x80);
-                else
-                    v = 0x0000;
-            }
+    return 0x0000;
+}
 
-            if ((gus->rcur[d] >> 14) > 4095)
-                v = (int16_t) (float) (v) *24.0 * vol16bit[4095];
-            else
-                v = (int16_t) (float) (v) *24.0 * vol16bit[(gus->rcur[d] >> 10) & 4095];
-
-            gus->out_l += (v * gus->pan_l[d]) / 7;
-            gus->out_r += (v * gus->pan_r[d]) / 7;
-
-            if (gus->ctrl[d] & 0x40) {
-                gus->cur[d] -= (gus->freq[d] >> 1);
-                if (gus->cur[d] <= gus->start[d]) {
-                    int diff = gus->start[d] - gus->cur[d];
-
-                    if (gus->ctrl[d] & 8) {
-                        if (gus->ctrl[d] & 0x10)
-                            gus->ctrl[d] ^= 0x40;
-                        gus->cur[d] = (gus->ctrl[d] & 0x40) ? (gus->end[d] - diff) : (gus->start[d] + diff);
-                    } else if (!(gus->rctrl[d] & 4)) {
-                        gus->ctrl[d] |= 1;
-                        gus->cur[d] = (gus->ctrl[d] & 0x40) ? gus->end[d] : gus->start[d];
-                    }
+static __inline int16_t
+gus_voice_volume(int16_t v, int rcur)
+{
+    if ((rcur >> 14) > 4095)
+        return (int16_t) (float) (v) *24.0 * vol16bit[4095];
 
-                    if ((gus->ctrl[d] & 0x20) && !gus->waveirqs[d]) {
-                        gus->waveirqs[d] = 1;
-                        update_irqs      = 1;
-                    }
+    return (int16_t) (float) (v) *24.0 * vol16bit[(rcur >> 10) & 4095];
+}
+
+/* Samples until the address of a voice reaches its start or end, counting the
+   sample that gets there. May be early (the boundary is then checked and not
+   taken), never late. Returns limit if it is not reached before that. */
+static uint32_t
+gus_voice_wave_left(const gus_t *gus, int d, uint32_t limit)
+{
+    uint32_t step = gus->freq[d] >> 1;
+    uint64_t left;
+
+    if (gus->ctrl[d] & 3)
+        return limit;
+
+    if (gus->ctrl[d] & 0x40) {
+        if (gus->cur[d] <= gus->start[d])
+            return 1;
+        left = gus->cur[d] - gus->start[d];
+    } else {
+        if (gus->cur[d] >= gus->end[d])
+            return 1;
+        left = gus->end[d] - gus->cur[d];
+    }
+
+    if (!step)
+        return limit;
+
+    left = (left + step - 1) / step;
+    return (left < limit) ? (uint32_t) left : limit;
+}
+
+/* Same for the volume ramp. */
+static uint32_t
+gus_voice_ramp_left(const gus_t *gus, int d, uint32_t limit)
+{
+    int64_t left;
+
+    if (gus->rctrl[d] & 3)
+        return limit;
+
+    if (gus->rctrl[d] & 0x40) {
+        if (gus->rcur[d] <= gus->rstart[d])
+            return 1;
+        left = (int64_t) gus->rcur[d] - gus->rstart[d];
+    } else {
+        if (gus->rcur[d] >= gus->rend[d])
+            return 1;
+        left = (int64_t) gus->rend[d] - gus->rcur[d];
+    }
+
+    if (!gus->rfreq[d])
+        return limit;
+
+    left = (left + gus->rfreq[d] - 1) / gus->rfreq[d];
+    return (left < limit) ? (uint32_t) left : limit;
+}
+
+/* Run one voice for one sample, handling the loop, stop and IRQ conditions.
+   Returns 1 if the IRQ status has to be updated. */
+static int
+gus_voice_step(gus_t *gus, int d, int32_t *out_l, int32_t *out_r)
+{
+    int16_t v;
+    int     update_irqs = 0;
+
+    if (!(gus->ctrl[d] & 3)) {
+        v = gus_voice_volume(gus_voice_fetch(gus, d, gus->cur[d]), gus->rcur[d]);
+
+        *out_l += (v * gus->pan_l[d]) / 7;
+        *out_r += (v * gus->pan_r[d]) / 7;
+
+        if (gus->ctrl[d] & 0x40) {
+            gus->cur[d] -= (gus->freq[d] >> 1);
+            if (gus->cur[d] <= gus->start[d]) {
+                int diff = gus->start[d] - gus->cur[d];
+
+                if (gus->ctrl[d] & 8) {
+                    if (gus->ctrl[d] & 0x10)
+                        gus->ctrl[d] ^= 0x40;
+                    gus->cur[d] = (gus->ctrl[d] & 0x40) ? (gus->end[d] - diff) : (gus->start[d] + diff);
+                } else if (!(gus->rctrl[d] & 4)) {
+                    gus->ctrl[d] |= 1;
+                    gus->cur[d] = (gus->ctrl[d] & 0x40) ? gus->end[d] : gus->start[d];
                 }
-            } else {
-                gus->cur[d] += (gus->freq[d] >> 1);
-
-                if (gus->cur[d] >= gus->end[d]) {
-                    int diff = gus->cur[d] - gus->end[d];
-
-                    if (gus->ctrl[d] & 8) {
-                        if (gus->ctrl[d] & 0x10)
-                            gus->ctrl[d] ^= 0x40;
-                        gus->cur[d] = (gus->ctrl[d] & 0x40) ? (gus->end[d] - diff) : (gus->start[d] + diff);
-                    } else if (!(gus->rctrl[d] & 4)) {
-                        gus->ctrl[d] |= 1;
-                        gus->cur[d] = (gus->ctrl[d] & 0x40) ? gus->end[d] : gus->start[d];
-                    }
 
-                    if ((gus->ctrl[d] & 0x20) && !gus->waveirqs[d]) {
-                        gus->waveirqs[d] = 1;
-                        update_irqs      = 1;
-                    }
+                if ((gus->ctrl[d] & 0x20) && !gus->waveirqs[d]) {
+                    gus->waveirqs[d] = 1;
+                    update_irqs      = 1;
+                }
+            }
+        } else {
+            gus->cur[d] += (gus->freq[d] >> 1);
+
+            if (gus->cur[d] >= gus->end[d]) {
+                int diff = gus->cur[d] - gus->end[d];
+
+                if (gus->ctrl[d] & 8) {
+                    if (gus->ctrl[d] & 0x10)
+                        gus->ctrl[d] ^= 0x40;
+                    gus->cur[d] = (gus->ctrl[d] & 0x40) ? (gus->end[d] - diff) : (gus->start[d] + diff);
+                } else if (!(gus->rctrl[d] & 4)) {
+                    gus->ctrl[d] |= 1;
+                    gus->cur[d] = (gus->ctrl[d] & 0x40) ? gus->end[d] : gus->start[d];
+                }
+
+                if ((gus->ctrl[d] & 0x20) && !gus->waveirqs[d]) {
+                    gus->waveirqs[d] = 1;
+                    update_irqs      = 1;
                 }
             }
         }
-        if (!(gus->rctrl[d] & 3)) {
-            if (gus->rctrl[d] & 0x40) {
-                gus->rcur[d] -= gus->rfreq[d];
-                if (gus->rcur[d] <= gus->rstart[d]) {
-                    int diff = gus->rstart[d] - gus->rcur[d];
-                    if (!(gus->rctrl[d] & 8)) {
-                        gus->rctrl[d] |= 1;
-                        gus->rcur[d] = (gus->rctrl[d] & 0x40) ? gus->rstart[d] : gus->rend[d];
-                    } else {
-                        if (gus->rctrl[d] & 0x10)
-                            gus->rctrl[d] ^= 0x40;
-                        gus->rcur[d] = (gus->rctrl[d] & 0x40) ? (gus->rend[d] - diff) : (gus->rstart[d] + diff);
-                    }
+    }
+    if (!(gus->rctrl[d] & 3)) {
+        if (gus->rctrl[d] & 0x40) {
+            gus->rcur[d] -= gus->rfreq[d];
+            if (gus->rcur[d] <= gus->rstart[d]) {
+                int diff = gus->rstart[d] - gus->rcur[d];
+                if (!(gus->rctrl[d] & 8)) {
+                    gus->rctrl[d] |= 1;
+                    gus->rcur[d] = (gus->rctrl[d] & 0x40) ? gus->rstart[d] : gus->rend[d];
+                } else {
+                    if (gus->rctrl[d] & 0x10)
+                        gus->rctrl[d] ^= 0x40;
+                    gus->rcur[d] = (gus->rctrl[d] & 0x40) ? (gus->rend[d] - diff) : (gus->rstart[d] + diff);
+                }
 
-                    if ((gus->rctrl[d] & 0x20) && !gus->rampirqs[d]) {
-                        gus->rampirqs[d] = 1;
-                        update_irqs      = 1;
-                    }
+                if ((gus->rctrl[d] & 0x20) && !gus->rampirqs[d]) {
+                    gus->rampirqs[d] = 1;
+                    update_irqs      = 1;
+                }
+            }
+        } else {
+            gus->rcur[d] += gus->rfreq[d];
+            if (gus->rcur[d] >= gus->rend[d]) {
+                int diff = gus->rcur[d] - gus->rend[d];
+                if (!(gus->rctrl[d] & 8)) {
+                    gus->rctrl[d] |= 1;
+                    gus->rcur[d] = (gus->rctrl[d] & 0x40) ? gus->rstart[d] : gus->rend[d];
+                } else {
+                    if (gus->rctrl[d] & 0x10)
+                        gus->rctrl[d] ^= 0x40;
+                    gus->rcur[d] = (gus->rctrl[d] & 0x40) ? (gus->rend[d] - diff) : (gus->rstart[d] + diff);
                 }
-            } else {
-                gus->rcur[d] += gus->rfreq[d];
-                if (gus->rcur[d] >= gus->rend[d]) {
-                    int diff = gus->rcur[d] - gus->rend[d];
-                    if (!(gus->rctrl[d] & 8)) {
-                        gus->rctrl[d] |= 1;
-                        gus->rcur[d] = (gus->rctrl[d] & 0x40) ? gus->rstart[d] : gus->rend[d];
-                    } else {
-                        if (gus->rctrl[d] & 0x10)
-                            gus->rctrl[d] ^= 0x40;
-                        gus->rcur[d] = (gus->rctrl[d] & 0x40) ? (gus->rend[d] - diff) : (gus->rstart[d] + diff);
-                    }
 
-                    if ((gus->rctrl[d] & 0x20) && !gus->rampirqs[d]) {
-                        gus->rampirqs[d] = 1;
-                        update_irqs      = 1;
-                    }
+                if ((gus->rctrl[d] & 0x20) && !gus->rampirqs[d]) {
+                    gus->rampirqs[d] = 1;
+                    update_irqs      = 1;
                 }
             }
         }
     }
 
+    return update_irqs;
+}
+
+/* Mix len samples of one voice. Between the points where the address or the
+   ramp reaches a boundary both advance linearly, so those runs go through a
+   plain loop and only the boundary samples take the full per-sample path. */
+static int
+gus_voice_render(gus_t *gus, int d, int32_t *out_l, int32_t *out_r, int len)
+{
+    uint32_t cur;
+    uint32_t wstep;
+    int      rcur;
+    int      rstep;
+    int      run;
+    int      pan_l       = gus->pan_l[d];
+    int      pan_r       = gus->pan_r[d];
+    int      update_irqs = 0;
+
+    for (int c = 0; c < len;) {
+        run = gus_voice_wave_left(gus, d, len - c + 1) - 1;
+        run = MIN(run, (int) gus_voice_ramp_left(gus, d, len - c + 1) - 1);
+
+        if (run > 0) {
+            cur   = gus->cur[d];
+            wstep = (gus->ctrl[d] & 0x40) ? -(uint32_t) (gus->freq[d] >> 1) : (gus->freq[d] >> 1);
+            rcur  = gus->rcur[d];
+            rstep = (gus->rctrl[d] & 3) ? 0 : ((gus->rctrl[d] & 0x40) ? -gus->rfreq[d] : gus->rfreq[d]);
+
+            if (!(gus->ctrl[d] & 3)) {
+                for (int i = c; i < (c + run); i++) {
+                    int16_t v = gus_voice_volume(gus_voice_fetch(gus, d, cur), rcur);
+
+                    out_l[i] += (v * pan_l) / 7;
+                    out_r[i] += (v * pan_r) / 7;
+                    cur += wstep;
+                    rcur += rstep;
+                }
+                gus->cur[d] = cur;
+            } else
+                rcur += rstep * run;
+            gus->rcur[d] = rcur;
+
+            c += run;
+        }
+
+        if (c < len) {
+            update_irqs |= gus_voice_step(gus, d, &out_l[c], &out_r[c]);
+            c++;
+        }
+    }
+
+    return update_irqs;
+}
+
+/* Schedule the wave timer for the next sample that can raise a wave or ramp
+   IRQ. No other sample needs to be run at its exact time, gus_wave_update()
+   catches up on the rest when the registers or the output are accessed. */
+static void
+gus_wave_schedule(gus_t *gus)
+{
+    uint32_t left = GUS_WAVE_AHEAD + 1;
+
+    if ((gus->reset & 3) == 3) {
+        for (uint8_t d = 0; d < 32; d++) {
+            if ((gus->ctrl[d] & 0x20) && !gus->waveirqs[d])
+                left = MIN(left, gus_voice_wave_left(gus, d, left));
+            if ((gus->rctrl[d] & 0x20) && !gus->rampirqs[d])
+                left = MIN(left, gus_voice_ramp_left(gus, d, left));
+        }
+    }
+
+    if (left > GUS_WAVE_AHEAD) {
+        if (timer_is_enabled(&gus->samp_timer))
+            timer_disable(&gus->samp_timer);
+        return;
+    }
+
+    timer_set_delay_u64(&gus->samp_timer, gus->samp_ts + ((left - 1) * gus->samp_latch) - ((uint64_t) tsc << 32));
+}
+
+/* Run the wave engine up to the current time and spread the new samples over
+   the output positions that have elapsed since the last update. */
+static void
+gus_wave_update(gus_t *gus)
+{
+    int32_t  out_l[GUS_WAVE_BLOCK];
+    int32_t  out_r[GUS_WAVE_BLOCK];
+    uint64_t now = ((uint64_t) tsc << 32) | 0xffffffffULL;
+    uint64_t late;
+    uint32_t len;
+    uint32_t done = 0;
+    uint32_t outlen;
+    uint32_t out  = 0;
+    uint32_t s;
+    int      block;
+    int      update_irqs = 0;
+
+    /* The next sample is never more than a period away, unless the time base was reset. */
+    if ((int64_t) (gus->samp_ts - now) > (int64_t) gus->samp_latch)
+        gus->samp_ts = now & ~0xffffffffULL;
+
+    if ((int64_t) (now - gus->samp_ts) < 0)
+        return;
+
+    late = ((now - gus->samp_ts) / gus->samp_latch) + 1;
+    len  = (late > GUS_WAVE_MAX) ? GUS_WAVE_MAX : (uint32_t) late;
+    gus->samp_ts += late * gus->samp_latch;
+
+    outlen = (gus->pos < sound_pos_global) ? (sound_pos_global - gus->pos) : 0;
+
+    while (done < len) {
+        block = MIN(len - done, GUS_WAVE_BLOCK);
+
+        memset(out_l, 0x00, block * sizeof(int32_t));
+        memset(out_r, 0x00, block * sizeof(int32_t));
+
+        if ((gus->reset & 3) == 3) {
+            for (uint8_t d = 0; d < 32; d++)
+                update_irqs |= gus_voice_render(gus, d, out_l, out_r, block);
+        }
+
+        /* Output position j holds the latest sample due by its time, taking the
+           output positions as evenly spread over the samples run. */
+        for (; out < outlen; out++) {
+            s = ((uint64_t) (out + 1) * len) / outlen;
+            if (s > (done + block))
+                break;
+            if (s > done)
+                gus_output(gus, out_l[s - done - 1], out_r[s - done - 1]);
+            else
+                gus_output(gus, gus->out_l, gus->out_r);
+            gus->pos++;
+        }
+
+        gus->out_l = out_l[block - 1];
+        gus->out_r = out_r[block - 1];
+        done += block;
+    }
+
+    gus_update(gus);
+
     if (update_irqs)
         gus_update_int_status(gus);
+
+    gus_wave_schedule(gus);
+}
+
+void
+gus_poll_wave(void *priv)
+{
+    gus_t *gus = (gus_t *) priv;
+
+    gus_wave_update(gus);
 }
 
 void
@@ -1337,6 +1570,7 @@ gus_get_buffer(int32_t *buffer, int len, void *priv)
     if ((gus->type == GUS_MAX) && (gus->max_ctrl))
         ad1848_update(&gus->ad1848);
 
+    gus_wave_update(gus);
     gus_update(gus);
     for (int c = 0; c < len * 2; c += 2) {
         double temp_l = 0.0;
@@ -1443,6 +1677,7 @@ gus_reset(void *priv)
     gus->voices = 14;
 
     gus->samp_latch = (uint64_t) (TIMER_USEC * (1000000.0 / 44100.0));
+    gus->samp_ts    = (uint64_t) tsc << 32;
 
     gus->t1l = gus->t2l = 0xff;
 
@@ -1520,6 +1755,7 @@ gus_reset(void *priv)
     }
 
     gus_update_int_status(gus);
+    gus_wave_schedule(gus);
 }
 
 void *
@@ -1548,6 +1784,7 @@ gus_init(UNUSED(const device_t *info))
     gus->voices = 14;
 
     gus->samp_latch = (uint64_t) (TIMER_USEC * (1000000.0 / 44100.0));
+    gus->samp_ts    = (uint64_t) tsc << 32;
 
     gus->t1l = gus->t2l = 0xff;
 
@@ -1601,7 +1838,7 @@ gus_init(UNUSED(const device_t *info))
                       ad1848_read, NULL, NULL, ad1848_write, NULL, NULL, &gus->ad1848);
     }
 
-    timer_add(&gus->samp_timer, gus_poll_wave, gus, 1);
+    timer_add(&gus->samp_timer, gus_poll_wave, gus, 0);
     timer_add(&gus->timer_1, gus_poll_timer_1, gus, 1);
     timer_add(&gus->timer_2, gus_poll_timer_2, gus, 1);
 
@@ -1627,11 +1864,15 @@ gus_speed_changed(void *priv)
 {
     gus_t *gus = (gus_t *) priv;
 
+    gus_wave_update(gus);
+
     if (gus->voices < 14)
         gus->samp_latch = (uint64_t) (TIMER_USEC * (1000000.0 / 44100.0));
     else
         gus->samp_latch = (uint64_t) (TIMER_USEC * (1000000.0 / gusfreqs[gus->voices - 14]));
 
+    gus_wave_schedule(gus);
+
     if ((gus->type == GUS_MAX) && (gus->max_ctrl))
         ad1848_speed_changed(&gus->ad1848);
 }
@@ -49,6 +49,7 @@
 #include "cpu.h"
 #include <86box/timer.h>
 #include <86box/device.h>
+#include <86box/device_worker.h>
 #include <86box/snd_opl.h>
 #include <86box/snd_opl_nuked.h>
 
@@ -1534,22 +1535,62 @@ nuked_drv_set_do_cycles(void *priv, int8_t do_cycles)
         dev->flags &= ~FLAG_CYCLES;
 }
 
-static int32_t *
-nuked_drv_update(void *priv)
+#define NUKED_POST_WRITE    DEVICE_POST_USER
+#define NUKED_POST_GENERATE (DEVICE_POST_USER + 1)
+
+/*
+ * Render the stereo pair straight into the output buffer up to the given
+ * position, halving as we go, instead of going through OPL3_GenerateStream()
+ * and a second pass over the block.
+ */
+static void
+nuked_drv_generate(nuked_drv_t *dev, int end)
+{
+    int32_t  samples[4];
+    int32_t *p = &dev->buffer[dev->pos * 2];
+
+    if (dev->is_48k) {
+        for (; dev->pos < end; dev->pos++) {
+            OPL3_Generate4ChResampled(&dev->opl, samples);
+            *p++ = samples[0] / 2;
+            *p++ = samples[1] / 2;
+        }
+    } else {
+        for (; dev->pos < end; dev->pos++) {
+            OPL3_Generate4Ch(&dev->opl, samples);
+            *p++ = samples[0] / 2;
+            *p++ = samples[1] / 2;
+        }
+    }
+}
+
+static void
+nuked_drv_worker(void *priv, uint8_t type, uint32_t addr, uint32_t val)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
 
-    if (dev->pos >= music_pos_global)
-        return dev->buffer;
+    nuked_drv_generate(dev, (int) addr);
 
-    OPL3_GenerateStream(&dev->opl,
-                        &dev->buffer[dev->pos * 2],
-                        music_pos_global - dev->pos);
+    if (type == NUKED_POST_WRITE)
+        OPL3_WriteRegBuffered(&dev->opl, (uint16_t) (val >> 8), (uint8_t) (val & 0xff));
+}
 
-    for (; dev->pos < music_pos_global; dev->pos++) {
-        dev->buffer[dev->pos * 2] /= 2;
-        dev->buffer[(dev->pos * 2) + 1] /= 2;
-    }
+static inline int
+nuked_drv_target(const nuked_drv_t *dev)
+{
+    return dev->is_48k ? sound_pos_global : music_pos_global;
+}
+
+static int32_t *
+nuked_drv_update(void *priv)
+{
+    nuked_drv_t *dev = (nuked_drv_t *) priv;
+
+    if (dev->worker != NULL) {
+        device_worker_post(dev->worker, NUKED_POST_GENERATE, nuked_drv_target(dev), 0);
+        device_worker_sync(dev->worker);
+    } else if (dev->pos < music_pos_global)
+        nuked_drv_generate(dev, music_pos_global);
 
     return dev->buffer;
 }
@@ -1559,17 +1600,11 @@ nuked_drv_update_48k(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
 
-    if (dev->pos >= sound_pos_global)
-        return dev->buffer;
-
-    OPL3_GenerateResampledStream(&dev->opl,
-                                 &dev->buffer[dev->pos * 2],
-                                 sound_pos_global - dev->pos);
-
-    for (; dev->pos < sound_pos_global; dev->pos++) {
-        dev->buffer[dev->pos * 2] /= 2;
-        dev->buffer[(dev->pos * 2) + 1] /= 2;
-    }
+    if (dev->worker != NULL) {
+        device_worker_post(dev->worker, NUKED_POST_GENERATE, nuked_drv_target(dev), 0);
+        device_worker_sync(dev->worker);
+    } else if (dev->pos < sound_pos_global)
+        nuked_drv_generate(dev, sound_pos_global);
 
     return dev->buffer;
 }
@@ -1582,7 +1617,9 @@ nuked_drv_read(uint16_t port, void *priv)
     if (dev->flags & FLAG_CYCLES)
         cycles -= ((int) (isa_timing * 8));
 
-    dev->update(dev);
+    /* The status only depends on the timers, which live on this thread. */
+    if (dev->worker == NULL)
+        dev->update(dev);
 
     uint8_t ret = 0xff;
 
@@ -1602,10 +1639,13 @@ nuked_drv_write(uint16_t port, uint8_t val, void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
 
-    dev->update(dev);
-
     if ((port & 0x0001) == 0x0001) {
-        OPL3_WriteRegBuffered(&dev->opl, dev->port, val);
+        if (dev->worker != NULL)
+            device_worker_post(dev->worker, NUKED_POST_WRITE, nuked_drv_target(dev), (dev->port << 8) | val);
+        else {
+            dev->update(dev);
+            OPL3_WriteRegBuffered(&dev->opl, dev->port, val);
+        }
 
         switch (dev->port) {
             case 0x002: /* Timer 1 */
@@ -1631,14 +1671,17 @@ nuked_drv_write(uint16_t port, uint8_t val, void *priv)
                 break;
 
             case 0x105:
-                dev->opl.newm = val & 0x01;
+                dev->newm = val & 0x01;
                 break;
 
             default:
                 break;
         }
     } else {
-        dev->port = nuked_write_addr(&dev->opl, port, val) & 0x01ff;
+        /* Use our own copy of NEW, the chip's belongs to the worker. */
+        dev->port = val;
+        if ((port & 0x0002) && ((val == 0x05) || dev->newm))
+            dev->port |= 0x0100;
 
         if (!(dev->flags & FLAG_OPL3))
             dev->port &= 0x00ff;
@@ -1650,6 +1693,9 @@ nuked_drv_reset_buffer(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
 
+    if (dev->worker != NULL)
+        device_worker_sync(dev->worker);
+
     dev->pos = 0;
 }
 
@@ -1657,6 +1703,9 @@ static void
 nuked_drv_close(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
+
+    device_worker_close(dev->worker);
+
     free(dev);
 }
 
@@ -1684,6 +1733,10 @@ nuked_drv_init(const device_t *info)
     timer_add(&dev->timers[0], nuked_timer_1, dev, 0);
     timer_add(&dev->timers[1], nuked_timer_2, dev, 0);
 
+    /* Each chip renders on its own thread, so the dual OPL2 cards spread
+       the work over two cores. */
+    dev->worker = device_worker_create("Nuked OPL", nuked_drv_worker, dev);
+
     return dev;
 }
 
@@ -12,6 +12,7 @@
  *
  *          Copyright 2022 Adrien Moulin.
  */
+#include <atomic>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
@@ -37,6 +38,7 @@ extern "C" {
 #include <86box/snd_opl.h>
 #include <86box/mem.h>
 #include <86box/rom.h>
+#include <86box/plat.h>
 #include <86box/plat_unused.h>
 
 // Disable c99-designator to avoid the warnings in *_ymfm_device
@@ -50,14 +52,29 @@ extern "C" {
 
 #define RSM_FRAC 10
 
+/* Chip samples generated per ymfm call, and register writes queued, a power of 2. */
+#define YMFM_BLOCK      256
+#define YMFM_QUEUE_SIZE 1024
+
 enum {
     FLAG_CYCLES = (1 << 0)
 };
 
+/* A register write, with the buffer position and the time at which it happened. */
+typedef struct ymfm_write_t {
+    int      pos;
+    uint64_t tsc;
+    uint16_t addr;
+    uint8_t  data;
+} ymfm_write_t;
+
 class YMFMChipBase {
 public:
     YMFMChipBase(UNUSED(uint32_t clock), fm_type type, uint32_t samplerate, int is_48k)
         : m_buf_pos(0)
+        , m_queue_head(0)
+        , m_queue_tail(0)
+        , m_direct(false)
         , m_flags(0)
         , m_type(type)
         , m_samplerate(samplerate)
@@ -76,10 +93,12 @@ public:
     int32_t *buffer() const { return (int32_t *) m_buffer; }
     void     reset_buffer() { m_buf_pos = 0; }
     int      is_48k() const { return m_48k; }
+    void     set_direct() { m_direct = true; }
 
     virtual uint32_t sample_rate() const = 0;
 
     virtual void     write(uint16_t addr, uint8_t data)                      = 0;
+    virtual void     sync()                                                  = 0;
     virtual void     generate(int32_t *data, uint32_t num_samples)           = 0;
     virtual void     generate_resampled(int32_t *data, uint32_t num_samples) = 0;
     virtual int32_t *update()                                                = 0;
@@ -90,6 +109,15 @@ protected:
     int32_t  m_buffer[MUSICBUFLEN * 2];
     int      m_buf_pos;
     int      *m_buf_pos_global;
+
+    /* Register writes not yet applied to the chip. Single producer, single
+       consumer, so the daughterboard path can queue from the emulation
+       thread while its own thread generates. */
+    ymfm_write_t          m_queue[YMFM_QUEUE_SIZE];
+    std::atomic<uint32_t> m_queue_head;
+    std::atomic<uint32_t> m_queue_tail;
+    std::atomic<bool>     m_direct; /* generated through fm_drv_t.generate() */
+
     int8_t   m_flags;
     fm_type  m_type;
     uint32_t m_samplerate;
@@ -105,6 +133,8 @@ public:
         , m_clock(clock)
         , m_samplerate(samplerate)
         , m_samplecnt(0)
+        , m_write_tsc(0)
+        , m_in_sync(0)
         , m_48k(0)
     {
         memset(m_samples, 0, sizeof(m_samples));
@@ -145,6 +175,11 @@ public:
             timer_stop(timer);
         else {
             double period = m_clock_us * duration_in_clocks;
+
+            /* Started by a queued write, count from the time of the write. */
+            if (m_in_sync)
+                period -= ((double) (tsc - m_write_tsc) * 4294967296.0) / (double) TIMER_USEC;
+
             if (period < m_subtract[tnum])
                 m_engine->engine_timer_expired(tnum);
             else
@@ -162,89 +197,165 @@ public:
         ymfm_set_timer(1, m_duration_in_clocks[1]);
     }
 
-    virtual void generate(int32_t *data, uint32_t num_samples) override
+    void output_sample(const typename ChipType::output_data &output, int32_t *out_l, int32_t *out_r) const
     {
-        for (uint32_t i = 0; i < num_samples; i++) {
-            m_chip.generate(&m_output);
-            if ((m_type == FM_YMF278B) && (sizeof(m_output.data) > (4 * sizeof(int32_t)))) {
-                if (ChipType::OUTPUTS == 1) {
-                    *data++ = m_output.data[4];
-                    *data++ = m_output.data[4];
-                } else {
-                    *data++ = m_output.data[4];
-                    *data++ = m_output.data[5];
-                }
-            } else if (ChipType::OUTPUTS == 1) {
-                *data++ = m_output.data[0];
-                *data++ = m_output.data[0];
+        if ((m_type == FM_YMF278B) && (sizeof(output.data) > (4 * sizeof(int32_t)))) {
+            if (ChipType::OUTPUTS == 1) {
+                *out_l = output.data[4];
+                *out_r = output.data[4];
             } else {
-                *data++ = m_output.data[0];
-                *data++ = m_output.data[1 % ChipType::OUTPUTS];
+                *out_l = output.data[4];
+                *out_r = output.data[5];
             }
+        } else if (ChipType::OUTPUTS == 1) {
+            *out_l = output.data[0];
+            *out_r = output.data[0];
+        } else {
+            *out_l = output.data[0];
+            *out_r = output.data[1 % ChipType::OUTPUTS];
+        }
+    }
+
+    virtual void generate(int32_t *data, uint32_t num_samples) override
+    {
+        uint32_t block;
+
+        for (uint32_t i = 0; i < num_samples; i += block) {
+            block = MIN(num_samples - i, YMFM_BLOCK);
+
+            m_chip.generate(m_outputs, block);
+            for (uint32_t j = 0; j < block; j++, data += 2)
+                output_sample(m_outputs[j], &data[0], &data[1]);
         }
     }
 
     virtual void generate_resampled(int32_t *data, uint32_t num_samples) override
     {
-        for (uint32_t i = 0; i < num_samples; i++) {
-            while (m_samplecnt >= m_rateratio) {
-                m_oldsamples[0] = m_samples[0];
-                m_oldsamples[1] = m_samples[1];
-                m_chip.generate(&m_output);
-                if ((m_type == FM_YMF278B) && (sizeof(m_output.data) > (4 * sizeof(int32_t)))) {
-                    if (ChipType::OUTPUTS == 1) {
-                        m_samples[0] = m_output.data[4];
-                        m_samples[1] = m_output.data[4];
-                    } else {
-                        m_samples[0] = m_output.data[4];
-                        m_samples[1] = m_output.data[5];
-                    }
-                } else if (ChipType::OUTPUTS == 1) {
-                    m_samples[0] = m_output.data[0];
-                    m_samples[1] = m_output.data[0];
-                } else {
-                    m_samples[0] = m_output.data[0];
-                    m_samples[1] = m_output.data[1 % ChipType::OUTPUTS];
+        uint32_t i = 0;
+        uint32_t count;
+        uint32_t needed;
+        uint32_t used;
+        uint32_t chip_samples;
+        int32_t  samplecnt;
+
+        while (i < num_samples) {
+            /* Count how many output samples a block of chip samples covers,
+               so that the chip never runs ahead of the output. */
+            count        = 0;
+            chip_samples = 0;
+            samplecnt    = m_samplecnt;
+            while ((i + count) < num_samples) {
+                needed = 0;
+                while (samplecnt >= m_rateratio) {
+                    samplecnt -= m_rateratio;
+                    needed++;
                 }
-                m_samplecnt -= m_rateratio;
+                if ((chip_samples + needed) > YMFM_BLOCK)
+                    break;
+                chip_samples += needed;
+                samplecnt += 1 << RSM_FRAC;
+                count++;
             }
 
-            *data++ = ((int32_t) ((m_oldsamples[0] * (m_rateratio - m_samplecnt)
-                                   + m_samples[0] * m_samplecnt)
-                                  / m_rateratio));
-            *data++ = ((int32_t) ((m_oldsamples[1] * (m_rateratio - m_samplecnt)
-                                   + m_samples[1] * m_samplecnt)
-                                  / m_rateratio));
+            if (chip_samples)
+                m_chip.generate(m_outputs, chip_samples);
+
+            used = 0;
+            for (uint32_t j = 0; j < count; j++) {
+                while (m_samplecnt >= m_rateratio) {
+                    m_oldsamples[0] = m_samples[0];
+                    m_oldsamples[1] = m_samples[1];
+                    output_sample(m_outputs[used++], &m_samples[0], &m_samples[1]);
+                    m_samplecnt -= m_rateratio;
+                }
+
+                *data++ = ((int32_t) ((m_oldsamples[0] * (m_rateratio - m_samplecnt)
+                                       + m_samples[0] * m_samplecnt)
+                                      / m_rateratio));
+                *data++ = ((int32_t) ((m_oldsamples[1] * (m_rateratio - m_samplecnt)
+                                       + m_samples[1] * m_samplecnt)
+                                      / m_rateratio));
+
+                m_samplecnt += 1 << RSM_FRAC;
+            }
 
-            m_samplecnt += 1 << RSM_FRAC;
+            i += count;
         }
     }
 
-    virtual int32_t *update() override
+    /* Generate the buffer up to pos, for the output sample rate. */
+    void render(int pos)
     {
-        if (m_buf_pos >= *m_buf_pos_global)
-            return m_buffer;
+        if (m_buf_pos >= pos)
+            return;
 
         if (m_48k)
-            generate_resampled(&m_buffer[m_buf_pos * 2], *m_buf_pos_global - m_buf_pos);
-        else        
-            generate(&m_buffer[m_buf_pos * 2], *m_buf_pos_global - m_buf_pos);
+            generate_resampled(&m_buffer[m_buf_pos * 2], pos - m_buf_pos);
+        else
+            generate(&m_buffer[m_buf_pos * 2], pos - m_buf_pos);
 
-        for (; m_buf_pos < *m_buf_pos_global; m_buf_pos++) {
+        for (; m_buf_pos < pos; m_buf_pos++) {
             m_buffer[m_buf_pos * 2] /= 2;
             m_buffer[(m_buf_pos * 2) + 1] /= 2;
         }
+    }
+
+    /* Apply the queued writes, each after generating up to its position. */
+    virtual void sync() override
+    {
+        uint32_t tail = m_queue_tail.load(std::memory_order_relaxed);
+        uint32_t head = m_queue_head.load(std::memory_order_acquire);
+        bool     direct = m_direct.load(std::memory_order_relaxed);
+
+        m_in_sync = 1;
+        for (; tail != head; tail++) {
+            const ymfm_write_t *w = &m_queue[tail & (YMFM_QUEUE_SIZE - 1)];
+
+            if (!direct)
+                render(w->pos);
+            m_write_tsc = w->tsc;
+            m_chip.write(w->addr, w->data);
+        }
+        m_in_sync = 0;
+
+        m_queue_tail.store(tail, std::memory_order_release);
+    }
+
+    virtual int32_t *update() override
+    {
+        sync();
+        render(*m_buf_pos_global);
 
         return m_buffer;
     }
 
     virtual void write(uint16_t addr, uint8_t data) override
     {
-        m_chip.write(addr, data);
+        uint32_t      head = m_queue_head.load(std::memory_order_relaxed);
+        ymfm_write_t *w;
+
+        while ((head - m_queue_tail.load(std::memory_order_acquire)) >= YMFM_QUEUE_SIZE) {
+            /* Full, the daughterboard thread drains it on its next block. */
+            if (m_direct.load(std::memory_order_relaxed))
+                plat_delay_ms(1);
+            else
+                sync();
+        }
+
+        w       = &m_queue[head & (YMFM_QUEUE_SIZE - 1)];
+        w->pos  = *m_buf_pos_global;
+        w->tsc  = tsc;
+        w->addr = addr;
+        w->data = data;
+
+        m_queue_head.store(head + 1, std::memory_order_release);
     }
 
     virtual uint8_t read(uint16_t addr) override
     {
+        /* The status and the registers read back depend on the writes before. */
+        sync();
+
         return m_chip.read(addr);
     }
 
@@ -256,12 +367,14 @@ public:
     static void timer1(void *priv)
     {
         YMFMChip<ChipType> *drv = (YMFMChip<ChipType> *) priv;
+        drv->sync();
         drv->m_engine->engine_timer_expired(0);
     }
 
     static void timer2(void *priv)
     {
         YMFMChip<ChipType> *drv = (YMFMChip<ChipType> *) priv;
+        drv->sync();
         drv->m_engine->engine_timer_expired(1);
     }
 
@@ -278,7 +391,7 @@ private:
     uint32_t                       m_clock;
     double                         m_clock_us;
     double                         m_subtract[2];
-    typename ChipType::output_data m_output;
+    typename ChipType::output_data m_outputs[YMFM_BLOCK];
     pc_timer_t                     m_timers[2];
     int32_t                        m_duration_in_clocks[2]; // Needed for clock switches.
     uint32_t                       m_samplerate;
@@ -292,6 +405,10 @@ private:
     int32_t m_oldsamples[2];
     int32_t m_samples[2];
 
+    // Queued write being applied, for the timers it starts.
+    uint64_t m_write_tsc;
+    int      m_in_sync;
+
     int                            m_48k;
 };
 
@@ -483,7 +600,6 @@ ymfm_drv_read(uint16_t port, void *priv)
         cycles -= ((int) (isa_timing * 8));
 
     uint8_t ret = drv->read(port);
-    drv->update();
 
     ymfm_log("YMFM read port %04x, status = %02x\n", port, ret);
     return ret;
@@ -498,7 +614,6 @@ ymfm_drv_write(uint16_t port, uint8_t val, void *priv)
     if ((port == 0x380) || (port == 0x381))
         port |= 4;
     drv->write(port, val);
-    drv->update();
 }
 
 static int32_t *
@@ -530,6 +645,10 @@ ymfm_drv_generate(void *priv, int32_t *data, uint32_t num_samples)
 {
     YMFMChipBase *drv = (YMFMChipBase *) priv;
 
+    /* The whole block is generated at once, after the writes queued since the last one. */
+    drv->set_direct();
+    drv->sync();
+
     if (drv->is_48k())
         drv->generate_resampled(data, num_samples);
     else
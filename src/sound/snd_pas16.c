@@ -490,7 +490,7 @@ enum {
 #define MV508_REG_SB_L          (MV508_MIXER | MV508_SB | MV508_LEFT)
 #define MV508_REG_SB_R          (MV508_MIXER | MV508_SB | MV508_RIGHT)
 
-double low_fir_pas16_coef[SB16_NCoef];
+float low_fir_pas16_coef[SB16_NCoef];
 
 /*
    Also used for the MVA508.
@@ -9,23 +9,37 @@
 
 #define RESID_FREQ 48000
 
+#define SID_CLOCK          (14318180.0 / 16.0)
+#define CYCLES_PER_SAMPLE  (SID_CLOCK / (double) RESID_FREQ)
+
+/* Samples the resampler can produce beyond the ones asked for. */
+#define SID_CARRY_MAX      4
+
 using reSIDfp::SID;
 
 typedef struct psid_t {
     /* resid sid implementation */
     SID    *sid;
     int16_t last_sample;
-} psid_t;
 
-psid_t *psid;
+    /* Fraction of a cycle left over from the previous batch. */
+    double  cycles_frac;
+
+    /* Clock output, and what did not fit in the previous batch. */
+    short  *scratch;
+    int     scratch_len;
+    short   carry[SID_CARRY_MAX];
+    int     carry_len;
+} psid_t;
 
 void *
-sid_init(uint8_t type, double range)
+sid_init(uint8_t type, double range, int fast)
 {
-    reSIDfp::SamplingMethod method         = reSIDfp::RESAMPLE;
-    float                   cycles_per_sec = 14318180.0 / 16.0;
+    reSIDfp::SamplingMethod method         = fast ? reSIDfp::DECIMATE : reSIDfp::RESAMPLE;
+    float                   cycles_per_sec = SID_CLOCK;
+    psid_t                 *psid;
 
-    psid      = new psid_t;
+    psid      = new psid_t();
     psid->sid = new SID;
 	psid->sid->setFilter6581Range(range);
 	psid->sid->reset();
@@ -60,17 +74,20 @@ sid_init(uint8_t type, double range)
 }
 
 void
-sid_close(UNUSED(void *priv))
+sid_close(void *priv)
 {
+    psid_t *psid = (psid_t *) priv;
+
     delete psid->sid;
-#if 0
-    free(psid);
-#endif
+    delete[] psid->scratch;
+    delete psid;
 }
 
 void
-sid_reset(UNUSED(void *priv))
+sid_reset(void *priv)
 {
+    psid_t *psid = (psid_t *) priv;
+
     psid->sid->reset();
 
     for (uint8_t c = 0; c < 32; c++)
@@ -78,32 +95,73 @@ sid_reset(UNUSED(void *priv))
 }
 
 uint8_t
-sid_read(uint16_t addr, UNUSED(void *priv))
+sid_read(uint16_t addr, void *priv)
 {
+    const psid_t *psid = (psid_t *) priv;
+
     return psid->sid->read(addr & 0x1f);
 }
 
 void
-sid_write(uint16_t addr, uint8_t val, UNUSED(void *priv))
+sid_write(uint16_t addr, uint8_t val, void *priv)
 {
+    const psid_t *psid = (psid_t *) priv;
+
     psid->sid->write(addr & 0x1f, val);
 }
 
-#define CLOCK_DELTA(n) (int) (((14318180.0 * n) / 16.0) / (float) RESID_FREQ)
-
-static void
-fillbuf2(int &count, int16_t *buf, UNUSED(int len))
-{
-    int c = psid->sid->clock(count, buf);
-
-    if (!c)
-        *buf = psid->last_sample;
-    psid->last_sample = *buf;
-}
+/*
+ * Render exactly len samples in one clock() call. The cycle count is carried
+ * over in fractions so the SID does not drift against the output rate, and
+ * the odd sample the resampler produces early is kept for the next batch.
+ */
 void
-sid_fillbuf(int16_t *buf, int len, UNUSED(void *priv))
+sid_fillbuf(int16_t *buf, int len, void *priv)
 {
-    int x = CLOCK_DELTA(len);
+    psid_t *psid = (psid_t *) priv;
+    double  cycles;
+    int     count;
+    int     n;
+    int     done = 0;
+
+    if (len <= 0)
+        return;
+
+    n = (psid->carry_len < len) ? psid->carry_len : len;
+    memcpy(buf, psid->carry, n * sizeof(short));
+    memmove(psid->carry, &psid->carry[n], (psid->carry_len - n) * sizeof(short));
+    psid->carry_len -= n;
+    done += n;
+
+    if (done < len) {
+        cycles            = psid->cycles_frac + (CYCLES_PER_SAMPLE * (len - done));
+        count             = (int) cycles;
+        psid->cycles_frac = cycles - count;
+
+        if (psid->scratch_len < (len + SID_CARRY_MAX)) {
+            delete[] psid->scratch;
+            psid->scratch_len = len + SID_CARRY_MAX;
+            psid->scratch     = new short[psid->scratch_len];
+        }
+
+        n = psid->sid->clock(count, psid->scratch);
+
+        if (n > (len - done)) {
+            psid->carry_len = n - (len - done);
+            if (psid->carry_len > SID_CARRY_MAX)
+                psid->carry_len = SID_CARRY_MAX;
+            memcpy(psid->carry, &psid->scratch[len - done], psid->carry_len * sizeof(short));
+            n = len - done;
+        }
+
+        memcpy(&buf[done], psid->scratch, n * sizeof(short));
+        done += n;
+    }
 
-    fillbuf2(x, buf, len);
-}
\ No newline at end of file
+    if (done > 0)
+        psid->last_sample = buf[done - 1];
+
+    /* Short by a sample, hold the last one. */
+    for (; done < len; done++)
+        buf[done] = psid->last_sample;
+}
@@ -269,7 +269,7 @@ uint16_t espcm3_dpcm_tables[1024] =
 };
 // clang-format on
 
-double low_fir_sb16_coef[5][SB16_NCoef];
+float low_fir_sb16_coef[5][SB16_NCoef];
 
 #ifdef ENABLE_SB_DSP_LOG
 int sb_dsp_do_log = ENABLE_SB_DSP_LOG;
@@ -624,6 +624,28 @@ sb_resume_dma(const sb_dsp_t *dsp, const int is_8)
     }
 }
 
+/* Whether the output timer still has something to clock. */
+static int
+sb_dsp_output_active(const sb_dsp_t *dsp)
+{
+    if (dsp->sb_pausetime >= 0)
+        return 1;
+
+    /* The ESPCM decoders keep draining their FIFO while the DMA is paused. */
+    if (dsp->sb_8_enable && dsp->sb_8_output &&
+        (!dsp->sb_8_pause || ((dsp->sb_8_format >= ESPCM_4) && (dsp->sb_8_format <= ESPCM_4E))))
+        return 1;
+
+    return dsp->sb_16_enable && dsp->sb_16_output && !dsp->sb_16_pause;
+}
+
+static void
+sb_dsp_output_resume(sb_dsp_t *dsp)
+{
+    if (!timer_is_enabled(&dsp->output_timer) && sb_dsp_output_active(dsp))
+        timer_set_delay_u64(&dsp->output_timer, (uint64_t) dsp->sblatcho);
+}
+
 void
 sb_start_dma(sb_dsp_t *dsp, int dma8, int autoinit, uint8_t format, int len)
 {
@@ -1693,6 +1715,7 @@ sb_exec_command(sb_dsp_t *dsp)
         case 0xD4: /* Continue 8-bit DMA */
             dsp->sb_8_pause = 0;
             sb_resume_dma(dsp, 1);
+            sb_dsp_output_resume(dsp);
             break;
         case 0xD5: /* Pause 16-bit DMA */
             if (dsp->sb_type >= SB16_DSP_404) {
@@ -1704,6 +1727,7 @@ sb_exec_command(sb_dsp_t *dsp)
             if (dsp->sb_type >= SB16_DSP_404) {
                 dsp->sb_16_pause = 0;
                 sb_resume_dma(dsp, 1);
+                sb_dsp_output_resume(dsp);
             }
             break;
         case 0xD8: /* Get speaker status */
@@ -2828,6 +2852,12 @@ pollsb(void *priv)
             sb_dsp_log("SB pause over\n");
         }
     }
+
+    /* Paused DMA would otherwise keep this firing at the sample rate for
+       nothing, continuing it arms the timer again. The mixer still holds
+       the last sample through sb_dsp_update(). */
+    if (timer_is_enabled(&dsp->output_timer) && !sb_dsp_output_active(dsp))
+        timer_disable(&dsp->output_timer);
 }
 
 void
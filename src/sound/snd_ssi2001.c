@@ -8,17 +8,25 @@
 
 #include <86box/86box.h>
 #include <86box/device.h>
+#include <86box/device_worker.h>
 #include <86box/gameport.h>
 #include <86box/io.h>
 #include <86box/snd_resid.h>
 #include <86box/sound.h>
 #include <86box/plat_unused.h>
 
+#define SSI2001_POST_WRITE    DEVICE_POST_USER
+#define SSI2001_POST_GENERATE (DEVICE_POST_USER + 1)
+
 typedef struct ssi2001_t {
     void   *psid;
     int16_t buffer[SOUNDBUFLEN * 2];
     int     pos;
     int     gameport_enabled;
+
+    /* Optional synthesis thread, register writes are posted to it stamped
+       with the buffer position they happened at. */
+    device_worker_t *worker;
 } ssi2001_t;
 
 typedef struct entertainer_t {
@@ -26,13 +34,34 @@ typedef struct entertainer_t {
 } entertainer_t;
 
 static void
-ssi2001_update(ssi2001_t *ssi2001)
+ssi2001_generate(ssi2001_t *ssi2001, int end)
 {
-    if (ssi2001->pos >= sound_pos_global)
+    if (ssi2001->pos >= end)
         return;
 
-    sid_fillbuf(&ssi2001->buffer[ssi2001->pos], sound_pos_global - ssi2001->pos, ssi2001->psid);
-    ssi2001->pos = sound_pos_global;
+    sid_fillbuf(&ssi2001->buffer[ssi2001->pos], end - ssi2001->pos, ssi2001->psid);
+    ssi2001->pos = end;
+}
+
+static void
+ssi2001_worker(void *priv, uint8_t type, uint32_t addr, uint32_t val)
+{
+    ssi2001_t *ssi2001 = (ssi2001_t *) priv;
+
+    ssi2001_generate(ssi2001, (int) addr);
+
+    if (type == SSI2001_POST_WRITE)
+        sid_write(val >> 8, val & 0xff, ssi2001->psid);
+}
+
+static void
+ssi2001_update(ssi2001_t *ssi2001)
+{
+    if (ssi2001->worker != NULL) {
+        device_worker_post(ssi2001->worker, SSI2001_POST_GENERATE, sound_pos_global, 0);
+        device_worker_sync(ssi2001->worker);
+    } else
+        ssi2001_generate(ssi2001, sound_pos_global);
 }
 
 static void
@@ -53,9 +82,10 @@ ssi2001_read(uint16_t addr, void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
 
+    /* OSC3 and ENV3 follow the synthesis, so catch up first. */
     ssi2001_update(ssi2001);
 
-    return sid_read(addr, priv);
+    return sid_read(addr, ssi2001->psid);
 }
 
 static void
@@ -63,8 +93,12 @@ ssi2001_write(uint16_t addr, uint8_t val, void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
 
-    ssi2001_update(ssi2001);
-    sid_write(addr, val, priv);
+    if (ssi2001->worker != NULL)
+        device_worker_post(ssi2001->worker, SSI2001_POST_WRITE, sound_pos_global, ((addr & 0x1f) << 8) | val);
+    else {
+        ssi2001_update(ssi2001);
+        sid_write(addr, val, ssi2001->psid);
+    }
 }
 
 void *
@@ -72,8 +106,11 @@ ssi2001_init(UNUSED(const device_t *info))
 {
     ssi2001_t *ssi2001 = calloc(1, sizeof(ssi2001_t));
 
-    ssi2001->psid = sid_init(device_get_config_int("sid_config"),device_get_config_int("sid_adjustment"));
+    ssi2001->psid = sid_init(device_get_config_int("sid_config"),device_get_config_int("sid_adjustment"),
+                             device_get_config_int("sid_resampling"));
     sid_reset(ssi2001->psid);
+    if (device_get_config_int("threaded"))
+        ssi2001->worker = device_worker_create("SSI-2001 SID", ssi2001_worker, ssi2001);
     uint16_t addr             = device_get_config_hex16("base");
     ssi2001->gameport_enabled = device_get_config_int("gameport");
     io_sethandler(addr, 0x0020, ssi2001_read, NULL, NULL, ssi2001_write, NULL, NULL, ssi2001);
@@ -88,6 +125,7 @@ ssi2001_close(void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
 
+    device_worker_close(ssi2001->worker);
     sid_close(ssi2001->psid);
 
     free(ssi2001);
@@ -112,7 +150,7 @@ entertainer_init(UNUSED(const device_t *info))
     ssi2001_t     *ssi2001     = calloc(1, sizeof(ssi2001_t));
     entertainer_t *entertainer = calloc(1, sizeof(entertainer_t));
 
-    ssi2001->psid = sid_init(0, 0.5);
+    ssi2001->psid = sid_init(0, 0.5, 0);
     sid_reset(ssi2001->psid);
     ssi2001->gameport_enabled = device_get_config_int("gameport");
     io_sethandler(0x200, 0x0001, entertainer_read, NULL, NULL, entertainer_write, NULL, NULL, entertainer);
@@ -189,6 +227,32 @@ static const device_config_t ssi2001_config[] = {
         .selection      = {{"0.5"}},
         .bios           = { { 0 } }
     },
+    {
+        .name           = "sid_resampling",
+        .description    = "Resampling",
+        .type           = CONFIG_SELECTION,
+        .default_string = NULL,
+        .default_int    = 0,
+        .file_filter    = NULL,
+        .spinner        = { 0 },
+        .selection      = {
+            { .description = "Resample (best quality)", .value = 0 },
+            { .description = "Decimate (faster)",       .value = 1 },
+            { .description = ""                                    }
+        },
+        .bios           = { { 0 } }
+    },
+    {
+        .name           = "threaded",
+        .description    = "Render on a separate thread",
+        .type           = CONFIG_BINARY,
+        .default_string = NULL,
+        .default_int    = 1,
+        .file_filter    = NULL,
+        .spinner        = { 0 },
+        .selection      = { { 0 } },
+        .bios           = { { 0 } }
+    },
     { .name = "", .description = "", .type = CONFIG_END }
 // clang-format off
 };
@@ -16,6 +16,7 @@
  *          Copyright 2016-2025 Miran Grca.
  *          Copyright 2024-2025 Jasmine Iwanek.
  */
+#include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdint.h>
@@ -37,6 +38,9 @@
 #include <86box/snd_mpu401.h>
 #include <86box/sound.h>
 #include <86box/fdd_audio.h>
+#include <86box/record.h>
+
+#include <minitrace/minitrace.h>
 
 typedef struct {
     const device_t *device;
@@ -45,6 +49,11 @@ typedef struct {
 typedef struct {
     void (*get_buffer)(int32_t *buffer, int len, void *priv);
     void *priv;
+
+    /* Host time spent in get_buffer, when timer_profile is set. */
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t max_ns;
 } sound_handler_t;
 
 int sound_card_current[SOUND_CARD_MAX] = { 0, 0, 0, 0 };
@@ -53,6 +62,8 @@ int music_pos_global                   = 0;
 int wavetable_pos_global               = 0;
 int sound_gain                         = 0;
 
+uint32_t sound_underruns = 0;
+
 static sound_handler_t sound_handlers[8];
 static sound_handler_t music_handlers[8];
 static sound_handler_t wavetable_handlers[8];
@@ -513,7 +524,7 @@ sound_init(void)
         sound_cd_start_event = thread_create_event();
 
         sound_cd_event    = thread_create_event();
-        sound_cd_thread_h = thread_create(sound_cd_thread, NULL);
+        sound_cd_thread_h = thread_create_role(sound_cd_thread, NULL, THREAD_ROLE_AUDIO);
 
         sound_log("Waiting for CD start event...\n");
         thread_wait_event(sound_cd_start_event, -1);
@@ -567,124 +578,173 @@ sound_set_pc_speaker_filter(void (*filter)(int channel, double *buffer, void *pr
     }
 }
 
-void
-sound_poll(UNUSED(void *priv))
+static void
+sound_run_handlers(sound_handler_t *handlers, int num, int32_t *buffer, int len)
 {
-    timer_advance_u64(&sound_poll_timer, sound_poll_latch);
+    uint64_t start;
+    uint64_t elapsed;
 
-    midi_poll();
+    memset(buffer, 0x00, len * 2 * sizeof(int32_t));
 
-    sound_pos_global++;
-    if (sound_pos_global == SOUNDBUFLEN) {
-        int c;
-
-        memset(outbuffer, 0x00, SOUNDBUFLEN * 2 * sizeof(int32_t));
-
-        for (c = 0; c < sound_handlers_num; c++)
-            sound_handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, sound_handlers[c].priv);
+    for (int c = 0; c < num; c++) {
+        if (!timer_profile) {
+            handlers[c].get_buffer(buffer, len, handlers[c].priv);
+            continue;
+        }
 
-        for (c = 0; c < SOUNDBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_ex[c] = ((float) outbuffer[c]) / (float) 32768.0;
-            else {
-                if (outbuffer[c] > 32767)
-                    outbuffer[c] = 32767;
-                if (outbuffer[c] < -32768)
-                    outbuffer[c] = -32768;
+        start = plat_get_nsecs();
+        handlers[c].get_buffer(buffer, len, handlers[c].priv);
+        elapsed = plat_get_nsecs() - start;
 
-                outbuffer_ex_int16[c] = (int16_t) outbuffer[c];
-            }
-        }
+        handlers[c].calls++;
+        handlers[c].total_ns += elapsed;
+        if (elapsed > handlers[c].max_ns)
+            handlers[c].max_ns = elapsed;
+    }
+}
 
-        if (sound_is_float)
-            givealbuffer(outbuffer_ex);
-        else
-            givealbuffer(outbuffer_ex_int16);
+static void
+sound_output_convert(const int32_t *buffer, float *out_float, int16_t *out_int16, int len)
+{
+    if (sound_is_float)
+        sound_mix_to_float(out_float, buffer, len * 2);
+    else
+        sound_mix_to_int16(out_int16, buffer, len * 2);
+}
 
-        if (cd_thread_enable) {
-            cd_buf_update--;
-            if (!cd_buf_update) {
-                cd_buf_update = (SOUND_FREQ / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
-                thread_set_event(sound_cd_event);
-            }
-        }
+static void
+sound_profile_dump_handlers(const char *kind, const sound_handler_t *handlers, int num)
+{
+    for (int c = 0; c < num; c++) {
+        if (!handlers[c].calls)
+            continue;
 
-        if (fdd_thread_enable) {
-            thread_set_event(sound_fdd_event);
-        }
-        sound_pos_global = 0;
+        always_log("%-10s %-18p %12" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n", kind,
+                   (void *) (uintptr_t) handlers[c].get_buffer, handlers[c].calls,
+                   handlers[c].total_ns / handlers[c].calls, handlers[c].max_ns);
     }
 }
 
+/* Log the time spent in each buffer handler, alongside the timer profile. */
 void
-music_poll(UNUSED(void *priv))
+sound_profile_dump(void)
 {
-    timer_advance_u64(&music_poll_timer, music_poll_latch);
+    if (!timer_profile)
+        return;
+
+    always_log("Sound handler profile:\n");
+    always_log("%-10s %-18s %12s %12s %12s\n", "Output", "Handler", "Calls", "Mean (ns)", "Max (ns)");
+    sound_profile_dump_handlers("Sound", sound_handlers, sound_handlers_num);
+    sound_profile_dump_handlers("Music", music_handlers, music_handlers_num);
+    sound_profile_dump_handlers("Wavetable", wavetable_handlers, wavetable_handlers_num);
+}
 
-    music_pos_global++;
-    if (music_pos_global == MUSICBUFLEN) {
-        int c;
+static void
+sound_poll_flush(void)
+{
+    MTR_BEGIN("sound", "sound_poll");
+    sound_run_handlers(sound_handlers, sound_handlers_num, outbuffer, SOUNDBUFLEN);
 
-        memset(outbuffer_m, 0x00, MUSICBUFLEN * 2 * sizeof(int32_t));
+    record_audio(outbuffer, SOUNDBUFLEN);
 
-        for (c = 0; c < music_handlers_num; c++)
-            music_handlers[c].get_buffer(outbuffer_m, MUSICBUFLEN, music_handlers[c].priv);
+    sound_output_convert(outbuffer, outbuffer_ex, outbuffer_ex_int16, SOUNDBUFLEN);
 
-        for (c = 0; c < MUSICBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_m_ex[c] = ((float) outbuffer_m[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_m[c] > 32767)
-                    outbuffer_m[c] = 32767;
-                if (outbuffer_m[c] < -32768)
-                    outbuffer_m[c] = -32768;
+    if (sound_is_float)
+        givealbuffer(outbuffer_ex);
+    else
+        givealbuffer(outbuffer_ex_int16);
 
-                outbuffer_m_ex_int16[c] = (int16_t) outbuffer_m[c];
-            }
+    if (cd_thread_enable) {
+        cd_buf_update--;
+        if (!cd_buf_update) {
+            cd_buf_update = (SOUND_FREQ / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
+            thread_set_event(sound_cd_event);
         }
+    }
 
-        if (sound_is_float)
-            givealbuffer_music(outbuffer_m_ex);
-        else
-            givealbuffer_music(outbuffer_m_ex_int16);
+    if (fdd_thread_enable) {
+        thread_set_event(sound_fdd_event);
+    }
+    sound_pos_global = 0;
+    MTR_END("sound", "sound_poll");
+}
+
+/* Batched sample clock, called once with all the samples that have elapsed. */
+static void
+sound_poll(UNUSED(void *priv), uint32_t periods)
+{
+    while (periods--) {
+        midi_poll();
 
-        music_pos_global = 0;
+        sound_pos_global++;
+        if (sound_pos_global == SOUNDBUFLEN)
+            sound_poll_flush();
     }
 }
 
-void
-wavetable_poll(UNUSED(void *priv))
+static void
+music_poll_flush(void)
 {
-    timer_advance_u64(&wavetable_poll_timer, wavetable_poll_latch);
+    sound_run_handlers(music_handlers, music_handlers_num, outbuffer_m, MUSICBUFLEN);
 
-    wavetable_pos_global++;
-    if (wavetable_pos_global == WTBUFLEN) {
-        int c;
+    sound_output_convert(outbuffer_m, outbuffer_m_ex, outbuffer_m_ex_int16, MUSICBUFLEN);
 
-        memset(outbuffer_w, 0x00, WTBUFLEN * 2 * sizeof(int32_t));
+    if (sound_is_float)
+        givealbuffer_music(outbuffer_m_ex);
+    else
+        givealbuffer_music(outbuffer_m_ex_int16);
 
-        for (c = 0; c < wavetable_handlers_num; c++)
-            wavetable_handlers[c].get_buffer(outbuffer_w, WTBUFLEN, wavetable_handlers[c].priv);
+    music_pos_global = 0;
+}
 
-        for (c = 0; c < WTBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_w_ex[c] = ((float) outbuffer_w[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_w[c] > 32767)
-                    outbuffer_w[c] = 32767;
-                if (outbuffer_w[c] < -32768)
-                    outbuffer_w[c] = -32768;
+static void
+music_poll(UNUSED(void *priv), uint32_t periods)
+{
+    uint32_t left;
 
-                outbuffer_w_ex_int16[c] = (int16_t) outbuffer_w[c];
-            }
+    while (periods) {
+        left = MUSICBUFLEN - music_pos_global;
+        if (periods < left) {
+            music_pos_global += periods;
+            break;
         }
 
-        if (sound_is_float)
-            givealbuffer_wt(outbuffer_w_ex);
-        else
-            givealbuffer_wt(outbuffer_w_ex_int16);
+        periods -= left;
+        music_pos_global = MUSICBUFLEN;
+        music_poll_flush();
+    }
+}
+
+static void
+wavetable_poll_flush(void)
+{
+    sound_run_handlers(wavetable_handlers, wavetable_handlers_num, outbuffer_w, WTBUFLEN);
+
+    sound_output_convert(outbuffer_w, outbuffer_w_ex, outbuffer_w_ex_int16, WTBUFLEN);
 
-        wavetable_pos_global = 0;
+    if (sound_is_float)
+        givealbuffer_wt(outbuffer_w_ex);
+    else
+        givealbuffer_wt(outbuffer_w_ex_int16);
+
+    wavetable_pos_global = 0;
+}
+
+static void
+wavetable_poll(UNUSED(void *priv), uint32_t periods)
+{
+    uint32_t left;
+
+    while (periods) {
+        left = WTBUFLEN - wavetable_pos_global;
+        if (periods < left) {
+            wavetable_pos_global += periods;
+            break;
+        }
+
+        periods -= left;
+        wavetable_pos_global = WTBUFLEN;
+        wavetable_poll_flush();
     }
 }
 
@@ -696,6 +756,10 @@ sound_speed_changed(void)
     music_poll_latch = (uint64_t) ((double) TIMER_USEC * (1000000.0 / (double) MUSIC_FREQ));
 
     wavetable_poll_latch = (uint64_t) ((double) TIMER_USEC * (1000000.0 / (double) WT_FREQ));
+
+    timer_set_batch_period(&sound_poll_timer, sound_poll_latch);
+    timer_set_batch_period(&music_poll_timer, music_poll_latch);
+    timer_set_batch_period(&wavetable_poll_timer, wavetable_poll_latch);
 }
 
 void
@@ -712,15 +776,15 @@ sound_reset(void)
 
     inital();
 
-    timer_add(&sound_poll_timer, sound_poll, NULL, 1);
+    timer_add_batched(&sound_poll_timer, sound_poll, NULL, sound_poll_latch, 1);
     sound_handlers_num = 0;
     memset(sound_handlers, 0x00, 8 * sizeof(sound_handler_t));
 
-    timer_add(&music_poll_timer, music_poll, NULL, 1);
+    timer_add_batched(&music_poll_timer, music_poll, NULL, music_poll_latch, 1);
     music_handlers_num = 0;
     memset(music_handlers, 0x00, 8 * sizeof(sound_handler_t));
 
-    timer_add(&wavetable_poll_timer, wavetable_poll, NULL, 1);
+    timer_add_batched(&wavetable_poll_timer, wavetable_poll, NULL, wavetable_poll_latch, 1);
     wavetable_handlers_num = 0;
     memset(wavetable_handlers, 0x00, 8 * sizeof(sound_handler_t));
 
@@ -788,7 +852,7 @@ sound_cd_thread_reset(void)
         sound_cd_start_event = thread_create_event();
 
         sound_cd_event    = thread_create_event();
-        sound_cd_thread_h = thread_create(sound_cd_thread, NULL);
+        sound_cd_thread_h = thread_create_role(sound_cd_thread, NULL, THREAD_ROLE_AUDIO);
 
         thread_wait_event(sound_cd_start_event, -1);
         thread_reset_event(sound_cd_start_event);
@@ -825,7 +889,7 @@ sound_fdd_thread_init(void)
 
         sound_fdd_start_event = thread_create_event();
         sound_fdd_event = thread_create_event();
-        sound_fdd_thread_h = thread_create(sound_fdd_thread, NULL);
+        sound_fdd_thread_h = thread_create_role(sound_fdd_thread, NULL, THREAD_ROLE_AUDIO);
 
         thread_wait_event(sound_fdd_start_event, -1);
         thread_reset_event(sound_fdd_start_event);
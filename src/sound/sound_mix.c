@@ -0,0 +1,156 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Buffer mixing and output conversion helpers, used by the
+ *          sound core and available to the sound cards.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define SOUND_MIX_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define SOUND_MIX_NEON
+#endif
+#include <86box/86box.h>
+#include <86box/sound.h>
+#include <86box/filters.h>
+
+/* Add the samples of src to the ones in dst. */
+void
+sound_mix_add(int32_t *dst, const int32_t *src, int len)
+{
+    int c = 0;
+
+#if defined(SOUND_MIX_SSE2)
+    for (; c <= (len - 4); c += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *) &dst[c]);
+        __m128i s = _mm_loadu_si128((const __m128i *) &src[c]);
+        _mm_storeu_si128((__m128i *) &dst[c], _mm_add_epi32(d, s));
+    }
+#elif defined(SOUND_MIX_NEON)
+    for (; c <= (len - 4); c += 4)
+        vst1q_s32(&dst[c], vaddq_s32(vld1q_s32(&dst[c]), vld1q_s32(&src[c])));
+#endif
+
+    for (; c < len; c++)
+        dst[c] += src[c];
+}
+
+/* Add 16-bit samples to a 32-bit mixing buffer. */
+void
+sound_mix_add_int16(int32_t *dst, const int16_t *src, int len)
+{
+    int c = 0;
+
+#if defined(SOUND_MIX_SSE2)
+    for (; c <= (len - 8); c += 8) {
+        __m128i s  = _mm_loadu_si128((const __m128i *) &src[c]);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_si128((__m128i *) &dst[c],
+                         _mm_add_epi32(_mm_loadu_si128((const __m128i *) &dst[c]), lo));
+        _mm_storeu_si128((__m128i *) &dst[c + 4],
+                         _mm_add_epi32(_mm_loadu_si128((const __m128i *) &dst[c + 4]), hi));
+    }
+#elif defined(SOUND_MIX_NEON)
+    for (; c <= (len - 8); c += 8) {
+        int16x8_t s = vld1q_s16(&src[c]);
+        vst1q_s32(&dst[c], vaddq_s32(vld1q_s32(&dst[c]), vmovl_s16(vget_low_s16(s))));
+        vst1q_s32(&dst[c + 4], vaddq_s32(vld1q_s32(&dst[c + 4]), vmovl_s16(vget_high_s16(s))));
+    }
+#endif
+
+    for (; c < len; c++)
+        dst[c] += src[c];
+}
+
+/* Clamp a mixing buffer to 16-bit output samples. */
+void
+sound_mix_to_int16(int16_t *dst, const int32_t *src, int len)
+{
+    int c = 0;
+
+#if defined(SOUND_MIX_SSE2)
+    /* The saturating pack is exactly the clamp to [-32768, 32767]. */
+    for (; c <= (len - 8); c += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i *) &src[c]);
+        __m128i hi = _mm_loadu_si128((const __m128i *) &src[c + 4]);
+        _mm_storeu_si128((__m128i *) &dst[c], _mm_packs_epi32(lo, hi));
+    }
+#elif defined(SOUND_MIX_NEON)
+    for (; c <= (len - 8); c += 8)
+        vst1q_s16(&dst[c], vcombine_s16(vqmovn_s32(vld1q_s32(&src[c])), vqmovn_s32(vld1q_s32(&src[c + 4]))));
+#endif
+
+    for (; c < len; c++) {
+        if (src[c] > 32767)
+            dst[c] = 32767;
+        else if (src[c] < -32768)
+            dst[c] = -32768;
+        else
+            dst[c] = (int16_t) src[c];
+    }
+}
+
+/* Scale a mixing buffer to float output samples, 32768 being full scale. */
+void
+sound_mix_to_float(float *dst, const int32_t *src, int len)
+{
+    int c = 0;
+
+    /* Multiplying by the power of two reciprocal is exact, so this matches
+       the division it replaces. */
+#if defined(SOUND_MIX_SSE2)
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    for (; c <= (len - 4); c += 4)
+        _mm_storeu_ps(&dst[c], _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &src[c])), scale));
+#elif defined(SOUND_MIX_NEON)
+    for (; c <= (len - 4); c += 4)
+        vst1q_f32(&dst[c], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&src[c])), 1.0f / 32768.0f));
+#endif
+
+    for (; c < len; c++)
+        dst[c] = ((float) src[c]) * (1.0f / 32768.0f);
+}
+
+float
+sound_fir_dot(const float *coef, const float *hist, int n)
+{
+    float sum = 0.0f;
+    int   c   = 0;
+
+#if defined(SOUND_MIX_SSE2)
+    __m128 acc = _mm_setzero_ps();
+
+    for (; c <= (n - 4); c += 4)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(&coef[c]), _mm_loadu_ps(&hist[c])));
+
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#elif defined(SOUND_MIX_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+
+    for (; c <= (n - 4); c += 4)
+        acc = vmlaq_f32(acc, vld1q_f32(&coef[c]), vld1q_f32(&hist[c]));
+
+    sum = vgetq_lane_f32(acc, 0) + vgetq_lane_f32(acc, 1) + vgetq_lane_f32(acc, 2) + vgetq_lane_f32(acc, 3);
+#endif
+
+    for (; c < n; c++)
+        sum += coef[c] * hist[c];
+
+    return sum;
+}
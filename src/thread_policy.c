@@ -0,0 +1,206 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Host CPU affinity and priority of the emulator threads.
+ *
+ *          Threads are created with a role (CPU, render, audio), and
+ *          the policy configured for that role is applied by the new
+ *          thread to itself before it runs, through the platform
+ *          plat_set_thread_affinity() and plat_set_thread_priority().
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+
+typedef struct thread_start_t {
+    void (*func)(void *param);
+    void *param;
+    int   role;
+} thread_start_t;
+
+thread_policy_t thread_policy[THREAD_ROLE_MAX];
+
+static const char *role_names[THREAD_ROLE_MAX] = { "", "cpu", "render", "audio" };
+static const char *prio_names[]                = { "default", "low", "normal", "high", "realtime" };
+
+#ifdef ENABLE_THREAD_POLICY_LOG
+int thread_policy_do_log = ENABLE_THREAD_POLICY_LOG;
+
+static void
+thread_policy_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (thread_policy_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define thread_policy_log(fmt, ...)
+#endif
+
+const char *
+thread_role_name(int role)
+{
+    return ((role > THREAD_ROLE_NONE) && (role < THREAD_ROLE_MAX)) ? role_names[role] : NULL;
+}
+
+const char *
+thread_priority_name(int prio)
+{
+    return ((prio >= THREAD_PRIO_DEFAULT) && (prio <= THREAD_PRIO_REALTIME)) ? prio_names[prio] : prio_names[0];
+}
+
+int
+thread_priority_from_name(const char *name)
+{
+    for (int i = THREAD_PRIO_DEFAULT; i <= THREAD_PRIO_REALTIME; i++) {
+        if (!strcmp(name, prio_names[i]))
+            return i;
+    }
+
+    return THREAD_PRIO_DEFAULT;
+}
+
+/* Parse a CPU list like "0-3,8,10-11" into mask, returns the number of CPUs set. */
+static int
+thread_parse_cpu_list(const char *s, uint64_t *mask)
+{
+    int   count = 0;
+    long  first;
+    long  last;
+    char *end;
+
+    while (*s) {
+        while ((*s == ' ') || (*s == ','))
+            s++;
+        if (!*s)
+            break;
+
+        first = strtol(s, &end, 10);
+        if (end == s)
+            return 0;
+        s    = end;
+        last = first;
+        if (*s == '-') {
+            s++;
+            last = strtol(s, &end, 10);
+            if (end == s)
+                return 0;
+            s = end;
+        }
+
+        for (long i = first; (i <= last) && (i < THREAD_MAX_CPUS); i++) {
+            if ((i >= 0) && !(mask[i >> 6] & (1ULL << (i & 63)))) {
+                mask[i >> 6] |= 1ULL << (i & 63);
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/* "nodeN" selects the CPUs of a NUMA node, as listed by the host. */
+static int
+thread_parse_affinity(const char *s, uint64_t *mask)
+{
+    unsigned node;
+
+    if (sscanf(s, "node%u", &node) == 1) {
+#ifdef __linux__
+        char  path[64];
+        char  list[1024];
+        FILE *fp;
+        int   ret = 0;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+        if ((fp = fopen(path, "r")) == NULL)
+            return 0;
+        if (fgets(list, sizeof(list), fp) != NULL) {
+            list[strcspn(list, "\r\n")] = '\0';
+            ret = thread_parse_cpu_list(list, mask);
+        }
+        fclose(fp);
+
+        return ret;
+#else
+        return 0;
+#endif
+    }
+
+    return thread_parse_cpu_list(s, mask);
+}
+
+/* Apply the policy of a role to the calling thread. */
+void
+thread_set_role(int role)
+{
+    const thread_policy_t *policy;
+    uint64_t               mask[THREAD_MAX_CPUS / 64] = { 0 };
+
+    if ((role <= THREAD_ROLE_NONE) || (role >= THREAD_ROLE_MAX))
+        return;
+
+    policy = &thread_policy[role];
+
+    if (policy->affinity[0]) {
+        if (!thread_parse_affinity(policy->affinity, mask))
+            pclog("Thread policy: invalid %s thread affinity \"%s\"\n", role_names[role], policy->affinity);
+        else if (!plat_set_thread_affinity(mask, THREAD_MAX_CPUS))
+            pclog("Thread policy: could not set %s thread affinity to \"%s\"\n", role_names[role], policy->affinity);
+        else
+            thread_policy_log("Thread policy: %s thread affinity set to \"%s\"\n", role_names[role], policy->affinity);
+    }
+
+    if (policy->priority != THREAD_PRIO_DEFAULT) {
+        if (!plat_set_thread_priority(policy->priority))
+            pclog("Thread policy: could not set %s thread priority to %s\n", role_names[role], prio_names[policy->priority]);
+        else
+            thread_policy_log("Thread policy: %s thread priority set to %s\n", role_names[role], prio_names[policy->priority]);
+    }
+}
+
+static void
+thread_role_start(void *priv)
+{
+    thread_start_t start = *(thread_start_t *) priv;
+
+    free(priv);
+
+    thread_set_role(start.role);
+    start.func(start.param);
+}
+
+thread_t *
+thread_create_named_role(void (*func)(void *param), void *param, const char *name, int role)
+{
+    thread_start_t *start;
+
+    if ((role <= THREAD_ROLE_NONE) || (role >= THREAD_ROLE_MAX) ||
+        (!thread_policy[role].affinity[0] && (thread_policy[role].priority == THREAD_PRIO_DEFAULT)))
+        return thread_create_named(func, param, name);
+
+    start        = (thread_start_t *) malloc(sizeof(thread_start_t));
+    start->func  = func;
+    start->param = param;
+    start->role  = role;
+
+    return thread_create_named(thread_role_start, start, name);
+}
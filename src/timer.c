@@ -1,90 +1,214 @@
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/timer.h>
+#include <86box/device.h>
+#include <86box/device_prof.h>
+#include <86box/plat.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 
+#include <minitrace/minitrace.h>
+
 uint64_t TIMER_USEC;
 uint32_t timer_target;
 
-/*Enabled timers are stored in a linked list, with the first timer to expire at
-  the head.*/
-pc_timer_t *timer_head = NULL;
+/*Enabled timers are stored in a 4-ary min-heap, with the first timer to expire
+  at the root. Each timer keeps its 1-based position in the heap so it can be
+  removed or rescheduled in O(log n) without searching for it. Timers expiring
+  at the same timestamp are ordered most recently enabled first, matching the
+  behaviour of the old sorted linked list.*/
+#define TIMER_HEAP_ARITY 4
+
+/*All the scheduler state lives in one structure, so that it can later be made
+  per-machine rather than per-process.*/
+typedef struct timer_sched_t {
+    pc_timer_t **heap;
+    uint32_t     count;
+    uint32_t     size;
+    uint32_t     seq;
+} timer_sched_t;
+
+static timer_sched_t timer_sched = { 0 };
 
 /* Are we initialized? */
 int timer_inited = 0;
 
+/* (O) Profile timer callbacks and dump the results on exit. */
+int timer_profile = 0;
+
+/* Callbacks run since startup. */
+uint64_t timer_callback_count = 0;
+
+/*Profiling statistics, one entry per callback/private data pair, kept in a
+  small open-addressed hash table.*/
+#define TIMER_PROF_SIZE 1024
+
+typedef struct timer_prof_t {
+    void      (*callback)(void *priv);
+    void       *priv;
+    const char *name;
+    uint64_t    fires;
+    uint64_t    total_ns;
+    uint64_t    max_ns;
+    uint64_t    rearms;
+    uint64_t    rearm_total; /* 32:32 */
+    uint64_t    rearm_max;   /* 32:32 */
+} timer_prof_t;
+
+static timer_prof_t timer_prof[TIMER_PROF_SIZE];
+
 static void timer_advance_ex(pc_timer_t *timer, int start);
 
+/*True if timer a has to fire before timer b*/
+static __inline int
+timer_heap_before(pc_timer_t *a, pc_timer_t *b)
+{
+    int64_t diff = (int64_t) (a->ts.ts64 - b->ts.ts64);
+
+    if (diff != 0)
+        return diff < 0;
+
+    return (int32_t) (a->seq - b->seq) > 0;
+}
+
+static __inline void
+timer_heap_place(pc_timer_t *timer, uint32_t pos)
+{
+    timer_sched.heap[pos] = timer;
+    timer->heap_pos = pos + 1;
+}
+
+static void
+timer_heap_sift_up(uint32_t pos)
+{
+    pc_timer_t *timer = timer_sched.heap[pos];
+    uint32_t    parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / TIMER_HEAP_ARITY;
+        if (!timer_heap_before(timer, timer_sched.heap[parent]))
+            break;
+        timer_heap_place(timer_sched.heap[parent], pos);
+        pos = parent;
+    }
+
+    timer_heap_place(timer, pos);
+}
+
+static void
+timer_heap_sift_down(uint32_t pos)
+{
+    pc_timer_t *timer = timer_sched.heap[pos];
+    uint32_t    child;
+    uint32_t    best;
+    uint32_t    last;
+
+    while (1) {
+        child = (pos * TIMER_HEAP_ARITY) + 1;
+        if (child >= timer_sched.count)
+            break;
+
+        last = child + TIMER_HEAP_ARITY;
+        if (last > timer_sched.count)
+            last = timer_sched.count;
+
+        best = child;
+        for (child++; child < last; child++) {
+            if (timer_heap_before(timer_sched.heap[child], timer_sched.heap[best]))
+                best = child;
+        }
+
+        if (!timer_heap_before(timer_sched.heap[best], timer))
+            break;
+
+        timer_heap_place(timer_sched.heap[best], pos);
+        pos = best;
+    }
+
+    timer_heap_place(timer, pos);
+}
+
+static void
+timer_heap_remove(pc_timer_t *timer)
+{
+    uint32_t    pos  = timer->heap_pos - 1;
+    pc_timer_t *last = timer_sched.heap[--timer_sched.count];
+
+    timer->heap_pos = 0;
+
+    if (pos == timer_sched.count)
+        return;
+
+    timer_heap_place(last, pos);
+    if ((pos > 0) && timer_heap_before(last, timer_sched.heap[(pos - 1) / TIMER_HEAP_ARITY]))
+        timer_heap_sift_up(pos);
+    else
+        timer_heap_sift_down(pos);
+}
+
+static __inline void
+timer_update_target(void)
+{
+    if (timer_sched.count)
+        timer_target = timer_sched.heap[0]->ts.ts32.integer;
+}
+
 void
 timer_enable(pc_timer_t *timer)
 {
-    pc_timer_t *timer_node = timer_head;
-    int ret = 0;
+    uint32_t pos;
 
     if (!timer_inited || (timer == NULL))
         return;
 
-    if (timer->flags & TIMER_ENABLED)
-        timer_disable(timer);
+    timer->seq = timer_sched.seq++;
 
-    if (timer->next || timer->prev)
-        fatal("timer_disable(): Attempting to enable a non-isolated "
-              "timer incorrectly marked as disabled\n");
+    if (timer->flags & TIMER_ENABLED) {
+        if ((timer->heap_pos == 0) || (timer->heap_pos > timer_sched.count) ||
+            (timer_sched.heap[timer->heap_pos - 1] != timer))
+            fatal("timer_enable(): Attempting to reschedule a timer "
+                  "incorrectly marked as enabled\n");
 
-    /*List currently empty - add to head*/
-    if (!timer_head) {
-        timer_head  = timer;
-        timer->next = timer->prev = NULL;
-        timer_target              = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (TIMER_LESS_THAN(timer, timer_head)) {
-        timer->next      = timer_head;
-        timer->prev      = NULL;
-        timer_head->prev = timer;
-        timer_head       = timer;
-        timer_target     = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (!timer_head->next) {
-        timer_head->next = timer;
-        timer->prev      = timer_head;
-        ret = 1;
+        /* Already queued - just move it to its new place in the heap. */
+        timer->in_callback = 0;
+
+        pos = timer->heap_pos - 1;
+        if ((pos > 0) && timer_heap_before(timer, timer_sched.heap[(pos - 1) / TIMER_HEAP_ARITY]))
+            timer_heap_sift_up(pos);
+        else
+            timer_heap_sift_down(pos);
+
+        timer_update_target();
+        return;
     }
 
-    if (ret == 0) {
-        pc_timer_t *prev = timer_head;
-        timer_node       = timer_head->next;
-
-        while (1) {
-            /*Timer expires before timer_node. Add to list in front of timer_node*/
-            if (TIMER_LESS_THAN(timer, timer_node)) {
-                timer->next      = timer_node;
-                timer->prev      = prev;
-                timer_node->prev = timer;
-                prev->next       = timer;
-                ret = 1;
-                break;
-            }
-
-            /*timer_node is last in the list. Add timer to end of list*/
-            if (!timer_node->next) {
-                timer_node->next = timer;
-                timer->prev      = timer_node;
-                ret = 1;
-                break;
-            }
-
-            prev       = timer_node;
-            timer_node = timer_node->next;
-        }
+    if (timer->heap_pos)
+        fatal("timer_enable(): Attempting to enable a non-isolated "
+              "timer incorrectly marked as disabled\n");
+
+    if (timer_sched.count == timer_sched.size) {
+        pc_timer_t **heap;
+        uint32_t     size = timer_sched.size ? (timer_sched.size << 1) : 64;
+
+        heap = (pc_timer_t **) realloc(timer_sched.heap, size * sizeof(pc_timer_t *));
+        if (heap == NULL)
+            fatal("timer_enable(): Unable to grow the timer heap to %u entries\n", size);
+
+        timer_sched.heap = heap;
+        timer_sched.size = size;
     }
 
-    /* Do not mark it as enabled if it has failed every single condition. */
-    if (ret == 1)
-        timer->flags |= TIMER_ENABLED;
+    timer_sched.heap[timer_sched.count] = timer;
+    timer_heap_sift_up(timer_sched.count++);
+
+    timer->flags |= TIMER_ENABLED;
+
+    timer_update_target();
 }
 
 void
@@ -93,20 +217,143 @@ timer_disable(pc_timer_t *timer)
     if (!timer_inited || (timer == NULL) || !(timer->flags & TIMER_ENABLED))
         return;
 
-    if (!timer->next && !timer->prev && timer != timer_head)
+    if ((timer->heap_pos == 0) || (timer->heap_pos > timer_sched.count) ||
+        (timer_sched.heap[timer->heap_pos - 1] != timer))
         fatal("timer_disable(): Attempting to disable an isolated "
-              "non-head timer incorrectly marked as enabled\n");
+              "timer incorrectly marked as enabled\n");
 
     timer->flags &= ~TIMER_ENABLED;
     timer->in_callback = 0;
 
-    if (timer->prev)
-        timer->prev->next = timer->next;
+    timer_heap_remove(timer);
+    timer_update_target();
+}
+
+static void
+timer_run_batched(pc_timer_t *timer)
+{
+    /* Count every period whose integer timestamp has been reached, exactly as
+       many times as an unbatched timer would have fired by now. */
+    uint64_t late    = (((uint64_t) (uint32_t) tsc << 32) | 0xffffffffULL) - timer->ts.ts64;
+    uint64_t elapsed = (late / timer->batch_period) + 1;
+    uint32_t periods = (elapsed > 0xffffffffULL) ? 0xffffffff : (uint32_t) elapsed;
+
+    /* Re-arm first, so the callback is free to stop or reprogram the timer. */
+    timer_advance_u64(timer, periods * timer->batch_period);
+
+    timer->batch_callback(timer->priv, periods);
+}
+
+static __inline void
+timer_run_callback(pc_timer_t *timer)
+{
+    if (timer->flags & TIMER_BATCHED)
+        timer_run_batched(timer);
     else
-        timer_head = timer->next;
-    if (timer->next)
-        timer->next->prev = timer->prev;
-    timer->prev = timer->next = NULL;
+        timer->callback(timer->priv);
+}
+
+static timer_prof_t *
+timer_prof_find(pc_timer_t *timer)
+{
+    void        (*callback)(void *priv) = timer->callback;
+    uintptr_t     hash;
+    timer_prof_t *prof;
+
+    /* Batched timers are told apart by their batch callback. */
+    if (timer->flags & TIMER_BATCHED)
+        callback = (void (*)(void *)) (uintptr_t) timer->batch_callback;
+
+    hash = ((uintptr_t) callback ^ ((uintptr_t) timer->priv * 31)) >> 4;
+
+    for (uint32_t i = 0; i < TIMER_PROF_SIZE; i++) {
+        prof = &timer_prof[(hash + i) & (TIMER_PROF_SIZE - 1)];
+
+        if ((prof->callback == callback) && (prof->priv == timer->priv))
+            return prof;
+
+        if (prof->callback == NULL) {
+            prof->callback = callback;
+            prof->priv     = timer->priv;
+            prof->name     = device_get_name_by_priv(timer->priv);
+            return prof;
+        }
+    }
+
+    /* Table full, lump everything else into the last probed slot. */
+    return prof;
+}
+
+static void
+timer_prof_callback(pc_timer_t *timer)
+{
+    timer_prof_t *prof   = timer_prof_find(timer);
+    uint64_t      old_ts = timer->ts.ts64;
+    uint64_t      start  = plat_get_nsecs();
+    uint64_t      elapsed;
+    uint64_t      rearm;
+
+    timer_run_callback(timer);
+
+    elapsed = plat_get_nsecs() - start;
+
+    prof->fires++;
+    prof->total_ns += elapsed;
+    if (elapsed > prof->max_ns)
+        prof->max_ns = elapsed;
+
+    if (timer->flags & TIMER_ENABLED) {
+        rearm = timer->ts.ts64 - old_ts;
+        prof->rearms++;
+        prof->rearm_total += rearm;
+        if (rearm > prof->rearm_max)
+            prof->rearm_max = rearm;
+    }
+}
+
+static int
+timer_prof_compare(const void *a, const void *b)
+{
+    const timer_prof_t *pa = (const timer_prof_t *) a;
+    const timer_prof_t *pb = (const timer_prof_t *) b;
+
+    if (pa->total_ns == pb->total_ns)
+        return 0;
+
+    return (pa->total_ns < pb->total_ns) ? 1 : -1;
+}
+
+void
+timer_profile_dump(void)
+{
+    timer_prof_t *sorted;
+    timer_prof_t *prof;
+    uint32_t      count = 0;
+    double        usec  = TIMER_USEC ? (double) TIMER_USEC : 1.0;
+
+    if (!timer_profile)
+        return;
+
+    sorted = (timer_prof_t *) calloc(TIMER_PROF_SIZE, sizeof(timer_prof_t));
+    for (uint32_t i = 0; i < TIMER_PROF_SIZE; i++) {
+        if (timer_prof[i].fires)
+            sorted[count++] = timer_prof[i];
+    }
+    qsort(sorted, count, sizeof(timer_prof_t), timer_prof_compare);
+
+    always_log("Timer profile (%u callbacks, sorted by total host time):\n", count);
+    always_log("%-40s %-18s %12s %12s %12s %13s %13s\n", "Device", "Callback", "Fires",
+               "Mean (ns)", "Max (ns)", "Re-arm (us)", "Max re-arm");
+    for (uint32_t i = 0; i < count; i++) {
+        prof = &sorted[i];
+        always_log("%-40.40s %-18p %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %13.3f %13.3f\n",
+                   prof->name ? prof->name : "(unknown)", (void *) (uintptr_t) prof->callback,
+                   prof->fires, prof->total_ns / prof->fires, prof->max_ns,
+                   prof->rearms ? ((double) prof->rearm_total / (double) prof->rearms) / usec : 0.0,
+                   (double) prof->rearm_max / usec);
+    }
+
+    free(sorted);
 }
 
 void
@@ -114,54 +361,61 @@ timer_process(void)
 {
     pc_timer_t *timer;
 
-    if (!timer_head)
+    if (!timer_sched.count)
         return;
 
-    while (1) {
-        timer = timer_head;
+    MTR_BEGIN("timer", "timer_process");
+
+    while (timer_sched.count) {
+        timer = timer_sched.heap[0];
 
         if (!TIMER_LESS_THAN_VAL(timer, (uint32_t) tsc))
             break;
 
-        timer_head = timer->next;
-        if (timer_head)
-            timer_head->prev = NULL;
-
-        timer->next = timer->prev = NULL;
+        timer_heap_remove(timer);
         timer->flags &= ~TIMER_ENABLED;
 
         if (timer->flags & TIMER_SPLIT)
             timer_advance_ex(timer, 0);   /* We're splitting a > 1 s period into
                                                  multiple <= 1 s periods. */
-        else if (timer->callback != NULL) {
+        else if ((timer->flags & TIMER_BATCHED) ? (timer->batch_callback != NULL) : (timer->callback != NULL)) {
             /* Make sure it's not NULL, so that we can
                have a NULL callback when no operation
                is needed. */
             timer->in_callback = 1;
-            timer->callback(timer->priv);
+            timer_callback_count++;
+            if (device_profile) {
+                void    *priv  = timer->priv;
+                uint64_t start = plat_get_nsecs();
+
+                if (timer_profile)
+                    timer_prof_callback(timer);
+                else
+                    timer_run_callback(timer);
+                device_prof_add(priv, DEVICE_PROF_TIMER, start);
+            } else if (timer_profile)
+                timer_prof_callback(timer);
+            else
+                timer_run_callback(timer);
             timer->in_callback = 0;
         }
     }
 
-    timer_target = timer_head->ts.ts32.integer;
+    timer_update_target();
+
+    MTR_END("timer", "timer_process");
 }
 
 void
 timer_close(void)
 {
-    pc_timer_t *t = timer_head;
-    pc_timer_t *r;
-
-    /* Set all timers' prev and next to NULL so it is assured that
-       timers that are not in malloc'd structs don't keep pointing
-       to timers that may be in malloc'd structs. */
-    while (t != NULL) {
-        r       = t;
-        r->prev = r->next = NULL;
-        t                 = r->next;
-    }
+    /* Clear all timers' heap positions so it is assured that timers
+       that are not in malloc'd structs are not considered queued
+       when the timer system is brought back up. */
+    for (uint32_t i = 0; i < timer_sched.count; i++)
+        timer_sched.heap[i]->heap_pos = 0;
 
-    timer_head = NULL;
+    timer_sched.count = 0;
 
     timer_inited = 0;
 }
@@ -181,17 +435,46 @@ timer_init(void)
 void
 timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start_timer)
 {
+    /* Re-adding a queued timer must not leave a stale pointer in the heap. */
+    if ((timer->heap_pos != 0) && (timer->heap_pos <= timer_sched.count) &&
+        (timer_sched.heap[timer->heap_pos - 1] == timer)) {
+        timer_heap_remove(timer);
+        timer_update_target();
+    }
+
     memset(timer, 0, sizeof(pc_timer_t));
 
     timer->callback    = callback;
     timer->in_callback = 0;
     timer->priv        = priv;
     timer->flags       = 0;
-    timer->prev        = timer->next = NULL;
+    timer->heap_pos    = 0;
     if (start_timer)
         timer_set_delay_u64(timer, 0);
 }
 
+void
+timer_add_batched(pc_timer_t *timer, void (*callback)(void *priv, uint32_t periods),
+                  void *priv, uint64_t period, int start_timer)
+{
+    timer_add(timer, NULL, priv, 0);
+
+    timer->batch_callback = callback;
+    timer->batch_period   = period ? period : 1;
+    timer->flags          = TIMER_BATCHED;
+    if (start_timer)
+        timer_set_delay_u64(timer, 0);
+}
+
+void
+timer_set_batch_period(pc_timer_t *timer, uint64_t period)
+{
+    if (timer == NULL)
+        return;
+
+    timer->batch_period = period ? period : 1;
+}
+
 /* The API for big timer periods starts here. */
 void
 timer_stop(pc_timer_t *timer)
@@ -271,19 +554,19 @@ timer_set_new_tsc(uint64_t new_tsc)
         update_tsc();
 #endif
 
-    if (!timer_head) {
+    if (!timer_sched.count) {
         tsc = new_tsc;
         return;
     }
 
-    timer = timer_head;
-    timer_target = new_tsc + (int32_t)(timer_get_ts_int(timer_head) - (uint32_t)tsc);
+    timer_target = new_tsc + (int32_t)(timer_get_ts_int(timer_sched.heap[0]) - (uint32_t)tsc);
+
+    /* Every timer is shifted by the same amount, so the heap order is kept. */
+    for (uint32_t i = 0; i < timer_sched.count; i++) {
+        timer = timer_sched.heap[i];
 
-    while (timer) {
         int32_t offset_from_current_tsc = (int32_t)(timer_get_ts_int(timer) - (uint32_t)tsc);
         timer->ts.ts32.integer = new_tsc + offset_from_current_tsc;
-
-        timer = timer->next;
     }
 
     tsc = new_tsc;
@@ -41,6 +41,7 @@
 #include <86box/device.h>
 #include <86box/gameport.h>
 #include <86box/unix_sdl.h>
+#include <86box/unix_headless.h>
 #include <86box/unix_osd.h>
 #include "cpu.h"
 #include <86box/timer.h>
@@ -48,10 +49,19 @@
 #include <86box/version.h>
 #include <86box/video.h>
 #include <86box/ui.h>
+#include <86box/replay.h>
 #include <86box/gdbstub.h>
 
 #define __USE_GNU 1 /* shouldn't be done, yet it is */
 #include <pthread.h>
+#include <sched.h>
+#ifdef __linux__
+#    include <sys/resource.h>
+#    include <sys/syscall.h>
+#endif
+#ifdef __APPLE__
+#    include <pthread/qos.h>
+#endif
 
 extern SDL_Window         *sdl_win;
 
@@ -452,6 +462,47 @@ plat_munmap(void *ptr, size_t size)
     munmap(ptr, size);
 }
 
+/* Huge page sizes are 2 MB on the hosts we care about, round large mappings up
+   to that so that plat_munmap_large() can release what was actually mapped. */
+#define LARGE_PAGE_SIZE (2ULL << 20)
+
+void *
+plat_mmap_large(size_t size, uint8_t executable, const char *what)
+{
+    const char *backing = "normal pages";
+    void       *ret     = NULL;
+
+    size = (size + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+    ret = mmap(0, size, PROT_READ | PROT_WRITE | (executable ? PROT_EXEC : 0), MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+    if (ret == MAP_FAILED)
+        ret = NULL;
+    else
+        backing = "huge pages";
+#endif
+
+    if (ret == NULL) {
+        ret = plat_mmap(size, executable);
+        if ((ret == NULL) || (ret == MAP_FAILED))
+            return NULL;
+#ifdef MADV_HUGEPAGE
+        /* No reserved huge pages, let the kernel use transparent ones if it can. */
+        if (!madvise(ret, size, MADV_HUGEPAGE))
+            backing = "transparent huge pages";
+#endif
+    }
+
+    pclog("%s: %" PRIu64 " kB backed by %s\n", what, (uint64_t) (size >> 10), backing);
+
+    return ret;
+}
+
+void
+plat_munmap_large(void *ptr, size_t size)
+{
+    munmap(ptr, (size + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1));
+}
+
 uint64_t
 plat_timer_read(void)
 {
@@ -475,6 +526,21 @@ plat_get_ticks_common(void)
     return ElapsedMicroseconds;
 }
 
+uint64_t
+plat_get_nsecs(void)
+{
+    uint64_t elapsed;
+
+    if (first_use) {
+        Frequency    = SDL_GetPerformanceFrequency();
+        StartingTime = SDL_GetPerformanceCounter();
+        first_use    = 0;
+    }
+    elapsed = SDL_GetPerformanceCounter() - StartingTime;
+
+    return ((elapsed / Frequency) * 1000000000ULL) + (((elapsed % Frequency) * 1000000000ULL) / Frequency);
+}
+
 uint32_t
 plat_get_ticks(void)
 {
@@ -487,6 +553,12 @@ plat_remove(char *path)
     remove(path);
 }
 
+int
+plat_rename(const char *from, const char *to)
+{
+    return rename(from, to);
+}
+
 void ui_sb_update_icon_state(int tag, int state)
 {
     osd_ui_sb_update_icon_state(tag, state);
@@ -599,17 +671,21 @@ main_thread(UNUSED(void *param))
 #endif
 
         old_time = new_time;
+        /* Do not wait for real time to catch up while booting unpaced or replaying. */
+        if ((turbo_boot || (replay_mode == REPLAY_PLAY)) && (drawits <= 0))
+            drawits = 10;
         if (drawits > 0 && !dopause) {
             /* Yes, so do one frame now. */
-            drawits -= force_10ms ? 10 : 1;
             if (drawits > 50)
                 drawits = 0;
 
             /* Run a block of code. */
-            pc_run();
+            int frame_ms = pc_run(drawits);
+            drawits -= frame_ms;
 
-            /* Every 200 frames we save the machine status. */
-            if (++frames >= (force_10ms ? 200 : 2000) && nvr_dosave) {
+            /* Every 2 emulated seconds we save the machine status. */
+            frames += frame_ms;
+            if ((frames >= 2000) && nvr_dosave) {
                 nvr_save();
                 nvr_dosave = 0;
                 frames     = 0;
@@ -646,7 +722,7 @@ do_start(void)
     timer_freq = SDL_GetPerformanceFrequency();
 
     /* Start the emulator, really. */
-    thMain = thread_create(main_thread, NULL);
+    thMain = thread_create_role(main_thread, NULL, THREAD_ROLE_CPU);
 }
 
 void
@@ -670,7 +746,10 @@ do_stop(void)
     startblit();
 
     is_quit = 1;
-    sdl_close();
+    if (start_headless)
+        headless_close();
+    else
+        sdl_close();
 
     pc_close(thMain);
 
@@ -806,7 +885,7 @@ plat_pause(int p)
     if ((!!p) == dopause)
         return;
 
-    if ((p == 0) && (time_sync & TIME_SYNC_ENABLED))
+    if ((p == 0) && (time_sync & TIME_SYNC_ENABLED) && (replay_mode == REPLAY_OFF))
         nvr_time_sync();
 
     do_pause(p);
@@ -1363,9 +1442,12 @@ main(int argc, char **argv)
     } else
         fprintf(stderr, "libedit not found, line editing will be limited.\n");
     mousemutex = SDL_CreateMutex();
-    sdl_initho();
+    if (start_headless)
+        headless_init();
+    else
+        sdl_initho();
 
-    if (start_in_fullscreen) {
+    if (start_in_fullscreen && !start_headless) {
         video_fullscreen = 1;
         sdl_set_fs(1);
     }
@@ -1604,11 +1686,15 @@ main(int argc, char **argv)
             }
         }
 
+        /* There are no window events to wait on, so don't spin. */
+        if (start_headless)
+            SDL_Delay(10);
+
         if (blitreq) {
             extern void sdl_blit(int x, int y, int w, int h);
             sdl_blit(params.x, params.y, params.w, params.h);
         }
-        if (title_set) {
+        if (title_set && !start_headless) {
             extern void ui_window_title_real(void);
             ui_window_title_real();
         }
@@ -1616,7 +1702,7 @@ main(int argc, char **argv)
             sdl_set_fs(0);
             video_fullscreen = 0;
         }
-        if (fullscreen_pending) {
+        if (fullscreen_pending && !start_headless) {
             sdl_set_fs(video_fullscreen);
             fullscreen_pending = 0;
         }
@@ -1681,6 +1767,50 @@ plat_set_thread_name(void *thread, const char *name)
 #endif
 }
 
+int
+plat_set_thread_affinity(const uint64_t *mask, int max_cpus)
+{
+#ifdef __linux__
+    /* The kernel wants an array of longs, which is not a uint64_t array on 32-bit big endian. */
+    unsigned long kmask[THREAD_MAX_CPUS / (8 * sizeof(unsigned long))] = { 0 };
+
+    for (int i = 0; (i < max_cpus) && (i < THREAD_MAX_CPUS); i++) {
+        if (mask[i >> 6] & (1ULL << (i & 63)))
+            kmask[i / (8 * sizeof(unsigned long))] |= 1UL << (i % (8 * sizeof(unsigned long)));
+    }
+
+    return !syscall(SYS_sched_setaffinity, 0, sizeof(kmask), kmask);
+#else
+    /* No thread affinity on this host. */
+    (void) mask;
+    (void) max_cpus;
+    return 0;
+#endif
+}
+
+int
+plat_set_thread_priority(int prio)
+{
+    struct sched_param param = { 0 };
+
+    if (prio == THREAD_PRIO_REALTIME) {
+        param.sched_priority = sched_get_priority_min(SCHED_RR);
+        return !pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+    }
+
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+#if defined(__linux__)
+    /* Linux keeps a nice value per thread. */
+    return !setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid),
+                        (prio == THREAD_PRIO_LOW) ? 10 : ((prio == THREAD_PRIO_HIGH) ? -5 : 0));
+#elif defined(__APPLE__)
+    return !pthread_set_qos_class_self_np((prio == THREAD_PRIO_LOW) ? QOS_CLASS_UTILITY :
+                                          ((prio == THREAD_PRIO_HIGH) ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_USER_INITIATED), 0);
+#else
+    return (prio == THREAD_PRIO_NORMAL);
+#endif
+}
+
 /* Converts the numeric language ID to a language code string */
 void
 plat_language_code_r(UNUSED(int id), UNUSED(char *outbuf), UNUSED(int len))
@@ -35,6 +35,7 @@
 #include <86box/scsi_disk.h>
 #include <86box/plat.h>
 #include <86box/ui.h>
+#include <86box/replay.h>
 
 void
 cassette_mount(char *fn, uint8_t wp)
@@ -95,6 +96,9 @@ cartridge_eject(uint8_t id)
 void
 floppy_mount(uint8_t id, char *fn, uint8_t wp)
 {
+    if (replay_media(REPLAY_MEDIA_FLOPPY, id, fn, wp))
+        return;
+
     fdd_close(id);
     ui_writeprot[id] = wp;
     fdd_load(id, fn);
@@ -109,6 +113,9 @@ floppy_mount(uint8_t id, char *fn, uint8_t wp)
 void
 floppy_eject(uint8_t id)
 {
+    if (replay_media(REPLAY_MEDIA_FLOPPY, id, "", 0))
+        return;
+
     fdd_close(id);
 
     ui_sb_update_icon_state(SB_FLOPPY | id, 1);
@@ -135,6 +142,9 @@ plat_cdrom_ui_update(uint8_t id, UNUSED(uint8_t reload))
 void
 cdrom_mount(uint8_t id, char *fn)
 {
+    if (replay_media(REPLAY_MEDIA_CDROM, id, fn, 0))
+        return;
+
     int ret = cdrom_load( &(cdrom[id]), fn, 0);
 
     plat_cdrom_ui_update(id, 0);
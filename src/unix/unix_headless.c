@@ -0,0 +1,55 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Headless renderer for the SDL frontend, which never copies
+ *          or presents frames and only reads the target buffer when a
+ *          screenshot has been requested.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/video.h>
+#include <86box/unix_headless.h>
+
+static void
+headless_blit(int x, int y, int w, int h, int monitor_index)
+{
+    const bitmap_t *b = monitors[monitor_index].target_buffer;
+
+    /* The card has already rendered the frame into its target buffer, so a
+       screenshot can be taken straight from there without a staging copy. */
+    if (monitors[monitor_index].mon_screenshots && (b != NULL) &&
+        (x >= 0) && (y >= 0) && (w > 0) && (h > 0) && ((x + w) <= b->w) && ((y + h) <= b->h))
+        video_screenshot_monitor(b->dat, x, y, b->w, monitor_index);
+
+    video_blit_complete_monitor(monitor_index);
+}
+
+int
+headless_init(void)
+{
+    fprintf(stderr, "Headless: no display, frames are only rendered for screenshots\n");
+
+    /* Register our renderer! */
+    video_setblit(headless_blit);
+
+    return 1;
+}
+
+void
+headless_close(void)
+{
+    /* Unregister our renderer! */
+    video_setblit(NULL);
+}
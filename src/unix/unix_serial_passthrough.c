@@ -77,7 +77,7 @@ plat_serpt_set_line_state(void *priv)
 }
 
 int
-plat_serpt_read(void *priv, uint8_t *data)
+plat_serpt_read(void *priv, uint8_t *data, int len)
 {
     serial_passthrough_t *dev = (serial_passthrough_t *) priv;
     int                   res;
@@ -86,10 +86,8 @@ plat_serpt_read(void *priv, uint8_t *data)
 
     switch (dev->mode) {
         case SERPT_MODE_HOSTSER: {
-            if (read(dev->master_fd, data, 1) > 0) {
-                return 1;
-            }
-            return 0;
+            res = read(dev->master_fd, data, len);
+            return (res > 0) ? res : 0;
         }
         case SERPT_MODE_VCON:
             FD_ZERO(&rdfds);
@@ -102,9 +100,9 @@ plat_serpt_read(void *priv, uint8_t *data)
                 return 0;
             }
 
-            if (read(dev->master_fd, data, 1) > 0) {
-                return 1;
-            }
+            res = read(dev->master_fd, data, len);
+            if (res > 0)
+                return res;
             break;
         default:
             break;
@@ -125,13 +123,13 @@ plat_serpt_close(void *priv)
 }
 
 static void
-plat_serpt_write_vcon(serial_passthrough_t *dev, uint8_t data)
+plat_serpt_write_vcon(serial_passthrough_t *dev, const uint8_t *data, int len)
 {
 #if 0
     fd_set wrfds;
     int    res;
 #endif
-    size_t res;
+    ssize_t res;
 
     /* We cannot use select here, this would block the hypervisor! */
 #if 0
@@ -147,11 +145,16 @@ plat_serpt_write_vcon(serial_passthrough_t *dev, uint8_t data)
 
     /* just write it out */
     if (dev->mode == SERPT_MODE_HOSTSER) {
-        do {
-            res = write(dev->master_fd, &data, 1);
-        } while (res == 0 || (res == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)));
+        while (len > 0) {
+            res = write(dev->master_fd, data, len);
+            if (res > 0) {
+                data += res;
+                len -= res;
+            } else if ((res == -1) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+                break;
+        }
     } else
-        res = write(dev->master_fd, &data, 1);
+        res = write(dev->master_fd, data, len);
 }
 
 void
@@ -229,14 +232,14 @@ plat_serpt_set_params(void *priv)
 }
 
 void
-plat_serpt_write(void *priv, uint8_t data)
+plat_serpt_write(void *priv, const uint8_t *data, int len)
 {
     serial_passthrough_t *dev = (serial_passthrough_t *) priv;
 
     switch (dev->mode) {
         case SERPT_MODE_VCON:
         case SERPT_MODE_HOSTSER:
-            plat_serpt_write_vcon(dev, data);
+            plat_serpt_write_vcon(dev, data, len);
             break;
         default:
             break;
@@ -6,8 +6,8 @@
  *
  *          This file is part of the 86Box distribution.
  *
- *          Universal Serial Bus emulation (currently dummy UHCI and
- *          OHCI).
+ *          Universal Serial Bus emulation (UHCI and OHCI host
+ *          controllers, no devices attached yet).
  *
  * Authors: Miran Grca, <mgrca8@gmail.com>
  *
@@ -24,6 +24,8 @@
 #include <86box/device.h>
 #include <86box/io.h>
 #include <86box/mem.h>
+#include <86box/timer.h>
+#include <86box/pci.h>
 #include <86box/usb.h>
 #include "cpu.h"
 #include <86box/plat_unused.h>
@@ -46,17 +48,260 @@ usb_log(const char *fmt, ...)
 #    define usb_log(fmt, ...)
 #endif
 
+#define USB_FRAME_USEC        1000ULL
+#define USB_FRAME_PERIOD      (TIMER_USEC * USB_FRAME_USEC)
+
+#define UHCI_CMD_RS           0x0001
+#define UHCI_CMD_HCRESET      0x0002
+
+#define UHCI_STS_USBINT       0x0001
+#define UHCI_STS_ERROR        0x0002
+#define UHCI_STS_RESUME       0x0004
+#define UHCI_STS_HSE          0x0008
+#define UHCI_STS_HCPE         0x0010
+#define UHCI_STS_HALTED       0x0020
+
+#define UHCI_INTR_TIMEOUT     0x0001
+#define UHCI_INTR_RESUME      0x0002
+#define UHCI_INTR_IOC         0x0004
+#define UHCI_INTR_SHORT       0x0008
+
+#define UHCI_LINK_TERMINATE   0x00000001
+#define UHCI_LINK_QH          0x00000002
+#define UHCI_TD_ACTLEN        0x000007ff
+#define UHCI_TD_TIMEOUT       (1 << 18)
+#define UHCI_TD_STALLED       (1 << 22)
+#define UHCI_TD_ACTIVE        (1 << 23)
+#define UHCI_TD_IOC           (1 << 24)
+#define UHCI_TD_ERRORS        (3 << 27)
+
+/* Bound on the elements walked per frame, so a looping schedule cannot hang us. */
+#define UHCI_MAX_ELEMENTS     1024
+
+#define OHCI_CONTROL          0x04
+#define OHCI_CMDSTATUS        0x08
+#define OHCI_INTSTATUS        0x0c
+#define OHCI_INTENABLE        0x10
+#define OHCI_HCCA             0x18
+#define OHCI_CONTROL_HEAD     0x20
+#define OHCI_BULK_HEAD        0x28
+#define OHCI_DONE_HEAD        0x30
+#define OHCI_FMINTERVAL       0x34
+#define OHCI_FMNUMBER         0x3c
+
+#define OHCI_CTL_PLE          0x00000004
+#define OHCI_CTL_CLE          0x00000010
+#define OHCI_CTL_BLE          0x00000020
+#define OHCI_CTL_HCFS         0x000000c0
+#define OHCI_CTL_OPERATIONAL  0x00000080
+#define OHCI_CTL_IR           0x00000100
+
+#define OHCI_CMD_CLF          0x00000002
+#define OHCI_CMD_BLF          0x00000004
+
+#define OHCI_INT_WDH          0x00000002
+#define OHCI_INT_SF           0x00000004
+#define OHCI_INT_FNO          0x00000020
+#define OHCI_INT_MIE          0x80000000
+
+#define OHCI_ED_HALTED        0x00000001
+#define OHCI_ED_CARRY         0x00000002
+#define OHCI_ED_SKIP          (1 << 14)
+#define OHCI_ED_ISO           (1 << 15)
+
+#define OHCI_TD_CC_SHIFT      28
+#define OHCI_TD_DI_SHIFT      21
+#define OHCI_CC_NOT_RESPONDING 0x05
+#define OHCI_NO_DELAY         0x07
+
+#define OHCI_MAX_EDS          1024
+
+static void
+usb_update_irq(usb_t *dev)
+{
+    if (!dev->irq_pin)
+        return;
+
+    if (dev->uhci_irq || dev->ohci_irq)
+        pci_set_irq(dev->pci_slot, dev->irq_pin, &dev->irq_state);
+    else
+        pci_clear_irq(dev->pci_slot, dev->irq_pin, &dev->irq_state);
+}
+
+void
+usb_set_slot(usb_t *dev, uint8_t slot, uint8_t irq_pin)
+{
+    dev->pci_slot = slot;
+    dev->irq_pin  = irq_pin;
+}
+
+/* Frames of the pending timer period that have already gone by. */
+static uint32_t
+usb_frames_elapsed(pc_timer_t *timer, uint32_t batch)
+{
+    uint64_t left;
+
+    if ((batch <= 1) || !timer_is_enabled(timer))
+        return 0;
+
+    left = (timer_get_remaining_u64(timer) + USB_FRAME_PERIOD - 1) / USB_FRAME_PERIOD;
+
+    return (left < batch) ? (batch - (uint32_t) left) : 0;
+}
+
+/* Cut the pending period short at the end of the current frame, returning the
+   frames skipped; the guest may be about to change the schedule. */
+static uint32_t
+usb_frames_sync(pc_timer_t *timer, uint32_t *batch)
+{
+    uint32_t elapsed;
+    uint64_t remaining;
+
+    if ((*batch <= 1) || !timer_is_enabled(timer))
+        return 0;
+
+    elapsed   = usb_frames_elapsed(timer, *batch);
+    remaining = timer_get_remaining_u64(timer);
+    remaining -= (uint64_t) (*batch - elapsed - 1) * USB_FRAME_PERIOD;
+
+    *batch = 1;
+    timer_set_delay_u64(timer, remaining);
+
+    return elapsed;
+}
+
+static void
+uhci_update_irq(usb_t *dev)
+{
+    const uint16_t *regs = (uint16_t *) dev->uhci_io;
+    uint16_t        sts  = regs[0x01];
+    uint16_t        intr = regs[0x02];
+
+    dev->uhci_irq = ((sts & UHCI_STS_USBINT) && (intr & (UHCI_INTR_IOC | UHCI_INTR_SHORT))) ||
+                    ((sts & UHCI_STS_ERROR) && (intr & UHCI_INTR_TIMEOUT)) ||
+                    ((sts & UHCI_STS_RESUME) && (intr & UHCI_INTR_RESUME)) ||
+                    (sts & (UHCI_STS_HSE | UHCI_STS_HCPE));
+
+    usb_update_irq(dev);
+}
+
+static void
+uhci_sync(usb_t *dev)
+{
+    uint16_t *regs = (uint16_t *) dev->uhci_io;
+
+    regs[0x03] = (regs[0x03] + usb_frames_sync(&dev->uhci_frame_timer, &dev->uhci_batch)) & 0x07ff;
+}
+
+/* No device models exist yet, so every transaction goes unanswered and the
+   TD retires with a timeout, as it would on an empty port. */
+static int
+uhci_td_run(usb_t *dev, uint32_t addr)
+{
+    uint16_t *regs = (uint16_t *) dev->uhci_io;
+    uint32_t  ctrl = mem_readl_phys(addr + 4);
+
+    if (!(ctrl & UHCI_TD_ACTIVE))
+        return 0;
+
+    usb_log("UHCI: TD %08X timed out\n", addr);
+
+    ctrl &= ~(UHCI_TD_ACTIVE | UHCI_TD_ERRORS);
+    ctrl |= UHCI_TD_STALLED | UHCI_TD_TIMEOUT | UHCI_TD_ACTLEN;
+    mem_writel_phys(addr + 4, ctrl);
+
+    regs[0x01] |= UHCI_STS_ERROR;
+    if (ctrl & UHCI_TD_IOC)
+        regs[0x01] |= UHCI_STS_USBINT;
+
+    return 1;
+}
+
+/* Runs one frame's worth of schedule starting at link, returns 1 if an active
+   transfer descriptor was found. */
+static int
+uhci_walk(usb_t *dev, uint32_t link)
+{
+    uint32_t addr;
+    uint32_t element;
+    int      active = 0;
+
+    for (int n = 0; !(link & UHCI_LINK_TERMINATE) && (n < UHCI_MAX_ELEMENTS); n++) {
+        addr = link & 0xfffffff0;
+
+        if (link & UHCI_LINK_QH) {
+            /* A failed element TD is not advanced, it stays at the head of the queue. */
+            element = mem_readl_phys(addr + 4);
+            if (!(element & (UHCI_LINK_TERMINATE | UHCI_LINK_QH)))
+                active |= uhci_td_run(dev, element & 0xfffffff0);
+        } else
+            active |= uhci_td_run(dev, addr);
+
+        link = mem_readl_phys(addr);
+    }
+
+    return active;
+}
+
+static void
+uhci_frame_timer(void *priv)
+{
+    usb_t    *dev    = (usb_t *) priv;
+    uint16_t *regs   = (uint16_t *) dev->uhci_io;
+    uint32_t  base   = (dev->uhci_io[0x08] | (dev->uhci_io[0x09] << 8) |
+                        (dev->uhci_io[0x0a] << 16) | (dev->uhci_io[0x0b] << 24)) & 0xfffff000;
+    uint32_t  last   = 0;
+    uint32_t  link;
+    int       active = 0;
+
+    for (uint32_t i = 0; i < dev->uhci_batch; i++) {
+        link = mem_readl_phys(base + ((regs[0x03] & 0x03ff) << 2));
+
+        /* Idle frame lists mostly point at a few shared queue heads, walk each once. */
+        if ((i == 0) || (link != last))
+            active |= uhci_walk(dev, link);
+        last = link;
+
+        regs[0x03] = (regs[0x03] + 1) & 0x07ff;
+    }
+
+    uhci_update_irq(dev);
+
+    dev->uhci_batch = active ? 1 : USB_IDLE_FRAMES;
+    timer_advance_u64(&dev->uhci_frame_timer, dev->uhci_batch * USB_FRAME_PERIOD);
+}
+
+static void
+uhci_reset(usb_t *dev)
+{
+    timer_disable(&dev->uhci_frame_timer);
+    dev->uhci_batch = 1;
+
+    memset(dev->uhci_io, 0x00, sizeof(dev->uhci_io));
+    dev->uhci_io[0x0c] = 0x40;
+    dev->uhci_io[0x10] = dev->uhci_io[0x12] = 0x80;
+
+    uhci_update_irq(dev);
+}
+
 static uint8_t
 uhci_reg_read(uint16_t addr, void *priv)
 {
-    const usb_t   *dev = (usb_t *) priv;
+    usb_t         *dev = (usb_t *) priv;
     uint8_t        ret;
     const uint8_t *regs = dev->uhci_io;
+    uint16_t       frnum;
 
     addr &= 0x0000001f;
 
     ret = regs[addr];
 
+    if ((addr & 0x1e) == 0x06) {
+        frnum = (regs[0x06] | (regs[0x07] << 8));
+        frnum = (frnum + usb_frames_elapsed(&dev->uhci_frame_timer, dev->uhci_batch)) & 0x07ff;
+        ret   = (addr & 1) ? (frnum >> 8) : (frnum & 0xff);
+    }
+
     return ret;
 }
 
@@ -68,12 +313,16 @@ uhci_reg_write(uint16_t addr, uint8_t val, void *priv)
 
     addr &= 0x0000001f;
 
+    uhci_sync(dev);
+
     switch (addr) {
         case 0x02:
-            regs[0x02] &= ~(val & 0x3f);
+            regs[0x02] &= ~(val & 0x1f);
+            uhci_update_irq(dev);
             break;
         case 0x04:
             regs[0x04] = (val & 0x0f);
+            uhci_update_irq(dev);
             break;
         case 0x09:
             regs[0x09] = (val & 0xf0);
@@ -99,12 +348,22 @@ uhci_reg_writew(uint16_t addr, uint16_t val, void *priv)
 
     addr &= 0x0000001f;
 
+    uhci_sync(dev);
+
     switch (addr) {
         case 0x00:
-            if ((val & 0x0001) && !(regs[0x00] & 0x0001))
-                regs[0x01] &= ~0x20;
-            else if (!(val & 0x0001))
-                regs[0x01] |= 0x20;
+            if (val & UHCI_CMD_HCRESET) {
+                uhci_reset(dev);
+                break;
+            }
+            if ((val & UHCI_CMD_RS) && !(regs[0x00] & UHCI_CMD_RS)) {
+                regs[0x01] &= ~UHCI_STS_HALTED;
+                dev->uhci_batch = 1;
+                timer_set_delay_u64(&dev->uhci_frame_timer, USB_FRAME_PERIOD);
+            } else if (!(val & UHCI_CMD_RS)) {
+                regs[0x01] |= UHCI_STS_HALTED;
+                timer_disable(&dev->uhci_frame_timer);
+            }
             regs[0x00] = (val & 0x00ff);
             break;
         case 0x06:
@@ -134,16 +393,249 @@ uhci_update_io_mapping(usb_t *dev, uint8_t base_l, uint8_t base_h, int enable)
         io_sethandler(dev->uhci_io_base, 0x20, uhci_reg_read, NULL, NULL, uhci_reg_write, uhci_reg_writew, NULL, dev);
 }
 
+static __inline uint32_t
+ohci_reg(const usb_t *dev, int reg)
+{
+    return dev->ohci_mmio[reg] | (dev->ohci_mmio[reg + 1] << 8) |
+           (dev->ohci_mmio[reg + 2] << 16) | ((uint32_t) dev->ohci_mmio[reg + 3] << 24);
+}
+
+static __inline void
+ohci_set_reg(usb_t *dev, int reg, uint32_t val)
+{
+    dev->ohci_mmio[reg]     = val & 0xff;
+    dev->ohci_mmio[reg + 1] = (val >> 8) & 0xff;
+    dev->ohci_mmio[reg + 2] = (val >> 16) & 0xff;
+    dev->ohci_mmio[reg + 3] = (val >> 24) & 0xff;
+}
+
+static void
+ohci_update_irq(usb_t *dev)
+{
+    uint32_t enable = ohci_reg(dev, OHCI_INTENABLE);
+    int      level  = (enable & OHCI_INT_MIE) && (ohci_reg(dev, OHCI_INTSTATUS) & enable & ~OHCI_INT_MIE);
+
+    /* With InterruptRouting set the controller belongs to the SMM driver. */
+    if (ohci_reg(dev, OHCI_CONTROL) & OHCI_CTL_IR) {
+        if (level && !dev->ohci_smi)
+            smi_raise();
+        dev->ohci_smi = level;
+        level         = 0;
+    } else
+        dev->ohci_smi = 0;
+
+    dev->ohci_irq = level;
+    usb_update_irq(dev);
+}
+
+static void
+ohci_sync(usb_t *dev)
+{
+    uint32_t fn = ohci_reg(dev, OHCI_FMNUMBER);
+
+    fn += usb_frames_sync(&dev->ohci_frame_timer, &dev->ohci_batch);
+    ohci_set_reg(dev, OHCI_FMNUMBER, fn & 0xffff);
+}
+
+/* No device models exist yet, so the TD at the head of the ED retires with
+   DeviceNotResponding and, for general TDs, halts the endpoint. */
+static void
+ohci_retire_td(usb_t *dev, uint32_t ed, uint32_t head, int iso)
+{
+    uint32_t td    = head & 0xfffffff0;
+    uint32_t flags = mem_readl_phys(td);
+    uint32_t next  = mem_readl_phys(td + 0x08) & 0xfffffff0;
+    uint8_t  delay = (flags >> OHCI_TD_DI_SHIFT) & 0x07;
+
+    usb_log("OHCI: TD %08X on ED %08X not responding\n", td, ed);
+
+    mem_writel_phys(td, (flags & 0x0fffffff) | (OHCI_CC_NOT_RESPONDING << OHCI_TD_CC_SHIFT));
+    mem_writel_phys(td + 0x08, ohci_reg(dev, OHCI_DONE_HEAD));
+    ohci_set_reg(dev, OHCI_DONE_HEAD, td);
+    if (delay < dev->ohci_done_delay)
+        dev->ohci_done_delay = delay;
+
+    mem_writel_phys(ed + 0x08, next | (head & OHCI_ED_CARRY) | (iso ? 0 : OHCI_ED_HALTED));
+}
+
+/* Services the first TD of every ED on a list, returns 1 if any was found. */
+static int
+ohci_walk(usb_t *dev, uint32_t ed)
+{
+    uint32_t addr;
+    uint32_t flags;
+    uint32_t head;
+    uint32_t tail;
+    int      active = 0;
+
+    for (int n = 0; (ed & 0xfffffff0) && (n < OHCI_MAX_EDS); n++) {
+        addr  = ed & 0xfffffff0;
+        flags = mem_readl_phys(addr);
+        tail  = mem_readl_phys(addr + 0x04) & 0xfffffff0;
+        head  = mem_readl_phys(addr + 0x08);
+
+        if (!(flags & OHCI_ED_SKIP) && !(head & OHCI_ED_HALTED) && ((head & 0xfffffff0) != tail)) {
+            ohci_retire_td(dev, addr, head, flags & OHCI_ED_ISO);
+            active = 1;
+        }
+
+        ed = mem_readl_phys(addr + 0x0c);
+    }
+
+    return active;
+}
+
+/* End of frame: count down the done queue interrupt delay and write the queue
+   back to the HCCA once it expires. */
+static void
+ohci_frame_done(usb_t *dev, uint32_t hcca, uint32_t *status)
+{
+    uint32_t head = ohci_reg(dev, OHCI_DONE_HEAD);
+
+    if (!head || (dev->ohci_done_delay == OHCI_NO_DELAY))
+        return;
+
+    if (dev->ohci_done_delay == 0) {
+        if (*status & OHCI_INT_WDH)
+            return;
+
+        if (*status & ohci_reg(dev, OHCI_INTENABLE) & ~(OHCI_INT_WDH | OHCI_INT_MIE))
+            head |= 1;
+        mem_writel_phys(hcca + 0x84, head);
+
+        ohci_set_reg(dev, OHCI_DONE_HEAD, 0);
+        dev->ohci_done_delay = OHCI_NO_DELAY;
+        *status |= OHCI_INT_WDH;
+    } else
+        dev->ohci_done_delay--;
+}
+
+static void
+ohci_frame_timer(void *priv)
+{
+    usb_t   *dev     = (usb_t *) priv;
+    uint32_t hcca    = ohci_reg(dev, OHCI_HCCA) & 0xffffff00;
+    uint32_t control = ohci_reg(dev, OHCI_CONTROL);
+    uint32_t cmd     = ohci_reg(dev, OHCI_CMDSTATUS);
+    uint32_t status  = ohci_reg(dev, OHCI_INTSTATUS);
+    uint16_t frame   = ohci_reg(dev, OHCI_FMNUMBER) & 0xffff;
+    uint32_t last    = 0;
+    uint32_t ed;
+    uint32_t batch;
+    int      active  = 0;
+
+    for (uint32_t i = 0; i < dev->ohci_batch; i++) {
+        if ((frame ^ (frame + 1)) & 0x8000)
+            status |= OHCI_INT_FNO;
+        frame++;
+        status |= OHCI_INT_SF;
+
+        if (control & OHCI_CTL_PLE) {
+            ed = mem_readl_phys(hcca + ((frame & 0x1f) << 2));
+
+            /* The interrupt tree converges quickly, walk each distinct entry once. */
+            if ((i == 0) || (ed != last))
+                active |= ohci_walk(dev, ed);
+            last = ed;
+        }
+
+        if ((control & OHCI_CTL_CLE) && (cmd & OHCI_CMD_CLF)) {
+            if (ohci_walk(dev, ohci_reg(dev, OHCI_CONTROL_HEAD)))
+                active = 1;
+            else
+                cmd &= ~OHCI_CMD_CLF;
+        }
+
+        if ((control & OHCI_CTL_BLE) && (cmd & OHCI_CMD_BLF)) {
+            if (ohci_walk(dev, ohci_reg(dev, OHCI_BULK_HEAD)))
+                active = 1;
+            else
+                cmd &= ~OHCI_CMD_BLF;
+        }
+
+        ohci_frame_done(dev, hcca, &status);
+    }
+
+    mem_writel_phys(hcca + 0x80, frame);
+
+    ohci_set_reg(dev, OHCI_FMNUMBER, frame);
+    ohci_set_reg(dev, OHCI_CMDSTATUS, cmd);
+    ohci_set_reg(dev, OHCI_INTSTATUS, status);
+    ohci_update_irq(dev);
+
+    /* Stay on single frames while anything can observe them. */
+    if (active || (ohci_reg(dev, OHCI_DONE_HEAD) && (dev->ohci_done_delay != OHCI_NO_DELAY)) ||
+        (ohci_reg(dev, OHCI_INTENABLE) & OHCI_INT_SF))
+        batch = 1;
+    else {
+        batch = 0x8000 - (frame & 0x7fff);
+        if (batch > USB_IDLE_FRAMES)
+            batch = USB_IDLE_FRAMES;
+    }
+
+    dev->ohci_batch = batch;
+    timer_advance_u64(&dev->ohci_frame_timer, batch * USB_FRAME_PERIOD);
+}
+
+static void
+ohci_update_frame_timer(usb_t *dev)
+{
+    if ((ohci_reg(dev, OHCI_CONTROL) & OHCI_CTL_HCFS) == OHCI_CTL_OPERATIONAL) {
+        if (!timer_is_enabled(&dev->ohci_frame_timer)) {
+            dev->ohci_batch = 1;
+            timer_set_delay_u64(&dev->ohci_frame_timer, USB_FRAME_PERIOD);
+        }
+    } else
+        timer_disable(&dev->ohci_frame_timer);
+}
+
+static void
+ohci_reset(usb_t *dev)
+{
+    timer_disable(&dev->ohci_frame_timer);
+    dev->ohci_batch      = 1;
+    dev->ohci_done_delay = OHCI_NO_DELAY;
+
+    memset(dev->ohci_mmio, 0x00, sizeof(dev->ohci_mmio));
+    dev->ohci_mmio[0x00] = 0x10;
+    dev->ohci_mmio[0x01] = 0x01;
+    dev->ohci_mmio[0x48] = 0x02;
+    ohci_set_reg(dev, OHCI_FMINTERVAL, 0x00002edf);
+    dev->ohci_mmio[0x44] = 0x28;
+    dev->ohci_mmio[0x45] = 0x06;
+
+    ohci_update_irq(dev);
+}
+
 static uint8_t
 ohci_mmio_read(uint32_t addr, void *priv)
 {
-    const usb_t  *dev = (usb_t *) priv;
+    usb_t        *dev = (usb_t *) priv;
     uint8_t       ret = 0x00;
+    uint32_t      val;
+    uint32_t      fi;
 
     addr &= 0x00000fff;
 
     ret = dev->ohci_mmio[addr];
 
+    if ((addr >= 0x14) && (addr <= 0x17)) {
+        /* HcInterruptDisable reads back the enabled interrupts. */
+        ret = dev->ohci_mmio[addr - 4];
+    } else if ((addr >= 0x38) && (addr <= 0x3b)) {
+        /* HcFmRemaining, bit times left in the current frame. */
+        fi  = ohci_reg(dev, OHCI_FMINTERVAL);
+        val = 0;
+        if (timer_is_enabled(&dev->ohci_frame_timer))
+            val = (uint32_t) (((timer_get_remaining_u64(&dev->ohci_frame_timer) % USB_FRAME_PERIOD) *
+                              ((fi & 0x3fff) + 1)) / USB_FRAME_PERIOD);
+        val |= (fi & 0x80000000);
+        ret = (val >> ((addr & 3) << 3)) & 0xff;
+    } else if ((addr == 0x3c) || (addr == 0x3d)) {
+        val = ohci_reg(dev, OHCI_FMNUMBER) + usb_frames_elapsed(&dev->ohci_frame_timer, dev->ohci_batch);
+        ret = (val >> ((addr & 1) << 3)) & 0xff;
+    }
+
     if (addr == 0x101)
         ret = (ret & 0xfe) | (!!mem_a20_key);
 
@@ -158,13 +650,22 @@ ohci_mmio_write(uint32_t addr, uint8_t val, void *priv)
 
     addr &= 0x00000fff;
 
+    if (addr < 0x40)
+        ohci_sync(dev);
+
     switch (addr) {
         case 0x04:
             if ((val & 0xc0) == 0x00) {
                 /* UsbReset */
                 dev->ohci_mmio[0x56] = dev->ohci_mmio[0x5a] = 0x16;
             }
-            break;
+            dev->ohci_mmio[addr] = val;
+            ohci_update_frame_timer(dev);
+            return;
+        case 0x05:
+            dev->ohci_mmio[addr] = (val & 0x07);
+            ohci_update_irq(dev);
+            return;
         case 0x08: /* HCCOMMANDSTATUS */
             /* bit OwnershipChangeRequest triggers an ownership change (SMM <-> OS) */
             if (val & 0x08) {
@@ -175,21 +676,29 @@ ohci_mmio_write(uint32_t addr, uint8_t val, void *priv)
 
             /* bit HostControllerReset must be cleared for the controller to be seen as initialized */
             if (val & 0x01) {
-                memset(dev->ohci_mmio, 0x00, 4096);
-                dev->ohci_mmio[0x00] = 0x10;
-                dev->ohci_mmio[0x01] = 0x01;
-                dev->ohci_mmio[0x48] = 0x02;
+                ohci_reset(dev);
                 val &= ~0x01;
             }
-            break;
+            dev->ohci_mmio[addr] |= (val & 0x0e);
+            return;
         case 0x0c:
             dev->ohci_mmio[addr] &= ~(val & 0x7f);
+            ohci_update_irq(dev);
             return;
         case 0x0d:
         case 0x0e:
             return;
         case 0x0f:
             dev->ohci_mmio[addr] &= ~(val & 0x40);
+            ohci_update_irq(dev);
+            return;
+        case 0x10 ... 0x13:
+            dev->ohci_mmio[addr] |= val;
+            ohci_update_irq(dev);
+            return;
+        case 0x14 ... 0x17:
+            dev->ohci_mmio[addr - 4] &= ~val;
+            ohci_update_irq(dev);
             return;
         case 0x3b:
             dev->ohci_mmio[addr] = (val & 0x80);
@@ -202,6 +711,8 @@ ohci_mmio_write(uint32_t addr, uint8_t val, void *priv)
             dev->ohci_mmio[addr] = (val & 0x0f);
             return;
         case 0x3a:
+        case 0x3c:
+        case 0x3d:
         case 0x3e:
         case 0x3f:
         case 0x42:
@@ -371,14 +882,8 @@ usb_reset(void *priv)
 {
     usb_t *dev = (usb_t *) priv;
 
-    memset(dev->uhci_io, 0x00, 128);
-    dev->uhci_io[0x0c] = 0x40;
-    dev->uhci_io[0x10] = dev->uhci_io[0x12] = 0x80;
-
-    memset(dev->ohci_mmio, 0x00, 4096);
-    dev->ohci_mmio[0x00] = 0x10;
-    dev->ohci_mmio[0x01] = 0x01;
-    dev->ohci_mmio[0x48] = 0x02;
+    uhci_reset(dev);
+    ohci_reset(dev);
 
     io_removehandler(dev->uhci_io_base, 0x20, uhci_reg_read, NULL, NULL, uhci_reg_write, uhci_reg_writew, NULL, dev);
     dev->uhci_enable = 0;
@@ -392,6 +897,9 @@ usb_close(void *priv)
 {
     usb_t *dev = (usb_t *) priv;
 
+    timer_disable(&dev->uhci_frame_timer);
+    timer_disable(&dev->ohci_frame_timer);
+
     free(dev);
 }
 
@@ -405,14 +913,8 @@ usb_init(UNUSED(const device_t *info))
         return (NULL);
     memset(dev, 0x00, sizeof(usb_t));
 
-    memset(dev->uhci_io, 0x00, 128);
-    dev->uhci_io[0x0c] = 0x40;
-    dev->uhci_io[0x10] = dev->uhci_io[0x12] = 0x80;
-
-    memset(dev->ohci_mmio, 0x00, 4096);
-    dev->ohci_mmio[0x00] = 0x10;
-    dev->ohci_mmio[0x01] = 0x01;
-    dev->ohci_mmio[0x48] = 0x02;
+    timer_add(&dev->uhci_frame_timer, uhci_frame_timer, dev, 0);
+    timer_add(&dev->ohci_frame_timer, ohci_frame_timer, dev, 0);
 
     mem_mapping_add(&dev->ohci_mmio_mapping, 0, 0,
                     ohci_mmio_read, NULL, NULL,
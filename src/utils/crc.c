@@ -68,10 +68,3 @@ crc16_setup(uint16_t *crc_table, uint16_t poly)
         }
     }
 }
-
-void
-crc16_calc(uint16_t *crc_table, uint8_t byte, crc_t *crc_var)
-{
-    crc_var->word = (crc_var->word << 8) ^
-                    crc_table[(crc_var->word >> 8) ^ byte];
-}
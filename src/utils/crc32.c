@@ -107,7 +107,8 @@
 
 /*
    #ifdef this out because that code path does not currently produce the
-   correct results.
+   correct results: the ARM CRC32 instructions are hardwired to the zlib
+   polynomial, while this file computes the CD-ROM EDC one (see POLY below).
  */
 #ifdef USE_ARMCRC32
 /* If available, use the ARM processor CRC32 instruction. */
@@ -696,8 +697,8 @@ static word_t crc_word_big(word_t data) {
 #endif
 
 /* ========================================================================= */
-unsigned long cdrom_crc32(unsigned long crc, const unsigned char *buf,
-                          size_t len) {
+static unsigned long crc32_soft(unsigned long crc, const unsigned char *buf,
+                                size_t len) {
     /* Return initial CRC, if requested. */
     if (buf == NULL)
         return 0;
@@ -1016,3 +1017,122 @@ unsigned long cdrom_crc32(unsigned long crc, const unsigned char *buf,
 }
 
 #endif
+
+#ifndef ARMCRC32
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#  define CRC32_PCLMUL
+#  include <cpuid.h>
+#  include <emmintrin.h>
+#  include <wmmintrin.h>
+
+/*
+  Carry-less multiplication folding, after "Fast CRC Computation for Generic
+  Polynomials Using PCLMULQDQ Instruction" (Gopal, Ozturk et al., Intel 2009).
+  The constants are the bit-reflected k1..k5, P(x) and mu for POLY, computed
+  as described at the end of the paper:
+
+    k1 = x^(4*128+32) mod P    k2 = x^(4*128-32) mod P
+    k3 = x^(128+32) mod P      k4 = x^(128-32) mod P
+    k5 = x^64 mod P            mu = x^64 / P
+
+  len must be at least 64 and a multiple of 16; crc is pre-conditioned.
+ */
+__attribute__((target("sse2,pclmul")))
+static crc_t crc32_pclmul(const unsigned char *buf, size_t len, crc_t crc) {
+    const __m128i k1k2 = _mm_set_epi64x(0x012e7928a2, 0x01f8931102);
+    const __m128i k3k4 = _mm_set_epi64x(0x01d5934102, 0x006c90c100);
+    const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x01f1030002);
+    const __m128i poly = _mm_set_epi64x(0x017000ffff, 0x01b0030003);
+    const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i x1, x2, x3, x4, y1, y2, y3, y4;
+
+    x1 = _mm_loadu_si128((const __m128i *) (buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *) (buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *) (buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *) (buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) crc));
+    buf += 64;
+    len -= 64;
+
+    /* Fold four 128-bit lanes in parallel. */
+    while (len >= 64) {
+        y1 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        y2 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        y3 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        y4 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, y1), _mm_loadu_si128((const __m128i *) (buf + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, y2), _mm_loadu_si128((const __m128i *) (buf + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, y3), _mm_loadu_si128((const __m128i *) (buf + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, y4), _mm_loadu_si128((const __m128i *) (buf + 0x30)));
+        buf += 64;
+        len -= 64;
+    }
+
+    /* Fold the lanes into one, then any remaining 128-bit blocks into it. */
+    y1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), y1);
+    y1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), y1);
+    y1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), y1);
+
+    while (len >= 16) {
+        y1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *) buf)), y1);
+        buf += 16;
+        len -= 16;
+    }
+
+    /* Fold 128 bits down to 64. */
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction to 32 bits. */
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), poly, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (crc_t) _mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+static int
+crc32_has_pclmul(void)
+{
+    static int has_pclmul = -1;
+    unsigned int eax, ebx, ecx, edx;
+
+    if (has_pclmul < 0)
+        has_pclmul = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) && (edx & bit_SSE2);
+
+    return has_pclmul;
+}
+#endif
+
+/* ========================================================================= */
+unsigned long cdrom_crc32(unsigned long crc, const unsigned char *buf,
+                          size_t len) {
+#ifdef CRC32_PCLMUL
+    /* Fold whole 16-byte blocks in hardware, leave the tail to the tables. */
+    if ((buf != NULL) && (len >= 64) && crc32_has_pclmul()) {
+        size_t blk = len & ~(size_t) 15;
+
+        crc = ~crc32_pclmul(buf, blk, (crc_t) ~crc) & 0xffffffff;
+        buf += blk;
+        len -= blk;
+    }
+#endif
+
+    return crc32_soft(crc, buf, len);
+}
+#endif
@@ -45,33 +45,68 @@ fifo8_destroy(Fifo8 *fifo)
     }
 }
 
+/* Index of the first free byte; head and num never exceed the capacity, so
+   one conditional subtraction replaces the modulo. */
+static __inline uint32_t
+fifo8_tail(const Fifo8 *fifo)
+{
+    uint32_t tail = fifo->head + fifo->num;
+
+    if (tail >= fifo->capacity)
+        tail -= fifo->capacity;
+
+    return tail;
+}
+
 void
 fifo8_push(Fifo8 *fifo, uint8_t data)
 {
     assert(fifo->num < fifo->capacity);
-    fifo->data[(fifo->head + fifo->num) % fifo->capacity] = data;
+    fifo->data[fifo8_tail(fifo)] = data;
     fifo->num++;
 }
 
+uint8_t *
+fifo8_reserve_span(Fifo8 *fifo, uint32_t max, uint32_t *numptr)
+{
+    uint32_t tail = fifo8_tail(fifo);
+    uint32_t num;
+
+    num = MIN(max, fifo->capacity - fifo->num);
+    num = MIN(num, fifo->capacity - tail);
+    if (numptr)
+        *numptr = num;
+
+    return &fifo->data[tail];
+}
+
+void
+fifo8_commit(Fifo8 *fifo, uint32_t num)
+{
+    assert((fifo->num + num) <= fifo->capacity);
+    fifo->num += num;
+}
+
 void
 fifo8_push_all(Fifo8 *fifo, const uint8_t *data, uint32_t num)
 {
-    uint32_t start;
-    uint32_t avail;
+    uint8_t *span;
+    uint32_t len;
 
     assert((fifo->num + num) <= fifo->capacity);
 
-    start = (fifo->head + fifo->num) % fifo->capacity;
-
-    if (start + num <= fifo->capacity) {
-        memcpy(&fifo->data[start], data, num);
-    } else {
-        avail = fifo->capacity - start;
-        memcpy(&fifo->data[start], data, avail);
-        memcpy(&fifo->data[0], &data[avail], num - avail);
+    /* Without assertions the bytes that do not fit are dropped, a full
+       store would otherwise hand out empty spans forever. */
+    num = MIN(num, fifo->capacity - fifo->num);
+
+    /* At most two spans, the second one starting at the beginning of the store. */
+    while (num) {
+        span = fifo8_reserve_span(fifo, num, &len);
+        memcpy(span, data, len);
+        fifo8_commit(fifo, len);
+        data += len;
+        num -= len;
     }
-
-    fifo->num += num;
 }
 
 uint8_t
@@ -81,7 +116,8 @@ fifo8_pop(Fifo8 *fifo)
 
     assert(fifo->num > 0);
     ret = fifo->data[fifo->head++];
-    fifo->head %= fifo->capacity;
+    if (fifo->head == fifo->capacity)
+        fifo->head = 0;
     fifo->num--;
     return ret;
 }
@@ -98,7 +134,8 @@ static const uint8_t
 
     if (do_pop) {
         fifo->head += num;
-        fifo->head %= fifo->capacity;
+        if (fifo->head == fifo->capacity)
+            fifo->head = 0;
         fifo->num -= num;
     }
     if (numptr)
@@ -119,6 +156,15 @@ const uint8_t
     return fifo8_peekpop_buf(fifo, max, numptr, 1);
 }
 
+const uint8_t *
+fifo8_peek_span(Fifo8 *fifo, uint32_t *numptr)
+{
+    if (numptr)
+        *numptr = MIN(fifo->num, fifo->capacity - fifo->head);
+
+    return &fifo->data[fifo->head];
+}
+
 uint32_t
 fifo8_pop_buf(Fifo8 *fifo, uint8_t *dest, uint32_t destlen)
 {
@@ -150,8 +196,11 @@ fifo8_pop_buf(Fifo8 *fifo, uint8_t *dest, uint32_t destlen)
 void
 fifo8_drop(Fifo8 *fifo, uint32_t len)
 {
-    len -= fifo8_pop_buf(fifo, NULL, len);
-    assert(len == 0);
+    assert(len <= fifo->num);
+    fifo->head += len;
+    if (fifo->head >= fifo->capacity)
+        fifo->head -= fifo->capacity;
+    fifo->num -= len;
 }
 
 int
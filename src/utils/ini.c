@@ -33,43 +33,62 @@
 #include <wctype.h>
 #define HAVE_STDARG_H
 #include <86box/86box.h>
+#include <86box/hash.h>
 #include <86box/ini.h>
 #include <86box/mem.h>
 #include <86box/rom.h>
 #include <86box/plat.h>
 
+/* Power of two, so the bucket is a simple mask of the name hash. */
+#define INI_HASH_SIZE 64
+#define INI_NAME_MAX  128 /* Names are compared with strncmp() over this much */
+
 typedef struct _list_ {
     struct _list_ *next;
 } list_t;
 
-typedef struct section_t {
-    list_t list;
-
-    char name[128];
-
-    list_t entry_head;
-} section_t;
-
 typedef struct entry_t {
     list_t list;
 
-    char    name[128];
+    struct entry_t *hash_next;
+    uint32_t        hash;
+
+    char    name[INI_NAME_MAX];
     char    data[512];
+    int     wdata_valid; /* wdata is converted from data on first use */
     wchar_t wdata[512];
 } entry_t;
 
-#define list_add(new, head)        \
+typedef struct section_t {
+    list_t list;
+
+    struct ini_head_t *owner;
+    struct section_t  *hash_next;
+    uint32_t           hash;
+
+    char name[INI_NAME_MAX];
+
+    list_t   entry_head;
+    list_t  *entry_tail;
+    entry_t *entry_hash[INI_HASH_SIZE];
+} section_t;
+
+/* The ini_t handle; the list head must stay first. */
+typedef struct ini_head_t {
+    list_t     list;
+    list_t    *tail;
+    section_t *hash[INI_HASH_SIZE];
+    int        dirty; /* Changed since it was last read, written or copied */
+} ini_head_t;
+
+#define list_add(new, head, tail)  \
     {                              \
-        list_t *next = head;       \
-                                   \
-        while (next->next != NULL) \
-            next = next->next;     \
-                                   \
-        (next)->next = new;        \
         (new)->next  = NULL;       \
+        (tail)->next = new;        \
+        tail         = new;        \
     }
 
-#define list_delete(old, head)          \
+#define list_delete(old, head, tail)    \
     {                                   \
         list_t *next = head;            \
                                         \
@@ -78,8 +97,8 @@ typedef struct entry_t {
         }                               \
                                         \
         (next)->next = (old)->next;     \
-        if ((next) == (head))           \
-            (head)->next = (old)->next; \
+        if ((tail) == (old))            \
+            tail = next;                \
     }
 
 #ifdef ENABLE_INI_LOG
@@ -100,20 +119,116 @@ ini_log(const char *fmt, ...)
 #    define ini_log(fmt, ...)
 #endif
 
+/* Chains are kept in list order, so duplicate names resolve to the first one as before. */
+static void
+section_hash_add(ini_head_t *head, section_t *sec)
+{
+    section_t **p = &head->hash[sec->hash & (INI_HASH_SIZE - 1)];
+
+    while (*p != NULL)
+        p = &(*p)->hash_next;
+
+    sec->hash_next = NULL;
+    *p             = sec;
+}
+
+static void
+section_hash_remove(ini_head_t *head, section_t *sec)
+{
+    section_t **p = &head->hash[sec->hash & (INI_HASH_SIZE - 1)];
+
+    while (*p != sec)
+        p = &(*p)->hash_next;
+
+    *p = sec->hash_next;
+}
+
+static void
+entry_hash_add(section_t *section, entry_t *ent)
+{
+    entry_t **p = &section->entry_hash[ent->hash & (INI_HASH_SIZE - 1)];
+
+    while (*p != NULL)
+        p = &(*p)->hash_next;
+
+    ent->hash_next = NULL;
+    *p             = ent;
+}
+
+static void
+entry_hash_remove(section_t *section, entry_t *ent)
+{
+    entry_t **p = &section->entry_hash[ent->hash & (INI_HASH_SIZE - 1)];
+
+    while (*p != ent)
+        p = &(*p)->hash_next;
+
+    *p = ent->hash_next;
+}
+
+static void
+insert_section(ini_head_t *head, section_t *sec)
+{
+    sec->owner      = head;
+    sec->hash       = name_hash(sec->name, INI_NAME_MAX);
+    sec->entry_tail = &sec->entry_head;
+    list_add(&sec->list, &head->list, head->tail);
+    section_hash_add(head, sec);
+}
+
+static void
+insert_entry(section_t *section, entry_t *ent)
+{
+    ent->hash = name_hash(ent->name, INI_NAME_MAX);
+    list_add(&ent->list, &section->entry_head, section->entry_tail);
+    entry_hash_add(section, ent);
+}
+
+static ini_head_t *
+create_head(void)
+{
+    ini_head_t *head = calloc(1, sizeof(ini_head_t));
+
+    head->tail = &head->list;
+
+    return head;
+}
+
+/* Get the wide version of the data, converting it if a setter changed it. */
+static wchar_t *
+entry_wdata(entry_t *ent)
+{
+    if (!ent->wdata_valid) {
+#ifdef _WIN32 /* Make sure the string is converted from UTF-8 rather than a legacy codepage */
+        mbstoc16s(ent->wdata, ent->data, sizeof_w(ent->wdata));
+#else
+        mbstowcs(ent->wdata, ent->data, sizeof_w(ent->wdata));
+#endif
+        ent->wdata[sizeof_w(ent->wdata) - 1] = L'\0';
+        ent->wdata_valid                      = 1;
+    }
+
+    return ent->wdata;
+}
+
 static section_t *
-find_section(list_t *head, const char *name)
+find_section(ini_head_t *head, const char *name)
 {
-    section_t *sec     = (section_t *) head->next;
+    section_t *sec;
+    uint32_t   h;
     const char blank[] = "";
 
     if (name == NULL)
         name = blank;
 
+    h   = name_hash(name, INI_NAME_MAX);
+    sec = head->hash[h & (INI_HASH_SIZE - 1)];
+
     while (sec != NULL) {
-        if (!strncmp(sec->name, name, sizeof(sec->name)))
+        if ((sec->hash == h) && !strncmp(sec->name, name, sizeof(sec->name)))
             return sec;
 
-        sec = (section_t *) sec->list.next;
+        sec = sec->hash_next;
     }
 
     return NULL;
@@ -125,7 +240,7 @@ ini_find_section(ini_t ini, const char *name)
     if (ini == NULL)
         return NULL;
 
-    return (ini_section_t) find_section((list_t *) ini, name);
+    return (ini_section_t) find_section((ini_head_t *) ini, name);
 }
 
 void
@@ -136,22 +251,27 @@ ini_rename_section(ini_section_t section, const char *name)
     if (sec == NULL)
         return;
 
+    section_hash_remove(sec->owner, sec);
     memset(sec->name, 0x00, sizeof(sec->name));
     memcpy(sec->name, name, MIN(128, strlen(name) + 1));
+    sec->hash = name_hash(sec->name, INI_NAME_MAX);
+    section_hash_add(sec->owner, sec);
+    sec->owner->dirty = 1;
 }
 
 static entry_t *
 find_entry(section_t *section, const char *name)
 {
     entry_t *ent;
+    uint32_t h = name_hash(name, INI_NAME_MAX);
 
-    ent = (entry_t *) section->entry_head.next;
+    ent = section->entry_hash[h & (INI_HASH_SIZE - 1)];
 
     while (ent != NULL) {
-        if (!strncmp(ent->name, name, sizeof(ent->name)))
+        if ((ent->hash == h) && !strncmp(ent->name, name, sizeof(ent->name)))
             return ent;
 
-        ent = (entry_t *) ent->list.next;
+        ent = ent->hash_next;
     }
 
     return (NULL);
@@ -191,8 +311,14 @@ entries_num(section_t *section)
     return i;
 }
 
+static int
+entry_name_cmp(const void *a, const void *b)
+{
+    return strcmp((*(entry_t *const *) a)->name, (*(entry_t *const *) b)->name);
+}
+
 static void
-delete_section_if_empty(list_t *head, section_t *section)
+delete_section_if_empty(ini_head_t *head, section_t *section)
 {
     if (section == NULL)
         return;
@@ -200,43 +326,51 @@ delete_section_if_empty(list_t *head, section_t *section)
     int     n = entries_num(section);
 
     if (n > 0) {
-        int      i      = 0;
-        entry_t *i_ent = (entry_t *) section->entry_head.next;
-
-        while (i_ent != NULL) {
-            int      i_nlen = strlen(i_ent->name);
-            entry_t* i_next = (entry_t *) i_ent->list.next;
-
-            if (i_nlen > 0) {
-                int      j      = 0;
-                entry_t *j_ent = (entry_t *) section->entry_head.next;
-
-                while (j_ent != NULL) {
-                    int      j_nlen = strlen(j_ent->name);
-                    entry_t* j_next = (entry_t *) j_ent->list.next;
-                    if (j_nlen > 0) {
-                        if ((j != i) && (strcmp(j_ent->name, i_ent->name) > 0)) {
-                            entry_t t_ent = { 0 };
-                            memcpy(&t_ent, j_ent, sizeof(entry_t));
-                            /* J: Contents of I, list of J */
-                            memcpy(j_ent->name, i_ent->name, sizeof(entry_t) - sizeof(i_ent->list));
-                            /* I: Contents of J, list of I */
-                            memcpy(i_ent->name, t_ent.name, sizeof(entry_t) - sizeof(i_ent->list));
-                        }
-
-                        j++;
-                    }
-
-                    j_ent = (entry_t *) j_next;
-                }
+        /* Sort the named entries by relinking the nodes, leaving unnamed ones in place. */
+        entry_t  *ent;
+        entry_t **nodes;
+        entry_t **sorted;
+        list_t   *prev  = &section->entry_head;
+        int       total = 0;
+        int       i     = 0;
+        int       j     = 0;
+
+        for (ent = (entry_t *) section->entry_head.next; ent != NULL; ent = (entry_t *) ent->list.next)
+            total++;
+
+        nodes  = malloc((total + n) * sizeof(entry_t *));
+        sorted = &nodes[total];
+
+        for (ent = (entry_t *) section->entry_head.next; ent != NULL; ent = (entry_t *) ent->list.next) {
+            if (ent->name[0] != '\0')
+                sorted[i++] = ent;
+            nodes[j++] = ent;
+        }
 
-                i++;
-            }
+        qsort(sorted, n, sizeof(entry_t *), entry_name_cmp);
 
-            i_ent = (entry_t *) i_next;
+        i = 0;
+        for (j = 0; j < total; j++) {
+            ent = (nodes[j]->name[0] != '\0') ? sorted[i++] : nodes[j];
+            if (ent != nodes[j])
+                head->dirty = 1;
+
+            prev->next = &ent->list;
+            prev       = &ent->list;
         }
+        prev->next          = NULL;
+        section->entry_tail = prev;
+
+        /* Rebuild the chains so duplicate names keep resolving in list order. */
+        memset(section->entry_hash, 0x00, sizeof(section->entry_hash));
+        for (ent = (entry_t *) section->entry_head.next; ent != NULL; ent = (entry_t *) ent->list.next)
+            entry_hash_add(section, ent);
+
+        free(nodes);
     } else {
-        list_delete(&section->list, head);
+        list_delete(&section->list, &head->list, head->tail);
+        section_hash_remove(head, section);
+        head->dirty = 1;
         free(section);
     }
 }
@@ -247,16 +381,17 @@ ini_delete_section_if_empty(ini_t ini, ini_section_t section)
     if (ini == NULL || section == NULL)
         return;
 
-    delete_section_if_empty((list_t *) ini, (section_t *) section);
+    delete_section_if_empty((ini_head_t *) ini, (section_t *) section);
 }
 
 static section_t *
-create_section(list_t *head, const char *name)
+create_section(ini_head_t *head, const char *name)
 {
     section_t *ns = calloc(1, sizeof(section_t));
 
-    memcpy(ns->name, name, strlen(name) + 1);
-    list_add(&ns->list, head);
+    memcpy(ns->name, name, MIN(sizeof(ns->name) - 1, strlen(name)));
+    insert_section(head, ns);
+    head->dirty = 1;
 
     return ns;
 }
@@ -267,9 +402,9 @@ ini_find_or_create_section(ini_t ini, const char *name)
     if (ini == NULL)
         return NULL;
 
-    section_t *section = find_section((list_t *) ini, name);
+    section_t *section = find_section((ini_head_t *) ini, name);
     if (section == NULL)
-        section = create_section((list_t *) ini, name);
+        section = create_section((ini_head_t *) ini, name);
 
     return (ini_section_t) section;
 }
@@ -279,12 +414,29 @@ create_entry(section_t *section, const char *name)
 {
     entry_t *ne = calloc(1, sizeof(entry_t));
 
-    memcpy(ne->name, name, strlen(name) + 1);
-    list_add(&ne->list, &section->entry_head);
+    memcpy(ne->name, name, MIN(sizeof(ne->name) - 1, strlen(name)));
+    insert_entry(section, ne);
+    section->owner->dirty = 1;
 
     return ne;
 }
 
+/* Store a new value, only flagging the ini as changed if it actually differs. */
+static void
+entry_set_data(section_t *section, entry_t *ent, const char *val)
+{
+    size_t len = MIN(strlen(val), sizeof(ent->data) - 1);
+
+    if (!strncmp(ent->data, val, len) && (ent->data[len] == '\0'))
+        return;
+
+    memcpy(ent->data, val, len);
+    ent->data[len]   = '\0';
+    ent->wdata_valid = 0;
+
+    section->owner->dirty = 1;
+}
+
 void
 ini_close(ini_t ini)
 {
@@ -375,8 +527,8 @@ ini_read_ex(const char *fn, int is_rom)
     int        c;
     int        d;
     int        bom;
-    FILE      *fp;
-    list_t    *head;
+    FILE       *fp;
+    ini_head_t *head;
 
     bom = ini_detect_bom(fn);
 
@@ -396,10 +548,10 @@ ini_read_ex(const char *fn, int is_rom)
     if (fp == NULL)
         return NULL;
 
-    head = calloc(1, sizeof(list_t));
-    sec = calloc(1, sizeof(section_t));
+    head = create_head();
+    sec  = calloc(1, sizeof(section_t));
 
-    list_add(&sec->list, head);
+    insert_section(head, sec);
     if (bom)
         fseek(fp, 3, SEEK_SET);
 
@@ -449,7 +601,7 @@ ini_read_ex(const char *fn, int is_rom)
             ns = malloc(sizeof(section_t));
             memset(ns, 0x00, sizeof(section_t));
             memcpy(ns->name, sname, 128);
-            list_add(&ns->list, head);
+            insert_section(head, ns);
 
             /* New section is now the current one. */
             sec = ns;
@@ -489,9 +641,10 @@ ini_read_ex(const char *fn, int is_rom)
         wcstombs(ne->data, ne->wdata, sizeof(ne->data));
 #endif
         ne->data[sizeof(ne->data) - 1] = '\0';
+        ne->wdata_valid                = 1;
 
         /* .. and insert it. */
-        list_add(&ne->list, &sec->entry_head);
+        insert_entry(sec, ne);
     }
 
     (void) fclose(fp);
@@ -511,16 +664,22 @@ void
 ini_write_ex(ini_t ini, const char *fn, int is_rom)
 {
     wchar_t    wtemp[512];
+    char       tmp_fn[1024 + 8];
     list_t    *list = (list_t *) ini;
     section_t *sec;
     FILE      *fp;
     int        fl = 0;
+    int        err;
 
     if (list == NULL)
         return;
 
     sec = (section_t *) list->next;
 
+    /* Write to a temporary file next to the target and rename it over
+       the old one, so a crash or a full disk never leaves a truncated file. */
+    snprintf(tmp_fn, sizeof(tmp_fn), "%s.tmp", fn);
+
     if (is_rom)
 #if defined(ANSI_CFG) || !defined(_WIN32)
         fp = rom_fopen(fn, "wt");
@@ -529,9 +688,9 @@ ini_write_ex(ini_t ini, const char *fn, int is_rom)
 #endif
     else
 #if defined(ANSI_CFG) || !defined(_WIN32)
-        fp = plat_fopen(fn, "wt");
+        fp = plat_fopen(tmp_fn, "wt");
 #else
-        fp = plat_fopen(fn, "wt, ccs=UTF-8");
+        fp = plat_fopen(tmp_fn, "wt, ccs=UTF-8");
 #endif
 
     if (fp == NULL)
@@ -553,10 +712,10 @@ ini_write_ex(ini_t ini, const char *fn, int is_rom)
         while (ent != NULL) {
             if (ent->name[0] != '\0') {
                 mbstowcs(wtemp, ent->name, 128);
-                if (ent->wdata[0] == L'\0')
+                if (ent->data[0] == '\0')
                     fwprintf(fp, L"%ls = \n", wtemp);
                 else
-                    fwprintf(fp, L"%ls = %ls\n", wtemp, ent->wdata);
+                    fwprintf(fp, L"%ls = %ls\n", wtemp, entry_wdata(ent));
                 fl++;
             }
 
@@ -566,7 +725,21 @@ ini_write_ex(ini_t ini, const char *fn, int is_rom)
         sec = (section_t *) sec->list.next;
     }
 
-    (void) fclose(fp);
+    err = ferror(fp);
+    err |= fclose(fp);
+
+    if (is_rom)
+        return;
+
+    if (err) {
+        ini_log("INI: Failed to write %s, keeping the old file\n", tmp_fn);
+        plat_remove(tmp_fn);
+    } else if (plat_rename(tmp_fn, fn) != 0) {
+        /* Some file systems refuse to rename over an existing file. */
+        plat_remove((char *) fn);
+        if (plat_rename(tmp_fn, fn) != 0)
+            ini_log("INI: Failed to rename %s to %s\n", tmp_fn, fn);
+    }
 }
 
 /* Write the in-memory configuration to disk. */
@@ -642,14 +815,9 @@ ini_strip_quotes(ini_t ini)
             if (ent->name[0] != '\0') {
                 int trailing_hash = strcspn(ent->data, "#");
                 int trailing_quote;
-                ent->wdata[trailing_hash] = 0;
+                /* Let the wide copy be regenerated from the stripped data. */
+                ent->wdata_valid = 0;
                 ent->data[trailing_hash] = 0;
-                if (ent->wdata[0] == L'\"') {
-                    memmove(ent->wdata, &ent->wdata[1], sizeof(ent->wdata) - sizeof(wchar_t));
-                }
-                if (ent->wdata[wcslen(ent->wdata) - 1] == L'\"') {
-                    ent->wdata[wcslen(ent->wdata) - 1] = 0;
-                }
 
                 if (ent->data[0] == '\"') {
                     memmove(ent->data, &ent->data[1], sizeof(ent->data) - sizeof(char));
@@ -659,10 +827,8 @@ ini_strip_quotes(ini_t ini)
                 }
 
                 trailing_quote = strcspn(ent->data, "\"");
-                ent->wdata[trailing_quote] = 0;
                 ent->data[trailing_quote] = 0;
-                
-                trim_w(ent->wdata);
+
                 trim(ent->data);
             }
 
@@ -676,15 +842,61 @@ ini_strip_quotes(ini_t ini)
 ini_t
 ini_new(void)
 {
-    ini_t ini = malloc(sizeof(list_t));
-    memset(ini, 0, sizeof(list_t));
-    return ini;
+    return (ini_t) create_head();
+}
+
+/* Deep copy, so a snapshot can be written out while the original keeps changing. */
+ini_t
+ini_copy(ini_t ini)
+{
+    ini_head_t *head = create_head();
+    section_t  *sec;
+
+    if (ini == NULL)
+        return (ini_t) head;
+
+    for (sec = (section_t *) ((list_t *) ini)->next; sec != NULL; sec = (section_t *) sec->list.next) {
+        section_t *ns = calloc(1, sizeof(section_t));
+        entry_t   *ent;
+
+        memcpy(ns->name, sec->name, sizeof(ns->name));
+        insert_section(head, ns);
+
+        for (ent = (entry_t *) sec->entry_head.next; ent != NULL; ent = (entry_t *) ent->list.next) {
+            entry_t *ne = malloc(sizeof(entry_t));
+
+            memcpy(ne->name, ent->name, sizeof(ne->name));
+            memcpy(ne->data, ent->data, sizeof(ne->data));
+            ne->wdata_valid = ent->wdata_valid;
+            if (ent->wdata_valid)
+                memcpy(ne->wdata, ent->wdata, sizeof(ne->wdata));
+            insert_entry(ns, ne);
+        }
+    }
+
+    return (ini_t) head;
+}
+
+int
+ini_is_dirty(ini_t ini)
+{
+    if (ini == NULL)
+        return 0;
+
+    return ((ini_head_t *) ini)->dirty;
+}
+
+void
+ini_clear_dirty(ini_t ini)
+{
+    if (ini != NULL)
+        ((ini_head_t *) ini)->dirty = 0;
 }
 
 void
 ini_dump(ini_t ini)
 {
-    section_t *sec = (section_t *) ini;
+    section_t *sec = (section_t *) ((list_t *) ini)->next;
     while (sec != NULL) {
         entry_t *ent;
 
@@ -713,7 +925,9 @@ ini_section_delete_var(ini_section_t self, const char *name)
 
     entry = find_entry(section, name);
     if (entry != NULL) {
-        list_delete(&entry->list, &section->entry_head);
+        list_delete(&entry->list, &section->entry_head, section->entry_tail);
+        entry_hash_remove(section, entry);
+        section->owner->dirty = 1;
         free(entry);
     }
 }
@@ -919,7 +1133,7 @@ ini_section_get_wstring(ini_section_t self, const char *name, wchar_t *def)
     if (entry == NULL)
         return def;
 
-    return (entry->wdata);
+    return entry_wdata(entry);
 }
 
 void
@@ -927,6 +1141,7 @@ ini_section_set_int(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[64];
 
     if (section == NULL)
         return;
@@ -935,8 +1150,8 @@ ini_section_set_int(ini_section_t self, const char *name, int val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    sprintf(ent->data, "%i", val);
-    mbstowcs(ent->wdata, ent->data, 512);
+    sprintf(temp, "%i", val);
+    entry_set_data(section, ent, temp);
 }
 
 void
@@ -944,6 +1159,7 @@ ini_section_set_uint(ini_section_t self, const char *name, uint32_t val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[64];
 
     if (section == NULL)
         return;
@@ -952,8 +1168,8 @@ ini_section_set_uint(ini_section_t self, const char *name, uint32_t val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    sprintf(ent->data, "%i", val);
-    mbstowcs(ent->wdata, ent->data, 512);
+    sprintf(temp, "%i", val);
+    entry_set_data(section, ent, temp);
 }
 
 #if 0
@@ -962,6 +1178,7 @@ ini_section_set_float(ini_section_t self, const char *name, float val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[64];
 
     if (section == NULL)
         return;
@@ -970,8 +1187,8 @@ ini_section_set_float(ini_section_t self, const char *name, float val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    sprintf(ent->data, "%g", val);
-    mbstowcs(ent->wdata, ent->data, 512);
+    sprintf(temp, "%g", val);
+    entry_set_data(section, ent, temp);
 }
 #endif
 
@@ -980,6 +1197,7 @@ ini_section_set_double(ini_section_t self, const char *name, double val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[64];
 
     if (section == NULL)
         return;
@@ -988,8 +1206,8 @@ ini_section_set_double(ini_section_t self, const char *name, double val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    sprintf(ent->data, "%lg", val);
-    mbstowcs(ent->wdata, ent->data, 512);
+    sprintf(temp, "%lg", val);
+    entry_set_data(section, ent, temp);
 }
 
 void
@@ -997,6 +1215,7 @@ ini_section_set_hex12(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[64];
 
     if (section == NULL)
         return;
@@ -1005,8 +1224,8 @@ ini_section_set_hex12(ini_section_t self, const char *name, int val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    sprintf(ent->data, "%03X", val);
-    mbstowcs(ent->wdata, ent->data, sizeof_w(ent->wdata));
+    sprintf(temp, "%03X", val);
+    entry_set_data(section, ent, temp);
 }
 
 void
@@ -1014,6 +1233,7 @@ ini_section_set_hex16(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[64];
 
     if (section == NULL)
         return;
@@ -1022,8 +1242,8 @@ ini_section_set_hex16(ini_section_t self, const char *name, int val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    sprintf(ent->data, "%04X", val);
-    mbstowcs(ent->wdata, ent->data, sizeof_w(ent->wdata));
+    sprintf(temp, "%04X", val);
+    entry_set_data(section, ent, temp);
 }
 
 void
@@ -1031,6 +1251,7 @@ ini_section_set_hex20(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[64];
 
     if (section == NULL)
         return;
@@ -1039,8 +1260,8 @@ ini_section_set_hex20(ini_section_t self, const char *name, int val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    sprintf(ent->data, "%05X", val);
-    mbstowcs(ent->wdata, ent->data, sizeof_w(ent->wdata));
+    sprintf(temp, "%05X", val);
+    entry_set_data(section, ent, temp);
 }
 
 void
@@ -1048,6 +1269,7 @@ ini_section_set_mac(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[64];
 
     if (section == NULL)
         return;
@@ -1056,9 +1278,9 @@ ini_section_set_mac(ini_section_t self, const char *name, int val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    sprintf(ent->data, "%02x:%02x:%02x",
+    sprintf(temp, "%02x:%02x:%02x",
             (val >> 16) & 0xff, (val >> 8) & 0xff, val & 0xff);
-    mbstowcs(ent->wdata, ent->data, 512);
+    entry_set_data(section, ent, temp);
 }
 
 void
@@ -1074,15 +1296,7 @@ ini_section_set_string(ini_section_t self, const char *name, const char *val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    if ((strlen(val) + 1) <= sizeof(ent->data))
-        memcpy(ent->data, val, strlen(val) + 1);
-    else
-        memcpy(ent->data, val, sizeof(ent->data));
-#ifdef _WIN32 /* Make sure the string is converted from UTF-8 rather than a legacy codepage */
-    mbstoc16s(ent->wdata, ent->data, sizeof_w(ent->wdata));
-#else
-    mbstowcs(ent->wdata, ent->data, sizeof_w(ent->wdata));
-#endif
+    entry_set_data(section, ent, val);
 }
 
 void
@@ -1090,6 +1304,7 @@ ini_section_set_wstring(ini_section_t self, const char *name, wchar_t *val)
 {
     section_t *section = (section_t *) self;
     entry_t   *ent;
+    char       temp[512];
 
     if (section == NULL)
         return;
@@ -1098,10 +1313,14 @@ ini_section_set_wstring(ini_section_t self, const char *name, wchar_t *val)
     if (ent == NULL)
         ent = create_entry(section, name);
 
-    memcpy(ent->wdata, val, sizeof_w(ent->wdata));
 #ifdef _WIN32 /* Make sure the string is converted to UTF-8 rather than a legacy codepage */
-    c16stombs(ent->data, ent->wdata, sizeof(ent->data));
+    c16stombs(temp, val, sizeof(temp));
 #else
-    wcstombs(ent->data, ent->wdata, sizeof(ent->data));
+    wcstombs(temp, val, sizeof(temp));
 #endif
+    temp[sizeof(temp) - 1] = '\0';
+    entry_set_data(section, ent, temp);
+
+    memcpy(ent->wdata, val, sizeof_w(ent->wdata));
+    ent->wdata_valid = 1;
 }
@@ -18,6 +18,7 @@
  */
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -32,6 +33,7 @@
 #include <86box/mem.h>
 #include "cpu.h"
 #include <86box/plat.h>
+#include <86box/thread.h>
 #include <86box/version.h>
 #include <86box/log.h>
 
@@ -51,6 +53,49 @@ extern FILE *stdlog;
 /* Functions only used in this translation unit. */
 void log_ensure_stdlog_open(void);
 
+#ifndef RELEASE_BUILD
+/*
+   Asynchronous backend: logging threads reserve room for their records in
+   one shared ring, fill it in, mark it ready and move on, so the order of
+   the reservations is the order of the log. A single writer thread takes
+   the records in that order and does the repeat suppression, the cyclic
+   detection and the file I/O, so the emulation threads never wait on
+   fprintf() or fflush().
+ */
+#    define LOG_RING_SIZE (256 * 1024) /* Must be a power of 2 */
+#    define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#    define LOG_REC_READY 8            /* Bytes before the header, holding the ready flag */
+#    define LOG_WRITER_MS 5            /* Writer poll period */
+
+enum {
+    LOG_REC_PLAIN = 0,
+    LOG_REC_SUPPR,
+    LOG_REC_CYCLIC
+};
+
+typedef struct log_rec_t {
+    log_t   *log;
+    uint32_t len;  /* Text bytes following the header, without the NUL */
+    uint32_t type;
+} log_rec_t;
+
+typedef struct log_ring_t {
+    /* The logging threads reserve at head, the writer thread releases at tail. */
+    atomic_uint head;
+    atomic_uint tail;
+    uint64_t    data[LOG_RING_SIZE / sizeof(uint64_t)]; /* Records are 8-byte aligned */
+} log_ring_t;
+
+static log_ring_t           log_ring;
+static atomic_int           log_writer_state; /* 0 = not started, 1 = starting, 2 = running */
+static event_t             *log_wake_event;
+/* State for pclog_ex(), which has no log_t of its own. */
+static log_t                log_pclog = { .suppr_seen = 1 };
+
+static void log_write_line(log_t *log, const char *temp);
+static void log_write_cyclic(log_t *log, char *temp);
+#endif
+
 void
 log_set_dev_name(void *priv, char *dev_name)
 {
@@ -73,6 +118,183 @@ log_copy(log_t *log, char *dest, const char *src, size_t dest_size)
 }
 
 #ifndef RELEASE_BUILD
+static void
+log_ring_write(uint32_t pos, const void *src, uint32_t len)
+{
+    uint8_t *data  = (uint8_t *) log_ring.data;
+    uint32_t off   = pos & LOG_RING_MASK;
+    uint32_t first = MIN(len, LOG_RING_SIZE - off);
+
+    memcpy(&data[off], src, first);
+    memcpy(data, (const uint8_t *) src + first, len - first);
+}
+
+static void
+log_ring_read(uint32_t pos, void *dest, uint32_t len)
+{
+    const uint8_t *data  = (const uint8_t *) log_ring.data;
+    uint32_t       off   = pos & LOG_RING_MASK;
+    uint32_t       first = MIN(len, LOG_RING_SIZE - off);
+
+    memcpy(dest, &data[off], first);
+    memcpy((uint8_t *) dest + first, data, len - first);
+}
+
+/* Released space reads as zero, the ready flag of the next record included. */
+static void
+log_ring_clear(uint32_t pos, uint32_t len)
+{
+    uint8_t *data  = (uint8_t *) log_ring.data;
+    uint32_t off   = pos & LOG_RING_MASK;
+    uint32_t first = MIN(len, LOG_RING_SIZE - off);
+
+    memset(&data[off], 0x00, first);
+    memset(data, 0x00, len - first);
+}
+
+/* Records start 8-byte aligned, so the flag never wraps around. */
+static inline atomic_uint *
+log_rec_ready(uint32_t pos)
+{
+    return (atomic_uint *) &((uint8_t *) log_ring.data)[pos & LOG_RING_MASK];
+}
+
+static inline uint32_t
+log_rec_size(uint32_t len)
+{
+    return (LOG_REC_READY + sizeof(log_rec_t) + len + 7) & ~7;
+}
+
+/* Write out everything queued so far; returns the number of records. */
+static int
+log_drain(void)
+{
+    char      temp[LOG_SIZE_BUFFER];
+    log_rec_t rec;
+    uint32_t  tail;
+    uint32_t  size;
+    int       count = 0;
+
+    while (1) {
+        tail = atomic_load_explicit(&log_ring.tail, memory_order_relaxed);
+
+        /* Stop at a record that is reserved but not filled in yet, it is
+           picked up on the next round. */
+        if ((tail == atomic_load_explicit(&log_ring.head, memory_order_acquire)) ||
+            !atomic_load_explicit(log_rec_ready(tail), memory_order_acquire))
+            break;
+
+        log_ring_read(tail + LOG_REC_READY, &rec, sizeof(rec));
+        log_ring_read(tail + LOG_REC_READY + sizeof(rec), temp, rec.len);
+        temp[rec.len] = '\0';
+
+        switch (rec.type) {
+            case LOG_REC_CYCLIC:
+                log_write_cyclic(rec.log, temp);
+                break;
+            case LOG_REC_SUPPR:
+                log_write_line(rec.log, temp);
+                break;
+            default:
+                fprintf(stdlog, "%s", temp);
+                break;
+        }
+
+        /* Release the space only once the text is out, so log_flush() can wait on it. */
+        size = log_rec_size(rec.len);
+        log_ring_clear(tail, size);
+        atomic_store_explicit(&log_ring.tail, tail + size, memory_order_release);
+        count++;
+    }
+
+    return count;
+}
+
+static void
+log_writer_thread(UNUSED(void *priv))
+{
+    while (1) {
+        if (log_drain())
+            fflush(stdlog);
+
+        thread_wait_event(log_wake_event, LOG_WRITER_MS);
+        thread_reset_event(log_wake_event);
+    }
+}
+
+static int
+log_ring_empty(void)
+{
+    return atomic_load_explicit(&log_ring.tail, memory_order_acquire) == atomic_load_explicit(&log_ring.head, memory_order_acquire);
+}
+
+/* Wait until everything logged so far has reached the log file. */
+void
+log_flush(void)
+{
+    if (atomic_load_explicit(&log_writer_state, memory_order_acquire) != 2)
+        return;
+
+    while (!log_ring_empty()) {
+        thread_set_event(log_wake_event);
+        plat_delay_ms(1);
+    }
+
+    fflush(stdlog);
+}
+
+/* The first record from anywhere starts the writer. */
+static void
+log_writer_start(void)
+{
+    int state = 0;
+
+    if (atomic_compare_exchange_strong(&log_writer_state, &state, 1)) {
+        log_ensure_stdlog_open();
+        log_wake_event = thread_create_event();
+        (void) thread_create(log_writer_thread, NULL);
+        atexit(log_flush);
+        atomic_store_explicit(&log_writer_state, 2, memory_order_release);
+    } else {
+        while (atomic_load_explicit(&log_writer_state, memory_order_acquire) != 2)
+            plat_delay_ms(1);
+    }
+}
+
+static void
+log_push(log_t *log, uint32_t type, const char *text)
+{
+    log_rec_t rec;
+    uint32_t  head;
+    uint32_t  size;
+
+    if (atomic_load_explicit(&log_writer_state, memory_order_acquire) != 2)
+        log_writer_start();
+
+    rec.len  = MIN(strlen(text), LOG_SIZE_BUFFER - 1);
+    rec.log  = log;
+    rec.type = type;
+    size     = log_rec_size(rec.len);
+
+    /* Space only ever grows while waiting, so a reservation made against
+       the tail seen here stays valid. */
+    head = atomic_load_explicit(&log_ring.head, memory_order_relaxed);
+    do {
+        /* Full ring: nudge the writer and wait rather than lose lines. */
+        while ((LOG_RING_SIZE - (head - atomic_load_explicit(&log_ring.tail, memory_order_acquire))) < size) {
+            thread_set_event(log_wake_event);
+            plat_delay_ms(1);
+            head = atomic_load_explicit(&log_ring.head, memory_order_relaxed);
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&log_ring.head, &head, head + size,
+                                                    memory_order_relaxed, memory_order_relaxed));
+
+    log_ring_write(head + LOG_REC_READY, &rec, sizeof(rec));
+    log_ring_write(head + LOG_REC_READY + sizeof(rec), text, rec.len);
+
+    atomic_store_explicit(log_rec_ready(head), 1, memory_order_release);
+}
+
 void 
 log_ensure_stdlog_open(void)
 {
@@ -112,25 +334,40 @@ log_out(void *priv, const char *fmt, va_list ap)
     else if (fmt == NULL)
         pclog("WARNING: Logging called with a NULL format pointer\n");
     else if (fmt[0] != '\0') {
-        log_ensure_stdlog_open();
-
         vsnprintf(temp, sizeof(temp), fmt, ap);
 
-        if (log->suppr_seen && !strcmp(log->buff, temp))
-            log->seen++;
-        else {
-            if (log->suppr_seen && log->seen) {
-                fprintf(stdlog, "*** %d repeats ***\n", log->seen);
-            }
-            log->seen = 0;
+        log_push(log, LOG_REC_SUPPR, temp);
+    }
+}
 
-            strncpy(log->buff, temp, sizeof(log->buff) - 1);
-            log->buff[sizeof(log->buff) - 1] = '\0';
+/* Also used by pclog_ex(), with its own state. */
+void
+log_out_global(int suppr_seen, const char *fmt, va_list ap)
+{
+    char temp[LOG_SIZE_BUFFER];
+
+    vsnprintf(temp, sizeof(temp), fmt, ap);
 
-            fprintf(stdlog, "%s", temp);
+    /* Only the writer thread looks at log_pclog past this point. */
+    log_push(&log_pclog, suppr_seen ? LOG_REC_SUPPR : LOG_REC_PLAIN, temp);
+}
+
+/* Runs on the writer thread. */
+static void
+log_write_line(log_t *log, const char *temp)
+{
+    if (log->suppr_seen && !strcmp(log->buff, temp))
+        log->seen++;
+    else {
+        if (log->suppr_seen && log->seen) {
+            fprintf(stdlog, "*** %d repeats ***\n", log->seen);
         }
+        log->seen = 0;
 
-        fflush(stdlog);
+        strncpy(log->buff, temp, sizeof(log->buff) - 1);
+        log->buff[sizeof(log->buff) - 1] = '\0';
+
+        fprintf(stdlog, "%s", temp);
     }
 }
 
@@ -158,114 +395,130 @@ log_out_cyclic(void* priv, const char* fmt, va_list ap)
         pclog("WARNING: Cyclical logging called with a NULL format pointer\n");
     /* Is the string empty? */
     else if (fmt[0] != '\0') {
-        /* Ensure stdlog is open. */
-        log_ensure_stdlog_open();
-
         char temp[LOG_SIZE_BUFFER] = {0};
 
-        log->cyclic_last_line %= LOG_SIZE_BUFFER_CYCLIC_LINES;
+        vsnprintf(temp, sizeof(temp), fmt, ap);
+
+        /* The hashing below is far too slow for the calling thread. */
+        log_push(log, LOG_REC_CYCLIC, temp);
+    }
+}
+
+/* Runs on the writer thread. */
+static void
+log_write_cyclic(log_t *log, char *temp)
+{
+    /* The log may have lost its cyclic buffer to log_fatal() or log_warning(). */
+    if (log->cyclic_buff == NULL) {
+        fprintf(stdlog, "%s", temp);
+        return;
+    }
 
-        vsprintf(temp, fmt, ap);
+    log->cyclic_last_line %= LOG_SIZE_BUFFER_CYCLIC_LINES;
 
-        log_copy(log, log->cyclic_buff[log->cyclic_last_line], temp,
-                 LOG_SIZE_BUFFER);
+    log_copy(log, log->cyclic_buff[log->cyclic_last_line], temp,
+             LOG_SIZE_BUFFER);
 
-        uint32_t hashes[LOG_SIZE_BUFFER_CYCLIC_LINES] = {0};
+    uint32_t hashes[LOG_SIZE_BUFFER_CYCLIC_LINES] = {0};
 
-        /* Random numbers. */
-        uint32_t base = 257;
-        uint32_t mod = 1000000007;
+    /* Random numbers. */
+    uint32_t base = 257;
+    uint32_t mod = 1000000007;
 
-        uint32_t repeat_order = 0;
-        bool is_cycle = false;
+    uint32_t repeat_order = 0;
+    bool is_cycle = false;
 
-        /* Compute the set of hashes for the current log buffer. */
-        for (int32_t log_line = 0; log_line < LOG_SIZE_BUFFER_CYCLIC_LINES;
-             log_line++) {
-            if (log->cyclic_buff[log_line][0] == '\0')
-                continue;    /* Skip. */
+    /* Compute the set of hashes for the current log buffer. */
+    for (int32_t log_line = 0; log_line < LOG_SIZE_BUFFER_CYCLIC_LINES;
+         log_line++) {
+        if (log->cyclic_buff[log_line][0] == '\0')
+            continue;    /* Skip. */
 
-            for (int32_t log_line_char = 0; log_line_char < LOG_SIZE_BUFFER;
-                log_line_char++)
-                hashes[log_line] = hashes[log_line] * base +
-                    log->cyclic_buff[log_line][log_line_char] % mod;
-        }
+        for (int32_t log_line_char = 0; log_line_char < LOG_SIZE_BUFFER;
+            log_line_char++)
+            hashes[log_line] = hashes[log_line] * base +
+                log->cyclic_buff[log_line][log_line_char] % mod;
+    }
 
+    /*
+       Now see if there are real cycles.
+       We implement a minimum repeat size.
+     */
+    for (int32_t check_size = LOG_MINIMUM_REPEAT_ORDER;
+         check_size < LOG_SIZE_BUFFER_CYCLIC_LINES / 2; check_size++) {
         /*
-           Now see if there are real cycles.
-           We implement a minimum repeat size.
+           TODO: Log what we need for cycle 1.
+           TODO: Command line option that lets us turn off this behaviour.
          */
-        for (int32_t check_size = LOG_MINIMUM_REPEAT_ORDER;
-             check_size < LOG_SIZE_BUFFER_CYCLIC_LINES / 2; check_size++) {
-            /*
-               TODO: Log what we need for cycle 1.
-               TODO: Command line option that lets us turn off this behaviour.
-             */
-            for (int32_t log_line_to_check = 0; log_line_to_check < check_size;
-                 log_line_to_check++) {
-                if (hashes[log_line_to_check] ==
-                    hashes[(log_line_to_check + check_size) %
-                    LOG_SIZE_BUFFER_CYCLIC_LINES]) {
-                    repeat_order = check_size;
-                    break;
-                }
+        for (int32_t log_line_to_check = 0; log_line_to_check < check_size;
+             log_line_to_check++) {
+            if (hashes[log_line_to_check] ==
+                hashes[(log_line_to_check + check_size) %
+                LOG_SIZE_BUFFER_CYCLIC_LINES]) {
+                repeat_order = check_size;
+                break;
             }
+        }
 
-            is_cycle = (repeat_order != 0);
+        is_cycle = (repeat_order != 0);
 
-            /* If there still is a cycle, break. */
-            if (is_cycle)
-                break;
-            
-        }
+        /* If there still is a cycle, break. */
+        if (is_cycle)
+            break;
+        
+    }
 
-        if (is_cycle) {
-            if (log->cyclic_last_line % repeat_order == 0) {
-                log->log_cycles++;
-
-                if (log->log_cycles == 1) {
-                    /* 
-                       'Replay' the last few log entries so they actually
-                       show up.
-
-                       TODO: Is this right?
-                     */
-
-                    for (uint32_t index = log->cyclic_last_line - 1;
-                         index > (log->cyclic_last_line - repeat_order);
-                         index--) {
-                        /* *Very important* to prevent out of bounds index. */
-                        uint32_t real_index = index %
-                                              LOG_SIZE_BUFFER_CYCLIC_LINES;
-                        log_copy(log, temp, log->cyclic_buff[real_index],
-                                 LOG_SIZE_BUFFER);
-
-                        fprintf(stdlog, "%s", log->cyclic_buff[real_index]);
-                    }
-
-                    /* Restore the original line. */
-                    log_copy(log, temp,
-                             log->cyclic_buff[log->cyclic_last_line],
+    if (is_cycle) {
+        if (log->cyclic_last_line % repeat_order == 0) {
+            log->log_cycles++;
+
+            if (log->log_cycles == 1) {
+                /* 
+                   'Replay' the last few log entries so they actually
+                   show up.
+
+                   TODO: Is this right?
+                 */
+
+                for (uint32_t index = log->cyclic_last_line - 1;
+                     index > (log->cyclic_last_line - repeat_order);
+                     index--) {
+                    /* *Very important* to prevent out of bounds index. */
+                    uint32_t real_index = index %
+                                          LOG_SIZE_BUFFER_CYCLIC_LINES;
+                    log_copy(log, temp, log->cyclic_buff[real_index],
                              LOG_SIZE_BUFFER);
 
-                    /* Allow normal logging. */
-                    fprintf(stdlog, "%s", temp);
+                    fprintf(stdlog, "%s", log->cyclic_buff[real_index]);
                 }
 
-                if (log->log_cycles > 1 && log->log_cycles < 100)
-                    fprintf(stdlog, "***** Cyclical Log Repeat of Order %d "
-                            "#%d *****\n", repeat_order, log->log_cycles);
-                else if (log->log_cycles == 100)
-                    fprintf(stdlog, "Logged the same cycle 100 times... "
-                            "Silence until something interesting happens\n");
+                /* Restore the original line. */
+                log_copy(log, temp,
+                         log->cyclic_buff[log->cyclic_last_line],
+                         LOG_SIZE_BUFFER);
+
+                /* Allow normal logging. */
+                fprintf(stdlog, "%s", temp);
             }
-        } else {
-            log->log_cycles = 0;
-            fprintf(stdlog, "%s", temp);
-        }
 
-        log->cyclic_last_line++;
+            if (log->log_cycles > 1 && log->log_cycles < 100)
+                fprintf(stdlog, "***** Cyclical Log Repeat of Order %d "
+                        "#%d *****\n", repeat_order, log->log_cycles);
+            else if (log->log_cycles == 100)
+                fprintf(stdlog, "Logged the same cycle 100 times... "
+                        "Silence until something interesting happens\n");
+        }
+    } else {
+        log->log_cycles = 0;
+        fprintf(stdlog, "%s", temp);
     }
+
+    log->cyclic_last_line++;
+}
+#else
+void
+log_flush(void)
+{
 }
 #endif
 
@@ -280,11 +533,15 @@ log_fatal(void *priv, const char *fmt, ...)
     if (log == NULL)
         return;
 
+    /* The writer thread may still be using the cyclic buffer. */
+    log_flush();
+
     if (log->cyclic_buff != NULL) {
         for (int i = 0; i < LOG_SIZE_BUFFER_CYCLIC_LINES; i++)
             if (log->cyclic_buff[i] != NULL)
                 free(log->cyclic_buff[i]);
         free(log->cyclic_buff);
+        log->cyclic_buff = NULL;
     }
 
     log_copy(log, fmt2, fmt, LOG_SIZE_BUFFER);
@@ -306,11 +563,15 @@ log_warning(void *priv, const char *fmt, ...)
     if (log == NULL)
         return;
 
+    /* The writer thread may still be using the cyclic buffer. */
+    log_flush();
+
     if (log->cyclic_buff != NULL) {
         for (int i = 0; i < LOG_SIZE_BUFFER_CYCLIC_LINES; i++)
             if (log->cyclic_buff[i] != NULL)
                 free(log->cyclic_buff[i]);
         free(log->cyclic_buff);
+        log->cyclic_buff = NULL;
     }
 
     log_copy(log, fmt2, fmt, LOG_SIZE_BUFFER);
@@ -361,5 +622,8 @@ log_close(void *priv)
 {
     log_t *log = (log_t *) priv;
 
+    /* Records still queued point at this log. */
+    log_flush();
+
     free(log);
 }
@@ -56,6 +56,17 @@ agpgart_set_aperture(agpgart_t *dev, uint32_t base, uint32_t size, int enable)
     dev->aperture_mask   = size - 1;
     dev->aperture_enable = enable;
 
+    /* Size the translation cache for one entry per aperture page. */
+    dev->cache_pages = 0;
+    free(dev->cache);
+    dev->cache = NULL;
+    if (dev->aperture_size >= 0x1000) {
+        dev->cache = (agpgart_page_t *) calloc(dev->aperture_size >> 12, sizeof(agpgart_page_t));
+        if (dev->cache != NULL)
+            dev->cache_pages = dev->aperture_size >> 12;
+    }
+    dev->cache_gen = mem_mapping_gen - 1;
+
     /* Enable new aperture mapping if requested. */
     if (dev->aperture_base && dev->aperture_size && dev->aperture_enable) {
         mem_mapping_set_addr(&dev->aperture_mapping, dev->aperture_base, dev->aperture_size);
@@ -70,6 +81,36 @@ agpgart_set_gart(agpgart_t *dev, uint32_t base)
 
     /* Set GART base address. */
     dev->gart_base = base;
+    dev->cache_gen = mem_mapping_gen - 1;
+}
+
+/*
+   Host pointers are only valid for the memory map they were looked up in.
+   The GART itself is read through its host RAM, so guest updates to the
+   table are seen right away without having to watch writes to it.
+ */
+static void
+agpgart_cache_check(agpgart_t *dev)
+{
+    uint32_t len = dev->cache_pages << 2;
+    uint8_t *start;
+    uint8_t *end;
+
+    if (dev->cache_gen == mem_mapping_gen)
+        return;
+
+    dev->cache_gen  = mem_mapping_gen;
+    dev->gart_table = NULL;
+    if (dev->cache_pages)
+        memset(dev->cache, 0x00, dev->cache_pages * sizeof(agpgart_page_t));
+
+    /* The table must be a single run of RAM to be read directly. */
+    if (len && !(dev->gart_base & 3) && ((dev->gart_base + len - 1) > dev->gart_base)) {
+        start = mem_get_phys_ptr(dev->gart_base, 0);
+        end   = mem_get_phys_ptr(dev->gart_base + len - 1, 0);
+        if ((start != NULL) && (end == (start + len - 1)))
+            dev->gart_table = (const uint32_t *) start;
+    }
 }
 
 static uint32_t
@@ -79,37 +120,80 @@ agpgart_translate(uint32_t addr, agpgart_t *dev)
     addr &= dev->aperture_mask;
 
     /* Get the GART pointer for this page. */
-    register uint32_t gart_ptr = mem_readl_phys(dev->gart_base + ((addr >> 10) & 0xfffffffc)) & 0xfffff000;
+    register uint32_t gart_ptr = (dev->gart_table ? dev->gart_table[addr >> 12] :
+                                                    mem_readl_phys(dev->gart_base + ((addr >> 10) & 0xfffffffc))) & 0xfffff000;
 
     /* Return remapped address with the page offset. */
     return gart_ptr | (addr & 0x00000fff);
 }
 
+/* Host RAM behind an aperture read that stays within one page, NULL if it must go through the memory map. */
+static const uint8_t *
+agpgart_read_ptr(uint32_t addr, int size, agpgart_t *dev)
+{
+    agpgart_page_t *page;
+    uint32_t        entry;
+
+    agpgart_cache_check(dev);
+
+    addr &= dev->aperture_mask;
+    if ((dev->gart_table == NULL) || ((addr & 0x00000fff) > (uint32_t) (0x1000 - size)))
+        return NULL;
+
+    page  = &dev->cache[addr >> 12];
+    entry = dev->gart_table[addr >> 12] & 0xfffff000;
+    if ((page->ptr == NULL) || (page->entry != entry)) {
+        page->entry = entry;
+        page->ptr   = mem_get_phys_ptr(entry, 0);
+        if (page->ptr == NULL)
+            return NULL;
+    }
+
+    return &page->ptr[addr & 0x00000fff];
+}
+
 static uint8_t
 agpgart_aperture_readb(uint32_t addr, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
+    agpgart_t     *dev = (agpgart_t *) priv;
+    const uint8_t *ptr = agpgart_read_ptr(addr, 1, dev);
+
+    if (ptr != NULL)
+        return *ptr;
+
     return mem_readb_phys(agpgart_translate(addr, dev));
 }
 
 static uint16_t
 agpgart_aperture_readw(uint32_t addr, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
+    agpgart_t     *dev = (agpgart_t *) priv;
+    const uint8_t *ptr = agpgart_read_ptr(addr, 2, dev);
+
+    if (ptr != NULL)
+        return *(const uint16_t *) ptr;
+
     return mem_readw_phys(agpgart_translate(addr, dev));
 }
 
 static uint32_t
 agpgart_aperture_readl(uint32_t addr, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
+    agpgart_t     *dev = (agpgart_t *) priv;
+    const uint8_t *ptr = agpgart_read_ptr(addr, 4, dev);
+
+    if (ptr != NULL)
+        return *(const uint32_t *) ptr;
+
     return mem_readl_phys(agpgart_translate(addr, dev));
 }
 
+/* Writes keep going through the memory map, for the dynamic recompiler's dirty page tracking. */
 static void
 agpgart_aperture_writeb(uint32_t addr, uint8_t val, void *priv)
 {
     agpgart_t *dev = (agpgart_t *) priv;
+    agpgart_cache_check(dev);
     mem_writeb_phys(agpgart_translate(addr, dev), val);
 }
 
@@ -117,6 +201,7 @@ static void
 agpgart_aperture_writew(uint32_t addr, uint16_t val, void *priv)
 {
     agpgart_t *dev = (agpgart_t *) priv;
+    agpgart_cache_check(dev);
     mem_writew_phys(agpgart_translate(addr, dev), val);
 }
 
@@ -124,6 +209,7 @@ static void
 agpgart_aperture_writel(uint32_t addr, uint32_t val, void *priv)
 {
     agpgart_t *dev = (agpgart_t *) priv;
+    agpgart_cache_check(dev);
     mem_writel_phys(agpgart_translate(addr, dev), val);
 }
 
@@ -154,6 +240,7 @@ agpgart_close(void *priv)
     /* Disable aperture. */
     mem_mapping_disable(&dev->aperture_mapping);
 
+    free(dev->cache);
     free(dev);
 }
 
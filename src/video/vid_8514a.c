@@ -1040,6 +1040,104 @@ ibm8514_short_stroke_start(int count, int cpu_input, uint32_t mix_dat, uint32_t
     ibm8514_accel_start(count, cpu_input, mix_dat, cpu_dat, svga, len);
 }
 
+/*
+ * Row at a time fill of a solid colour rectangle with no colour compare,
+ * used instead of the pixel loop for the mixes that do not depend on the
+ * destination. Clipping is resolved once per row and the write mask is
+ * only merged in when it is partial. Returns 0 if the mix is not handled.
+ */
+static int
+ibm8514_accel_fill_rect(svga_t *svga, ibm8514_t *dev, uint16_t src_dat, uint16_t wrt_mask,
+                        int clip_t, int clip_l, int clip_b, int clip_r, int cmd)
+{
+    uint16_t *vram_w = (uint16_t *) dev->vram;
+    uint32_t  mask   = dev->bpp ? (dev->vram_mask >> 1) : dev->vram_mask;
+    int       shift  = dev->bpp ? 11 : 12;
+    int       width  = (dev->accel.maj_axis_pcnt & 0x7ff) + 1;
+    int       full;
+    int       x_l;
+    int       x_r;
+    int       x;
+    uint32_t  addr;
+    uint32_t  block;
+
+    switch (dev->accel.frgd_mix) {
+        case 0x01:
+            src_dat = 0;
+            break;
+        case 0x02:
+            src_dat = 0xffff;
+            break;
+        case 0x04:
+            src_dat = ~src_dat;
+            break;
+        case 0x07:
+            break;
+
+        default:
+            return 0;
+    }
+
+    if (!dev->bpp) {
+        src_dat &= 0xff;
+        wrt_mask &= 0xff;
+        full = (wrt_mask == 0xff);
+    } else
+        full = (wrt_mask == 0xffff);
+
+    if (dev->accel.cmd & 0x20) {
+        x_l = dev->accel.cx;
+        x_r = dev->accel.cx + width - 1;
+    } else {
+        x_l = dev->accel.cx - width + 1;
+        x_r = dev->accel.cx;
+    }
+    if (x_l < clip_l)
+        x_l = clip_l;
+    if (x_r > clip_r)
+        x_r = clip_r;
+
+    while (dev->accel.sy >= 0) {
+        if ((x_l <= x_r) && (dev->accel.cy >= clip_t) && (dev->accel.cy <= clip_b)) {
+            dev->subsys_stat |= INT_GE_BSY;
+
+            if (dev->accel.cmd & 0x10) {
+                block = 0xffffffff;
+                for (x = x_l; x <= x_r; x++) {
+                    addr = (dev->accel.dest + x) & mask;
+                    if (dev->bpp)
+                        vram_w[addr] = full ? src_dat : ((src_dat & wrt_mask) | (vram_w[addr] & ~wrt_mask));
+                    else
+                        dev->vram[addr] = full ? src_dat : ((src_dat & wrt_mask) | (dev->vram[addr] & ~wrt_mask));
+
+                    if ((addr >> shift) != block) {
+                        block                   = addr >> shift;
+                        dev->changedvram[block] = svga->monitor->mon_changeframecount;
+                    }
+                }
+            }
+        }
+
+        if (dev->accel.cmd & 0x80)
+            dev->accel.cy++;
+        else
+            dev->accel.cy--;
+
+        dev->accel.dest = dev->accel.ge_offset + (dev->accel.cy * dev->pitch);
+        dev->accel.sy--;
+    }
+
+    dev->accel.fill_state = 0;
+    dev->accel.sx         = dev->accel.maj_axis_pcnt & 0x7ff;
+    if (cmd != 4) {
+        dev->accel.cur_x = dev->accel.cx;
+        dev->accel.cur_y = dev->accel.cy;
+    }
+    dev->fifo_idx       = 0;
+    dev->accel.cmd_back = 1;
+    return 1;
+}
+
 void
 ibm8514_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, svga_t *svga, UNUSED(int len))
 {
@@ -2484,6 +2582,12 @@ skip_nibble_rect_write:
                         }
                     } else {
                         ibm8514_log("Polygon Draw Type=%02x, CX=%d, CY=%d, SY=%d, CL=%d, CR=%d, frgdmix=%d, bkgdmix=%d, cmpmode=%02x, pitch=%d.\n", dev->accel.multifunc[0x0a] & 0x06, dev->accel.cx, dev->accel.cy, dev->accel.sy, clip_l, clip_r, frgd_mix, bkgd_mix, compare_mode, dev->pitch);
+                        if ((old_mix_dat == 0xffffffff) && (frgd_mix <= 1) && !compare_mode &&
+                            !(dev->accel.multifunc[0x0a] & 0x06) &&
+                            ibm8514_accel_fill_rect(svga, dev, frgd_mix ? frgd_color : bkgd_color, wrt_mask,
+                                                    clip_t, clip_l, clip_b, clip_r, cmd))
+                            return;
+
                         while (count-- && (dev->accel.sy >= 0)) {
                             if ((dev->accel.cx >= clip_l) &&
                                 (dev->accel.cx <= clip_r) &&
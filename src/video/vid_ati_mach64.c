@@ -1632,6 +1632,123 @@ mach64_start_line(mach64_t *mach64)
         svga->changedvram[(((addr) >> 3) & mach64->vram_mask) >> 12] = svga->monitor->mon_changeframecount; \
     }
 
+/*
+ * Solid fills are the bulk of GDI traffic, so give them their own kernel:
+ * every pixel of such a fill takes the same source, mix and compare
+ * decisions, leaving only the scissor test, which is done once per row.
+ * The width argument is a constant at each call site, letting the compiler
+ * emit a separate loop per pixel size from the READ/WRITE macros.
+ */
+static __inline void
+mach64_fill_span(mach64_t *mach64, uint32_t addr, int count, uint32_t src_dat, int partial, int width)
+{
+    svga_t  *svga = &mach64->svga;
+    uint32_t dest_dat;
+    uint32_t old_dest_dat;
+
+    while (count--) {
+        dest_dat = src_dat;
+        if (partial) {
+            READ(addr, old_dest_dat, width);
+            dest_dat = (src_dat & mach64->accel.write_mask) | (old_dest_dat & ~mach64->accel.write_mask);
+        }
+        WRITE(addr, width);
+        addr++;
+    }
+}
+
+static int
+mach64_blit_fill(mach64_t *mach64)
+{
+    uint32_t src_dat  = mach64->accel.dp_frgd_clr;
+    uint32_t pix_mask = 0xffffffff;
+    int      x_first  = mach64->accel.dst_x_start;
+    int      x_last   = mach64->accel.dst_x_start + ((mach64->accel.dst_width - 1) * mach64->accel.xinc);
+    int      x_start;
+    int      x_end;
+    int      partial;
+    int      dst_y;
+
+    if ((mach64->accel.source_mix != MONO_SRC_1) || (mach64->accel.source_fg != SRC_FG) ||
+        (mach64->dst_cntl & (DST_24_ROT_EN | DST_POLYGON_EN)) ||
+        (mach64->accel.clr_cmp_fn == 1) || (mach64->accel.clr_cmp_fn == 4) || (mach64->accel.clr_cmp_fn == 5) ||
+        (mach64->accel.dst_size == WIDTH_1BIT) || (mach64->accel.dst_width <= 0) || (mach64->accel.dst_height <= 0))
+        return 0;
+
+    switch (mach64->accel.mix_fg) {
+        case 0x1:
+            src_dat = 0;
+            break;
+        case 0x2:
+            src_dat = 0xffffffff;
+            break;
+        case 0x4:
+            src_dat = ~src_dat;
+            break;
+        case 0x7:
+            break;
+
+        default:
+            return 0;
+    }
+
+    if (x_first > x_last) {
+        x_start = x_last;
+        x_end   = x_first;
+    } else {
+        x_start = x_first;
+        x_end   = x_last;
+    }
+
+    /*Rows that wrap around the 12-bit X coordinate stay on the generic path.*/
+    if ((x_start < 0) || (x_end > 0xfff))
+        return 0;
+
+    if (x_start < mach64->accel.sc_left)
+        x_start = mach64->accel.sc_left;
+    if (x_end > mach64->accel.sc_right)
+        x_end = mach64->accel.sc_right;
+
+    if (mach64->accel.dst_size == 0)
+        pix_mask = 0xff;
+    else if (mach64->accel.dst_size == 1)
+        pix_mask = 0xffff;
+    partial = (mach64->accel.write_mask & pix_mask) != pix_mask;
+
+    while (mach64->accel.dst_height > 0) {
+        dst_y = (mach64->accel.dst_y + mach64->accel.dst_y_start) & 0x3fff;
+
+        if ((x_start <= x_end) && (dst_y >= mach64->accel.sc_top) && (dst_y <= mach64->accel.sc_bottom)) {
+            uint32_t addr  = mach64->accel.dst_offset + (dst_y * mach64->accel.dst_pitch) + x_start;
+            int      count = x_end - x_start + 1;
+
+            switch (mach64->accel.dst_size) {
+                case 0:
+                    mach64_fill_span(mach64, addr, count, src_dat, partial, 0);
+                    break;
+                case 1:
+                    mach64_fill_span(mach64, addr, count, src_dat, partial, 1);
+                    break;
+                default:
+                    mach64_fill_span(mach64, addr, count, src_dat, partial, 2);
+                    break;
+            }
+        }
+
+        mach64->accel.dst_y += mach64->accel.yinc;
+        mach64->accel.dst_height--;
+    }
+
+    mach64_log("mach64 blit finished\n");
+    mach64->accel.x_count = mach64->accel.dst_width;
+    mach64->accel.busy    = 0;
+    if (mach64->dst_cntl & DST_X_TILE)
+        mach64->dst_y_x = (mach64->dst_y_x & 0xfff) | ((mach64->dst_y_x + (mach64->accel.dst_width << 16)) & 0xfff0000);
+    if (mach64->dst_cntl & DST_Y_TILE)
+        mach64->dst_y_x = (mach64->dst_y_x & 0xfff0000) | ((mach64->dst_y_x + (mach64->dst_height_width & 0x1fff)) & 0xfff);
+    return 1;
+}
+
 void
 mach64_blit(uint32_t cpu_dat, int count, mach64_t *mach64)
 {
@@ -1646,6 +1763,9 @@ mach64_blit(uint32_t cpu_dat, int count, mach64_t *mach64)
 
     switch (mach64->accel.op) {
         case OP_RECT:
+            if ((count == -1) && mach64_blit_fill(mach64))
+                return;
+
             while (count) {
                 uint8_t  write_mask = 0;
                 uint32_t src_dat = 0;
@@ -4916,7 +5036,7 @@ mach64_common_init(const device_t *info)
     mach64->thread_run = 1;
     mach64->wake_fifo_thread = thread_create_event();
     mach64->fifo_not_full_event = thread_create_event();
-    mach64->fifo_thread = thread_create(fifo_thread, mach64);
+    mach64->fifo_thread = thread_create_role(fifo_thread, mach64, THREAD_ROLE_RENDER);
     mach64->on_board = !!(info->local & (1 << 19));
 
     mach64->i2c = i2c_gpio_init("ddc_ati_mach64");
@@ -220,6 +220,17 @@ Composite_Process(uint8_t cgamode, uint8_t border, uint32_t blocks /*, bool doub
     int            *ap;
     int            *bp;
 
+    /* The decode coefficients are whole numbers kept in volatile doubles so
+       the UI thread can change them; take an integer copy once per line so
+       the loops below stay in integer arithmetic and can be vectorized. */
+    const int sharp = video_sharpness;
+    const int ri    = (int) video_ri;
+    const int rq    = (int) video_rq;
+    const int gi    = (int) video_gi;
+    const int gq    = (int) video_gq;
+    const int bi    = (int) video_bi;
+    const int bq    = (int) video_bq;
+
 #define COMPOSITE_CONVERT(I, Q)                                                  \
     do {                                                                         \
         i[1] = (i[1] << 3) - ap[1];                                              \
@@ -227,10 +238,10 @@ Composite_Process(uint8_t cgamode, uint8_t border, uint32_t blocks /*, bool doub
         b    = bp[0];                                                            \
         c    = i[0] + i[0];                                                      \
         d    = i[-1] + i[1];                                                     \
-        y    = ((c + d) << 8) + video_sharpness * (c - d);                       \
-        rr   = y + video_ri * (I) + video_rq * (Q);                              \
-        gg   = y + video_gi * (I) + video_gq * (Q);                              \
-        bb   = y + video_bi * (I) + video_bq * (Q);                              \
+        y    = ((c + d) << 8) + sharp * (c - d);                                 \
+        rr   = y + ri * (I) + rq * (Q);                                          \
+        gg   = y + gi * (I) + gq * (Q);                                          \
+        bb   = y + bi * (I) + bq * (Q);                                          \
         ++i;                                                                     \
         ++ap;                                                                    \
         ++bp;                                                                    \
@@ -266,7 +277,7 @@ Composite_Process(uint8_t cgamode, uint8_t border, uint32_t blocks /*, bool doub
         for (x2 = 0; x2 < blocks * 4; ++x2) {
             int c = (i[0] + i[0]) << 3;
             int d = (i[-1] + i[1]) << 3;
-            int y = ((c + d) << 8) + video_sharpness * (c - d);
+            int y = ((c + d) << 8) + sharp * (c - d);
             ++i;
             *srgb = byte_clamp(y) * 0x10101;
             ++srgb;
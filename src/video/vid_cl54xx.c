@@ -31,6 +31,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/device.h>
+#include <86box/device_worker.h>
 #include <86box/machine.h>
 #include <86box/timer.h>
 #include <86box/video.h>
@@ -272,6 +273,9 @@ typedef struct gd54xx_t {
 
     void *i2c;
     void *ddc;
+
+    /* Runs screen to screen BitBLTs off the CPU thread. */
+    device_worker_t *blt_worker;
 } gd54xx_t;
 
 static video_timings_t timing_gd54xx_isa = { .type = VIDEO_ISA,
@@ -310,6 +314,18 @@ gd54xx_reset_blit(gd54xx_t *gd54xx);
 static void
 gd54xx_start_blit(uint32_t cpu_dat, uint32_t count, gd54xx_t *gd54xx, svga_t *svga);
 
+/*
+ * BitBLTs that only touch video memory are handed to the blit worker and run
+ * while the CPU carries on. Every register, I/O and video memory access waits
+ * for an outstanding blit first, so the guest never sees one half done.
+ */
+static __inline void
+gd54xx_blt_sync(gd54xx_t *gd54xx)
+{
+    if (gd54xx->blt_worker != NULL)
+        device_worker_sync(gd54xx->blt_worker);
+}
+
 #define CLAMP(x)                      \
     do {                              \
         if ((x) & ~0xff)              \
@@ -693,6 +709,8 @@ gd54xx_out(uint16_t addr, uint8_t val, void *priv)
     uint8_t   index;
     uint32_t  o32;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (((addr & 0xfff0) == 0x3d0 || (addr & 0xfff0) == 0x3b0) && !(svga->miscout & 1))
         addr ^= 0x60;
 
@@ -913,6 +931,7 @@ gd54xx_out(uint16_t addr, uint8_t val, void *priv)
                         svga->pallook[index]  = makecol32(video_6to8[svga->vgapal[index].r & 0x3f],
                                                           video_6to8[svga->vgapal[index].g & 0x3f],
                                                           video_6to8[svga->vgapal[index].b & 0x3f]);
+                        svga->pal_gen++;
                     }
                     svga->dac_addr = (svga->dac_addr + 1) & 255;
                     svga->dac_pos  = 0;
@@ -1279,6 +1298,8 @@ gd54xx_in(uint16_t addr, void *priv)
     uint8_t index;
     uint8_t ret = 0xff;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (((addr & 0xfff0) == 0x3d0 || (addr & 0xfff0) == 0x3b0) && !(svga->miscout & 1))
         addr ^= 0x60;
 
@@ -2274,6 +2295,8 @@ gd54xx_write(uint32_t addr, uint8_t val, void *priv)
     svga_t   *svga   = (svga_t *) priv;
     gd54xx_t *gd54xx = (gd54xx_t *) svga->local;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest &&
         !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         gd54xx_mem_sys_src_write(gd54xx, val, 0);
@@ -2293,6 +2316,8 @@ gd54xx_writew(uint32_t addr, uint16_t val, void *priv)
     svga_t   *svga   = (svga_t *) priv;
     gd54xx_t *gd54xx = (gd54xx_t *) svga->local;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest &&
         !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         if ((gd54xx->blt.mode & CIRRUS_BLTMODE_COLOREXPAND) && (gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_DWORDGRANULARITY))
@@ -2323,6 +2348,8 @@ gd54xx_writel(uint32_t addr, uint32_t val, void *priv)
     svga_t   *svga   = (svga_t *) priv;
     gd54xx_t *gd54xx = (gd54xx_t *) svga->local;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest &&
         !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         if ((gd54xx->blt.mode & CIRRUS_BLTMODE_COLOREXPAND) && (gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_DWORDGRANULARITY))
@@ -2438,6 +2465,9 @@ gd54xx_readb_linear(uint32_t addr, void *priv)
     svga_t   *svga   = &gd54xx->svga;
 
     uint8_t ap = gd54xx_get_aperture(gd54xx, addr);
+
+    gd54xx_blt_sync(gd54xx);
+
     addr &= 0x003fffff; /* 4 MB mask */
 
     if (!(svga->seqregs[0x07] & CIRRUS_SR7_BPP_SVGA))
@@ -2486,6 +2516,8 @@ gd54xx_readw_linear(uint32_t addr, void *priv)
     uint8_t  ap = gd54xx_get_aperture(gd54xx, addr);
     uint16_t temp;
 
+    gd54xx_blt_sync(gd54xx);
+
     addr &= 0x003fffff; /* 4 MB mask */
 
     if (!(svga->seqregs[0x07] & CIRRUS_SR7_BPP_SVGA))
@@ -2540,6 +2572,8 @@ gd54xx_readl_linear(uint32_t addr, void *priv)
     uint8_t  ap = gd54xx_get_aperture(gd54xx, addr);
     uint32_t temp;
 
+    gd54xx_blt_sync(gd54xx);
+
     addr &= 0x003fffff; /* 4 MB mask */
 
     if (!(svga->seqregs[0x07] & CIRRUS_SR7_BPP_SVGA))
@@ -2600,6 +2634,8 @@ gd5436_aperture2_readb(UNUSED(uint32_t addr), void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
     uint8_t  ap = gd54xx_get_aperture(gd54xx, addr);
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && gd54xx->blt.ms_is_dest &&
         gd54xx_aperture2_enabled(gd54xx) && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED))
         return gd54xx_mem_sys_dest_read(gd54xx, ap);
@@ -2613,6 +2649,8 @@ gd5436_aperture2_readw(uint32_t addr, void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
     uint16_t  ret    = 0xffff;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && gd54xx->blt.ms_is_dest &&
         gd54xx_aperture2_enabled(gd54xx) && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         ret = gd5436_aperture2_readb(addr, priv);
@@ -2629,6 +2667,8 @@ gd5436_aperture2_readl(uint32_t addr, void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
     uint32_t  ret    = 0xffffffff;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && gd54xx->blt.ms_is_dest &&
         gd54xx_aperture2_enabled(gd54xx) && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         ret = gd5436_aperture2_readb(addr, priv);
@@ -2647,6 +2687,8 @@ gd5436_aperture2_writeb(UNUSED(uint32_t addr), uint8_t val, void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
     uint8_t  ap = gd54xx_get_aperture(gd54xx, addr);
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest &&
         gd54xx_aperture2_enabled(gd54xx) && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED))
         gd54xx_mem_sys_src_write(gd54xx, val, ap);
@@ -2657,6 +2699,8 @@ gd5436_aperture2_writew(uint32_t addr, uint16_t val, void *priv)
 {
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest &&
         gd54xx_aperture2_enabled(gd54xx) && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         gd5436_aperture2_writeb(addr, val, gd54xx);
@@ -2669,6 +2713,8 @@ gd5436_aperture2_writel(uint32_t addr, uint32_t val, void *priv)
 {
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest &&
         gd54xx_aperture2_enabled(gd54xx) && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         gd5436_aperture2_writeb(addr, val, gd54xx);
@@ -2686,6 +2732,8 @@ gd54xx_writeb_linear(uint32_t addr, uint8_t val, void *priv)
 
     uint8_t ap       = gd54xx_get_aperture(gd54xx, addr);
 
+    gd54xx_blt_sync(gd54xx);
+
     if (!(svga->seqregs[0x07] & CIRRUS_SR7_BPP_SVGA)) {
         svga_write_linear(addr, val, svga);
         return;
@@ -2738,6 +2786,8 @@ gd54xx_writew_linear(uint32_t addr, uint16_t val, void *priv)
     uint32_t  old_addr = addr;
     uint8_t ap         = gd54xx_get_aperture(gd54xx, addr);
 
+    gd54xx_blt_sync(gd54xx);
+
     if (!(svga->seqregs[0x07] & CIRRUS_SR7_BPP_SVGA)) {
         svga_writew_linear(addr, val, svga);
         return;
@@ -2810,6 +2860,8 @@ gd54xx_writel_linear(uint32_t addr, uint32_t val, void *priv)
     uint32_t  old_addr = addr;
     uint8_t ap         = gd54xx_get_aperture(gd54xx, addr);
 
+    gd54xx_blt_sync(gd54xx);
+
     if (!(svga->seqregs[0x07] & CIRRUS_SR7_BPP_SVGA)) {
         svga_writel_linear(addr, val, svga);
         return;
@@ -2892,6 +2944,8 @@ gd54xx_read(uint32_t addr, void *priv)
     svga_t   *svga   = (svga_t *) priv;
     gd54xx_t *gd54xx = (gd54xx_t *) svga->local;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && gd54xx->blt.ms_is_dest &&
         !(gd54xx->blt.status & CIRRUS_BLT_PAUSED))
         return gd54xx_mem_sys_dest_read(gd54xx, 0);
@@ -2910,6 +2964,8 @@ gd54xx_readw(uint32_t addr, void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) svga->local;
     uint16_t  ret;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && gd54xx->blt.ms_is_dest &&
         !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         ret = gd54xx_read(addr, svga);
@@ -2932,6 +2988,8 @@ gd54xx_readl(uint32_t addr, void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) svga->local;
     uint32_t  ret;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd54xx->countminusone && gd54xx->blt.ms_is_dest &&
         !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         ret = gd54xx_read(addr, svga);
@@ -2960,6 +3018,23 @@ gd543x_do_mmio(svga_t *svga, uint32_t addr)
         return ((addr & ~0xff) == 0xb8000);
 }
 
+static void
+gd54xx_blt_worker(void *priv, UNUSED(uint8_t type), UNUSED(uint32_t addr), UNUSED(uint32_t val))
+{
+    gd54xx_t *gd54xx = (gd54xx_t *) priv;
+
+    gd54xx_start_blit(0, 0xffffffff, gd54xx, &gd54xx->svga);
+}
+
+static void
+gd54xx_queue_blit(gd54xx_t *gd54xx, svga_t *svga)
+{
+    if ((gd54xx->blt_worker == NULL) || (gd54xx->blt.mode & (CIRRUS_BLTMODE_MEMSYSSRC | CIRRUS_BLTMODE_MEMSYSDEST)))
+        gd54xx_start_blit(0, 0xffffffff, gd54xx, svga);
+    else
+        device_worker_post(gd54xx->blt_worker, DEVICE_POST_USER, 0, 0);
+}
+
 static void
 gd543x_mmio_write(uint32_t addr, uint8_t val, void *priv)
 {
@@ -2967,6 +3042,8 @@ gd543x_mmio_write(uint32_t addr, uint8_t val, void *priv)
     svga_t   *svga   = &gd54xx->svga;
     uint8_t   old;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd543x_do_mmio(svga, addr)) {
         switch (addr & 0xff) {
             case 0x00:
@@ -3063,7 +3140,7 @@ gd543x_mmio_write(uint32_t addr, uint8_t val, void *priv)
                     (gd54xx->blt.status & CIRRUS_BLT_AUTOSTART) &&
                     !(gd54xx->blt.status & CIRRUS_BLT_BUSY)) {
                     gd54xx->blt.status |= CIRRUS_BLT_BUSY;
-                    gd54xx_start_blit(0, 0xffffffff, gd54xx, svga);
+                    gd54xx_queue_blit(gd54xx, svga);
                 }
                 break;
 
@@ -3120,7 +3197,7 @@ gd543x_mmio_write(uint32_t addr, uint8_t val, void *priv)
                     gd54xx_reset_blit(gd54xx);
                 else if (!(old & CIRRUS_BLT_START) && (gd54xx->blt.status & CIRRUS_BLT_START)) {
                     gd54xx->blt.status |= CIRRUS_BLT_BUSY;
-                    gd54xx_start_blit(0, 0xffffffff, gd54xx, svga);
+                    gd54xx_queue_blit(gd54xx, svga);
                 }
                 break;
 
@@ -3137,6 +3214,8 @@ gd543x_mmio_writeb(uint32_t addr, uint8_t val, void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
     svga_t   *svga   = &gd54xx->svga;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (!gd543x_do_mmio(svga, addr) && !gd54xx->blt.ms_is_dest && gd54xx->countminusone &&
         !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
         gd54xx_mem_sys_src_write(gd54xx, val, 0);
@@ -3152,6 +3231,8 @@ gd543x_mmio_writew(uint32_t addr, uint16_t val, void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
     svga_t   *svga   = &gd54xx->svga;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd543x_do_mmio(svga, addr)) {
         gd543x_mmio_write(addr, val & 0xff, gd54xx);
         gd543x_mmio_write(addr + 1, val >> 8, gd54xx);
@@ -3173,6 +3254,8 @@ gd543x_mmio_writel(uint32_t addr, uint32_t val, void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
     svga_t   *svga   = &gd54xx->svga;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd543x_do_mmio(svga, addr)) {
         gd543x_mmio_write(addr, val & 0xff, gd54xx);
         gd543x_mmio_write(addr + 1, val >> 8, gd54xx);
@@ -3201,6 +3284,8 @@ gd543x_mmio_read(uint32_t addr, void *priv)
     svga_t   *svga   = &gd54xx->svga;
     uint8_t   ret    = 0xff;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd543x_do_mmio(svga, addr)) {
         switch (addr & 0xff) {
             case 0x00:
@@ -3343,6 +3428,8 @@ gd543x_mmio_readw(uint32_t addr, void *priv)
     svga_t   *svga   = &gd54xx->svga;
     uint16_t  ret    = 0xffff;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd543x_do_mmio(svga, addr))
         ret = gd543x_mmio_read(addr, gd54xx) | (gd543x_mmio_read(addr + 1, gd54xx) << 8);
     else if (gd54xx->mmio_vram_overlap)
@@ -3364,6 +3451,8 @@ gd543x_mmio_readl(uint32_t addr, void *priv)
     svga_t   *svga   = &gd54xx->svga;
     uint32_t  ret    = 0xffffffff;
 
+    gd54xx_blt_sync(gd54xx);
+
     if (gd543x_do_mmio(svga, addr))
         ret = gd543x_mmio_read(addr, gd54xx) | (gd543x_mmio_read(addr + 1, gd54xx) << 8) |
               (gd543x_mmio_read(addr + 2, gd54xx) << 16) |
@@ -4149,6 +4238,8 @@ gd54xx_reset(void *priv)
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
     svga_t   *svga   = &gd54xx->svga;
 
+    gd54xx_blt_sync(gd54xx);
+
     memset(svga->crtc, 0x00, sizeof(svga->crtc));
     memset(svga->seqregs, 0x00, sizeof(svga->seqregs));
     memset(svga->gdcreg, 0x00, sizeof(svga->gdcreg));
@@ -4423,6 +4514,7 @@ gd54xx_init(const device_t *info)
         video_inform(VIDEO_FLAG_TYPE_SPECIAL, &timing_gd54xx_vlb);
 
     if (id >= CIRRUS_ID_CLGD5426) {
+        gd54xx->blt_worker = device_worker_create("GD54xx BitBLT", gd54xx_blt_worker, gd54xx);
         svga_init(info, &gd54xx->svga, gd54xx, gd54xx->vram_size,
                   gd54xx_recalctimings, gd54xx_in, gd54xx_out,
                   gd54xx_hwcursor_draw, gd54xx_overlay_draw);
@@ -4706,6 +4798,8 @@ gd54xx_close(void *priv)
 {
     gd54xx_t *gd54xx = (gd54xx_t *) priv;
 
+    device_worker_close(gd54xx->blt_worker);
+
     svga_close(&gd54xx->svga);
 
     if (gd54xx->i2c) {
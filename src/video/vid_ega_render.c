@@ -217,8 +217,9 @@ ega_render_graphics(ega_t *ega)
     const bool    crtcreset   = ((ega->crtc[0x17] & 0x80) == 0);
     const bool    seq9dot       = ((ega->seqregs[1] & 1) == 0);
     const bool    seqoddeven  = ((ega->seqregs[1] & 4) != 0);
-    const uint8_t blinkmask   = (attrblink ? 0x8 : 0x0);
-    const uint8_t blinkval    = (attrblink && blinked ? 0x8 : 0x0);
+    const uint32_t planemask  = 0x11111111 * (uint32_t) (ega->plane_mask & 0x0f);
+    const uint32_t blinkmask  = (attrblink ? 0x88888888 : 0x0);
+    const uint32_t blinkval   = (attrblink && blinked ? 0x88888888 : 0x0);
     uint32_t     *p           = &buffer32->line[ega->displine + ega->y_add][ega->x_add];
     const int     dwshift     = doublewidth ? 1 : 0;
     const int     dotwidth    = 1 << dwshift;
@@ -265,18 +266,20 @@ ega_render_graphics(ega_t *ega)
         }
 
         if (!crtcreset) {
+            /* All 8 pixels to 4bpp chunky at once, in the order of the SVGA renderer. */
+            uint32_t dat = egaplanarlookup[0][edat[0]] | egaplanarlookup[1][edat[1]] |
+                           egaplanarlookup[2][edat[2]] | egaplanarlookup[3][edat[3]];
+            uint32_t shift = (002461357) << 2;
+
+            // FIXME: Confirm blink behaviour is actually XOR on real hardware
+            dat = ((dat & planemask & ~blinkmask) | ((dat | ~planemask) & blinkmask & blinkval)) ^ blinkmask;
+
             for (int i = 0; i < 8; i += 2) {
                 const int outoffs = i << dwshift;
-                const int inshift = 6 - i;
-                uint8_t   dat     = (edatlookup[(edat[0] >> inshift) & 3][(edat[1] >> inshift) & 3])
-                    | (edatlookup[(edat[2] >> inshift) & 3][(edat[3] >> inshift) & 3] << 2);
-                // FIXME: Confirm blink behaviour is actually XOR on real hardware
-                uint32_t c0 = (dat >> 4) & 0xF;
-                uint32_t c1 = dat & 0xF;
-                c0 = ((c0 & ega->plane_mask & ~blinkmask) |
-                     ((c0 | ~ega->plane_mask) & blinkmask & blinkval)) ^ blinkmask;
-                c1 = ((c1 & ega->plane_mask & ~blinkmask) |
-                     ((c1 | ~ega->plane_mask) & blinkmask & blinkval)) ^ blinkmask;
+                uint32_t  c0      = (dat >> (shift & 0x1C)) & 0xF;
+                shift >>= 3;
+                uint32_t  c1      = (dat >> (shift & 0x1C)) & 0xF;
+                shift >>= 3;
                 uint32_t p0 = ega->pallook[ega->egapal[c0]];
                 uint32_t p1 = ega->pallook[ega->egapal[c1]];
                 for (int subx = 0; subx < dotwidth; subx++)
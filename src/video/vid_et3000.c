@@ -277,6 +277,7 @@ et3000_out(uint16_t addr, uint8_t val, void *priv)
                             svga->pallook[index] = makecol32(video_6to8[svga->vgapal[index].r & 0x3f],
                                                              video_6to8[svga->vgapal[index].g & 0x3f],
                                                              video_6to8[svga->vgapal[index].b & 0x3f]);
+                        svga->pal_gen++;
                     }
                     svga->dac_pos  = 0;
                     svga->dac_addr = (svga->dac_addr + 1) & 255;
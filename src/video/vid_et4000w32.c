@@ -31,6 +31,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/device.h>
+#include <86box/device_worker.h>
 #include <86box/timer.h>
 #include <86box/plat.h>
 #include <86box/video.h>
@@ -139,6 +140,9 @@ typedef struct et4000w32p_t {
     } mmu;
 
     volatile int busy;
+
+    /* Runs the MMU aperture and accelerator writes off the CPU thread. */
+    device_worker_t *acl_worker;
 } et4000w32p_t;
 
 static int et4000w32_vbus[4] = { 1, 2, 4, 4 };
@@ -189,6 +193,8 @@ et4000w32p_out(uint16_t addr, uint8_t val, void *priv)
     uint8_t       old;
     uint32_t      add2addr = 0;
 
+    device_worker_sync(et4000->acl_worker);
+
     if (((addr & 0xfff0) == 0x3d0 || (addr & 0xfff0) == 0x3b0) && !(svga->miscout & 1))
         addr ^= 0x60;
 
@@ -378,6 +384,8 @@ et4000w32p_in(uint16_t addr, void *priv)
     svga_t       *svga   = &et4000->svga;
     uint8_t       temp   = 0x00;
 
+    device_worker_sync(et4000->acl_worker);
+
     if (((addr & 0xfff0) == 0x3d0 || (addr & 0xfff0) == 0x3b0) && !(svga->miscout & 1))
         addr ^= 0x60;
 
@@ -970,7 +978,7 @@ et4000w32p_accel_write_mmu(et4000w32p_t *et4000, uint32_t addr, uint8_t val, uin
 }
 
 static void
-et4000w32p_mmu_write(uint32_t addr, uint8_t val, void *priv)
+et4000w32p_mmu_write_worker(void *priv, UNUSED(uint8_t type), uint32_t addr, uint32_t val)
 {
     et4000w32p_t *et4000 = (et4000w32p_t *) priv;
     svga_t       *svga   = &et4000->svga;
@@ -1051,6 +1059,129 @@ et4000w32p_mmu_write(uint32_t addr, uint8_t val, void *priv)
     }
 }
 
+/*
+ * Writes to the MMU aperture (banked VRAM, accelerator registers and
+ * accelerator data) are posted to the worker thread in order, so the
+ * blitter runs while the CPU carries on. Anything that can observe their
+ * effect - aperture reads, the frame buffer mappings and the I/O ports -
+ * waits for the worker to drain first.
+ */
+static void
+et4000w32p_mmu_write(uint32_t addr, uint8_t val, void *priv)
+{
+    const et4000w32p_t *et4000 = (et4000w32p_t *) priv;
+
+    device_worker_post(et4000->acl_worker, DEVICE_POST_WRITE_B, addr, val);
+}
+
+static uint8_t
+et4000w32p_read(uint32_t addr, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    return svga_read(addr, priv);
+}
+
+static uint16_t
+et4000w32p_readw(uint32_t addr, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    return svga_readw(addr, priv);
+}
+
+static uint32_t
+et4000w32p_readl(uint32_t addr, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    return svga_readl(addr, priv);
+}
+
+static void
+et4000w32p_write(uint32_t addr, uint8_t val, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    svga_write(addr, val, priv);
+}
+
+static void
+et4000w32p_writew(uint32_t addr, uint16_t val, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    svga_writew(addr, val, priv);
+}
+
+static void
+et4000w32p_writel(uint32_t addr, uint32_t val, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    svga_writel(addr, val, priv);
+}
+
+static uint8_t
+et4000w32p_read_linear(uint32_t addr, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    return svga_read_linear(addr, priv);
+}
+
+static uint16_t
+et4000w32p_readw_linear(uint32_t addr, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    return svga_readw_linear(addr, priv);
+}
+
+static uint32_t
+et4000w32p_readl_linear(uint32_t addr, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    return svga_readl_linear(addr, priv);
+}
+
+static void
+et4000w32p_write_linear(uint32_t addr, uint8_t val, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    svga_write_linear(addr, val, priv);
+}
+
+static void
+et4000w32p_writew_linear(uint32_t addr, uint16_t val, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    svga_writew_linear(addr, val, priv);
+}
+
+static void
+et4000w32p_writel_linear(uint32_t addr, uint32_t val, void *priv)
+{
+    const svga_t *svga = (svga_t *) priv;
+
+    device_worker_sync(((et4000w32p_t *) svga->priv)->acl_worker);
+    svga_writel_linear(addr, val, priv);
+}
+
 static uint8_t
 et4000w32p_mmu_read(uint32_t addr, void *priv)
 {
@@ -1058,6 +1189,8 @@ et4000w32p_mmu_read(uint32_t addr, void *priv)
     const svga_t *svga   = &et4000->svga;
     uint8_t       temp;
 
+    device_worker_sync(et4000->acl_worker);
+
     switch (addr & 0x6000) {
         case 0x0000: /* MMU 0 */
         case 0x2000: /* MMU 1 */
@@ -2921,7 +3054,12 @@ et4000w32p_init(const device_t *info)
         if (!et4000->onboard_vid)
             mem_mapping_disable(&et4000->bios_rom.mapping);
     }
-    mem_mapping_add(&et4000->linear_mapping, 0, 0, svga_read_linear, svga_readw_linear, svga_readl_linear, svga_write_linear, svga_writew_linear, svga_writel_linear, NULL, MEM_MAPPING_EXTERNAL, &et4000->svga);
+    et4000->acl_worker = device_worker_create("ET4000/W32 Accelerator", et4000w32p_mmu_write_worker, et4000);
+
+    mem_mapping_set_handler(&et4000->svga.mapping,
+                            et4000w32p_read, et4000->svga.readw ? et4000w32p_readw : NULL, et4000->svga.readl ? et4000w32p_readl : NULL,
+                            et4000w32p_write, et4000->svga.writew ? et4000w32p_writew : NULL, et4000->svga.writel ? et4000w32p_writel : NULL);
+    mem_mapping_add(&et4000->linear_mapping, 0, 0, et4000w32p_read_linear, et4000w32p_readw_linear, et4000w32p_readl_linear, et4000w32p_write_linear, et4000w32p_writew_linear, et4000w32p_writel_linear, NULL, MEM_MAPPING_EXTERNAL, &et4000->svga);
     mem_mapping_add(&et4000->mmu_mapping, 0, 0, et4000w32p_mmu_read, NULL, NULL, et4000w32p_mmu_write, NULL, NULL, NULL, MEM_MAPPING_EXTERNAL, et4000);
 
     et4000w32p_io_set(et4000);
@@ -3003,6 +3141,8 @@ et4000w32p_close(void *priv)
 {
     et4000w32p_t *et4000 = (et4000w32p_t *) priv;
 
+    device_worker_close(et4000->acl_worker);
+
     svga_close(&et4000->svga);
 
     free(et4000);
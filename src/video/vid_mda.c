@@ -166,111 +166,117 @@ mda_poll(void *priv)
             }
             mda->lastline = mda->displine;
 
-            for (uint32_t x = 0; x < mda->crtc[MDA_CRTC_HDISP]; x++) {
-                chr        = mda->vram[(mda->memaddr << 1) & 0xfff];
-                attr       = mda->vram[((mda->memaddr << 1) + 1) & 0xfff];
-                drawcursor = ((mda->memaddr == cursoraddr) && mda->cursorvisible && mda->cursoron);
-                blink      = ((mda->blink & 16) && (mda->mode & MDA_MODE_BLINK) && (attr & 0x80) && !drawcursor);
-
-                // Colours that will be used
-                int32_t color_bg = 0, color_fg = 0;
-
-                // If we are using an RGBI monitor allow colour
-                if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
-                    && !(mda->mode & MDA_MODE_BW)) {
-                    color_bg = (attr >> 4) & 0x0F;
-                    color_fg = (attr & 0x0F);
-
-                    // turn off bright bg colours in blink mode
-                    if ((mda->mode & MDA_MODE_BLINK)
-                        && (color_bg & 0x8))
-                        color_bg &= ~(0x8);
-
-                    // black-on-non black or white colours forced to white
-                    // grey-on-colours forced to bright white
-
-                    bool special_treatment = (color_bg != 0 && color_bg != 7);
-
-                    if (color_fg == MDA_COLOR_GREY
-                        && special_treatment)
-                        color_fg = MDA_COLOR_BRIGHT_WHITE;
-
-                    if (color_fg == 0
-                        && special_treatment)
-                        color_fg = MDA_COLOR_GREY;
-
-                    // gray is black
-                    if (color_fg == MDA_COLOR_GREY
-                        && (color_bg == MDA_COLOR_GREY || color_bg == MDA_COLOR_BLACK))
-                        color_fg = MDA_COLOR_BLACK;
-                }
-
-                if (mda->scanline == 12
-                    && ((attr & 7) == 1)) { // underline
-                    for (uint32_t column = 0; column < 9; column++) {
-                        if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
-                            && !(mda->mode & MDA_MODE_BW)) {
-                            buffer32->line[mda->displine][(x * 9) + column] = CGAPAL_CGA_START + color_fg;
-                        } else
-                            buffer32->line[mda->displine][(x * 9) + column] = mda_attr_to_color_table[attr][blink][1];
+            /* Nothing to draw for a hidden secondary monitor, only keep the
+               address counting. */
+            if (!video_monitor_consumed(mda->monitor_index))
+                mda->memaddr += mda->crtc[MDA_CRTC_HDISP];
+            else {
+                for (uint32_t x = 0; x < mda->crtc[MDA_CRTC_HDISP]; x++) {
+                    chr        = mda->vram[(mda->memaddr << 1) & 0xfff];
+                    attr       = mda->vram[((mda->memaddr << 1) + 1) & 0xfff];
+                    drawcursor = ((mda->memaddr == cursoraddr) && mda->cursorvisible && mda->cursoron);
+                    blink      = ((mda->blink & 16) && (mda->mode & MDA_MODE_BLINK) && (attr & 0x80) && !drawcursor);
+
+                    // Colours that will be used
+                    int32_t color_bg = 0, color_fg = 0;
+
+                    // If we are using an RGBI monitor allow colour
+                    if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
+                        && !(mda->mode & MDA_MODE_BW)) {
+                        color_bg = (attr >> 4) & 0x0F;
+                        color_fg = (attr & 0x0F);
+
+                        // turn off bright bg colours in blink mode
+                        if ((mda->mode & MDA_MODE_BLINK)
+                            && (color_bg & 0x8))
+                            color_bg &= ~(0x8);
+
+                        // black-on-non black or white colours forced to white
+                        // grey-on-colours forced to bright white
+
+                        bool special_treatment = (color_bg != 0 && color_bg != 7);
+
+                        if (color_fg == MDA_COLOR_GREY
+                            && special_treatment)
+                            color_fg = MDA_COLOR_BRIGHT_WHITE;
+
+                        if (color_fg == 0
+                            && special_treatment)
+                            color_fg = MDA_COLOR_GREY;
+
+                        // gray is black
+                        if (color_fg == MDA_COLOR_GREY
+                            && (color_bg == MDA_COLOR_GREY || color_bg == MDA_COLOR_BLACK))
+                            color_fg = MDA_COLOR_BLACK;
                     }
-                } else { // character
-                    for (uint32_t column = 0; column < 8; column++) {
-                        // bg=0, fg=1
-                        bool is_fg = (fontdatm[chr + mda->fontbase][mda->scanline] & (1 << (column ^ 7))) ? 1 : 0;
-
-                        uint32_t font_char = mda_attr_to_color_table[attr][blink][is_fg];
-
-                        if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
-                            && !(mda->mode & MDA_MODE_BW)) {
-                            if (!is_fg)
-                                font_char = CGAPAL_CGA_START + color_bg;
-                            else
-                                font_char = CGAPAL_CGA_START + color_fg;
+
+                    if (mda->scanline == 12
+                        && ((attr & 7) == 1)) { // underline
+                        for (uint32_t column = 0; column < 9; column++) {
+                            if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
+                                && !(mda->mode & MDA_MODE_BW)) {
+                                buffer32->line[mda->displine][(x * 9) + column] = CGAPAL_CGA_START + color_fg;
+                            } else
+                                buffer32->line[mda->displine][(x * 9) + column] = mda_attr_to_color_table[attr][blink][1];
+                        }
+                    } else { // character
+                        for (uint32_t column = 0; column < 8; column++) {
+                            // bg=0, fg=1
+                            bool is_fg = (fontdatm[chr + mda->fontbase][mda->scanline] & (1 << (column ^ 7))) ? 1 : 0;
+
+                            uint32_t font_char = mda_attr_to_color_table[attr][blink][is_fg];
+
+                            if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
+                                && !(mda->mode & MDA_MODE_BW)) {
+                                if (!is_fg)
+                                    font_char = CGAPAL_CGA_START + color_bg;
+                                else
+                                    font_char = CGAPAL_CGA_START + color_fg;
+                            }
+
+                            buffer32->line[mda->displine][(x * 9) + column] = font_char;
                         }
 
-                        buffer32->line[mda->displine][(x * 9) + column] = font_char;
-                    }
+                        // these characters (C0-DF) have their background extended to their 9th column
+                        if ((chr & ~0x1f) == 0xc0) {
+                            bool     is_fg        = fontdatm[chr + mda->fontbase][mda->scanline] & 1;
+                            uint32_t final_result = mda_attr_to_color_table[attr][blink][is_fg];
 
-                    // these characters (C0-DF) have their background extended to their 9th column
-                    if ((chr & ~0x1f) == 0xc0) {
-                        bool     is_fg        = fontdatm[chr + mda->fontbase][mda->scanline] & 1;
-                        uint32_t final_result = mda_attr_to_color_table[attr][blink][is_fg];
-
-                        if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
-                            && !(mda->mode & MDA_MODE_BW)) {
-                            if (!is_fg)
-                                final_result = CGAPAL_CGA_START + color_bg;
-                            else
-                                final_result = CGAPAL_CGA_START + color_fg;
-                        }
+                            if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
+                                && !(mda->mode & MDA_MODE_BW)) {
+                                if (!is_fg)
+                                    final_result = CGAPAL_CGA_START + color_bg;
+                                else
+                                    final_result = CGAPAL_CGA_START + color_fg;
+                            }
 
-                        buffer32->line[mda->displine][(x * 9) + 8] = final_result;
+                            buffer32->line[mda->displine][(x * 9) + 8] = final_result;
 
-                    } else {
-                        if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
-                            && !(mda->mode & MDA_MODE_BW)) {
-                            buffer32->line[mda->displine][(x * 9) + 8] = CGAPAL_CGA_START + color_bg;
+                        } else {
+                            if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
+                                && !(mda->mode & MDA_MODE_BW)) {
+                                buffer32->line[mda->displine][(x * 9) + 8] = CGAPAL_CGA_START + color_bg;
 
-                        } else
-                            buffer32->line[mda->displine][(x * 9) + 8] = mda_attr_to_color_table[attr][blink][0];
+                            } else
+                                buffer32->line[mda->displine][(x * 9) + 8] = mda_attr_to_color_table[attr][blink][0];
+                        }
                     }
-                }
 
-                mda->memaddr++;
+                    mda->memaddr++;
 
-                if (drawcursor) {
-                    for (uint32_t column = 0; column < 9; column++) {
-                        if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
-                            && !(mda->mode & MDA_MODE_BW)) {
-                            buffer32->line[mda->displine][(x * 9) + column] ^= CGAPAL_CGA_START + color_fg;
-                        } else
-                            buffer32->line[mda->displine][(x * 9) + column] ^= mda_attr_to_color_table[attr][0][1];
+                    if (drawcursor) {
+                        for (uint32_t column = 0; column < 9; column++) {
+                            if (mda->monitor_type == MDA_MONITOR_TYPE_RGBI
+                                && !(mda->mode & MDA_MODE_BW)) {
+                                buffer32->line[mda->displine][(x * 9) + column] ^= CGAPAL_CGA_START + color_fg;
+                            } else
+                                buffer32->line[mda->displine][(x * 9) + column] ^= mda_attr_to_color_table[attr][0][1];
+                        }
                     }
                 }
-            }
 
-            video_process_8(mda->crtc[MDA_CRTC_HDISP] * 9, mda->displine);
+                video_process_8(mda->crtc[MDA_CRTC_HDISP] * 9, mda->displine);
+            }
         }
         mda->scanline = scanline_old;
         if (mda->vc == mda->crtc[MDA_CRTC_VSYNC] && !mda->scanline) {
@@ -1423,6 +1423,8 @@ mystique_write_xreg(mystique_t *mystique, int reg, uint8_t val)
             break;
 
         case XREG_XGENCTRL:
+            if ((mystique->xgenctrl ^ val) & (1 << 2))
+                svga->pal_gen++;
             mystique->xgenctrl = val;
             break;
 
@@ -4776,6 +4778,24 @@ blit_line_start(mystique_t *mystique, int closed, int autoline)
     }
 }
 
+/*
+ * One clipped row of a BLK/RPL trapezoid. The clip rectangle is applied to the
+ * row up front and the pixel width switch sits outside the loop, so each
+ * width gets its own tight loop with only the transparency and pattern
+ * tests left per pixel.
+ */
+#define TRAP_BLK_SPAN(store)                                                                        \
+    for (x = x_start; x <= x_end; x++) {                                                            \
+        if (trans[x & 3]) {                                                                         \
+            int pattern = mystique->dwgreg.pattern[yoff][(mystique->dwgreg.xoff + (x & 7)) & 15]; \
+                                                                                                    \
+            if (!transc || pattern) {                                                               \
+                uint32_t col = pattern ? mystique->dwgreg.fcol : mystique->dwgreg.bcol;             \
+                store                                                                               \
+            }                                                                                       \
+        }                                                                                           \
+    }
+
 static void
 blit_trap(mystique_t *mystique)
 {
@@ -4807,41 +4827,41 @@ blit_trap(mystique_t *mystique)
                 else
                     len = x_r - x_l;
 
-                while (len > 0) {
-                    if (x_l >= mystique->dwgreg.cxleft && x_l <= mystique->dwgreg.cxright && mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop && mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot && trans[x_l & 3]) {
-                        int      xoff    = (mystique->dwgreg.xoff + (x_l & 7)) & 15;
-                        int      pattern = mystique->dwgreg.pattern[yoff][xoff];
-                        uint32_t dst;
+                if ((mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop) && (mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot)) {
+                    int x_start = x_l;
+                    int x_end   = x_l + len - 1;
+                    int x;
 
-                        if (!transc || pattern)
-                        switch (mystique->maccess_running & MACCESS_PWIDTH_MASK) {
-                            case MACCESS_PWIDTH_8:
-                                svga->vram[(mystique->dwgreg.ydst_lin + x_l) & mystique->vram_mask]                = (pattern ? mystique->dwgreg.fcol : mystique->dwgreg.bcol) & 0xff;
-                                svga->changedvram[((mystique->dwgreg.ydst_lin + x_l) & mystique->vram_mask) >> 12] = changeframecount;
-                                break;
+                    if (x_start < mystique->dwgreg.cxleft)
+                        x_start = mystique->dwgreg.cxleft;
+                    if (x_end > mystique->dwgreg.cxright)
+                        x_end = mystique->dwgreg.cxright;
 
-                            case MACCESS_PWIDTH_16:
-                                ((uint16_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x_l) & mystique->vram_mask_w] = (pattern ? mystique->dwgreg.fcol : mystique->dwgreg.bcol) & 0xffff;
-                                svga->changedvram[((mystique->dwgreg.ydst_lin + x_l) & mystique->vram_mask_w) >> 11] = changeframecount;
-                                break;
+                    if (x_start <= x_end) switch (mystique->maccess_running & MACCESS_PWIDTH_MASK) {
+                        case MACCESS_PWIDTH_8:
+                            TRAP_BLK_SPAN(svga->vram[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask]                = col & 0xff;
+                                          svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask) >> 12] = changeframecount;)
+                            break;
 
-                            case MACCESS_PWIDTH_24:
-                                dst                                                                                        = *(uint32_t *) (&svga->vram[((mystique->dwgreg.ydst_lin + x_l) * 3) & mystique->vram_mask]) & 0xff000000;
-                                *(uint32_t *) (&svga->vram[((mystique->dwgreg.ydst_lin + x_l) * 3) & mystique->vram_mask]) = ((pattern ? mystique->dwgreg.fcol : mystique->dwgreg.bcol) & 0xffffff) | dst;
-                                svga->changedvram[(((mystique->dwgreg.ydst_lin + x_l) * 3) & mystique->vram_mask) >> 12]   = changeframecount;
-                                break;
+                        case MACCESS_PWIDTH_16:
+                            TRAP_BLK_SPAN(((uint16_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_w] = col & 0xffff;
+                                          svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_w) >> 11] = changeframecount;)
+                            break;
 
-                            case MACCESS_PWIDTH_32:
-                                ((uint32_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x_l) & mystique->vram_mask_l] = pattern ? mystique->dwgreg.fcol : mystique->dwgreg.bcol;
-                                svga->changedvram[((mystique->dwgreg.ydst_lin + x_l) & mystique->vram_mask_l) >> 10] = changeframecount;
-                                break;
+                        case MACCESS_PWIDTH_24:
+                            TRAP_BLK_SPAN(uint32_t dst = *(uint32_t *) (&svga->vram[((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask]) & 0xff000000;
+                                          *(uint32_t *) (&svga->vram[((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask]) = (col & 0xffffff) | dst;
+                                          svga->changedvram[(((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask) >> 12]   = changeframecount;)
+                            break;
 
-                            default:
-                                fatal("TRAP BLK/RPL PWIDTH %x %08x\n", mystique->maccess_running & MACCESS_PWIDTH_MASK, mystique->dwgreg.dwgctrl_running);
-                        }
+                        case MACCESS_PWIDTH_32:
+                            TRAP_BLK_SPAN(((uint32_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_l] = col;
+                                          svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_l) >> 10] = changeframecount;)
+                            break;
+
+                        default:
+                            fatal("TRAP BLK/RPL PWIDTH %x %08x\n", mystique->maccess_running & MACCESS_PWIDTH_MASK, mystique->dwgreg.dwgctrl_running);
                     }
-                    len--;
-                    x_l++;
                 }
 
                 while ((err_l < 0) && mystique->dwgreg.ar[0]) {
@@ -6868,7 +6888,7 @@ mystique_init(const device_t *info)
     mystique->wake_fifo_thread    = thread_create_event();
     mystique->fifo_not_full_event = thread_create_event();
     mystique->thread_run          = 1;
-    mystique->fifo_thread         = thread_create(fifo_thread, mystique);
+    mystique->fifo_thread         = thread_create_role(fifo_thread, mystique, THREAD_ROLE_RENDER);
     mystique->dma.lock            = thread_create_mutex();
 
     timer_add(&mystique->wake_timer, mystique_wake_timer, (void *) mystique, 0);
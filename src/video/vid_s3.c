@@ -8288,6 +8288,101 @@ s3_short_stroke_start(s3_t *s3, uint8_t ssv)
     s3->accel_start(-1, 0, -1, 0, s3);
 }
 
+/*
+ * Fast path for the common rectangle fill: a constant source with a ROP that
+ * does not depend on the destination, no colour compare and no CPU transfer.
+ * Every pixel of a row takes the same decisions, so the clip test is done
+ * once per row and only the visible span is written. Returns 0 when the fill
+ * has to go through the generic per-pixel loop instead.
+ */
+static int
+s3_accel_rect_fill_span(s3_t *s3, uint32_t dstbase, uint32_t src_dat, uint32_t wrt_mask,
+                        int clip_t, int clip_l, int clip_b, int clip_r)
+{
+    svga_t   *svga    = &s3->svga;
+    uint16_t *vram_w  = (uint16_t *) svga->vram;
+    uint32_t *vram_l  = (uint32_t *) svga->vram;
+    uint32_t  pix_mask;
+    uint32_t  dest_dat;
+    uint32_t  old_dest_dat;
+    int       partial;
+    int       width   = s3->accel.sx + 1;
+    int       x_start;
+    int       x0;
+    int       x1;
+    int       x;
+
+    switch (s3->accel.frgd_mix & 0xf) {
+        case 0x1:
+            src_dat = 0;
+            break;
+        case 0x2:
+            src_dat = ~0;
+            break;
+        case 0x4:
+            src_dat = ~src_dat;
+            break;
+        case 0x7:
+            break;
+
+        default:
+            return 0;
+    }
+
+    if (s3->accel.cmd & 0x20) {
+        x0 = s3->accel.cx;
+        x1 = s3->accel.cx + width - 1;
+    } else {
+        x0 = s3->accel.cx - width + 1;
+        x1 = s3->accel.cx;
+    }
+
+    /* Rows that wrap around the 4096 pixel coordinate space stay generic. */
+    if ((x0 < 0) || (x1 > 0xfff))
+        return 0;
+
+    x_start = s3->accel.cx;
+    if (x0 < clip_l)
+        x0 = clip_l;
+    if (x1 > clip_r)
+        x1 = clip_r;
+
+    if (s3->bpp == 0)
+        pix_mask = 0xff;
+    else if (s3->bpp == 1)
+        pix_mask = 0xffff;
+    else
+        pix_mask = 0xffffffff;
+    partial = (wrt_mask & pix_mask) != pix_mask;
+
+    while (s3->accel.sy >= 0) {
+        if ((s3->accel.cmd & 0x10) && (s3->accel.cy >= clip_t) && (s3->accel.cy <= clip_b)) {
+            for (x = x0; x <= x1; x++) {
+                dest_dat = src_dat;
+                if (partial) {
+                    READ(s3->accel.dest + x, old_dest_dat);
+                    dest_dat = (dest_dat & wrt_mask) | (old_dest_dat & ~wrt_mask);
+                }
+                WRITE(s3->accel.dest + x, dest_dat);
+            }
+        }
+
+        if (s3->accel.cmd & 0x80)
+            s3->accel.cy++;
+        else
+            s3->accel.cy--;
+
+        s3->accel.cy &= 0xfff;
+        s3->accel.dest = dstbase + s3->accel.cy * s3->width;
+        s3->accel.sy--;
+    }
+
+    s3->accel.cx    = x_start;
+    s3->accel.cur_x = s3->accel.cx;
+    s3->accel.cur_y = s3->accel.cy;
+    return 1;
+}
+
 void
 s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, void *priv)
 {
@@ -9338,6 +9433,13 @@ s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, voi
                 return;
             }
 
+            if (!cpu_input && (mix_dat == 0xffffffff) && (frgd_mix != 2) && !s3->color_16bit &&
+                !s3_cpu_src(s3) && !s3_cpu_dest(s3) && !(s3->accel.multifunc[0xe] & 0x120)) {
+                if (s3_accel_rect_fill_span(s3, dstbase, frgd_mix ? ((frgd_mix == 1) ? frgd_color : 0) : bkgd_color,
+                                            wrt_mask, clip_t, clip_l, clip_b, clip_r))
+                    return;
+            }
+
             while (count-- && (s3->accel.sy >= 0)) {
                 if (s3->accel.b2e8_pix && s3_cpu_src(s3) && !s3->accel.temp_cnt) {
                     mix_dat >>= 16;
@@ -12216,7 +12318,7 @@ s3_init(const device_t *info)
     s3->wake_fifo_thread    = thread_create_event();
     s3->fifo_not_full_event = thread_create_event();
     s3->fifo_thread_run     = 1;
-    s3->fifo_thread         = thread_create(fifo_thread, s3);
+    s3->fifo_thread         = thread_create_role(fifo_thread, s3, THREAD_ROLE_RENDER);
 
     *reset_state = *s3;
 
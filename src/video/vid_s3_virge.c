@@ -74,9 +74,11 @@ static int dither[4][4] = {
 #define RB_SIZE 256
 #define RB_MASK (RB_SIZE - 1)
 
-#define RB_ENTRIES (virge->s3d_write_idx - virge->s3d_read_idx)
-#define RB_FULL (RB_ENTRIES == RB_SIZE)
-#define RB_EMPTY (!RB_ENTRIES)
+#define RB_ENTRIES(c) (virge->s3d_write_idx - virge->s3d_read_idx[c])
+#define RB_FULL(c) (RB_ENTRIES(c) == RB_SIZE)
+#define RB_EMPTY(c) (!RB_ENTRIES(c))
+
+#define VIRGE_MAX_RENDER_THREADS 4
 
 #define FIFO_SIZE 65536
 #define FIFO_MASK (FIFO_SIZE - 1)
@@ -221,10 +223,13 @@ typedef struct virge_t {
     int pixel_count;
     int tri_count;
 
-    thread_t *render_thread;
-    event_t  *wake_render_thread;
+    int render_threads;
+    int odd_even_mask;
+
+    thread_t *render_thread[VIRGE_MAX_RENDER_THREADS];
+    event_t  *wake_render_thread[VIRGE_MAX_RENDER_THREADS];
     event_t  *wake_main_thread;
-    event_t  *not_full_event;
+    event_t  *not_full_event[VIRGE_MAX_RENDER_THREADS];
 
     uint32_t hwc_fg_col;
     uint32_t hwc_bg_col;
@@ -289,10 +294,12 @@ typedef struct virge_t {
 
     s3d_t s3d_tri;
 
+    /* Every render thread walks the whole triangle ring, drawing only the
+       scanlines selected by odd_even_mask, so each keeps its own read index. */
     s3d_t      s3d_buffer[RB_SIZE];
-    atomic_int s3d_read_idx;
+    atomic_int s3d_read_idx[VIRGE_MAX_RENDER_THREADS];
     atomic_int s3d_write_idx;
-    atomic_int s3d_busy;
+    atomic_int s3d_busy[VIRGE_MAX_RENDER_THREADS];
 
     struct {
         uint32_t pri_ctrl;
@@ -333,7 +340,7 @@ typedef struct virge_t {
 
     fifo_entry_t fifo[FIFO_SIZE];
     atomic_int   fifo_read_idx, fifo_write_idx;
-    atomic_int   fifo_thread_run, render_thread_run;
+    atomic_int   fifo_thread_run, render_thread_run[VIRGE_MAX_RENDER_THREADS];
 
     thread_t *fifo_thread;
     event_t  *wake_fifo_thread;
@@ -414,6 +421,17 @@ static void     s3_virge_mmio_write_l(uint32_t addr, uint32_t val, void *priv);
 
 static void s3_virge_queue(virge_t *virge, uint32_t addr, uint32_t val, uint32_t type);
 
+static int
+s3_virge_s3d_busy(virge_t *virge)
+{
+    for (int c = 0; c < virge->render_threads; c++) {
+        if (virge->s3d_busy[c] || !RB_EMPTY(c))
+            return 1;
+    }
+
+    return 0;
+}
+
 enum {
     CMD_SET_AE = 1,
     CMD_SET_HC = (1 << 1),
@@ -1199,7 +1217,7 @@ s3_virge_mmio_read(uint32_t addr, void *priv)
             return ret;
         case 0x8505:
             ret = 0xc0;
-            if (virge->s3d_busy || virge->virge_busy || !FIFO_EMPTY)
+            if (s3_virge_s3d_busy(virge) || virge->virge_busy || !FIFO_EMPTY)
                 ret |= 0x10;
             else
                 ret |= 0x30;
@@ -1244,7 +1262,7 @@ s3_virge_mmio_read_w(uint32_t addr, void *priv)
     switch (addr & 0xfffe) {
         case 0x8504:
             ret = 0xc000;
-            if (virge->s3d_busy || virge->virge_busy || !FIFO_EMPTY)
+            if (s3_virge_s3d_busy(virge) || virge->virge_busy || !FIFO_EMPTY)
                 ret |= 0x1000;
             else
                 ret |= 0x3000;
@@ -1344,7 +1362,7 @@ s3_virge_mmio_read_l(uint32_t addr, void *priv)
 
         case 0x8504:
             ret = 0x0000c000;
-            if (virge->s3d_busy || virge->virge_busy || !FIFO_EMPTY)
+            if (s3_virge_s3d_busy(virge) || virge->virge_busy || !FIFO_EMPTY)
                 ret |= 0x00001000;
             else
                 ret |= 0x00003000;
@@ -3434,6 +3452,8 @@ typedef struct rgba_t {
     int a;
 } rgba_t;
 
+struct s3d_texture_state_t;
+
 typedef struct s3d_state_t {
     int32_t r;
     int32_t g;
@@ -3471,6 +3491,11 @@ typedef struct s3d_state_t {
     int y;
 
     rgba_t dest_rgba;
+
+    /* Selected per triangle, kept here so render threads don't share them. */
+    void (*tex_read)(struct s3d_state_t *state, struct s3d_texture_state_t *texture_state, rgba_t *out);
+    void (*tex_sample)(struct s3d_state_t *state);
+    void (*dest_pixel)(struct s3d_state_t *state);
 } s3d_state_t;
 
 typedef struct s3d_texture_state_t {
@@ -3481,16 +3506,9 @@ typedef struct s3d_texture_state_t {
     int32_t v;
 } s3d_texture_state_t;
 
-static void (*tex_read)(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out);
-static void (*tex_sample)(s3d_state_t *state);
-static void (*dest_pixel)(s3d_state_t *state);
-
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
-static int _x;
-static int _y;
-
 static void
 tex_ARGB1555(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
 {
@@ -3588,7 +3606,7 @@ tex_sample_normal(s3d_state_t *state)
     texture_state.u             = state->u + state->tbu;
     texture_state.v             = state->v + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -3607,21 +3625,21 @@ tex_sample_normal_filter(s3d_state_t *state)
 
     texture_state.u = state->u + state->tbu;
     texture_state.v = state->v + state->tbv;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (texture_state.u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (texture_state.v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = state->u + state->tbu + tex_offset;
     texture_state.v = state->v + state->tbv;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = state->u + state->tbu;
     texture_state.v = state->v + state->tbv + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = state->u + state->tbu + tex_offset;
     texture_state.v = state->v + state->tbv + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -3650,7 +3668,7 @@ tex_sample_mipmap(s3d_state_t *state)
     texture_state.u             = state->u + state->tbu;
     texture_state.v             = state->v + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -3671,21 +3689,21 @@ tex_sample_mipmap_filter(s3d_state_t *state)
 
     texture_state.u = state->u + state->tbu;
     texture_state.v = state->v + state->tbv;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (texture_state.u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (texture_state.v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = state->u + state->tbu + tex_offset;
     texture_state.v = state->v + state->tbv;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = state->u + state->tbu;
     texture_state.v = state->v + state->tbv + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = state->u + state->tbu + tex_offset;
     texture_state.v = state->v + state->tbv + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -3716,7 +3734,7 @@ tex_sample_persp_normal(s3d_state_t *state)
     texture_state.u             = (int32_t) (((int64_t) state->u * (int64_t) w) >> (12 + state->max_d)) + state->tbu;
     texture_state.v             = (int32_t) (((int64_t) state->v * (int64_t) w) >> (12 + state->max_d)) + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -3744,21 +3762,21 @@ tex_sample_persp_normal_filter(s3d_state_t *state)
 
     texture_state.u = u;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = u + tex_offset;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = u;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = u + tex_offset;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -3789,7 +3807,7 @@ tex_sample_persp_normal_375(s3d_state_t *state)
     texture_state.u             = (int32_t) (((int64_t) state->u * (int64_t) w) >> (8 + state->max_d)) + state->tbu;
     texture_state.v             = (int32_t) (((int64_t) state->v * (int64_t) w) >> (8 + state->max_d)) + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -3817,21 +3835,21 @@ tex_sample_persp_normal_filter_375(s3d_state_t *state)
 
     texture_state.u = u;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = u + tex_offset;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = u;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = u + tex_offset;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -3864,7 +3882,7 @@ tex_sample_persp_mipmap(s3d_state_t *state)
     texture_state.u             = (int32_t) (((int64_t) state->u * (int64_t) w) >> (12 + state->max_d)) + state->tbu;
     texture_state.v             = (int32_t) (((int64_t) state->v * (int64_t) w) >> (12 + state->max_d)) + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -3894,21 +3912,21 @@ tex_sample_persp_mipmap_filter(s3d_state_t *state)
 
     texture_state.u = u;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = u + tex_offset;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = u;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = u + tex_offset;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -3941,7 +3959,7 @@ tex_sample_persp_mipmap_375(s3d_state_t *state)
     texture_state.u             = (int32_t) (((int64_t) state->u * (int64_t) w) >> (8 + state->max_d)) + state->tbu;
     texture_state.v             = (int32_t) (((int64_t) state->v * (int64_t) w) >> (8 + state->max_d)) + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -3971,21 +3989,21 @@ tex_sample_persp_mipmap_filter_375(s3d_state_t *state)
 
     texture_state.u = u;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = u + tex_offset;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = u;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = u + tex_offset;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -4053,7 +4071,7 @@ dest_pixel_gouraud_shaded_triangle(s3d_state_t *state)
 static void
 dest_pixel_unlit_texture_triangle(s3d_state_t *state)
 {
-    tex_sample(state);
+    state->tex_sample(state);
 
     if (state->cmd_set & CMD_SET_ABC_SRC)
         state->dest_rgba.a = state->a >> 7;
@@ -4062,7 +4080,7 @@ dest_pixel_unlit_texture_triangle(s3d_state_t *state)
 static void
 dest_pixel_lit_texture_decal(s3d_state_t *state)
 {
-    tex_sample(state);
+    state->tex_sample(state);
 
     if (state->cmd_set & CMD_SET_ABC_SRC)
         state->dest_rgba.a = state->a >> 7;
@@ -4071,7 +4089,7 @@ dest_pixel_lit_texture_decal(s3d_state_t *state)
 static void
 dest_pixel_lit_texture_reflection(s3d_state_t *state)
 {
-    tex_sample(state);
+    state->tex_sample(state);
 
     state->dest_rgba.r += (state->r >> 7);
     state->dest_rgba.g += (state->g >> 7);
@@ -4090,7 +4108,7 @@ dest_pixel_lit_texture_modulate(s3d_state_t *state)
     int b = state->b >> 7;
     int a = state->a >> 7;
 
-    tex_sample(state);
+    state->tex_sample(state);
 
     CLAMP_RGBA(r, g, b, a);
 
@@ -4103,7 +4121,7 @@ dest_pixel_lit_texture_modulate(s3d_state_t *state)
 }
 
 static void
-tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int32_t dx2)
+tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int32_t dx2, int thread)
 {
     uint8_t *vram    = virge->svga.vram;
     int      x_dir   = s3d_tri->tlr ? 1 : -1;
@@ -4112,6 +4130,8 @@ tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int
     int      bpp     = (s3d_tri->cmd_set >> 2) & 7;
     uint32_t dest_offset;
     uint32_t z_offset;
+    int      _x;
+    int      _y;
 
     dest_offset = s3d_tri->dest_base + (state->y * s3d_tri->dest_str);
     z_offset    = s3d_tri->z_base + (state->y * s3d_tri->z_str);
@@ -4155,7 +4175,8 @@ tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int
             xe--;
         }
 
-        if (x != xe && ((x_dir > 0 && x < xe) || (x_dir < 0 && x > xe))) {
+        if (((state->y & virge->odd_even_mask) == thread) &&
+            x != xe && ((x_dir > 0 && x < xe) || (x_dir < 0 && x > xe))) {
             uint32_t dest_addr;
             uint32_t z_addr;
             int      dx        = (x_dir > 0) ? ((31 - ((state->x1 - 1) >> 15)) & 0x1f) : (((state->x1 - 1) >> 15) & 0x1f);
@@ -4246,7 +4267,7 @@ tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int
                 if (update) {
                     uint32_t dest_col;
 
-                    dest_pixel(state);
+                    state->dest_pixel(state);
 
                     if (s3d_tri->cmd_set & CMD_SET_FE) {
                         int a              = state->a >> 7;
@@ -4336,7 +4357,7 @@ tri_skip_line:
 static int tex_size[8] = { 4 * 2, 2 * 2, 2 * 2, 1 * 2, 2 / 1, 2 / 1, 1 * 2, 1 * 2 };
 
 static void
-s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
+s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri, int thread)
 {
     s3d_state_t state;
 
@@ -4374,19 +4395,19 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 
     switch ((s3d_tri->cmd_set >> 27) & 0xf) {
         case 0:
-            dest_pixel = dest_pixel_gouraud_shaded_triangle;
+            state.dest_pixel = dest_pixel_gouraud_shaded_triangle;
             break;
         case 1:
         case 5:
             switch ((s3d_tri->cmd_set >> 15) & 0x3) {
                 case 0:
-                    dest_pixel = dest_pixel_lit_texture_reflection;
+                    state.dest_pixel = dest_pixel_lit_texture_reflection;
                     break;
                 case 1:
-                    dest_pixel = dest_pixel_lit_texture_modulate;
+                    state.dest_pixel = dest_pixel_lit_texture_modulate;
                     break;
                 case 2:
-                    dest_pixel = dest_pixel_lit_texture_decal;
+                    state.dest_pixel = dest_pixel_lit_texture_decal;
                     break;
                 default:
                     return;
@@ -4394,7 +4415,7 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
             break;
         case 2:
         case 6:
-            dest_pixel = dest_pixel_unlit_texture_triangle;
+            state.dest_pixel = dest_pixel_unlit_texture_triangle;
             break;
         default:
             return;
@@ -4403,117 +4424,153 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
     switch (((s3d_tri->cmd_set >> 12) & 7) | ((s3d_tri->cmd_set & (1 << 29)) ? 8 : 0)) {
         case 0:
         case 1:
-            tex_sample = tex_sample_mipmap;
+            state.tex_sample = tex_sample_mipmap;
             break;
         case 2:
         case 3:
-            tex_sample = virge->bilinear_enabled ? tex_sample_mipmap_filter : tex_sample_mipmap;
+            state.tex_sample = virge->bilinear_enabled ? tex_sample_mipmap_filter : tex_sample_mipmap;
             break;
         case 4:
         case 5:
-            tex_sample = tex_sample_normal;
+            state.tex_sample = tex_sample_normal;
             break;
         case 6:
         case 7:
-            tex_sample = virge->bilinear_enabled ? tex_sample_normal_filter : tex_sample_normal;
+            state.tex_sample = virge->bilinear_enabled ? tex_sample_normal_filter : tex_sample_normal;
             break;
         case (0 | 8):
         case (1 | 8):
             if ((virge->chip == S3_VIRGEDX) || (virge->chip >= S3_VIRGEGX2))
-                tex_sample = tex_sample_persp_mipmap_375;
+                state.tex_sample = tex_sample_persp_mipmap_375;
             else
-                tex_sample = tex_sample_persp_mipmap;
+                state.tex_sample = tex_sample_persp_mipmap;
             break;
         case (2 | 8):
         case (3 | 8):
             if ((virge->chip == S3_VIRGEDX) || (virge->chip >= S3_VIRGEGX2))
-                tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter_375 :
+                state.tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter_375 :
                                                        tex_sample_persp_mipmap_375;
             else
-                tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter :
+                state.tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter :
                                                        tex_sample_persp_mipmap;
             break;
         case (4 | 8):
         case (5 | 8):
             if ((virge->chip == S3_VIRGEDX) || (virge->chip >= S3_VIRGEGX2))
-                tex_sample = tex_sample_persp_normal_375;
+                state.tex_sample = tex_sample_persp_normal_375;
             else
-                tex_sample = tex_sample_persp_normal;
+                state.tex_sample = tex_sample_persp_normal;
             break;
         case (6 | 8):
         case (7 | 8):
             if ((virge->chip == S3_VIRGEDX) || (virge->chip >= S3_VIRGEGX2))
-                tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter_375 :
+                state.tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter_375 :
                                                        tex_sample_persp_normal_375;
             else
-                tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter :
+                state.tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter :
                                                        tex_sample_persp_normal;
             break;
     }
 
     switch ((s3d_tri->cmd_set >> 5) & 7) {
         case 0:
-            tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB8888 : tex_ARGB8888_nowrap;
+            state.tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB8888 : tex_ARGB8888_nowrap;
             break;
         case 1:
-            tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB4444 : tex_ARGB4444_nowrap;
+            state.tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB4444 : tex_ARGB4444_nowrap;
             break;
         case 2:
-            tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
+            state.tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
             break;
         default:
-            tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
+            state.tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
             break;
     }
 
     state.y  = s3d_tri->tys;
     state.x1 = s3d_tri->txs;
     state.x2 = s3d_tri->txend01;
-    tri(virge, s3d_tri, &state, s3d_tri->ty01, s3d_tri->TdXdY02, s3d_tri->TdXdY01);
+    tri(virge, s3d_tri, &state, s3d_tri->ty01, s3d_tri->TdXdY02, s3d_tri->TdXdY01, thread);
     state.x2 = s3d_tri->txend12;
-    tri(virge, s3d_tri, &state, s3d_tri->ty12, s3d_tri->TdXdY02, s3d_tri->TdXdY12);
+    tri(virge, s3d_tri, &state, s3d_tri->ty12, s3d_tri->TdXdY02, s3d_tri->TdXdY12, thread);
 
-    virge->tri_count++;
+    if (thread == 0) {
+        virge->tri_count++;
 
-    end_time = plat_timer_read();
+        end_time = plat_timer_read();
 
-    virge_time += end_time - start_time;
+        virge_time += end_time - start_time;
+    }
 }
 
 static void
-render_thread(void *param)
+render_thread(virge_t *virge, int thread)
 {
-    virge_t *virge = (virge_t *) param;
-
-    while (virge->render_thread_run) {
-        thread_wait_event(virge->wake_render_thread, -1);
-        thread_reset_event(virge->wake_render_thread);
-        virge->s3d_busy = 1;
-        while (!RB_EMPTY) {
-            s3_virge_triangle(virge, &virge->s3d_buffer[virge->s3d_read_idx & RB_MASK]);
-            virge->s3d_read_idx++;
+    while (virge->render_thread_run[thread]) {
+        thread_wait_event(virge->wake_render_thread[thread], -1);
+        thread_reset_event(virge->wake_render_thread[thread]);
+        virge->s3d_busy[thread] = 1;
+        while (!RB_EMPTY(thread)) {
+            s3_virge_triangle(virge, &virge->s3d_buffer[virge->s3d_read_idx[thread] & RB_MASK], thread);
+            virge->s3d_read_idx[thread]++;
+
+            if (RB_ENTRIES(thread) == RB_MASK)
+                thread_set_event(virge->not_full_event[thread]);
+        }
+        virge->s3d_busy[thread] = 0;
 
-            if (RB_ENTRIES == RB_MASK)
-                thread_set_event(virge->not_full_event);
+        /*The last thread to drain the ring signals completion.*/
+        if (!s3_virge_s3d_busy(virge)) {
+            virge->subsys_stat |= INT_S3D_DONE;
+            virge->irq_pending++;
         }
-        virge->s3d_busy = 0;
-        virge->subsys_stat |= INT_S3D_DONE;
-        virge->irq_pending++;
     }
 }
 
+static void
+render_thread_1(void *param)
+{
+    render_thread((virge_t *) param, 0);
+}
+
+static void
+render_thread_2(void *param)
+{
+    render_thread((virge_t *) param, 1);
+}
+
+static void
+render_thread_3(void *param)
+{
+    render_thread((virge_t *) param, 2);
+}
+
+static void
+render_thread_4(void *param)
+{
+    render_thread((virge_t *) param, 3);
+}
+
+static void (*const render_thread_func[VIRGE_MAX_RENDER_THREADS])(void *param) = {
+    render_thread_1, render_thread_2, render_thread_3, render_thread_4
+};
+
 static void
 queue_triangle(virge_t *virge)
 {
-    if (RB_FULL) {
-        thread_reset_event(virge->not_full_event);
-        if (RB_FULL)
-            thread_wait_event(virge->not_full_event, -1); /*Wait for room in ringbuffer*/
+    for (int c = 0; c < virge->render_threads; c++) {
+        if (RB_FULL(c)) {
+            thread_reset_event(virge->not_full_event[c]);
+            if (RB_FULL(c))
+                thread_wait_event(virge->not_full_event[c], -1); /*Wait for room in ringbuffer*/
+        }
     }
     virge->s3d_buffer[virge->s3d_write_idx & RB_MASK] = virge->s3d_tri;
     virge->s3d_write_idx++;
-    if (!virge->s3d_busy)
-        thread_set_event(virge->wake_render_thread); /*Wake up render thread if moving from idle*/
+    for (int c = 0; c < virge->render_threads; c++) {
+        if (!virge->s3d_busy[c])
+            thread_set_event(virge->wake_render_thread[c]); /*Wake up render thread if moving from idle*/
+    }
 }
 
 static void
@@ -5303,9 +5360,11 @@ s3_virge_reset(void *priv)
         dev->virge_busy       = 0;
         dev->fifo_write_idx   = 0;
         dev->fifo_read_idx    = 0;
-        dev->s3d_busy         = 0;
         dev->s3d_write_idx    = 0;
-        dev->s3d_read_idx     = 0;
+        for (int c = 0; c < VIRGE_MAX_RENDER_THREADS; c++) {
+            dev->s3d_busy[c]     = 0;
+            dev->s3d_read_idx[c] = 0;
+        }
         reset_state->pci_slot = dev->pci_slot;
 
         *dev = *reset_state;
@@ -5323,6 +5382,8 @@ s3_virge_init(const device_t *info)
 
     virge->bilinear_enabled  = device_get_config_int("bilinear");
     virge->dithering_enabled = device_get_config_int("dithering");
+    virge->render_threads    = device_get_config_int("render_threads");
+    virge->odd_even_mask     = virge->render_threads - 1;
     if (virge->type >= S3_VIRGE_GX2)
         virge->memory_size = 4;
     else
@@ -5555,16 +5616,18 @@ s3_virge_init(const device_t *info)
 
     virge->svga.force_old_addr = 1;
 
-    virge->render_thread_run  = 1;
-    virge->wake_render_thread = thread_create_event();
-    virge->wake_main_thread   = thread_create_event();
-    virge->not_full_event     = thread_create_event();
-    virge->render_thread      = thread_create(render_thread, virge);
+    virge->wake_main_thread = thread_create_event();
+    for (int c = 0; c < virge->render_threads; c++) {
+        virge->render_thread_run[c]  = 1;
+        virge->wake_render_thread[c] = thread_create_event();
+        virge->not_full_event[c]     = thread_create_event();
+        virge->render_thread[c]      = thread_create_role(render_thread_func[c], virge, THREAD_ROLE_RENDER);
+    }
 
     virge->fifo_thread_run     = 1;
     virge->wake_fifo_thread    = thread_create_event();
     virge->fifo_not_full_event = thread_create_event();
-    virge->fifo_thread         = thread_create(fifo_thread, virge);
+    virge->fifo_thread         = thread_create_role(fifo_thread, virge, THREAD_ROLE_RENDER);
 
     timer_add(&virge->irq_timer, s3_virge_update_irq_timer, virge, 1);
 
@@ -5580,12 +5643,14 @@ s3_virge_close(void *priv)
 {
     virge_t *virge = (virge_t *) priv;
 
-    virge->render_thread_run = 0;
-    thread_set_event(virge->wake_render_thread);
-    thread_wait(virge->render_thread);
-    thread_destroy_event(virge->not_full_event);
+    for (int c = 0; c < virge->render_threads; c++) {
+        virge->render_thread_run[c] = 0;
+        thread_set_event(virge->wake_render_thread[c]);
+        thread_wait(virge->render_thread[c]);
+        thread_destroy_event(virge->not_full_event[c]);
+        thread_destroy_event(virge->wake_render_thread[c]);
+    }
     thread_destroy_event(virge->wake_main_thread);
-    thread_destroy_event(virge->wake_render_thread);
 
     virge->fifo_thread_run = 0;
     thread_set_event(virge->wake_fifo_thread);
@@ -5733,6 +5798,22 @@ static const device_config_t s3_virge_config[] = {
         .selection      = { { 0 } },
         .bios           = { { 0 } }
     },
+    {
+        .name           = "render_threads",
+        .description    = "Render threads",
+        .type           = CONFIG_SELECTION,
+        .default_string = NULL,
+        .default_int    = 2,
+        .file_filter    = NULL,
+        .spinner        = { 0 },
+        .selection      = {
+            { .description = "1", .value = 1 },
+            { .description = "2", .value = 2 },
+            { .description = "4", .value = 4 },
+            { .description = ""              }
+        },
+        .bios           = { { 0 } }
+    },
     { .name = "", .description = "", .type = CONFIG_END }
     // clang-format on
 };
@@ -5785,6 +5866,22 @@ static const device_config_t s3_virge_stb_config[] = {
         .selection      = { { 0 } },
         .bios           = { { 0 } }
     },
+    {
+        .name           = "render_threads",
+        .description    = "Render threads",
+        .type           = CONFIG_SELECTION,
+        .default_string = NULL,
+        .default_int    = 2,
+        .file_filter    = NULL,
+        .spinner        = { 0 },
+        .selection      = {
+            { .description = "1", .value = 1 },
+            { .description = "2", .value = 2 },
+            { .description = "4", .value = 4 },
+            { .description = ""              }
+        },
+        .bios           = { { 0 } }
+    },
     { .name = "", .description = "", .type = CONFIG_END }
     // clang-format on
 };
@@ -5838,6 +5935,22 @@ static const device_config_t s3_virge_357_config[] = {
         .selection      = { { 0 } },
         .bios           = { { 0 } }
     },
+    {
+        .name           = "render_threads",
+        .description    = "Render threads",
+        .type           = CONFIG_SELECTION,
+        .default_string = NULL,
+        .default_int    = 2,
+        .file_filter    = NULL,
+        .spinner        = { 0 },
+        .selection      = {
+            { .description = "1", .value = 1 },
+            { .description = "2", .value = 2 },
+            { .description = "4", .value = 4 },
+            { .description = ""              }
+        },
+        .bios           = { { 0 } }
+    },
     { .name = "", .description = "", .type = CONFIG_END }
     // clang-format on
 };
@@ -5892,6 +6005,22 @@ static const device_config_t s3_trio3d2x_config[] = {
         .selection      = { { 0 } },
         .bios           = { { 0 } }
     },
+    {
+        .name           = "render_threads",
+        .description    = "Render threads",
+        .type           = CONFIG_SELECTION,
+        .default_string = NULL,
+        .default_int    = 2,
+        .file_filter    = NULL,
+        .spinner        = { 0 },
+        .selection      = {
+            { .description = "1", .value = 1 },
+            { .description = "2", .value = 2 },
+            { .description = "4", .value = 4 },
+            { .description = ""              }
+        },
+        .bios           = { { 0 } }
+    },
     { .name = "", .description = "", .type = CONFIG_END }
     // clang-format on
 };
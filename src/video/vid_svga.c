@@ -43,6 +43,8 @@
 #include <86box/vid_svga_render.h>
 #include <86box/vid_xga_device.h>
 
+#include <minitrace/minitrace.h>
+
 void svga_doblit(int wx, int wy, svga_t *svga);
 void svga_poll(void *priv);
 
@@ -369,6 +371,7 @@ svga_out(uint16_t addr, uint8_t val, void *priv)
                         svga->pallook[index] = makecol32(svga->vgapal[index].r, svga->vgapal[index].g, svga->vgapal[index].b);
                     else
                         svga->pallook[index] = makecol32(video_6to8[svga->vgapal[index].r & 0x3f], video_6to8[svga->vgapal[index].g & 0x3f], video_6to8[svga->vgapal[index].b & 0x3f]);
+                    svga->pal_gen++;
                     svga->dac_pos  = 0;
                     svga->dac_addr = (svga->dac_addr + 1) & 0xff;
                     break;
@@ -678,6 +681,7 @@ svga_set_ramdac_type(svga_t *svga, int type)
                                              (svga->vgapal[c].g & 0x3f) * 4,
                                              (svga->vgapal[c].b & 0x3f) * 4);
         }
+        svga->pal_gen++;
     }
 }
 
@@ -1281,6 +1285,16 @@ svga_recalctimings(svga_t *svga)
     }
 }
 
+/*
+ * Render the current scanline. This runs on the CPU thread, in svga_poll(),
+ * on purpose: svga->render() and the overlay and cursor hooks read live
+ * svga_t state (memaddr, which they also advance, scrollcache, x_add/y_add,
+ * the palette and LUT RAM, map8), card-private state behind svga->priv, and
+ * VRAM itself, which the CPU and the accelerators keep writing. Deferring
+ * the line to another thread would mean snapshotting all of that per line,
+ * including the card hooks; the cheap wins are skipping clean lines (the
+ * changedvram checks in the renderers) and clean frames (svga_blit_needed()).
+ */
 static void
 svga_do_render(svga_t *svga)
 {
@@ -1328,8 +1342,42 @@ svga_do_render(svga_t *svga)
     }
 }
 
-void
-svga_poll(void *priv)
+/* Whether the frame that just ended has to be handed to the blitter. When
+   no scanline was rendered (every renderer skips lines whose VRAM did not
+   change) and nothing else around the picture changed, the target buffer
+   still holds what was blitted last time, so the blit can be skipped. One
+   frame in every 50 is still blitted, so the UI never stalls for long.
+   Otherwise, when only the picture itself changed, the rendered lines are
+   passed on to the renderer as the dirty range. */
+static int
+svga_blit_needed(svga_t *svga, int wx)
+{
+    int wy   = svga->lastline - svga->firstline;
+    int full = svga->vertical_linedbl || svga->dpms || (wx != svga->blit_wx) || (wy != svga->blit_wy) ||
+               (svga->overscan_color != svga->blit_overscan_color) ||
+               video_force_resize_get_monitor(svga->monitor_index);
+
+    if (full || (svga->firstline_draw != 2000) || svga->monitor->mon_screenshots || (svga->blit_skipped >= 50)) {
+        if (full || (svga->firstline_draw == 2000))
+            svga->blit_dirty_y1 = -1;
+        else {
+            svga->blit_dirty_y1 = svga->firstline_draw + svga->y_add;
+            svga->blit_dirty_y2 = svga->lastline_draw + svga->y_add;
+        }
+
+        svga->blit_wx             = wx;
+        svga->blit_wy             = wy;
+        svga->blit_overscan_color = svga->overscan_color;
+        svga->blit_skipped        = 0;
+        return 1;
+    }
+
+    svga->blit_skipped++;
+    return 0;
+}
+
+static void
+svga_poll_line(void *priv)
 {
     svga_t    *svga = (svga_t *) priv;
     uint32_t   x;
@@ -1387,7 +1435,12 @@ svga_poll(void *priv)
             if (svga->hwcursor_on || svga->dac_hwcursor_on || svga->overlay_on)
                 svga->changedvram[svga->memaddr >> 12] = svga->changedvram[(svga->memaddr >> 12) + 1] = svga->interlace ? 3 : 2;
 
-            if (svga->vertical_linedbl) {
+            /* Draw nothing on a hidden secondary monitor, the address counters
+               are reloaded at the end of the line anyway. Once it is shown
+               again, every line gets redrawn. */
+            if (!video_monitor_consumed(svga->monitor_index))
+                svga->fullchange = svga->monitor->mon_changeframecount;
+            else if (svga->vertical_linedbl) {
                 old_ma = svga->memaddr;
 
                 svga->displine <<= 1;
@@ -1560,7 +1613,7 @@ svga_poll(void *priv)
 
             wx = x;
 
-            if (!svga->override) {
+            if (!svga->override && svga_blit_needed(svga, wx)) {
                 if (svga->vertical_linedbl) {
                     wy = (svga->lastline - svga->firstline) << 1;
                     svga->vdisp = wy + 1;
@@ -1658,12 +1711,47 @@ svga_poll(void *priv)
     }
 }
 
+void
+svga_poll(void *priv)
+{
+    MTR_BEGIN("video", "svga_poll");
+    svga_poll_line(priv);
+    MTR_END("video", "svga_poll");
+}
+
 uint32_t
 svga_conv_16to32(UNUSED(struct svga_t *svga), uint16_t color, uint8_t bpp)
 {
     return (bpp == 15) ? video_15to32[color] : video_16to32[color];
 }
 
+/* Return a table giving conv_16to32() for every 15/16 bpp colour. The
+   plain conversion uses the static tables, anything else is cached and only
+   rebuilt when the palette generation or the conversion inputs change. */
+const uint32_t *
+svga_conv_16to32_lut(svga_t *svga, uint8_t bpp)
+{
+    if (svga->conv_16to32 == svga_conv_16to32)
+        return (bpp == 15) ? video_15to32 : video_16to32;
+
+    if ((svga->conv_lut == NULL) || (svga->conv_lut_gen != svga->pal_gen) ||
+        (svga->conv_lut_bpp != bpp) || (svga->conv_lut_lut_map != svga->lut_map) ||
+        (svga->conv_lut_func != svga->conv_16to32)) {
+        if (svga->conv_lut == NULL)
+            svga->conv_lut = (uint32_t *) malloc(65536 * sizeof(uint32_t));
+
+        for (uint32_t c = 0; c < 65536; c++)
+            svga->conv_lut[c] = svga->conv_16to32(svga, c, bpp);
+
+        svga->conv_lut_gen     = svga->pal_gen;
+        svga->conv_lut_bpp     = bpp;
+        svga->conv_lut_lut_map = svga->lut_map;
+        svga->conv_lut_func    = svga->conv_16to32;
+    }
+
+    return svga->conv_lut;
+}
+
 int
 svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
           void (*recalctimings_ex)(struct svga_t *svga),
@@ -1685,6 +1773,7 @@ svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
     svga->monitor->mon_overscan_x = 16;
     svga->monitor->mon_overscan_y = 32;
     svga->x_add                   = 8;
+    svga->blit_dirty_y1           = -1;
     svga->y_add                   = 16;
     svga->force_shifter_bypass    = 1;
 
@@ -1771,6 +1860,7 @@ svga_close(svga_t *svga)
 {
     free(svga->changedvram);
     free(svga->vram);
+    free(svga->conv_lut);
 
     if (svga->dpms_ui)
         ui_sb_set_text_w(NULL);
@@ -2100,16 +2190,70 @@ svga_read_common(uint32_t addr, uint8_t linear, void *priv)
     return ret;
 }
 
+/*
+   Plain write mode 0 into packed chain-4 or frame buffer memory, the common case
+   in linear and 256-colour modes: no rotate, set/reset, logical operation or bit
+   mask, so the byte goes straight to VRAM without the latches.
+ */
+static __inline int
+svga_write_is_plain(const svga_t *svga)
+{
+    return svga->fast && !svga->writemode && !(svga->gdcreg[3] & 7) && !(svga->adv_flags & FLAG_ADDR_BY8) &&
+           ((svga->chain4 && (svga->packed_chain4 || svga->force_old_addr)) || svga->fb_only);
+}
+
+static __inline void
+svga_write_plain(uint32_t addr, uint8_t val, uint8_t linear, svga_t *svga)
+{
+    uint32_t plane;
+
+    cycles -= svga->monitor->mon_video_timing_write_b;
+
+    if (!linear) {
+        xga_write_test(addr, val, svga);
+        addr = svga_decode_addr(svga, addr, 1);
+        if (addr == 0xffffffff)
+            return;
+    }
+
+    if (!(svga->gdcreg[6] & 1))
+        svga->fullchange = 2;
+
+    plane = addr & 3;
+    addr  = (addr & ~3) & svga->decode_mask;
+
+    if (svga->translate_address)
+        addr = svga->translate_address(addr, svga);
+
+    if (addr >= svga->vram_max)
+        return;
+
+    addr &= svga->vram_mask;
+
+    svga->changedvram[addr >> 12] = svga->monitor->mon_changeframecount;
+    svga->vram[addr | plane]      = val;
+}
+
 void
 svga_write(uint32_t addr, uint8_t val, void *priv)
 {
-    svga_write_common(addr, val, 0, priv);
+    svga_t *svga = (svga_t *) priv;
+
+    if (svga_write_is_plain(svga))
+        svga_write_plain(addr, val, 0, svga);
+    else
+        svga_write_common(addr, val, 0, priv);
 }
 
 void
 svga_write_linear(uint32_t addr, uint8_t val, void *priv)
 {
-    svga_write_common(addr, val, 1, priv);
+    svga_t *svga = (svga_t *) priv;
+
+    if (svga_write_is_plain(svga))
+        svga_write_plain(addr, val, 1, svga);
+    else
+        svga_write_common(addr, val, 1, priv);
 }
 
 uint8_t
@@ -2137,6 +2281,11 @@ svga_doblit(int wx, int wy, svga_t *svga)
     int       j;
     int       xs_temp;
     int       ys_temp;
+    int       resized  = 0;
+    int       dirty_y1 = svga->blit_dirty_y1;
+
+    /* Only svga_poll() knows the dirty lines, other callers blit in full. */
+    svga->blit_dirty_y1 = -1;
 
     y_add   = enable_overscan ? svga->monitor->mon_overscan_y : 0;
     x_add   = enable_overscan ? svga->monitor->mon_overscan_x : 0;
@@ -2173,6 +2322,7 @@ svga_doblit(int wx, int wy, svga_t *svga)
 
     if ((svga->crtc[0x17] & 0x80) && ((xs_temp != svga->monitor->mon_xsize) || (ys_temp != svga->monitor->mon_ysize) || video_force_resize_get_monitor(svga->monitor_index))) {
         /* Screen res has changed.. fix up, and let them know. */
+        resized                  = 1;
         svga->monitor->mon_xsize = xs_temp;
         svga->monitor->mon_ysize = ys_temp;
 
@@ -2211,7 +2361,11 @@ svga_doblit(int wx, int wy, svga_t *svga)
         }
     }
 
-    video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
+    if (resized || (dirty_y1 < 0))
+        video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
+    else
+        video_blit_memtoscreen_dirty_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add,
+                                             dirty_y1, svga->blit_dirty_y2, svga->monitor_index);
 
     if (svga->vertical_linedbl)
         svga->vertical_linedbl >>= 1;
@@ -42,6 +42,27 @@ svga_lookup_lut_ram(svga_t* svga, uint32_t val)
 
 #define lookup_lut(val) svga_lookup_lut_ram(svga, val)
 
+/* Convert a 15/16bpp scanline through a full 64K entry colour table, either
+   the plain video_15to32/video_16to32 or the card's cached conv_16to32
+   output. Without the indirect call per pixel the compiler is free to
+   unroll and vectorize the loop. */
+static int
+svga_render_16bpp_line_lut(svga_t *svga, uint32_t *p, const uint32_t *lut)
+{
+    uint32_t dat;
+    int      x;
+
+    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+        for (int i = 0; i < 8; i += 2) {
+            dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + ((x + i) << 1)) & svga->vram_display_mask]);
+            *p++ = lut[dat & 0xffff];
+            *p++ = lut[dat >> 16];
+        }
+    }
+
+    return x;
+}
+
 void
 svga_render_null(svga_t *svga)
 {
@@ -150,11 +171,13 @@ svga_render_text_40(svga_t *svga)
     if ((svga->displine + svga->y_add) < 0)
         return;
 
-    if (svga->firstline_draw == 2000)
-        svga->firstline_draw = svga->displine;
-    svga->lastline_draw = svga->displine;
-
+    /* Text is only redrawn on a full change (a write to the display, a blink
+       phase change), other frames leave the target buffer as it is. */
     if (svga->fullchange) {
+        if (svga->firstline_draw == 2000)
+            svga->firstline_draw = svga->displine;
+        svga->lastline_draw = svga->displine;
+
         p    = &svga->monitor->target_buffer->line[(svga->displine + svga->y_add) & 2047][(svga->x_add) & 2047];
         xinc = (svga->seqregs[1] & 1) ? 16 : 18;
 
@@ -223,6 +246,8 @@ svga_render_text_80(svga_t *svga)
     uint32_t  charaddr;
     int       fg;
     int       bg;
+    uint32_t  fgcol;
+    uint32_t  bgcol;
     uint32_t  addr = 0;
 
     if (svga->render_override) {
@@ -233,11 +258,11 @@ svga_render_text_80(svga_t *svga)
     if ((svga->displine + svga->y_add) < 0)
         return;
 
-    if (svga->firstline_draw == 2000)
-        svga->firstline_draw = svga->displine;
-    svga->lastline_draw = svga->displine;
-
     if (svga->fullchange) {
+        if (svga->firstline_draw == 2000)
+            svga->firstline_draw = svga->displine;
+        svga->lastline_draw = svga->displine;
+
         p    = &svga->monitor->target_buffer->line[(svga->displine + svga->y_add) & 2047][(svga->x_add) & 2047];
         xinc = (svga->seqregs[1] & 1) ? 8 : 9;
 
@@ -310,21 +335,18 @@ svga_render_text_80(svga_t *svga)
                     }
                 }
             } else {
-                if (svga->seqregs[1] & 1) {
-                    for (xx = 0; xx < 8; xx++) {
-                        col = (col << 4) | ((dat & (0x80 >> xx)) ? fg : bg);
-                        p[xx] = svga->pallook[svga->egapal[col & 0x0f] & svga->dac_mask];
-                    }
-                } else {
-                    for (xx = 0; xx < 8; xx++) {
-                        col = (col << 4) | ((dat & (0x80 >> xx)) ? fg : bg);
-                        p[xx] = svga->pallook[svga->egapal[col & 0x0f] & svga->dac_mask];
-                    }
+                /* Only two colours per cell, look them up once. */
+                fgcol = svga->pallook[svga->egapal[fg] & svga->dac_mask];
+                bgcol = svga->pallook[svga->egapal[bg] & svga->dac_mask];
+
+                for (xx = 0; xx < 8; xx++)
+                    p[xx] = (dat & (0x80 >> xx)) ? fgcol : bgcol;
+
+                if (!(svga->seqregs[1] & 1)) {
                     if ((chr & ~0x1F) != 0xC0 || !(svga->attrregs[0x10] & 4))
-                        col = (col << 4) | bg;
+                        p[8] = bgcol;
                     else
-                        col = (col << 4) | ((dat & 1) ? fg : bg);
-                    p[8] = svga->pallook[svga->egapal[col & 0x0f] & svga->dac_mask];
+                        p[8] = (dat & 1) ? fgcol : bgcol;
                 }
             }
 
@@ -354,11 +376,11 @@ svga_render_text_80_ksc5601(svga_t *svga)
     if ((svga->displine + svga->y_add) < 0)
         return;
 
-    if (svga->firstline_draw == 2000)
-        svga->firstline_draw = svga->displine;
-    svga->lastline_draw = svga->displine;
-
     if (svga->fullchange) {
+        if (svga->firstline_draw == 2000)
+            svga->firstline_draw = svga->displine;
+        svga->lastline_draw = svga->displine;
+
         p = &svga->monitor->target_buffer->line[svga->displine + svga->y_add][svga->x_add];
 
         xinc = (svga->seqregs[1] & 1) ? 8 : 9;
@@ -855,8 +877,8 @@ svga_render_indexed_gfx(svga_t *svga, bool highres, bool combine8bits)
                     edat = (edat & 0xCCCC3333) | ((edat << 14) & 0x33330000) | ((edat >> 14) & 0x0000CCCC);
                 } else {
                     /* Group 4x 1bpp values into 4bpp values */
-                    edat = (edat & 0xAA55AA55) | ((edat << 7) & 0x55005500) | ((edat >> 7) & 0x00AA00AA);
-                    edat = (edat & 0xCCCC3333) | ((edat << 14) & 0x33330000) | ((edat >> 14) & 0x0000CCCC);
+                    edat = egaplanarlookup[0][edat & 0xff] | egaplanarlookup[1][(edat >> 8) & 0xff] |
+                           egaplanarlookup[2][(edat >> 16) & 0xff] | egaplanarlookup[3][edat >> 24];
                 }
             }
         } else {
@@ -1496,10 +1518,13 @@ svga_render_15bpp_lowres(svga_t *svga)
     uint32_t  dat;
     uint32_t  changed_addr;
     uint32_t  addr;
+    const uint32_t *lut;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
 
+    lut = svga_conv_16to32_lut(svga, 15);
+
     if (svga->force_old_addr) {
         if (svga->changedvram[svga->memaddr >> 12] || svga->changedvram[(svga->memaddr >> 12) + 1] || svga->fullchange) {
             p = &svga->monitor->target_buffer->line[svga->displine + svga->y_add][svga->x_add];
@@ -1511,13 +1536,13 @@ svga_render_15bpp_lowres(svga_t *svga)
             for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
                 dat = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
 
-                p[x << 1] = p[(x << 1) + 1] = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[(x << 1) + 2] = p[(x << 1) + 3] = svga->conv_16to32(svga, dat >> 16, 15);
+                p[x << 1] = p[(x << 1) + 1] = lut[dat & 0xffff];
+                p[(x << 1) + 2] = p[(x << 1) + 3] = lut[dat >> 16];
 
                 dat = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
 
-                p[(x << 1) + 4] = p[(x << 1) + 5] = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[(x << 1) + 6] = p[(x << 1) + 7] = svga->conv_16to32(svga, dat >> 16, 15);
+                p[(x << 1) + 4] = p[(x << 1) + 5] = lut[dat & 0xffff];
+                p[(x << 1) + 6] = p[(x << 1) + 7] = lut[dat >> 16];
             }
             svga->memaddr += x << 1;
             svga->memaddr &= svga->vram_display_mask;
@@ -1536,13 +1561,13 @@ svga_render_15bpp_lowres(svga_t *svga)
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
                     dat = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
 
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                    *p++ = lut[dat & 0xffff];
+                    *p++ = lut[dat >> 16];
 
                     dat = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
 
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                    *p++ = lut[dat & 0xffff];
+                    *p++ = lut[dat >> 16];
                 }
                 svga->memaddr += x << 1;
             } else {
@@ -1550,8 +1575,8 @@ svga_render_15bpp_lowres(svga_t *svga)
                     addr = svga->remap_func(svga, svga->memaddr);
                     dat  = *(uint32_t *) (&svga->vram[addr & svga->vram_display_mask]);
 
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                    *p++ = lut[dat & 0xffff];
+                    *p++ = lut[dat >> 16];
                     svga->memaddr += 4;
                 }
             }
@@ -1568,10 +1593,13 @@ svga_render_15bpp_highres(svga_t *svga)
     uint32_t  dat;
     uint32_t  changed_addr;
     uint32_t  addr;
+    const uint32_t *lut;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
 
+    lut = svga_conv_16to32_lut(svga, 15);
+
     if (svga->force_old_addr) {
         if (svga->changedvram[svga->memaddr >> 12] || svga->changedvram[(svga->memaddr >> 12) + 1] || svga->fullchange) {
             p = &svga->monitor->target_buffer->line[svga->displine + svga->y_add][svga->x_add];
@@ -1582,20 +1610,20 @@ svga_render_15bpp_highres(svga_t *svga)
 
             for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
                 dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-                p[x]     = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[x + 1] = svga->conv_16to32(svga, dat >> 16, 15);
+                p[x]     = lut[dat & 0xffff];
+                p[x + 1] = lut[dat >> 16];
 
                 dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-                p[x + 2] = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[x + 3] = svga->conv_16to32(svga, dat >> 16, 15);
+                p[x + 2] = lut[dat & 0xffff];
+                p[x + 3] = lut[dat >> 16];
 
                 dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
-                p[x + 4] = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[x + 5] = svga->conv_16to32(svga, dat >> 16, 15);
+                p[x + 4] = lut[dat & 0xffff];
+                p[x + 5] = lut[dat >> 16];
 
                 dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
-                p[x + 6] = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[x + 7] = svga->conv_16to32(svga, dat >> 16, 15);
+                p[x + 6] = lut[dat & 0xffff];
+                p[x + 7] = lut[dat >> 16];
             }
             svga->memaddr += x << 1;
             svga->memaddr &= svga->vram_display_mask;
@@ -1611,31 +1639,15 @@ svga_render_15bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-                }
+                x = svga_render_16bpp_line_lut(svga, p, lut);
                 svga->memaddr += x << 1;
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 2) {
                     addr = svga->remap_func(svga, svga->memaddr);
                     dat  = *(uint32_t *) (&svga->vram[addr & svga->vram_display_mask]);
 
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                    *p++ = lut[dat & 0xffff];
+                    *p++ = lut[dat >> 16];
                     svga->memaddr += 4;
                 }
             }
@@ -1650,10 +1662,13 @@ svga_render_15bpp_mix_lowres(svga_t *svga)
     int       x;
     uint32_t *p;
     uint32_t  dat;
+    const uint32_t *lut;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
 
+    lut = svga_conv_16to32_lut(svga, 15);
+
     if (svga->changedvram[svga->memaddr >> 12] || svga->changedvram[(svga->memaddr >> 12) + 1] || svga->fullchange) {
         p = &svga->monitor->target_buffer->line[svga->displine + svga->y_add][svga->x_add];
 
@@ -1663,16 +1678,16 @@ svga_render_15bpp_mix_lowres(svga_t *svga)
 
         for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
             dat       = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-            p[x << 1] = p[(x << 1) + 1] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x << 1] = p[(x << 1) + 1] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
 
             dat >>= 16;
-            p[(x << 1) + 2] = p[(x << 1) + 3] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[(x << 1) + 2] = p[(x << 1) + 3] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
 
             dat             = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-            p[(x << 1) + 4] = p[(x << 1) + 5] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[(x << 1) + 4] = p[(x << 1) + 5] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
 
             dat >>= 16;
-            p[(x << 1) + 6] = p[(x << 1) + 7] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[(x << 1) + 6] = p[(x << 1) + 7] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
         }
         svga->memaddr += x << 1;
         svga->memaddr &= svga->vram_display_mask;
@@ -1685,10 +1700,13 @@ svga_render_15bpp_mix_highres(svga_t *svga)
     int       x;
     uint32_t *p;
     uint32_t  dat;
+    const uint32_t *lut;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
 
+    lut = svga_conv_16to32_lut(svga, 15);
+
     if (svga->changedvram[svga->memaddr >> 12] || svga->changedvram[(svga->memaddr >> 12) + 1] || svga->fullchange) {
         p = &svga->monitor->target_buffer->line[svga->displine + svga->y_add][svga->x_add];
 
@@ -1698,24 +1716,24 @@ svga_render_15bpp_mix_highres(svga_t *svga)
 
         for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
             dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-            p[x] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
             dat >>= 16;
-            p[x + 1] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x + 1] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
 
             dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-            p[x + 2] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x + 2] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
             dat >>= 16;
-            p[x + 3] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x + 3] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
 
             dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
-            p[x + 4] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x + 4] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
             dat >>= 16;
-            p[x + 5] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x + 5] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
 
             dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
-            p[x + 6] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x + 6] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
             dat >>= 16;
-            p[x + 7] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : svga->conv_16to32(svga, dat & 0xffff, 15);
+            p[x + 7] = (dat & 0x00008000) ? svga->pallook[dat & 0xff] : lut[dat & 0xffff];
         }
         svga->memaddr += x << 1;
         svga->memaddr &= svga->vram_display_mask;
@@ -1730,10 +1748,13 @@ svga_render_16bpp_lowres(svga_t *svga)
     uint32_t  dat;
     uint32_t  changed_addr;
     uint32_t  addr;
+    const uint32_t *lut;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
 
+    lut = svga_conv_16to32_lut(svga, 16);
+
     if (svga->force_old_addr) {
         if (svga->changedvram[svga->memaddr >> 12] || svga->changedvram[(svga->memaddr >> 12) + 1] || svga->fullchange) {
             p = &svga->monitor->target_buffer->line[svga->displine + svga->y_add][svga->x_add];
@@ -1744,12 +1765,12 @@ svga_render_16bpp_lowres(svga_t *svga)
 
             for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
                 dat       = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-                p[x << 1] = p[(x << 1) + 1] = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[(x << 1) + 2] = p[(x << 1) + 3] = svga->conv_16to32(svga, dat >> 16, 16);
+                p[x << 1] = p[(x << 1) + 1] = lut[dat & 0xffff];
+                p[(x << 1) + 2] = p[(x << 1) + 3] = lut[dat >> 16];
 
                 dat             = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-                p[(x << 1) + 4] = p[(x << 1) + 5] = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[(x << 1) + 6] = p[(x << 1) + 7] = svga->conv_16to32(svga, dat >> 16, 16);
+                p[(x << 1) + 4] = p[(x << 1) + 5] = lut[dat & 0xffff];
+                p[(x << 1) + 6] = p[(x << 1) + 7] = lut[dat >> 16];
             }
             svga->memaddr += x << 1;
             svga->memaddr &= svga->vram_display_mask;
@@ -1768,13 +1789,13 @@ svga_render_16bpp_lowres(svga_t *svga)
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
                     dat = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
 
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                    *p++ = lut[dat & 0xffff];
+                    *p++ = lut[dat >> 16];
 
                     dat = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
 
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                    *p++ = lut[dat & 0xffff];
+                    *p++ = lut[dat >> 16];
                 }
                 svga->memaddr += x << 1;
             } else {
@@ -1782,8 +1803,8 @@ svga_render_16bpp_lowres(svga_t *svga)
                     addr = svga->remap_func(svga, svga->memaddr);
                     dat  = *(uint32_t *) (&svga->vram[addr & svga->vram_display_mask]);
 
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                    *p++ = lut[dat & 0xffff];
+                    *p++ = lut[dat >> 16];
                 }
                 svga->memaddr += 4;
             }
@@ -1800,10 +1821,13 @@ svga_render_16bpp_highres(svga_t *svga)
     uint32_t  dat;
     uint32_t  changed_addr;
     uint32_t  addr;
+    const uint32_t *lut;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
 
+    lut = svga_conv_16to32_lut(svga, 16);
+
     if (svga->force_old_addr) {
         if (svga->changedvram[svga->memaddr >> 12] || svga->changedvram[(svga->memaddr >> 12) + 1] || svga->fullchange) {
             p = &svga->monitor->target_buffer->line[svga->displine + svga->y_add][svga->x_add];
@@ -1814,20 +1838,20 @@ svga_render_16bpp_highres(svga_t *svga)
 
             for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
                 uint32_t dat = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-                p[x]         = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[x + 1]     = svga->conv_16to32(svga, dat >> 16, 16);
+                p[x]         = lut[dat & 0xffff];
+                p[x + 1]     = lut[dat >> 16];
 
                 dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-                p[x + 2] = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[x + 3] = svga->conv_16to32(svga, dat >> 16, 16);
+                p[x + 2] = lut[dat & 0xffff];
+                p[x + 3] = lut[dat >> 16];
 
                 dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
-                p[x + 4] = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[x + 5] = svga->conv_16to32(svga, dat >> 16, 16);
+                p[x + 4] = lut[dat & 0xffff];
+                p[x + 5] = lut[dat >> 16];
 
                 dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
-                p[x + 6] = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[x + 7] = svga->conv_16to32(svga, dat >> 16, 16);
+                p[x + 6] = lut[dat & 0xffff];
+                p[x + 7] = lut[dat >> 16];
             }
             svga->memaddr += x << 1;
             svga->memaddr &= svga->vram_display_mask;
@@ -1843,31 +1867,15 @@ svga_render_16bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-                }
+                x = svga_render_16bpp_line_lut(svga, p, lut);
                 svga->memaddr += x << 1;
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 2) {
                     addr = svga->remap_func(svga, svga->memaddr);
                     dat  = *(uint32_t *) (&svga->vram[addr & svga->vram_display_mask]);
 
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                    *p++ = lut[dat & 0xffff];
+                    *p++ = lut[dat >> 16];
 
                     svga->memaddr += 4;
                 }
@@ -55,6 +55,8 @@ rgba8_t ai88[0x10000];
 
 int tris = 0;
 
+static int voodoo_tables_made = 0;
+
 #ifdef ENABLE_VOODOO_LOG
 int voodoo_do_log = ENABLE_VOODOO_LOG;
 
@@ -400,7 +402,7 @@ voodoo_writew(uint32_t addr, uint16_t val, void *priv)
     cycles -= voodoo->write_time;
 
     if ((addr & 0xc00000) == 0x400000) /*Framebuffer*/
-        voodoo_queue_command(voodoo, addr | FIFO_WRITEW_FB, val);
+        voodoo_queue_fb_write(voodoo, addr | FIFO_WRITEW_FB, val);
 }
 
 static void
@@ -424,7 +426,7 @@ voodoo_writel(uint32_t addr, uint32_t val, void *priv)
         voodoo_queue_command(voodoo, addr | FIFO_WRITEL_TEX, val);
     } else if (addr & 0x400000) /*Framebuffer*/
     {
-        voodoo_queue_command(voodoo, addr | FIFO_WRITEL_FB, val);
+        voodoo_queue_fb_write(voodoo, addr | FIFO_WRITEL_FB, val);
     } else if ((addr & 0x200000) && (voodoo->fbiInit7 & FBIINIT7_CMDFIFO_ENABLE)) {
 #if 0
         voodoo_log("Write CMDFIFO %08x(%08x) %08x  %08x\n", addr, (voodoo->cmdfifo_base + (addr & 0x3fffc)) & voodoo->fb_mask, val, (voodoo->cmdfifo_base + (addr & 0x3fffc)) & voodoo->fb_mask);
@@ -915,6 +917,58 @@ voodoo_force_blit(void *priv)
     }
 }
 
+/* The texture format tables are the same for all cards, build them once. */
+static void
+voodoo_generate_tables(UNUSED(void *priv))
+{
+    for (int c = 0; c < 0x100; c++) {
+        rgb332[c].r = c & 0xe0;
+        rgb332[c].g = (c << 3) & 0xe0;
+        rgb332[c].b = (c << 6) & 0xc0;
+        rgb332[c].r = rgb332[c].r | (rgb332[c].r >> 3) | (rgb332[c].r >> 6);
+        rgb332[c].g = rgb332[c].g | (rgb332[c].g >> 3) | (rgb332[c].g >> 6);
+        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 2);
+        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 4);
+        rgb332[c].a = 0xff;
+
+        ai44[c].a = (c & 0xf0) | ((c & 0xf0) >> 4);
+        ai44[c].r = (c & 0x0f) | ((c & 0x0f) << 4);
+        ai44[c].g = ai44[c].b = ai44[c].r;
+    }
+
+    for (int c = 0; c < 0x10000; c++) {
+        rgb565[c].r = (c >> 8) & 0xf8;
+        rgb565[c].g = (c >> 3) & 0xfc;
+        rgb565[c].b = (c << 3) & 0xf8;
+        rgb565[c].r |= (rgb565[c].r >> 5);
+        rgb565[c].g |= (rgb565[c].g >> 6);
+        rgb565[c].b |= (rgb565[c].b >> 5);
+        rgb565[c].a = 0xff;
+
+        argb1555[c].r = (c >> 7) & 0xf8;
+        argb1555[c].g = (c >> 2) & 0xf8;
+        argb1555[c].b = (c << 3) & 0xf8;
+        argb1555[c].r |= (argb1555[c].r >> 5);
+        argb1555[c].g |= (argb1555[c].g >> 5);
+        argb1555[c].b |= (argb1555[c].b >> 5);
+        argb1555[c].a = (c & 0x8000) ? 0xff : 0;
+
+        argb4444[c].a = (c >> 8) & 0xf0;
+        argb4444[c].r = (c >> 4) & 0xf0;
+        argb4444[c].g = c & 0xf0;
+        argb4444[c].b = (c << 4) & 0xf0;
+        argb4444[c].a |= (argb4444[c].a >> 4);
+        argb4444[c].r |= (argb4444[c].r >> 4);
+        argb4444[c].g |= (argb4444[c].g >> 4);
+        argb4444[c].b |= (argb4444[c].b >> 4);
+
+        ai88[c].a = (c >> 8);
+        ai88[c].r = c & 0xff;
+        ai88[c].g = c & 0xff;
+        ai88[c].b = c & 0xff;
+    }
+}
+
 void *
 voodoo_card_init(void)
 {
@@ -950,10 +1004,8 @@ voodoo_card_init(void)
             break;
     }
 
-    if (voodoo->type == VOODOO_2) /*generate filter lookup tables*/
-        voodoo_generate_filter_v2(voodoo);
-    else
-        voodoo_generate_filter_v1(voodoo);
+    /*generate filter lookup tables*/
+    device_init_async(voodoo_generate_filter, voodoo);
 
     pci_add_card(PCI_ADD_NORMAL, voodoo_pci_read, voodoo_pci_write, voodoo, &voodoo->pci_slot);
 
@@ -982,79 +1034,26 @@ voodoo_card_init(void)
     voodoo->svga     = svga_get_pri();
     voodoo->fbiInit0 = 0;
 
-    voodoo->wake_fifo_thread         = thread_create_event();
-    voodoo->wake_render_thread[0]    = thread_create_event();
-    voodoo->wake_render_thread[1]    = thread_create_event();
-    voodoo->wake_render_thread[2]    = thread_create_event();
-    voodoo->wake_render_thread[3]    = thread_create_event();
-    voodoo->wake_main_thread         = thread_create_event();
-    voodoo->fifo_not_full_event      = thread_create_event();
-    voodoo->render_not_full_event[0] = thread_create_event();
-    voodoo->render_not_full_event[1] = thread_create_event();
-    voodoo->render_not_full_event[2] = thread_create_event();
-    voodoo->render_not_full_event[3] = thread_create_event();
-    voodoo->fifo_thread_run          = 1;
-    voodoo->fifo_thread              = thread_create(voodoo_fifo_thread, voodoo);
-    voodoo->render_thread_run[0]     = 1;
-    voodoo->render_thread[0]         = thread_create(voodoo_render_thread_1, voodoo);
-    if (voodoo->render_threads >= 2) {
-        voodoo->render_thread_run[1] = 1;
-        voodoo->render_thread[1]     = thread_create(voodoo_render_thread_2, voodoo);
+    voodoo->wake_fifo_thread    = thread_create_event();
+    voodoo->wake_main_thread    = thread_create_event();
+    voodoo->fifo_not_full_event = thread_create_event();
+    for (c = 0; c < voodoo->render_threads; c++) {
+        voodoo->wake_render_thread[c]    = thread_create_event();
+        voodoo->render_not_full_event[c] = thread_create_event();
     }
-    if (voodoo->render_threads == 4) {
-        voodoo->render_thread_run[2] = 1;
-        voodoo->render_thread[2]     = thread_create(voodoo_render_thread_3, voodoo);
-        voodoo->render_thread_run[3] = 1;
-        voodoo->render_thread[3]     = thread_create(voodoo_render_thread_4, voodoo);
+    voodoo_capture_open(voodoo);
+    voodoo->fifo_thread_run = 1;
+    voodoo->fifo_thread     = thread_create_role(voodoo_fifo_thread, voodoo, THREAD_ROLE_RENDER);
+    for (c = 0; c < voodoo->render_threads; c++) {
+        voodoo->render_thread_run[c] = 1;
+        voodoo->render_thread[c]     = thread_create_role(voodoo_render_thread_func[c], voodoo, THREAD_ROLE_RENDER);
     }
     voodoo->swap_mutex = thread_create_mutex();
     timer_add(&voodoo->wake_timer, voodoo_wake_timer, (void *) voodoo, 0);
 
-    for (c = 0; c < 0x100; c++) {
-        rgb332[c].r = c & 0xe0;
-        rgb332[c].g = (c << 3) & 0xe0;
-        rgb332[c].b = (c << 6) & 0xc0;
-        rgb332[c].r = rgb332[c].r | (rgb332[c].r >> 3) | (rgb332[c].r >> 6);
-        rgb332[c].g = rgb332[c].g | (rgb332[c].g >> 3) | (rgb332[c].g >> 6);
-        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 2);
-        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 4);
-        rgb332[c].a = 0xff;
-
-        ai44[c].a = (c & 0xf0) | ((c & 0xf0) >> 4);
-        ai44[c].r = (c & 0x0f) | ((c & 0x0f) << 4);
-        ai44[c].g = ai44[c].b = ai44[c].r;
-    }
-
-    for (c = 0; c < 0x10000; c++) {
-        rgb565[c].r = (c >> 8) & 0xf8;
-        rgb565[c].g = (c >> 3) & 0xfc;
-        rgb565[c].b = (c << 3) & 0xf8;
-        rgb565[c].r |= (rgb565[c].r >> 5);
-        rgb565[c].g |= (rgb565[c].g >> 6);
-        rgb565[c].b |= (rgb565[c].b >> 5);
-        rgb565[c].a = 0xff;
-
-        argb1555[c].r = (c >> 7) & 0xf8;
-        argb1555[c].g = (c >> 2) & 0xf8;
-        argb1555[c].b = (c << 3) & 0xf8;
-        argb1555[c].r |= (argb1555[c].r >> 5);
-        argb1555[c].g |= (argb1555[c].g >> 5);
-        argb1555[c].b |= (argb1555[c].b >> 5);
-        argb1555[c].a = (c & 0x8000) ? 0xff : 0;
-
-        argb4444[c].a = (c >> 8) & 0xf0;
-        argb4444[c].r = (c >> 4) & 0xf0;
-        argb4444[c].g = c & 0xf0;
-        argb4444[c].b = (c << 4) & 0xf0;
-        argb4444[c].a |= (argb4444[c].a >> 4);
-        argb4444[c].r |= (argb4444[c].r >> 4);
-        argb4444[c].g |= (argb4444[c].g >> 4);
-        argb4444[c].b |= (argb4444[c].b >> 4);
-
-        ai88[c].a = (c >> 8);
-        ai88[c].r = c & 0xff;
-        ai88[c].g = c & 0xff;
-        ai88[c].b = c & 0xff;
+    if (!voodoo_tables_made) {
+        device_init_async(voodoo_generate_tables, NULL);
+        voodoo_tables_made = 1;
     }
 #ifndef NO_CODEGEN
     voodoo_codegen_init(voodoo);
@@ -1088,9 +1087,6 @@ voodoo_2d3d_card_init(int type)
     voodoo->type      = type;
     voodoo->dual_tmus = (type == VOODOO_3) ? 1 : 0;
 
-    /*generate filter lookup tables*/
-    voodoo_generate_filter_v2(voodoo);
-
     for (c = 0; c < TEX_CACHE_MAX; c++) {
         voodoo->texture_cache[0][c].data     = malloc((256 * 256 + 256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2) * 4);
         voodoo->texture_cache[0][c].base     = -1; /*invalid*/
@@ -1106,79 +1102,26 @@ voodoo_2d3d_card_init(int type)
 
     voodoo->fbiInit0 = 0;
 
-    voodoo->wake_fifo_thread         = thread_create_event();
-    voodoo->wake_render_thread[0]    = thread_create_event();
-    voodoo->wake_render_thread[1]    = thread_create_event();
-    voodoo->wake_render_thread[2]    = thread_create_event();
-    voodoo->wake_render_thread[3]    = thread_create_event();
-    voodoo->wake_main_thread         = thread_create_event();
-    voodoo->fifo_not_full_event      = thread_create_event();
-    voodoo->render_not_full_event[0] = thread_create_event();
-    voodoo->render_not_full_event[1] = thread_create_event();
-    voodoo->render_not_full_event[2] = thread_create_event();
-    voodoo->render_not_full_event[3] = thread_create_event();
-    voodoo->fifo_thread_run          = 1;
-    voodoo->fifo_thread              = thread_create(voodoo_fifo_thread, voodoo);
-    voodoo->render_thread_run[0]     = 1;
-    voodoo->render_thread[0]         = thread_create(voodoo_render_thread_1, voodoo);
-    if (voodoo->render_threads >= 2) {
-        voodoo->render_thread_run[1] = 1;
-        voodoo->render_thread[1]     = thread_create(voodoo_render_thread_2, voodoo);
+    voodoo->wake_fifo_thread    = thread_create_event();
+    voodoo->wake_main_thread    = thread_create_event();
+    voodoo->fifo_not_full_event = thread_create_event();
+    for (c = 0; c < voodoo->render_threads; c++) {
+        voodoo->wake_render_thread[c]    = thread_create_event();
+        voodoo->render_not_full_event[c] = thread_create_event();
     }
-    if (voodoo->render_threads == 4) {
-        voodoo->render_thread_run[2] = 1;
-        voodoo->render_thread[2]     = thread_create(voodoo_render_thread_3, voodoo);
-        voodoo->render_thread_run[3] = 1;
-        voodoo->render_thread[3]     = thread_create(voodoo_render_thread_4, voodoo);
+    voodoo_capture_open(voodoo);
+    voodoo->fifo_thread_run = 1;
+    voodoo->fifo_thread     = thread_create_role(voodoo_fifo_thread, voodoo, THREAD_ROLE_RENDER);
+    for (c = 0; c < voodoo->render_threads; c++) {
+        voodoo->render_thread_run[c] = 1;
+        voodoo->render_thread[c]     = thread_create_role(voodoo_render_thread_func[c], voodoo, THREAD_ROLE_RENDER);
     }
     voodoo->swap_mutex = thread_create_mutex();
     timer_add(&voodoo->wake_timer, voodoo_wake_timer, (void *) voodoo, 0);
 
-    for (c = 0; c < 0x100; c++) {
-        rgb332[c].r = c & 0xe0;
-        rgb332[c].g = (c << 3) & 0xe0;
-        rgb332[c].b = (c << 6) & 0xc0;
-        rgb332[c].r = rgb332[c].r | (rgb332[c].r >> 3) | (rgb332[c].r >> 6);
-        rgb332[c].g = rgb332[c].g | (rgb332[c].g >> 3) | (rgb332[c].g >> 6);
-        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 2);
-        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 4);
-        rgb332[c].a = 0xff;
-
-        ai44[c].a = (c & 0xf0) | ((c & 0xf0) >> 4);
-        ai44[c].r = (c & 0x0f) | ((c & 0x0f) << 4);
-        ai44[c].g = ai44[c].b = ai44[c].r;
-    }
-
-    for (c = 0; c < 0x10000; c++) {
-        rgb565[c].r = (c >> 8) & 0xf8;
-        rgb565[c].g = (c >> 3) & 0xfc;
-        rgb565[c].b = (c << 3) & 0xf8;
-        rgb565[c].r |= (rgb565[c].r >> 5);
-        rgb565[c].g |= (rgb565[c].g >> 6);
-        rgb565[c].b |= (rgb565[c].b >> 5);
-        rgb565[c].a = 0xff;
-
-        argb1555[c].r = (c >> 7) & 0xf8;
-        argb1555[c].g = (c >> 2) & 0xf8;
-        argb1555[c].b = (c << 3) & 0xf8;
-        argb1555[c].r |= (argb1555[c].r >> 5);
-        argb1555[c].g |= (argb1555[c].g >> 5);
-        argb1555[c].b |= (argb1555[c].b >> 5);
-        argb1555[c].a = (c & 0x8000) ? 0xff : 0;
-
-        argb4444[c].a = (c >> 8) & 0xf0;
-        argb4444[c].r = (c >> 4) & 0xf0;
-        argb4444[c].g = c & 0xf0;
-        argb4444[c].b = (c << 4) & 0xf0;
-        argb4444[c].a |= (argb4444[c].a >> 4);
-        argb4444[c].r |= (argb4444[c].r >> 4);
-        argb4444[c].g |= (argb4444[c].g >> 4);
-        argb4444[c].b |= (argb4444[c].b >> 4);
-
-        ai88[c].a = (c >> 8);
-        ai88[c].r = c & 0xff;
-        ai88[c].g = c & 0xff;
-        ai88[c].b = c & 0xff;
+    if (!voodoo_tables_made) {
+        device_init_async(voodoo_generate_tables, NULL);
+        voodoo_tables_made = 1;
     }
 #ifndef NO_CODEGEN
     voodoo_codegen_init(voodoo);
@@ -1257,29 +1200,19 @@ voodoo_card_close(voodoo_t *voodoo)
     voodoo->fifo_thread_run = 0;
     thread_set_event(voodoo->wake_fifo_thread);
     thread_wait(voodoo->fifo_thread);
-    voodoo->render_thread_run[0] = 0;
-    thread_set_event(voodoo->wake_render_thread[0]);
-    thread_wait(voodoo->render_thread[0]);
-    if (voodoo->render_threads >= 2) {
-        voodoo->render_thread_run[1] = 0;
-        thread_set_event(voodoo->wake_render_thread[1]);
-        thread_wait(voodoo->render_thread[1]);
-    }
-    if (voodoo->render_threads == 4) {
-        voodoo->render_thread_run[2] = 0;
-        thread_set_event(voodoo->wake_render_thread[2]);
-        thread_wait(voodoo->render_thread[2]);
-        voodoo->render_thread_run[3] = 0;
-        thread_set_event(voodoo->wake_render_thread[3]);
-        thread_wait(voodoo->render_thread[3]);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        voodoo->render_thread_run[c] = 0;
+        thread_set_event(voodoo->wake_render_thread[c]);
+        thread_wait(voodoo->render_thread[c]);
     }
     thread_destroy_event(voodoo->fifo_not_full_event);
     thread_destroy_event(voodoo->wake_main_thread);
     thread_destroy_event(voodoo->wake_fifo_thread);
-    thread_destroy_event(voodoo->wake_render_thread[0]);
-    thread_destroy_event(voodoo->wake_render_thread[1]);
-    thread_destroy_event(voodoo->render_not_full_event[0]);
-    thread_destroy_event(voodoo->render_not_full_event[1]);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        thread_destroy_event(voodoo->wake_render_thread[c]);
+        thread_destroy_event(voodoo->render_not_full_event[c]);
+    }
+    voodoo_capture_close(voodoo);
 
     for (uint8_t c = 0; c < TEX_CACHE_MAX; c++) {
         if (voodoo->dual_tmus)
@@ -1405,6 +1338,7 @@ static const device_config_t voodoo_config[] = {
             { .description = "1", .value = 1 },
             { .description = "2", .value = 2 },
             { .description = "4", .value = 4 },
+            { .description = "8", .value = 8 },
             { .description = ""              }
         },
         .bios           = { { 0 } }
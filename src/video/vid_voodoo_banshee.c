@@ -530,6 +530,7 @@ banshee_render_16bpp_tiled(svga_t *svga)
     banshee_t *banshee = (banshee_t *) svga->priv;
     uint32_t  *p = &(svga->monitor->target_buffer->line[svga->displine + svga->y_add])[svga->x_add];
     uint32_t   addr;
+    const uint32_t *lut;
     int        drawn = 0;
 
     if ((svga->displine + svga->y_add) < 0)
@@ -543,6 +544,8 @@ banshee_render_16bpp_tiled(svga_t *svga)
     if (addr >= svga->vram_max)
         return;
 
+    lut = svga_conv_16to32_lut(svga, 16);
+
     for (int x = 0; x < svga->hdisp; x += 64) {
         if (svga->hwcursor_on || svga->overlay_on)
             svga->changedvram[addr >> 12] = 2;
@@ -550,7 +553,7 @@ banshee_render_16bpp_tiled(svga_t *svga)
             const uint16_t *vram_p = (uint16_t *) &svga->vram[addr & svga->vram_display_mask];
 
             for (uint8_t xx = 0; xx < 64; xx++)
-                *p++ = banshee_conv_16to32(svga, *vram_p++, 16);
+                *p++ = lut[*vram_p++];
 
             drawn = 1;
         } else
@@ -899,10 +902,13 @@ banshee_ext_outl(uint16_t addr, uint32_t val, void *priv)
             break;
         case DAC_dacData:
             svga->pallook[banshee->dacAddr] = val & 0xffffff;
+            svga->pal_gen++;
             svga->fullchange                = changeframecount;
             break;
 
         case Video_vidProcCfg:
+            if ((banshee->vidProcCfg ^ val) & VIDPROCCFG_DESKTOP_CLUT_SEL)
+                svga->pal_gen++;
             banshee->vidProcCfg = val;
 #if 0
             banshee_log("vidProcCfg=%08x\n", val);
@@ -1127,7 +1133,7 @@ banshee_status(banshee_t *banshee)
     int           fifo_entries = FIFO_ENTRIES;
     int           swap_count   = voodoo->swap_count;
     int           written      = voodoo->cmd_written + voodoo->cmd_written_fifo;
-    int           busy         = (written - voodoo->cmd_read) || (voodoo->cmdfifo_depth_rd != voodoo->cmdfifo_depth_wr) || (voodoo->cmdfifo_depth_rd_2 != voodoo->cmdfifo_depth_wr_2) || voodoo->render_voodoo_busy[0] || voodoo->render_voodoo_busy[1] || voodoo->render_voodoo_busy[2] || voodoo->render_voodoo_busy[3] || voodoo->voodoo_busy;
+    int           busy         = (written - voodoo->cmd_read) || (voodoo->cmdfifo_depth_rd != voodoo->cmdfifo_depth_wr) || (voodoo->cmdfifo_depth_rd_2 != voodoo->cmdfifo_depth_wr_2) || voodoo_render_threads_busy(voodoo) || voodoo->voodoo_busy;
     uint32_t      ret          = 0;
 
     if (fifo_entries < 0x20)
@@ -1647,7 +1653,7 @@ banshee_reg_writew(uint32_t addr, uint16_t val, void *priv)
         case 0x1d00000:
         case 0x1e00000:
         case 0x1f00000:
-            voodoo_queue_command(voodoo, (addr & 0xffffff) | FIFO_WRITEW_FB, val);
+            voodoo_queue_fb_write(voodoo, (addr & 0xffffff) | FIFO_WRITEW_FB, val);
             break;
 
         default:
@@ -1960,7 +1966,7 @@ banshee_reg_writel(uint32_t addr, uint32_t val, void *priv)
         case 0x1d00000:
         case 0x1e00000:
         case 0x1f00000:
-            voodoo_queue_command(voodoo, (addr & 0xfffffc) | FIFO_WRITEL_FB, val);
+            voodoo_queue_fb_write(voodoo, (addr & 0xfffffc) | FIFO_WRITEL_FB, val);
             break;
 
         default:
@@ -2419,82 +2425,12 @@ banshee_hwcursor_draw(svga_t *svga, int displine)
         }                                                                                                               \
     } while (0)
 
-#define DECODE_YUYV422(buf)                                      \
-    do {                                                         \
-        int c;                                                   \
-        int wp = 0;                                              \
-                                                                 \
-        for (c = 0; c < voodoo->overlay.overlay_bytes; c += 4) { \
-            uint8_t y1, y2;                                      \
-            int8_t  Cr, Cb;                                      \
-            int     dR, dG, dB;                                  \
-            int     r, g, b;                                     \
-                                                                 \
-            y1 = src[0];                                         \
-            Cr = src[1] - 0x80;                                  \
-            y2 = src[2];                                         \
-            Cb = src[3] - 0x80;                                  \
-            src += 4;                                            \
-                                                                 \
-            dR = (359 * Cr) >> 8;                                \
-            dG = (88 * Cb + 183 * Cr) >> 8;                      \
-            dB = (453 * Cb) >> 8;                                \
-                                                                 \
-            r = y1 + dR;                                         \
-            CLAMP(r);                                            \
-            g = y1 - dG;                                         \
-            CLAMP(g);                                            \
-            b = y1 + dB;                                         \
-            CLAMP(b);                                            \
-            buf[wp++] = r | (g << 8) | (b << 16);                \
-                                                                 \
-            r = y2 + dR;                                         \
-            CLAMP(r);                                            \
-            g = y2 - dG;                                         \
-            CLAMP(g);                                            \
-            b = y2 + dB;                                         \
-            CLAMP(b);                                            \
-            buf[wp++] = r | (g << 8) | (b << 16);                \
-        }                                                        \
-    } while (0)
-
-#define DECODE_UYUV422(buf)                                      \
-    do {                                                         \
-        int c;                                                   \
-        int wp = 0;                                              \
-                                                                 \
-        for (c = 0; c < voodoo->overlay.overlay_bytes; c += 4) { \
-            uint8_t y1, y2;                                      \
-            int8_t  Cr, Cb;                                      \
-            int     dR, dG, dB;                                  \
-            int     r, g, b;                                     \
-                                                                 \
-            Cr = src[0] - 0x80;                                  \
-            y1 = src[1];                                         \
-            Cb = src[2] - 0x80;                                  \
-            y2 = src[3];                                         \
-            src += 4;                                            \
-                                                                 \
-            dR = (359 * Cr) >> 8;                                \
-            dG = (88 * Cb + 183 * Cr) >> 8;                      \
-            dB = (453 * Cb) >> 8;                                \
-                                                                 \
-            r = y1 + dR;                                         \
-            CLAMP(r);                                            \
-            g = y1 - dG;                                         \
-            CLAMP(g);                                            \
-            b = y1 + dB;                                         \
-            CLAMP(b);                                            \
-            buf[wp++] = r | (g << 8) | (b << 16);                \
-                                                                 \
-            r = y2 + dR;                                         \
-            CLAMP(r);                                            \
-            g = y2 - dG;                                         \
-            CLAMP(g);                                            \
-            b = y2 + dB;                                         \
-            CLAMP(b);                                            \
-            buf[wp++] = r | (g << 8) | (b << 16);                \
-        }                                                        \
+#define DECODE_YUV422(buf, order)                                                \
+    do {                                                                         \
+        int pairs = (voodoo->overlay.overlay_bytes + 3) >> 2;                    \
+                                                                                 \
+        video_yuv422_to_rgb(buf, src, pairs, order);                             \
+        src += pairs << 2;                                                       \
     } while (0)
 
 #define OVERLAY_SAMPLE(buf)                                                      \
@@ -2504,11 +2440,11 @@ banshee_hwcursor_draw(svga_t *svga, int displine)
                 break;                                                           \
                                                                                  \
             case OVERLAY_FMT_YUYV422:                                            \
-                DECODE_YUYV422(buf);                                             \
+                DECODE_YUV422(buf, VIDEO_YUV422_YCRYCB);                         \
                 break;                                                           \
                                                                                  \
             case OVERLAY_FMT_UYVY422:                                            \
-                DECODE_UYUV422(buf);                                             \
+                DECODE_YUV422(buf, VIDEO_YUV422_CRYCBY);                         \
                 break;                                                           \
                                                                                  \
             case OVERLAY_FMT_565:                                                \
@@ -3499,7 +3435,7 @@ banshee_init_common(const device_t *info, char *fn, int has_sgram, int type, int
     banshee->voodoo->texture_mask = banshee->svga.vram_mask;
     banshee->voodoo->cmd_status   = (1 << 28);
     banshee->voodoo->cmd_status_2 = (1 << 28);
-    voodoo_generate_filter_v1(banshee->voodoo);
+    device_init_async(voodoo_generate_filter, banshee->voodoo);
 
     banshee->vidSerialParallelPort = VIDSERIAL_DDC_DCK_W | VIDSERIAL_DDC_DDA_W;
 
@@ -3885,6 +3821,7 @@ static const device_config_t banshee_sgram_config[] = {
             { .description = "1", .value = 1 },
             { .description = "2", .value = 2 },
             { .description = "4", .value = 4 },
+            { .description = "8", .value = 8 },
             { .description = ""              }
         },
         .bios           = { { 0 } }
@@ -3962,6 +3899,7 @@ static const device_config_t banshee_sgram_16mbonly_config[] = {
             { .description = "1", .value = 1 },
             { .description = "2", .value = 2 },
             { .description = "4", .value = 4 },
+            { .description = "8", .value = 8 },
             { .description = ""              }
         },
         .bios           = { { 0 } }
@@ -4039,6 +3977,7 @@ static const device_config_t banshee_sdram_config[] = {
             { .description = "1", .value = 1 },
             { .description = "2", .value = 2 },
             { .description = "4", .value = 4 },
+            { .description = "8", .value = 8 },
             { .description = ""              }
         },
         .bios           = { { 0 } }
@@ -186,6 +186,35 @@ MIX(voodoo_t *voodoo, uint32_t dest, uint32_t src, uint32_t pattern, int colour_
 
     rop = voodoo->banshee_blt.rops[rop_nr];
 
+    /*Handle the common ROPs directly rather than summing minterms*/
+    switch (rop) {
+        case 0x00: /*BLACKNESS*/
+            return 0;
+        case 0x33: /*NOTSRCCOPY*/
+            return ~src;
+        case 0x55: /*DSTINVERT*/
+            return ~dest;
+        case 0x5a: /*PATINVERT*/
+            return pattern ^ dest;
+        case 0x66: /*SRCINVERT*/
+            return src ^ dest;
+        case 0x88: /*SRCAND*/
+            return src & dest;
+        case 0xaa: /*NOP*/
+            return dest;
+        case 0xcc: /*SRCCOPY*/
+            return src;
+        case 0xee: /*SRCPAINT*/
+            return src | dest;
+        case 0xf0: /*PATCOPY*/
+            return pattern;
+        case 0xff: /*WHITENESS*/
+            return 0xffffffff;
+
+        default:
+            break;
+    }
+
     if (rop & 0x01)
         result |= (~pattern & ~src & ~dest);
     if (rop & 0x02)
@@ -428,6 +457,126 @@ end_command(voodoo_t *voodoo)
     }
 }
 
+/*Rectangle fill for ROPs that don't read the destination, on a linear
+  framebuffer with no colour keying or transparency. The ROP is resolved for
+  the 8 pattern columns once per row and the row is written straight into
+  VRAM. Returns 0 if the fill has to go through PLOT.*/
+static int
+banshee_do_rectfill_span(voodoo_t *voodoo)
+{
+    const clip_t   *clip         = &voodoo->banshee_blt.clip[(voodoo->banshee_blt.command & COMMAND_CLIP_SEL) ? 1 : 0];
+    int             dst_y        = voodoo->banshee_blt.dstY;
+    const uint8_t  *pattern_mono = (uint8_t *) voodoo->banshee_blt.colorPattern;
+    int             pat_y        = (voodoo->banshee_blt.commandExtra & CMDEXTRA_FORCE_PAT_ROW0) ? 0 : (voodoo->banshee_blt.patoff_y + voodoo->banshee_blt.dstY);
+    uint8_t         rop          = voodoo->banshee_blt.rops[0];
+    const uint32_t *pattern_col;
+    uint32_t        res[8];
+    int             bpp;
+    int             x_l;
+    int             x_r;
+
+    if (voodoo->banshee_blt.commandExtra & (CMDEXTRA_SRC_COLORKEY | CMDEXTRA_DST_COLORKEY))
+        return 0;
+    if ((voodoo->banshee_blt.command & (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO)) == (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO))
+        return 0;
+    if (voodoo->banshee_blt.dstBaseAddr_tiled)
+        return 0;
+    if (((rop >> 1) & 0x55) != (rop & 0x55))
+        return 0; /*ROP reads the destination*/
+
+    switch (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK) {
+        case DST_FORMAT_COL_8_BPP:
+            bpp         = 1;
+            pattern_col = voodoo->banshee_blt.colorPattern8;
+            break;
+        case DST_FORMAT_COL_16_BPP:
+            bpp         = 2;
+            pattern_col = voodoo->banshee_blt.colorPattern16;
+            break;
+        case DST_FORMAT_COL_24_BPP:
+            bpp         = 3;
+            pattern_col = voodoo->banshee_blt.colorPattern24;
+            break;
+        case DST_FORMAT_COL_32_BPP:
+            bpp         = 4;
+            pattern_col = voodoo->banshee_blt.colorPattern;
+            break;
+
+        default:
+            return 0;
+    }
+
+    if (voodoo->banshee_blt.command & COMMAND_DX) {
+        x_l = voodoo->banshee_blt.dstX - voodoo->banshee_blt.dstSizeX + 1;
+        x_r = voodoo->banshee_blt.dstX;
+    } else {
+        x_l = voodoo->banshee_blt.dstX;
+        x_r = voodoo->banshee_blt.dstX + voodoo->banshee_blt.dstSizeX - 1;
+    }
+    if (x_l < clip->x_min)
+        x_l = clip->x_min;
+    if (x_r >= clip->x_max)
+        x_r = clip->x_max - 1;
+    if (x_l < 0)
+        return 0;
+
+    for (voodoo->banshee_blt.cur_y = 0; voodoo->banshee_blt.cur_y < voodoo->banshee_blt.dstSizeY; voodoo->banshee_blt.cur_y++) {
+        if (dst_y >= clip->y_min && dst_y < clip->y_max && x_l <= x_r) {
+            uint8_t  pattern_mask = pattern_mono[pat_y & 7];
+            int      pat_x        = voodoo->banshee_blt.patoff_x + x_l;
+            uint32_t addr         = (voodoo->banshee_blt.dstBaseAddr + x_l * bpp + dst_y * voodoo->banshee_blt.dst_stride) & voodoo->fb_mask;
+            int      count        = x_r - x_l + 1;
+
+            for (uint8_t c = 0; c < 8; c++) {
+                int      px      = (pat_x + c) & 7;
+                uint32_t pattern = (voodoo->banshee_blt.command & COMMAND_PATTERN_MONO) ? ((pattern_mask & (1 << (7 - px))) ? voodoo->banshee_blt.colorFore : voodoo->banshee_blt.colorBack) : pattern_col[px + (pat_y & 7) * 8];
+
+                res[c] = MIX(voodoo, 0, voodoo->banshee_blt.colorFore, pattern, COLORKEY_32, COLORKEY_32);
+            }
+
+            if ((addr + count * bpp) > (voodoo->fb_mask + 1)) {
+                /*Row wraps around the end of VRAM*/
+                for (int x = x_l; x <= x_r; x++)
+                    PLOT(voodoo, x, dst_y, voodoo->banshee_blt.patoff_x + x, pat_y, pattern_mask, rop, voodoo->banshee_blt.colorFore, COLORKEY_32);
+            } else {
+                uint8_t *p = &voodoo->vram[addr];
+
+                switch (bpp) {
+                    case 1:
+                        for (int x = 0; x < count; x++)
+                            p[x] = res[x & 7];
+                        break;
+                    case 2:
+                        for (int x = 0; x < count; x++)
+                            ((uint16_t *) p)[x] = res[x & 7];
+                        break;
+                    case 3:
+                        for (int x = 0; x < count; x++) {
+                            p[x * 3]     = res[x & 7];
+                            p[x * 3 + 1] = res[x & 7] >> 8;
+                            p[x * 3 + 2] = res[x & 7] >> 16;
+                        }
+                        break;
+                    default:
+                        for (int x = 0; x < count; x++)
+                            ((uint32_t *) p)[x] = res[x & 7];
+                        break;
+                }
+
+                for (uint32_t block = addr >> 12; block <= ((addr + count * bpp - 1) >> 12); block++)
+                    voodoo->changedvram[block] = changeframecount;
+            }
+            voodoo->banshee_blt.cur_x = voodoo->banshee_blt.dstSizeX;
+        }
+        dst_y += (voodoo->banshee_blt.command & COMMAND_DY) ? -1 : 1;
+        if (!(voodoo->banshee_blt.commandExtra & CMDEXTRA_FORCE_PAT_ROW0))
+            pat_y += (voodoo->banshee_blt.command & COMMAND_DY) ? -1 : 1;
+    }
+
+    end_command(voodoo);
+    return 1;
+}
+
 static void
 banshee_do_rectfill(voodoo_t *voodoo)
 {
@@ -443,6 +592,9 @@ banshee_do_rectfill(voodoo_t *voodoo)
     bansheeblt_log("clipping: %i,%i -> %i,%i\n", clip->x_min, clip->y_min, clip->x_max, clip->y_max);
     bansheeblt_log("colorFore=%08x\n", voodoo->banshee_blt.colorFore);
 #endif
+    if (banshee_do_rectfill_span(voodoo))
+        return;
+
     for (voodoo->banshee_blt.cur_y = 0; voodoo->banshee_blt.cur_y < voodoo->banshee_blt.dstSizeY; voodoo->banshee_blt.cur_y++) {
         int dst_x = voodoo->banshee_blt.dstX;
 
@@ -562,6 +714,92 @@ DECODE_YUYV422_16BPP(uint16_t *buf, uint8_t *src)
     } while (0);
 }
 
+/*Straight SRCCOPY of one line between linear surfaces of the same format.
+  Only taken when copying the whole run at once gives the same result as
+  the pixel at a time copy in the blit's X direction. Returns 0 if the line
+  has to go through the pixel loop.*/
+static int
+do_screen_to_screen_copy_line(voodoo_t *voodoo, const uint8_t *src_p, int src_x, int dst_y, const clip_t *clip)
+{
+    int      bpp;
+    int      x_l;
+    int      x_r;
+    int      src_l;
+    int      count;
+    uint32_t dst_addr;
+    uint32_t src_addr;
+
+    if (voodoo->banshee_blt.rops[0] != 0xcc)
+        return 0;
+    if (voodoo->banshee_blt.commandExtra & (CMDEXTRA_SRC_COLORKEY | CMDEXTRA_DST_COLORKEY))
+        return 0;
+    if ((voodoo->banshee_blt.command & (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO)) == (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO))
+        return 0;
+    if (voodoo->banshee_blt.dstBaseAddr_tiled)
+        return 0;
+
+    switch (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK) {
+        case DST_FORMAT_COL_8_BPP:
+            bpp = 1;
+            break;
+        case DST_FORMAT_COL_16_BPP:
+            bpp = 2;
+            break;
+        case DST_FORMAT_COL_24_BPP:
+            bpp = 3;
+            break;
+        case DST_FORMAT_COL_32_BPP:
+            bpp = 4;
+            break;
+
+        default:
+            return 0;
+    }
+    if (voodoo->banshee_blt.src_bpp != (bpp * 8))
+        return 0;
+
+    if (voodoo->banshee_blt.command & COMMAND_DX) {
+        x_l   = voodoo->banshee_blt.dstX - voodoo->banshee_blt.dstSizeX + 1;
+        src_l = src_x - voodoo->banshee_blt.dstSizeX + 1;
+    } else {
+        x_l   = voodoo->banshee_blt.dstX;
+        src_l = src_x;
+    }
+    x_r = x_l + voodoo->banshee_blt.dstSizeX - 1;
+    if (x_l < clip->x_min) {
+        src_l += clip->x_min - x_l;
+        x_l = clip->x_min;
+    }
+    if (x_r >= clip->x_max)
+        x_r = clip->x_max - 1;
+    if ((x_l < 0) || (src_l < 0))
+        return 0;
+
+    count = (x_r - x_l + 1) * bpp;
+    if (count > 0) {
+        dst_addr = (voodoo->banshee_blt.dstBaseAddr + x_l * bpp + dst_y * voodoo->banshee_blt.dst_stride) & voodoo->fb_mask;
+        src_addr = (src_p - voodoo->vram) + src_l * bpp;
+
+        if (((dst_addr + count) > (voodoo->fb_mask + 1)) || ((src_addr + count) > (voodoo->fb_mask + 1)))
+            return 0;
+
+        /*Overlapping runs copied against the X direction smear on hardware*/
+        if (voodoo->banshee_blt.command & COMMAND_DX) {
+            if ((dst_addr < src_addr) && ((dst_addr + count) > src_addr))
+                return 0;
+        } else if ((dst_addr > src_addr) && (dst_addr < (src_addr + count)))
+            return 0;
+
+        memmove(&voodoo->vram[dst_addr], &voodoo->vram[src_addr], count);
+
+        for (uint32_t block = dst_addr >> 12; block <= ((dst_addr + count - 1) >> 12); block++)
+            voodoo->changedvram[block] = changeframecount;
+    }
+
+    voodoo->banshee_blt.cur_x = voodoo->banshee_blt.dstSizeX;
+    return 1;
+}
+
 static void
 do_screen_to_screen_line(voodoo_t *voodoo, uint8_t *src_p, int use_x_dir, int src_x, int src_tiled)
 {
@@ -589,7 +827,8 @@ do_screen_to_screen_line(voodoo_t *voodoo, uint8_t *src_p, int use_x_dir, int sr
 #endif
     if ((voodoo->banshee_blt.srcFormat & SRC_FORMAT_COL_MASK) == (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK)) {
         /*No conversion required*/
-        if (dst_y >= clip->y_min && dst_y < clip->y_max) {
+        if (dst_y >= clip->y_min && dst_y < clip->y_max &&
+            !(use_x_dir && !src_tiled && do_screen_to_screen_copy_line(voodoo, src_p, src_x, dst_y, clip))) {
             int     dst_x        = voodoo->banshee_blt.dstX;
             int     pat_x        = voodoo->banshee_blt.patoff_x + voodoo->banshee_blt.dstX;
             uint8_t pattern_mask = pattern_mono[pat_y & 7];
@@ -350,6 +350,18 @@ voodoo_generate_filter_v2(voodoo_t *voodoo)
     }
 }
 
+/* Filter tables for the card type, run from device_init_async() at init. */
+void
+voodoo_generate_filter(void *priv)
+{
+    voodoo_t *voodoo = (voodoo_t *) priv;
+
+    if (voodoo->type == VOODOO_2)
+        voodoo_generate_filter_v2(voodoo);
+    else
+        voodoo_generate_filter_v1(voodoo);
+}
+
 void
 voodoo_threshold_check(voodoo_t *voodoo)
 {
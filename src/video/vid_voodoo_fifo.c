@@ -13,6 +13,8 @@
  *          Copyright 2008-2020 Sarah Walker.
  */
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -42,6 +44,8 @@
 #include <86box/vid_voodoo_render.h>
 #include <86box/vid_voodoo_texture.h>
 
+#include <minitrace/minitrace.h>
+
 #ifdef ENABLE_VOODOO_FIFO_LOG
 int voodoo_fifo_do_log = ENABLE_VOODOO_FIFO_LOG;
 
@@ -60,13 +64,103 @@ voodoo_fifo_log(const char *fmt, ...)
 #    define voodoo_fifo_log(fmt, ...)
 #endif
 
+/* (B) Record the FIFO stream of each card to voodoo_capture_path. */
+int  voodoo_capture = 0;
+char voodoo_capture_path[1024];
+
+/*
+ * Capture file format, all fields little endian 32-bit:
+ *   header: "VCAP", version, card type, framebuffer MB, texture MB, dual TMUs
+ *   record: addr_type, val
+ * Records are FIFO entries in the order the FIFO thread processed them,
+ * with the FIFO_* type in the top byte, or CMDFIFO words tagged with
+ * VOODOO_CAPTURE_CMDFIFO(_2). Register writes that bypass the FIFO (PCI
+ * config, init registers) are not recorded, so start capturing from
+ * power-on.
+ */
+#define VOODOO_CAPTURE_VERSION   1
+#define VOODOO_CAPTURE_CMDFIFO   (0x10 << 24)
+#define VOODOO_CAPTURE_CMDFIFO_2 (0x11 << 24)
+
+void
+voodoo_capture_open(voodoo_t *voodoo)
+{
+    static int cards = 0;
+    char       path[1024 + 16];
+    uint32_t   header[6];
+
+    voodoo->capture_fp      = NULL;
+    voodoo->capture_records = 0;
+
+    if (!voodoo_capture)
+        return;
+
+    /* The first card writes to the given path, further cards (SLI) get a suffix. */
+    if (cards == 0)
+        snprintf(path, sizeof(path), "%s", voodoo_capture_path);
+    else
+        snprintf(path, sizeof(path), "%s.%i", voodoo_capture_path, cards);
+    cards++;
+
+    voodoo->capture_fp = plat_fopen(path, "wb");
+    if (voodoo->capture_fp == NULL) {
+        pclog("Voodoo: unable to open capture file %s\n", path);
+        return;
+    }
+
+    memcpy(&header[0], "VCAP", 4);
+    header[1] = VOODOO_CAPTURE_VERSION;
+    header[2] = voodoo->type;
+    header[3] = voodoo->fb_size;
+    header[4] = voodoo->texture_size;
+    header[5] = voodoo->dual_tmus;
+    fwrite(header, sizeof(uint32_t), 6, voodoo->capture_fp);
+}
+
+void
+voodoo_capture_close(voodoo_t *voodoo)
+{
+    if (voodoo->capture_fp == NULL)
+        return;
+
+    pclog("Voodoo: captured %" PRIu64 " records, FIFO thread busy for %" PRIu64 " ms\n",
+          voodoo->capture_records, (voodoo->time * 1000) / timer_freq);
+
+    fclose(voodoo->capture_fp);
+    voodoo->capture_fp = NULL;
+}
+
+static __inline void
+voodoo_capture_write(voodoo_t *voodoo, uint32_t addr_type, uint32_t val)
+{
+    uint32_t record[2] = { addr_type, val };
+
+    if (voodoo->capture_fp == NULL)
+        return;
+
+    fwrite(record, sizeof(uint32_t), 2, voodoo->capture_fp);
+    voodoo->capture_records++;
+}
+
 #define WAKE_DELAY_DEFAULT (TIMER_USEC * 100)
 
 /* Per-card wake delay: Voodoo1 uses a larger delay to reduce FIFO wake frequency */
 #define WAKE_DELAY_OF(v) ((v)->type == VOODOO_1 ? (TIMER_USEC * 2000) : WAKE_DELAY_DEFAULT)
+static int
+voodoo_fifo_pending(voodoo_t *voodoo)
+{
+    return !FIFO_EMPTY || (voodoo->cmdfifo_enabled && (voodoo->cmdfifo_depth_rd != voodoo->cmdfifo_depth_wr || voodoo->cmdfifo_in_sub)) || (voodoo->cmdfifo_enabled_2 && (voodoo->cmdfifo_depth_rd_2 != voodoo->cmdfifo_depth_wr_2 || voodoo->cmdfifo_in_sub_2));
+}
+
 void
 voodoo_wake_fifo_thread(voodoo_t *voodoo)
 {
+    /*The FIFO thread looks for more work before it goes idle, so it does not
+      need waking while it is still draining.*/
+    atomic_thread_fence(memory_order_seq_cst);
+    if (voodoo->voodoo_busy)
+        return;
+
     if (!timer_is_enabled(&voodoo->wake_timer)) {
         /*Don't wake FIFO thread immediately - if we do that it will probably
           process one word and go back to sleep, requiring it to be woken on
@@ -87,6 +181,10 @@ voodoo_wake_timer(void *priv)
 {
     voodoo_t *voodoo = (voodoo_t *) priv;
 
+    atomic_thread_fence(memory_order_seq_cst);
+    if (voodoo->voodoo_busy)
+        return;
+
     thread_set_event(voodoo->wake_fifo_thread); /*Wake up FIFO thread if moving from idle*/
 }
 
@@ -114,6 +212,34 @@ voodoo_queue_command(voodoo_t *voodoo, uint32_t addr_type, uint32_t val)
         voodoo_wake_fifo_thread(voodoo);
 }
 
+/* Nothing queued and no thread working on the card. Only the CPU thread queues
+   work, so this stays true until it queues something itself. */
+static int
+voodoo_fifo_idle(voodoo_t *voodoo)
+{
+    return FIFO_EMPTY && !voodoo->voodoo_busy && !voodoo->cmdfifo_in_sub && !voodoo->cmdfifo_in_sub_2 &&
+           (voodoo->cmdfifo_depth_rd == voodoo->cmdfifo_depth_wr) &&
+           (voodoo->cmdfifo_depth_rd_2 == voodoo->cmdfifo_depth_wr_2) && !voodoo_render_threads_busy(voodoo);
+}
+
+/* Linear frame buffer writes that bypass the pixel pipeline only depend on the
+   LFB state, so when the card is idle they can go straight to the frame buffer
+   instead of through the FIFO thread. Pipelined writes still get queued, and the
+   FIFO thread handles runs of them after a single wait for the render threads. */
+void
+voodoo_queue_fb_write(voodoo_t *voodoo, uint32_t addr_type, uint32_t val)
+{
+    if (!(voodoo->lfbMode & 0x100) && (voodoo->capture_fp == NULL) && voodoo_fifo_idle(voodoo)) {
+        if ((addr_type & FIFO_TYPE) == FIFO_WRITEW_FB)
+            voodoo_fb_writew(addr_type & FIFO_ADDR, val, voodoo);
+        else
+            voodoo_fb_writel(addr_type & FIFO_ADDR, val, voodoo);
+        return;
+    }
+
+    voodoo_queue_command(voodoo, addr_type, val);
+}
+
 void
 voodoo_flush(voodoo_t *voodoo)
 {
@@ -177,6 +303,8 @@ cmdfifo_get(voodoo_t *voodoo)
         voodoo->cmdfifo_depth_rd++;
     voodoo->cmdfifo_rp += 4;
 
+    voodoo_capture_write(voodoo, VOODOO_CAPTURE_CMDFIFO, val);
+
     //        voodoo_fifo_log("  CMDFIFO get %08x\n", val);
     return val;
 }
@@ -214,6 +342,8 @@ cmdfifo_get_2(voodoo_t *voodoo)
         voodoo->cmdfifo_depth_rd_2++;
     voodoo->cmdfifo_rp_2 += 4;
 
+    voodoo_capture_write(voodoo, VOODOO_CAPTURE_CMDFIFO_2, val);
+
     //        voodoo_fifo_log("  CMDFIFO get %08x\n", val);
     return val;
 }
@@ -253,6 +383,7 @@ voodoo_fifo_thread(void *param)
         thread_wait_event(voodoo->wake_fifo_thread, -1);
         thread_reset_event(voodoo->wake_fifo_thread);
         voodoo->voodoo_busy = 1;
+        MTR_BEGIN("video", "voodoo_fifo_thread");
         while (!FIFO_EMPTY) {
             uint64_t      start_time = plat_timer_read();
             uint64_t      end_time;
@@ -261,6 +392,7 @@ voodoo_fifo_thread(void *param)
             switch (fifo->addr_type & FIFO_TYPE) {
                 case FIFO_WRITEL_REG:
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_REG) {
+                        voodoo_capture_write(voodoo, fifo->addr_type, fifo->val);
                         voodoo_reg_writel(fifo->addr_type & FIFO_ADDR, fifo->val, voodoo);
                         fifo->addr_type = FIFO_INVALID;
                         voodoo->fifo_read_idx++;
@@ -272,6 +404,7 @@ voodoo_fifo_thread(void *param)
                 case FIFO_WRITEW_FB:
                     voodoo_wait_for_render_thread_idle(voodoo);
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEW_FB) {
+                        voodoo_capture_write(voodoo, fifo->addr_type, fifo->val);
                         voodoo_fb_writew(fifo->addr_type & FIFO_ADDR, fifo->val, voodoo);
                         fifo->addr_type = FIFO_INVALID;
                         voodoo->fifo_read_idx++;
@@ -283,6 +416,7 @@ voodoo_fifo_thread(void *param)
                 case FIFO_WRITEL_FB:
                     voodoo_wait_for_render_thread_idle(voodoo);
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_FB) {
+                        voodoo_capture_write(voodoo, fifo->addr_type, fifo->val);
                         voodoo_fb_writel(fifo->addr_type & FIFO_ADDR, fifo->val, voodoo);
                         fifo->addr_type = FIFO_INVALID;
                         voodoo->fifo_read_idx++;
@@ -293,6 +427,7 @@ voodoo_fifo_thread(void *param)
                     break;
                 case FIFO_WRITEL_TEX:
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_TEX) {
+                        voodoo_capture_write(voodoo, fifo->addr_type, fifo->val);
                         if (!(fifo->addr_type & 0x400000))
                             voodoo_tex_writel(fifo->addr_type & FIFO_ADDR, fifo->val, voodoo);
                         fifo->addr_type = FIFO_INVALID;
@@ -304,6 +439,7 @@ voodoo_fifo_thread(void *param)
                     break;
                 case FIFO_WRITEL_2DREG:
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_2DREG) {
+                        voodoo_capture_write(voodoo, fifo->addr_type, fifo->val);
                         voodoo_2d_reg_writel(voodoo, fifo->addr_type & FIFO_ADDR, fifo->val);
                         fifo->addr_type = FIFO_INVALID;
                         voodoo->fifo_read_idx++;
@@ -908,7 +1044,14 @@ voodoo_fifo_thread(void *param)
             end_time = plat_timer_read();
             voodoo->time += end_time - start_time;
         }
+        MTR_END("video", "voodoo_fifo_thread");
 
         voodoo->voodoo_busy = 0;
+
+        /*Wake-ups are skipped while busy, so pick up anything queued since
+          the last check now that the CPU thread can see us going idle.*/
+        atomic_thread_fence(memory_order_seq_cst);
+        if (voodoo_fifo_pending(voodoo))
+            thread_set_event(voodoo->wake_fifo_thread);
     }
 }
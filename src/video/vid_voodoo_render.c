@@ -38,6 +38,8 @@
 #include <86box/vid_voodoo_render.h>
 #include <86box/vid_voodoo_texture.h>
 
+#include <minitrace/minitrace.h>
+
 typedef struct voodoo_state_t {
     int      xstart, xend, xdir;
     uint32_t base_r, base_g, base_b, base_a, base_z;
@@ -694,12 +696,30 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
 #endif
     int y_diff   = SLI_ENABLED ? 2 : 1;
     int y_origin = (voodoo->type >= VOODOO_BANSHEE) ? voodoo->y_origin_swap : (voodoo->v_disp - 1);
+    /* The dither tables only depend on fbzMode, so pick them once per
+       triangle. Both layouts are [value][y][x], flattened to
+       (value << dither_shift) + (y << (dither_shift / 2)) + x. */
+    const uint8_t *dither_rb_tab    = NULL;
+    const uint8_t *dither_g_tab     = NULL;
+    const uint8_t *dithersub_rb_tab = NULL;
+    const uint8_t *dithersub_g_tab  = NULL;
+    int            dither_shift     = dither2x2 ? 2 : 4;
+    int            dither_mask      = dither2x2 ? 1 : 3;
 
     if ((params->textureMode[0] & TEXTUREMODE_MASK) == TEXTUREMODE_PASSTHROUGH || (params->textureMode[0] & TEXTUREMODE_LOCAL_MASK) == TEXTUREMODE_LOCAL)
         texels = 1;
     else
         texels = 2;
 
+    if (dither) {
+        dither_rb_tab = dither2x2 ? &dither_rb2x2[0][0][0] : &dither_rb[0][0][0];
+        dither_g_tab  = dither2x2 ? &dither_g2x2[0][0][0] : &dither_g[0][0][0];
+    }
+    if (dithersub && voodoo->dithersub_enabled) {
+        dithersub_rb_tab = dither2x2 ? &dithersub_rb2x2[0][0][0] : &dithersub_rb[0][0][0];
+        dithersub_g_tab  = dither2x2 ? &dithersub_g2x2[0][0][0] : &dithersub_g[0][0][0];
+    }
+
     state->clamp_s[0] = params->textureMode[0] & TEXTUREMODE_TCLAMPS;
     state->clamp_t[0] = params->textureMode[0] & TEXTUREMODE_TCLAMPT;
     state->clamp_s[1] = params->textureMode[1] & TEXTUREMODE_TCLAMPS;
@@ -940,9 +960,10 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
                 int x_tiled = (x & 63) | ((x >> 6) * 128 * 32 / 2);
                 start_x     = x;
                 state->x    = x;
-                voodoo->pixel_count[odd_even]++;
-                voodoo->texel_count[odd_even] += texels;
-                voodoo->fbiPixelsIn++;
+                /* Count in the per-thread state like the recompiled spans do,
+                   the totals are added to the shared counters once per line. */
+                state->pixel_count++;
+                state->texel_count += texels;
 
                 voodoo_render_log("  X=%03i T=%08x\n", x, state->tmu0_t);
 #if 0
@@ -1272,30 +1293,23 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
                         ALPHA_TEST(src_a);
 
                     if (params->alphaMode & (1 << 4)) {
-                        if (dithersub && !dither2x2 && voodoo->dithersub_enabled) {
-                            dest_r = dithersub_rb[dest_r][real_y & 3][x & 3];
-                            dest_g = dithersub_g[dest_g][real_y & 3][x & 3];
-                            dest_b = dithersub_rb[dest_b][real_y & 3][x & 3];
-                        }
-                        if (dithersub && dither2x2 && voodoo->dithersub_enabled) {
-                            dest_r = dithersub_rb2x2[dest_r][real_y & 1][x & 1];
-                            dest_g = dithersub_g2x2[dest_g][real_y & 1][x & 1];
-                            dest_b = dithersub_rb2x2[dest_b][real_y & 1][x & 1];
+                        if (dithersub_rb_tab) {
+                            int dither_off = ((real_y & dither_mask) << (dither_shift >> 1)) + (x & dither_mask);
+
+                            dest_r = dithersub_rb_tab[(dest_r << dither_shift) + dither_off];
+                            dest_g = dithersub_g_tab[(dest_g << dither_shift) + dither_off];
+                            dest_b = dithersub_rb_tab[(dest_b << dither_shift) + dither_off];
                         }
                         ALPHA_BLEND(src_r, src_g, src_b, src_a);
                     }
 
                     if (update) {
-                        if (dither) {
-                            if (dither2x2) {
-                                src_r = dither_rb2x2[src_r][real_y & 1][x & 1];
-                                src_g = dither_g2x2[src_g][real_y & 1][x & 1];
-                                src_b = dither_rb2x2[src_b][real_y & 1][x & 1];
-                            } else {
-                                src_r = dither_rb[src_r][real_y & 3][x & 3];
-                                src_g = dither_g[src_g][real_y & 3][x & 3];
-                                src_b = dither_rb[src_b][real_y & 3][x & 3];
-                            }
+                        if (dither_rb_tab) {
+                            int dither_off = ((real_y & dither_mask) << (dither_shift >> 1)) + (x & dither_mask);
+
+                            src_r = dither_rb_tab[(src_r << dither_shift) + dither_off];
+                            src_g = dither_g_tab[(src_g << dither_shift) + dither_off];
+                            src_b = dither_rb_tab[(src_b << dither_shift) + dither_off];
                         } else {
                             src_r >>= 3;
                             src_g >>= 2;
@@ -1555,6 +1569,7 @@ render_thread(void *param, int odd_even)
         thread_reset_event(voodoo->wake_render_thread[odd_even]);
         voodoo->render_voodoo_busy[odd_even] = 1;
 
+        MTR_BEGIN_I("video", "voodoo_render_thread", "thread", odd_even);
         while (!PARAM_EMPTY(odd_even)) {
             uint64_t         start_time = plat_timer_read();
             uint64_t         end_time;
@@ -1570,6 +1585,7 @@ render_thread(void *param, int odd_even)
             end_time = plat_timer_read();
             voodoo->render_time[odd_even] += end_time - start_time;
         }
+        MTR_END("video", "voodoo_render_thread");
 
         voodoo->render_voodoo_busy[odd_even] = 0;
     }
@@ -1595,28 +1611,65 @@ voodoo_render_thread_4(void *param)
 {
     render_thread(param, 3);
 }
+void
+voodoo_render_thread_5(void *param)
+{
+    render_thread(param, 4);
+}
+void
+voodoo_render_thread_6(void *param)
+{
+    render_thread(param, 5);
+}
+void
+voodoo_render_thread_7(void *param)
+{
+    render_thread(param, 6);
+}
+void
+voodoo_render_thread_8(void *param)
+{
+    render_thread(param, 7);
+}
+
+void (*const voodoo_render_thread_func[VOODOO_MAX_RENDER_THREADS])(void *param) = {
+    voodoo_render_thread_1, voodoo_render_thread_2, voodoo_render_thread_3, voodoo_render_thread_4,
+    voodoo_render_thread_5, voodoo_render_thread_6, voodoo_render_thread_7, voodoo_render_thread_8
+};
+
+static int
+voodoo_render_params_full(voodoo_t *voodoo)
+{
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (PARAM_FULL(c))
+            return 1;
+    }
 
+    return 0;
+}
+
+/*
+ * Every triangle is rasterized here, in software, into fb_mem. That is the
+ * only place the frame exists: LFB reads, LFB writes, screen-to-screen
+ * blits, SLI and the display code all work on fb_mem directly and can run
+ * between any two triangles. A host GPU backend would therefore have to
+ * read back after almost every frame on real workloads, and it could not
+ * replicate the dithering, fog table, W-buffer and 16-bit framebuffer
+ * rounding that software relies on. Triangles are queued to the render
+ * threads instead, and rendering is scaled with more threads.
+ */
 void
 voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 {
     voodoo_params_t *params_new = &voodoo->params_buffer[voodoo->params_write_idx & PARAM_MASK];
 
-    while (PARAM_FULL(0) || (voodoo->render_threads >= 2 && PARAM_FULL(1)) || (voodoo->render_threads == 4 && (PARAM_FULL(2) || PARAM_FULL(3)))) {
-        thread_reset_event(voodoo->render_not_full_event[0]);
-        if (voodoo->render_threads >= 2)
-            thread_reset_event(voodoo->render_not_full_event[1]);
-        if (voodoo->render_threads == 4) {
-            thread_reset_event(voodoo->render_not_full_event[2]);
-            thread_reset_event(voodoo->render_not_full_event[3]);
+    while (voodoo_render_params_full(voodoo)) {
+        for (int c = 0; c < voodoo->render_threads; c++)
+            thread_reset_event(voodoo->render_not_full_event[c]);
+        for (int c = 0; c < voodoo->render_threads; c++) {
+            if (PARAM_FULL(c))
+                thread_wait_event(voodoo->render_not_full_event[c], -1); /*Wait for room in ringbuffer*/
         }
-        if (PARAM_FULL(0))
-            thread_wait_event(voodoo->render_not_full_event[0], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads >= 2 && PARAM_FULL(1))
-            thread_wait_event(voodoo->render_not_full_event[1], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(2))
-            thread_wait_event(voodoo->render_not_full_event[2], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(3))
-            thread_wait_event(voodoo->render_not_full_event[3], -1); /*Wait for room in ringbuffer*/
     }
 
     voodoo_use_texture(voodoo, params, 0);
@@ -1627,6 +1680,10 @@ voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 
     voodoo->params_write_idx++;
 
-    if (PARAM_ENTRIES(0) < 4 || (voodoo->render_threads >= 2 && PARAM_ENTRIES(1) < 4) || (voodoo->render_threads == 4 && (PARAM_ENTRIES(2) < 4 || PARAM_ENTRIES(3) < 4)))
-        voodoo_wake_render_thread(voodoo);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (PARAM_ENTRIES(c) < 4) {
+            voodoo_wake_render_thread(voodoo);
+            break;
+        }
+    }
 }
@@ -237,6 +237,39 @@ voodoo_recalc_tex3(voodoo_t *voodoo, int tmu)
 
 #define makergba(r, g, b, a) ((b) | ((g) << 8) | ((r) << 16) | ((a) << 24))
 
+/* The conversion tables and palettes are stored in makergba() byte order,
+   so a texel can be fetched as one 32-bit word instead of four bytes. */
+#define tex_rgba(t)          (*(const uint32_t *) &(t))
+
+/* A texture is in use until every render thread has drawn all the
+   triangles that referenced it. */
+static int
+voodoo_texture_in_use(voodoo_t *voodoo, texture_t *texture)
+{
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (texture->refcount != texture->refcount_r[c])
+            return 1;
+    }
+
+    return 0;
+}
+
+/* texture_present[] counts the cached textures covering each page, so an
+   entry can be added or evicted without rebuilding the whole map. */
+static void
+voodoo_texture_mark_pages(voodoo_t *voodoo, int tmu, texture_t *texture, int delta)
+{
+    for (uint8_t d = 0; d < 4; d++) {
+        uint32_t addr     = texture->addr_start[d];
+        uint32_t addr_end = texture->addr_end[d];
+
+        if (addr_end != 0) {
+            for (; addr <= addr_end; addr += (1 << TEX_DIRTY_SHIFT))
+                voodoo->texture_present[tmu][(addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] += delta;
+        }
+    }
+}
+
 void
 voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 {
@@ -244,7 +277,6 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     int      lod_min;
     int      lod_max;
     uint32_t addr = 0;
-    uint32_t addr_end;
     uint32_t palette_checksum;
 
     lod_min = (params->tLOD[tmu] >> 2) & 15;
@@ -283,7 +315,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
         for (c = 0; c < TEX_CACHE_MAX; c++) {
             voodoo->texture_last_removed++;
             voodoo->texture_last_removed &= (TEX_CACHE_MAX - 1);
-            if (voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[0] && (voodoo->render_threads == 1 || voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[1]))
+            if (!voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][voodoo->texture_last_removed]))
                 break;
         }
         if (c == TEX_CACHE_MAX)
@@ -294,6 +326,9 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 
     c = voodoo->texture_last_removed;
 
+    if (voodoo->texture_cache[tmu][c].base != -1)
+        voodoo_texture_mark_pages(voodoo, tmu, &voodoo->texture_cache[tmu][c], -1);
+
     if ((voodoo->params.tLOD[tmu] & LOD_SPLIT) && (voodoo->params.tLOD[tmu] & LOD_ODD) && (voodoo->params.tLOD[tmu] & LOD_TMULTIBASEADDR))
         voodoo->texture_cache[tmu][c].base = params->texBaseAddr1[tmu];
     else
@@ -325,7 +360,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint8_t dat = voodoo->tex_mem[tmu][(tex_addr + x) & voodoo->texture_mask];
 
-                        base[x] = makergba(rgb332[dat].r, rgb332[dat].g, rgb332[dat].b, 0xff);
+                        base[x] = tex_rgba(rgb332[dat]) | 0xff000000;
                     }
                     tex_addr += (1 << voodoo->params.tex_shift[tmu][lod]);
                     base += (1 << shift);
@@ -338,7 +373,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint8_t dat = voodoo->tex_mem[tmu][(tex_addr + x) & voodoo->texture_mask];
 
-                        base[x] = makergba(pal[dat].rgba.r, pal[dat].rgba.g, pal[dat].rgba.b, 0xff);
+                        base[x] = pal[dat].u | 0xff000000;
                     }
                     tex_addr += (1 << voodoo->params.tex_shift[tmu][lod]);
                     base += (1 << shift);
@@ -387,7 +422,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint8_t dat = voodoo->tex_mem[tmu][(tex_addr + x) & voodoo->texture_mask];
 
-                        base[x] = makergba(pal[dat].rgba.r, pal[dat].rgba.g, pal[dat].rgba.b, 0xff);
+                        base[x] = pal[dat].u | 0xff000000;
                     }
                     tex_addr += (1 << voodoo->params.tex_shift[tmu][lod]);
                     base += (1 << shift);
@@ -417,7 +452,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint16_t dat = *(uint16_t *) &voodoo->tex_mem[tmu][(tex_addr + x * 2) & voodoo->texture_mask];
 
-                        base[x] = makergba(rgb332[dat & 0xff].r, rgb332[dat & 0xff].g, rgb332[dat & 0xff].b, dat >> 8);
+                        base[x] = (tex_rgba(rgb332[dat & 0xff]) & 0x00ffffff) | ((uint32_t) (dat >> 8) << 24);
                     }
                     tex_addr += (1 << (voodoo->params.tex_shift[tmu][lod] + 1));
                     base += (1 << shift);
@@ -430,7 +465,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint16_t dat = *(uint16_t *) &voodoo->tex_mem[tmu][(tex_addr + x * 2) & voodoo->texture_mask];
 
-                        base[x] = makergba(pal[dat & 0xff].rgba.r, pal[dat & 0xff].rgba.g, pal[dat & 0xff].rgba.b, dat >> 8);
+                        base[x] = (pal[dat & 0xff].u & 0x00ffffff) | ((uint32_t) (dat >> 8) << 24);
                     }
                     tex_addr += (1 << (voodoo->params.tex_shift[tmu][lod] + 1));
                     base += (1 << shift);
@@ -442,7 +477,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint16_t dat = *(uint16_t *) &voodoo->tex_mem[tmu][(tex_addr + x * 2) & voodoo->texture_mask];
 
-                        base[x] = makergba(rgb565[dat].r, rgb565[dat].g, rgb565[dat].b, 0xff);
+                        base[x] = tex_rgba(rgb565[dat]) | 0xff000000;
                     }
                     tex_addr += (1 << (voodoo->params.tex_shift[tmu][lod] + 1));
                     base += (1 << shift);
@@ -454,7 +489,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint16_t dat = *(uint16_t *) &voodoo->tex_mem[tmu][(tex_addr + x * 2) & voodoo->texture_mask];
 
-                        base[x] = makergba(argb1555[dat].r, argb1555[dat].g, argb1555[dat].b, argb1555[dat].a);
+                        base[x] = tex_rgba(argb1555[dat]);
                     }
                     tex_addr += (1 << (voodoo->params.tex_shift[tmu][lod] + 1));
                     base += (1 << shift);
@@ -466,7 +501,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint16_t dat = *(uint16_t *) &voodoo->tex_mem[tmu][(tex_addr + x * 2) & voodoo->texture_mask];
 
-                        base[x] = makergba(argb4444[dat].r, argb4444[dat].g, argb4444[dat].b, argb4444[dat].a);
+                        base[x] = tex_rgba(argb4444[dat]);
                     }
                     tex_addr += (1 << (voodoo->params.tex_shift[tmu][lod] + 1));
                     base += (1 << shift);
@@ -491,7 +526,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                     for (x = 0; x < voodoo->params.tex_w_mask[tmu][lod] + 1; x++) {
                         uint16_t dat = *(uint16_t *) &voodoo->tex_mem[tmu][(tex_addr + x * 2) & voodoo->texture_mask];
 
-                        base[x] = makergba(pal[dat & 0xff].rgba.r, pal[dat & 0xff].rgba.g, pal[dat & 0xff].rgba.b, dat >> 8);
+                        base[x] = (pal[dat & 0xff].u & 0x00ffffff) | ((uint32_t) (dat >> 8) << 24);
                     }
                     tex_addr += (1 << (voodoo->params.tex_shift[tmu][lod] + 1));
                     base += (1 << shift);
@@ -534,15 +569,7 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     } else
         voodoo->texture_cache[tmu][c].addr_start[3] = voodoo->texture_cache[tmu][c].addr_end[3] = 0;
 
-    for (uint8_t d = 0; d < 4; d++) {
-        addr     = voodoo->texture_cache[tmu][c].addr_start[d];
-        addr_end = voodoo->texture_cache[tmu][c].addr_end[d];
-
-        if (addr_end != 0) {
-            for (; addr <= addr_end; addr += (1 << TEX_DIRTY_SHIFT))
-                voodoo->texture_present[tmu][(addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-        }
-    }
+    voodoo_texture_mark_pages(voodoo, tmu, &voodoo->texture_cache[tmu][c], 1);
 
     params->tex_entry[tmu] = c;
     voodoo->texture_cache[tmu][c].refcount++;
@@ -553,35 +580,37 @@ flush_texture_cache(voodoo_t *voodoo, uint32_t dirty_addr, int tmu)
 {
     int wait_for_idle = 0;
 
-    memset(voodoo->texture_present[tmu], 0, sizeof(voodoo->texture_present[0]));
 #if 0
-    voodoo_texture_log("Evict %08x %i\n", dirty_addr, sizeof(voodoo->texture_present));
+    voodoo_texture_log("Evict %08x\n", dirty_addr);
 #endif
     for (uint8_t c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->texture_cache[tmu][c].base != -1) {
-            for (uint8_t d = 0; d < 4; d++) {
-                int addr_start = voodoo->texture_cache[tmu][c].addr_start[d];
-                int addr_end   = voodoo->texture_cache[tmu][c].addr_end[d];
-
-                if (addr_end != 0) {
-                    int addr_start_masked = addr_start & voodoo->texture_mask & ~0x3ff;
-                    int addr_end_masked   = ((addr_end & voodoo->texture_mask) + 0x3ff) & ~0x3ff;
-
-                    if (addr_end_masked < addr_start_masked)
-                        addr_end_masked = voodoo->texture_mask + 1;
-                    if (dirty_addr >= addr_start_masked && dirty_addr < addr_end_masked) {
+        texture_t *texture = &voodoo->texture_cache[tmu][c];
+
+        if (texture->base == -1)
+            continue;
+
+        for (uint8_t d = 0; d < 4; d++) {
+            int addr_start = texture->addr_start[d];
+            int addr_end   = texture->addr_end[d];
+
+            if (addr_end != 0) {
+                int addr_start_masked = addr_start & voodoo->texture_mask & ~0x3ff;
+                int addr_end_masked   = ((addr_end & voodoo->texture_mask) + 0x3ff) & ~0x3ff;
+
+                if (addr_end_masked < addr_start_masked)
+                    addr_end_masked = voodoo->texture_mask + 1;
+                if (dirty_addr >= addr_start_masked && dirty_addr < addr_end_masked) {
 #if 0
-                        voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
+                    voodoo_texture_log("  Evict texture %i %08x\n", c, texture->base);
 #endif
 
-                        if (voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[0] || (voodoo->render_threads == 2 && voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[1]))
-                            wait_for_idle = 1;
+                    if (voodoo_texture_in_use(voodoo, texture))
+                        wait_for_idle = 1;
 
-                        voodoo->texture_cache[tmu][c].base = -1;
-                    } else {
-                        for (; addr_start <= addr_end; addr_start += (1 << TEX_DIRTY_SHIFT))
-                            voodoo->texture_present[tmu][(addr_start & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-                    }
+                    /* Only the evicted entry's pages need updating. */
+                    voodoo_texture_mark_pages(voodoo, tmu, texture, -1);
+                    texture->base = -1;
+                    break;
                 }
             }
         }
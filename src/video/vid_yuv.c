@@ -0,0 +1,118 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          YCbCr to RGB conversion for the video overlays.
+ *
+ *          Lines are converted in one go, four pixel pairs at a time
+ *          on SSE2 hosts, with the same fixed point maths and rounding
+ *          as the per-pixel code it replaces.
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define VIDEO_YUV_SSE2
+#endif
+#include <86box/86box.h>
+#include <86box/video.h>
+
+#define CLAMP(x)                      \
+    do {                              \
+        if ((x) & ~0xff)              \
+            x = ((x) < 0) ? 0 : 0xff; \
+    } while (0)
+
+/* Convert pairs of 4:2:2 pixels to 0x00BBGGRR, in the given byte order. */
+void
+video_yuv422_to_rgb(uint32_t *dst, const uint8_t *src, int pairs, int order)
+{
+    int y0_pos = (order == VIDEO_YUV422_YCRYCB) ? 0 : 1;
+    int cr_pos = (order == VIDEO_YUV422_YCRYCB) ? 1 : 0;
+    int c      = 0;
+
+#ifdef VIDEO_YUV_SSE2
+    const __m128i bytes = _mm_set1_epi32(0x000000ff);
+    const __m128i words = _mm_set1_epi32(0x00ff00ff);
+    const __m128i bias  = _mm_set1_epi16(0x80);
+    const __m128i k_r   = _mm_set1_epi32(359);               /* Cr * 359 */
+    const __m128i k_g   = _mm_set1_epi32((88 << 16) | 183);  /* Cb * 88 + Cr * 183 */
+    const __m128i k_b   = _mm_set1_epi32(453 << 16);         /* Cb * 453 */
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i max   = _mm_set1_epi16(0xff);
+
+    for (; (c + 4) <= pairs; c += 4) {
+        __m128i in = _mm_loadu_si128((const __m128i *) &src[c << 2]);
+        __m128i y0;
+        __m128i y1;
+        __m128i ch;
+        __m128i r;
+        __m128i g;
+        __m128i b;
+
+        /* One pair per 32-bit lane, split into Y0, Y1 and the Cr/Cb words. */
+        if (order == VIDEO_YUV422_YCRYCB) {
+            y0 = _mm_and_si128(in, bytes);
+            y1 = _mm_and_si128(_mm_srli_epi32(in, 16), bytes);
+            ch = _mm_and_si128(_mm_srli_epi32(in, 8), words);
+        } else {
+            y0 = _mm_and_si128(_mm_srli_epi32(in, 8), bytes);
+            y1 = _mm_srli_epi32(in, 24);
+            ch = _mm_and_si128(in, words);
+        }
+        ch = _mm_sub_epi16(ch, bias);
+
+        r = _mm_srai_epi32(_mm_madd_epi16(ch, k_r), 8);
+        g = _mm_srai_epi32(_mm_madd_epi16(ch, k_g), 8);
+        b = _mm_srai_epi32(_mm_madd_epi16(ch, k_b), 8);
+
+        /* Back to pixel order, as 16-bit values clamped to 0-255. */
+#    define YUV_CHANNEL(out, y_op, d)                                                    \
+        do {                                                                             \
+            __m128i p0 = y_op(y0, d);                                                    \
+            __m128i p1 = y_op(y1, d);                                                    \
+                                                                                         \
+            out = _mm_packs_epi32(_mm_unpacklo_epi32(p0, p1), _mm_unpackhi_epi32(p0, p1)); \
+            out = _mm_min_epi16(_mm_max_epi16(out, zero), max);                          \
+        } while (0)
+
+        YUV_CHANNEL(r, _mm_add_epi32, r);
+        YUV_CHANNEL(g, _mm_sub_epi32, g);
+        YUV_CHANNEL(b, _mm_add_epi32, b);
+#    undef YUV_CHANNEL
+
+        r = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        _mm_storeu_si128((__m128i *) &dst[c << 1], _mm_unpacklo_epi16(r, b));
+        _mm_storeu_si128((__m128i *) &dst[(c << 1) + 4], _mm_unpackhi_epi16(r, b));
+    }
+#endif
+
+    for (; c < pairs; c++) {
+        const uint8_t *pair = &src[c << 2];
+        int8_t         Cr   = pair[cr_pos] - 0x80;
+        int8_t         Cb   = pair[cr_pos + 2] - 0x80;
+        int            dR   = (359 * Cr) >> 8;
+        int            dG   = (88 * Cb + 183 * Cr) >> 8;
+        int            dB   = (453 * Cb) >> 8;
+
+        for (int i = 0; i < 2; i++) {
+            int y = pair[y0_pos + (i << 1)];
+            int r = y + dR;
+            int g = y - dG;
+            int b = y + dB;
+
+            CLAMP(r);
+            CLAMP(g);
+            CLAMP(b);
+            dst[(c << 1) + i] = r | (g << 8) | (b << 16);
+        }
+    }
+}
@@ -69,14 +69,17 @@
 #include <86box/plat.h>
 #include <86box/ui.h>
 #include <86box/thread.h>
+#include <86box/device_worker.h>
 #include <86box/video.h>
 #include <86box/vid_svga.h>
+#include <86box/record.h>
 
 #include <minitrace/minitrace.h>
 
 volatile int screenshots = 0;
 uint8_t      edatlookup[4][4];
 uint8_t      egaremap2bpp[256];
+uint32_t     egaplanarlookup[4][256];
 uint8_t      fontdat[2048][8];            /* IBM CGA font */
 uint8_t      fontdatm[2048][16];          /* IBM MDA font */
 uint8_t      fontdat2[2048][8];           /* IBM CGA 2nd instance font */
@@ -234,7 +237,11 @@ const uint32_t shade[5][256] = {
 
 typedef struct blit_data_struct {
     int x, y, w, h;
+    int dirty_y1, dirty_y2;
+    int dropped;
     int busy;
+    uint32_t frames_dropped;
+    uint32_t frames_blocked;
     int buffer_in_use;
     int thread_run;
     int monitor_index;
@@ -297,95 +304,205 @@ video_wait_for_buffer_monitor(int monitor_index)
 {
     blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
 
+    if (blit_data_ptr->buffer_in_use)
+        blit_data_ptr->frames_blocked++;
+
     while (blit_data_ptr->buffer_in_use)
         thread_wait_event(blit_data_ptr->buffer_not_in_use, -1);
     thread_reset_event(blit_data_ptr->buffer_not_in_use);
 }
 
-static png_structp png_ptr[MONITORS_NUM];
-static png_infop   info_ptr[MONITORS_NUM];
+/* Return and clear the number of frames dropped because the blit thread
+   was still busy, and of frames where the emulation had to wait for the
+   renderer to release the target buffer. */
+void
+video_get_blit_stats_monitor(int monitor_index, uint32_t *dropped, uint32_t *blocked)
+{
+    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    *dropped = blit_data_ptr->frames_dropped;
+    *blocked = blit_data_ptr->frames_blocked;
 
-static void
-video_take_screenshot_monitor(const char *fn, uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index)
+    blit_data_ptr->frames_dropped = 0;
+    blit_data_ptr->frames_blocked = 0;
+}
+
+/* Screenshots are copied out of the caller's buffer and encoded on a
+   worker, so the blit or render thread taking one does not stall on the
+   compression and the disk. */
+#define SCREENSHOT_JOBS 8
+
+typedef struct screenshot_job_t {
+    atomic_int busy;
+    char       path[1024];
+    uint32_t  *buf;
+    int        w;
+    int        h;
+    int        monitor_index;
+} screenshot_job_t;
+
+static screenshot_job_t screenshot_jobs[SCREENSHOT_JOBS];
+static uint32_t         screenshot_job_next;
+static device_worker_t *screenshot_worker;
+static mutex_t         *screenshot_mutex;
+
+/* Called on the screenshot worker once a screenshot has been written (ok
+   set) or has failed. */
+void (*video_screenshot_callback)(const char *fn, int monitor_index, int ok) = NULL;
+
+static int
+video_write_png(const char *fn, const uint32_t *buf, int w, int h)
 {
-    png_bytep         *b_rgb         = NULL;
-    FILE              *fp            = NULL;
-    uint32_t           temp          = 0x00000000;
-    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    png_structp png_ptr;
+    png_infop   info_ptr;
+    png_bytep   row;
+    FILE       *fp;
 
     /* create file */
     fp = plat_fopen(fn, (const char *) "wb");
     if (!fp) {
-        video_log("[video_take_screenshot] File %s could not be opened for writing", fn);
-        return;
+        video_log("[video_write_png] File %s could not be opened for writing", fn);
+        return 0;
     }
 
     /* initialize stuff */
-    png_ptr[monitor_index] = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-
-    if (!png_ptr[monitor_index]) {
-        video_log("[video_take_screenshot] png_create_write_struct failed");
+    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png_ptr) {
+        video_log("[video_write_png] png_create_write_struct failed");
         fclose(fp);
-        return;
+        return 0;
     }
 
-    info_ptr[monitor_index] = png_create_info_struct(png_ptr[monitor_index]);
-    if (!info_ptr[monitor_index]) {
-        video_log("[video_take_screenshot] png_create_info_struct failed");
+    info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr) {
+        video_log("[video_write_png] png_create_info_struct failed");
+        png_destroy_write_struct(&png_ptr, NULL);
         fclose(fp);
-        return;
+        return 0;
     }
 
-    png_init_io(png_ptr[monitor_index], fp);
+    png_init_io(png_ptr, fp);
 
-    png_set_IHDR(png_ptr[monitor_index], info_ptr[monitor_index], blit_data_ptr->w, blit_data_ptr->h,
+    png_set_IHDR(png_ptr, info_ptr, w, h,
                  8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
                  PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
 
-    b_rgb = (png_bytep *) malloc(sizeof(png_bytep) * blit_data_ptr->h);
-    if (b_rgb == NULL) {
-        video_log("[video_take_screenshot] Unable to Allocate RGB Bitmap Memory");
+    row = (png_bytep) malloc((size_t) w * 3);
+    if (row == NULL) {
+        video_log("[video_write_png] Unable to Allocate RGB Bitmap Memory");
+        png_destroy_write_struct(&png_ptr, &info_ptr);
         fclose(fp);
-        return;
+        return 0;
     }
 
-    for (int y = 0; y < blit_data_ptr->h; ++y) {
-        b_rgb[y] = (png_byte *) malloc(png_get_rowbytes(png_ptr[monitor_index], info_ptr[monitor_index]));
-        for (int x = 0; x < blit_data_ptr->w; ++x) {
-            if (buf == NULL)
-                memset(&(b_rgb[y][x * 3]), 0x00, 3);
-            else {
-                temp                  = buf[((start_y + y) * row_len) + start_x + x];
-                b_rgb[y][x * 3]       = (temp >> 16) & 0xff;
-                b_rgb[y][(x * 3) + 1] = (temp >> 8) & 0xff;
-                b_rgb[y][(x * 3) + 2] = temp & 0xff;
-            }
+    png_write_info(png_ptr, info_ptr);
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            uint32_t temp = buf[(y * w) + x];
+
+            row[x * 3]       = (temp >> 16) & 0xff;
+            row[(x * 3) + 1] = (temp >> 8) & 0xff;
+            row[(x * 3) + 2] = temp & 0xff;
         }
+        png_write_row(png_ptr, row);
     }
 
-    png_write_info(png_ptr[monitor_index], info_ptr[monitor_index]);
+    png_write_end(png_ptr, NULL);
 
-    png_write_image(png_ptr[monitor_index], b_rgb);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    free(row);
+    fclose(fp);
 
-    png_write_end(png_ptr[monitor_index], NULL);
+    return 1;
+}
 
-    /* cleanup heap allocation */
-    for (int i = 0; i < blit_data_ptr->h; i++)
-        if (b_rgb[i])
-            free(b_rgb[i]);
+static void
+video_put_le(uint8_t *p, uint32_t val, int size)
+{
+    for (int i = 0; i < size; i++)
+        p[i] = (val >> (i << 3)) & 0xff;
+}
 
-    if (b_rgb)
-        free(b_rgb);
+/* Uncompressed 24-bit BMP, for when encoding speed matters more than size. */
+static int
+video_write_bmp(const char *fn, const uint32_t *buf, int w, int h)
+{
+    uint8_t  hdr[54] = { 'B', 'M' };
+    uint32_t stride  = ((w * 3) + 3) & ~3;
+    uint8_t *row;
+    FILE    *fp;
 
-    if (fp)
+    fp = plat_fopen(fn, (const char *) "wb");
+    if (!fp) {
+        video_log("[video_write_bmp] File %s could not be opened for writing", fn);
+        return 0;
+    }
+
+    row = (uint8_t *) calloc(1, stride);
+    if (row == NULL) {
         fclose(fp);
+        return 0;
+    }
+
+    video_put_le(&hdr[2], sizeof(hdr) + (stride * h), 4);
+    video_put_le(&hdr[10], sizeof(hdr), 4);
+    video_put_le(&hdr[14], 40, 4);
+    video_put_le(&hdr[18], w, 4);
+    video_put_le(&hdr[22], h, 4);
+    video_put_le(&hdr[26], 1, 2);
+    video_put_le(&hdr[28], 24, 2);
+    video_put_le(&hdr[34], stride * h, 4);
+    fwrite(hdr, 1, sizeof(hdr), fp);
+
+    /* BMP rows are stored bottom-up, in B, G, R order. */
+    for (int y = h - 1; y >= 0; y--) {
+        for (int x = 0; x < w; ++x) {
+            uint32_t temp = buf[(y * w) + x];
+
+            row[x * 3]       = temp & 0xff;
+            row[(x * 3) + 1] = (temp >> 8) & 0xff;
+            row[(x * 3) + 2] = (temp >> 16) & 0xff;
+        }
+        fwrite(row, 1, stride, fp);
+    }
+
+    free(row);
+    fclose(fp);
+
+    return 1;
+}
+
+static void
+video_screenshot_worker(UNUSED(void *priv), UNUSED(uint8_t type), uint32_t addr, UNUSED(uint32_t val))
+{
+    screenshot_job_t *job = &screenshot_jobs[addr];
+    int               ret;
+
+    if (video_screenshot_format == SCREENSHOT_FORMAT_BMP)
+        ret = video_write_bmp(job->path, job->buf, job->w, job->h);
+    else
+        ret = video_write_png(job->path, job->buf, job->w, job->h);
+
+    if (video_screenshot_callback)
+        video_screenshot_callback(job->path, job->monitor_index, ret);
+
+    free(job->buf);
+    job->buf = NULL;
+    atomic_store(&job->busy, 0);
 }
 
 void
 video_screenshot_monitor(uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index)
 {
-    char path[1024];
-    char fn[256];
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    screenshot_job_t  *job;
+    uint32_t          *copy;
+    uint32_t           idx;
+    int                w = blit_data_ptr->w;
+    int                h = blit_data_ptr->h;
+    char               path[1024];
+    char               fn[256];
 
     memset(fn, 0, sizeof(fn));
     memset(path, 0, sizeof(path));
@@ -399,17 +516,54 @@ video_screenshot_monitor(uint32_t *buf, int start_x, int start_y, int row_len, i
     strcat(path, "Monitor_");
     snprintf(&path[strlen(path)], 42, "%d_", monitor_index + 1);
 
-    plat_tempfile(fn, NULL, ".png");
+    plat_tempfile(fn, NULL, (video_screenshot_format == SCREENSHOT_FORMAT_BMP) ? (char *) ".bmp" : (char *) ".png");
     strcat(path, fn);
 
     video_log("taking screenshot to: %s\n", path);
 
-    video_take_screenshot_monitor((const char *) path, buf, start_x, start_y, row_len, monitor_index);
-    png_destroy_write_struct(&png_ptr[monitor_index], &info_ptr[monitor_index]);
+    /* Only the copy is made here, the caller's buffer is free to change as
+       soon as we return. */
+    copy = (uint32_t *) calloc((size_t) w * h, sizeof(uint32_t));
+    if ((copy != NULL) && (buf != NULL)) {
+        for (int y = 0; y < h; ++y)
+            memcpy(&copy[y * w], &buf[((start_y + y) * row_len) + start_x], w * sizeof(uint32_t));
+    }
+
+    if (copy != NULL) {
+        thread_wait_mutex(screenshot_mutex);
+
+        idx = screenshot_job_next++ % SCREENSHOT_JOBS;
+        job = &screenshot_jobs[idx];
+
+        /* All the slots in use means screenshots come faster than they can
+           be written, so wait for the oldest one. */
+        if (atomic_load(&job->busy))
+            device_worker_sync(screenshot_worker);
+
+        strncpy(job->path, path, sizeof(job->path) - 1);
+        job->buf           = copy;
+        job->w             = w;
+        job->h             = h;
+        job->monitor_index = monitor_index;
+        atomic_store(&job->busy, 1);
+
+        device_worker_post(screenshot_worker, DEVICE_POST_USER, idx, 0);
+
+        thread_release_mutex(screenshot_mutex);
+    } else if (video_screenshot_callback)
+        video_screenshot_callback(path, monitor_index, 0);
 
     atomic_fetch_sub(&monitors[monitor_index].mon_screenshots, 1);
 }
 
+/* Wait for all the screenshots taken so far to be written. */
+void
+video_screenshot_flush(void)
+{
+    if (screenshot_worker != NULL)
+        device_worker_sync(screenshot_worker);
+}
+
 void
 video_screenshot(uint32_t *buf, int start_x, int start_y, int row_len)
 {
@@ -458,28 +612,95 @@ blit_thread(void *param)
     }
 }
 
+/* Like video_blit_memtoscreen_monitor(), but with the card telling which
+   lines of the target buffer (dirty_y1 to dirty_y2, inclusive) changed since
+   its previous blit, so the renderer can copy and upload only those. */
 void
-video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, int dirty_y1, int dirty_y2, int monitor_index)
 {
+    blit_data_t *data = monitors[monitor_index].mon_blit_data_ptr;
+
     MTR_BEGIN("video", "video_blit_memtoscreen");
 
     if ((w <= 0) || (h <= 0))
         return;
 
+    /* The recorder wants every frame, even ones the renderer drops. */
+    record_video(x, y, w, h, dirty_y1, dirty_y2, monitor_index);
+
+    /* A hidden secondary monitor has nobody to blit for. */
+    if (!video_monitor_consumed(monitor_index)) {
+        data->dropped = 1;
+        return;
+    }
+
+    /* Nobody is watching the POST screens during an unpaced boot, and if the
+       renderer has not finished with the previous frame yet, drop this one
+       rather than stall the emulation; the target buffer keeps it anyway. */
+    if (turbo_boot || data->busy) {
+        if (data->busy)
+            data->frames_dropped++;
+        data->dropped = 1;
+        return;
+    }
+
     video_wait_for_blit_monitor(monitor_index);
 
-    monitors[monitor_index].mon_blit_data_ptr->busy          = 1;
-    monitors[monitor_index].mon_blit_data_ptr->buffer_in_use = 1;
-    monitors[monitor_index].mon_blit_data_ptr->x             = x;
-    monitors[monitor_index].mon_blit_data_ptr->y             = y;
-    monitors[monitor_index].mon_blit_data_ptr->w             = w;
-    monitors[monitor_index].mon_blit_data_ptr->h             = h;
+    /* Lines changed in a dropped frame were never seen by the renderer. */
+    if (data->dropped) {
+        dirty_y1      = y;
+        dirty_y2      = y + h - 1;
+        data->dropped = 0;
+    }
+
+    data->busy          = 1;
+    data->buffer_in_use = 1;
+    data->x             = x;
+    data->y             = y;
+    data->w             = w;
+    data->h             = h;
+    data->dirty_y1      = dirty_y1;
+    data->dirty_y2      = dirty_y2;
     monitors[monitor_index].mon_renderedframes++;
 
     thread_set_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
     MTR_END("video", "video_blit_memtoscreen");
 }
 
+void
+video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+{
+    video_blit_memtoscreen_dirty_monitor(x, y, w, h, y, y + h - 1, monitor_index);
+}
+
+/* Called by the UI when the window of a monitor is shown, hidden or
+   minimised. */
+void
+video_monitor_set_visible(int monitor_index, int visible)
+{
+    atomic_store(&monitors[monitor_index].mon_visible, !!visible);
+}
+
+/* Whether anything will look at the next frame of a monitor: its window, or
+   a pending screenshot. The primary monitor always counts, as the VNC server
+   and the recorder take their frames from it. Cards may skip rendering the
+   lines of a monitor that is not consumed. */
+int
+video_monitor_consumed(int monitor_index)
+{
+    return !monitor_index || atomic_load(&monitors[monitor_index].mon_visible) ||
+           atomic_load(&monitors[monitor_index].mon_screenshots);
+}
+
+/* For blit_func: the lines of the target buffer changed by the blit in
+   progress. */
+void
+video_blit_get_dirty_monitor(int monitor_index, int *dirty_y1, int *dirty_y2)
+{
+    *dirty_y1 = monitors[monitor_index].mon_blit_data_ptr->dirty_y1;
+    *dirty_y2 = monitors[monitor_index].mon_blit_data_ptr->dirty_y2;
+}
+
 uint8_t
 pixels8(uint32_t *pixels)
 {
@@ -869,9 +1090,10 @@ video_monitor_init(int index)
     monitors[index].mon_vid_type                         = VIDEO_FLAG_TYPE_NONE;
     atomic_init(&doresize_monitors[index], 0);
     atomic_init(&monitors[index].mon_screenshots, 0);
+    atomic_init(&monitors[index].mon_visible, 1);
     if (index >= 1)
         ui_init_monitor(index);
-    monitors[index].mon_blit_data_ptr->blit_thread = thread_create(blit_thread, monitors[index].mon_blit_data_ptr);
+    monitors[index].mon_blit_data_ptr->blit_thread = thread_create_role(blit_thread, monitors[index].mon_blit_data_ptr, THREAD_ROLE_RENDER);
 }
 
 void
@@ -946,6 +1168,20 @@ video_init(void)
             egaremap2bpp[c] |= 0x08;
     }
 
+    /*
+       Each plane byte expanded to its bit of eight 4bpp chunky pixels,
+       in the scrambled order the SVGA renderer unscrambles with 002461357.
+     */
+    for (uint16_t c = 0; c < 256; c++) {
+        for (uint8_t d = 0; d < 4; d++) {
+            uint32_t edat = (uint32_t) c << (d << 3);
+
+            edat = (edat & 0xAA55AA55) | ((edat << 7) & 0x55005500) | ((edat >> 7) & 0x00AA00AA);
+            edat = (edat & 0xCCCC3333) | ((edat << 14) & 0x33330000) | ((edat >> 14) & 0x0000CCCC);
+            egaplanarlookup[d][c] = edat;
+        }
+    }
+
     video_6to8 = malloc(4 * 256);
     for (uint16_t c = 0; c < 256; c++)
         video_6to8[c] = calc_6to8(c);
@@ -968,11 +1204,22 @@ video_init(void)
 
     memset(monitors, 0, sizeof(monitors));
     video_monitor_init(0);
+
+    screenshot_mutex  = thread_create_mutex();
+    screenshot_worker = device_worker_create("Screenshot writer", video_screenshot_worker, NULL);
 }
 
 void
 video_close(void)
 {
+    /* Finish writing any screenshots still queued. */
+    device_worker_close(screenshot_worker);
+    screenshot_worker = NULL;
+    if (screenshot_mutex != NULL) {
+        thread_close_mutex(screenshot_mutex);
+        screenshot_mutex = NULL;
+    }
+
     video_monitor_close(0);
 
     free(video_16to32);
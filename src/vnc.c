@@ -34,6 +34,7 @@
 #define VNC_MAX_X 2048
 #define VNC_MIN_Y 200
 #define VNC_MAX_Y 2048
+#define VNC_TILE  16
 
 static rfbScreenInfoPtr rfb = NULL;
 static int              clients;
@@ -171,24 +172,101 @@ vnc_display(rfbClientPtr cl)
     }
 }
 
+/* Compare a copied row against the framebuffer a tile at a time, updating
+   the tiles that differ and flagging them in the band's dirty mask. */
+static void
+vnc_update_row(const uint32_t *src, uint32_t *dst, int w, uint8_t *tiles)
+{
+    for (int tx = 0; tx < w; tx += VNC_TILE) {
+        int    tw  = ((w - tx) < VNC_TILE) ? (w - tx) : VNC_TILE;
+        size_t len = tw * sizeof(uint32_t);
+
+        if (memcmp(&dst[tx], &src[tx], len)) {
+            memcpy(&dst[tx], &src[tx], len);
+            tiles[tx / VNC_TILE] = 1;
+        }
+    }
+}
+
+/* Mark the runs of changed tiles in a band as modified. */
+static void
+vnc_mark_band(const uint8_t *tiles, int w, int y1, int y2)
+{
+    int ntiles = (w + VNC_TILE - 1) / VNC_TILE;
+    int start  = -1;
+
+    for (int t = 0; t <= ntiles; t++) {
+        if ((t < ntiles) && tiles[t]) {
+            if (start < 0)
+                start = t;
+        } else if (start >= 0) {
+            rfbMarkRectAsModified(rfb, start * VNC_TILE, y1,
+                                  (t * VNC_TILE < w) ? (t * VNC_TILE) : w, y2);
+            start = -1;
+        }
+    }
+}
+
 static void
 vnc_blit(int x, int y, int w, int h, int monitor_index)
 {
+    static int      last_x = -1;
+    static int      last_y = -1;
+    static int      last_w = -1;
+    static int      last_h = -1;
+    static uint32_t row_buf[VNC_MAX_X];
+    uint8_t         tiles[VNC_MAX_X / VNC_TILE];
+    uint32_t       *fb;
+    int             dirty_y1;
+    int             dirty_y2;
+    int             band;
+
     if (monitor_index || (x < 0) || (y < 0) || (w < VNC_MIN_X) || (h < VNC_MIN_Y) || (w > VNC_MAX_X) || (h > VNC_MAX_Y) || (buffer32 == NULL)) {
         video_blit_complete_monitor(monitor_index);
         return;
     }
 
-    for (int row = 0; row < h; ++row)
-        video_copy(&(((uint8_t *) rfb->frameBuffer)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    /* Only rows the card changed since the last blit need comparing, unless
+       the visible area moved, in which case everything is stale. */
+    video_blit_get_dirty_monitor(monitor_index, &dirty_y1, &dirty_y2);
+    if ((x != last_x) || (y != last_y) || (w != last_w) || (h != last_h)) {
+        dirty_y1 = y;
+        dirty_y2 = y + h - 1;
+        last_x   = x;
+        last_y   = y;
+        last_w   = w;
+        last_h   = h;
+    }
+    if (dirty_y1 < y)
+        dirty_y1 = y;
+    if (dirty_y2 > (y + h - 1))
+        dirty_y2 = y + h - 1;
+    dirty_y1 -= y;
+    dirty_y2 -= y;
+
+    fb = (uint32_t *) rfb->frameBuffer;
+
+    /* Walk the dirty rows in bands of VNC_TILE lines, so clients only get
+       sent the tiles whose pixels actually changed. */
+    for (int row = dirty_y1 & ~(VNC_TILE - 1); row <= dirty_y2; row = band) {
+        band = row + VNC_TILE;
+        memset(tiles, 0, sizeof(tiles));
+
+        for (int r = (row < dirty_y1) ? dirty_y1 : row; (r < band) && (r <= dirty_y2); r++) {
+            /* Copy through video_copy first, so the comparison is made on
+               the same (possibly colour transformed) pixels clients get. */
+            video_copy(row_buf, &(buffer32->line[y + r][x]), w * sizeof(uint32_t));
+            vnc_update_row(row_buf, &fb[r * VNC_MAX_X], w, tiles);
+        }
+
+        if (!updatingSize)
+            vnc_mark_band(tiles, w, row, (band < h) ? band : h);
+    }
 
     if (screenshots)
         video_screenshot((uint32_t *) rfb->frameBuffer, 0, 0, VNC_MAX_X);
 
     video_blit_complete_monitor(monitor_index);
-
-    if (!updatingSize)
-        rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
 }
 
 /* Initialize VNC for operation. */